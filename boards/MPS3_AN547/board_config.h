@@ -84,5 +84,6 @@
 #define OMV_CSI_MAX_DEVICES                   (3)
 
 #define OMV_SOFTCSI_ENABLE                    (1)
+#define OMV_SOFTCSI_REPLAY_ENABLE             (1)
 
 #endif //__BOARD_CONFIG_H__
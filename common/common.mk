@@ -39,6 +39,7 @@ COMMON_SRC_C += \
     queue.c \
     omv_cycles.c \
     omv_profiler.c \
+    omv_sampler.c \
     umalloc.c \
 
 CFLAGS += -I$(TOP_DIR)/common
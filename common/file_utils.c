@@ -36,8 +36,20 @@
 #include "omv_common.h"
 #include "file_utils.h"
 
+// Buffer states. While reading, buf holds the file bytes [buf_pos, buf_pos + len) and
+// the stream is at buf_pos + len. While writing, buf holds bytes that still have to be
+// written at buf_pos and the stream is at buf_pos. The file position is buf_pos + idx.
+#define FILE_MODE_IDLE      (0)
+#define FILE_MODE_READ      (1)
+#define FILE_MODE_WRITE     (2)
+
 static inline void file_cleanup(file_t *fp) {
     if (fp && fp->fp != MP_OBJ_NULL) {
+        if (fp->buf) {
+            m_del(uint8_t, fp->buf, OMV_FILE_BUFFER_SIZE);
+            fp->buf = NULL;
+        }
+        fp->mode = FILE_MODE_IDLE;
         mp_stream_close(fp->fp);
         fp->fp = MP_OBJ_NULL;
     }
@@ -110,10 +122,45 @@ static size_t file_write_helper(file_t *fp, const void *buf, size_t len) {
     return out_sz;
 }
 
+// Returns the number of bytes the buffer can hold before reaching a sector boundary.
+static inline size_t file_buffer_limit(file_t *fp) {
+    return OMV_FILE_BUFFER_SIZE - (fp->buf_pos % OMV_FILE_SECTOR_SIZE);
+}
+
+// Writes back pending data or discards read-ahead data, leaving the stream at the
+// current file position.
+static void file_buffer_drop(file_t *fp) {
+    if (fp->mode == FILE_MODE_WRITE && fp->len) {
+        if (file_write_helper(fp, fp->buf, fp->len) != fp->len) {
+            file_write_fail(fp);
+        }
+        if (fp->idx != fp->len) {
+            file_seek_helper(fp, fp->buf_pos + fp->idx, SEEK_SET);
+        }
+    } else if (fp->mode == FILE_MODE_READ && fp->idx != fp->len) {
+        file_seek_helper(fp, fp->buf_pos + fp->idx, SEEK_SET);
+    }
+    fp->mode = FILE_MODE_IDLE;
+}
+
+static void file_buffer_start(file_t *fp, uint8_t mode) {
+    if (fp->mode != mode) {
+        size_t pos = (fp->mode == FILE_MODE_IDLE) ?
+                     file_seek_helper(fp, 0, SEEK_CUR) : (fp->buf_pos + fp->idx);
+        file_buffer_drop(fp);
+        fp->buf_pos = pos;
+        fp->idx = 0;
+        fp->len = 0;
+        fp->mode = mode;
+    }
+}
+
 void file_open(file_t *fp, const char *path, uint32_t flags) {
     // Initialize fp to safe state in case open fails
     fp->fp = MP_OBJ_NULL;
     fp->flags = 0;
+    fp->mode = FILE_MODE_IDLE;
+    fp->buf = NULL;
 
     // Reject unsupported FA_READ | FA_WRITE without creation/append flags
     // This combination would silently truncate the file (mode "wb")
@@ -147,18 +194,31 @@ void file_open(file_t *fp, const char *path, uint32_t flags) {
     };
     fp->fp = mp_vfs_open(MP_ARRAY_SIZE(args), args, (mp_map_t *) &mp_const_empty_map);
     fp->flags = (uint8_t) flags;
+
+    #if OMV_FILE_BUFFER_SIZE
+    // Falls back to unbuffered I/O if the heap can't spare the buffer.
+    fp->buf = m_new_maybe(uint8_t, OMV_FILE_BUFFER_SIZE);
+    #endif
 }
 
 void file_close(file_t *fp) {
     if (fp && fp->fp != MP_OBJ_NULL) {
-        mp_stream_close(fp->fp);
-        fp->fp = MP_OBJ_NULL;
+        file_buffer_drop(fp);
+        file_cleanup(fp);
     }
 }
 
 void file_seek(file_t *fp, size_t offset) {
     if (fp && fp->fp) {
-        file_seek_helper(fp, offset, SEEK_SET);
+        if ((fp->mode != FILE_MODE_IDLE) &&
+            (offset >= fp->buf_pos) &&
+            (offset <= (fp->buf_pos + fp->len))) {
+            // Seeking within the buffer doesn't touch the stream.
+            fp->idx = offset - fp->buf_pos;
+        } else {
+            file_buffer_drop(fp);
+            file_seek_helper(fp, offset, SEEK_SET);
+        }
     }
 }
 
@@ -167,6 +227,8 @@ void file_truncate(file_t *fp) {
         return;
     }
 
+    file_buffer_drop(fp);
+
     // Truncate file at current position by calling Python truncate() method
     // Use getattr to get the truncate method
     mp_obj_t truncate_str = mp_obj_new_str("truncate", 8);
@@ -182,6 +244,8 @@ void file_sync(file_t *fp) {
         return;
     }
 
+    file_buffer_drop(fp);
+
     const mp_stream_p_t *stream_p = mp_get_stream_raise(fp->fp, MP_STREAM_OP_WRITE);
     mp_uint_t res = stream_p->ioctl(fp->fp, MP_STREAM_FLUSH, 0, &err);
     if (res == MP_STREAM_ERROR) {
@@ -190,6 +254,9 @@ void file_sync(file_t *fp) {
 }
 
 size_t file_tell(file_t *fp) {
+    if (fp->mode != FILE_MODE_IDLE) {
+        return fp->buf_pos + fp->idx;
+    }
     return file_seek_helper(fp, 0, SEEK_CUR);
 }
 
@@ -197,14 +264,15 @@ size_t file_size(file_t *fp) {
     off_t current_pos = file_seek_helper(fp, 0, SEEK_CUR);
     off_t file_end = file_seek_helper(fp, 0, SEEK_END);
     file_seek_helper(fp, current_pos, SEEK_SET);
+    if (fp->mode == FILE_MODE_WRITE) {
+        // Pending data may extend the file.
+        return OMV_MAX((size_t) file_end, fp->buf_pos + fp->len);
+    }
     return file_end;
 }
 
 bool file_eof(file_t *fp) {
-    off_t current_pos = file_seek_helper(fp, 0, SEEK_CUR);
-    off_t file_end = file_seek_helper(fp, 0, SEEK_END);
-    file_seek_helper(fp, current_pos, SEEK_SET);
-    return current_pos >= file_end;
+    return file_tell(fp) >= file_size(fp);
 }
 
 void file_read(file_t *fp, void *data, size_t size) {
@@ -214,13 +282,55 @@ void file_read(file_t *fp, void *data, size_t size) {
 
     if (data == NULL) {
         // Skip bytes
-        file_seek_helper(fp, size, SEEK_CUR);
+        if (fp->mode == FILE_MODE_IDLE) {
+            file_seek_helper(fp, size, SEEK_CUR);
+        } else {
+            file_seek(fp, file_tell(fp) + size);
+        }
         return;
     }
 
-    size_t bytes = file_read_helper(fp, data, size);
-    if (bytes != size) {
-        file_read_fail(fp);
+    if (!fp->buf) {
+        size_t bytes = file_read_helper(fp, data, size);
+        if (bytes != size) {
+            file_read_fail(fp);
+        }
+        return;
+    }
+
+    file_buffer_start(fp, FILE_MODE_READ);
+
+    for (uint8_t *ptr = data; size; ) {
+        if (fp->idx < fp->len) {
+            size_t n = OMV_MIN(size, (size_t) (fp->len - fp->idx));
+            memcpy(ptr, fp->buf + fp->idx, n);
+            fp->idx += n;
+            ptr += n;
+            size -= n;
+            continue;
+        }
+
+        // The buffer is empty and the stream is at buf_pos + len.
+        fp->buf_pos += fp->len;
+        fp->idx = 0;
+        fp->len = 0;
+
+        size_t limit = file_buffer_limit(fp);
+        if (size >= limit) {
+            // Large reads bypass the buffer up to the last sector boundary.
+            size_t n = limit + OMV_ALIGN_DOWN(size - limit, OMV_FILE_SECTOR_SIZE);
+            if (file_read_helper(fp, ptr, n) != n) {
+                file_read_fail(fp);
+            }
+            fp->buf_pos += n;
+            ptr += n;
+            size -= n;
+        } else {
+            fp->len = file_read_helper(fp, fp->buf, limit);
+            if (!fp->len) {
+                file_read_fail(fp);
+            }
+        }
     }
 }
 
@@ -229,9 +339,46 @@ void file_write(file_t *fp, const void *data, size_t size) {
         return;
     }
 
-    size_t bytes = file_write_helper(fp, data, size);
-    if (bytes != size) {
-        file_write_fail(fp);
+    if (!fp->buf) {
+        size_t bytes = file_write_helper(fp, data, size);
+        if (bytes != size) {
+            file_write_fail(fp);
+        }
+        return;
+    }
+
+    file_buffer_start(fp, FILE_MODE_WRITE);
+
+    for (const uint8_t *ptr = data; size; ) {
+        size_t limit = file_buffer_limit(fp);
+        if (!fp->len && (size >= limit)) {
+            // Large writes bypass the buffer up to the last sector boundary.
+            size_t n = limit + OMV_ALIGN_DOWN(size - limit, OMV_FILE_SECTOR_SIZE);
+            if (file_write_helper(fp, ptr, n) != n) {
+                file_write_fail(fp);
+            }
+            fp->buf_pos += n;
+            ptr += n;
+            size -= n;
+            continue;
+        }
+
+        size_t n = OMV_MIN(size, limit - fp->idx);
+        memcpy(fp->buf + fp->idx, ptr, n);
+        fp->idx += n;
+        fp->len = OMV_MAX(fp->len, fp->idx);
+        ptr += n;
+        size -= n;
+
+        if (fp->idx == limit) {
+            // The buffer ends on a sector boundary, write it back.
+            if (file_write_helper(fp, fp->buf, fp->len) != fp->len) {
+                file_write_fail(fp);
+            }
+            fp->buf_pos += fp->len;
+            fp->idx = 0;
+            fp->len = 0;
+        }
     }
 }
 
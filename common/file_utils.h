@@ -30,11 +30,25 @@
 #include <sys/types.h>
 #include "py/obj.h"
 
+// Size of the per-file write-behind/read-ahead buffer, must be a multiple of the
+// sector size and at most 32KB. Set to 0 to pass reads and writes straight to the stream.
+#ifndef OMV_FILE_BUFFER_SIZE
+#define OMV_FILE_BUFFER_SIZE    (2048)
+#endif
+
+// Buffered reads and writes are split on sector boundaries.
+#define OMV_FILE_SECTOR_SIZE    (512)
+
 // File handle that wraps a MicroPython file object
 // Replaces FatFS FIL type with VFS-agnostic abstraction
 typedef struct {
     mp_obj_t fp;      // MicroPython file object
     uint8_t flags;    // Open mode flags (FA_READ, FA_WRITE, etc.)
+    uint8_t mode;     // Buffer state (idle, read-ahead or write-behind)
+    uint16_t idx;     // File position relative to buf_pos
+    uint16_t len;     // Valid (read) or pending (write) bytes in buf
+    uint32_t buf_pos; // File offset of buf[0]
+    uint8_t *buf;     // Buffer or NULL if unbuffered
 } file_t;
 
 // FatFS-compatible mode flags for backward compatibility
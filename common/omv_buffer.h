@@ -90,6 +90,13 @@ static inline void omv_buffer_consume(omv_buffer_t *buf, size_t consumed) {
     }
 }
 
+// Remove data from the middle of the buffer, the data before it is moved up
+// Caller must ensure offset + size <= omv_buffer_avail(buf)
+static inline void omv_buffer_remove(omv_buffer_t *buf, size_t offset, size_t size) {
+    memmove(buf->read_ptr + size, buf->read_ptr, offset);
+    omv_buffer_consume(buf, size);
+}
+
 // Claim contiguous space for writing, compacting buffer if needed
 static inline void *omv_buffer_claim(omv_buffer_t *buf, size_t requested_size) {
     // Check if we have enough total space
@@ -35,6 +35,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <math.h>
 
 #include "py/mphal.h"
 #include "omv_gpio.h"
@@ -44,6 +45,7 @@
 #include "framebuffer.h"
 #include "memcpy.h"
 #include "sensor_config.h"
+#include "trace.h"
 
 #ifndef OMV_CSI_RESET_DELAY
 #define OMV_CSI_RESET_DELAY (10)
@@ -317,6 +319,12 @@ __weak int omv_csi_reset(omv_csi_t *csi, bool hard) {
     #endif // MICROPY_PY_IMU
     csi->color_palette = rainbow_table;
     csi->disable_full_flush = false;
+    if (csi->fb) {
+        framebuffer_reset_stats(csi->fb);
+        csi->fb->meta = (vbuffer_meta_t) {
+            .exposure_us = -1, .gain_db = NAN
+        };
+    }
     csi->vsync_cb = (omv_csi_cb_t) {
         NULL, NULL
     };
@@ -901,6 +909,7 @@ __weak int omv_csi_set_framerate(omv_csi_t *csi, int framerate) {
 __weak void omv_csi_throttle_framerate(omv_csi_t *csi) {
     if (!csi->first_line) {
         csi->first_line = true;
+        framebuffer_begin_frame(csi->fb);
         uint32_t tick = mp_hal_ticks_ms();
         uint32_t framerate_ms = IM_DIV(1000, csi->framerate);
 
@@ -1094,6 +1103,20 @@ __weak int omv_csi_set_auto_gain(omv_csi_t *csi, int enable, float gain_db, floa
         return OMV_CSI_ERROR_CTL_FAILED;
     }
 
+    // Track the gain for the frame metadata, it's only known in manual mode.
+    if (csi->fb) {
+        csi->fb->meta.gain_db = NAN;
+        if (!enable && !isnan(gain_db)) {
+            csi->fb->meta.gain_db = gain_db;
+        } else if (!enable && csi->get_gain_db) {
+            // The current gain is kept, read it back.
+            float current_db;
+            if (csi->get_gain_db(csi, &current_db) == 0) {
+                csi->fb->meta.gain_db = current_db;
+            }
+        }
+    }
+
     return 0;
 }
 
@@ -1122,6 +1145,20 @@ __weak int omv_csi_set_auto_exposure(omv_csi_t *csi, int enable, int exposure_us
         return OMV_CSI_ERROR_CTL_FAILED;
     }
 
+    // Track the exposure for the frame metadata, it's only known in manual mode.
+    if (csi->fb) {
+        csi->fb->meta.exposure_us = -1;
+        if (!enable && (exposure_us >= 0)) {
+            csi->fb->meta.exposure_us = exposure_us;
+        } else if (!enable && csi->get_exposure_us) {
+            // The current exposure is kept, read it back.
+            int current_us;
+            if (csi->get_exposure_us(csi, &current_us) == 0) {
+                csi->fb->meta.exposure_us = current_us;
+            }
+        }
+    }
+
     return 0;
 }
 
@@ -1666,7 +1703,7 @@ __weak int omv_csi_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
         if (!(flags & OMV_CSI_FLAG_NO_UPDATE) && omv_csi_match(csi, stream_fb->source)) {
             image_t tmp;
             framebuffer_to_image(csi->fb, &tmp);
-            framebuffer_update_preview(&tmp);
+            framebuffer_stage_preview(&tmp);
         }
 
         // Release the previous buffer from used queue -> free queue.
@@ -1679,7 +1716,9 @@ __weak int omv_csi_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
     }
 
     // Call the sensor specific function.
+    OMV_TRACE_BEGIN("snapshot");
     int ret = csi->snapshot(csi, image, flags);
+    OMV_TRACE_END("snapshot");
 
     // Toggle FSYNC.
     if (csi->fsync_pin) {
@@ -1691,6 +1730,10 @@ __weak int omv_csi_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
         ret = csi->post_process(csi, image, flags);
     }
 
+    if (ret == OMV_CSI_ERROR_JPEG_OVERFLOW) {
+        csi->fb->stats.overflowed += 1;
+    }
+
     if (ret >= 0) {
         // Mark this buffer to be released on the next call.
         buffer = framebuffer_acquire(csi->fb, FB_FLAG_USED | FB_FLAG_PEEK);
@@ -0,0 +1,148 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2025 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Statistical sampling profiler.
+ */
+#if OMV_SAMPLER_ENABLE
+#include <stdint.h>
+#include <string.h>
+#include "omv_sampler.h"
+
+#if OMV_SAMPLER_POOL_SIZE > 65536
+#error "OMV_SAMPLER_POOL_SIZE must fit the 16-bit record indices."
+#endif
+
+// Also drops the thumb bit, it's always set in LR.
+#define OMV_SAMPLER_PC_MASK     (~((1U << OMV_SAMPLER_PC_SHIFT) - 1) & ~1U)
+
+typedef struct {
+    volatile bool running;
+    volatile bool paused;
+    bool capture_lr;
+    uint32_t pool_index;    // Next free record, record 0 counts dropped samples
+    uint16_t hash[OMV_SAMPLER_POOL_SIZE];   // Index of the first record in each bucket
+    uint16_t next[OMV_SAMPLER_POOL_SIZE];   // Index of the next record in the bucket
+    omv_sampler_record_t pool[OMV_SAMPLER_POOL_SIZE];
+} omv_sampler_state_t;
+
+static omv_sampler_state_t sampler;
+
+static inline uint32_t hash_sample(uint32_t pc, uint32_t lr) {
+    uint32_t x = (pc >> OMV_SAMPLER_PC_SHIFT) ^ (lr * 0x9e3779b1U);
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    return x & (OMV_SAMPLER_POOL_SIZE - 1);
+}
+
+void omv_sampler_init(void) {
+    omv_sampler_stop();
+    omv_sampler_reset();
+}
+
+void omv_sampler_reset(void) {
+    // The sampling IRQ is the only writer, pause it while clearing the pool.
+    bool paused = sampler.paused;
+    sampler.paused = true;
+    sampler.pool_index = 1;
+    memset(sampler.hash, 0, sizeof(sampler.hash));
+    memset(sampler.pool, 0, sizeof(sampler.pool));
+    sampler.paused = paused;
+}
+
+int omv_sampler_start(uint32_t rate_hz, bool capture_lr) {
+    omv_sampler_stop();
+    if (!sampler.pool_index) {
+        omv_sampler_reset();
+    }
+    sampler.capture_lr = capture_lr;
+    sampler.paused = false;
+    if (omv_sampler_timer_start(rate_hz ? rate_hz : OMV_SAMPLER_RATE_HZ) != 0) {
+        return -1;
+    }
+    sampler.running = true;
+    return 0;
+}
+
+void omv_sampler_stop(void) {
+    if (sampler.running) {
+        omv_sampler_timer_stop();
+        sampler.running = false;
+    }
+}
+
+void omv_sampler_pause(bool pause) {
+    sampler.paused = pause;
+}
+
+bool omv_sampler_running(void) {
+    return sampler.running;
+}
+
+size_t omv_sampler_get_size(void) {
+    return sampler.pool_index * sizeof(omv_sampler_record_t);
+}
+
+const void *omv_sampler_get_data(void) {
+    return sampler.pool;
+}
+
+void omv_sampler_sample(uint32_t pc, uint32_t lr) {
+    if (sampler.paused) {
+        return;
+    }
+
+    pc &= OMV_SAMPLER_PC_MASK;
+    lr = sampler.capture_lr ? (lr & OMV_SAMPLER_PC_MASK) : 0;
+
+    uint32_t bucket = hash_sample(pc, lr);
+    for (uint32_t i = sampler.hash[bucket]; i; i = sampler.next[i]) {
+        if (sampler.pool[i].pc == pc && sampler.pool[i].lr == lr) {
+            sampler.pool[i].count++;
+            return;
+        }
+    }
+
+    if (sampler.pool_index >= OMV_SAMPLER_POOL_SIZE) {
+        sampler.pool[0].count++;
+        return;
+    }
+
+    uint32_t i = sampler.pool_index;
+    sampler.pool[i].pc = pc;
+    sampler.pool[i].lr = lr;
+    sampler.pool[i].count = 1;
+    sampler.next[i] = sampler.hash[bucket];
+    sampler.hash[bucket] = i;
+    // Publish the record last, readers only look at records below pool_index.
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    sampler.pool_index = i + 1;
+}
+
+__attribute__((weak)) int omv_sampler_timer_start(uint32_t rate_hz) {
+    return -1;
+}
+
+__attribute__((weak)) void omv_sampler_timer_stop(void) {
+}
+#endif // OMV_SAMPLER_ENABLE
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2025 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Statistical sampling profiler.
+ *
+ * A periodic timer interrupt records the interrupted PC (and optionally LR) into a
+ * histogram, which the host resolves to functions using the firmware's symbol table.
+ * Unlike the instrumenting profiler this doesn't need a special build, and its cost
+ * doesn't depend on how often functions are called.
+ */
+#ifndef __OMV_SAMPLER_H__
+#define __OMV_SAMPLER_H__
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#if OMV_SAMPLER_ENABLE
+// Must be a power of 2, up to 65536.
+#ifndef OMV_SAMPLER_POOL_SIZE
+#define OMV_SAMPLER_POOL_SIZE   (1024)
+#endif
+
+// Samples are counted per 2^OMV_SAMPLER_PC_SHIFT bytes of code instead of per instruction,
+// so the pool holds the hot code regions of a run rather than its first few hundred PCs.
+#ifndef OMV_SAMPLER_PC_SHIFT
+#define OMV_SAMPLER_PC_SHIFT    (4)
+#endif
+
+#ifndef OMV_SAMPLER_RATE_HZ
+#define OMV_SAMPLER_RATE_HZ     (1000)
+#endif
+
+// Histogram record, record 0 counts the samples that didn't fit in the pool.
+typedef struct {
+    uint32_t pc;            // Sampled PC, rounded down to the granule
+    uint32_t lr;            // Sampled LR, rounded down to the granule, or 0 if not captured
+    uint32_t count;         // Number of samples
+} omv_sampler_record_t;
+
+void omv_sampler_init(void);
+int omv_sampler_start(uint32_t rate_hz, bool capture_lr);
+void omv_sampler_stop(void);
+void omv_sampler_reset(void);
+void omv_sampler_pause(bool pause);
+bool omv_sampler_running(void);
+size_t omv_sampler_get_size(void);
+const void *omv_sampler_get_data(void);
+
+// Called from the sampling timer IRQ with the interrupted context's PC and LR.
+void omv_sampler_sample(uint32_t pc, uint32_t lr);
+
+// Port specific sampling timer, returns -1 if not supported.
+int omv_sampler_timer_start(uint32_t rate_hz);
+void omv_sampler_timer_stop(void);
+
+// Defines a timer IRQ handler that finds the exception frame of the interrupted
+// context (on the main or process stack) and samples its stacked PC and LR. The
+// ack function clears the timer's interrupt.
+#define OMV_SAMPLER_IRQ_HANDLER(handler, ack)                       \
+    static void __attribute__((used)) handler##_sample(const uint32_t *frame) { \
+        ack();                                                      \
+        omv_sampler_sample(frame[6], frame[5]);                     \
+    }                                                               \
+    static void __attribute__((naked)) handler(void) {              \
+        __asm volatile (                                            \
+            "tst lr, #4\n"                                          \
+            "ite eq\n"                                              \
+            "mrseq r0, msp\n"                                       \
+            "mrsne r0, psp\n"                                       \
+            "b " #handler "_sample\n"                               \
+            );                                                      \
+    }
+#endif // OMV_SAMPLER_ENABLE
+#endif // __OMV_SAMPLER_H__
@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: MIT
  *
- * Copyright (C) 2013-2024 OpenMV, LLC.
+ * Copyright (C) 2013-2025 OpenMV, LLC.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -21,31 +21,129 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  *
- * Trace buffer.
+ * Timeline trace recorder.
  */
+#if OMV_TRACE_ENABLE
 #include <stdint.h>
-#include "cmsis_compiler.h"
+#include <string.h>
+#include CMSIS_MCU_H
+#include "omv_cycles.h"
 #include "trace.h"
 
-#define TRACEBUF_SIZE    (256)
-typedef struct _tracebuf_t {
-    uint8_t idx;
-    uint8_t buf[TRACEBUF_SIZE];
-} tracebuf_t;
+typedef struct {
+    volatile bool paused;
+    // Name pointers seen so far, checked before comparing the strings.
+    const char *pointers[OMV_TRACE_NAME_COUNT];
+    omv_trace_buffer_t buffer;
+} omv_trace_state_t;
 
-static tracebuf_t tracebuf;
+static omv_trace_state_t trace;
 
-void trace_init() {
-    tracebuf.idx = 0;
-    for (int i = 0; i < TRACEBUF_SIZE; i++) {
-        tracebuf.buf[i] = 0;
+void omv_trace_init(void) {
+    if (trace.buffer.magic != OMV_TRACE_MAGIC) {
+        memset(&trace, 0, sizeof(trace));
+        trace.buffer.magic = OMV_TRACE_MAGIC;
+        trace.buffer.version = OMV_TRACE_VERSION;
+        trace.buffer.event_size = sizeof(omv_trace_event_t);
+        trace.buffer.capacity = OMV_TRACE_BUFFER_SIZE;
+        trace.buffer.name_count = 1;
+        trace.buffer.name_size = OMV_TRACE_NAME_SIZE;
+        trace.buffer.name_capacity = OMV_TRACE_NAME_COUNT;
+        strcpy(trace.buffer.names[0], "unknown");
     }
+
+    // The cycle counter may not be running yet.
+    omv_cycles_init();
+    trace.buffer.cpu_freq = OMV_CPU_FREQ_HZ;
 }
 
-void trace_insert(uint32_t x) {
+void omv_trace_reset(void) {
+    // Names are kept since they're cached by the call sites.
+    uint32_t primask = __get_PRIMASK();
     __disable_irq();
-    if (tracebuf.idx < TRACEBUF_SIZE) {
-        tracebuf.buf[tracebuf.idx++] = x;
+    trace.buffer.head = 0;
+    trace.buffer.dropped = 0;
+    memset(trace.buffer.events, 0, sizeof(trace.buffer.events));
+    __set_PRIMASK(primask);
+}
+
+void omv_trace_pause(bool pause) {
+    trace.paused = pause;
+}
+
+size_t omv_trace_get_count(void) {
+    return OMV_MIN(trace.buffer.head, OMV_TRACE_BUFFER_SIZE);
+}
+
+size_t omv_trace_get_size(void) {
+    return offsetof(omv_trace_buffer_t, events) + omv_trace_get_count() * sizeof(omv_trace_event_t);
+}
+
+const void *omv_trace_get_data(void) {
+    return &trace.buffer;
+}
+
+static uint8_t omv_trace_add_name(const char *name, const char *pointer) {
+    uint8_t index = 0;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+
+    for (size_t i = 1; i < trace.buffer.name_count; i++) {
+        if (!strncmp(trace.buffer.names[i], name, OMV_TRACE_NAME_SIZE - 1)) {
+            index = i;
+            break;
+        }
+    }
+
+    if (!index && trace.buffer.name_count < OMV_TRACE_NAME_COUNT) {
+        index = trace.buffer.name_count++;
+        strncpy(trace.buffer.names[index], name, OMV_TRACE_NAME_SIZE - 1);
+        trace.pointers[index] = pointer;
     }
-    __enable_irq();
+
+    __set_PRIMASK(primask);
+    return index;
+}
+
+uint8_t omv_trace_name(const char *name) {
+    // Fast path for names that were registered with the same pointer.
+    for (size_t i = 1; i < trace.buffer.name_count; i++) {
+        if (trace.pointers[i] == name) {
+            return i;
+        }
+    }
+
+    return omv_trace_add_name(name, name);
+}
+
+uint8_t omv_trace_name_str(const char *name) {
+    return omv_trace_add_name(name, NULL);
+}
+
+void omv_trace_record(uint32_t type, uint8_t name, int32_t value) {
+    uint32_t cycles = omv_cycles_now();
+
+    if (trace.paused) {
+        trace.buffer.dropped++;
+        return;
+    }
+
+    // Claim a slot, writers that interrupt each other get consecutive slots.
+    uint32_t index = __atomic_fetch_add(&trace.buffer.head, 1, __ATOMIC_RELAXED);
+    omv_trace_event_t *event = &trace.buffer.events[index & (OMV_TRACE_BUFFER_SIZE - 1)];
+
+    // The type is written last, so a reader never sees a partially written event as valid.
+    event->type = OMV_TRACE_TYPE_NONE;
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    event->cycles = cycles;
+    event->value = value;
+    event->name = name;
+    event->context = __get_IPSR();
+    __atomic_signal_fence(__ATOMIC_SEQ_CST);
+    event->type = type;
+}
+
+void omv_trace_scope_exit(uint8_t *name) {
+    omv_trace_record(OMV_TRACE_TYPE_END, *name, 0);
 }
+#endif // OMV_TRACE_ENABLE
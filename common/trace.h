@@ -1,7 +1,7 @@
 /*
  * SPDX-License-Identifier: MIT
  *
- * Copyright (C) 2013-2024 OpenMV, LLC.
+ * Copyright (C) 2013-2025 OpenMV, LLC.
  *
  * Permission is hereby granted, free of charge, to any person obtaining a copy
  * of this software and associated documentation files (the "Software"), to deal
@@ -21,11 +21,131 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  *
- * Trace buffer.
+ * Timeline trace recorder.
+ *
+ * Records timestamped begin/end/instant/counter events into a ring buffer that's
+ * exported as is by the profile channel. Events can be recorded from any context,
+ * including IRQs, and the latest OMV_TRACE_BUFFER_SIZE events are kept.
  */
 #ifndef __TRACE_H__
 #define __TRACE_H__
 #include <stdint.h>
-void trace_init();
-void trace_insert(uint32_t x);
-#endif /* __TRACE_H__ */
+#include <stddef.h>
+#include <stdbool.h>
+
+#if OMV_TRACE_ENABLE
+#include "py/nlr.h"
+#include "omv_common.h"
+
+// Must be a power of 2
+#ifndef OMV_TRACE_BUFFER_SIZE
+#define OMV_TRACE_BUFFER_SIZE   (1024)
+#endif
+
+#ifndef OMV_TRACE_NAME_COUNT
+#define OMV_TRACE_NAME_COUNT    (64)
+#endif
+
+#define OMV_TRACE_NAME_SIZE     (16)
+#define OMV_TRACE_MAGIC         (0x54564D4F) // "OMVT"
+#define OMV_TRACE_VERSION       (1)
+
+typedef enum {
+    OMV_TRACE_TYPE_NONE     = 0,  // Event is being written
+    OMV_TRACE_TYPE_BEGIN    = 1,  // Start of a duration
+    OMV_TRACE_TYPE_END      = 2,  // End of a duration
+    OMV_TRACE_TYPE_INSTANT  = 3,  // Point in time
+    OMV_TRACE_TYPE_COUNTER  = 4,  // Counter value
+} omv_trace_type_t;
+
+typedef struct {
+    uint32_t cycles;        // DWT cycle count
+    int32_t value;          // Counter value
+    uint8_t type;           // Event type
+    uint8_t name;           // Index in the names table
+    uint16_t context;       // 0 for thread mode, otherwise the active exception number
+} omv_trace_event_t;
+
+// Exported as is, the events that follow the header and names are a ring buffer
+// and the oldest event is at (head % capacity) once the buffer has wrapped.
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t event_size;
+    uint32_t cpu_freq;      // DWT cycles per second
+    uint32_t capacity;      // Events in the ring buffer
+    uint32_t head;          // Total events recorded since the last reset
+    uint32_t dropped;       // Events dropped while the buffer was paused
+    uint16_t name_count;    // Names in use
+    uint16_t name_size;
+    uint16_t name_capacity; // Names in the table
+    uint16_t reserved;
+    char names[OMV_TRACE_NAME_COUNT][OMV_TRACE_NAME_SIZE];
+    omv_trace_event_t events[OMV_TRACE_BUFFER_SIZE];
+} omv_trace_buffer_t;
+
+OMV_ATTR_NO_INSTRUMENT void omv_trace_init(void);
+OMV_ATTR_NO_INSTRUMENT void omv_trace_reset(void);
+OMV_ATTR_NO_INSTRUMENT void omv_trace_pause(bool pause);
+OMV_ATTR_NO_INSTRUMENT size_t omv_trace_get_size(void);
+OMV_ATTR_NO_INSTRUMENT size_t omv_trace_get_count(void);
+OMV_ATTR_NO_INSTRUMENT const void *omv_trace_get_data(void);
+// Names must be static, their pointers are cached. Use omv_trace_name_str() for other names.
+OMV_ATTR_NO_INSTRUMENT uint8_t omv_trace_name(const char *name);
+OMV_ATTR_NO_INSTRUMENT uint8_t omv_trace_name_str(const char *name);
+OMV_ATTR_NO_INSTRUMENT void omv_trace_record(uint32_t type, uint8_t name, int32_t value);
+OMV_ATTR_NO_INSTRUMENT void omv_trace_scope_exit(uint8_t *name);
+
+// Resolves a name once per call site, index 0 is reserved for names that didn't fit.
+static inline OMV_ATTR_NO_INSTRUMENT uint8_t omv_trace_lookup(uint8_t *id, const char *name) {
+    if (*id == 0) {
+        *id = omv_trace_name(name);
+    }
+    return *id;
+}
+
+#define OMV_TRACE_EVENT(type, name, value)                                 \
+    do {                                                                   \
+        static uint8_t omv_trace_id;                                       \
+        omv_trace_record(type, omv_trace_lookup(&omv_trace_id, name), value); \
+    } while (0)
+
+#define OMV_TRACE_BEGIN(name)           OMV_TRACE_EVENT(OMV_TRACE_TYPE_BEGIN, name, 0)
+#define OMV_TRACE_END(name)             OMV_TRACE_EVENT(OMV_TRACE_TYPE_END, name, 0)
+#define OMV_TRACE_INSTANT(name)         OMV_TRACE_EVENT(OMV_TRACE_TYPE_INSTANT, name, 0)
+#define OMV_TRACE_COUNTER(name, value)  OMV_TRACE_EVENT(OMV_TRACE_TYPE_COUNTER, name, value)
+
+// Records a begin event and the matching end event when the enclosing scope
+// exits, on any return path. Must not be used in functions that can raise.
+#define OMV_TRACE_SCOPE(name)                                                      \
+    static uint8_t omv_trace_scope_id;                                             \
+    uint8_t omv_trace_scope __attribute__((cleanup(omv_trace_scope_exit))) =       \
+        omv_trace_lookup(&omv_trace_scope_id, name);                               \
+    omv_trace_record(OMV_TRACE_TYPE_BEGIN, omv_trace_scope, 0)
+
+// Records a begin event, runs the statement and records the matching end event,
+// also if the statement raises. The statement must not return.
+#define OMV_TRACE_CALL(name, stmt)                  \
+    do {                                            \
+        nlr_buf_t omv_trace_nlr;                    \
+        OMV_TRACE_BEGIN(name);                      \
+        if (nlr_push(&omv_trace_nlr) == 0) {        \
+            stmt;                                   \
+            nlr_pop();                              \
+            OMV_TRACE_END(name);                    \
+        } else {                                    \
+            OMV_TRACE_END(name);                    \
+            nlr_jump(omv_trace_nlr.ret_val);        \
+        }                                           \
+    } while (0)
+
+#else
+// Disabled - empty macros
+#define OMV_TRACE_BEGIN(name) do {} while (0)
+#define OMV_TRACE_END(name) do {} while (0)
+#define OMV_TRACE_INSTANT(name) do {} while (0)
+#define OMV_TRACE_COUNTER(name, value) do {} while (0)
+#define OMV_TRACE_SCOPE(name) do {} while (0)
+#define OMV_TRACE_CALL(name, stmt) do { stmt; } while (0)
+#endif // OMV_TRACE_ENABLE
+#endif // __TRACE_H__
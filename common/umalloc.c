@@ -38,9 +38,157 @@ static int uma_num_pools;
 static uma_pool_t uma_pools[UMA_MAX_POOLS];
 static volatile int uma_collect_locked;
 
+// Frame scratch arena. UMA_SCRATCH allocations are bump allocated from a single persistent
+// block that is sized from the scratch usage of previous frames, which keeps short-lived
+// kernel buffers out of the TLSF pools. The arena is rewound when its last block is freed,
+// when the top block is freed, or when a scope is released. Live blocks are chained from
+// the top block down, frees of blocks that aren't on the chain are ignored.
+typedef struct {
+    uint32_t size;
+    uint32_t prev;  // Arena top before this block was allocated.
+    uint32_t link;  // Offset of the block below this one, 0 if none.
+    uint32_t live;
+} uma_scratch_hdr_t;
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t top;
+    size_t last;
+    size_t count;
+    size_t depth;
+    size_t peak;
+    size_t misses;
+    size_t last_peak;
+    size_t last_misses;
+} uma_scratch_t;
+
+static uma_scratch_t uma_scratch;
+
+static inline void uma_pool_update_peak(uma_pool_t *pool) {
+    size_t used = pool->size - pool->free;
+    if (used > pool->peak) {
+        pool->peak = used;
+    }
+    if (used > pool->frame_peak) {
+        pool->frame_peak = used;
+    }
+}
+
+static inline bool uma_scratch_owns(const void *ptr) {
+    return uma_scratch.base && ((uint8_t *) ptr >= uma_scratch.base) &&
+           ((uint8_t *) ptr < (uma_scratch.base + uma_scratch.size));
+}
+
+static void *uma_scratch_alloc(size_t size, uint32_t flags) {
+    size_t align = (flags & UMA_CACHE) ? OMV_CACHE_LINE_SIZE : sizeof(uint64_t);
+    size_t start = OMV_ALIGN_TO(uma_scratch.top + sizeof(uma_scratch_hdr_t), align);
+    size_t end = start + size;
+
+    // Track the demand even if it doesn't fit, the arena is resized to it on the next frame.
+    if (end > uma_scratch.peak) {
+        uma_scratch.peak = end;
+    }
+
+    if (end > uma_scratch.size) {
+        uma_scratch.misses++;
+        return NULL;
+    }
+
+    uma_scratch_hdr_t *hdr = (uma_scratch_hdr_t *) (uma_scratch.base + start) - 1;
+    hdr->size = size;
+    hdr->prev = uma_scratch.top;
+    hdr->link = uma_scratch.last;
+    hdr->live = 1;
+    uma_scratch.top = end;
+    uma_scratch.last = start;
+    uma_scratch.count++;
+    return uma_scratch.base + start;
+}
+
+static uma_scratch_hdr_t *uma_scratch_find(const void *ptr) {
+    size_t start = (const uint8_t *) ptr - uma_scratch.base;
+    size_t block = uma_scratch.last;
+
+    // Blocks are chained in address order, frees are mostly LIFO so this is usually one step.
+    while (block > start) {
+        block = ((uma_scratch_hdr_t *) (uma_scratch.base + block) - 1)->link;
+    }
+
+    if (!block || (block != start)) {
+        return NULL;
+    }
+
+    uma_scratch_hdr_t *hdr = (uma_scratch_hdr_t *) (uma_scratch.base + block) - 1;
+    return hdr->live ? hdr : NULL;
+}
+
+static void uma_scratch_free(void *ptr) {
+    uma_scratch_hdr_t *hdr = uma_scratch_find(ptr);
+
+    // Already freed, or reclaimed by releasing a scope or a collect.
+    if (!hdr) {
+        return;
+    }
+
+    hdr->live = 0;
+    if (--uma_scratch.count == 0) {
+        uma_scratch.top = 0;
+        uma_scratch.last = 0;
+        return;
+    }
+
+    // Rewind past the top block and any freed blocks below it.
+    while (uma_scratch.last) {
+        hdr = (uma_scratch_hdr_t *) (uma_scratch.base + uma_scratch.last) - 1;
+        if (hdr->live) {
+            break;
+        }
+        uma_scratch.top = hdr->prev;
+        uma_scratch.last = hdr->link;
+    }
+}
+
+static void *uma_scratch_realloc(void *ptr, size_t size, uint32_t flags) {
+    uint8_t *p = ptr;
+    uma_scratch_hdr_t *hdr = (uma_scratch_hdr_t *) p - 1;
+
+    if (size == 0) {
+        uma_scratch_free(ptr);
+        return NULL;
+    }
+
+    if (flags & UMA_CACHE) {
+        size = OMV_ALIGN_TO(size, OMV_CACHE_LINE_SIZE);
+    }
+
+    if (size <= hdr->size) {
+        return ptr;
+    }
+
+    // The top block can grow in place.
+    size_t start = p - uma_scratch.base;
+    if ((start == uma_scratch.last) && ((start + size) <= uma_scratch.size)) {
+        hdr->size = size;
+        uma_scratch.top = start + size;
+        if (uma_scratch.top > uma_scratch.peak) {
+            uma_scratch.peak = uma_scratch.top;
+        }
+        return ptr;
+    }
+
+    void *new_ptr = uma_malloc(size, flags | UMA_SCRATCH);
+    if (new_ptr) {
+        memcpy(new_ptr, ptr, hdr->size);
+        uma_scratch_free(ptr);
+    }
+    return new_ptr;
+}
+
 
 void uma_init(void) {
     uma_num_pools = 0;
+    memset(&uma_scratch, 0, sizeof(uma_scratch));
 
     #if defined(OMV_UMA_BLOCK0_MEMORY)
     typedef struct {
@@ -96,6 +244,8 @@ void uma_pool_add(void *mem, size_t size, uint32_t flags) {
     p->free = usable;
     p->persist = 0;
     p->peak = 0;
+    p->frame_peak = 0;
+    p->last_frame_peak = 0;
 }
 
 uma_pool_t *uma_pool_find(const void *ptr, size_t size, uint32_t flags) {
@@ -152,6 +302,15 @@ void *uma_malloc(size_t size, uint32_t flags) {
         size = OMV_ALIGN_TO(size, OMV_CACHE_LINE_SIZE);
     }
 
+    // Scratch blocks can only be served from the arena if they don't need a specific memory.
+    if ((flags & UMA_SCRATCH) && !(flags & (UMA_STRICT | UMA_PERSIST)) &&
+        !(flags & UMA_MEM_ATTR_MASK & ~UMA_DTCM)) {
+        ptr = uma_scratch_alloc(size, flags);
+        if (ptr) {
+            return ptr;
+        }
+    }
+
     uma_pool_t *pool = uma_pool_find(NULL, size, flags);
     if (!pool) {
         if (flags & UMA_MAYBE) {
@@ -177,9 +336,7 @@ void *uma_malloc(size_t size, uint32_t flags) {
         tlsf_block_set_persist(ptr);
         pool->persist += tlsf_block_size(ptr);
     }
-    if ((pool->size - pool->free) > pool->peak) {
-        pool->peak = pool->size - pool->free;
-    }
+    uma_pool_update_peak(pool);
 
     return ptr;
 }
@@ -214,9 +371,7 @@ void *uma_malign(size_t size, size_t align, uint32_t flags) {
         tlsf_block_set_persist(ptr);
         pool->persist += tlsf_block_size(ptr);
     }
-    if ((pool->size - pool->free) > pool->peak) {
-        pool->peak = pool->size - pool->free;
-    }
+    uma_pool_update_peak(pool);
 
     return ptr;
 }
@@ -234,6 +389,10 @@ void *uma_realloc(void *ptr, size_t size, uint32_t flags) {
         return uma_malloc(size, flags);
     }
 
+    if (uma_scratch_owns(ptr)) {
+        return uma_scratch_realloc(ptr, size, flags);
+    }
+
     if ((flags & UMA_PERSIST) || tlsf_block_is_persist(ptr)) {
         // Well, we can, but there's no use use and it's much simple this way.
         mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("can't realloc a persistent block"));
@@ -296,9 +455,7 @@ void *uma_realloc(void *ptr, size_t size, uint32_t flags) {
 
     size_t new_size = tlsf_block_size(p);
     pool->free += (int) old_size - (int) new_size;
-    if ((pool->size - pool->free) > pool->peak) {
-        pool->peak = pool->size - pool->free;
-    }
+    uma_pool_update_peak(pool);
 
     return p;
 }
@@ -308,6 +465,11 @@ void uma_free(void *ptr) {
         return;
     }
 
+    if (uma_scratch_owns(ptr)) {
+        uma_scratch_free(ptr);
+        return;
+    }
+
     uma_pool_t *pool = uma_pool_find(ptr, 0, 0);
     if (tlsf_block_is_persist(ptr)) {
         pool->persist -= tlsf_block_size(ptr);
@@ -356,7 +518,84 @@ void uma_transient_release(void) {
         p->free = p->size;
         p->persist = 0;
         p->peak = 0;
+        p->frame_peak = 0;
+    }
+}
+
+void uma_frame_begin(void) {
+    for (int i = 0; i < uma_num_pools; i++) {
+        uma_pool_t *p = &uma_pools[i];
+        p->last_frame_peak = p->frame_peak;
+        p->frame_peak = p->size - p->free;
+    }
+
+    // Blocks still live outside of any scope were leaked by a kernel that raised before
+    // freeing them, reclaim them. A frame started from a callback inside a scope keeps them.
+    if (!uma_scratch.depth) {
+        uma_scratch.top = 0;
+        uma_scratch.last = 0;
+        uma_scratch.count = 0;
+    }
+
+    uma_scratch.last_peak = uma_scratch.peak;
+    uma_scratch.last_misses = uma_scratch.misses;
+    uma_scratch.peak = uma_scratch.top;
+    uma_scratch.misses = 0;
+
+    // Resize the arena to fit the last frame, it can only be moved while empty and outside
+    // of any scope. It's dropped once a frame uses no scratch memory, and shrunk when the
+    // last frame used less than half of it.
+    size_t size = OMV_MIN(OMV_ALIGN_TO(uma_scratch.last_peak, 1024), UMA_SCRATCH_MAX_SIZE);
+    if (!uma_scratch.count && !uma_scratch.depth &&
+        ((size > uma_scratch.size) || (size <= (uma_scratch.size / 2)))) {
+        uint8_t *base = NULL;
+        if (size) {
+            base = uma_malloc(size, UMA_DTCM | UMA_CACHE | UMA_PERSIST | UMA_MAYBE);
+        }
+        if (base || !size) {
+            uint8_t *old = uma_scratch.base;
+            uma_scratch.base = NULL;
+            uma_free(old);
+            uma_scratch.base = base;
+            uma_scratch.size = size;
+            uma_scratch.top = 0;
+            uma_scratch.last = 0;
+        }
+    }
+}
+
+size_t uma_scratch_mark(void) {
+    uma_scratch.depth++;
+    return uma_scratch.top;
+}
+
+void uma_scratch_release(size_t mark) {
+    if (uma_scratch.depth) {
+        uma_scratch.depth--;
+    }
+
+    // Drop the blocks allocated after the mark from the live chain. Blocks below the mark
+    // keep their state, those freed inside the scope were already uncounted when freed.
+    while (uma_scratch.last > mark) {
+        uma_scratch_hdr_t *hdr = (uma_scratch_hdr_t *) (uma_scratch.base + uma_scratch.last) - 1;
+        if (hdr->live) {
+            hdr->live = 0;
+            uma_scratch.count--;
+        }
+        uma_scratch.last = hdr->link;
+    }
+
+    // Rewind past any freed blocks below the mark.
+    while (uma_scratch.last) {
+        uma_scratch_hdr_t *hdr = (uma_scratch_hdr_t *) (uma_scratch.base + uma_scratch.last) - 1;
+        if (hdr->live) {
+            uma_scratch.top = uma_scratch.last + hdr->size;
+            return;
+        }
+        uma_scratch.last = hdr->link;
     }
+
+    uma_scratch.top = 0;
 }
 
 void uma_collect_lock(void) {
@@ -371,6 +610,10 @@ void uma_collect(void) {
     if (uma_collect_locked) {
         return;
     }
+    uma_scratch.top = 0;
+    uma_scratch.last = 0;
+    uma_scratch.count = 0;
+    uma_scratch.depth = 0;
     for (int i = 0; i < uma_num_pools; i++) {
         size_t nblocks = 0;
         size_t freed = tlsf_collect(uma_pools[i].tlsf, &nblocks);
@@ -413,6 +656,7 @@ void uma_get_stats(int index, bool full, uma_stats_t *stats) {
         stats->free_bytes += p->free;
         stats->used_bytes += p->size - p->free;
         stats->persist_bytes += p->persist;
+        stats->frame_peak_bytes += p->last_frame_peak;
     }
 
     if (full) {
@@ -428,6 +672,10 @@ void uma_get_stats(int index, bool full, uma_stats_t *stats) {
     if (end - start == 1) {
         stats->peak_bytes = uma_pools[start].peak;
     }
+
+    stats->scratch_bytes = uma_scratch.size;
+    stats->scratch_peak_bytes = uma_scratch.last_peak;
+    stats->scratch_misses = uma_scratch.last_misses;
 }
 
 void uma_print_stats(int index) {
@@ -445,14 +693,20 @@ void uma_print_stats(int index) {
 
         printf("pool %d: base=0x%08lx size=%lu "
                "used=%lu(%lu) free=%lu(%lu) persist=%lu(%lu) "
-               "peak=%lu flags=%s%s%s\n",
+               "peak=%lu frame_peak=%lu flags=%s%s%s\n",
                i, (unsigned long) p->base, (unsigned long) p->size,
                (unsigned long) stats.used_bytes, (unsigned long) stats.used_count,
                (unsigned long) stats.free_bytes, (unsigned long) stats.free_count,
                (unsigned long) stats.persist_bytes, (unsigned long) stats.persist_count,
                (unsigned long) stats.peak_bytes,
+               (unsigned long) stats.frame_peak_bytes,
                (p->flags & UMA_FAST) ? "FAST|" : "",
                (p->flags & UMA_DTCM) ? "DTCM|" : "",
                (p->flags & UMA_TRANSIENT) ? "TRANSIENT|" : "");
     }
+
+    printf("scratch: size=%lu frame_peak=%lu misses=%lu\n",
+           (unsigned long) uma_scratch.size,
+           (unsigned long) uma_scratch.last_peak,
+           (unsigned long) uma_scratch.last_misses);
 }
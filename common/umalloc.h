@@ -30,6 +30,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include "py/nlr.h"
 #endif
 
 // Memory attributes (bits 0-7)
@@ -47,18 +48,26 @@
 #define UMA_STRICT          (1 << 9)
 #define UMA_CACHE           (1 << 10)
 #define UMA_PERSIST         (1 << 11)
+#define UMA_SCRATCH         (1 << 12)
 
 #if !defined(LINKER_SCRIPT)
 #ifndef UMA_MAX_POOLS
 #define UMA_MAX_POOLS       4
 #endif
 
+// Upper bound for the frame scratch arena, which grows to the peak scratch usage of past frames.
+#ifndef UMA_SCRATCH_MAX_SIZE
+#define UMA_SCRATCH_MAX_SIZE (32 * 1024)
+#endif
+
 typedef struct {
     void *tlsf;
     size_t size;
     size_t free;
     size_t persist;
     size_t peak;
+    size_t frame_peak;
+    size_t last_frame_peak;
     uintptr_t base;
     uintptr_t end;
     uint32_t flags;
@@ -72,6 +81,10 @@ typedef struct {
     size_t persist_count;
     size_t persist_bytes;
     size_t peak_bytes;
+    size_t frame_peak_bytes;
+    size_t scratch_bytes;
+    size_t scratch_peak_bytes;
+    size_t scratch_misses;
 } uma_stats_t;
 
 void uma_init0(void);
@@ -92,8 +105,27 @@ void  uma_collect_unlock(void);
 size_t uma_avail(uint32_t flags);
 void uma_transient_acquire(void);
 void uma_transient_release(void);
+void uma_frame_begin(void);
+size_t uma_scratch_mark(void);
+void uma_scratch_release(size_t mark);
 void uma_get_stats(int index, bool full, uma_stats_t *stats);
 void uma_print_stats(int index);
 
+// Runs stmt inside a scratch scope. The scratch blocks it leaves behind are
+// released when it returns or raises, so a failed kernel can't pin the arena.
+#define UMA_SCRATCH_CALL(stmt)                      \
+    do {                                            \
+        nlr_buf_t uma_nlr;                          \
+        size_t uma_mark = uma_scratch_mark();       \
+        if (nlr_push(&uma_nlr) == 0) {              \
+            stmt;                                   \
+            nlr_pop();                              \
+            uma_scratch_release(uma_mark);          \
+        } else {                                    \
+            uma_scratch_release(uma_mark);          \
+            nlr_jump(uma_nlr.ret_val);              \
+        }                                           \
+    } while (0)
+
 #endif // !LINKER_SCRIPT
 #endif /* __UMALLOC_H__ */
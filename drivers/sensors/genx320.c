@@ -77,10 +77,15 @@
 
 #define EHC_DIFF3D_N_BITS_SIZE          (7) // signed 8-bit value
 
+// Time surface decay table, in steps of tau / TS_LUT_STEPS up to TS_LUT_SIZE steps (8 tau).
+#define TS_LUT_STEPS                    32
+#define TS_LUT_SIZE                     256
+
 typedef struct genx_state {
     int32_t contrast;
     int32_t brightness;
     uint64_t event_time_us;
+    uint64_t surface_time_us;
     const struct issd *issd;
     genx320_mode_t mode;
     AFK_HandleTypeDef psee_afk;
@@ -99,6 +104,7 @@ static int reset(omv_csi_t *csi) {
     genx->contrast = CONTRAST_DEFAULT;
     genx->brightness = BRIGHTNESS_DEFAULT;
     genx->event_time_us = 0;
+    genx->surface_time_us = 0;
     csi->resolution[OMV_CSI_FRAMESIZE_CUSTOM][0] = ACTIVE_SENSOR_WIDTH;
     csi->resolution[OMV_CSI_FRAMESIZE_CUSTOM][1] = ACTIVE_SENSOR_HEIGHT;
 
@@ -305,6 +311,176 @@ static int disable_hot_pixels(omv_csi_t *csi, uint8_t *histogram, float sigma) {
     return ret;
 }
 
+// Finds the timestamps of the first and last pixel events in a buffer of EVT2.0 words
+// without expanding the events. Returns false if the buffer has no pixel events.
+static bool evt20_time_range(uint64_t time_high, const uint32_t *events, size_t len,
+                             uint64_t *t_first, uint64_t *t_last) {
+    size_t i = 0;
+
+    for (; i < len; i++) {
+        uint32_t type = __EVT20_TYPE(events[i]);
+        if (type == EV_TIME_HIGH) {
+            time_high = __EVT20_TIME_HIGH(events[i]);
+        } else if (type <= TD_HIGH) {
+            break;
+        }
+    }
+
+    if (i == len) {
+        return false;
+    }
+
+    *t_first = __EVT20_TIME(time_high, __EVT20_TS(events[i]));
+
+    // Walk back to the last pixel event, and then to the time high word it belongs to.
+    size_t j = len - 1;
+    while (__EVT20_TYPE(events[j]) > TD_HIGH) {
+        j--;
+    }
+
+    uint32_t ts = __EVT20_TS(events[j]);
+    while ((j > i) && (__EVT20_TYPE(events[j]) != EV_TIME_HIGH)) {
+        j--;
+    }
+
+    if (j > i) {
+        time_high = __EVT20_TIME_HIGH(events[j]);
+    }
+
+    *t_last = __EVT20_TIME(time_high, ts);
+    return true;
+}
+
+// Accumulates EVT2.0 words straight from the frame buffer. Only the time high words
+// are tracked in the sensor state, pixel events are never expanded to ec_event_t.
+static int accumulate_events(genx_state_t *genx, const uint32_t *events, size_t len,
+                             int mode, void *data, uint32_t w, uint32_t h, int param) {
+    uint64_t time_high = genx->event_time_us;
+    uint64_t t_first, t_last;
+    int count = 0;
+
+    if (!evt20_time_range(time_high, events, len, &t_first, &t_last)) {
+        // Keep the time high tracking even if there are no pixel events.
+        for (size_t i = 0; i < len; i++) {
+            if (__EVT20_TYPE(events[i]) == EV_TIME_HIGH) {
+                time_high = __EVT20_TIME_HIGH(events[i]);
+            }
+        }
+        genx->event_time_us = time_high;
+        return 0;
+    }
+
+    switch (mode) {
+        case OMV_CSI_GENX320_ACC_HISTOGRAM: {
+            uint8_t *pixels = data;
+
+            for (size_t i = 0; i < len; i++) {
+                uint32_t val = events[i];
+                uint32_t type = __EVT20_TYPE(val);
+                if (type <= TD_HIGH) {
+                    uint32_t x = __EVT20_X(val);
+                    uint32_t y = __EVT20_Y(val);
+                    if ((x < w) && (y < h)) {
+                        uint8_t *p = pixels + (y * w) + x;
+                        *p = __USAT(*p + (type == TD_HIGH ? param : -param), UINT8_T_BITS);
+                        count++;
+                    }
+                } else if (type == EV_TIME_HIGH) {
+                    time_high = __EVT20_TIME_HIGH(val);
+                }
+            }
+            break;
+        }
+        case OMV_CSI_GENX320_ACC_TIME_SURFACE: {
+            uint8_t *pixels = data;
+            uint8_t lut[TS_LUT_SIZE];
+            uint32_t tau = param;
+            uint64_t max_age = (uint64_t) tau * (TS_LUT_SIZE / TS_LUT_STEPS);
+            // LUT steps per us in 32.32 fixed-point, so it doesn't round to 0 for large tau.
+            // The index is below TS_LUT_SIZE because age < max_age.
+            uint64_t scale = ((uint64_t) TS_LUT_STEPS << 32) / tau;
+
+            // Decay the surface to the time of the last event in this buffer.
+            if (genx->surface_time_us && (t_last > genx->surface_time_us)) {
+                uint64_t dt = t_last - genx->surface_time_us;
+                if (dt >= max_age) {
+                    memset(pixels, 0, w * h);
+                } else {
+                    uint8_t decay_lut[256];
+                    float decay = expf(-(float) dt / tau);
+                    for (int i = 0; i < 256; i++) {
+                        decay_lut[i] = fast_roundf(i * decay);
+                    }
+                    for (size_t i = 0; i < (w * h); i++) {
+                        pixels[i] = decay_lut[pixels[i]];
+                    }
+                }
+            }
+
+            genx->surface_time_us = t_last;
+
+            for (int i = 0; i < TS_LUT_SIZE; i++) {
+                lut[i] = fast_roundf(255.0f * expf(-(float) i / TS_LUT_STEPS));
+            }
+
+            for (size_t i = 0; i < len; i++) {
+                uint32_t val = events[i];
+                uint32_t type = __EVT20_TYPE(val);
+                if (type <= TD_HIGH) {
+                    uint32_t x = __EVT20_X(val);
+                    uint32_t y = __EVT20_Y(val);
+                    uint64_t t = __EVT20_TIME(time_high, __EVT20_TS(val));
+                    uint64_t age = (t < t_last) ? (t_last - t) : 0;
+                    if ((x < w) && (y < h) && (age < max_age)) {
+                        uint8_t *p = pixels + (y * w) + x;
+                        *p = IM_MAX(*p, lut[(age * scale) >> 32]);
+                        count++;
+                    }
+                } else if (type == EV_TIME_HIGH) {
+                    time_high = __EVT20_TIME_HIGH(val);
+                }
+            }
+            break;
+        }
+        case OMV_CSI_GENX320_ACC_VOXEL_GRID: {
+            int16_t *grid = data;
+            uint32_t bins = param;
+            uint64_t span = (t_last - t_first) + 1;
+            // Bins per us in 32.32 fixed-point, so the per-event bin is a multiply and a shift.
+            // (t - t_first) < span keeps the product below bins << 32, so it cannot overflow.
+            uint64_t scale = ((uint64_t) bins << 32) / span;
+
+            for (size_t i = 0; i < len; i++) {
+                uint32_t val = events[i];
+                uint32_t type = __EVT20_TYPE(val);
+                if (type <= TD_HIGH) {
+                    uint32_t x = __EVT20_X(val);
+                    uint32_t y = __EVT20_Y(val);
+                    uint64_t t = __EVT20_TIME(time_high, __EVT20_TS(val));
+                    uint32_t bin = 0;
+                    if (t > t_first) {
+                        bin = IM_MIN(((t - t_first) * scale) >> 32, bins - 1);
+                    }
+                    if ((x < w) && (y < h)) {
+                        int16_t *p = grid + (((bin * h) + y) * w) + x;
+                        *p = __SSAT(*p + (type == TD_HIGH ? 1 : -1), 16);
+                        count++;
+                    }
+                } else if (type == EV_TIME_HIGH) {
+                    time_high = __EVT20_TIME_HIGH(val);
+                }
+            }
+            break;
+        }
+        default: {
+            return -1;
+        }
+    }
+
+    genx->event_time_us = time_high;
+    return count;
+}
+
 static int ioctl(omv_csi_t *csi, int request, va_list ap) {
     genx_state_t *genx = csi->priv;
     int ret = 0;
@@ -549,6 +725,40 @@ static int ioctl(omv_csi_t *csi, int request, va_list ap) {
             ret = omv_csi_snapshot(csi, img, OMV_CSI_FLAG_NO_POST | OMV_CSI_FLAG_NO_UPDATE);
             break;
         }
+        case OMV_CSI_IOCTL_GENX320_ACCUMULATE: {
+            int mode = va_arg(ap, int);
+            void *data = va_arg(ap, void *);
+            int w = va_arg(ap, int);
+            int h = va_arg(ap, int);
+            int param = va_arg(ap, int);
+
+            if (genx->mode != OMV_CSI_GENX320_MODE_EVENT) {
+                return OMV_CSI_ERROR_INVALID_ARGUMENT;
+            }
+
+            if ((mode == OMV_CSI_GENX320_ACC_TIME_SURFACE && param <= 0) ||
+                (mode == OMV_CSI_GENX320_ACC_VOXEL_GRID && (param <= 0 || param > 0xFFFF))) {
+                return OMV_CSI_ERROR_INVALID_ARGUMENT;
+            }
+
+            if (omv_csi_get_cropped(csi)) {
+                return OMV_CSI_ERROR_CAPTURE_FAILED;
+            }
+
+            if (csi->transpose) {
+                return OMV_CSI_ERROR_CAPTURE_FAILED;
+            }
+
+            image_t image;
+            ret = omv_csi_snapshot(csi, &image, OMV_CSI_FLAG_NO_POST | OMV_CSI_FLAG_NO_UPDATE);
+            if (ret < 0) {
+                break;
+            }
+
+            ret = accumulate_events(genx, (uint32_t *) image.data, (image.w * image.h) / sizeof(uint32_t),
+                                    mode, data, w, h, param);
+            break;
+        }
         case OMV_CSI_IOCTL_GENX320_CALIBRATE: {
             uint32_t event_count = va_arg(ap, uint32_t);
             float sigma = va_arg(ap, double);
@@ -702,6 +912,7 @@ static int set_active_mode(omv_csi_t *csi, genx320_mode_t mode, int framesize) {
         csi->fb->pixfmt = PIXFORMAT_INVALID;
     }
 
+    genx->surface_time_us = 0;
     genx->issd = (mode == OMV_CSI_GENX320_MODE_EVENT) ? &dcmi_evt : &dcmi_histo;
     genx->mode = mode;
     csi->post_process = (mode == OMV_CSI_GENX320_MODE_EVENT) ? post_process_event : post_process_histo;
@@ -54,4 +54,10 @@ typedef enum {
     OMV_CSI_GENX320_STC_TRAIL,
 } genx320_stc_modes_t;
 
+typedef enum {
+    OMV_CSI_GENX320_ACC_HISTOGRAM,      // Signed polarity counts into a GRAYSCALE image.
+    OMV_CSI_GENX320_ACC_TIME_SURFACE,   // Exponentially decaying time surface into a GRAYSCALE image.
+    OMV_CSI_GENX320_ACC_VOXEL_GRID,     // Signed polarity counts into an int16 (bins, h, w) grid.
+} genx320_acc_mode_t;
+
 #endif // __GENX320_H__
@@ -22,23 +22,79 @@
  * THE SOFTWARE.
  *
  * Virtual image sensor.
+ *
+ * Generates a test pattern, or replays frames from an ImageIO recording, an MJPEG
+ * AVI file or a directory of BMP/PGM/PPM/JPEG files when built with
+ * OMV_SOFTCSI_REPLAY_ENABLE, using csi.ioctl(IOCTL_SOFTCSI_REPLAY, path[, fps]).
+ * The fps argument is positional, 0 (the default) replays frames on demand.
  */
 #include "board_config.h"
 #if (OMV_SOFTCSI_ENABLE == 1)
 
 #include <stdio.h>
+#include <ctype.h>
+#include <string.h>
 #include "omv_csi.h"
 #include "vospi.h"
 #include "py/mphal.h"
+#include "py/runtime.h"
 #include "omv_common.h"
 #include "omv_gpio.h"
 #include "omv_i2c.h"
 #include "framebuffer.h"
+#if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+#include "extmod/vfs.h"
+#include "file_utils.h"
+#include "umalloc.h"
+#endif
+
+#if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+#ifndef OMV_SOFTCSI_REPLAY_MAX_FILES
+#define OMV_SOFTCSI_REPLAY_MAX_FILES    (256)
+#endif
+
+#ifndef OMV_SOFTCSI_REPLAY_NAMES_SIZE
+#define OMV_SOFTCSI_REPLAY_NAMES_SIZE   (4096)
+#endif
+
+#define REPLAY_PATH_SIZE                (128)
+#define IMAGEIO_MAGIC                   "OMV IMG STR V2.0"
+#define IMAGEIO_MAGIC_SIZE              (16)
+#define IMAGEIO_HEADER_SIZE             (32)
+#define IMAGEIO_ALIGN_SIZE              (16)
+
+typedef enum {
+    REPLAY_NONE,
+    REPLAY_IMAGEIO,
+    REPLAY_MJPEG,
+    REPLAY_FILES,
+} replay_type_t;
+
+// The files are opened for each frame, so nothing in the state points into the GC heap.
+typedef struct {
+    replay_type_t type;
+    char path[REPLAY_PATH_SIZE];
+    uint32_t period_us;         // Frame period, or 0 to replay frames on demand.
+    uint32_t next_us;           // Time of the next frame.
+    uint32_t offset;            // File offset (or index) of the next frame.
+    uint32_t start;             // File offset (or index) of the first frame.
+    uint32_t end;               // End of the frame data (or file count).
+    uint32_t width;             // MJPEG frame width.
+    uint32_t height;            // MJPEG frame height.
+    uint16_t names[OMV_SOFTCSI_REPLAY_MAX_FILES];
+    char names_pool[OMV_SOFTCSI_REPLAY_NAMES_SIZE];
+} replay_t;
+
+static replay_t replay;
+#endif // OMV_SOFTCSI_REPLAY_ENABLE
 
 static uint32_t step = 0;
 
 static int reset(omv_csi_t *csi) {
     step = 0;
+    #if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+    replay.type = REPLAY_NONE;
+    #endif
     return 0;
 }
 
@@ -64,7 +120,7 @@ static int set_vflip(omv_csi_t *csi, int enable) {
     return 0;
 }
 
-static int snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
+static int pattern_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
     framebuffer_t *fb = csi->fb;
 
     // This driver can't use handle NULL images.
@@ -79,6 +135,8 @@ static int snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
         return OMV_CSI_ERROR_FRAMEBUFFER_ERROR;
     }
 
+    framebuffer_begin_frame(fb);
+
     // Set the framebuffer pixel format.
     fb->pixfmt = csi->pixformat;
 
@@ -135,6 +193,399 @@ static int snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
     return 0;
 }
 
+#if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+static bool replay_has_extension(const char *name) {
+    // PBM (P1/P4) is not supported by imlib_read_geometry().
+    static const char *const exts[] = { ".bmp", ".pgm", ".ppm", ".jpg", ".jpeg" };
+    const char *ext = strrchr(name, '.');
+    char lower[6];
+
+    if (!ext || strlen(ext) >= sizeof(lower)) {
+        return false;
+    }
+
+    for (size_t i = 0; i <= strlen(ext); i++) {
+        lower[i] = tolower((unsigned char) ext[i]);
+    }
+
+    for (size_t i = 0; i < OMV_ARRAY_SIZE(exts); i++) {
+        if (!strcmp(lower, exts[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lists the image files in a directory, sorted by name.
+static void replay_list_files(const char *path) {
+    mp_obj_t path_obj = mp_obj_new_str_from_cstr(path);
+    mp_obj_t iter = mp_getiter(mp_vfs_ilistdir(1, &path_obj), NULL);
+    size_t pool_used = 0;
+
+    replay.end = 0;
+
+    for (mp_obj_t item; (item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION;) {
+        mp_obj_t *fields;
+        mp_obj_get_array_fixed_n(item, 3, &fields);
+        const char *name = mp_obj_str_get_str(fields[0]);
+        size_t size = strlen(name) + 1;
+
+        if ((mp_obj_get_int(fields[1]) & MP_S_IFDIR) || !replay_has_extension(name)) {
+            continue;
+        }
+
+        if ((replay.end == OMV_SOFTCSI_REPLAY_MAX_FILES) ||
+            ((pool_used + size) > OMV_SOFTCSI_REPLAY_NAMES_SIZE) ||
+            ((strlen(path) + size + 1) > REPLAY_PATH_SIZE)) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Too many files to replay"));
+        }
+
+        memcpy(replay.names_pool + pool_used, name, size);
+
+        // Insertion sort, the directory order is not defined.
+        size_t i = replay.end++;
+        for (; i && strcmp(replay.names_pool + replay.names[i - 1], name) > 0; i--) {
+            replay.names[i] = replay.names[i - 1];
+        }
+        replay.names[i] = pool_used;
+        pool_used += size;
+    }
+
+    if (!replay.end) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("No image files found"));
+    }
+}
+
+// Finds the frame chunks and the frame size of an MJPEG AVI file.
+static void replay_open_mjpeg(file_t *fp) {
+    uint32_t size = file_size(fp);
+
+    for (uint32_t offset = 12; (offset + 12) <= size;) {
+        uint8_t fourcc[4];
+        uint32_t chunk_size, list_type;
+
+        file_seek(fp, offset);
+        file_read(fp, fourcc, 4);
+        file_read(fp, &chunk_size, 4);
+
+        if (!memcmp(fourcc, "LIST", 4)) {
+            file_read(fp, &list_type, 4);
+            if (!memcmp(&list_type, "movi", 4)) {
+                replay.start = offset + 12;
+                // The size isn't updated until the file is closed.
+                replay.end = chunk_size ? IM_MIN(offset + 8 + chunk_size, size) : size;
+                break;
+            }
+            // Descend into the other lists, e.g. hdrl and strl.
+            offset += 12;
+            continue;
+        }
+
+        if (!memcmp(fourcc, "avih", 4)) {
+            uint32_t avih[10];
+            file_read(fp, avih, sizeof(avih));
+            replay.width = avih[8];
+            replay.height = avih[9];
+        }
+
+        offset += 8 + ((chunk_size + 1) & ~1);
+    }
+
+    if (!replay.start || !replay.width || !replay.height) {
+        file_raise_format(fp);
+    }
+}
+
+static int replay_open(const char *path, int fps) {
+    replay.type = REPLAY_NONE;
+
+    if (!path) {
+        return 0;
+    }
+
+    if ((fps < 0) || (strlen(path) >= REPLAY_PATH_SIZE)) {
+        return OMV_CSI_ERROR_INVALID_ARGUMENT;
+    }
+
+    replay_type_t type = REPLAY_FILES;
+    mp_obj_t stat = mp_vfs_stat(mp_obj_new_str_from_cstr(path));
+
+    strcpy(replay.path, path);
+    replay.offset = 0;
+    replay.start = 0;
+
+    if (mp_obj_get_int(mp_obj_subscr(stat, MP_OBJ_NEW_SMALL_INT(0), MP_OBJ_SENTINEL)) & MP_S_IFDIR) {
+        replay_list_files(path);
+    } else {
+        file_t fp;
+        uint8_t magic[IMAGEIO_MAGIC_SIZE];
+
+        file_open(&fp, path, FA_READ | FA_OPEN_EXISTING);
+        file_read(&fp, magic, IMAGEIO_MAGIC_SIZE);
+
+        if (!memcmp(magic, IMAGEIO_MAGIC, IMAGEIO_MAGIC_SIZE)) {
+            type = REPLAY_IMAGEIO;
+            replay.start = IMAGEIO_MAGIC_SIZE;
+            replay.end = file_size(&fp);
+        } else if (!memcmp(magic, "RIFF", 4) && !memcmp(magic + 8, "AVI ", 4)) {
+            type = REPLAY_MJPEG;
+            replay_open_mjpeg(&fp);
+        } else {
+            file_raise_format(&fp);
+        }
+
+        file_close(&fp);
+
+        if (replay.start >= replay.end) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("No frames to replay"));
+        }
+    }
+
+    replay.offset = replay.start;
+    replay.period_us = fps ? (1000000 / fps) : 0;
+    replay.next_us = mp_hal_ticks_us();
+    replay.type = type;
+    return 0;
+}
+
+// Loads the frame from path, or reads size bytes of it from fp, into a new (uma) buffer.
+static void replay_load_frame(image_t *image, uint32_t size, file_t *fp, const char *path) {
+    image->data = uma_malloc(size, UMA_CACHE);
+
+    // The buffer must not leak if the frame can't be read.
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        if (path) {
+            imlib_load_image(image, path);
+        } else {
+            file_read(fp, image->data, size);
+        }
+        nlr_pop();
+    } else {
+        uma_free(image->data);
+        image->data = NULL;
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+// Reads the next frame into a new (uma) buffer, or skips it if image is NULL.
+static void replay_read_frame(image_t *image) {
+    file_t fp;
+
+    if (replay.type == REPLAY_FILES) {
+        char path[REPLAY_PATH_SIZE];
+        snprintf(path, sizeof(path), "%s/%s", replay.path, replay.names_pool + replay.names[replay.offset]);
+        replay.offset = (replay.offset + 1) % replay.end;
+
+        if (image) {
+            img_read_settings_t rs;
+            imlib_read_geometry(&fp, image, path, &rs);
+            file_close(&fp);
+            replay_load_frame(image, image_size(image), NULL, path);
+        }
+        return;
+    }
+
+    file_open(&fp, replay.path, FA_READ | FA_OPEN_EXISTING);
+
+    if (replay.type == REPLAY_IMAGEIO) {
+        uint32_t header[IMAGEIO_HEADER_SIZE / sizeof(uint32_t)];
+
+        if ((replay.offset + IMAGEIO_HEADER_SIZE) > replay.end) {
+            replay.offset = replay.start;
+        }
+
+        // Elapsed time, width, height, pixel format, size and padding.
+        file_seek(&fp, replay.offset);
+        file_read(&fp, header, IMAGEIO_HEADER_SIZE);
+
+        image_t frame = { .w = header[1], .h = header[2], .pixfmt = header[3], .size = header[4] };
+
+        if (!IMLIB_PIXFORMAT_IS_VALID(frame.pixfmt)) {
+            file_raise_corrupted(&fp);
+        }
+
+        uint32_t size = image_size(&frame);
+        replay.offset += IMAGEIO_HEADER_SIZE + OMV_ALIGN_TO(size, IMAGEIO_ALIGN_SIZE);
+
+        if (image) {
+            *image = frame;
+            replay_load_frame(image, size, &fp, NULL);
+        }
+    } else {
+        // Skip the chunks that aren't video frames, e.g. JUNK or index chunks.
+        for (bool wrapped = false; ;) {
+            uint8_t fourcc[4];
+            uint32_t size;
+
+            if ((replay.offset + 8) > replay.end) {
+                if (wrapped) {
+                    file_raise_format(&fp);
+                }
+                wrapped = true;
+                replay.offset = replay.start;
+            }
+
+            file_seek(&fp, replay.offset);
+            file_read(&fp, fourcc, 4);
+            file_read(&fp, &size, 4);
+            replay.offset += 8 + ((size + 1) & ~1);
+
+            if ((fourcc[2] == 'd') && ((fourcc[3] == 'c') || (fourcc[3] == 'b'))) {
+                if (image) {
+                    *image = (image_t) {
+                        .w = replay.width, .h = replay.height, .pixfmt = PIXFORMAT_JPEG, .size = size
+                    };
+                    replay_load_frame(image, size, &fp, NULL);
+                }
+                break;
+            }
+        }
+    }
+
+    file_close(&fp);
+}
+
+// Captures the next frame into a free buffer, scaled to the frame size and cropped to the window.
+static void replay_capture(omv_csi_t *csi) {
+    framebuffer_t *fb = csi->fb;
+    vbuffer_t *buffer = framebuffer_acquire(fb, FB_FLAG_FREE | FB_FLAG_PEEK);
+
+    // The frame is dropped if there are no free buffers.
+    if (!buffer) {
+        replay_read_frame(NULL);
+        return;
+    }
+
+    image_t src;
+    framebuffer_begin_frame(fb);
+    replay_read_frame(&src);
+
+    image_t dst = {
+        .w = csi->transpose ? fb->v : fb->u,
+        .h = csi->transpose ? fb->u : fb->v,
+        .pixfmt = csi->pixformat,
+        .data = buffer->data,
+    };
+
+    float x_scale = (float) csi->resolution[csi->framesize][0] / src.w;
+    float y_scale = (float) csi->resolution[csi->framesize][1] / src.h;
+    int x = csi->transpose ? -fb->y : -fb->x;
+    int y = csi->transpose ? -fb->x : -fb->y;
+
+    image_hint_t hint = ((x_scale < 1.0f) || (y_scale < 1.0f)) ? IMAGE_HINT_AREA : IMAGE_HINT_BILINEAR;
+    hint |= (csi->hmirror ? IMAGE_HINT_HMIRROR : 0) |
+            (csi->vflip ? IMAGE_HINT_VFLIP : 0) |
+            (csi->transpose ? IMAGE_HINT_TRANSPOSE : 0) |
+            IMAGE_HINT_BLACK_BACKGROUND;
+
+    // The frame must not leak if it can't be decoded.
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        imlib_draw_image(&dst, &src, x, y, x_scale, y_scale, NULL, -1, 255, NULL, NULL, hint, NULL, NULL, NULL, NULL);
+        nlr_pop();
+    } else {
+        uma_free(src.data);
+        nlr_jump(nlr.ret_val);
+    }
+    uma_free(src.data);
+
+    // Move the buffer from free queue -> used queue, or keep the latest frames
+    // when the queue is full, the same as the hardware drivers.
+    framebuffer_release(fb, FB_FLAG_FREE | FB_FLAG_CHECK_LAST);
+}
+
+// Captures the frames that are due, which the hardware would have captured in the background.
+static void replay_poll(omv_csi_t *csi) {
+    framebuffer_t *fb = csi->fb;
+
+    if (!replay.period_us) {
+        if (!framebuffer_readable(fb)) {
+            replay_capture(csi);
+        }
+        return;
+    }
+
+    uint32_t due = (mp_hal_ticks_us() - replay.next_us);
+    if ((int32_t) due < 0) {
+        return;
+    }
+
+    // Frames older than the buffer queue would have been overwritten, skip them without decoding.
+    uint32_t frames = (due / replay.period_us) + 1;
+    for (; frames > fb->buf_count; frames--) {
+        replay_read_frame(NULL);
+        replay.next_us += replay.period_us;
+    }
+
+    for (; frames; frames--) {
+        replay_capture(csi);
+        replay.next_us += replay.period_us;
+    }
+}
+
+static int replay_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
+    framebuffer_t *fb = csi->fb;
+
+    // Frames are only drawn to the formats set_pixformat() accepts.
+    if ((csi->pixformat != PIXFORMAT_GRAYSCALE) && (csi->pixformat != PIXFORMAT_RGB565)) {
+        return OMV_CSI_ERROR_INVALID_PIXFORMAT;
+    }
+
+    // Wait for a frame to be ready.
+    for (mp_uint_t start = mp_hal_ticks_ms(); ; mp_event_handle_nowait()) {
+        replay_poll(csi);
+
+        if (framebuffer_readable(fb)) {
+            break;
+        }
+
+        if (flags & OMV_CSI_FLAG_NON_BLOCK) {
+            return OMV_CSI_ERROR_WOULD_BLOCK;
+        }
+
+        // Compress the staged preview frame while waiting.
+        framebuffer_poll_preview();
+
+        if ((mp_hal_ticks_ms() - start) > OMV_CSI_TIMEOUT_MS) {
+            return OMV_CSI_ERROR_CAPTURE_TIMEOUT;
+        }
+    }
+
+    // Set the framebuffer pixel format.
+    fb->pixfmt = csi->pixformat;
+
+    // Set the framebuffer width/height.
+    fb->w = csi->transpose ? fb->v : fb->u;
+    fb->h = csi->transpose ? fb->u : fb->v;
+
+    framebuffer_to_image(fb, image);
+    return 0;
+}
+
+static int ioctl(omv_csi_t *csi, int request, va_list ap) {
+    switch (request) {
+        case OMV_CSI_IOCTL_SOFTCSI_REPLAY: {
+            const char *path = va_arg(ap, const char *);
+            int fps = va_arg(ap, int);
+            return replay_open(path, fps);
+        }
+        default: {
+            return OMV_CSI_ERROR_CTL_UNSUPPORTED;
+        }
+    }
+}
+#endif // OMV_SOFTCSI_REPLAY_ENABLE
+
+static int snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
+    #if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+    if (replay.type != REPLAY_NONE) {
+        return replay_snapshot(csi, image, flags);
+    }
+    #endif
+    return pattern_snapshot(csi, image, flags);
+}
+
 int softcsi_init(omv_csi_t *csi) {
     csi->reset = reset;
     csi->abort = NULL;
@@ -144,6 +595,9 @@ int softcsi_init(omv_csi_t *csi) {
     csi->set_hmirror = set_hmirror;
     csi->set_vflip = set_vflip;
     csi->snapshot = snapshot;
+    #if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+    csi->ioctl = ioctl;
+    #endif
 
     csi->auxiliary = 1;
     csi->vsync_pol = 1;
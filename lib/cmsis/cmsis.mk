@@ -36,8 +36,25 @@ CMSIS_SRC_C += $(addprefix cmsis/src/dsp/,\
 	CommonTables/CommonTablesF16.c \
 	FastMathFunctions/FastMathFunctions.c \
 	FastMathFunctions/FastMathFunctionsF16.c \
+	TransformFunctions/arm_bitreversal2.c \
+	TransformFunctions/arm_cfft_f32.c \
+	TransformFunctions/arm_cfft_init_f32.c \
+	TransformFunctions/arm_cfft_radix8_f32.c \
+	TransformFunctions/arm_rfft_fast_f32.c \
+	TransformFunctions/arm_rfft_fast_init_f32.c \
 )
 
+# Only link the FFT tables for the lengths imlib/fft.c uses, otherwise the init
+# functions pull in the tables for every length. The fast math tables are kept.
+# The MVE init functions use the fixed-point bit reversal tables (FXT).
+CMSIS_FFT_LENGTHS := 16 32 64 128 256 512 1024
+CMSIS_DSP_CFLAGS += -DARM_DSP_CONFIG_TABLES -DARM_FFT_ALLOW_TABLES -DARM_FAST_ALLOW_TABLES -DARM_ALL_FAST_TABLES
+CMSIS_DSP_CFLAGS += $(foreach n,$(CMSIS_FFT_LENGTHS),\
+	-DARM_TABLE_TWIDDLECOEF_F32_$(n) -DARM_TABLE_BITREVIDX_FLT_$(n) -DARM_TABLE_BITREVIDX_FXT_$(n))
+CMSIS_DSP_CFLAGS += $(foreach n,$(filter-out 16,$(CMSIS_FFT_LENGTHS)),-DARM_TABLE_TWIDDLECOEF_RFFT_F32_$(n))
+
+$(BUILD)/lib/cmsis/src/dsp/%.o: override CFLAGS += $(CMSIS_DSP_CFLAGS)
+
 HAL_CFLAGS += -I$(TOP_DIR)/lib/cmsis/include
 HAL_CFLAGS += -I$(TOP_DIR)/lib/cmsis/include/$(CMSIS_INC)
 
@@ -5,9 +5,12 @@
 // OpenMV wrapper for upstream AprilTag v3.4.5 (configurable fork).
 // Provides imlib_find_apriltags() and imlib_find_rects().
 
+#include "py/nlr.h"
+
 #include "imlib.h"
 #include "umalloc.h"
 #include "fmath.h"
+#include "trace.h"
 
 #include "apriltag.h"
 #include "common/image_u8.h"
@@ -49,92 +52,132 @@ extern int quad_update_homographies(struct quad *quad);
 extern zarray_t *apriltag_quad_thresh(apriltag_detector_t *td, image_u8_t *im);
 extern void refine_edges(apriltag_detector_t *td, image_u8_t *im_orig, struct quad *quad);
 
+// Extra UMA flags for all AprilTag allocations (see apriltag_config.h).
+uint32_t apriltag_uma_flags;
+
 #ifdef IMLIB_ENABLE_APRILTAGS
-void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
-                          float fx, float fy, float cx, float cy) {
-    apriltag_detector_t *td = apriltag_detector_create();
-    td->nthreads = 1;
-    td->wp = workerpool_create(td->nthreads);
+typedef struct imlib_apriltag_family {
+    apriltag_families_t id;
+    apriltag_family_t *(*create)(void);
+    void (*destroy)(apriltag_family_t *tf);
+} imlib_apriltag_family_t;
 
-    // Create and add requested tag families.
+static const imlib_apriltag_family_t imlib_apriltag_families[] = {
     #ifdef IMLIB_ENABLE_APRILTAGS_TAG16H5
-    apriltag_family_t *tf_tag16h5 = NULL;
-    if (families & TAG16H5) {
-        tf_tag16h5 = tag16h5_create();
-        apriltag_detector_add_family(td, tf_tag16h5);
-    }
+    { TAG16H5, tag16h5_create, tag16h5_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAG25H9
-    apriltag_family_t *tf_tag25h9 = NULL;
-    if (families & TAG25H9) {
-        tf_tag25h9 = tag25h9_create();
-        apriltag_detector_add_family(td, tf_tag25h9);
-    }
+    { TAG25H9, tag25h9_create, tag25h9_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H10
-    apriltag_family_t *tf_tag36h10 = NULL;
-    if (families & TAG36H10) {
-        tf_tag36h10 = tag36h10_create();
-        apriltag_detector_add_family(td, tf_tag36h10);
-    }
+    { TAG36H10, tag36h10_create, tag36h10_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H11
-    apriltag_family_t *tf_tag36h11 = NULL;
-    if (families & TAG36H11) {
-        tf_tag36h11 = tag36h11_create();
-        apriltag_detector_add_family(td, tf_tag36h11);
-    }
+    { TAG36H11, tag36h11_create, tag36h11_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE21H7
-    apriltag_family_t *tf_tagCircle21h7 = NULL;
-    if (families & TAGCIRCLE21H7) {
-        tf_tagCircle21h7 = tagCircle21h7_create();
-        apriltag_detector_add_family(td, tf_tagCircle21h7);
-    }
+    { TAGCIRCLE21H7, tagCircle21h7_create, tagCircle21h7_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE49H12
-    apriltag_family_t *tf_tagCircle49h12 = NULL;
-    if (families & TAGCIRCLE49H12) {
-        tf_tagCircle49h12 = tagCircle49h12_create();
-        apriltag_detector_add_family(td, tf_tagCircle49h12);
-    }
+    { TAGCIRCLE49H12, tagCircle49h12_create, tagCircle49h12_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAGCUSTOM48H12
-    apriltag_family_t *tf_tagCustom48h12 = NULL;
-    if (families & TAGCUSTOM48H12) {
-        tf_tagCustom48h12 = tagCustom48h12_create();
-        apriltag_detector_add_family(td, tf_tagCustom48h12);
-    }
+    { TAGCUSTOM48H12, tagCustom48h12_create, tagCustom48h12_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD41H12
-    apriltag_family_t *tf_tagStandard41h12 = NULL;
-    if (families & TAGSTANDARD41H12) {
-        tf_tagStandard41h12 = tagStandard41h12_create();
-        apriltag_detector_add_family(td, tf_tagStandard41h12);
-    }
+    { TAGSTANDARD41H12, tagStandard41h12_create, tagStandard41h12_destroy },
     #endif
-
     #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD52H13
-    apriltag_family_t *tf_tagStandard52h13 = NULL;
-    if (families & TAGSTANDARD52H13) {
-        tf_tagStandard52h13 = tagStandard52h13_create();
-        apriltag_detector_add_family(td, tf_tagStandard52h13);
-    }
+    { TAGSTANDARD52H13, tagStandard52h13_create, tagStandard52h13_destroy },
     #endif
+};
+
+void imlib_apriltag_detector_init(imlib_apriltag_detector_t *detector, apriltag_families_t families, uint32_t uma_flags) {
+    nlr_buf_t nlr;
+    memset(detector, 0, sizeof(imlib_apriltag_detector_t));
+    detector->uma_flags = uma_flags;
+    apriltag_uma_flags = uma_flags;
+
+    if (nlr_push(&nlr) == 0) {
+        apriltag_detector_t *td = apriltag_detector_create();
+        td->nthreads = 1;
+        detector->td = td;
+
+        // Reserve the family list up front since persistent blocks can't be reallocated.
+        zarray_ensure_capacity(td->tag_families, IMLIB_APRILTAG_FAMILIES_MAX);
+
+        // Create and add requested tag families (this builds the quick-decode tables).
+        for (size_t i = 0; i < OMV_ARRAY_SIZE(imlib_apriltag_families); i++) {
+            if (families & imlib_apriltag_families[i].id) {
+                detector->families[i] = imlib_apriltag_families[i].create();
+                apriltag_detector_add_family(td, detector->families[i]);
+            }
+        }
+        nlr_pop();
+    } else {
+        // The flags must not stay set, or every later detection allocates persistent blocks.
+        apriltag_uma_flags = 0;
+        imlib_apriltag_detector_deinit(detector);
+        nlr_jump(nlr.ret_val);
+    }
+
+    detector->quad_decimate = detector->td->quad_decimate;
+    detector->quad_sigma = detector->td->quad_sigma;
+    detector->refine_edges = detector->td->refine_edges;
+    apriltag_uma_flags = 0;
+}
+
+void imlib_apriltag_detector_deinit(imlib_apriltag_detector_t *detector) {
+    if (detector->td) {
+        // The worker pool only lives for the duration of a detection.
+        detector->td->wp = NULL;
+        apriltag_detector_destroy(detector->td);
+    }
+
+    for (size_t i = 0; i < OMV_ARRAY_SIZE(imlib_apriltag_families); i++) {
+        if (detector->families[i]) {
+            imlib_apriltag_families[i].destroy(detector->families[i]);
+        }
+    }
+
+    if (detector->buffer) {
+        uma_free(detector->buffer);
+    }
+
+    memset(detector, 0, sizeof(imlib_apriltag_detector_t));
+}
+
+// Detection stages are kept in separate functions so the profiler reports them individually,
+// and each one is recorded as its own span in the trace ring.
+static image_u8_t imlib_apriltag_detector_convert(imlib_apriltag_detector_t *detector, image_t *ptr, rectangle_t *roi) {
+    if (ptr->pixfmt == PIXFORMAT_GRAYSCALE && detector->quad_sigma == 0.0f) {
+        // Grayscale images are used in place unless quad_sigma is set, which blurs the input.
+        image_u8_t im = {
+            .width = roi->w,
+            .height = roi->h,
+            .stride = ptr->w,
+            .buf = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, roi->y) + roi->x,
+        };
+        return im;
+    }
 
-    // Allocate grayscale image from frame buffer.
     image_t img;
     img.w = roi->w;
     img.h = roi->h;
     img.pixfmt = PIXFORMAT_GRAYSCALE;
-    img.data = uma_malloc(image_size(&img), UMA_CACHE);
+
+    // The grayscale buffer is reused by following calls (only grows).
+    if (image_size(&img) > detector->buffer_size) {
+        if (detector->buffer) {
+            uma_free(detector->buffer);
+            detector->buffer = NULL;
+            detector->buffer_size = 0;
+        }
+        detector->buffer = uma_malloc(image_size(&img), UMA_CACHE | detector->uma_flags);
+        detector->buffer_size = image_size(&img);
+    }
+
+    img.data = detector->buffer;
     imlib_draw_image(&img, ptr, 0, 0, 1.0f, 1.0f, roi, -1, 255, NULL, NULL, 0, NULL, NULL, NULL, NULL);
 
     image_u8_t im = {
@@ -143,8 +186,20 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
         .stride = roi->w,
         .buf = img.data,
     };
+    return im;
+}
 
-    zarray_t *detections = apriltag_detector_detect(td, &im);
+static zarray_t *imlib_apriltag_detector_run(apriltag_detector_t *td, image_u8_t *im) {
+    // The worker pool's task list grows while detecting, so it's never persistent.
+    td->wp = workerpool_create(td->nthreads);
+    zarray_t *detections = apriltag_detector_detect(td, im);
+    workerpool_destroy(td->wp);
+    td->wp = NULL;
+    return detections;
+}
+
+static void imlib_apriltag_detector_output(imlib_apriltag_detector_t *detector, list_t *out, zarray_t *detections,
+                                           rectangle_t *roi, float fx, float fy, float cx, float cy) {
     list_init(out, sizeof(find_apriltags_list_lnk_data_t));
 
     for (int i = 0, j = zarray_size(detections); i < j; i++) {
@@ -176,51 +231,11 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
         lnk_data.id = det->id;
         lnk_data.family = 0;
 
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAG16H5
-        if (tf_tag16h5 && det->family == tf_tag16h5) {
-            lnk_data.family |= TAG16H5;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAG25H9
-        if (tf_tag25h9 && det->family == tf_tag25h9) {
-            lnk_data.family |= TAG25H9;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H10
-        if (tf_tag36h10 && det->family == tf_tag36h10) {
-            lnk_data.family |= TAG36H10;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H11
-        if (tf_tag36h11 && det->family == tf_tag36h11) {
-            lnk_data.family |= TAG36H11;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE21H7
-        if (tf_tagCircle21h7 && det->family == tf_tagCircle21h7) {
-            lnk_data.family |= TAGCIRCLE21H7;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE49H12
-        if (tf_tagCircle49h12 && det->family == tf_tagCircle49h12) {
-            lnk_data.family |= TAGCIRCLE49H12;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAGCUSTOM48H12
-        if (tf_tagCustom48h12 && det->family == tf_tagCustom48h12) {
-            lnk_data.family |= TAGCUSTOM48H12;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD41H12
-        if (tf_tagStandard41h12 && det->family == tf_tagStandard41h12) {
-            lnk_data.family |= TAGSTANDARD41H12;
-        }
-        #endif
-        #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD52H13
-        if (tf_tagStandard52h13 && det->family == tf_tagStandard52h13) {
-            lnk_data.family |= TAGSTANDARD52H13;
+        for (size_t k = 0; k < OMV_ARRAY_SIZE(imlib_apriltag_families); k++) {
+            if (detector->families[k] && det->family == detector->families[k]) {
+                lnk_data.family |= imlib_apriltag_families[k].id;
+            }
         }
-        #endif
 
         lnk_data.hamming = det->hamming;
         lnk_data.centroid_x = det->c[0] + roi->x;
@@ -243,58 +258,32 @@ void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_
 
         list_push_back(out, &lnk_data);
     }
+}
 
+void imlib_apriltag_detector_detect(imlib_apriltag_detector_t *detector, list_t *out, image_t *ptr, rectangle_t *roi,
+                                    float fx, float fy, float cx, float cy) {
+    apriltag_detector_t *td = detector->td;
+    td->quad_decimate = detector->quad_decimate;
+    td->quad_sigma = detector->quad_sigma;
+    td->refine_edges = detector->refine_edges;
+
+    image_u8_t im;
+    zarray_t *detections;
+
+    // All stages allocate and can raise, so the spans are closed by OMV_TRACE_CALL.
+    OMV_TRACE_CALL("tag_convert", im = imlib_apriltag_detector_convert(detector, ptr, roi));
+    OMV_TRACE_CALL("tag_detect", detections = imlib_apriltag_detector_run(td, &im));
+    OMV_TRACE_CALL("tag_output",
+                   imlib_apriltag_detector_output(detector, out, detections, roi, fx, fy, cx, cy));
     apriltag_detections_destroy(detections);
-    apriltag_detector_destroy(td);
-
-    // Destroy tag families.
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAG16H5
-    if (tf_tag16h5) {
-        tag16h5_destroy(tf_tag16h5);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAG25H9
-    if (tf_tag25h9) {
-        tag25h9_destroy(tf_tag25h9);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H10
-    if (tf_tag36h10) {
-        tag36h10_destroy(tf_tag36h10);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAG36H11
-    if (tf_tag36h11) {
-        tag36h11_destroy(tf_tag36h11);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE21H7
-    if (tf_tagCircle21h7) {
-        tagCircle21h7_destroy(tf_tagCircle21h7);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAGCIRCLE49H12
-    if (tf_tagCircle49h12) {
-        tagCircle49h12_destroy(tf_tagCircle49h12);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAGCUSTOM48H12
-    if (tf_tagCustom48h12) {
-        tagCustom48h12_destroy(tf_tagCustom48h12);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD41H12
-    if (tf_tagStandard41h12) {
-        tagStandard41h12_destroy(tf_tagStandard41h12);
-    }
-    #endif
-    #ifdef IMLIB_ENABLE_APRILTAGS_TAGSTANDARD52H13
-    if (tf_tagStandard52h13) {
-        tagStandard52h13_destroy(tf_tagStandard52h13);
-    }
-    #endif
+}
 
-    uma_free(img.data);
+void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
+                          float fx, float fy, float cx, float cy) {
+    imlib_apriltag_detector_t detector;
+    imlib_apriltag_detector_init(&detector, families, 0);
+    imlib_apriltag_detector_detect(&detector, out, ptr, roi, fx, fy, cx, cy);
+    imlib_apriltag_detector_deinit(&detector);
 }
 #endif //IMLIB_ENABLE_APRILTAGS
 
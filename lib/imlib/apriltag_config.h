@@ -54,10 +54,14 @@
 #define APRILTAG_ENABLE_TAGSTANDARD52H13 (0)
 #endif
 
+// Extra UMA flags for AprilTag allocations, set to UMA_PERSIST while
+// creating a detector that's kept alive across calls (see apriltag.c).
+extern uint32_t apriltag_uma_flags;
+
 // Redirect malloc/calloc/realloc/free to UMA allocator.
-#define apriltag_malloc(s)      uma_malloc(s, UMA_DTCM)
-#define apriltag_calloc(n, s)   uma_calloc((n) * (s), UMA_DTCM)
-#define apriltag_realloc(p, s)  uma_realloc(p, s, UMA_DTCM)
+#define apriltag_malloc(s)      uma_malloc(s, UMA_DTCM | apriltag_uma_flags)
+#define apriltag_calloc(n, s)   uma_calloc((n) * (s), UMA_DTCM | apriltag_uma_flags)
+#define apriltag_realloc(p, s)  uma_realloc(p, s, UMA_DTCM | apriltag_uma_flags)
 #define apriltag_free(p)        uma_free(p)
 #define apriltag_assert(x)      ((void) 0)
 #define apriltag_poll_events()  imlib_poll_events()
@@ -922,82 +922,280 @@ void imlib_b_xnor_line_op(int x, int x_end, int y_row, imlib_draw_row_data_t *da
     }
 }
 
-static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_d, image_t *mask) {
+// Returns word i of src shifted so that bit x of the result is bit (x + s) of src.
+static inline uint32_t binary_row_word_shr(const uint32_t *src, int words, int i, int s) {
+    int q = i + (s >> UINT32_T_SHIFT), b = s & UINT32_T_MASK;
+    uint32_t lo = (q < words) ? src[q] : 0;
+    if (!b) {
+        return lo;
+    }
+    uint32_t hi = ((q + 1) < words) ? src[q + 1] : 0;
+    return (lo >> b) | (hi << (UINT32_T_BITS - b));
+}
+
+// Returns word i of src shifted so that bit x of the result is bit (x - s) of src.
+static inline uint32_t binary_row_word_shl(const uint32_t *src, int words, int i, int s) {
+    int q = i - (s >> UINT32_T_SHIFT), b = s & UINT32_T_MASK;
+    uint32_t hi = ((0 <= q) && (q < words)) ? src[q] : 0;
+    if (!b) {
+        return hi;
+    }
+    uint32_t lo = ((1 <= q) && (q <= words)) ? src[q - 1] : 0;
+    return (hi << b) | (lo >> (UINT32_T_BITS - b));
+}
+
+// Counters are stored bit-sliced: plane b holds bit b of the count of every pixel in the row.
+static inline void binary_count_add_row(uint32_t *planes, int bits, int words, const uint32_t *row,
+                                        uint32_t last_mask, bool sub) {
+    for (int i = 0; i < words; i++) {
+        uint32_t carry = row[i] & ((i == (words - 1)) ? last_mask : 0xFFFFFFFF);
+
+        for (int b = 0; (b < bits) && carry; b++) {
+            uint32_t p = planes[(b * words) + i];
+            planes[(b * words) + i] = p ^ carry;
+            carry = (sub ? ~p : p) & carry;
+        }
+    }
+}
+
+// dst(x) += src(x + s). May be called in place since words are read ahead of being written.
+static inline void binary_count_add_shr(uint32_t *dst, int dst_bits, const uint32_t *src, int src_bits,
+                                        int words, int s) {
+    for (int i = 0; i < words; i++) {
+        uint32_t v[UINT32_T_BITS];
+
+        for (int b = 0; b < src_bits; b++) {
+            v[b] = binary_row_word_shr(src + (b * words), words, i, s);
+        }
+
+        uint32_t carry = 0;
+
+        for (int b = 0; b < dst_bits; b++) {
+            uint32_t a = dst[(b * words) + i], x = (b < src_bits) ? v[b] : 0;
+
+            if ((b >= src_bits) && (!carry)) {
+                break;
+            }
+
+            dst[(b * words) + i] = a ^ x ^ carry;
+            carry = (a & x) | (carry & (a ^ x));
+        }
+    }
+}
+
+// Returns a mask of the pixels in word i whose count is >= t.
+static inline uint32_t binary_count_ge(const uint32_t *planes, int bits, int words, int i, int t) {
+    uint32_t gt = 0, eq = 0xFFFFFFFF;
+
+    for (int b = bits - 1; b >= 0; b--) {
+        uint32_t p = planes[(b * words) + i];
+
+        if ((t >> b) & 1) {
+            eq &= p;
+        } else {
+            gt |= eq & p;
+            eq &= ~p;
+        }
+    }
+
+    return gt | eq;
+}
+
+static inline void binary_row_fill(uint32_t *row, int start, int end, int value) {
+    for (int x = start; x < end; x++) {
+        IMAGE_PUT_BINARY_PIXEL_FAST(row, x, value);
+    }
+}
+
+// Erodes or dilates a BINARY image a word (32 pixels) at a time. A pixel is set (dilate) or kept
+// (erode) when at least t pixels of its edge clamped (ksize*2+1)^2 neighborhood are set. The
+// usual t == 1 (dilate) and t == n (erode) cases are separable ORs of the rows and of shifted
+// copies of the result. Other thresholds count pixels with bit-sliced adders instead: column
+// counts are updated incrementally per row and summed horizontally by doubling shifts, so the
+// per-word cost only grows with log2(ksize).
+static void imlib_erode_dilate_binary(image_t *img, int ksize, int t, int e_or_d, image_t *mask) {
+    int len = (ksize * 2) + 1;
+    int n = len * len;
+    int words = IMAGE_BINARY_LINE_LEN(img);
+    int p_words = (img->w + (ksize * 2) + UINT32_T_MASK) >> UINT32_T_SHIFT;
+    uint32_t last_mask = (img->w & UINT32_T_MASK) ? ((1U << (img->w & UINT32_T_MASK)) - 1) : 0xFFFFFFFF;
+    bool count = (1 < t) && (t < n);
+    int v_bits = 32 - __CLZ(len);
+    int h_bits = 32 - __CLZ(n);
+
     int brows = ksize + 1;
     image_t buf;
     buf.w = img->w;
     buf.h = brows;
     buf.pixfmt = img->pixfmt;
+    buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, 0);
+
+    // OR mode: tmp (words), padded row (p_words). Count mode: column counts (v_bits * words), padded
+    // column counts and window counts (h_bits * p_words each).
+    uint32_t *cond = uma_malloc(words * sizeof(uint32_t), 0);
+    uint32_t *cols = uma_calloc((count ? (v_bits * words) : words) * sizeof(uint32_t), 0);
+    uint32_t *sums = uma_malloc((count ? (h_bits * p_words * 2) : p_words) * sizeof(uint32_t), 0);
+
+    if (count) {
+        for (int j = -ksize; j < ksize; j++) {
+            int y_j = IM_CLAMP(j, 0, (img->h - 1));
+            binary_count_add_row(cols, v_bits, words, IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y_j), last_mask, false);
+        }
+    }
 
-    switch (img->pixfmt) {
-        case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, 0);
+    for (int y = 0; y < img->h; y++) {
+        imlib_poll_events();
+        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+        uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
 
-            for (int y = 0; y < img->h; y++) {
-                imlib_poll_events();
-                uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                uint32_t *buf_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows));
-                int acc = 0;
+        if (t <= 0) {
+            memset(cond, 0xFF, words * sizeof(uint32_t));
+        } else if (t > n) {
+            memset(cond, 0, words * sizeof(uint32_t));
+        } else if (!count) {
+            // Erode (t == n) is the complement of dilating the complement.
+            bool invert = t != 1;
+            uint32_t *padded = sums;
 
-                for (int x = 0; x < img->w; x++) {
-                    int pixel = IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x);
-                    IMAGE_PUT_BINARY_PIXEL_FAST(buf_row_ptr, x, pixel);
+            for (int i = 0; i < words; i++) {
+                uint32_t acc = 0;
 
-                    if (mask && (!image_get_mask_pixel(mask, x, y))) {
-                        continue; // Short circuit.
-                    }
+                for (int y_j = IM_MAX(y - ksize, 0), y_end = IM_MIN(y + ksize, img->h - 1); y_j <= y_end; y_j++) {
+                    uint32_t pixels = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y_j)[i];
+                    acc |= invert ? ~pixels : pixels;
+                }
 
-                    if (!mask && x > ksize && x < img->w - ksize && y >= ksize && y < img->h - ksize) {
-                        // faster
-                        for (int j = -ksize; j <= ksize; j++) {
-                            uint32_t *k_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y + j);
-                            // subtract old left column and add new right column
-                            acc -= IMAGE_GET_BINARY_PIXEL_FAST(k_row_ptr, x - ksize - 1);
-                            acc += IMAGE_GET_BINARY_PIXEL_FAST(k_row_ptr, x + ksize);
-                        }
-                    } else {
-                        // slower (checks boundaries per pixel)
-                        acc = e_or_d ? 0 : -1; // Don't count center pixel...
-                        for (int j = -ksize; j <= ksize; j++) {
-                            int y_j = IM_CLAMP(y + j, 0, (img->h - 1));
-                            uint32_t *k_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y_j);
+                cols[i] = acc & ((i == (words - 1)) ? last_mask : 0xFFFFFFFF);
+            }
 
-                            for (int k = -ksize; k <= ksize; k++) {
-                                int x_k = IM_CLAMP(x + k, 0, (img->w - 1));
-                                acc += IMAGE_GET_BINARY_PIXEL_FAST(k_row_ptr, x_k);
-                            }
-                        }
-                    }
+            for (int i = 0; i < p_words; i++) {
+                padded[i] = binary_row_word_shl(cols, words, i, ksize);
+            }
 
-                    if (!e_or_d) {
-                        // Preserve original pixel value... or clear it.
-                        if (acc < threshold) {
-                            IMAGE_CLEAR_BINARY_PIXEL_FAST(buf_row_ptr, x);
-                        }
-                    } else {
-                        // Preserve original pixel value... or set it.
-                        if (acc > threshold) {
-                            IMAGE_SET_BINARY_PIXEL_FAST(buf_row_ptr, x);
-                        }
-                    }
+            // OR in shifted copies of the row doubling the span each time and then cover the rest.
+            int span = 1;
+
+            for (; (span * 2) <= len; span *= 2) {
+                for (int i = 0; i < p_words; i++) {
+                    padded[i] |= binary_row_word_shr(padded, p_words, i, span);
                 }
+            }
 
-                if (y >= ksize) {
-                    // Transfer buffer lines...
-                    memcpy(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, (y - ksize)),
-                           IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, ((y - ksize) % brows)),
-                           IMAGE_BINARY_LINE_LEN_BYTES(img));
+            if (span < len) {
+                for (int i = 0; i < p_words; i++) {
+                    padded[i] |= binary_row_word_shr(padded, p_words, i, len - span);
                 }
             }
 
-            // Copy any remaining lines from the buffer image...
-            for (int y = IM_MAX(img->h - ksize, 0); y < img->h; y++) {
-                memcpy(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y),
-                       IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows)),
-                       IMAGE_BINARY_LINE_LEN_BYTES(img));
+            for (int i = 0; i < words; i++) {
+                cond[i] = invert ? ~padded[i] : padded[i];
             }
+        } else {
+            uint32_t *padded = sums;
+            uint32_t *window = sums + (h_bits * p_words);
 
-            uma_free(buf.data);
+            binary_count_add_row(cols, v_bits, words,
+                                 IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, IM_MIN(y + ksize, img->h - 1)), last_mask, false);
+
+            // Pad the column counts by replicating the edge columns.
+            for (int b = 0; b < v_bits; b++) {
+                uint32_t *src = cols + (b * words);
+                uint32_t *dst = padded + (b * p_words);
+
+                for (int i = 0; i < p_words; i++) {
+                    dst[i] = binary_row_word_shl(src, words, i, ksize);
+                }
+
+                binary_row_fill(dst, 0, ksize, IMAGE_GET_BINARY_PIXEL_FAST(src, 0));
+                binary_row_fill(dst, img->w + ksize, img->w + (ksize * 2), IMAGE_GET_BINARY_PIXEL_FAST(src, img->w - 1));
+            }
+
+            memset(padded + (v_bits * p_words), 0, (h_bits - v_bits) * p_words * sizeof(uint32_t));
+            memset(window, 0, h_bits * p_words * sizeof(uint32_t));
+
+            // Sum len columns by adding power of two spans for each bit set in len.
+            for (int span = 1, bits = v_bits, offset = 0;; span *= 2) {
+                if (len & span) {
+                    binary_count_add_shr(window, h_bits, padded, bits, p_words, offset);
+                    offset += span;
+                }
+
+                if ((span * 2) > len) {
+                    break;
+                }
+
+                int next_bits = IM_MIN(bits + 1, h_bits);
+                binary_count_add_shr(padded, next_bits, padded, bits, p_words, span);
+                bits = next_bits;
+            }
+
+            for (int i = 0; i < words; i++) {
+                cond[i] = binary_count_ge(window, h_bits, p_words, i, t);
+            }
+
+            binary_count_add_row(cols, v_bits, words,
+                                 IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, IM_MAX(y - ksize, 0)), last_mask, true);
+        }
+
+        uint32_t *mask_row_ptr = NULL;
+
+        if (mask && (mask->pixfmt == PIXFORMAT_BINARY) && (mask->w == img->w) && (y < mask->h)) {
+            mask_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(mask, y);
+        }
+
+        for (int i = 0; i < words; i++) {
+            uint32_t pixels = row_ptr[i];
+            uint32_t m = (i == (words - 1)) ? last_mask : 0xFFFFFFFF;
+
+            if (mask_row_ptr) {
+                m &= mask_row_ptr[i];
+            } else if (mask) {
+                uint32_t mask_bits = 0;
+
+                for (int b = 0, x = i * UINT32_T_BITS; (b < UINT32_T_BITS) && (x < img->w); b++, x++) {
+                    mask_bits |= ((uint32_t) image_get_mask_pixel(mask, x, y)) << b;
+                }
+
+                m &= mask_bits;
+            }
+
+            // Erode keeps set pixels that pass, dilate sets pixels that pass.
+            uint32_t result = e_or_d ? (pixels | cond[i]) : (pixels & cond[i]);
+            buf_row_ptr[i] = (result & m) | (pixels & ~m);
+        }
+
+        if (y >= ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, (y - ksize)),
+                   IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, ((y - ksize) % brows)),
+                   IMAGE_BINARY_LINE_LEN_BYTES(img));
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(img->h - ksize, 0); y < img->h; y++) {
+        memcpy(IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y),
+               IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&buf, (y % brows)),
+               IMAGE_BINARY_LINE_LEN_BYTES(img));
+    }
+
+    uma_free(sums);
+    uma_free(cols);
+    uma_free(cond);
+    uma_free(buf.data);
+}
+
+static void imlib_erode_dilate(image_t *img, int ksize, int threshold, int e_or_d, image_t *mask) {
+    int brows = ksize + 1;
+    image_t buf;
+    buf.w = img->w;
+    buf.h = brows;
+    buf.pixfmt = img->pixfmt;
+
+    switch (img->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            // Erode keeps pixels with (count - 1) >= threshold, dilate sets pixels with count > threshold.
+            imlib_erode_dilate_binary(img, ksize, threshold + 1, e_or_d, mask);
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
@@ -23,15 +23,75 @@
  *
  * Blob detection code.
  */
+#include <float.h>
 #include "imlib.h"
 
 typedef struct xylr {
     int16_t x, y, l, r, t_l, b_l;
 } xylr_t;
 
-static float sign(float x) {
-    return x / fabsf(x);
-}
+#define BLOB_CODE_NONE     0xFF
+#define BLOB_LABEL_FREE    -1
+#define BLOB_SEED_NONE     UINT64_MAX
+
+// A horizontal run of pixels matching the same threshold.
+typedef struct blob_run {
+    int16_t l, r;
+    uint8_t code;
+    int32_t label, root;
+} blob_run_t;
+
+// Runs of a label kept for building the x/y histograms.
+typedef struct blob_hist_node {
+    int16_t l, r, y;
+    int32_t next;
+} blob_hist_node_t;
+
+typedef struct blob_label {
+    int32_t parent; // union-find parent (or next free label)
+    int32_t stamp; // last row the label was seen on
+    int32_t hist_head, hist_tail;
+    uint64_t key; // threshold code, then first seed pixel in raster order
+    uint8_t code;
+    int pixels, perimeter, cx, cy;
+    long long a, b, c;
+    float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
+    point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
+    int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
+} blob_label_t;
+
+struct blob_labeler {
+    blob_label_t *labels;
+    int32_t labels_len, labels_free;
+    blob_hist_node_t *nodes;
+    int32_t nodes_len, nodes_used, nodes_free;
+    uint64_t *keys;
+    size_t keys_len;
+    // Row state
+    rectangle_t roi;
+    unsigned int x_stride, y_stride;
+    bool invert;
+    pixformat_t pixfmt;
+    uint8_t lut[256];
+    uint32_t *lab_masks;
+    uint32_t thresholds_mask;
+    uint8_t *codes_buf, *codes, *prev_codes;
+    blob_run_t *runs_buf, *runs, *prev_runs;
+    int prev_runs_n;
+    // Blob output
+    int w, h;
+    list_t *out;
+    unsigned int area_threshold, pixels_threshold;
+    bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *);
+    void *threshold_cb_arg;
+    uint16_t *x_hist_bins, *y_hist_bins;
+    unsigned int x_hist_bins_max, y_hist_bins_max;
+};
+
+typedef struct blob_sort {
+    uint64_t key;
+    list_lnk_t *lnk;
+} blob_sort_t;
 
 static int sum_m_to_n(int m, int n) {
     return ((n * (n + 1)) - (m * (m - 1))) / 2;
@@ -136,958 +196,599 @@ static float calc_roundness(float blob_a, float blob_b, float blob_c) {
     return IM_DIV(roundness_min, roundness_max);
 }
 
-void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
-                      list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
-                      bool merge, int margin, bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *),
-                      void *threshold_cb_arg,
-                      bool (*merge_cb) (void *, find_blobs_list_lnk_data_t *, find_blobs_list_lnk_data_t *),
-                      void *merge_cb_arg, unsigned int x_hist_bins_max, unsigned int y_hist_bins_max) {
-    // Same size as the image so we don't have to translate.
-    image_t bmp;
-    bmp.w = ptr->w;
-    bmp.h = ptr->h;
-    bmp.pixfmt = PIXFORMAT_BINARY;
-    bmp.data = uma_calloc(image_size(&bmp), 0);
-
-    uint16_t *x_hist_bins = NULL;
-    if (x_hist_bins_max) {
-        x_hist_bins = uma_malloc(ptr->w * sizeof(uint16_t), 0);
-    }
+static int32_t blob_label_new(blob_labeler_t *ctx, uint8_t code, int y) {
+    if (ctx->labels_free < 0) {
+        int32_t len = ctx->labels_len;
+        ctx->labels_len = len ? (len * 2) : 64;
+        ctx->labels = uma_realloc(ctx->labels, ctx->labels_len * sizeof(blob_label_t), 0);
 
-    uint16_t *y_hist_bins = NULL;
-    if (y_hist_bins_max) {
-        y_hist_bins = uma_malloc(ptr->h * sizeof(uint16_t), 0);
+        for (int32_t i = ctx->labels_len - 1; i >= len; i--) {
+            ctx->labels[i].parent = ctx->labels_free;
+            ctx->labels[i].stamp = BLOB_LABEL_FREE;
+            ctx->labels_free = i;
+        }
     }
 
-    lifo_t lifo;
-    size_t lifo_len;
-    lifo_alloc_all(&lifo, &lifo_len, sizeof(xylr_t));
+    int32_t i = ctx->labels_free;
+    blob_label_t *label = &ctx->labels[i];
+    ctx->labels_free = label->parent;
+
+    label->parent = i;
+    label->stamp = y;
+    label->hist_head = -1;
+    label->hist_tail = -1;
+    label->key = BLOB_SEED_NONE;
+    label->code = code;
+    label->pixels = 0;
+    label->perimeter = 0;
+    label->cx = 0;
+    label->cy = 0;
+    label->a = 0;
+    label->b = 0;
+    label->c = 0;
+
+    // The first run always replaces these.
+    for (int j = 0; j < FIND_BLOBS_CORNERS_RESOLUTION; j++) {
+        label->corners_acc[j] = FLT_MAX;
+        label->corners_n[j] = 0;
+    }
 
-    list_init(out, sizeof(find_blobs_list_lnk_data_t));
+    return i;
+}
 
-    size_t code = 0;
-    list_for_each(it, thresholds) {
-        color_thresholds_list_lnk_data_t *lnk_data = list_get_data(it);
-
-        switch (ptr->pixfmt) {
-            case PIXFORMAT_BINARY: {
-                for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
-                    imlib_poll_events();
-                    uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
-                    uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
-                    for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
-                        if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
-                            && COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x), lnk_data, invert)) {
-                            int old_x = x;
-                            int old_y = y;
-
-                            float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
-                            point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
-                            int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
-                            // These values are initialized to their maximum before we minimize.
-                            for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                corners[i].x =
-                                    IM_CLAMP(x_max * sign(cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, x_max);
-                                corners[i].y =
-                                    IM_CLAMP(y_max * sign(sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, y_max);
-                                corners_acc[i] = (corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                                 (corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                corners_n[i] = 1;
-                            }
+static void blob_label_free(blob_labeler_t *ctx, int32_t i) {
+    blob_label_t *label = &ctx->labels[i];
 
-                            int blob_pixels = 0;
-                            int blob_perimeter = 0;
-                            int blob_cx = 0;
-                            int blob_cy = 0;
-                            long long blob_a = 0;
-                            long long blob_b = 0;
-                            long long blob_c = 0;
+    if (label->hist_head >= 0) {
+        ctx->nodes[label->hist_tail].next = ctx->nodes_free;
+        ctx->nodes_free = label->hist_head;
+    }
 
-                            if (x_hist_bins) {
-                                memset(x_hist_bins, 0, ptr->w * sizeof(uint16_t));
-                            }
-                            if (y_hist_bins) {
-                                memset(y_hist_bins, 0, ptr->h * sizeof(uint16_t));
-                            }
+    label->parent = ctx->labels_free;
+    label->stamp = BLOB_LABEL_FREE;
+    ctx->labels_free = i;
+}
 
-                            // Scanline Flood Fill Algorithm //
+static int32_t blob_label_find(blob_label_t *labels, int32_t i) {
+    while (labels[i].parent != i) {
+        labels[i].parent = labels[labels[i].parent].parent;
+        i = labels[i].parent;
+    }
 
-                            for (;;) {
-                                int left = x, right = x;
-                                uint32_t *row     = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y);
-                                uint32_t *bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
+    return i;
+}
 
-                                while ((left > roi->x)
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, left - 1))
-                                       && COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, left - 1), lnk_data,
-                                                                 invert)) {
-                                    left--;
-                                }
+static void blob_label_add_run(blob_labeler_t *ctx, int32_t i, int left, int right, int y) {
+    blob_label_t *label = &ctx->labels[i];
+
+    int sum = sum_m_to_n(left, right);
+    int sum_2 = sum_2_m_to_n(left, right);
+    int cnt = right - left + 1;
+    int avg = sum / cnt;
+
+    for (int j = 0; j < FIND_BLOBS_CORNERS_RESOLUTION; j++) {
+        int x_new = (cos_table[FIND_BLOBS_ANGLE_RESOLUTION * j] > 0) ? left :
+                    ((cos_table[FIND_BLOBS_ANGLE_RESOLUTION * j] == 0) ? avg : right);
+        float z = (x_new * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * j]) +
+                  (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * j]);
+        if (z < label->corners_acc[j]) {
+            label->corners_acc[j] = z;
+            label->corners[j].x = x_new;
+            label->corners[j].y = y;
+            label->corners_n[j] = 1;
+        } else if (z == label->corners_acc[j]) {
+            label->corners[j].x = cumulative_moving_average(label->corners[j].x, x_new, label->corners_n[j]);
+            label->corners[j].y = cumulative_moving_average(label->corners[j].y, y, label->corners_n[j]);
+            label->corners_n[j] += 1;
+        }
+    }
 
-                                while ((right < (roi->x + roi->w - 1))
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, right + 1))
-                                       && COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, right + 1), lnk_data,
-                                                                 invert)) {
-                                    right++;
-                                }
+    label->pixels += cnt;
+    label->perimeter += 2;
+    label->cx += sum;
+    label->cy += y * cnt;
+    label->a += sum_2;
+    label->b += y * sum;
+    label->c += y * y * cnt;
+
+    if (ctx->x_hist_bins || ctx->y_hist_bins) {
+        if (ctx->nodes_free < 0) {
+            if (ctx->nodes_used == ctx->nodes_len) {
+                ctx->nodes_len = ctx->nodes_len ? (ctx->nodes_len * 2) : 256;
+                ctx->nodes = uma_realloc(ctx->nodes, ctx->nodes_len * sizeof(blob_hist_node_t), 0);
+            }
+            ctx->nodes_free = ctx->nodes_used++;
+            ctx->nodes[ctx->nodes_free].next = -1;
+        }
 
-                                for (int i = left; i <= right; i++) {
-                                    IMAGE_SET_BINARY_PIXEL_FAST(bmp_row, i);
-                                }
+        int32_t n = ctx->nodes_free;
+        blob_hist_node_t *node = &ctx->nodes[n];
+        ctx->nodes_free = node->next;
 
-                                int sum = sum_m_to_n(left, right);
-                                int sum_2 = sum_2_m_to_n(left, right);
-                                int cnt = right - left + 1;
-                                int avg = sum / cnt;
-
-                                for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                    int x_new = (cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] > 0) ? left :
-                                                ((cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] == 0) ? avg :
-                                                 right);
-                                    float z = (x_new * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                              (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                    if (z < corners_acc[i]) {
-                                        corners_acc[i] = z;
-                                        corners[i].x = x_new;
-                                        corners[i].y = y;
-                                        corners_n[i] = 1;
-                                    } else if (z == corners_acc[i]) {
-                                        corners[i].x = cumulative_moving_average(corners[i].x, x_new, corners_n[i]);
-                                        corners[i].y = cumulative_moving_average(corners[i].y, y, corners_n[i]);
-                                        corners_n[i] += 1;
-                                    }
-                                }
+        node->l = left;
+        node->r = right;
+        node->y = y;
+        node->next = -1;
 
-                                blob_pixels += cnt;
-                                blob_perimeter += 2;
-                                blob_cx += sum;
-                                blob_cy += y * cnt;
-                                blob_a += sum_2;
-                                blob_b += y * sum;
-                                blob_c += y * y * cnt;
+        if (label->hist_head < 0) {
+            label->hist_head = n;
+        } else {
+            ctx->nodes[label->hist_tail].next = n;
+        }
 
-                                if (y_hist_bins) {
-                                    y_hist_bins[y] += cnt;
-                                }
-                                if (x_hist_bins) {
-                                    for (int i = left; i <= right; i++) {
-                                        x_hist_bins[i] += 1;
-                                    }
-                                }
+        label->hist_tail = n;
+    }
+}
 
-                                int top_left = left;
-                                int bot_left = left;
-                                bool break_out = false;
-                                for (;;) {
-                                    if (lifo_size(&lifo) < lifo_len) {
-
-                                        if (y > roi->y) {
-                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y - 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y - 1);
-
-                                            bool recurse = false;
-                                            for (int i = top_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i),
-                                                                                   lnk_data,
-                                                                                   invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                                    context.b_l = bot_left;
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y - 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-
-                                        if (y < (roi->y + roi->h - 1)) {
-                                            row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(ptr, y + 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y + 1);
-
-                                            bool recurse = false;
-                                            for (int i = bot_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST(row, i),
-                                                                                   lnk_data,
-                                                                                   invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = top_left;
-                                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y + 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-                                    } else {
-                                        blob_perimeter += (right - left + 1) * 2;
-                                    }
-
-                                    if (!lifo_size(&lifo)) {
-                                        break_out = true;
-                                        break;
-                                    }
+// Merges label src into label dst, both must be roots.
+static void blob_label_merge(blob_labeler_t *ctx, int32_t dst, int32_t src) {
+    blob_label_t *d = &ctx->labels[dst];
+    blob_label_t *s = &ctx->labels[src];
+
+    for (int j = 0; j < FIND_BLOBS_CORNERS_RESOLUTION; j++) {
+        if (s->corners_acc[j] < d->corners_acc[j]) {
+            d->corners_acc[j] = s->corners_acc[j];
+            d->corners[j] = s->corners[j];
+            d->corners_n[j] = s->corners_n[j];
+        } else if (s->corners_acc[j] == d->corners_acc[j]) {
+            int n = d->corners_n[j] + s->corners_n[j];
+            d->corners[j].x = ((d->corners[j].x * d->corners_n[j]) + (s->corners[j].x * s->corners_n[j])) / n;
+            d->corners[j].y = ((d->corners[j].y * d->corners_n[j]) + (s->corners[j].y * s->corners_n[j])) / n;
+            d->corners_n[j] = n;
+        }
+    }
 
-                                    xylr_t context;
-                                    lifo_dequeue(&lifo, &context);
-                                    x = context.x;
-                                    y = context.y;
-                                    left = context.l;
-                                    right = context.r;
-                                    top_left = context.t_l;
-                                    bot_left = context.b_l;
-                                }
+    d->key = IM_MIN(d->key, s->key);
+    d->pixels += s->pixels;
+    d->perimeter += s->perimeter;
+    d->cx += s->cx;
+    d->cy += s->cy;
+    d->a += s->a;
+    d->b += s->b;
+    d->c += s->c;
+
+    if (s->hist_head >= 0) {
+        if (d->hist_head < 0) {
+            d->hist_head = s->hist_head;
+        } else {
+            ctx->nodes[d->hist_tail].next = s->hist_head;
+        }
+        d->hist_tail = s->hist_tail;
+        s->hist_head = -1;
+        s->hist_tail = -1;
+    }
 
-                                if (break_out) {
-                                    break;
-                                }
-                            }
+    s->parent = dst;
+}
 
-                            rectangle_t rect;
-                            rect.x = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x; // l
-                            rect.y = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y; // t
-                            rect.w = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4].x -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x + 1;                                              // r - l + 1
-                            rect.h = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4].y -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y + 1;                                              // b - t + 1
-
-                            if (((rect.w * rect.h) >= area_threshold) && (blob_pixels >= pixels_threshold)) {
-
-                                // http://www.cse.usf.edu/~r1k/MachineVisionBook/MachineVision.files/MachineVision_Chapter2.pdf
-                                // https://www.strchr.com/standard_deviation_in_one_pass
-                                //
-                                // a = sigma(x*x) + (mx*sigma(x)) + (mx*sigma(x)) + (sigma()*mx*mx)
-                                // b = sigma(x*y) + (mx*sigma(y)) + (my*sigma(x)) + (sigma()*mx*my)
-                                // c = sigma(y*y) + (my*sigma(y)) + (my*sigma(y)) + (sigma()*my*my)
-                                //
-                                // blob_a = sigma(x*x)
-                                // blob_b = sigma(x*y)
-                                // blob_c = sigma(y*y)
-                                // blob_cx = sigma(x)
-                                // blob_cy = sigma(y)
-                                // blob_pixels = sigma()
-
-                                float b_mx = blob_cx / ((float) blob_pixels);
-                                float b_my = blob_cy / ((float) blob_pixels);
-                                int mx = fast_roundf(b_mx); // x centroid
-                                int my = fast_roundf(b_my); // y centroid
-                                int small_blob_a = blob_a - ((mx * blob_cx) + (mx * blob_cx)) + (blob_pixels * mx * mx);
-                                int small_blob_b = blob_b - ((mx * blob_cy) + (my * blob_cx)) + (blob_pixels * mx * my);
-                                int small_blob_c = blob_c - ((my * blob_cy) + (my * blob_cy)) + (blob_pixels * my * my);
-
-                                find_blobs_list_lnk_data_t lnk_blob;
-                                memcpy(lnk_blob.corners, corners, FIND_BLOBS_CORNERS_RESOLUTION * sizeof(point_t));
-                                memcpy(&lnk_blob.rect, &rect, sizeof(rectangle_t));
-                                lnk_blob.pixels = blob_pixels;
-                                lnk_blob.perimeter = blob_perimeter;
-                                lnk_blob.code = 1 << code;
-                                lnk_blob.count = 1;
-                                lnk_blob.centroid_x = b_mx;
-                                lnk_blob.centroid_y = b_my;
-                                lnk_blob.rotation =
-                                    (small_blob_a !=
-                                     small_blob_c) ? (fast_atan2f(2 * small_blob_b, small_blob_a - small_blob_c) / 2.0f) : 0.0f;
-                                lnk_blob.roundness = calc_roundness(small_blob_a, small_blob_b, small_blob_c);
-                                lnk_blob.x_hist_bins_count = 0;
-                                lnk_blob.x_hist_bins = NULL;
-                                lnk_blob.y_hist_bins_count = 0;
-                                lnk_blob.y_hist_bins = NULL;
-                                // These store the current average accumulation.
-                                lnk_blob.centroid_x_acc = lnk_blob.centroid_x * lnk_blob.pixels;
-                                lnk_blob.centroid_y_acc = lnk_blob.centroid_y * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_x = cosf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_y = sinf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.roundness_acc = lnk_blob.roundness * lnk_blob.pixels;
-
-                                if (x_hist_bins) {
-                                    bin_up(x_hist_bins,
-                                           ptr->w,
-                                           x_hist_bins_max,
-                                           &lnk_blob.x_hist_bins,
-                                           &lnk_blob.x_hist_bins_count);
-                                }
+// Turns a finished label into a blob and appends it to the output list.
+static void blob_label_emit(blob_labeler_t *ctx, int32_t i) {
+    blob_label_t *label = &ctx->labels[i];
 
-                                if (y_hist_bins) {
-                                    bin_up(y_hist_bins,
-                                           ptr->h,
-                                           y_hist_bins_max,
-                                           &lnk_blob.y_hist_bins,
-                                           &lnk_blob.y_hist_bins_count);
-                                }
+    // Only labels touching a pixel on the x/y stride grid are blobs.
+    if (label->key == BLOB_SEED_NONE) {
+        return;
+    }
 
-                                bool add_to_list = threshold_cb_arg == NULL;
-                                if (!add_to_list) {
-                                    add_to_list = threshold_cb(threshold_cb_arg, &lnk_blob);
-                                }
+    point_t *corners = label->corners;
+    int blob_pixels = label->pixels;
+    int blob_cx = label->cx;
+    int blob_cy = label->cy;
+
+    rectangle_t rect;
+    rect.x = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x; // l
+    rect.y = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y; // t
+    rect.w = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4].x -
+             corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x + 1; // r - l + 1
+    rect.h = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4].y -
+             corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y + 1; // b - t + 1
+
+    if (((rect.w * rect.h) < ctx->area_threshold) || (blob_pixels < ctx->pixels_threshold)) {
+        return;
+    }
 
-                                if (add_to_list) {
-                                    list_push_back(out, &lnk_blob);
-                                } else {
-                                    if (lnk_blob.x_hist_bins) {
-                                        m_free(lnk_blob.x_hist_bins);
-                                    }
-                                    if (lnk_blob.y_hist_bins) {
-                                        m_free(lnk_blob.y_hist_bins);
-                                    }
-                                }
-                            }
+    // http://www.cse.usf.edu/~r1k/MachineVisionBook/MachineVision.files/MachineVision_Chapter2.pdf
+    // https://www.strchr.com/standard_deviation_in_one_pass
+    //
+    // a = sigma(x*x) + (mx*sigma(x)) + (mx*sigma(x)) + (sigma()*mx*mx)
+    // b = sigma(x*y) + (mx*sigma(y)) + (my*sigma(x)) + (sigma()*mx*my)
+    // c = sigma(y*y) + (my*sigma(y)) + (my*sigma(y)) + (sigma()*my*my)
+    //
+    // blob_a = sigma(x*x)
+    // blob_b = sigma(x*y)
+    // blob_c = sigma(y*y)
+    // blob_cx = sigma(x)
+    // blob_cy = sigma(y)
+    // blob_pixels = sigma()
+
+    float b_mx = blob_cx / ((float) blob_pixels);
+    float b_my = blob_cy / ((float) blob_pixels);
+    int mx = fast_roundf(b_mx); // x centroid
+    int my = fast_roundf(b_my); // y centroid
+    int small_blob_a = label->a - ((mx * blob_cx) + (mx * blob_cx)) + (blob_pixels * mx * mx);
+    int small_blob_b = label->b - ((mx * blob_cy) + (my * blob_cx)) + (blob_pixels * mx * my);
+    int small_blob_c = label->c - ((my * blob_cy) + (my * blob_cy)) + (blob_pixels * my * my);
+
+    find_blobs_list_lnk_data_t lnk_blob;
+    memcpy(lnk_blob.corners, corners, FIND_BLOBS_CORNERS_RESOLUTION * sizeof(point_t));
+    memcpy(&lnk_blob.rect, &rect, sizeof(rectangle_t));
+    lnk_blob.pixels = blob_pixels;
+    lnk_blob.perimeter = label->perimeter;
+    lnk_blob.code = 1U << label->code;
+    lnk_blob.count = 1;
+    lnk_blob.centroid_x = b_mx;
+    lnk_blob.centroid_y = b_my;
+    lnk_blob.rotation =
+        (small_blob_a != small_blob_c) ? (fast_atan2f(2 * small_blob_b, small_blob_a - small_blob_c) / 2.0f) : 0.0f;
+    lnk_blob.roundness = calc_roundness(small_blob_a, small_blob_b, small_blob_c);
+    lnk_blob.x_hist_bins_count = 0;
+    lnk_blob.x_hist_bins = NULL;
+    lnk_blob.y_hist_bins_count = 0;
+    lnk_blob.y_hist_bins = NULL;
+    // These store the current average accumulation.
+    lnk_blob.centroid_x_acc = lnk_blob.centroid_x * lnk_blob.pixels;
+    lnk_blob.centroid_y_acc = lnk_blob.centroid_y * lnk_blob.pixels;
+    lnk_blob.rotation_acc_x = cosf(lnk_blob.rotation) * lnk_blob.pixels;
+    lnk_blob.rotation_acc_y = sinf(lnk_blob.rotation) * lnk_blob.pixels;
+    lnk_blob.roundness_acc = lnk_blob.roundness * lnk_blob.pixels;
+
+    if (ctx->x_hist_bins) {
+        memset(ctx->x_hist_bins, 0, ctx->w * sizeof(uint16_t));
+    }
 
-                            x = old_x;
-                            y = old_y;
-                        }
-                    }
-                }
-                break;
-            }
-            case PIXFORMAT_GRAYSCALE: {
-                for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
-                    imlib_poll_events();
-                    uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
-                    uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
-                    for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
-                        if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
-                            && COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x), lnk_data, invert)) {
-                            int old_x = x;
-                            int old_y = y;
-
-                            float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
-                            point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
-                            int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
-                            // These values are initialized to their maximum before we minimize.
-                            for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                corners[i].x =
-                                    IM_CLAMP(x_max * sign(cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, x_max);
-                                corners[i].y =
-                                    IM_CLAMP(y_max * sign(sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, y_max);
-                                corners_acc[i] = (corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                                 (corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                corners_n[i] = 1;
-                            }
+    if (ctx->y_hist_bins) {
+        memset(ctx->y_hist_bins, 0, ctx->h * sizeof(uint16_t));
+    }
 
-                            int blob_pixels = 0;
-                            int blob_perimeter = 0;
-                            int blob_cx = 0;
-                            int blob_cy = 0;
-                            long long blob_a = 0;
-                            long long blob_b = 0;
-                            long long blob_c = 0;
+    for (int32_t n = label->hist_head; n >= 0; n = ctx->nodes[n].next) {
+        blob_hist_node_t *node = &ctx->nodes[n];
 
-                            if (x_hist_bins) {
-                                memset(x_hist_bins, 0, ptr->w * sizeof(uint16_t));
-                            }
-                            if (y_hist_bins) {
-                                memset(y_hist_bins, 0, ptr->h * sizeof(uint16_t));
-                            }
+        if (ctx->y_hist_bins) {
+            ctx->y_hist_bins[node->y] += node->r - node->l + 1;
+        }
 
-                            // Scanline Flood Fill Algorithm //
+        if (ctx->x_hist_bins) {
+            for (int x = node->l; x <= node->r; x++) {
+                ctx->x_hist_bins[x] += 1;
+            }
+        }
+    }
 
-                            for (;;) {
-                                int left = x, right = x;
-                                uint8_t *row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y);
-                                uint32_t *bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
+    if (ctx->x_hist_bins) {
+        bin_up(ctx->x_hist_bins, ctx->w, ctx->x_hist_bins_max, &lnk_blob.x_hist_bins, &lnk_blob.x_hist_bins_count);
+    }
 
-                                while ((left > roi->x)
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, left - 1))
-                                       && COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, left - 1), lnk_data,
-                                                                    invert)) {
-                                    left--;
-                                }
+    if (ctx->y_hist_bins) {
+        bin_up(ctx->y_hist_bins, ctx->h, ctx->y_hist_bins_max, &lnk_blob.y_hist_bins, &lnk_blob.y_hist_bins_count);
+    }
 
-                                while ((right < (roi->x + roi->w - 1))
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, right + 1))
-                                       && COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, right + 1), lnk_data,
-                                                                    invert)) {
-                                    right++;
-                                }
+    bool add_to_list = ctx->threshold_cb_arg == NULL;
+    if (!add_to_list) {
+        add_to_list = ctx->threshold_cb(ctx->threshold_cb_arg, &lnk_blob);
+    }
 
-                                for (int i = left; i <= right; i++) {
-                                    IMAGE_SET_BINARY_PIXEL_FAST(bmp_row, i);
-                                }
+    if (add_to_list) {
+        size_t n = list_size(ctx->out);
+        if (n == ctx->keys_len) {
+            ctx->keys_len = ctx->keys_len ? (ctx->keys_len * 2) : 16;
+            ctx->keys = uma_realloc(ctx->keys, ctx->keys_len * sizeof(uint64_t), 0);
+        }
+        ctx->keys[n] = label->key;
+        list_push_back(ctx->out, &lnk_blob);
+    } else {
+        if (lnk_blob.x_hist_bins) {
+            m_free(lnk_blob.x_hist_bins);
+        }
+        if (lnk_blob.y_hist_bins) {
+            m_free(lnk_blob.y_hist_bins);
+        }
+    }
+}
 
-                                int sum = sum_m_to_n(left, right);
-                                int sum_2 = sum_2_m_to_n(left, right);
-                                int cnt = right - left + 1;
-                                int avg = sum / cnt;
-
-                                for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                    int x_new = (cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] > 0) ? left :
-                                                ((cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] == 0) ? avg :
-                                                 right);
-                                    float z = (x_new * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                              (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                    if (z < corners_acc[i]) {
-                                        corners_acc[i] = z;
-                                        corners[i].x = x_new;
-                                        corners[i].y = y;
-                                        corners_n[i] = 1;
-                                    } else if (z == corners_acc[i]) {
-                                        corners[i].x = cumulative_moving_average(corners[i].x, x_new, corners_n[i]);
-                                        corners[i].y = cumulative_moving_average(corners[i].y, y, corners_n[i]);
-                                        corners_n[i] += 1;
-                                    }
-                                }
+// Counts pixels in codes[l, r] that do not pass the threshold with the given code. Pixels
+// claimed by an earlier threshold are not counted.
+static int blob_count_border(const uint8_t *codes, int l, int r, uint8_t code) {
+    int count = 0;
 
-                                blob_pixels += cnt;
-                                blob_perimeter += 2;
-                                blob_cx += sum;
-                                blob_cy += y * cnt;
-                                blob_a += sum_2;
-                                blob_b += y * sum;
-                                blob_c += y * y * cnt;
+    for (int i = l; i <= r; i++) {
+        count += codes[i] > code;
+    }
 
-                                if (y_hist_bins) {
-                                    y_hist_bins[y] += cnt;
-                                }
-                                if (x_hist_bins) {
-                                    for (int i = left; i <= right; i++) {
-                                        x_hist_bins[i] += 1;
-                                    }
-                                }
+    return count;
+}
 
-                                int top_left = left;
-                                int bot_left = left;
-                                bool break_out = false;
-                                for (;;) {
-                                    if (lifo_size(&lifo) < lifo_len) {
-
-                                        if (y > roi->y) {
-                                            row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y - 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y - 1);
-
-                                            bool recurse = false;
-                                            for (int i = top_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i),
-                                                                                      lnk_data,
-                                                                                      invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                                    context.b_l = bot_left;
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y - 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-
-                                        if (y < (roi->y + roi->h - 1)) {
-                                            row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(ptr, y + 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y + 1);
-
-                                            bool recurse = false;
-                                            for (int i = bot_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST(row, i),
-                                                                                      lnk_data,
-                                                                                      invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = top_left;
-                                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y + 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-                                    } else {
-                                        blob_perimeter += (right - left + 1) * 2;
-                                    }
-
-                                    if (!lifo_size(&lifo)) {
-                                        break_out = true;
-                                        break;
-                                    }
+static int blob_sort_compare(const void *a, const void *b) {
+    uint64_t key_a = ((const blob_sort_t *) a)->key;
+    uint64_t key_b = ((const blob_sort_t *) b)->key;
+    return (key_a > key_b) - (key_a < key_b);
+}
 
-                                    xylr_t context;
-                                    lifo_dequeue(&lifo, &context);
-                                    x = context.x;
-                                    y = context.y;
-                                    left = context.l;
-                                    right = context.r;
-                                    top_left = context.t_l;
-                                    bot_left = context.b_l;
-                                }
+blob_labeler_t *imlib_find_blobs_start(list_t *out, image_t *ptr, rectangle_t *roi,
+                                       unsigned int x_stride, unsigned int y_stride,
+                                       list_t *thresholds, bool invert,
+                                       unsigned int area_threshold, unsigned int pixels_threshold,
+                                       bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *),
+                                       void *threshold_cb_arg,
+                                       unsigned int x_hist_bins_max, unsigned int y_hist_bins_max) {
+    // Each row is thresholded once into runs tagged with the index of the first matching
+    // threshold. Runs that overlap a run with the same code on the previous row are joined
+    // with union-find, and the blob statistics are accumulated per label. A label is output
+    // once no run on the current row is connected to it.
+    //
+    // Thresholds may overlap, but a pixel matching several thresholds is only part of the
+    // blobs of the first one.
+    if (list_size(thresholds) > FIND_BLOBS_MAX_THRESHOLDS) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("At most 32 thresholds are supported"));
+    }
 
-                                if (break_out) {
-                                    break;
-                                }
-                            }
+    blob_labeler_t *ctx = uma_calloc(sizeof(blob_labeler_t), 0);
+    ctx->labels_free = -1;
+    ctx->nodes_free = -1;
+    ctx->roi = *roi;
+    ctx->x_stride = x_stride;
+    ctx->y_stride = y_stride;
+    ctx->invert = invert;
+    ctx->pixfmt = ptr->pixfmt;
+    ctx->w = ptr->w;
+    ctx->h = ptr->h;
+    ctx->out = out;
+    ctx->area_threshold = area_threshold;
+    ctx->pixels_threshold = pixels_threshold;
+    ctx->threshold_cb = threshold_cb;
+    ctx->threshold_cb_arg = threshold_cb_arg;
+    ctx->x_hist_bins_max = x_hist_bins_max;
+    ctx->y_hist_bins_max = y_hist_bins_max;
 
-                            rectangle_t rect;
-                            rect.x = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x; // l
-                            rect.y = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y; // t
-                            rect.w = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4].x -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x + 1;                                              // r - l + 1
-                            rect.h = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4].y -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y + 1;                                              // b - t + 1
-
-                            if (((rect.w * rect.h) >= area_threshold) && (blob_pixels >= pixels_threshold)) {
-
-                                // http://www.cse.usf.edu/~r1k/MachineVisionBook/MachineVision.files/MachineVision_Chapter2.pdf
-                                // https://www.strchr.com/standard_deviation_in_one_pass
-                                //
-                                // a = sigma(x*x) + (mx*sigma(x)) + (mx*sigma(x)) + (sigma()*mx*mx)
-                                // b = sigma(x*y) + (mx*sigma(y)) + (my*sigma(x)) + (sigma()*mx*my)
-                                // c = sigma(y*y) + (my*sigma(y)) + (my*sigma(y)) + (sigma()*my*my)
-                                //
-                                // blob_a = sigma(x*x)
-                                // blob_b = sigma(x*y)
-                                // blob_c = sigma(y*y)
-                                // blob_cx = sigma(x)
-                                // blob_cy = sigma(y)
-                                // blob_pixels = sigma()
-
-                                float b_mx = blob_cx / ((float) blob_pixels);
-                                float b_my = blob_cy / ((float) blob_pixels);
-                                int mx = fast_roundf(b_mx); // x centroid
-                                int my = fast_roundf(b_my); // y centroid
-                                int small_blob_a = blob_a - ((mx * blob_cx) + (mx * blob_cx)) + (blob_pixels * mx * mx);
-                                int small_blob_b = blob_b - ((mx * blob_cy) + (my * blob_cx)) + (blob_pixels * mx * my);
-                                int small_blob_c = blob_c - ((my * blob_cy) + (my * blob_cy)) + (blob_pixels * my * my);
-
-                                find_blobs_list_lnk_data_t lnk_blob;
-                                memcpy(lnk_blob.corners, corners, FIND_BLOBS_CORNERS_RESOLUTION * sizeof(point_t));
-                                memcpy(&lnk_blob.rect, &rect, sizeof(rectangle_t));
-                                lnk_blob.pixels = blob_pixels;
-                                lnk_blob.perimeter = blob_perimeter;
-                                lnk_blob.code = 1 << code;
-                                lnk_blob.count = 1;
-                                lnk_blob.centroid_x = b_mx;
-                                lnk_blob.centroid_y = b_my;
-                                lnk_blob.rotation =
-                                    (small_blob_a !=
-                                     small_blob_c) ? (fast_atan2f(2 * small_blob_b, small_blob_a - small_blob_c) / 2.0f) : 0.0f;
-                                lnk_blob.roundness = calc_roundness(small_blob_a, small_blob_b, small_blob_c);
-                                lnk_blob.x_hist_bins_count = 0;
-                                lnk_blob.x_hist_bins = NULL;
-                                lnk_blob.y_hist_bins_count = 0;
-                                lnk_blob.y_hist_bins = NULL;
-                                // These store the current average accumulation.
-                                lnk_blob.centroid_x_acc = lnk_blob.centroid_x * lnk_blob.pixels;
-                                lnk_blob.centroid_y_acc = lnk_blob.centroid_y * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_x = cosf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_y = sinf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.roundness_acc = lnk_blob.roundness * lnk_blob.pixels;
-
-                                if (x_hist_bins) {
-                                    bin_up(x_hist_bins,
-                                           ptr->w,
-                                           x_hist_bins_max,
-                                           &lnk_blob.x_hist_bins,
-                                           &lnk_blob.x_hist_bins_count);
-                                }
+    if (x_hist_bins_max) {
+        ctx->x_hist_bins = uma_malloc(ptr->w * sizeof(uint16_t), UMA_SCRATCH);
+    }
 
-                                if (y_hist_bins) {
-                                    bin_up(y_hist_bins,
-                                           ptr->h,
-                                           y_hist_bins_max,
-                                           &lnk_blob.y_hist_bins,
-                                           &lnk_blob.y_hist_bins_count);
-                                }
+    if (y_hist_bins_max) {
+        ctx->y_hist_bins = uma_malloc(ptr->h * sizeof(uint16_t), UMA_SCRATCH);
+    }
 
-                                bool add_to_list = threshold_cb_arg == NULL;
-                                if (!add_to_list) {
-                                    add_to_list = threshold_cb(threshold_cb_arg, &lnk_blob);
-                                }
+    size_t thresholds_len = list_size(thresholds);
+    color_thresholds_list_lnk_data_t *t = uma_malloc(IM_MAX(thresholds_len, (size_t) 1) *
+                                                     sizeof(color_thresholds_list_lnk_data_t), UMA_SCRATCH);
 
-                                if (add_to_list) {
-                                    list_push_back(out, &lnk_blob);
-                                } else {
-                                    if (lnk_blob.x_hist_bins) {
-                                        m_free(lnk_blob.x_hist_bins);
-                                    }
-                                    if (lnk_blob.y_hist_bins) {
-                                        m_free(lnk_blob.y_hist_bins);
-                                    }
-                                }
-                            }
+    size_t code = 0;
+    list_for_each(it, thresholds) {
+        memcpy(&t[code++], list_get_data(it), sizeof(color_thresholds_list_lnk_data_t));
+    }
 
-                            x = old_x;
-                            y = old_y;
-                        }
-                    }
-                }
+    // BINARY and GRAYSCALE pixels map to a code with a lookup table.
+    for (int i = 0; i < 256; i++) {
+        ctx->lut[i] = BLOB_CODE_NONE;
+        for (size_t j = 0; j < thresholds_len; j++) {
+            bool match = (ptr->pixfmt == PIXFORMAT_BINARY) ?
+                         COLOR_THRESHOLD_BINARY(i, &t[j], invert) : COLOR_THRESHOLD_GRAYSCALE(i, &t[j], invert);
+            if (match) {
+                ctx->lut[i] = j;
                 break;
             }
-            case PIXFORMAT_RGB565: {
-                for (int y = roi->y, yy = roi->y + roi->h, y_max = yy - 1; y < yy; y += y_stride) {
-                    imlib_poll_events();
-                    uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y);
-                    uint32_t *bmp_row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
-                    for (int x = roi->x + (y % x_stride), xx = roi->x + roi->w, x_max = xx - 1; x < xx; x += x_stride) {
-                        if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row_ptr, x))
-                            && COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x), lnk_data, invert)) {
-                            int old_x = x;
-                            int old_y = y;
-
-                            float corners_acc[FIND_BLOBS_CORNERS_RESOLUTION];
-                            point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
-                            int corners_n[FIND_BLOBS_CORNERS_RESOLUTION];
-                            // Ensures that maximum goes all the way to the edge of the image.
-                            for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                corners[i].x =
-                                    IM_CLAMP(x_max * sign(cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, x_max);
-                                corners[i].y =
-                                    IM_CLAMP(y_max * sign(sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]), 0, y_max);
-                                corners_acc[i] = (corners[i].x * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                                 (corners[i].y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                corners_n[i] = 1;
-                            }
+        }
+    }
 
-                            int blob_pixels = 0;
-                            int blob_perimeter = 0;
-                            int blob_cx = 0;
-                            int blob_cy = 0;
-                            long long blob_a = 0;
-                            long long blob_b = 0;
-                            long long blob_c = 0;
+    // RGB565 pixels test all thresholds at once with one bit per threshold for each of L, A and B.
+    ctx->thresholds_mask = (thresholds_len < 32) ? ((1U << thresholds_len) - 1) : UINT32_MAX;
+    if (ptr->pixfmt == PIXFORMAT_RGB565) {
+        uint32_t *lab_masks = ctx->lab_masks = uma_calloc(256 * 3 * sizeof(uint32_t), UMA_SCRATCH);
+        for (int i = 0; i < 256; i++) {
+            for (size_t j = 0; j < thresholds_len; j++) {
+                lab_masks[i] |= ((uint32_t) ((t[j].LMin <= i) && (i <= t[j].LMax))) << j;
+                lab_masks[256 + i] |= ((uint32_t) ((t[j].AMin <= (i - 128)) && ((i - 128) <= t[j].AMax))) << j;
+                lab_masks[512 + i] |= ((uint32_t) ((t[j].BMin <= (i - 128)) && ((i - 128) <= t[j].BMax))) << j;
+            }
+        }
+    }
 
-                            if (x_hist_bins) {
-                                memset(x_hist_bins, 0, ptr->w * sizeof(uint16_t));
-                            }
-                            if (y_hist_bins) {
-                                memset(y_hist_bins, 0, ptr->h * sizeof(uint16_t));
-                            }
+    uma_free(t);
 
-                            // Scanline Flood Fill Algorithm //
+    ctx->codes_buf = uma_malloc(roi->w * 2, UMA_SCRATCH);
+    ctx->prev_codes = ctx->codes_buf;
+    ctx->codes = ctx->codes_buf + roi->w;
+    ctx->runs_buf = uma_malloc(roi->w * 2 * sizeof(blob_run_t), UMA_SCRATCH);
+    ctx->prev_runs = ctx->runs_buf;
+    ctx->runs = ctx->runs_buf + roi->w;
 
-                            for (;;) {
-                                int left = x, right = x;
-                                uint16_t *row     = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y);
-                                uint32_t *bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y);
+    list_init(out, sizeof(find_blobs_list_lnk_data_t));
+    return ctx;
+}
 
-                                while ((left > roi->x)
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, left - 1))
-                                       && COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, left - 1), lnk_data,
-                                                                 invert)) {
-                                    left--;
-                                }
+void imlib_find_blobs_row(blob_labeler_t *ctx, const void *row, int y) {
+    const rectangle_t *roi = &ctx->roi;
+    uint8_t *codes = ctx->codes;
+    uint8_t *prev_codes = ctx->prev_codes;
+    blob_run_t *runs = ctx->runs;
+    blob_run_t *prev_runs = ctx->prev_runs;
+    int prev_runs_n = ctx->prev_runs_n;
+    int yy = roi->y + roi->h;
 
-                                while ((right < (roi->x + roi->w - 1))
-                                       && (!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, right + 1))
-                                       && COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, right + 1), lnk_data,
-                                                                 invert)) {
-                                    right++;
-                                }
+    switch (ctx->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            const uint32_t *row_ptr = row;
+            for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
+                codes[x - roi->x] = ctx->lut[IMAGE_GET_BINARY_PIXEL_FAST(row_ptr, x)];
+            }
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            const uint8_t *row_ptr = row;
+            for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
+                codes[x - roi->x] = ctx->lut[IMAGE_GET_GRAYSCALE_PIXEL_FAST(row_ptr, x)];
+            }
+            break;
+        }
+        case PIXFORMAT_RGB565: {
+            const uint16_t *row_ptr = row;
+            const uint32_t *lab_masks = ctx->lab_masks;
+            for (int x = roi->x, xx = roi->x + roi->w; x < xx; x++) {
+                int pixel = IMAGE_GET_RGB565_PIXEL_FAST(row_ptr, x);
+                uint32_t match = lab_masks[COLOR_RGB565_TO_L(pixel)] &
+                                 lab_masks[256 + COLOR_RGB565_TO_A(pixel) + 128] &
+                                 lab_masks[512 + COLOR_RGB565_TO_B(pixel) + 128];
+                match = (ctx->invert ? ~match : match) & ctx->thresholds_mask;
+                codes[x - roi->x] = match ? __CLZ(__RBIT(match)) : BLOB_CODE_NONE;
+            }
+            break;
+        }
+        default: {
+            memset(codes, BLOB_CODE_NONE, roi->w);
+            break;
+        }
+    }
 
-                                for (int i = left; i <= right; i++) {
-                                    IMAGE_SET_BINARY_PIXEL_FAST(bmp_row, i);
-                                }
+    // Split the row into runs.
+    int runs_n = 0;
+    for (int x = 0; x < roi->w;) {
+        uint8_t run_code = codes[x];
+        if (run_code == BLOB_CODE_NONE) {
+            x++;
+            continue;
+        }
 
-                                int sum = sum_m_to_n(left, right);
-                                int sum_2 = sum_2_m_to_n(left, right);
-                                int cnt = right - left + 1;
-                                int avg = sum / cnt;
-
-                                for (int i = 0; i < FIND_BLOBS_CORNERS_RESOLUTION; i++) {
-                                    int x_new = (cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] > 0) ? left :
-                                                ((cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i] == 0) ? avg :
-                                                 right);
-                                    float z = (x_new * cos_table[FIND_BLOBS_ANGLE_RESOLUTION * i]) +
-                                              (y * sin_table[FIND_BLOBS_ANGLE_RESOLUTION * i]);
-                                    if (z < corners_acc[i]) {
-                                        corners_acc[i] = z;
-                                        corners[i].x = x_new;
-                                        corners[i].y = y;
-                                        corners_n[i] = 1;
-                                    } else if (z == corners_acc[i]) {
-                                        corners[i].x = cumulative_moving_average(corners[i].x, x_new, corners_n[i]);
-                                        corners[i].y = cumulative_moving_average(corners[i].y, y, corners_n[i]);
-                                        corners_n[i] += 1;
-                                    }
-                                }
+        int l = x;
+        while ((x < roi->w) && (codes[x] == run_code)) {
+            x++;
+        }
 
-                                blob_pixels += cnt;
-                                blob_perimeter += 2;
-                                blob_cx += sum;
-                                blob_cy += y * cnt;
-                                blob_a += sum_2;
-                                blob_b += y * sum;
-                                blob_c += y * y * cnt;
+        runs[runs_n].l = roi->x + l;
+        runs[runs_n].r = roi->x + x - 1;
+        runs[runs_n].code = run_code;
+        runs[runs_n].label = -1;
+        runs_n++;
+    }
 
-                                if (y_hist_bins) {
-                                    y_hist_bins[y] += cnt;
-                                }
-                                if (x_hist_bins) {
-                                    for (int i = left; i <= right; i++) {
-                                        x_hist_bins[i] += 1;
-                                    }
-                                }
+    // Seeds are the pixels the flood fill used to start from.
+    unsigned int x_stride = ctx->x_stride;
+    bool seed_row = ((y - roi->y) % ctx->y_stride) == 0;
+    int seed_x = roi->x + (y % x_stride);
 
-                                int top_left = left;
-                                int bot_left = left;
-                                bool break_out = false;
-                                for (;;) {
-                                    if (lifo_size(&lifo) < lifo_len) {
-
-                                        if (y > roi->y) {
-                                            row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y - 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y - 1);
-
-                                            bool recurse = false;
-                                            for (int i = top_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i),
-                                                                                   lnk_data,
-                                                                                   invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = i + 1; // Don't test the same pixel again...
-                                                    context.b_l = bot_left;
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y - 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-
-                                        if (y < (roi->y + roi->h - 1)) {
-                                            row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(ptr, y + 1);
-                                            bmp_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(&bmp, y + 1);
-
-                                            bool recurse = false;
-                                            for (int i = bot_left; i <= right; i++) {
-                                                bool ok = true; // Does nothing if thresholding is skipped.
-
-                                                if ((!IMAGE_GET_BINARY_PIXEL_FAST(bmp_row, i))
-                                                    && (ok =
-                                                            COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST(row, i),
-                                                                                   lnk_data,
-                                                                                   invert))) {
-                                                    xylr_t context;
-                                                    context.x = x;
-                                                    context.y = y;
-                                                    context.l = left;
-                                                    context.r = right;
-                                                    context.t_l = top_left;
-                                                    context.b_l = i + 1; // Don't test the same pixel again...
-                                                    lifo_enqueue(&lifo, &context);
-                                                    x = i;
-                                                    y = y + 1;
-                                                    recurse = true;
-                                                    break;
-                                                }
-
-                                                blob_perimeter += (!ok) && (i != left) && (i != right);
-                                            }
-                                            if (recurse) {
-                                                break;
-                                            }
-                                        } else {
-                                            blob_perimeter += right - left + 1;
-                                        }
-                                    } else {
-                                        blob_perimeter += (right - left + 1) * 2;
-                                    }
-
-                                    if (!lifo_size(&lifo)) {
-                                        break_out = true;
-                                        break;
-                                    }
+    // Connect the runs to the runs on the previous row.
+    for (int i = 0, j = 0; i < runs_n; i++) {
+        blob_run_t *run = &runs[i];
 
-                                    xylr_t context;
-                                    lifo_dequeue(&lifo, &context);
-                                    x = context.x;
-                                    y = context.y;
-                                    left = context.l;
-                                    right = context.r;
-                                    top_left = context.t_l;
-                                    bot_left = context.b_l;
-                                }
+        while ((j < prev_runs_n) && (prev_runs[j].r < run->l)) {
+            j++;
+        }
 
-                                if (break_out) {
-                                    break;
-                                }
-                            }
+        for (int k = j; (k < prev_runs_n) && (prev_runs[k].l <= run->r); k++) {
+            if (prev_runs[k].code == run->code) {
+                int32_t root = blob_label_find(ctx->labels, prev_runs[k].label);
+                if (run->label < 0) {
+                    run->label = root;
+                } else if (root != run->label) {
+                    blob_label_merge(ctx, run->label, root);
+                }
+            }
+        }
 
-                            rectangle_t rect;
-                            rect.x = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x; // l
-                            rect.y = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y; // t
-                            rect.w = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 2) / 4].x -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 0) / 4].x + 1;                                              // r - l + 1
-                            rect.h = corners[(FIND_BLOBS_CORNERS_RESOLUTION * 3) / 4].y -
-                                     corners[(FIND_BLOBS_CORNERS_RESOLUTION * 1) / 4].y + 1;                                              // b - t + 1
-
-                            if (((rect.w * rect.h) >= area_threshold) && (blob_pixels >= pixels_threshold)) {
-
-                                // http://www.cse.usf.edu/~r1k/MachineVisionBook/MachineVision.files/MachineVision_Chapter2.pdf
-                                // https://www.strchr.com/standard_deviation_in_one_pass
-                                //
-                                // a = sigma(x*x) + (mx*sigma(x)) + (mx*sigma(x)) + (sigma()*mx*mx)
-                                // b = sigma(x*y) + (mx*sigma(y)) + (my*sigma(x)) + (sigma()*mx*my)
-                                // c = sigma(y*y) + (my*sigma(y)) + (my*sigma(y)) + (sigma()*my*my)
-                                //
-                                // blob_a = sigma(x*x)
-                                // blob_b = sigma(x*y)
-                                // blob_c = sigma(y*y)
-                                // blob_cx = sigma(x)
-                                // blob_cy = sigma(y)
-                                // blob_pixels = sigma()
-
-                                float b_mx = blob_cx / ((float) blob_pixels);
-                                float b_my = blob_cy / ((float) blob_pixels);
-                                int mx = fast_roundf(b_mx); // x centroid
-                                int my = fast_roundf(b_my); // y centroid
-                                int small_blob_a = blob_a - ((mx * blob_cx) + (mx * blob_cx)) + (blob_pixels * mx * mx);
-                                int small_blob_b = blob_b - ((mx * blob_cy) + (my * blob_cx)) + (blob_pixels * mx * my);
-                                int small_blob_c = blob_c - ((my * blob_cy) + (my * blob_cy)) + (blob_pixels * my * my);
-
-                                find_blobs_list_lnk_data_t lnk_blob;
-                                memcpy(lnk_blob.corners, corners, FIND_BLOBS_CORNERS_RESOLUTION * sizeof(point_t));
-                                memcpy(&lnk_blob.rect, &rect, sizeof(rectangle_t));
-                                lnk_blob.pixels = blob_pixels;
-                                lnk_blob.perimeter = blob_perimeter;
-                                lnk_blob.code = 1 << code;
-                                lnk_blob.count = 1;
-                                lnk_blob.centroid_x = b_mx;
-                                lnk_blob.centroid_y = b_my;
-                                lnk_blob.rotation =
-                                    (small_blob_a !=
-                                     small_blob_c) ? (fast_atan2f(2 * small_blob_b, small_blob_a - small_blob_c) / 2.0f) : 0.0f;
-                                lnk_blob.roundness = calc_roundness(small_blob_a, small_blob_b, small_blob_c);
-                                lnk_blob.x_hist_bins_count = 0;
-                                lnk_blob.x_hist_bins = NULL;
-                                lnk_blob.y_hist_bins_count = 0;
-                                lnk_blob.y_hist_bins = NULL;
-                                // These store the current average accumulation.
-                                lnk_blob.centroid_x_acc = lnk_blob.centroid_x * lnk_blob.pixels;
-                                lnk_blob.centroid_y_acc = lnk_blob.centroid_y * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_x = cosf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.rotation_acc_y = sinf(lnk_blob.rotation) * lnk_blob.pixels;
-                                lnk_blob.roundness_acc = lnk_blob.roundness * lnk_blob.pixels;
-
-                                if (x_hist_bins) {
-                                    bin_up(x_hist_bins,
-                                           ptr->w,
-                                           x_hist_bins_max,
-                                           &lnk_blob.x_hist_bins,
-                                           &lnk_blob.x_hist_bins_count);
-                                }
+        if (run->label < 0) {
+            run->label = blob_label_new(ctx, run->code, y);
+        }
 
-                                if (y_hist_bins) {
-                                    bin_up(y_hist_bins,
-                                           ptr->h,
-                                           y_hist_bins_max,
-                                           &lnk_blob.y_hist_bins,
-                                           &lnk_blob.y_hist_bins_count);
-                                }
+        blob_label_add_run(ctx, run->label, run->l, run->r, y);
+        blob_label_t *label = &ctx->labels[run->label];
 
-                                bool add_to_list = threshold_cb_arg == NULL;
-                                if (!add_to_list) {
-                                    add_to_list = threshold_cb(threshold_cb_arg, &lnk_blob);
-                                }
+        if (y == roi->y) {
+            label->perimeter += run->r - run->l + 1;
+        } else {
+            label->perimeter += blob_count_border(prev_codes, run->l - roi->x + 1, run->r - roi->x - 1, run->code);
+        }
 
-                                if (add_to_list) {
-                                    list_push_back(out, &lnk_blob);
-                                } else {
-                                    if (lnk_blob.x_hist_bins) {
-                                        m_free(lnk_blob.x_hist_bins);
-                                    }
-                                    if (lnk_blob.y_hist_bins) {
-                                        m_free(lnk_blob.y_hist_bins);
-                                    }
-                                }
-                            }
+        if (y == (yy - 1)) {
+            label->perimeter += run->r - run->l + 1;
+        }
 
-                            x = old_x;
-                            y = old_y;
-                        }
-                    }
-                }
-                break;
-            }
-            default: {
-                break;
+        if (seed_row) {
+            int x = (run->l <= seed_x) ? seed_x :
+                    (seed_x + ((((run->l - seed_x) + x_stride - 1) / x_stride) * x_stride));
+            if (x <= run->r) {
+                uint64_t key = (((uint64_t) run->code) << 32) | (((uint64_t) y) << 16) | x;
+                label->key = IM_MIN(label->key, key);
             }
         }
+    }
 
-        code += 1;
+    // Labels may have been merged, so resolve the roots before releasing anything.
+    for (int i = 0; i < runs_n; i++) {
+        runs[i].label = blob_label_find(ctx->labels, runs[i].label);
+        ctx->labels[runs[i].label].stamp = y;
     }
 
-    lifo_free(&lifo);
-    uma_free(y_hist_bins);
-    uma_free(x_hist_bins);
-    uma_free(bmp.data);
+    for (int k = 0; k < prev_runs_n; k++) {
+        blob_run_t *run = &prev_runs[k];
+        run->root = blob_label_find(ctx->labels, run->label);
+        ctx->labels[run->root].perimeter += blob_count_border(codes, run->l - roi->x + 1,
+                                                              run->r - roi->x - 1, run->code);
+    }
+
+    // Output labels that did not continue onto this row and release merged labels.
+    for (int k = 0; k < prev_runs_n; k++) {
+        blob_run_t *run = &prev_runs[k];
+        if (ctx->labels[run->label].stamp == BLOB_LABEL_FREE) {
+            continue;
+        }
+
+        if (run->label != run->root) {
+            blob_label_free(ctx, run->label);
+        } else if (ctx->labels[run->root].stamp != y) {
+            blob_label_emit(ctx, run->root);
+            blob_label_free(ctx, run->root);
+        }
+    }
+
+    ctx->prev_codes = codes;
+    ctx->codes = prev_codes;
+    ctx->prev_runs = runs;
+    ctx->runs = prev_runs;
+    ctx->prev_runs_n = runs_n;
+}
+
+void imlib_find_blobs_finish(blob_labeler_t *ctx, bool merge, int margin,
+                             bool (*merge_cb) (void *, find_blobs_list_lnk_data_t *, find_blobs_list_lnk_data_t *),
+                             void *merge_cb_arg) {
+    list_t *out = ctx->out;
+    unsigned int x_hist_bins_max = ctx->x_hist_bins_max;
+    unsigned int y_hist_bins_max = ctx->y_hist_bins_max;
+
+    for (int k = 0; k < ctx->prev_runs_n; k++) {
+        if (ctx->labels[ctx->prev_runs[k].label].stamp != BLOB_LABEL_FREE) {
+            blob_label_emit(ctx, ctx->prev_runs[k].label);
+            blob_label_free(ctx, ctx->prev_runs[k].label);
+        }
+    }
+
+    // Blobs are output in the order the flood fill used to find them.
+    size_t out_len = list_size(out);
+    if (out_len > 1) {
+        blob_sort_t *sort = uma_malloc(out_len * sizeof(blob_sort_t), UMA_SCRATCH);
+
+        size_t i = 0;
+        list_for_each(it, out) {
+            sort[i].key = ctx->keys[i];
+            sort[i].lnk = it;
+            i++;
+        }
+
+        qsort(sort, out_len, sizeof(blob_sort_t), blob_sort_compare);
+
+        for (i = 0; i < out_len; i++) {
+            list_move_back(out, out, sort[i].lnk);
+        }
+
+        uma_free(sort);
+    }
+
+    uma_free(ctx->runs_buf);
+    uma_free(ctx->codes_buf);
+    uma_free(ctx->lab_masks);
+    uma_free(ctx->keys);
+    uma_free(ctx->nodes);
+    uma_free(ctx->labels);
+    uma_free(ctx->y_hist_bins);
+    uma_free(ctx->x_hist_bins);
+    uma_free(ctx);
 
     if (merge) {
         for (;;) {
@@ -1183,6 +884,24 @@ void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int
     }
 }
 
+void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
+                      list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
+                      bool merge, int margin, bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *),
+                      void *threshold_cb_arg,
+                      bool (*merge_cb) (void *, find_blobs_list_lnk_data_t *, find_blobs_list_lnk_data_t *),
+                      void *merge_cb_arg, unsigned int x_hist_bins_max, unsigned int y_hist_bins_max) {
+    blob_labeler_t *ctx = imlib_find_blobs_start(out, ptr, roi, x_stride, y_stride, thresholds, invert,
+                                                 area_threshold, pixels_threshold, threshold_cb, threshold_cb_arg,
+                                                 x_hist_bins_max, y_hist_bins_max);
+
+    for (int y = roi->y, yy = roi->y + roi->h; y < yy; y++) {
+        imlib_poll_events();
+        imlib_find_blobs_row(ctx, ptr->data + (y * image_line_size(ptr)), y);
+    }
+
+    imlib_find_blobs_finish(ctx, merge, margin, merge_cb, merge_cb_arg);
+}
+
 void imlib_flood_fill_int(image_t *out, image_t *img, int x, int y,
                           int seed_threshold, int floating_threshold,
                           flood_fill_call_back_t cb, void *data) {
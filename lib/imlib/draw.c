@@ -2718,6 +2718,92 @@ void imlib_draw_row(int x_start, int x_end, int y_row, imlib_draw_row_data_t *da
     #undef BLEND_RGB566
 }
 
+#if (OMV_JPEG_CODEC_ENABLE == 0)
+typedef struct imlib_draw_jpeg_rows {
+    image_t *dst_img;
+    int dst_x_start;
+    int dst_y_start;
+    rectangle_t roi;
+    int rgb_channel;
+    int alpha;
+    const uint16_t *color_palette;
+    const uint8_t *alpha_palette;
+    image_hint_t hint;
+    imlib_draw_row_callback_t callback;
+    void *callback_arg;
+    void *dst_row_override;
+} imlib_draw_jpeg_rows_t;
+
+// Draws a band of decoded JPEG rows 1:1 at its final position.
+static void imlib_draw_jpeg_rows(void *arg, image_t *rows, int y) {
+    imlib_draw_jpeg_rows_t *d = (imlib_draw_jpeg_rows_t *) arg;
+    int y_start = IM_MAX(y, d->roi.y);
+    int y_end = IM_MIN(y + rows->h, d->roi.y + d->roi.h);
+
+    if (y_start < y_end) {
+        rectangle_t roi = { d->roi.x, y_start - y, d->roi.w, y_end - y_start };
+        imlib_draw_image(d->dst_img, rows, d->dst_x_start, d->dst_y_start + (y_start - d->roi.y), 1.f, 1.f, &roi,
+                         d->rgb_channel, d->alpha, d->color_palette, d->alpha_palette, d->hint, NULL,
+                         d->callback, d->callback_arg, d->dst_row_override);
+    }
+}
+
+// Decodes only the MCUs under the roi, letting the decoder do power-of-two downscaling in the DCT
+// domain. When no scaling, flipping or transposing is left the rows are drawn as they are decoded
+// so the full image is never buffered. Scales and hints must be resolved by the caller.
+static void imlib_draw_jpeg_image(image_t *dst_img, image_t *src_img, int dst_x_start, int dst_y_start,
+                                  float x_scale, float y_scale, rectangle_t *roi, int pixfmt,
+                                  int rgb_channel, int alpha, const uint16_t *color_palette,
+                                  const uint8_t *alpha_palette, image_hint_t hint,
+                                  imlib_draw_row_callback_t callback, void *callback_arg,
+                                  void *dst_row_override) {
+    int scale = 1;
+    while ((scale < 8) && ((x_scale * scale * 2) <= 1.f) && ((y_scale * scale * 2) <= 1.f)) {
+        scale *= 2;
+    }
+
+    rectangle_t rect = *roi;
+    image_t jpeg_img = { .pixfmt = pixfmt };
+    jpeg_decompress_geometry(&jpeg_img, src_img, &rect, scale);
+
+    rectangle_t jpeg_roi;
+    jpeg_roi.x = (roi->x - rect.x) / scale;
+    jpeg_roi.y = (roi->y - rect.y) / scale;
+    jpeg_roi.w = IM_MIN((roi->w + scale - 1) / scale, jpeg_img.w - jpeg_roi.x);
+    jpeg_roi.h = IM_MIN((roi->h + scale - 1) / scale, jpeg_img.h - jpeg_roi.y);
+
+    x_scale *= scale;
+    y_scale *= scale;
+
+    // Rows can't be streamed into the buffer that holds the compressed image.
+    if ((x_scale == 1.f) && (y_scale == 1.f) && (dst_img->data != src_img->data) &&
+        !(hint & (IMAGE_HINT_HMIRROR | IMAGE_HINT_VFLIP | IMAGE_HINT_TRANSPOSE))) {
+        imlib_draw_jpeg_rows_t rows = {
+            .dst_img = dst_img,
+            .dst_x_start = dst_x_start,
+            .dst_y_start = dst_y_start,
+            .roi = jpeg_roi,
+            .rgb_channel = rgb_channel,
+            .alpha = alpha,
+            .color_palette = color_palette,
+            .alpha_palette = alpha_palette,
+            .hint = hint,
+            .callback = callback,
+            .callback_arg = callback_arg,
+            .dst_row_override = dst_row_override,
+        };
+        jpeg_decompress_rect(&jpeg_img, src_img, &rect, scale, imlib_draw_jpeg_rows, &rows);
+    } else {
+        jpeg_img.data = uma_malloc(image_size(&jpeg_img), UMA_CACHE);
+        jpeg_decompress_rect(&jpeg_img, src_img, &rect, scale, NULL, NULL);
+        imlib_draw_image(dst_img, &jpeg_img, dst_x_start, dst_y_start, x_scale, y_scale, &jpeg_roi,
+                         rgb_channel, alpha, color_palette, alpha_palette, hint, NULL,
+                         callback, callback_arg, dst_row_override);
+        uma_free(jpeg_img.data);
+    }
+}
+#endif
+
 static void imlib_draw_image_scale_and_center_helper(image_t *dst_img,
                                                      int src_img_w,
                                                      int src_img_h,
@@ -2919,6 +3005,27 @@ void imlib_draw_image(image_t *dst_img,
         }
     }
 
+    #if (OMV_JPEG_CODEC_ENABLE == 0)
+    if ((src_img->pixfmt == PIXFORMAT_JPEG) && (!transform)) {
+        int pixfmt = (rgb_channel != -1) ? PIXFORMAT_RGB565 : (color_palette ? PIXFORMAT_GRAYSCALE : dst_img->pixfmt);
+        bool full = (w_start == 0) && (h_start == 0) && (src_img_w == src_img->w) && (src_img_h == src_img->h);
+        bool scaling = (x_scale != 1.f) || (y_scale != 1.f);
+        bool flipping = (dst_delta_x < 0) || (dst_delta_y < 0) || (hint & IMAGE_HINT_TRANSPOSE);
+
+        // Falls through to a full frame decode when this has nothing to save.
+        if (((pixfmt == PIXFORMAT_BINARY) || (pixfmt == PIXFORMAT_GRAYSCALE) || (pixfmt == PIXFORMAT_RGB565)) &&
+            ((!full) || ((x_scale <= 0.5f) && (y_scale <= 0.5f)) || (!scaling && !flipping))) {
+            rectangle_t jpeg_roi = { w_start, h_start, src_img_w, src_img_h };
+            hint &= ~(IMAGE_HINT_HMIRROR | IMAGE_HINT_VFLIP);
+            hint |= ((dst_delta_x < 0) ? IMAGE_HINT_HMIRROR : 0) | ((dst_delta_y < 0) ? IMAGE_HINT_VFLIP : 0);
+            imlib_draw_jpeg_image(dst_img, src_img, dst_x_start, dst_y_start, x_scale, y_scale, &jpeg_roi, pixfmt,
+                                  rgb_channel, alpha, color_palette, alpha_palette, hint,
+                                  callback, callback_arg, dst_row_override);
+            return;
+        }
+    }
+    #endif
+
     int dst_x_start_backup = dst_x_start;
     int dst_y_start_backup = dst_y_start;
 
@@ -21,17 +21,29 @@
  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
  * THE SOFTWARE.
  *
- * FFT LIB - can do 1024 point real FFTs and 512 point complex FFTs
+ * FFT LIB - real and complex FFTs of 2^n, 3*2^n and 5*2^n points using CMSIS-DSP.
  */
 #ifndef __FFT_H__
 #define __FFT_H__
 #include <stdint.h>
+#include <arm_math.h>
 #include "imlib.h"
 
+// Transform lengths are rounded up to the nearest supported size, which may
+// not be a power of two. The plan is initialized once and reused per row/col.
+typedef struct {
+    int len;
+    int radix;
+    bool real;
+    arm_cfft_instance_f32 cfft;
+    arm_rfft_fast_instance_f32 rfft;
+    float *twiddles;
+} fft_plan_t;
+
 typedef struct {
     uint8_t *d_pointer;
     int d_len;
-    int pow2;
+    fft_plan_t plan;
     float *data;
 } fft1d_controller_t;
 
@@ -49,7 +61,8 @@ void fft1d_run_again(fft1d_controller_t *controller); // Do FFT again on real ma
 typedef struct {
     image_t *img;
     rectangle_t r;
-    int w_pow2, h_pow2;
+    int w, h;
+    fft_plan_t w_plan, h_plan;
     float *data;
 } fft2d_controller_t;
 
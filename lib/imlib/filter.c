@@ -25,8 +25,47 @@
  */
 #include "fsort.h"
 #include "imlib.h"
+#include "simd.h"
 #include "umalloc.h"
 
+#if defined(IMLIB_ENABLE_MEAN) || defined(IMLIB_ENABLE_MEDIAN) || defined(IMLIB_ENABLE_MIDPOINT)
+// Applies the adaptive threshold to a filtered row (in place) using the unfiltered source row.
+static inline void filter_threshold_row_grayscale(uint8_t *dst, uint8_t *src, int w, int offset, bool invert) {
+    for (int x = 0; x < w; x++) {
+        if (((dst[x] - offset) < src[x]) ^ invert) {
+            dst[x] = COLOR_GRAYSCALE_BINARY_MAX;
+        } else {
+            dst[x] = COLOR_GRAYSCALE_BINARY_MIN;
+        }
+    }
+}
+
+static inline void filter_threshold_row_rgb565(uint16_t *dst, uint16_t *src, int w, int offset, bool invert) {
+    for (int x = 0; x < w; x++) {
+        if (((COLOR_RGB565_TO_Y(dst[x]) - offset) < COLOR_RGB565_TO_Y(src[x])) ^ invert) {
+            dst[x] = COLOR_RGB565_BINARY_MAX;
+        } else {
+            dst[x] = COLOR_RGB565_BINARY_MIN;
+        }
+    }
+}
+
+// Replicates the first and last of w values into the ksize wide borders around them.
+static inline void filter_pad_row_u8(uint8_t *row, int w, int ksize) {
+    for (int i = 1; i <= ksize; i++) {
+        row[-i] = row[0];
+        row[w - 1 + i] = row[w - 1];
+    }
+}
+
+static inline void filter_pad_row_u16(uint16_t *row, int w, int ksize) {
+    for (int i = 1; i <= ksize; i++) {
+        row[-i] = row[0];
+        row[w - 1 + i] = row[w - 1];
+    }
+}
+#endif
+
 void imlib_histeq(image_t *img, image_t *mask) {
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
@@ -63,7 +102,7 @@ void imlib_histeq(image_t *img, image_t *mask) {
         case PIXFORMAT_GRAYSCALE: {
             int a = img->w * img->h;
             float s = (COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN) / ((float) a);
-            uint32_t *hist = uma_calloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(uint32_t), UMA_DTCM);
+            uint32_t *hist = uma_calloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(uint32_t), UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
@@ -95,7 +134,7 @@ void imlib_histeq(image_t *img, image_t *mask) {
         case PIXFORMAT_RGB565: {
             int a = img->w * img->h;
             float s = (COLOR_Y_MAX - COLOR_Y_MIN) / ((float) a);
-            uint32_t *hist = uma_calloc((COLOR_Y_MAX - COLOR_Y_MIN + 1) * sizeof(uint32_t), UMA_DTCM);
+            uint32_t *hist = uma_calloc((COLOR_Y_MAX - COLOR_Y_MIN + 1) * sizeof(uint32_t), UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
@@ -151,6 +190,173 @@ void imlib_histeq(image_t *img, image_t *mask) {
 //   much change in performance.
 //
 #ifdef IMLIB_ENABLE_MEAN
+// The vectorized path keeps a running column sum of the (clamped) kernel rows which is updated by
+// adding the row entering the window and subtracting the row leaving it. The column sums are then
+// padded and summed horizontally. All sums are in 16-bit lanes, which bounds the kernel size.
+#define MEAN_SIMD_MAX_KSIZE     (7)
+
+static void mean_csum_update_grayscale(uint16_t *csum, uint8_t *row, int w, bool sub) {
+    for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+        v128_predicate_t pred = vpredicate_16(w - x);
+        v128_t s = vldr_u16_pred(csum + x, pred);
+        v128_t p = vldr_u8_widen_u16_pred(row + x, pred);
+        s = sub ? vsub_u16(s, p) : vadd_u16(s, p);
+        vstr_u16_pred(csum + x, s, pred);
+    }
+}
+
+static void mean_csum_update_rgb565(uint16_t *r_csum, uint16_t *g_csum, uint16_t *b_csum,
+                                    uint16_t *row, int w, bool sub) {
+    for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+        v128_predicate_t pred = vpredicate_16(w - x);
+        v128_t p = vldr_u16_pred(row + x, pred);
+        v128_t r = vlsr_u16(p, 11);
+        v128_t g = vand_u32(vlsr_u16(p, 5), vdup_u16(0x3F));
+        v128_t b = vand_u32(p, vdup_u16(0x1F));
+        v128_t r_s = vldr_u16_pred(r_csum + x, pred);
+        v128_t g_s = vldr_u16_pred(g_csum + x, pred);
+        v128_t b_s = vldr_u16_pred(b_csum + x, pred);
+        if (sub) {
+            r_s = vsub_u16(r_s, r);
+            g_s = vsub_u16(g_s, g);
+            b_s = vsub_u16(b_s, b);
+        } else {
+            r_s = vadd_u16(r_s, r);
+            g_s = vadd_u16(g_s, g);
+            b_s = vadd_u16(b_s, b);
+        }
+        vstr_u16_pred(r_csum + x, r_s, pred);
+        vstr_u16_pred(g_csum + x, g_s, pred);
+        vstr_u16_pred(b_csum + x, b_s, pred);
+    }
+}
+
+// csum points to the left border of the padded column sums, so lane x sums csum[x:x+(ksize*2)].
+static inline v128_t mean_box_sum(uint16_t *csum, int x, int ksize, uint16_t over32_n, v128_predicate_t pred) {
+    v128_t acc = vldr_u16_pred(csum + x, pred);
+    for (int i = 1, ii = ksize * 2; i <= ii; i++) {
+        acc = vadd_u16(acc, vldr_u16_pred(csum + x + i, pred));
+    }
+    return vmulh_n_u16(acc, over32_n);
+}
+
+static void mean_filter_grayscale_simd(image_t *img, int ksize, bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    // The source row leaving the window is still read one row after the output row is computed.
+    int brows = ksize + 2;
+    uint16_t over32_n = 65536 / (((ksize * 2) + 1) * ((ksize * 2) + 1));
+    uint16_t *csum = uma_malloc((w + (ksize * 2)) * sizeof(uint16_t), UMA_DTCM | UMA_SCRATCH);
+    uint8_t *buf = uma_malloc(w * brows, UMA_DTCM | UMA_SCRATCH);
+    uint16_t *csum_row = csum + ksize;
+
+    memset(csum_row, 0, w * sizeof(uint16_t));
+    for (int j = -ksize; j <= ksize; j++) {
+        int y_j = IM_CLAMP(j, 0, (h - 1));
+        mean_csum_update_grayscale(csum_row, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y_j), w, false);
+    }
+
+    for (int y = 0; y < h; y++) {
+        imlib_poll_events();
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+        uint8_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        if (y > 0) {
+            int y_add = IM_MIN(y + ksize, (h - 1));
+            int y_sub = IM_MAX(y - ksize - 1, 0);
+            mean_csum_update_grayscale(csum_row, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y_add), w, false);
+            mean_csum_update_grayscale(csum_row, IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y_sub), w, true);
+        }
+
+        filter_pad_row_u16(csum_row, w, ksize);
+
+        for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_16(w - x);
+            vstr_u16_narrow_u8_pred(buf_row_ptr + x, mean_box_sum(csum, x, ksize, over32_n, pred), pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_grayscale(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y > ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (y - ksize - 1)),
+                   buf + (((y - ksize - 1) % brows) * w), w);
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize - 1, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w);
+    }
+
+    uma_free(buf);
+    uma_free(csum);
+}
+
+static void mean_filter_rgb565_simd(image_t *img, int ksize, bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    int brows = ksize + 2;
+    int pw = w + (ksize * 2);
+    uint16_t over32_n = 65536 / (((ksize * 2) + 1) * ((ksize * 2) + 1));
+    uint16_t *csum = uma_malloc(pw * sizeof(uint16_t) * 3, UMA_DTCM | UMA_SCRATCH);
+    uint16_t *buf = uma_malloc(w * brows * sizeof(uint16_t), UMA_DTCM | UMA_SCRATCH);
+    uint16_t *r_csum = csum, *g_csum = csum + pw, *b_csum = csum + (pw * 2);
+
+    memset(csum, 0, pw * sizeof(uint16_t) * 3);
+    for (int j = -ksize; j <= ksize; j++) {
+        int y_j = IM_CLAMP(j, 0, (h - 1));
+        mean_csum_update_rgb565(r_csum + ksize, g_csum + ksize, b_csum + ksize,
+                                IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_j), w, false);
+    }
+
+    for (int y = 0; y < h; y++) {
+        imlib_poll_events();
+        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+        uint16_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        if (y > 0) {
+            int y_add = IM_MIN(y + ksize, (h - 1));
+            int y_sub = IM_MAX(y - ksize - 1, 0);
+            mean_csum_update_rgb565(r_csum + ksize, g_csum + ksize, b_csum + ksize,
+                                    IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_add), w, false);
+            mean_csum_update_rgb565(r_csum + ksize, g_csum + ksize, b_csum + ksize,
+                                    IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_sub), w, true);
+        }
+
+        filter_pad_row_u16(r_csum + ksize, w, ksize);
+        filter_pad_row_u16(g_csum + ksize, w, ksize);
+        filter_pad_row_u16(b_csum + ksize, w, ksize);
+
+        for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_16(w - x);
+            v128_t r = mean_box_sum(r_csum, x, ksize, over32_n, pred);
+            v128_t g = mean_box_sum(g_csum, x, ksize, over32_n, pred);
+            v128_t b = mean_box_sum(b_csum, x, ksize, over32_n, pred);
+            v128_t pixels = vorr_u32(vlsl_u16(r, 11), vorr_u32(vlsl_u16(g, 5), b));
+            vstr_u16_pred(buf_row_ptr + x, pixels, pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_rgb565(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y > ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, (y - ksize - 1)),
+                   buf + (((y - ksize - 1) % brows) * w), w * sizeof(uint16_t));
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize - 1, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w * sizeof(uint16_t));
+    }
+
+    uma_free(buf);
+    uma_free(csum);
+}
+
 void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset, bool invert, image_t *mask) {
     int brows = ksize + 1;
     image_t buf;
@@ -162,7 +368,7 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
 
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -228,7 +434,12 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            if (!mask && (ksize >= 1) && (ksize <= MEAN_SIMD_MAX_KSIZE)) {
+                mean_filter_grayscale_simd(img, ksize, threshold, offset, invert);
+                break;
+            }
+
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -292,8 +503,13 @@ void imlib_mean_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case PIXFORMAT_RGB565: {
+            if (!mask && (ksize >= 1) && (ksize <= MEAN_SIMD_MAX_KSIZE)) {
+                mean_filter_rgb565_simd(img, ksize, threshold, offset, invert);
+                break;
+            }
+
             int pixel, r, g, b, r_acc, g_acc, b_acc;
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -406,6 +622,180 @@ static uint8_t hist_median(uint8_t *data, int len, const int cutoff) {
     return i - 1;
 } /* hist_median() */
 
+// The vectorized path handles small kernels by selecting the ranked value directly instead of
+// maintaining a histogram. The window rows are quantized into a ring of padded planes as they enter
+// the window. The ranked value is then found one bit at a time (MSB first) by counting, per lane,
+// how many window values are below the candidate. This matches the histogram search exactly.
+#define MEDIAN_SIMD_MAX_KSIZE   (2)
+
+// Returns the cutoff-th smallest value (1-based) of the window whose top-left corner is at
+// rows[0] + x. Values must be less than 128 and the window must hold less than 128 values.
+static inline v128_t median_rank_select(uint8_t **rows, int x, int ksize, int cutoff, int bits) {
+    int size = (ksize * 2) + 1;
+    v128_t result = vdup_u8(0);
+    v128_t rank = vdup_u8(cutoff);
+
+    for (int bit = bits - 1; bit >= 0; bit--) {
+        v128_t candidate = vorr_u32(result, vdup_u8(1 << bit));
+        v128_t count = vdup_u8(0);
+
+        for (int j = 0; j < size; j++) {
+            for (int i = 0; i < size; i++) {
+                // value < candidate when (value - candidate) is negative.
+                v128_t diff = vsub_u8(vldr_u8(rows[j] + x + i), candidate);
+                count = vadd_u8(count, vlsr_u8(diff, 7));
+            }
+        }
+
+        // count < cutoff when the ranked value is >= candidate, so keep the bit.
+        v128_t keep = vsub_u8(vdup_u8(0), vlsr_u8(vsub_u8(count, rank), 7));
+        result = vorr_u32(result, vand_u32(keep, vdup_u8(1 << bit)));
+    }
+
+    return result;
+}
+
+static void median_load_row_grayscale(uint8_t *plane, uint8_t *row, int w, int ksize) {
+    for (int x = 0; x < w; x += UINT8_VECTOR_SIZE) {
+        v128_predicate_t pred = vpredicate_8(w - x);
+        vstr_u8_pred(plane + ksize + x, vlsr_u8(vldr_u8_pred(row + x, pred), 2), pred);
+    }
+
+    filter_pad_row_u8(plane + ksize, w, ksize);
+}
+
+static void median_load_row_rgb565(uint8_t *r_plane, uint8_t *g_plane, uint8_t *b_plane,
+                                   uint16_t *row, int w, int ksize) {
+    for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+        v128_predicate_t pred = vpredicate_16(w - x);
+        v128_t p = vldr_u16_pred(row + x, pred);
+        vstr_u16_narrow_u8_pred(r_plane + ksize + x, vlsr_u16(p, 11), pred);
+        vstr_u16_narrow_u8_pred(g_plane + ksize + x, vand_u32(vlsr_u16(p, 5), vdup_u16(0x3F)), pred);
+        vstr_u16_narrow_u8_pred(b_plane + ksize + x, vand_u32(p, vdup_u16(0x1F)), pred);
+    }
+
+    filter_pad_row_u8(r_plane + ksize, w, ksize);
+    filter_pad_row_u8(g_plane + ksize, w, ksize);
+    filter_pad_row_u8(b_plane + ksize, w, ksize);
+}
+
+static void median_filter_grayscale_simd(image_t *img, int ksize, int cutoff, bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    int brows = ksize + 1;
+    int size = (ksize * 2) + 1;
+    // Vector loads may run past the right border.
+    int pw = w + (ksize * 2) + UINT8_VECTOR_SIZE;
+    uint8_t *ring = uma_malloc(pw * size, UMA_DTCM | UMA_SCRATCH);
+    uint8_t *buf = uma_malloc(w * brows, UMA_DTCM | UMA_SCRATCH);
+    uint8_t *rows[(MEDIAN_SIMD_MAX_KSIZE * 2) + 1];
+
+    for (int y = 0, next = 0; y < h; y++) {
+        imlib_poll_events();
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+        uint8_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        for (int yy = IM_MIN(y + ksize, (h - 1)); next <= yy; next++) {
+            median_load_row_grayscale(ring + ((next % size) * pw),
+                                      IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, next), w, ksize);
+        }
+
+        for (int j = 0; j < size; j++) {
+            rows[j] = ring + ((IM_CLAMP(y + j - ksize, 0, (h - 1)) % size) * pw);
+        }
+
+        for (int x = 0; x < w; x += UINT8_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_8(w - x);
+            v128_t pixels = median_rank_select(rows, x, ksize, cutoff, 6);
+            vstr_u8_pred(buf_row_ptr + x, vlsl_u8(pixels, 2), pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_grayscale(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y >= ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (y - ksize)),
+                   buf + (((y - ksize) % brows) * w), w);
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w);
+    }
+
+    uma_free(buf);
+    uma_free(ring);
+}
+
+static void median_filter_rgb565_simd(image_t *img, int ksize, int cutoff, bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    int brows = ksize + 1;
+    int size = (ksize * 2) + 1;
+    int pw = w + (ksize * 2) + UINT8_VECTOR_SIZE;
+    uint8_t *ring = uma_malloc(pw * size * 3, UMA_DTCM | UMA_SCRATCH);
+    uint8_t *planes = uma_malloc(w * 3, UMA_DTCM | UMA_SCRATCH);
+    uint16_t *buf = uma_malloc(w * brows * sizeof(uint16_t), UMA_DTCM | UMA_SCRATCH);
+    uint8_t *r_rows[(MEDIAN_SIMD_MAX_KSIZE * 2) + 1];
+    uint8_t *g_rows[(MEDIAN_SIMD_MAX_KSIZE * 2) + 1];
+    uint8_t *b_rows[(MEDIAN_SIMD_MAX_KSIZE * 2) + 1];
+
+    for (int y = 0, next = 0; y < h; y++) {
+        imlib_poll_events();
+        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+        uint16_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        for (int yy = IM_MIN(y + ksize, (h - 1)); next <= yy; next++) {
+            uint8_t *plane = ring + ((next % size) * pw * 3);
+            median_load_row_rgb565(plane, plane + pw, plane + (pw * 2),
+                                   IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, next), w, ksize);
+        }
+
+        for (int j = 0; j < size; j++) {
+            uint8_t *plane = ring + ((IM_CLAMP(y + j - ksize, 0, (h - 1)) % size) * pw * 3);
+            r_rows[j] = plane;
+            g_rows[j] = plane + pw;
+            b_rows[j] = plane + (pw * 2);
+        }
+
+        for (int x = 0; x < w; x += UINT8_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_8(w - x);
+            vstr_u8_pred(planes + x, median_rank_select(r_rows, x, ksize, cutoff, 5), pred);
+            vstr_u8_pred(planes + w + x, median_rank_select(g_rows, x, ksize, cutoff, 6), pred);
+            vstr_u8_pred(planes + (w * 2) + x, median_rank_select(b_rows, x, ksize, cutoff, 5), pred);
+        }
+
+        for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_16(w - x);
+            v128_t r = vldr_u8_widen_u16_pred(planes + x, pred);
+            v128_t g = vldr_u8_widen_u16_pred(planes + w + x, pred);
+            v128_t b = vldr_u8_widen_u16_pred(planes + (w * 2) + x, pred);
+            v128_t pixels = vorr_u32(vlsl_u16(r, 11), vorr_u32(vlsl_u16(g, 5), b));
+            vstr_u16_pred(buf_row_ptr + x, pixels, pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_rgb565(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y >= ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, (y - ksize)),
+                   buf + (((y - ksize) % brows) * w), w * sizeof(uint16_t));
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w * sizeof(uint16_t));
+    }
+
+    uma_free(buf);
+    uma_free(planes);
+    uma_free(ring);
+}
+
 void imlib_median_filter(image_t *img, const int ksize, float percentile, bool threshold, int offset, bool invert,
                          image_t *mask) {
     int brows = ksize + 1;
@@ -419,7 +809,7 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
 
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
             int sum = 0;
 
             for (int y = 0, yy = img->h; y < yy; y++) {
@@ -482,8 +872,14 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            uint8_t *data = uma_malloc(64, UMA_DTCM);
+            if (!mask && (ksize >= 1) && (ksize <= MEDIAN_SIMD_MAX_KSIZE) &&
+                (median_cutoff >= 1) && (median_cutoff <= n)) {
+                median_filter_grayscale_simd(img, ksize, median_cutoff, threshold, offset, invert);
+                break;
+            }
+
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *data = uma_malloc(64, UMA_DTCM | UMA_SCRATCH);
             uint8_t pixel;
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -553,10 +949,16 @@ void imlib_median_filter(image_t *img, const int ksize, float percentile, bool t
             break;
         }
         case PIXFORMAT_RGB565: {
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            uint8_t *r_data = uma_malloc(32, UMA_DTCM);
-            uint8_t *g_data = uma_malloc(64, UMA_DTCM);
-            uint8_t *b_data = uma_malloc(32, UMA_DTCM);
+            if (!mask && (ksize >= 1) && (ksize <= MEDIAN_SIMD_MAX_KSIZE) &&
+                (median_cutoff >= 1) && (median_cutoff <= n)) {
+                median_filter_rgb565_simd(img, ksize, median_cutoff, threshold, offset, invert);
+                break;
+            }
+
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *r_data = uma_malloc(32, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *g_data = uma_malloc(64, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *b_data = uma_malloc(32, UMA_DTCM | UMA_SCRATCH);
             uint8_t r, g, b;
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -672,7 +1074,7 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
     const uint8_t n2 = (((ksize * 2) + 1) * ((ksize * 2) + 1)) / 2;
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
             int bins = 0;
 
             for (int y = 0, yy = img->h; y < yy; y++) {
@@ -735,8 +1137,8 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            uint8_t *bins = uma_malloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1), UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *bins = uma_malloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1), UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -826,10 +1228,10 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
             break;
         }
         case PIXFORMAT_RGB565: {
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            uint8_t *r_bins = uma_malloc((COLOR_R5_MAX - COLOR_R5_MIN + 1), UMA_DTCM);
-            uint8_t *g_bins = uma_malloc((COLOR_G6_MAX - COLOR_G6_MIN + 1), UMA_DTCM);
-            uint8_t *b_bins = uma_malloc((COLOR_B5_MAX - COLOR_B5_MIN + 1), UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            uint8_t *r_bins = uma_malloc((COLOR_R5_MAX - COLOR_R5_MIN + 1), UMA_DTCM | UMA_SCRATCH);
+            uint8_t *g_bins = uma_malloc((COLOR_G6_MAX - COLOR_G6_MIN + 1), UMA_DTCM | UMA_SCRATCH);
+            uint8_t *b_bins = uma_malloc((COLOR_B5_MAX - COLOR_B5_MIN + 1), UMA_DTCM | UMA_SCRATCH);
             int r_pixel, g_pixel, b_pixel;
 
             for (int y = 0, yy = img->h; y < yy; y++) {
@@ -984,6 +1386,163 @@ void imlib_mode_filter(image_t *img, const int ksize, bool threshold, int offset
 #endif // IMLIB_ENABLE_MODE
 
 #ifdef IMLIB_ENABLE_MIDPOINT
+// The vectorized path is separable: the min/max over the kernel rows is computed first, padded, and
+// then reduced horizontally. The bias is applied with a table gather.
+static void midpoint_filter_grayscale_simd(image_t *img, int ksize, uint8_t *bias_table,
+                                           bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    int brows = ksize + 1;
+    int pw = w + (ksize * 2);
+    uint8_t *min_row = uma_malloc(pw * 2, UMA_DTCM | UMA_SCRATCH);
+    uint8_t *max_row = min_row + pw;
+    uint8_t *buf = uma_malloc(w * brows, UMA_DTCM | UMA_SCRATCH);
+
+    for (int y = 0; y < h; y++) {
+        imlib_poll_events();
+        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+        uint8_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        for (int x = 0; x < w; x += UINT8_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_8(w - x);
+            v128_t min = vdup_u8(COLOR_GRAYSCALE_MAX);
+            v128_t max = vdup_u8(COLOR_GRAYSCALE_MIN);
+
+            for (int j = -ksize; j <= ksize; j++) {
+                int y_j = IM_CLAMP(y + j, 0, (h - 1));
+                v128_t pixels = vldr_u8_pred(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y_j) + x, pred);
+                min = vmin_u8(min, pixels);
+                max = vmax_u8(max, pixels);
+            }
+
+            vstr_u8_pred(min_row + ksize + x, min, pred);
+            vstr_u8_pred(max_row + ksize + x, max, pred);
+        }
+
+        filter_pad_row_u8(min_row + ksize, w, ksize);
+        filter_pad_row_u8(max_row + ksize, w, ksize);
+
+        for (int x = 0; x < w; x += UINT8_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_8(w - x);
+            v128_t min = vldr_u8_pred(min_row + x, pred);
+            v128_t max = vldr_u8_pred(max_row + x, pred);
+
+            for (int i = 1, ii = ksize * 2; i <= ii; i++) {
+                min = vmin_u8(min, vldr_u8_pred(min_row + x + i, pred));
+                max = vmax_u8(max, vldr_u8_pred(max_row + x + i, pred));
+            }
+
+            v128_t pixels = vadd_u8(min, vldr_u8_gather(bias_table, vsub_u8(max, min)));
+            vstr_u8_pred(buf_row_ptr + x, pixels, pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_grayscale(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y >= ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, (y - ksize)),
+                   buf + (((y - ksize) % brows) * w), w);
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w);
+    }
+
+    uma_free(buf);
+    uma_free(min_row);
+}
+
+static void midpoint_filter_rgb565_simd(image_t *img, int ksize, uint8_t *bias_table,
+                                        bool threshold, int offset, bool invert) {
+    int w = img->w, h = img->h;
+    int brows = ksize + 1;
+    int pw = w + (ksize * 2);
+    // Per channel min/max rows: r_min, g_min, b_min, r_max, g_max, b_max.
+    uint16_t *rows = uma_malloc(pw * sizeof(uint16_t) * 6, UMA_DTCM | UMA_SCRATCH);
+    uint16_t *buf = uma_malloc(w * brows * sizeof(uint16_t), UMA_DTCM | UMA_SCRATCH);
+
+    for (int y = 0; y < h; y++) {
+        imlib_poll_events();
+        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
+        uint16_t *buf_row_ptr = buf + ((y % brows) * w);
+
+        for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_16(w - x);
+            v128_t r_min = vdup_u16(COLOR_R5_MAX), r_max = vdup_u16(COLOR_R5_MIN);
+            v128_t g_min = vdup_u16(COLOR_G6_MAX), g_max = vdup_u16(COLOR_G6_MIN);
+            v128_t b_min = vdup_u16(COLOR_B5_MAX), b_max = vdup_u16(COLOR_B5_MIN);
+
+            for (int j = -ksize; j <= ksize; j++) {
+                int y_j = IM_CLAMP(y + j, 0, (h - 1));
+                v128_t pixels = vldr_u16_pred(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y_j) + x, pred);
+                v128_t r = vlsr_u16(pixels, 11);
+                v128_t g = vand_u32(vlsr_u16(pixels, 5), vdup_u16(0x3F));
+                v128_t b = vand_u32(pixels, vdup_u16(0x1F));
+                r_min = vmin_u16(r_min, r);
+                r_max = vmax_u16(r_max, r);
+                g_min = vmin_u16(g_min, g);
+                g_max = vmax_u16(g_max, g);
+                b_min = vmin_u16(b_min, b);
+                b_max = vmax_u16(b_max, b);
+            }
+
+            vstr_u16_pred(rows + (pw * 0) + ksize + x, r_min, pred);
+            vstr_u16_pred(rows + (pw * 1) + ksize + x, g_min, pred);
+            vstr_u16_pred(rows + (pw * 2) + ksize + x, b_min, pred);
+            vstr_u16_pred(rows + (pw * 3) + ksize + x, r_max, pred);
+            vstr_u16_pred(rows + (pw * 4) + ksize + x, g_max, pred);
+            vstr_u16_pred(rows + (pw * 5) + ksize + x, b_max, pred);
+        }
+
+        for (int i = 0; i < 6; i++) {
+            filter_pad_row_u16(rows + (pw * i) + ksize, w, ksize);
+        }
+
+        for (int x = 0; x < w; x += UINT16_VECTOR_SIZE) {
+            v128_predicate_t pred = vpredicate_16(w - x);
+            v128_t channels[3];
+
+            for (int c = 0; c < 3; c++) {
+                uint16_t *c_min_row = rows + (pw * c) + x;
+                uint16_t *c_max_row = rows + (pw * (c + 3)) + x;
+                v128_t min = vldr_u16_pred(c_min_row, pred);
+                v128_t max = vldr_u16_pred(c_max_row, pred);
+
+                for (int i = 1, ii = ksize * 2; i <= ii; i++) {
+                    min = vmin_u16(min, vldr_u16_pred(c_min_row + i, pred));
+                    max = vmax_u16(max, vldr_u16_pred(c_max_row + i, pred));
+                }
+
+                channels[c] = vadd_u16(min, vldr_u8_widen_u16_gather(bias_table, vsub_u16(max, min)));
+            }
+
+            v128_t pixels = vorr_u32(vlsl_u16(channels[0], 11), vorr_u32(vlsl_u16(channels[1], 5), channels[2]));
+            vstr_u16_pred(buf_row_ptr + x, pixels, pred);
+        }
+
+        if (threshold) {
+            filter_threshold_row_rgb565(buf_row_ptr, row_ptr, w, offset, invert);
+        }
+
+        if (y >= ksize) {
+            // Transfer buffer lines...
+            memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, (y - ksize)),
+                   buf + (((y - ksize) % brows) * w), w * sizeof(uint16_t));
+        }
+    }
+
+    // Copy any remaining lines from the buffer image...
+    for (int y = IM_MAX(h - ksize, 0); y < h; y++) {
+        memcpy(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y), buf + ((y % brows) * w), w * sizeof(uint16_t));
+    }
+
+    uma_free(buf);
+    uma_free(rows);
+}
+
 void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool threshold, int offset, bool invert, image_t *mask) {
     int brows = ksize + 1;
     image_t buf;
@@ -993,14 +1552,14 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
     uint8_t *u8BiasTable;
     float max_bias = bias, min_bias = 1.0f - bias;
 
-    u8BiasTable = uma_malloc(256, UMA_DTCM);
+    u8BiasTable = uma_malloc(256, UMA_DTCM | UMA_SCRATCH);
     for (int i = 0; i < 256; i++) {
         u8BiasTable[i] = (uint8_t) fast_floorf((float) i * bias);
     }
 
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -1070,7 +1629,12 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            if (!mask) {
+                midpoint_filter_grayscale_simd(img, ksize, u8BiasTable, threshold, offset, invert);
+                break;
+            }
+
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -1091,7 +1655,8 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(k_row_ptr, x + k);
                                 if (pixel < min) {
                                     min = pixel;
-                                } else if (pixel > max) {
+                                }
+                                if (pixel > max) {
                                     max = pixel;
                                 }
                             }
@@ -1106,7 +1671,8 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(k_row_ptr, x_k);
                                 if (pixel < min) {
                                     min = pixel;
-                                } else if (pixel > max) {
+                                }
+                                if (pixel > max) {
                                     max = pixel;
                                 }
                             }
@@ -1145,7 +1711,12 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
             break;
         }
         case PIXFORMAT_RGB565: {
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            if (!mask) {
+                midpoint_filter_rgb565_simd(img, ksize, u8BiasTable, threshold, offset, invert);
+                break;
+            }
+
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0, yy = img->h; y < yy; y++) {
                 imlib_poll_events();
@@ -1171,17 +1742,20 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int b_pixel = COLOR_RGB565_TO_B5(pixel);
                                 if (r_pixel < r_min) {
                                     r_min = r_pixel;
-                                } else if (r_pixel > r_max) {
+                                }
+                                if (r_pixel > r_max) {
                                     r_max = r_pixel;
                                 }
                                 if (g_pixel < g_min) {
                                     g_min = g_pixel;
-                                } else if (g_pixel > g_max) {
+                                }
+                                if (g_pixel > g_max) {
                                     g_max = g_pixel;
                                 }
                                 if (b_pixel < b_min) {
                                     b_min = b_pixel;
-                                } else if (b_pixel > b_max) {
+                                }
+                                if (b_pixel > b_max) {
                                     b_max = b_pixel;
                                 }
                             }
@@ -1199,17 +1773,20 @@ void imlib_midpoint_filter(image_t *img, const int ksize, float bias, bool thres
                                 int b_pixel = COLOR_RGB565_TO_B5(pixel);
                                 if (r_pixel < r_min) {
                                     r_min = r_pixel;
-                                } else if (r_pixel > r_max) {
+                                }
+                                if (r_pixel > r_max) {
                                     r_max = r_pixel;
                                 }
                                 if (g_pixel < g_min) {
                                     g_min = g_pixel;
-                                } else if (g_pixel > g_max) {
+                                }
+                                if (g_pixel > g_max) {
                                     g_max = g_pixel;
                                 }
                                 if (b_pixel < b_min) {
                                     b_min = b_pixel;
-                                } else if (b_pixel > b_max) {
+                                }
+                                if (b_pixel > b_max) {
                                     b_max = b_pixel;
                                 }
                             }
@@ -1281,7 +1858,7 @@ void imlib_morph(image_t *img,
 
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             for (int y = 0; y < img->h; y++) {
                 imlib_poll_events();
@@ -1347,7 +1924,7 @@ void imlib_morph(image_t *img,
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             #if defined(ARM_MATH_DSP)
             int32_t krn_4, krn_2_0, krn_5_3, krn_8_6, krn_7_1, offset_int, invert_ge, invert_lt;
@@ -1526,7 +2103,7 @@ void imlib_morph(image_t *img,
             break;
         }
         case PIXFORMAT_RGB565: {
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
 
             #if defined(ARM_MATH_DSP)
             int32_t krn_5, krn_1_0, krn_4_3, krn_7_6, krn_8_2, offset_int, invert_ge, invert_lt;
@@ -1806,7 +2383,7 @@ void imlib_bilateral_filter(image_t *img,
 
     switch (img->pixfmt) {
         case PIXFORMAT_BINARY: {
-            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_BINARY_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
             float gi_lut_buf[(COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1) * 2];
             float *gi_lut = &gi_lut_buf[1];
             float max_color = IM_DIV(1.0f, COLOR_BINARY_MAX - COLOR_BINARY_MIN);
@@ -1815,7 +2392,7 @@ void imlib_bilateral_filter(image_t *img,
             }
 
             int n = (ksize * 2) + 1;
-            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM);
+            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM | UMA_SCRATCH);
 
             float max_space = IM_DIV(1.0f, distance(ksize, ksize));
             for (int y = -ksize; y <= ksize; y++) {
@@ -1884,8 +2461,8 @@ void imlib_bilateral_filter(image_t *img,
             break;
         }
         case PIXFORMAT_GRAYSCALE: {
-            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            float *gi_lut_ptr = uma_malloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(float) * 2, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_GRAYSCALE_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            float *gi_lut_ptr = uma_malloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(float) * 2, UMA_DTCM | UMA_SCRATCH);
             float *gi_lut = &gi_lut_ptr[256]; // point to the middle
             float max_color = IM_DIV(1.0f, COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN);
             for (int i = COLOR_GRAYSCALE_MIN; i <= COLOR_GRAYSCALE_MAX; i++) {
@@ -1893,7 +2470,7 @@ void imlib_bilateral_filter(image_t *img,
             }
 
             int n = (ksize * 2) + 1;
-            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM);
+            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM | UMA_SCRATCH);
 
             float max_space = IM_DIV(1.0f, distance(ksize, ksize));
             for (int y = -ksize; y <= ksize; y++) {
@@ -1975,9 +2552,9 @@ void imlib_bilateral_filter(image_t *img,
             break;
         }
         case PIXFORMAT_RGB565: {
-            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM);
-            float *rb_gi_ptr = uma_malloc((COLOR_R5_MAX - COLOR_R5_MIN + 1) * sizeof(float) * 2, UMA_DTCM);
-            float *g_gi_ptr = uma_malloc((COLOR_G6_MAX - COLOR_G6_MIN + 1) * sizeof(float) * 2, UMA_DTCM);
+            buf.data = uma_malloc(IMAGE_RGB565_LINE_LEN_BYTES(img) * brows, UMA_DTCM | UMA_SCRATCH);
+            float *rb_gi_ptr = uma_malloc((COLOR_R5_MAX - COLOR_R5_MIN + 1) * sizeof(float) * 2, UMA_DTCM | UMA_SCRATCH);
+            float *g_gi_ptr = uma_malloc((COLOR_G6_MAX - COLOR_G6_MIN + 1) * sizeof(float) * 2, UMA_DTCM | UMA_SCRATCH);
             float *rb_gi_lut = &rb_gi_ptr[32]; // center
             float *g_gi_lut = &g_gi_ptr[64];
 
@@ -1992,7 +2569,7 @@ void imlib_bilateral_filter(image_t *img,
             }
 
             int n = (ksize * 2) + 1;
-            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM);
+            float *gs_lut = uma_malloc(n * n * sizeof(float), UMA_DTCM | UMA_SCRATCH);
 
             float max_space = IM_DIV(1.0f, distance(ksize, ksize));
             for (int y = -ksize; y <= ksize; y++) {
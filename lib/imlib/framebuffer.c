@@ -24,13 +24,17 @@
  * Framebuffer functions.
  */
 #include <stdio.h>
+#include <math.h>
 #include "py/mphal.h"
+#include "py/nlr.h"
 #include "mpprint.h"
 #include "fmath.h"
 #include "framebuffer.h"
 #include "board_config.h"
 #include "omv_protocol.h"
 #include "umalloc.h"
+#include "omv_cycles.h"
+#include "trace.h"
 
 // Streaming buffer memory
 extern char _sb_memory_start;
@@ -73,6 +77,8 @@ void framebuffer_init(framebuffer_t *fb, void *buff, size_t size, bool dynamic,
     fb->raw_enabled = false;
     #endif
     fb->quality = ((OMV_JPEG_QUALITY_HIGH - OMV_JPEG_QUALITY_LOW) / 2) + OMV_JPEG_QUALITY_LOW;
+    fb->meta.exposure_us = -1;
+    fb->meta.gain_db = NAN;
     mutex_init0(&fb->lock);
 }
 
@@ -135,6 +141,7 @@ void framebuffer_flush(framebuffer_t *fb) {
 
     // Drop all frame buffers.
     if (fb->buf_count) {
+        fb->stats.flushed += queue_size(fb->used_queue);
         queue_flush(fb->free_queue);
         queue_flush(fb->used_queue);
     }
@@ -226,6 +233,35 @@ vbuffer_t *framebuffer_acquire(framebuffer_t *fb, uint32_t flags) {
     return buffer;
 }
 
+void framebuffer_begin_frame(framebuffer_t *fb) {
+    fb->meta.start_us = mp_hal_ticks_us();
+}
+
+void framebuffer_reset_stats(framebuffer_t *fb) {
+    memset(&fb->stats, 0, sizeof(fb->stats));
+}
+
+// Stamps a captured frame before it's moved to the used queue.
+static void framebuffer_stamp(framebuffer_t *fb, vbuffer_t *buffer) {
+    vbuffer_meta_t *meta = &fb->meta;
+    size_t depth = queue_size(fb->used_queue);
+
+    meta->seq += 1;
+    meta->end_us = mp_hal_ticks_us();
+
+    // Drivers that don't mark the frame start get the end time.
+    if (!meta->start_us) {
+        meta->start_us = meta->end_us;
+    }
+
+    buffer->meta = *meta;
+    meta->start_us = 0;
+    meta->dropped = 0;
+
+    fb->stats.captured += 1;
+    fb->stats.depth[OMV_MIN(depth, FRAMEBUFFER_DEPTH_BINS - 1)] += 1;
+}
+
 vbuffer_t *framebuffer_release(framebuffer_t *fb, uint32_t flags) {
     vbuffer_t *buffer = NULL;
 
@@ -233,12 +269,21 @@ vbuffer_t *framebuffer_release(framebuffer_t *fb, uint32_t flags) {
         if (fb->buf_count == 2) {
             // Double buffer: Reset but do Not release the buffer.
             vbuffer_t *buffer = queue_pop(fb->free_queue, true);
+            uint32_t dropped = fb->meta.dropped;
+            framebuffer_stamp(fb, buffer);
             framebuffer_reset(buffer);
+            // The next frame carries the dropped frames.
+            fb->meta.dropped = dropped + 1;
+            fb->stats.dropped += 1;
             return NULL;
         } else if (fb->buf_count == 3) {
             // Triple buffer: Swap the old buffer with the latest.
+            vbuffer_t *latest = queue_pop(fb->free_queue, true);
+            framebuffer_stamp(fb, latest);
             vbuffer_t *buffer = queue_swap(fb->used_queue, fb->free_queue);
+            latest->meta.dropped += buffer->meta.dropped + 1;
             framebuffer_reset(buffer);
+            fb->stats.dropped += 1;
             return NULL;
         }
     }
@@ -252,6 +297,7 @@ vbuffer_t *framebuffer_release(framebuffer_t *fb, uint32_t flags) {
             queue_push(fb->free_queue, buffer);
         } else {
             // Move the buffer back to the used queue.
+            framebuffer_stamp(fb, buffer);
             queue_push(fb->used_queue, buffer);
         }
     }
@@ -259,10 +305,7 @@ vbuffer_t *framebuffer_release(framebuffer_t *fb, uint32_t flags) {
     return buffer;
 }
 
-void framebuffer_update_preview(image_t *src) {
-    static int overflow_count = 0;
-    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
-
+static void framebuffer_update_fps(framebuffer_t *fb) {
     // Update FPS tracking (EMA of frame time in ms).
     uint32_t now = mp_hal_ticks_ms();
     if (fb->fps_last_ms) {
@@ -276,19 +319,36 @@ void framebuffer_update_preview(image_t *src) {
         }
     }
     fb->fps_last_ms = now;
+}
 
-    // Check if the streaming buffer is disabled, image is NULL or format is not set.
-    if (!fb->enabled || !src->data || src->pixfmt == PIXFORMAT_INVALID) {
-        return;
-    }
+// Updates the embedded header, unlocks the streaming buffer and notifies the host.
+static void framebuffer_commit_preview(framebuffer_t *fb, bool overflow) {
+    framebuffer_header_t *header = (framebuffer_header_t *) fb->raw_base;
+    header->width = fb->w;
+    header->height = fb->h;
+    header->pixfmt = fb->pixfmt;
+    header->size = fb->is_compressed ? fb->size : fb->bpp;
+    header->offset = sizeof(framebuffer_header_t);
+    header->fps = (fb->fps_frame_time > 0.0f) ? 1000.0f / fb->fps_frame_time : 0.0f;
 
-    // Lock the streaming buffer.
-    if (!mutex_try_lock_fair(&fb->lock, MUTEX_TID_OMV)) {
-        return;
+    // Unlock the streaming buffer.
+    if (overflow) {
+        mutex_init0(&fb->lock);
+    } else {
+        fb->unread = true;
+        mutex_unlock(&fb->lock, MUTEX_TID_OMV);
     }
 
+    #if MICROPY_PY_PROTOCOL
+    omv_protocol_send_event(OMV_PROTOCOL_CHANNEL_ID_STREAM, OMV_PROTOCOL_EVENT_NOTIFY, false);
+    #endif
+}
+
+// Encodes or copies the frame into the locked streaming buffer, returns true on overflow.
+static bool framebuffer_encode_preview(framebuffer_t *fb, image_t *src) {
+    static int overflow_count = 0;
+
     // Reserve space for header at the beginning
-    framebuffer_header_t *header = (framebuffer_header_t *) fb->raw_base;
     uint8_t *frame_data = (uint8_t *) fb->raw_base + sizeof(framebuffer_header_t);
     size_t available_size = fb->raw_size - sizeof(framebuffer_header_t);
     bool overflow = false;
@@ -302,7 +362,7 @@ void framebuffer_update_preview(image_t *src) {
             framebuffer_from_image(fb, src);
             memcpy(frame_data, src->data, src->size);
         }
-        goto exit_cleanup;
+        return overflow;
     }
 
     image_t dst = {
@@ -373,22 +433,208 @@ void framebuffer_update_preview(image_t *src) {
         framebuffer_from_image(fb, &dst);
     }
 
-exit_cleanup:
-    header->width = fb->w;
-    header->height = fb->h;
-    header->pixfmt = fb->pixfmt;
-    header->size = fb->is_compressed ? fb->size : fb->bpp;
-    header->offset = sizeof(framebuffer_header_t);
-    header->fps = (fb->fps_frame_time > 0.0f) ? 1000.0f / fb->fps_frame_time : 0.0f;
+    return overflow;
+}
 
-    // Unlock the streaming buffer.
-    if (overflow) {
+void framebuffer_update_preview(image_t *src) {
+    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
+
+    // A frame updated inline supersedes the staged one.
+    fb->pending = false;
+    framebuffer_update_fps(fb);
+
+    // Check if the streaming buffer is disabled, image is NULL or format is not set.
+    if (!fb->enabled || !src->data || src->pixfmt == PIXFORMAT_INVALID) {
+        return;
+    }
+
+    // Lock the streaming buffer.
+    if (!mutex_try_lock_fair(&fb->lock, MUTEX_TID_OMV)) {
+        return;
+    }
+
+    // Encoding can raise, in which case the trace span is closed and the buffer released.
+    nlr_buf_t nlr;
+    bool overflow;
+    OMV_TRACE_BEGIN("preview");
+    if (nlr_push(&nlr) == 0) {
+        overflow = framebuffer_encode_preview(fb, src);
+        nlr_pop();
+    } else {
+        OMV_TRACE_END("preview");
         mutex_init0(&fb->lock);
+        nlr_jump(nlr.ret_val);
+    }
+    OMV_TRACE_END("preview");
+
+    framebuffer_commit_preview(fb, overflow);
+}
+
+// The compressed size follows the quantization scale, which is s = 5000 / q for q < 50
+// and s = 200 - 2q otherwise. Relative to quality 50 the size is close to sqrt(100 / s).
+static float framebuffer_rate_weight(int quality) {
+    int s = (quality < 50) ? (5000 / quality) : (200 - (quality * 2));
+    return fast_sqrtf(100.0f / IM_MAX(s, 1));
+}
+
+void framebuffer_stage_preview(image_t *src) {
+    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
+    bool raw_stream = src->is_mutable && fb->raw_enabled && fb->raw_w && fb->raw_h;
+
+    // Raw streams, compressed and other formats are still updated inline. So are frames
+    // from drivers that don't poll while waiting, or that didn't get to the last staged
+    // frame, which is dropped for the newer one instead of starving the preview.
+    if (!fb->budget || raw_stream || !fb->polled || fb->pending ||
+        (src->pixfmt != PIXFORMAT_GRAYSCALE && src->pixfmt != PIXFORMAT_RGB565)) {
+        framebuffer_update_preview(src);
+        return;
+    }
+
+    framebuffer_update_fps(fb);
+
+    // Skip the frame if the streaming buffer is disabled, or if the host
+    // didn't read the last frame yet since it would be dropped anyway.
+    if (!fb->enabled || !src->data || fb->unread) {
+        return;
+    }
+
+    // The first half of the buffer holds the compressed frame, the second half the staged one.
+    // The frame is copied rather than handed over: the source is a capture buffer that's
+    // released to the driver right after this call, and holding it until the next poll would
+    // take a buffer out of the capture queue for a whole frame.
+    size_t half = OMV_ALIGN_DOWN(fb->raw_size / 2, FRAMEBUFFER_ALIGNMENT);
+    size_t stage_size = fb->raw_size - half;
+
+    // Scale that's expected to keep the encoder within the budget.
+    float scale = 1.0f;
+    float cycles = fb->rate_cpp * src->w * src->h;
+    if (cycles > fb->budget) {
+        scale = fast_sqrtf(fb->budget / cycles);
+    }
+
+    // Decimate the frame while copying it if it's scaled down 2x or more, or doesn't fit.
+    image_t *dst = &fb->staged;
+    int step = IM_MAX(fast_floorf(1.0f / scale), 1);
+    for (;; step++) {
+        *dst = (image_t) {
+            .w = (src->w + step - 1) / step,
+            .h = (src->h + step - 1) / step,
+            .pixfmt = src->pixfmt,
+            .data = (uint8_t *) fb->raw_base + half,
+        };
+        if (image_size(dst) <= stage_size) {
+            break;
+        }
+    }
+
+    if (step == 1) {
+        memcpy(dst->data, src->data, image_size(src));
+    } else if (src->pixfmt == PIXFORMAT_GRAYSCALE) {
+        for (int y = 0; y < dst->h; y++) {
+            uint8_t *src_row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(src, y * step);
+            uint8_t *dst_row = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y);
+            for (int x = 0; x < dst->w; x++) {
+                dst_row[x] = src_row[x * step];
+            }
+        }
     } else {
-        mutex_unlock(&fb->lock, MUTEX_TID_OMV);
+        for (int y = 0; y < dst->h; y++) {
+            uint16_t *src_row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(src, y * step);
+            uint16_t *dst_row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y);
+            for (int x = 0; x < dst->w; x++) {
+                dst_row[x] = src_row[x * step];
+            }
+        }
     }
 
-    #if MICROPY_PY_PROTOCOL
-    omv_protocol_send_event(OMV_PROTOCOL_CHANNEL_ID_STREAM, OMV_PROTOCOL_EVENT_NOTIFY, false);
-    #endif
+    fb->scale = IM_MIN(scale * step, 1.0f);
+    fb->pending = true;
+}
+
+// Encodes the staged frame into the first half of the locked streaming buffer, returns true on overflow.
+static bool framebuffer_encode_staged(framebuffer_t *fb) {
+    uint32_t start = omv_cycles_now();
+
+    // Apply the rest of the scale, or encode the staged frame as is if there's no memory.
+    image_t src = fb->staged;
+    if (fb->scale < 1.0f) {
+        src.w = IM_MAX(fast_floorf(fb->staged.w * fb->scale), 1);
+        src.h = IM_MAX(fast_floorf(fb->staged.h * fb->scale), 1);
+        src.data = uma_malloc(image_size(&src), UMA_CACHE | UMA_MAYBE);
+        if (src.data) {
+            imlib_draw_image(&src, &fb->staged, 0, 0, fb->scale, fb->scale, NULL, -1, 255, NULL, NULL,
+                             IMAGE_HINT_BILINEAR | IMAGE_HINT_BLACK_BACKGROUND, NULL, NULL, NULL, NULL);
+        } else {
+            src = fb->staged;
+        }
+    }
+
+    size_t half = OMV_ALIGN_DOWN(fb->raw_size / 2, FRAMEBUFFER_ALIGNMENT);
+    size_t available_size = half - sizeof(framebuffer_header_t);
+    size_t pixels = src.w * src.h;
+
+    image_t dst = {
+        .w = src.w,
+        .h = src.h,
+        .pixfmt = PIXFORMAT_JPEG,
+        .size = available_size,
+        .data = (uint8_t *) fb->raw_base + sizeof(framebuffer_header_t)
+    };
+
+    // Use the highest quality that the rate model expects to fit with some headroom.
+    bool big_frame = image_size(&src) > OMV_JPEG_QUALITY_THRESHOLD;
+    int quality = big_frame ? OMV_JPEG_QUALITY_LOW : OMV_JPEG_QUALITY_HIGH;
+    while (quality > 1 && (fb->rate_bpp * pixels * framebuffer_rate_weight(quality)) > (available_size * 0.75f)) {
+        quality--;
+    }
+
+    bool overflow = jpeg_compress(&src, &dst, quality, false, JPEG_SUBSAMPLING_AUTO);
+
+    if (src.data != fb->staged.data) {
+        uma_free(src.data);
+    }
+
+    // Update the rate model.
+    float cpp = (float) (omv_cycles_now() - start) / pixels;
+    fb->rate_cpp = (fb->rate_cpp > 0.0f) ? (fb->rate_cpp * 0.75f + cpp * 0.25f) : cpp;
+
+    if (overflow) {
+        // The model underestimated the size, drop the frame and back off.
+        float bpp = available_size / (pixels * framebuffer_rate_weight(quality));
+        fb->rate_bpp = IM_MIN(IM_MAX(fb->rate_bpp, bpp) * 2.0f, 8.0f);
+        framebuffer_from_image(fb, NULL);
+    } else {
+        float bpp = dst.size / (pixels * framebuffer_rate_weight(quality));
+        fb->rate_bpp = (fb->rate_bpp > 0.0f) ? (fb->rate_bpp * 0.75f + bpp * 0.25f) : bpp;
+        framebuffer_from_image(fb, &dst);
+    }
+
+    return overflow;
+}
+
+void framebuffer_poll_preview(void) {
+    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
+    fb->polled = true;
+
+    if (!fb->pending || !mutex_try_lock_fair(&fb->lock, MUTEX_TID_OMV)) {
+        return;
+    }
+
+    fb->pending = false;
+
+    // Encoding can raise, in which case the trace span is closed and the buffer released.
+    nlr_buf_t nlr;
+    bool overflow;
+    OMV_TRACE_BEGIN("preview_poll");
+    if (nlr_push(&nlr) == 0) {
+        overflow = framebuffer_encode_staged(fb);
+        nlr_pop();
+    } else {
+        OMV_TRACE_END("preview_poll");
+        mutex_init0(&fb->lock);
+        nlr_jump(nlr.ret_val);
+    }
+    OMV_TRACE_END("preview_poll");
+
+    framebuffer_commit_preview(fb, overflow);
 }
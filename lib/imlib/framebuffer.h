@@ -57,6 +57,30 @@ typedef enum {
     FB_FLAG_INVALIDATE  = (1 << 7), // Invalidate buffer when acquired/released.
 } framebuffer_flags_t;
 
+#ifndef FRAMEBUFFER_DEPTH_BINS
+#define FRAMEBUFFER_DEPTH_BINS   (8)
+#endif
+
+// Per-frame capture metadata, stamped when a frame is released to the used queue.
+typedef struct vbuffer_meta {
+    uint32_t seq;           // Frame sequence number, starting from 1.
+    uint32_t start_us;      // Capture start timestamp (VSYNC/first line).
+    uint32_t end_us;        // Capture end timestamp (frame done).
+    int32_t exposure_us;    // Exposure at capture, or -1 if unknown.
+    float gain_db;          // Gain at capture, or NAN if unknown.
+    uint32_t dropped;       // Frames dropped between the previous frame and this one.
+} vbuffer_meta_t;
+
+// Frame counters.
+typedef struct framebuffer_stats {
+    uint32_t captured;      // Frames captured, including the dropped ones.
+    uint32_t dropped;       // Frames dropped or replaced because the used queue was full.
+    uint32_t flushed;       // Frames discarded by a flush (e.g. on abort).
+    uint32_t overflowed;    // Frames that didn't fit in the buffer (e.g. JPEG).
+    // Used queue depth seen by each captured frame, the last bin also counts deeper queues.
+    uint32_t depth[FRAMEBUFFER_DEPTH_BINS];
+} framebuffer_stats_t;
+
 // The frame buffer memory is used for the following:
 //
 // - Buffer queues: If the number of video buffers exceeds 3.
@@ -92,6 +116,16 @@ typedef struct framebuffer {
     char raw_static[queue_calc_size(3) * 2]; // Static memory for small queues.
     uint32_t fps_last_ms;   // Timestamp of last preview update.
     float fps_frame_time;   // Exponential moving average frame time in ms.
+    uint32_t budget;        // Deferred preview encode budget in cycles (0 = encode inline).
+    uint8_t pending;        // A staged preview frame is waiting to be encoded.
+    uint8_t polled;         // The driver polls the preview while waiting for frames.
+    uint8_t unread;         // The host didn't read the last published preview frame yet.
+    float scale;            // Scale left to apply to the staged frame.
+    float rate_cpp;         // Preview rate model: encoder cycles per output pixel.
+    float rate_bpp;         // Preview rate model: output bytes per pixel at quality 50.
+    image_t staged;         // Staged preview frame.
+    vbuffer_meta_t meta;    // Metadata of the frame being captured.
+    framebuffer_stats_t stats; // Frame counters.
 } framebuffer_t;
 
 // Drivers can add more flags:
@@ -107,6 +141,7 @@ typedef enum {
 typedef struct vbuffer {
     int32_t offset;     // Write offset into the buffer (used by some drivers).
     uint32_t flags;     // Flags, see above.
+    vbuffer_meta_t meta; // Capture metadata.
     OMV_ATTR_ALIGNED(uint8_t data[], FRAMEBUFFER_ALIGNMENT);    // Data.
 } vbuffer_t;
 
@@ -168,6 +203,18 @@ vbuffer_t *framebuffer_acquire(framebuffer_t *fb, uint32_t flags);
 // Note: Returns NULL if the buffer was Not released.
 vbuffer_t *framebuffer_release(framebuffer_t *fb, uint32_t flags);
 
+// Marks the start of a new frame capture, called at VSYNC or on the first line.
+void framebuffer_begin_frame(framebuffer_t *fb);
+
+// Counts a frame dropped by a driver because there were no free buffers.
+static inline void framebuffer_drop_frame(framebuffer_t *fb) {
+    fb->meta.dropped += 1;
+    fb->stats.dropped += 1;
+}
+
+// Resets the frame counters, the frame sequence keeps counting.
+void framebuffer_reset_stats(framebuffer_t *fb);
+
 // Reset a vbuffer state.
 static inline void framebuffer_reset(vbuffer_t *buffer) {
     memset(buffer, 0, offsetof(vbuffer_t, data));
@@ -179,7 +226,22 @@ static inline void framebuffer_set_preview(framebuffer_t *fb, uint16_t width, ui
     fb->raw_h = height;
 }
 
+// Set the per-frame cycle budget of the deferred preview encoder, 0 encodes inline.
+static inline void framebuffer_set_preview_budget(framebuffer_t *fb, uint32_t budget) {
+    fb->budget = budget;
+}
+
 // Compress the source image into the streaming buffer if it is mutable
 // and raw preview is disabled, or copy it directly if already compressed.
 void framebuffer_update_preview(image_t *src);
+
+// Copy the source image into the second half of the streaming buffer and
+// defer the compression to framebuffer_poll_preview(). Falls back to
+// framebuffer_update_preview() if the budget is zero, the frame can't be
+// staged, the driver never polls, or the last staged frame wasn't polled.
+// Frames are skipped while the host didn't read the last published one.
+void framebuffer_stage_preview(image_t *src);
+
+// Compress the staged frame, if any. Called while waiting for a new frame.
+void framebuffer_poll_preview(void);
 #endif /* __FRAMEBUFFER_H__ */
@@ -27,14 +27,36 @@
 #if defined(IMLIB_ENABLE_IMAGE_FILE_IO)
 
 #include "file_utils.h"
-#define BLOCK_SIZE    (126) // (2^7) - 2 // (DO NOT CHANGE!)
+#include "umalloc.h"
+
+#define GIF_MIN_CODE_SIZE   (8)
+#define GIF_MAX_CODE_SIZE   (12)
+#define GIF_CLEAR_CODE      (1 << GIF_MIN_CODE_SIZE)
+#define GIF_EOI_CODE        (GIF_CLEAR_CODE + 1)
+#define GIF_FIRST_CODE      (GIF_CLEAR_CODE + 2)
+#define GIF_MAX_CODE        (1 << GIF_MAX_CODE_SIZE)
+#define GIF_HASH_SIZE       (5003) // Prime, about 80% full with GIF_MAX_CODE entries.
+#define GIF_TRANSPARENT     (128)  // First palette entry after the 7-bit colors.
+
+typedef struct gif_lzw {
+    file_t *fp;
+    int32_t *keys;
+    uint16_t *codes;
+    uint32_t bits;
+    int nbits;
+    int code_size;
+    int next_code;
+    int prefix;
+    uint8_t block[256];
+} gif_lzw_t;
 
 void gif_open(file_t *fp, int width, int height, bool color, bool loop) {
     file_write(fp, "GIF89a", 6);
     file_write(fp, (uint16_t []) {width, height}, 4);
-    file_write(fp, (uint8_t []) {0xF6, 0x00, 0x00}, 3);
+    file_write(fp, (uint8_t []) {0xF7, 0x00, 0x00}, 3);
 
-    uint8_t palette[128 * 3];
+    // 128 colors followed by unused entries, one of which marks transparent pixels.
+    uint8_t palette[256 * 3] = {0};
     if (color) {
         for (int i = 0; i < 128; i++) {
             palette[i * 3 + 0] = ((((i & 0x60) >> 5) * 255) + 1.5) / 3;
@@ -59,71 +81,210 @@ void gif_open(file_t *fp, int width, int height, bool color, bool loop) {
 
 }
 
-void gif_add_frame(file_t *fp, image_t *img, uint16_t delay) {
-    if (delay) {
-        file_write(fp, (uint8_t []) {'!', 0xF9, 0x04, 0x04}, 4);
-        file_write_short(fp, delay);
-        file_write_short(fp, 0); // end
+// Converts pixels [x_start, x_end) of a row to palette indices, tmp holds a full RGB565 row.
+static void gif_read_row(image_t *img, int x_start, int x_end, int y, uint8_t *dst, uint16_t *tmp) {
+    uint16_t *row = tmp;
+
+    if (IM_IS_GS(img)) {
+        uint8_t *row8 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
+        for (int x = x_start; x < x_end; x++) {
+            dst[x] = row8[x] >> 1;
+        }
+        return;
+    } else if (img->is_bayer) {
+        imlib_debayer_line(0, img->w, y, tmp, PIXFORMAT_RGB565, img);
+    } else if (img->is_yuv) {
+        imlib_deyuv_line(0, img->w, y, tmp, PIXFORMAT_RGB565, img);
+    } else {
+        row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
     }
 
-    file_write_byte(fp, 0x2C);
-    file_write_long(fp, 0);
-    file_write(fp, (uint16_t []) {img->w, img->h}, 4);
-    file_write(fp, (uint8_t []) {0x00, 0x07}, 2); // 7-bits
+    for (int x = x_start; x < x_end; x++) {
+        uint16_t pixel = row[x];
+        uint16_t r = COLOR_RGB565_TO_R5(pixel) >> 3;
+        uint16_t g = COLOR_RGB565_TO_G6(pixel) >> 3;
+        uint16_t b = COLOR_RGB565_TO_B5(pixel) >> 3;
+        dst[x] = (r << 5) | (g << 2) | b;
+    }
+}
 
-    int bytes = img->h * img->w;
-    int blocks = (bytes + BLOCK_SIZE - 1) / BLOCK_SIZE;
+static void gif_lzw_reset(gif_lzw_t *lzw) {
+    memset(lzw->keys, 0xFF, GIF_HASH_SIZE * sizeof(int32_t));
+    lzw->code_size = GIF_MIN_CODE_SIZE + 1;
+    lzw->next_code = GIF_FIRST_CODE;
+}
 
-    // 2 bytes header (length + clear code) + up to BLOCK_SIZE data bytes
-    uint8_t blk_buf[2 + BLOCK_SIZE];
+// Appends a code to the data sub-blocks. Like the decoder, the code size grows once the
+// next free code no longer fits, which the decoder sees one code later.
+static void gif_lzw_write(gif_lzw_t *lzw, int code) {
+    lzw->bits |= code << lzw->nbits;
+    lzw->nbits += lzw->code_size;
 
-    if (IM_IS_GS(img)) {
-        for (int y = 0; y < blocks; y++) {
-            int block_size = IM_MIN(BLOCK_SIZE, bytes - (y * BLOCK_SIZE));
-            blk_buf[0] = 1 + block_size;
-            blk_buf[1] = 0x80; // clear code
-            for (int x = 0; x < block_size; x++) {
-                blk_buf[2 + x] = img->data[(y * BLOCK_SIZE) + x] >> 1;
-            }
-            file_write(fp, blk_buf, 2 + block_size);
+    while (lzw->nbits >= 8) {
+        lzw->block[++lzw->block[0]] = lzw->bits;
+        lzw->bits >>= 8;
+        lzw->nbits -= 8;
+        if (lzw->block[0] == 255) {
+            file_write(lzw->fp, lzw->block, 256);
+            lzw->block[0] = 0;
+        }
+    }
+
+    if ((lzw->next_code >= (1 << lzw->code_size)) && (lzw->code_size < GIF_MAX_CODE_SIZE)) {
+        lzw->code_size += 1;
+    }
+}
+
+static void gif_lzw_init(gif_lzw_t *lzw, file_t *fp) {
+    lzw->fp = fp;
+    lzw->keys = uma_malloc(GIF_HASH_SIZE * (sizeof(int32_t) + sizeof(uint16_t)), UMA_FAST);
+    lzw->codes = (uint16_t *) (lzw->keys + GIF_HASH_SIZE);
+    lzw->bits = 0;
+    lzw->nbits = 0;
+    lzw->prefix = -1;
+    lzw->block[0] = 0;
+
+    file_write_byte(fp, GIF_MIN_CODE_SIZE);
+    gif_lzw_reset(lzw);
+    gif_lzw_write(lzw, GIF_CLEAR_CODE);
+}
+
+static void gif_lzw_put(gif_lzw_t *lzw, int pixel) {
+    if (lzw->prefix < 0) {
+        lzw->prefix = pixel;
+        return;
+    }
+
+    // Look up prefix + pixel with double hashing.
+    int32_t key = (lzw->prefix << 8) | pixel;
+    int h = ((pixel << 4) ^ lzw->prefix) % GIF_HASH_SIZE;
+    int step = h ? (GIF_HASH_SIZE - h) : 1;
+
+    while (lzw->keys[h] >= 0) {
+        if (lzw->keys[h] == key) {
+            lzw->prefix = lzw->codes[h];
+            return;
         }
-    } else if (IM_IS_RGB565(img)) {
-        for (int y = 0; y < blocks; y++) {
-            int block_size = IM_MIN(BLOCK_SIZE, bytes - (y * BLOCK_SIZE));
-            blk_buf[0] = 1 + block_size;
-            blk_buf[1] = 0x80; // clear code
-            for (int x = 0; x < block_size; x++) {
-                uint16_t pixel = ((uint16_t *) img->data)[(y * BLOCK_SIZE) + x];
-                uint16_t r = COLOR_RGB565_TO_R5(pixel) >> 3;
-                uint16_t g = COLOR_RGB565_TO_G6(pixel) >> 3;
-                uint16_t b = COLOR_RGB565_TO_B5(pixel) >> 3;
-                blk_buf[2 + x] = (r << 5) | (g << 2) | b;
+        if ((h -= step) < 0) {
+            h += GIF_HASH_SIZE;
+        }
+    }
+
+    gif_lzw_write(lzw, lzw->prefix);
+
+    if (lzw->next_code < GIF_MAX_CODE) {
+        lzw->keys[h] = key;
+        lzw->codes[h] = lzw->next_code++;
+    } else {
+        // The dictionary is full, start over.
+        gif_lzw_write(lzw, GIF_CLEAR_CODE);
+        gif_lzw_reset(lzw);
+    }
+
+    lzw->prefix = pixel;
+}
+
+static void gif_lzw_finish(gif_lzw_t *lzw) {
+    if (lzw->prefix >= 0) {
+        gif_lzw_write(lzw, lzw->prefix);
+    }
+    gif_lzw_write(lzw, GIF_EOI_CODE);
+
+    if (lzw->nbits) {
+        lzw->block[++lzw->block[0]] = lzw->bits;
+    }
+    if (lzw->block[0]) {
+        file_write(lzw->fp, lzw->block, lzw->block[0] + 1);
+    }
+    file_write_byte(lzw->fp, 0x00); // block terminator
+
+    uma_free(lzw->keys);
+}
+
+// prev is NULL or a w * h buffer holding the palette indices of the last frame. With it,
+// frames after the first only encode the rectangle that changed since the last frame.
+void gif_add_frame(file_t *fp, image_t *img, uint16_t delay, uint8_t *prev, gif_stats_t *stats) {
+    size_t start = file_tell(fp);
+    uint8_t *row = uma_malloc(img->w * (sizeof(uint8_t) + sizeof(uint16_t)), UMA_FAST);
+    uint16_t *tmp = (uint16_t *) (row + img->w);
+    rectangle_t rect = {0, 0, img->w, img->h};
+    bool delta = prev && stats && stats->frames;
+
+    if (delta) {
+        // Only the bounding box of the pixels that changed since the last frame is written.
+        int x0 = img->w, x1 = -1, y0 = img->h, y1 = -1;
+        for (int y = 0; y < img->h; y++) {
+            uint8_t *prev_row = prev + (y * img->w);
+            gif_read_row(img, 0, img->w, y, row, tmp);
+
+            int x = 0, x_end = img->w - 1;
+            while ((x < img->w) && (row[x] == prev_row[x])) {
+                x++;
+            }
+            if (x == img->w) {
+                continue;
+            }
+            while (row[x_end] == prev_row[x_end]) {
+                x_end--;
             }
-            file_write(fp, blk_buf, 2 + block_size);
+
+            x0 = IM_MIN(x0, x);
+            x1 = IM_MAX(x1, x_end);
+            y0 = IM_MIN(y0, y);
+            y1 = y;
+        }
+
+        if (x1 >= 0) {
+            rect = (rectangle_t) {x0, y0, x1 - x0 + 1, y1 - y0 + 1};
+        } else {
+            // Nothing changed, a single transparent pixel still carries the delay.
+            rect = (rectangle_t) {0, 0, 1, 1};
         }
-    } else if (img->is_bayer || img->is_yuv) {
-        for (int y = 0; y < blocks; y++) {
-            int block_size = IM_MIN(BLOCK_SIZE, bytes - (y * BLOCK_SIZE));
-            blk_buf[0] = 1 + block_size;
-            blk_buf[1] = 0x80; // clear code
-            uint16_t pixels[block_size];
-            if (img->is_bayer) {
-                imlib_debayer_line(0, block_size, y, pixels, PIXFORMAT_RGB565, img);
-            } else {
-                imlib_deyuv_line(0, block_size, y, pixels, PIXFORMAT_RGB565, img);
+    }
+
+    if (delay || delta) {
+        // Frames are not disposed, unchanged pixels are transparent in delta frames.
+        file_write(fp, (uint8_t []) {'!', 0xF9, 0x04, delta ? 0x05 : 0x04}, 4);
+        file_write_short(fp, delay);
+        file_write(fp, (uint8_t []) {delta ? GIF_TRANSPARENT : 0x00, 0x00}, 2);
+    }
+
+    file_write_byte(fp, 0x2C);
+    file_write(fp, (uint16_t []) {rect.x, rect.y, rect.w, rect.h}, 8);
+    file_write_byte(fp, 0x00);
+
+    gif_lzw_t lzw;
+    gif_lzw_init(&lzw, fp);
+
+    for (int y = rect.y; y < (rect.y + rect.h); y++) {
+        gif_read_row(img, rect.x, rect.x + rect.w, y, row, tmp);
+
+        if (!prev) {
+            for (int x = rect.x; x < (rect.x + rect.w); x++) {
+                gif_lzw_put(&lzw, row[x]);
             }
-            for (int x = 0; x < block_size; x++) {
-                uint16_t pixel = pixels[2];
-                uint16_t r = COLOR_RGB565_TO_R5(pixel) >> 3;
-                uint16_t g = COLOR_RGB565_TO_G6(pixel) >> 3;
-                uint16_t b = COLOR_RGB565_TO_B5(pixel) >> 3;
-                blk_buf[2 + x] = (r << 5) | (g << 2) | b;
+        } else {
+            uint8_t *prev_row = prev + (y * img->w);
+            for (int x = rect.x; x < (rect.x + rect.w); x++) {
+                if (delta && (row[x] == prev_row[x])) {
+                    gif_lzw_put(&lzw, GIF_TRANSPARENT);
+                } else {
+                    gif_lzw_put(&lzw, row[x]);
+                    prev_row[x] = row[x];
+                }
             }
-            file_write(fp, blk_buf, 2 + block_size);
         }
     }
 
-    file_write(fp, (uint8_t []) {0x01, 0x81, 0x00}, 3); // end code
+    gif_lzw_finish(&lzw);
+    uma_free(row);
+
+    if (stats) {
+        stats->frames += 1;
+        stats->pixels += img->w * img->h;
+        stats->encoded_pixels += rect.w * rect.h;
+        stats->bytes += file_tell(fp) - start;
+    }
 }
 
 void gif_close(file_t *fp) {
@@ -34,60 +34,151 @@
 #endif
 
 #include "imlib.h"
+#include "simd.h"
 
 #ifdef IMLIB_ENABLE_FEATURES
-static int eval_weak_classifier(cascade_t *cascade, point_t pt, int t_idx, int w_idx, int r_idx) {
-    int32_t sumw = 0;
-    mw_image_t *sum = cascade->sum;
+// The windows of a row that are still running the cascade. Windows are evaluated
+// in parallel, one per vector lane, and compacted after each stage.
+typedef struct haar_lanes {
+    int n;                          // Number of active windows.
+    uint32_t *x;                    // Windows x offsets.
+    int32_t *std;                   // Windows standard deviations.
+    int32_t *sum;                   // Windows stage sums.
+} haar_lanes_t;
+
+static void haar_init_lanes(cascade_t *cascade, haar_lanes_t *lanes, int x2) {
+    int win_w = cascade->window.w;
+    int win_h = cascade->window.h;
+    uint32_t n = (win_w * win_h);
 
-    /* The node threshold is multiplied by the standard deviation of the sub window */
-    int32_t t = cascade->tree_thresh_array[t_idx] * cascade->std;
+    lanes->n = 0;
+    for (int x = 0; x < x2; x += cascade->step) {
+        uint32_t i_s = imlib_integral_mw_lookup(cascade->sum, x, 0, win_w, win_h);
+        uint32_t i_sq = imlib_integral_mw_lookup(cascade->ssq, x, 0, win_w, win_h);
+        uint32_t m = i_s / n;
+        uint32_t v = i_sq / n - (m * m);
 
-    for (int i = 0; i < cascade->num_rectangles_array[t_idx]; i++) {
-        int x = cascade->rectangles_array[r_idx + (i << 2) + 0];
-        int y = cascade->rectangles_array[r_idx + (i << 2) + 1];
-        int w = cascade->rectangles_array[r_idx + (i << 2) + 2];
-        int h = cascade->rectangles_array[r_idx + (i << 2) + 3];
-        // Lookup the feature
-        sumw += imlib_integral_mw_lookup(sum, pt.x + x, y, w, h) * (cascade->weights_array[w_idx + i] << 12);
+        // Skip homogeneous regions.
+        if (v < (50 * 50)) {
+            continue;
+        }
+
+        lanes->x[lanes->n] = x;
+        lanes->std[lanes->n] = fast_sqrtf(i_sq * n - (i_s * i_s));
+        lanes->n += 1;
     }
+}
+
+static void haar_run_stage(cascade_t *cascade, haar_lanes_t *lanes, const haar_stage_t *stage,
+                           const haar_feature_t *features) {
+    uint32_t **data = cascade->sum->data;
+
+    for (int i = 0; i < lanes->n; i += UINT32_VECTOR_SIZE) {
+        v128_predicate_t pred = vpredicate_32(lanes->n - i);
+        v128_t offsets = vldr_u32_pred(lanes->x + i, pred);
+        v128_t std = vldr_u32_pred((uint32_t *) lanes->std + i, pred);
+        v128_t stage_sum = vdup_s32(0);
+
+        for (int j = 0; j < stage->n_features; j++) {
+            const haar_feature_t *feature = &features[j];
+            v128_t sumw = vdup_s32(0);
+
+            for (int k = 0; k < feature->n_rects; k++) {
+                const uint8_t *r = feature->rects[k];
+                const uint32_t *row0 = data[r[1]] + r[0];
+                const uint32_t *row1 = data[r[1] + r[3]] + r[0];
+                // Lookup the rectangle corners of all windows.
+                v128_t a = vldr_u32_gather_pred(row0, offsets, pred);
+                v128_t b = vldr_u32_gather_pred(row0 + r[2], offsets, pred);
+                v128_t c = vldr_u32_gather_pred(row1, offsets, pred);
+                v128_t d = vldr_u32_gather_pred(row1 + r[2], offsets, pred);
+                v128_t s = vsub_s32(vsub_s32(vadd_s32(d, a), b), c);
+                sumw = vmla_n_s32(s, feature->weights[k] << 12, sumw);
+            }
 
-    if (sumw >= t) {
-        return cascade->alpha2_array[t_idx];
+            // The feature threshold is multiplied by the standard deviation of the window.
+            v128_t t = vmul_n_s32(std, feature->thresh);
+            stage_sum = vadd_s32(stage_sum, vsel_ge_s32(sumw, t, vdup_s32(feature->alpha2), vdup_s32(feature->alpha1)));
+        }
+
+        vstr_s32(lanes->sum + i, stage_sum);
     }
 
-    return cascade->alpha1_array[t_idx];
+    // Keep the windows that passed the stage, in order.
+    int n = 0;
+    for (int i = 0; i < lanes->n; i++) {
+        // If the sum is below the stage threshold, no objects were detected
+        if (lanes->sum[i] < (cascade->threshold * stage->thresh)) {
+            continue;
+        }
+        lanes->x[n] = lanes->x[i];
+        lanes->std[n] = lanes->std[i];
+        n += 1;
+    }
+    lanes->n = n;
 }
 
-static int run_cascade_classifier(cascade_t *cascade, point_t pt) {
-    int win_w = cascade->window.w;
-    int win_h = cascade->window.h;
-    uint32_t n = (win_w * win_h);
-    uint32_t i_s = imlib_integral_mw_lookup(cascade->sum, pt.x, 0, win_w, win_h);
-    uint32_t i_sq = imlib_integral_mw_lookup(cascade->ssq, pt.x, 0, win_w, win_h);
-    uint32_t m = i_s / n;
-    uint32_t v = i_sq / n - (m * m);
-
-    // Skip homogeneous regions.
-    if (v < (50 * 50)) {
-        return 0;
-    }
+// Runs the cascade over each scale of the image pyramid and appends the detections to objects.
+static void haar_detect_pyramid(image_t *image, cascade_t *cascade, rectangle_t *roi,
+                                haar_lanes_t *lanes, array_t *objects) {
+    mw_image_t *sum = cascade->sum;
+    mw_image_t *ssq = cascade->ssq;
 
-    cascade->std = fast_sqrtf(i_sq * n - (i_s * i_s));
-    for (int i = 0, w_idx = 0, r_idx = 0, t_idx = 0; i < cascade->n_stages; i++) {
-        int stage_sum = 0;
-        for (int j = 0; j < cascade->stages_array[i]; j++, t_idx++) {
-            // Send the shifted window to a haar filter
-            stage_sum += eval_weak_classifier(cascade, pt, t_idx, w_idx, r_idx);
-            w_idx += cascade->num_rectangles_array[t_idx];
-            r_idx += cascade->num_rectangles_array[t_idx] * 4;
+    // Iterate over the image pyramid
+    for (float factor = 1.0f; ; factor *= cascade->scale) {
+        // Set the scaled width and height
+        int szw = roi->w / factor;
+        int szh = roi->h / factor;
+
+        // Break if scaled image is smaller than feature size
+        if (szw < cascade->window.w || szh < cascade->window.h) {
+            break;
         }
-        // If the sum is below the stage threshold, no objects were detected
-        if (stage_sum < (cascade->threshold * cascade->stages_thresh_array[i])) {
-            return 0;
+
+        // Set the integral images scale
+        imlib_integral_mw_scale(roi, sum, szw, szh);
+        imlib_integral_mw_scale(roi, ssq, szw, szh);
+
+        // Compute new scaled integral images
+        imlib_integral_mw_ss(image, sum, ssq, roi);
+
+        // Scale the scanning step
+        cascade->step = cascade->step / factor;
+        cascade->step = (cascade->step == 0) ? 1 : cascade->step;
+
+        // Process image at the current scale
+        // When filter window shifts to borders, some margin need to be kept
+        int y2 = szh - cascade->window.h;
+        int x2 = szw - cascade->window.w;
+
+        // Shift the filter window over the image.
+        for (int y = 0; y < y2; y += cascade->step) {
+            imlib_poll_events();
+
+            // Run all the windows of the row through the cascade, stage by stage,
+            // until no window is left or all the stages have passed.
+            haar_init_lanes(cascade, lanes, x2);
+            const haar_feature_t *features = cascade->features;
+            for (int i = 0; i < cascade->n_stages && lanes->n; i++) {
+                haar_run_stage(cascade, lanes, &cascade->stages[i], features);
+                features += cascade->stages[i].n_features;
+            }
+
+            // Record the coordinates of the windows where an object was detected.
+            for (int i = 0; i < lanes->n; i++) {
+                array_push_back(objects,
+                                rectangle_alloc(fast_roundf(lanes->x[i] * factor) + roi->x,
+                                                fast_roundf(y * factor) + roi->y,
+                                                fast_roundf(cascade->window.w * factor),
+                                                fast_roundf(cascade->window.h * factor)));
+            }
+
+            // If not last line, shift integral images
+            if ((y + cascade->step) < y2) {
+                imlib_integral_mw_shift_ss(image, sum, ssq, roi, cascade->step);
+            }
         }
     }
-    return 1;
 }
 
 array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *roi) {
@@ -120,9 +211,9 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     // Compute the max height needed from all cascade rectangles.
     // Some features extend beyond window.h, so window.h + 1 is not enough.
     int mw_h = cascade->window.h;
-    for (int i = 0, r_idx = 0; i < cascade->n_features; i++) {
-        for (int j = 0; j < cascade->num_rectangles_array[i]; j++, r_idx += 4) {
-            int rh = cascade->rectangles_array[r_idx + 1] + cascade->rectangles_array[r_idx + 3];
+    for (int i = 0; i < cascade->n_features; i++) {
+        for (int j = 0; j < cascade->features[i].n_rects; j++) {
+            int rh = cascade->features[i].rects[j][1] + cascade->features[i].rects[j][3];
             if (rh > mw_h) {
                 mw_h = rh;
             }
@@ -133,54 +224,26 @@ array_t *imlib_detect_objects(image_t *image, cascade_t *cascade, rectangle_t *r
     imlib_integral_mw_alloc(&sum, roi->w, mw_h + 1);
     imlib_integral_mw_alloc(&ssq, roi->w, mw_h + 1);
 
-    // Iterate over the image pyramid
-    for (float factor = 1.0f; ; factor *= cascade->scale) {
-        // Set the scaled width and height
-        int szw = roi->w / factor;
-        int szh = roi->h / factor;
-
-        // Break if scaled image is smaller than feature size
-        if (szw < cascade->window.w || szh < cascade->window.h) {
-            break;
-        }
-
-        // Set the integral images scale
-        imlib_integral_mw_scale(roi, &sum, szw, szh);
-        imlib_integral_mw_scale(roi, &ssq, szw, szh);
-
-        // Compute new scaled integral images
-        imlib_integral_mw_ss(image, &sum, &ssq, roi);
-
-        // Scale the scanning step
-        cascade->step = cascade->step / factor;
-        cascade->step = (cascade->step == 0) ? 1 : cascade->step;
-
-        // Process image at the current scale
-        // When filter window shifts to borders, some margin need to be kept
-        int y2 = szh - cascade->window.h;
-        int x2 = szw - cascade->window.w;
-
-        // Shift the filter window over the image.
-        for (int y = 0; y < y2; y += cascade->step) {
-            imlib_poll_events();
-            for (int x = 0; x < x2; x += cascade->step) {
-                point_t p = {x, y};
-                // If an object is detected, record the coordinates of the filter window
-                if (run_cascade_classifier(cascade, p) > 0) {
-                    array_push_back(objects,
-                                    rectangle_alloc(fast_roundf(x * factor) + roi->x, fast_roundf(y * factor) + roi->y,
-                                                    fast_roundf(cascade->window.w * factor),
-                                                    fast_roundf(cascade->window.h * factor)));
-                }
-            }
-
-            // If not last line, shift integral images
-            if ((y + cascade->step) < y2) {
-                imlib_integral_mw_shift_ss(image, &sum, &ssq, roi, cascade->step);
-            }
-        }
+    // Allocate the row windows in one block, the stage sums are rounded up to a whole vector.
+    haar_lanes_t lanes;
+    lanes.x = uma_malloc(((roi->w * 3) + UINT32_VECTOR_SIZE) * sizeof(uint32_t), 0);
+    lanes.std = (int32_t *) (lanes.x + roi->w);
+    lanes.sum = lanes.std + roi->w;
+
+    // The buffers must not leak if adding a detection raises.
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        haar_detect_pyramid(image, cascade, roi, &lanes, objects);
+        nlr_pop();
+    } else {
+        uma_free(lanes.x);
+        imlib_integral_mw_free(&ssq);
+        imlib_integral_mw_free(&sum);
+        nlr_jump(nlr.ret_val);
     }
 
+    uma_free(lanes.x);
+
     imlib_integral_mw_free(&ssq);
     imlib_integral_mw_free(&sum);
 
@@ -199,6 +262,140 @@ static void *cascade_buffer_read(uint8_t **buf, size_t size) {
     return buf8;
 }
 
+// Converts the legacy cascade arrays to packed stages and features.
+static void cascade_pack_legacy(cascade_t *cascade, const uint8_t *stages_array, const int16_t *stages_thresh_array,
+                                const int16_t *tree_thresh_array, const int16_t *alpha1_array,
+                                const int16_t *alpha2_array, const int8_t *num_rectangles_array,
+                                const int8_t *weights_array, const int8_t *rectangles_array) {
+    haar_stage_t *stages = m_malloc(sizeof(haar_stage_t) * cascade->n_stages);
+    haar_feature_t *features = m_malloc0(sizeof(haar_feature_t) * cascade->n_features);
+
+    for (size_t i = 0; i < cascade->n_stages; i++) {
+        stages[i].n_features = stages_array[i];
+        stages[i].thresh = stages_thresh_array[i];
+    }
+
+    for (size_t i = 0, r_idx = 0; i < cascade->n_features; i++) {
+        if (num_rectangles_array[i] > HAAR_FEATURE_MAX_RECTS) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Too many rectangles per feature"));
+        }
+
+        features[i].thresh = tree_thresh_array[i];
+        features[i].alpha1 = alpha1_array[i];
+        features[i].alpha2 = alpha2_array[i];
+        // Features with a negative number of rectangles have none.
+        features[i].n_rects = IM_MAX(num_rectangles_array[i], 0);
+
+        for (size_t j = 0; j < features[i].n_rects; j++, r_idx++) {
+            features[i].weights[j] = weights_array[r_idx];
+            memcpy(features[i].rects[j], rectangles_array + (r_idx * 4), 4);
+        }
+    }
+
+    cascade->stages = stages;
+    cascade->features = features;
+}
+
+static void cascade_load_legacy_buffer(cascade_t *cascade, uint8_t *buf) {
+    // Set detection window size and the number of stages.
+    cascade->window.w = ((uint32_t *) buf)[0];
+    cascade->window.h = ((uint32_t *) buf)[1];
+    cascade->n_stages = ((uint32_t *) buf)[2];
+    buf += 12;
+
+    // Set the number features in each stages
+    uint8_t *stages_array = cascade_buffer_read(&buf, cascade->n_stages);
+    // Skip alignment
+    if (cascade->n_stages % 4) {
+        buf += 4 - (cascade->n_stages % 4);
+    }
+
+    // Sum the number of features in each stages
+    for (size_t i = 0; i < cascade->n_stages; i++) {
+        cascade->n_features += stages_array[i];
+    }
+
+    // Set features thresh array, alpha1, alpha 2,rects weights and rects
+    int16_t *stages_thresh_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_stages);
+    int16_t *tree_thresh_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
+    int16_t *alpha1_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
+    int16_t *alpha2_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
+    int8_t *num_rectangles_array = cascade_buffer_read(&buf, sizeof(int8_t) * cascade->n_features);
+
+    // Sum the number of rectangles in all features
+    size_t n_rectangles = 0;
+    for (size_t i = 0; i < cascade->n_features; i++) {
+        n_rectangles += num_rectangles_array[i];
+    }
+
+    // Set rectangles weights and rectangles (number of rectangles * 4 points)
+    int8_t *weights_array = cascade_buffer_read(&buf, n_rectangles);
+    int8_t *rectangles_array = cascade_buffer_read(&buf, n_rectangles * 4);
+
+    cascade_pack_legacy(cascade, stages_array, stages_thresh_array, tree_thresh_array, alpha1_array,
+                        alpha2_array, num_rectangles_array, weights_array, rectangles_array);
+}
+
+static void cascade_load_legacy_stream(cascade_t *cascade, mp_obj_t file, int *error) {
+    // Read detection window height and the number of stages (the width was already read).
+    mp_stream_read_exactly(file, &cascade->window.h, sizeof(cascade->window.h), error);
+    mp_stream_read_exactly(file, &cascade->n_stages, sizeof(cascade->n_stages), error);
+
+    // Allocate and read the number of features in each stages
+    uint8_t *stages_array = m_malloc(sizeof(int8_t) * cascade->n_stages);
+    mp_stream_read_exactly(file, stages_array, cascade->n_stages, error);
+    // Skip alignment
+    uint8_t padding[4];
+    if (cascade->n_stages % 4) {
+        mp_stream_read_exactly(file, padding, 4 - (cascade->n_stages % 4), error);
+    }
+
+    // Sum the number of features in each stages
+    for (size_t i = 0; i < cascade->n_stages; i++) {
+        cascade->n_features += stages_array[i];
+    }
+
+    // Alloc features thresh array, alpha1, alpha 2,rects weights and rects
+    int16_t *stages_thresh_array = m_malloc(sizeof(int16_t) * cascade->n_stages);
+    int16_t *tree_thresh_array = m_malloc(sizeof(int16_t) * cascade->n_features);
+    int16_t *alpha1_array = m_malloc(sizeof(int16_t) * cascade->n_features);
+    int16_t *alpha2_array = m_malloc(sizeof(int16_t) * cascade->n_features);
+    int8_t *num_rectangles_array = m_malloc(sizeof(int8_t) * cascade->n_features);
+
+    // Read features thresh array, alpha1, alpha 2,rects weights and rects
+    mp_stream_read_exactly(file, stages_thresh_array, sizeof(int16_t) * cascade->n_stages, error);
+    mp_stream_read_exactly(file, tree_thresh_array, sizeof(int16_t) * cascade->n_features, error);
+    mp_stream_read_exactly(file, alpha1_array, sizeof(int16_t) * cascade->n_features, error);
+    mp_stream_read_exactly(file, alpha2_array, sizeof(int16_t) * cascade->n_features, error);
+    mp_stream_read_exactly(file, num_rectangles_array, cascade->n_features, error);
+
+    // Sum the number of rectangles per feature
+    size_t n_rectangles = 0;
+    for (size_t i = 0; i < cascade->n_features; i++) {
+        n_rectangles += num_rectangles_array[i];
+    }
+
+    // Allocate and read rectangles weights and rectangles (number of rectangles * 4 points)
+    int8_t *weights_array = m_malloc(n_rectangles);
+    int8_t *rectangles_array = m_malloc(n_rectangles * 4);
+    mp_stream_read_exactly(file, weights_array, sizeof(int8_t) * n_rectangles, error);
+    mp_stream_read_exactly(file, rectangles_array, sizeof(int8_t) * n_rectangles * 4, error);
+
+    if (*error == 0) {
+        cascade_pack_legacy(cascade, stages_array, stages_thresh_array, tree_thresh_array, alpha1_array,
+                            alpha2_array, num_rectangles_array, weights_array, rectangles_array);
+    }
+
+    m_free(rectangles_array);
+    m_free(weights_array);
+    m_free(num_rectangles_array);
+    m_free(alpha2_array);
+    m_free(alpha1_array);
+    m_free(tree_thresh_array);
+    m_free(stages_thresh_array);
+    m_free(stages_array);
+}
+
 int imlib_load_cascade_from_file(cascade_t *cascade, const char *path) {
     int error = 0;
     mp_obj_t args[2] = {
@@ -211,93 +408,90 @@ int imlib_load_cascade_from_file(cascade_t *cascade, const char *path) {
     mp_buffer_info_t bufinfo;
     mp_obj_t file = mp_vfs_open(MP_ARRAY_SIZE(args), args, (mp_map_t *) &mp_const_empty_map);
 
-    if (mp_get_buffer(file, &bufinfo, MP_BUFFER_READ)) {
-        uint8_t *buf = (uint8_t *) bufinfo.buf + 12;
-        // Set detection window size and the number of stages.
-        cascade->window.w = ((uint32_t *) bufinfo.buf)[0];
-        cascade->window.h = ((uint32_t *) bufinfo.buf)[1];
-        cascade->n_stages = ((uint32_t *) bufinfo.buf)[2];
-
-        // Set the number features in each stages
-        cascade->stages_array = cascade_buffer_read(&buf, cascade->n_stages);
-        // Skip alignment
-        if ((uint32_t) buf % 4) {
-            buf += 4 - ((uint32_t) buf % 4);
-        }
-
-        // Sum the number of features in each stages
-        for (size_t i = 0; i < cascade->n_stages; i++) {
-            cascade->n_features += cascade->stages_array[i];
+    if (mp_get_buffer(file, &bufinfo, MP_BUFFER_READ) && !((uintptr_t) bufinfo.buf % 4)) {
+        haar_header_t *header = bufinfo.buf;
+        if (bufinfo.len >= sizeof(haar_header_t) && header->magic == HAAR_CASCADE_MAGIC) {
+            // The header counts must fit in the file.
+            if (bufinfo.len < sizeof(haar_header_t) +
+                sizeof(haar_stage_t) * header->n_stages +
+                sizeof(haar_feature_t) * header->n_features) {
+                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid cascade"));
+            }
+            // Packed cascades are used in place.
+            cascade->window.w = header->window_w;
+            cascade->window.h = header->window_h;
+            cascade->n_stages = header->n_stages;
+            cascade->n_features = header->n_features;
+            cascade->stages = (haar_stage_t *) (header + 1);
+            cascade->features = (haar_feature_t *) (cascade->stages + cascade->n_stages);
+        } else {
+            cascade_load_legacy_buffer(cascade, bufinfo.buf);
         }
+    } else {
+        uint32_t magic = 0;
+        mp_stream_read_exactly(file, &magic, sizeof(magic), &error);
+        if (magic == HAAR_CASCADE_MAGIC) {
+            haar_header_t header;
+            // Read the rest of the header.
+            mp_stream_read_exactly(file, &header.window_w, sizeof(header) - sizeof(magic), &error);
+            if (error != 0) {
+                mp_raise_OSError(error);
+            }
 
-        // Set features thresh array, alpha1, alpha 2,rects weights and rects
-        cascade->stages_thresh_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_stages);
-        cascade->tree_thresh_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
-        cascade->alpha1_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
-        cascade->alpha2_array = cascade_buffer_read(&buf, sizeof(int16_t) * cascade->n_features);
-        cascade->num_rectangles_array = cascade_buffer_read(&buf, sizeof(int8_t) * cascade->n_features);
-
-        // Sum the number of rectangles in all features
-        for (size_t i = 0; i < cascade->n_features; i++) {
-            cascade->n_rectangles += cascade->num_rectangles_array[i];
-        }
+            // The header counts must fit in the file before anything is allocated.
+            mp_off_t size = mp_stream_seek(file, 0, MP_SEEK_END, &error);
+            if ((size == (mp_off_t) -1) ||
+                (mp_stream_seek(file, sizeof(header), MP_SEEK_SET, &error) == (mp_off_t) -1)) {
+                mp_raise_OSError(error);
+            }
 
-        // Set rectangles weights and rectangles (number of rectangles * 4 points)
-        cascade->weights_array = cascade_buffer_read(&buf, cascade->n_rectangles);
-        cascade->rectangles_array = cascade_buffer_read(&buf, cascade->n_rectangles * 4);
-    } else {
-        // Read detection window size.
-        mp_stream_read_exactly(file, &cascade->window, sizeof(cascade->window), &error);
-        // Read the number of stages.
-        mp_stream_read_exactly(file, &cascade->n_stages, sizeof(cascade->n_stages), &error);
-
-        // Allocate stages array.
-        cascade->stages_array = m_malloc(sizeof(int8_t) * cascade->n_stages);
-
-        // Read number of features in each stages
-        mp_stream_read_exactly(file, cascade->stages_array, cascade->n_stages, &error);
-        // Skip alignment
-        uint8_t padding[4];
-        if (cascade->n_stages % 4) {
-            mp_stream_read_exactly(file, padding, 4 - (cascade->n_stages % 4), &error);
-        }
+            if ((size_t) size < sizeof(haar_header_t) +
+                sizeof(haar_stage_t) * header.n_stages +
+                sizeof(haar_feature_t) * header.n_features) {
+                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid cascade"));
+            }
 
-        // Sum the number of features in each stages
-        for (size_t i = 0; i < cascade->n_stages; i++) {
-            cascade->n_features += cascade->stages_array[i];
+            cascade->window.w = header.window_w;
+            cascade->window.h = header.window_h;
+            cascade->n_stages = header.n_stages;
+            cascade->n_features = header.n_features;
+
+            // Allocate and read stages and features.
+            haar_stage_t *stages = m_malloc(sizeof(haar_stage_t) * cascade->n_stages);
+            haar_feature_t *features = m_malloc(sizeof(haar_feature_t) * cascade->n_features);
+            mp_stream_read_exactly(file, stages, sizeof(haar_stage_t) * cascade->n_stages, &error);
+            mp_stream_read_exactly(file, features, sizeof(haar_feature_t) * cascade->n_features, &error);
+            cascade->stages = stages;
+            cascade->features = features;
+        } else {
+            // Legacy cascades start with the detection window width.
+            cascade->window.w = magic;
+            cascade_load_legacy_stream(cascade, file, &error);
         }
+    }
 
-        // Alloc features thresh array, alpha1, alpha 2,rects weights and rects
-        cascade->stages_thresh_array = m_malloc(sizeof(int16_t) * cascade->n_stages);
-        cascade->tree_thresh_array = m_malloc(sizeof(int16_t) * cascade->n_features);
-        cascade->alpha1_array = m_malloc(sizeof(int16_t) * cascade->n_features);
-        cascade->alpha2_array = m_malloc(sizeof(int16_t) * cascade->n_features);
-        cascade->num_rectangles_array = m_malloc(sizeof(int8_t) * cascade->n_features);
-
-        // Read features thresh array, alpha1, alpha 2,rects weights and rects
-        mp_stream_read_exactly(file, cascade->stages_thresh_array, sizeof(int16_t) * cascade->n_stages, &error);
-        mp_stream_read_exactly(file, cascade->tree_thresh_array, sizeof(int16_t) * cascade->n_features, &error);
-        mp_stream_read_exactly(file, cascade->alpha1_array, sizeof(int16_t) * cascade->n_features, &error);
-        mp_stream_read_exactly(file, cascade->alpha2_array, sizeof(int16_t) * cascade->n_features, &error);
-        mp_stream_read_exactly(file, cascade->num_rectangles_array, cascade->n_features, &error);
-
-        // Sum the number of rectangles per feature
-        for (size_t i = 0; i < cascade->n_features; i++) {
-            cascade->n_rectangles += cascade->num_rectangles_array[i];
-        }
+    if (error != 0) {
+        mp_raise_OSError(error);
+    }
 
-        // Allocate weights and rectangles arrays.
-        cascade->weights_array = m_malloc(cascade->n_rectangles);
-        cascade->rectangles_array = m_malloc(cascade->n_rectangles * 4);
+    // The stages must use all of the features.
+    size_t n_features = 0;
+    for (size_t i = 0; i < cascade->n_stages; i++) {
+        n_features += cascade->stages[i].n_features;
+    }
 
-        // Read rectangles weights and rectangles (number of rectangles * 4 points)
-        mp_stream_read_exactly(file, cascade->weights_array, sizeof(int8_t) * cascade->n_rectangles, &error);
-        mp_stream_read_exactly(file, cascade->rectangles_array, sizeof(int8_t) * cascade->n_rectangles * 4, &error);
+    if (n_features != cascade->n_features) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid cascade"));
     }
 
-    if (error != 0) {
-        mp_raise_OSError(error);
+    // Sum the number of rectangles in all features
+    for (size_t i = 0; i < cascade->n_features; i++) {
+        if (cascade->features[i].n_rects > HAAR_FEATURE_MAX_RECTS) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Too many rectangles per feature"));
+        }
+        cascade->n_rectangles += cascade->features[i].n_rects;
     }
+
     mp_stream_close(file);
     return 0;
 }
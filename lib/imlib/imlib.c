@@ -44,6 +44,9 @@ uint32_t imlib_last_poll_cyc;
 
 void imlib_init() {
     omv_cycles_init();
+    #ifdef IMLIB_ENABLE_REMAP
+    imlib_remap_init0();
+    #endif
     #if (OMV_GPU_ENABLE == 1)
     omv_gpu_init();
     #endif
@@ -56,6 +59,9 @@ void imlib_init() {
 }
 
 void imlib_deinit() {
+    #ifdef IMLIB_ENABLE_REMAP
+    imlib_remap_deinit0();
+    #endif
     #if (OMV_GPU_ENABLE == 1)
     omv_gpu_deinit();
     #endif
@@ -816,202 +822,75 @@ void imlib_zero(image_t *img, image_t *mask, bool invert) {
 }
 
 #ifdef IMLIB_ENABLE_LENS_CORR
+typedef struct imlib_lens_corr_key {
+    float strength, zoom, x_corr, y_corr;
+} imlib_lens_corr_key_t;
+
+typedef struct imlib_lens_corr_args {
+    float *table;
+    int w, h, half_w, half_h;
+    int down_adj, up_adj, right_adj, left_adj;
+} imlib_lens_corr_args_t;
+
+static void imlib_lens_corr_point(const void *args, int x, int y, float *sx, float *sy) {
+    const imlib_lens_corr_args_t *a = args;
+    // The correction is symmetrical around the center, so the bottom/right halves mirror the top/left ones.
+    bool bottom = y >= a->half_h;
+    bool right = x >= a->half_w;
+    int newY = (bottom ? (a->h - 1 - y) : y) - a->half_h;
+    int newX = (right ? (a->w - 1 - x) : x) - a->half_w;
+    float precalculated = a->table[(int) fast_sqrtf((newX * newX) + (newY * newY))];
+    int sourceY = fast_roundf(precalculated * newY); // rounding is necessary
+    int sourceX = fast_roundf(precalculated * newX); // rounding is necessary
+    *sy = bottom ? (a->up_adj - sourceY) : (a->down_adj + sourceY);
+    *sx = right ? (a->left_adj - sourceX) : (a->right_adj + sourceX);
+}
+
 // A simple algorithm for correcting lens distortion.
 // See http://www.tannerhelland.com/4743/simple-algorithm-correcting-lens-distortion/
-void imlib_lens_corr(image_t *img, float strength, float zoom, float x_corr, float y_corr) {
-    int w = img->w;
-    int h = img->h;
-    int halfWidth = w / 2;
-    int halfHeight = h / 2;
-    float maximum_diameter = fast_sqrtf((w * w) + (h * h));
-    float lens_corr_diameter = strength / maximum_diameter;
-    zoom = 1 / zoom;
-
-    // Convert percentage offset to pixels from center of image
-    int x_off = w * x_corr;
-    int y_off = h * y_corr;
-
-    // Create a tmp copy of the image to pull pixels from.
-    size_t size = image_size(img);
-    void *data = uma_malloc(size, 0);
-    memcpy(data, img->data, size);
-    memset(img->data, 0, size);
-
-    int maximum_radius = fast_ceilf(maximum_diameter / 2) + 1; // +1 inclusive of final value
-    float *precalculated_table = uma_malloc(maximum_radius * sizeof(float), UMA_DTCM);
-
-    for (int i = 0; i < maximum_radius; i++) {
-        float r = lens_corr_diameter * i;
-        precalculated_table[i] = (fast_atanf(r) / r) * zoom;
-    }
-
-    int down_adj = halfHeight + y_off;
-    int up_adj = h - 1 - halfHeight + y_off;
-    int right_adj = halfWidth + x_off;
-    int left_adj = w - 1 - halfWidth + x_off;
-
-    switch (img->pixfmt) {
-        case PIXFORMAT_BINARY: {
-            uint32_t *tmp = (uint32_t *) data;
-
-            for (int y = 0; y < halfHeight; y++) {
-                uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                uint32_t *row_ptr2 = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, h - 1 - y);
-                int newY = y - halfHeight;
-                int newY2 = newY * newY;
-
-                for (int x = 0; x < halfWidth; x++) {
-                    int newX = x - halfWidth;
-                    int newX2 = newX * newX;
-                    float precalculated = precalculated_table[(int) fast_sqrtf(newX2 + newY2)];
-                    int sourceY = fast_roundf(precalculated * newY); // rounding is necessary
-                    int sourceX = fast_roundf(precalculated * newX); // rounding is necessary
-                    int sourceY_down = down_adj + sourceY;
-                    int sourceY_up = up_adj - sourceY;
-                    int sourceX_right = right_adj + sourceX;
-                    int sourceX_left = left_adj - sourceX;
-
-                    // plot the 4 symmetrical pixels
-                    // top 2 pixels
-                    if (sourceY_down >= 0 && sourceY_down < h) {
-                        uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY_down);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            uint8_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX_right);
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, pixel);
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            uint8_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX_left);
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, w - 1 - x, pixel);
-                        }
-                    }
-
-                    // bottom 2 pixels
-                    if (sourceY_up >= 0 && sourceY_up < h) {
-                        uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY_up);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            uint8_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX_right);
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr2, x, pixel);
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            uint8_t pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX_left);
-                            IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr2, w - 1 - x, pixel);
-                        }
-                    }
-                }
-            }
-            break;
+void imlib_lens_corr(image_t *dst, image_t *src, float strength, float zoom, float x_corr, float y_corr) {
+    imlib_lens_corr_key_t key = { strength, zoom, x_corr, y_corr };
+    imlib_remap_t *map = imlib_remap_cache_get(IMLIB_REMAP_CACHE_LENS_CORR, src, &key, sizeof(key));
+
+    if (!map) {
+        int w = src->w;
+        int h = src->h;
+        float maximum_diameter = fast_sqrtf((w * w) + (h * h));
+        float lens_corr_diameter = strength / maximum_diameter;
+        zoom = 1 / zoom;
+
+        // Convert percentage offset to pixels from center of image
+        int x_off = w * x_corr;
+        int y_off = h * y_corr;
+
+        imlib_lens_corr_args_t args = {
+            .w = w,
+            .h = h,
+            .half_w = w / 2,
+            .half_h = h / 2,
+            .down_adj = (h / 2) + y_off,
+            .up_adj = h - 1 - (h / 2) + y_off,
+            .right_adj = (w / 2) + x_off,
+            .left_adj = w - 1 - (w / 2) + x_off,
+        };
+
+        int maximum_radius = fast_ceilf(maximum_diameter / 2) + 1; // +1 inclusive of final value
+        args.table = uma_malloc(maximum_radius * sizeof(float), UMA_DTCM);
+
+        for (int i = 0; i < maximum_radius; i++) {
+            float r = lens_corr_diameter * i;
+            args.table[i] = (fast_atanf(r) / r) * zoom;
         }
-        case PIXFORMAT_GRAYSCALE: {
-            uint8_t *tmp = (uint8_t *) data;
 
-            for (int y = 0; y < halfHeight; y++) {
-                uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                uint8_t *row_ptr2 = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, h - 1 - y);
-                int newY = y - halfHeight;
-                int newY2 = newY * newY;
-
-                for (int x = 0; x < halfWidth; x++) {
-                    int newX = x - halfWidth;
-                    int newX2 = newX * newX;
-                    float precalculated = precalculated_table[(int) fast_sqrtf(newX2 + newY2)];
-                    int sourceY = fast_roundf(precalculated * newY); // rounding is necessary
-                    int sourceX = fast_roundf(precalculated * newX); // rounding is necessary
-                    int sourceY_down = down_adj + sourceY;
-                    int sourceY_up = up_adj - sourceY;
-                    int sourceX_right = right_adj + sourceX;
-                    int sourceX_left = left_adj - sourceX;
-
-                    // plot the 4 symmetrical pixels
-                    // top 2 pixels
-                    if (sourceY_down >= 0 && sourceY_down < h) {
-                        uint8_t *ptr = tmp + (w * sourceY_down);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            row_ptr[x] = ptr[sourceX_right];
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            row_ptr[w - 1 - x] = ptr[sourceX_left];
-                        }
-                    }
-
-                    // bottom 2 pixels
-                    if (sourceY_up >= 0 && sourceY_up < h) {
-                        uint8_t *ptr = tmp + (w * sourceY_up);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            row_ptr2[x] = ptr[sourceX_right];
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            row_ptr2[w - 1 - x] = ptr[sourceX_left];
-                        }
-                    }
-                }
-            }
-            break;
-        }
-        case PIXFORMAT_RGB565: {
-            uint16_t *tmp = (uint16_t *) data;
-
-            for (int y = 0; y < halfHeight; y++) {
-                uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                uint16_t *row_ptr2 = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, h - 1 - y);
-                int newY = y - halfHeight;
-                int newY2 = newY * newY;
-
-                for (int x = 0; x < halfWidth; x++) {
-                    int newX = x - halfWidth;
-                    int newX2 = newX * newX;
-                    float precalculated = precalculated_table[(int) fast_sqrtf(newX2 + newY2)];
-                    int sourceY = fast_roundf(precalculated * newY); // rounding is necessary
-                    int sourceX = fast_roundf(precalculated * newX); // rounding is necessary
-                    int sourceY_down = down_adj + sourceY;
-                    int sourceY_up = up_adj - sourceY;
-                    int sourceX_right = right_adj + sourceX;
-                    int sourceX_left = left_adj - sourceX;
-
-                    // plot the 4 symmetrical pixels
-                    // top 2 pixels
-                    if (sourceY_down >= 0 && sourceY_down < h) {
-                        uint16_t *ptr = tmp + (w * sourceY_down);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            row_ptr[x] = ptr[sourceX_right];
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            row_ptr[w - 1 - x] = ptr[sourceX_left];
-                        }
-                    }
-
-                    // bottom 2 pixels
-                    if (sourceY_up >= 0 && sourceY_up < h) {
-                        uint16_t *ptr = tmp + (w * sourceY_up);
-
-                        if (sourceX_right >= 0 && sourceX_right < w) {
-                            row_ptr2[x] = ptr[sourceX_right];
-                        }
-
-                        if (sourceX_left >= 0 && sourceX_left < w) {
-                            row_ptr2[w - 1 - x] = ptr[sourceX_left];
-                        }
-                    }
-                }
-            }
-            break;
-        }
-        default: {
-            break;
-        }
+        // Maps that aren't cached may still need the table while they're applied.
+        map = imlib_remap_cache_set(IMLIB_REMAP_CACHE_LENS_CORR, src, &key, sizeof(key),
+                                    imlib_lens_corr_point, &args, true);
+        imlib_remap_image(map, dst, src);
+        uma_free(args.table);
+        return;
     }
 
-    uma_free(precalculated_table);
-    uma_free(data);
+    imlib_remap_image(map, dst, src);
 }
 #endif //IMLIB_ENABLE_LENS_CORR
 
@@ -1087,16 +966,9 @@ int imlib_image_std(image_t *src) {
 }
 
 // Vertical pass: convolve 3 rows with kernel, store u16 results.
-// Border: clamps row index to [0, h-1].
-static inline void sepconv3_vpass(uint8_t *data, int w, int h, int y,
+static inline void sepconv3_vpass(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, int w,
                                   int8_t k0, int8_t k1, int8_t k2,
                                   uint16_t *vrow) {
-    int y0 = y > 0 ? y - 1 : 0;
-    int y2 = y < h - 1 ? y + 1 : h - 1;
-    uint8_t *r0 = data + y0 * w;
-    uint8_t *r1 = data + y * w;
-    uint8_t *r2 = data + y2 * w;
-
     int x = 0;
     for (; x <= w - (int) UINT8_VECTOR_SIZE; x += UINT8_VECTOR_SIZE) {
         v128_t p0 = vldr_u8(r0 + x);
@@ -1123,7 +995,7 @@ static inline void sepconv3_vpass(uint8_t *data, int w, int h, int y,
 
 // Horizontal pass: convolve u16 row with kernel, scale, clamp, store u8.
 // Border: clamps column index to [0, w-1].
-static inline void sepconv3_hpass(uint16_t *prev, uint8_t *dst, int w,
+static inline void sepconv3_hpass(const uint16_t *prev, uint8_t *dst, int w,
                                   int8_t k0, int8_t k1, int8_t k2,
                                   float m, int b) {
     for (int x = 0; x < w; x++) {
@@ -1145,8 +1017,12 @@ void imlib_sepconv3(image_t *img, const int8_t *krn, const float m, const int b)
     uint16_t *vbuf = uma_malloc(w * sizeof(uint16_t) * 2, UMA_DTCM);
 
     for (int y = 0; y < h; y++) {
+        // Border: clamps row index to [0, h-1].
+        uint8_t *r0 = data + (y > 0 ? y - 1 : 0) * w;
+        uint8_t *r1 = data + y * w;
+        uint8_t *r2 = data + (y < h - 1 ? y + 1 : h - 1) * w;
         uint16_t *vrow = vbuf + (y & 1) * w;
-        sepconv3_vpass(data, w, h, y, k0, k1, k2, vrow);
+        sepconv3_vpass(r0, r1, r2, w, k0, k1, k2, vrow);
 
         if (y > 0) {
             uint16_t *prev = vbuf + ((y - 1) & 1) * w;
@@ -1159,3 +1035,9 @@ void imlib_sepconv3(image_t *img, const int8_t *krn, const float m, const int b)
 
     uma_free(vbuf);
 }
+
+void imlib_sepconv3_row(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, uint8_t *dst, int w,
+                        const int8_t *krn, const float m, const int b, uint16_t *vrow) {
+    sepconv3_vpass(r0, r1, r2, w, krn[0], krn[1], krn[2], vrow);
+    sepconv3_hpass(vrow, dst, w, krn[0], krn[1], krn[2], m, b);
+}
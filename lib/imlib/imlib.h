@@ -844,6 +844,27 @@ typedef enum jpeg_subsampling {
     JPEG_SUBSAMPLING_420  = 0x22, // Chroma subsampling 4:2:0
 } jpeg_subsampling_t;
 
+// Output buffer of the software encoder.
+typedef struct jpeg_buf {
+    int idx;
+    int length;
+    uint8_t *buf;
+    uint64_t bitb;
+    uint32_t bitc;
+    bool realloc;
+    bool overflow;
+} jpeg_buf_t;
+
+// Software encoder state, the image is encoded one band of MCU rows at a time.
+typedef struct jpeg_encoder {
+    jpeg_buf_t buf;
+    image_t *dst;
+    int band_h;
+    bool is_color;
+    jpeg_subsampling_t subsampling;
+    int DCY, DCU, DCV;
+} jpeg_encoder_t;
+
 // Old Image Macros - Will be refactor and removed. But, only after making sure through testing new macros work.
 
 // Image kernels
@@ -969,8 +990,34 @@ typedef struct size {
 } wsize_t;
 
 /* Haar cascade struct */
+#define HAAR_CASCADE_MAGIC      (0x52414148)    // "HAAR"
+#define HAAR_FEATURE_MAX_RECTS  (3)
+
+// Packed cascade file layout: header, stages[n_stages] and features[n_features].
+typedef struct haar_header {
+    uint32_t magic;                 // HAAR_CASCADE_MAGIC.
+    uint16_t window_w;              // Detection window width.
+    uint16_t window_h;              // Detection window height.
+    uint16_t n_stages;              // Number of stages in the cascade.
+    uint16_t n_features;            // Number of features in the cascade.
+} haar_header_t;
+
+typedef struct haar_stage {
+    uint16_t n_features;            // Number of features in the stage.
+    int16_t thresh;                 // Stage threshold (Q8).
+} haar_stage_t;
+
+typedef struct haar_feature {
+    int16_t thresh;                 // Feature threshold (Q12).
+    int16_t alpha1;                 // Left leaf value (Q8).
+    int16_t alpha2;                 // Right leaf value (Q8).
+    uint8_t n_rects;                // Number of rectangles.
+    int8_t weights[HAAR_FEATURE_MAX_RECTS];     // Rectangles weights.
+    uint8_t rects[HAAR_FEATURE_MAX_RECTS][4];   // Rectangles (x, y, w, h).
+    uint8_t reserved[2];
+} haar_feature_t;
+
 typedef struct cascade {
-    int std;                        // Image standard deviation.
     int step;                       // Image scanning factor.
     float threshold;                // Detection threshold.
     float scale;                    // Image scaling factor.
@@ -981,14 +1028,8 @@ typedef struct cascade {
     struct image *img;              // Grayscale image.
     mw_image_t *sum;                // Integral image.
     mw_image_t *ssq;                // Squared integral image.
-    uint8_t *stages_array;          // Number of features per stage.
-    int16_t *stages_thresh_array;   // Stages thresholds.
-    int16_t *tree_thresh_array;     // Features threshold (1 per feature).
-    int16_t *alpha1_array;          // Alpha1 array (1 per feature).
-    int16_t *alpha2_array;          // Alpha2 array (1 per feature).
-    int8_t *num_rectangles_array;   // Number of rectangles per features (1 per feature).
-    int8_t *weights_array;          // Rectangles weights (1 per rectangle).
-    int8_t *rectangles_array;       // Rectangles array.
+    const haar_stage_t *stages;     // Stages array.
+    const haar_feature_t *features; // Features array.
 } cascade_t;
 
 typedef struct bmp_read_settings {
@@ -1036,6 +1077,13 @@ typedef struct img_read_settings {
     save_image_format_t format;
 } img_read_settings_t;
 
+typedef struct gif_stats {
+    uint32_t frames;            // Frames added
+    uint32_t pixels;            // Pixels in all frames
+    uint32_t encoded_pixels;    // Pixels inside the written rectangles
+    uint32_t bytes;             // Bytes written for all frames
+} gif_stats_t;
+
 typedef void (*binary_morph_op_t) (image_t *, int, int, image_t *);
 typedef void (*line_op_t) (image_t *, int, void *, void *, bool);
 typedef void (*flood_fill_call_back_t) (image_t *, int, int, int, void *);
@@ -1089,6 +1137,7 @@ typedef struct statistics {
 
 #define FIND_BLOBS_CORNERS_RESOLUTION    20 // multiple of 4
 #define FIND_BLOBS_ANGLE_RESOLUTION      (360 / FIND_BLOBS_CORNERS_RESOLUTION)
+#define FIND_BLOBS_MAX_THRESHOLDS        32 // blob codes have one bit per threshold
 
 typedef struct find_blobs_list_lnk_data {
     point_t corners[FIND_BLOBS_CORNERS_RESOLUTION];
@@ -1148,6 +1197,95 @@ typedef struct find_apriltags_list_lnk_data {
     float x_rotation, y_rotation, z_rotation;
 } find_apriltags_list_lnk_data_t;
 
+#define IMLIB_TRACKER_MAX_TRACKS    (16)
+
+typedef struct imlib_track {
+    uint32_t id;
+    uint32_t key;       // Detection identity (e.g. tag family/id or payload hash).
+    rectangle_t rect;   // Last detected bounding box.
+    float vx, vy;       // Velocity in pixels per frame.
+    uint16_t lost;      // Frames since the track was last detected.
+} imlib_track_t;
+
+typedef struct imlib_tracker {
+    imlib_track_t tracks[IMLIB_TRACKER_MAX_TRACKS];
+    size_t n_tracks;
+    uint32_t next_id;
+    uint16_t interval;  // Full scan interval in frames.
+    uint16_t max_lost;  // Frames a lost track is kept for.
+    uint16_t frames;    // Frames since the last full scan.
+    float margin;       // Search window margin relative to the marker size.
+    bool rescan;        // A track was lost by a windowed search.
+    bool full_scan;     // The current frame is a full scan.
+} imlib_tracker_t;
+
+typedef struct imlib_tracker_det {
+    rectangle_t rect;
+    uint32_t key;
+} imlib_tracker_det_t;
+
+#if defined(IMLIB_ENABLE_LENS_CORR) || defined(IMLIB_ENABLE_ROTATION_CORR) || \
+    defined(IMLIB_ENABLE_LOGPOLAR) || defined(IMLIB_ENABLE_LINPOLAR)
+#define IMLIB_ENABLE_REMAP
+#endif
+
+#define IMLIB_REMAP_TILE_SHIFT      (3)
+#define IMLIB_REMAP_KEY_SIZE        (64)
+// Dense tables larger than this fall back to tiled tables (if allowed).
+#ifndef IMLIB_REMAP_DENSE_MAX
+#define IMLIB_REMAP_DENSE_MAX       (512 * 1024)
+#endif
+// Total size of the cached tables.
+#ifndef IMLIB_REMAP_CACHE_SIZE
+#define IMLIB_REMAP_CACHE_SIZE      (1024 * 1024)
+#endif
+
+typedef enum {
+    IMLIB_REMAP_CACHE_LENS_CORR,
+    IMLIB_REMAP_CACHE_ROTATION_CORR,
+    IMLIB_REMAP_CACHE_POLAR,
+    IMLIB_REMAP_CACHE_MAX
+} imlib_remap_cache_slot_t;
+
+// Returns the source coordinates of a destination pixel.
+typedef void (*imlib_remap_point_t) (const void *args, int x, int y, float *sx, float *sy);
+
+typedef struct imlib_remap_span {
+    uint16_t x, n;
+    uint32_t offset;            // Source offset of the first pixel.
+} imlib_remap_span_t;
+
+typedef struct imlib_remap {
+    uint16_t w, h;
+    pixformat_t pixfmt;
+    uint32_t stride;            // Source row stride in pixels.
+    size_t size;                // Table size in bytes.
+    // Dense tables.
+    uint32_t *row_spans;        // First span of each row (h + 1 entries).
+    imlib_remap_span_t *spans;  // Runs of pixels that have a source.
+    int16_t *deltas;            // Source offset step to each following pixel of the spans.
+    // Tiled tables.
+    int32_t *grid;              // Q16 source (x, y) at the tile corners.
+    uint16_t grid_w, grid_h;
+    // Maps without a table compute the source of each pixel.
+    imlib_remap_point_t point;
+    const void *args;
+} imlib_remap_t;
+
+#define IMLIB_APRILTAG_FAMILIES_MAX (9)
+
+// Keeps the tag families (and their quick-decode tables) alive across detections.
+typedef struct imlib_apriltag_detector {
+    struct apriltag_detector *td;
+    struct apriltag_family *families[IMLIB_APRILTAG_FAMILIES_MAX];
+    uint32_t uma_flags;
+    uint8_t *buffer; // Grayscale conversion buffer.
+    size_t buffer_size;
+    float quad_decimate;
+    float quad_sigma;
+    bool refine_edges;
+} imlib_apriltag_detector_t;
+
 typedef struct find_datamatrices_list_lnk_data {
     point_t corners[4];
     rectangle_t rect;
@@ -1271,7 +1409,23 @@ void imlib_hardware_venc_deinit();
 void jpeg_get_mcu(image_t *src, int x_offset, int y_offset, int dx, int dy,
                   int8_t *Y0, int8_t *CB, int8_t *CR);
 void jpeg_decompress(image_t *dst, image_t *src);
+// Called with each band of rows decoded by jpeg_decompress_rect(), y is relative to the output image.
+typedef void (*jpeg_decompress_callback_t) (void *arg, image_t *rows, int y);
+void jpeg_decompress_geometry(image_t *dst, image_t *src, rectangle_t *roi, int scale);
+void jpeg_decompress_rect(image_t *dst, image_t *src, rectangle_t *roi, int scale,
+                          jpeg_decompress_callback_t callback, void *callback_arg);
 bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling);
+#if (OMV_JPEG_CODEC_ENABLE == 0)
+// Encodes a w x h image into dst (allocated if NULL) band by band. Each band is band_h rows
+// except the last one, and is read from row y of src. Returns true if the output overflowed.
+void jpeg_encoder_start(jpeg_encoder_t *enc, image_t *dst, int w, int h, bool is_color,
+                        int quality, bool realloc, jpeg_subsampling_t subsampling);
+bool jpeg_encoder_band(jpeg_encoder_t *enc, image_t *src, int y);
+bool jpeg_encoder_finish(jpeg_encoder_t *enc);
+#if MICROPY_PY_UNITTEST
+int jpeg_fdct_quant_luma(const int8_t *CDU, int quality, int *DUQ);
+#endif
+#endif
 bool jpeg_is_valid(image_t *img);
 int jpeg_clean_trailing_bytes(int bpp, uint8_t *data);
 void jpeg_read_geometry(file_t *fp, image_t *img, const char *path, jpg_read_settings_t *rs);
@@ -1291,7 +1445,7 @@ void imlib_save_image(image_t *img, const char *path, rectangle_t *roi, int qual
 
 /* GIF functions */
 void gif_open(file_t *fp, int width, int height, bool color, bool loop);
-void gif_add_frame(file_t *fp, image_t *img, uint16_t delay);
+void gif_add_frame(file_t *fp, image_t *img, uint16_t delay, uint8_t *prev, gif_stats_t *stats);
 void gif_close(file_t *fp);
 
 /* MJPEG functions */
@@ -1317,6 +1471,9 @@ void rectangle_expand(rectangle_t *r, int x, int y);
 
 /* Separable 2D convolution */
 void imlib_sepconv3(image_t *img, const int8_t *krn, const float m, const int b);
+// Convolves one output row from rows r0..r2 (above, center, below). vrow is w u16 of scratch.
+void imlib_sepconv3_row(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, uint8_t *dst, int w,
+                        const int8_t *krn, const float m, const int b, uint16_t *vrow);
 
 /* Image Statistics */
 int imlib_image_mean(image_t *src, int *r_mean, int *g_mean, int *b_mean);
@@ -1455,6 +1612,13 @@ void imlib_awb_rgb_max(image_t *img, uint32_t *r_out, uint32_t *g_out, uint32_t
 void imlib_awb(image_t *img, uint32_t r_out, uint32_t g_out, uint32_t b_out);
 void imlib_ccm(image_t *img, float *ccm, bool offset);
 void imlib_gamma(image_t *img, float gamma, float scale, float offset);
+// Gamma lookup tables: one table for BINARY/GRAYSCALE, R5/G6/B5 tables packed together for RGB565.
+#define IMLIB_GAMMA_LUT_SIZE    (256)
+#define IMLIB_GAMMA_LUT_R5      (0)
+#define IMLIB_GAMMA_LUT_G6      (COLOR_R5_MAX - COLOR_R5_MIN + 1)
+#define IMLIB_GAMMA_LUT_B5      (IMLIB_GAMMA_LUT_G6 + COLOR_G6_MAX - COLOR_G6_MIN + 1)
+void imlib_gamma_lut(pixformat_t pixfmt, float gamma, float scale, float offset, uint8_t *lut);
+void imlib_gamma_lut_apply(image_t *img, const uint8_t *lut);
 // Binary Functions
 void imlib_zero_line_op(int x, int x_end, int y_row, imlib_draw_row_data_t *data);
 void imlib_mask_line_op(int x, int x_end, int y_row, imlib_draw_row_data_t *data);
@@ -1504,14 +1668,26 @@ void imlib_bilateral_filter(image_t *img,
                             int offset,
                             bool invert,
                             image_t *mask);
+// Remap tables
+void imlib_remap_init0(void);
+void imlib_remap_deinit0(void);
+bool imlib_remap_init(imlib_remap_t *map, image_t *img, imlib_remap_point_t point, const void *args,
+                      bool tiled, uint32_t flags);
+void imlib_remap_deinit(imlib_remap_t *map);
+void imlib_remap_apply(imlib_remap_t *map, image_t *dst, image_t *src);
+void imlib_remap_image(imlib_remap_t *map, image_t *dst, image_t *src);
+void imlib_remap_once(image_t *dst, image_t *src, imlib_remap_point_t point, const void *args, bool tiled);
+imlib_remap_t *imlib_remap_cache_get(imlib_remap_cache_slot_t slot, image_t *img, const void *key, size_t key_size);
+imlib_remap_t *imlib_remap_cache_set(imlib_remap_cache_slot_t slot, image_t *img, const void *key, size_t key_size,
+                                     imlib_remap_point_t point, const void *args, bool tiled);
 // Image Correction
 void imlib_logpolar_int(image_t *dst, image_t *src, rectangle_t *roi, int cx, int cy, bool linear, bool reverse); // helper/internal
-void imlib_logpolar(image_t *img, int cx, int cy, bool linear, bool reverse);
+void imlib_logpolar(image_t *dst, image_t *src, int cx, int cy, bool linear, bool reverse);
 // Lens/Rotation Correction
-void imlib_lens_corr(image_t *img, float strength, float zoom, float x_corr, float y_corr);
-void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation,
+void imlib_lens_corr(image_t *dst, image_t *src, float strength, float zoom, float x_corr, float y_corr);
+void imlib_rotation_corr(image_t *dst, image_t *src, float x_rotation, float y_rotation,
                          float z_rotation, float x_translation, float y_translation,
-                         float zoom, float fov, float *corners);
+                         float zoom, float fov, float *corners, bool cache);
 // Statistics
 void imlib_get_similarity(image_t *img,
                           image_t *other,
@@ -1544,12 +1720,107 @@ bool imlib_get_regression(find_lines_list_lnk_data_t *out,
                           unsigned int area_threshold,
                           unsigned int pixels_threshold);
 // Color Tracking
+// At most FIND_BLOBS_MAX_THRESHOLDS thresholds, a pixel matching several is only part of the blobs of the first.
 void imlib_find_blobs(list_t *out, image_t *ptr, rectangle_t *roi, unsigned int x_stride, unsigned int y_stride,
                       list_t *thresholds, bool invert, unsigned int area_threshold, unsigned int pixels_threshold,
                       bool merge, int margin,
                       bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *), void *threshold_cb_arg,
                       bool (*merge_cb) (void *, find_blobs_list_lnk_data_t *, find_blobs_list_lnk_data_t *), void *merge_cb_arg,
                       unsigned int x_hist_bins_max, unsigned int y_hist_bins_max);
+// Row-streaming blob detection: imlib_find_blobs() is start, one row call per ROI row, then finish.
+// Rows are in ptr->pixfmt and indexed by absolute x; ptr only supplies the frame geometry.
+typedef struct blob_labeler blob_labeler_t;
+blob_labeler_t *imlib_find_blobs_start(list_t *out, image_t *ptr, rectangle_t *roi,
+                                       unsigned int x_stride, unsigned int y_stride,
+                                       list_t *thresholds, bool invert,
+                                       unsigned int area_threshold, unsigned int pixels_threshold,
+                                       bool (*threshold_cb) (void *, find_blobs_list_lnk_data_t *),
+                                       void *threshold_cb_arg,
+                                       unsigned int x_hist_bins_max, unsigned int y_hist_bins_max);
+void imlib_find_blobs_row(blob_labeler_t *ctx, const void *row, int y);
+void imlib_find_blobs_finish(blob_labeler_t *ctx, bool merge, int margin,
+                             bool (*merge_cb) (void *, find_blobs_list_lnk_data_t *, find_blobs_list_lnk_data_t *),
+                             void *merge_cb_arg);
+// Row-streaming pipeline
+#define IMLIB_PIPELINE_MAX_STAGES   (8)
+
+typedef enum imlib_pipeline_op {
+    IMLIB_PIPELINE_OP_TO_GRAYSCALE,
+    IMLIB_PIPELINE_OP_TO_RGB565,
+    IMLIB_PIPELINE_OP_SEPCONV3,
+    IMLIB_PIPELINE_OP_GAMMA,
+    IMLIB_PIPELINE_OP_CCM,
+    IMLIB_PIPELINE_OP_BINARY,
+    IMLIB_PIPELINE_OP_LINE_OP,
+} imlib_pipeline_op_t;
+
+typedef struct imlib_pipeline_stage {
+    imlib_pipeline_op_t op;
+    union {
+        struct {
+            int8_t krn[3];
+            float m;
+            int b;
+        } sepconv3;
+        struct {
+            float gamma, contrast, brightness;
+        } gamma;
+        struct {
+            float ccm[12];
+            bool offset;
+        } ccm;
+        struct {
+            list_t thresholds;
+            bool invert;
+        } binary;
+        struct {
+            imlib_draw_row_callback_t callback;
+            image_t *other; // or NULL to use scalar
+            int scalar;
+            bool scalar_is_rgb888;
+        } line_op;
+    };
+} imlib_pipeline_stage_t;
+
+typedef struct imlib_pipeline {
+    size_t n_stages;
+    imlib_pipeline_stage_t stages[IMLIB_PIPELINE_MAX_STAGES];
+} imlib_pipeline_t;
+
+typedef void (*imlib_pipeline_callback_t) (void *arg, const void *row, int y);
+
+typedef struct imlib_pipeline_histogram {
+    histogram_t *hist;
+    pixformat_t pixfmt;
+    int w;
+    uint32_t pixels;
+} imlib_pipeline_histogram_t;
+
+// Output rows are collected into a band of MCU rows that's encoded once full.
+typedef struct imlib_pipeline_jpeg {
+    jpeg_encoder_t enc;
+    image_t band;
+    int h;
+} imlib_pipeline_jpeg_t;
+
+// Returns the output format for src, and optionally the row format before each stage followed
+// by the output format. Raises ValueError if the stages cannot be chained.
+pixformat_t imlib_pipeline_pixfmt(imlib_pipeline_t *pipeline, image_t *src, pixformat_t *stage_pixfmt);
+pixformat_t imlib_pipeline_run(imlib_pipeline_t *pipeline, image_t *src,
+                               imlib_pipeline_callback_t callback, void *callback_arg);
+// Consumers: arg is the destination image_t, a blob_labeler_t, an imlib_pipeline_histogram_t
+// or an imlib_pipeline_jpeg_t.
+void imlib_pipeline_image_cb(void *arg, const void *row, int y);
+void imlib_pipeline_find_blobs_cb(void *arg, const void *row, int y);
+void imlib_pipeline_histogram_start(imlib_pipeline_histogram_t *state);
+void imlib_pipeline_histogram_cb(void *arg, const void *row, int y);
+void imlib_pipeline_histogram_finish(imlib_pipeline_histogram_t *state);
+#if (OMV_JPEG_CODEC_ENABLE == 0)
+void imlib_pipeline_jpeg_start(imlib_pipeline_jpeg_t *state, image_t *dst, int w, int h, pixformat_t pixfmt,
+                               int quality, jpeg_subsampling_t subsampling);
+void imlib_pipeline_jpeg_cb(void *arg, const void *row, int y);
+bool imlib_pipeline_jpeg_finish(imlib_pipeline_jpeg_t *state);
+#endif
 // Shape Detection
 size_t trace_line(image_t *ptr, line_t *l, int *theta_buffer, uint32_t *mag_buffer, point_t *point_buffer); // helper/internal
 void merge_alot(list_t *out, int threshold, int theta_threshold); // helper/internal
@@ -1565,8 +1836,17 @@ void imlib_find_rects(list_t *out, image_t *ptr, rectangle_t *roi, uint32_t thre
 void imlib_find_qrcodes(list_t *out, image_t *ptr, rectangle_t *roi);
 void imlib_find_apriltags(list_t *out, image_t *ptr, rectangle_t *roi, apriltag_families_t families,
                           float fx, float fy, float cx, float cy);
+void imlib_apriltag_detector_init(imlib_apriltag_detector_t *detector, apriltag_families_t families, uint32_t uma_flags);
+void imlib_apriltag_detector_deinit(imlib_apriltag_detector_t *detector);
+void imlib_apriltag_detector_detect(imlib_apriltag_detector_t *detector, list_t *out, image_t *ptr, rectangle_t *roi,
+                                    float fx, float fy, float cx, float cy);
 void imlib_find_datamatrices(list_t *out, image_t *ptr, rectangle_t *roi, int effort);
 void imlib_find_barcodes(list_t *out, image_t *ptr, rectangle_t *roi);
+// Temporal ROI tracking
+void imlib_tracker_init(imlib_tracker_t *tracker, int interval, float margin, int max_lost);
+void imlib_tracker_reset(imlib_tracker_t *tracker);
+size_t imlib_tracker_windows(imlib_tracker_t *tracker, rectangle_t *roi, rectangle_t *windows);
+void imlib_tracker_update(imlib_tracker_t *tracker, size_t n, imlib_tracker_det_t *dets, uint32_t *ids);
 // Template Matching
 void imlib_phasecorrelate(image_t *img0,
                           image_t *img1,
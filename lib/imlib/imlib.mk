@@ -62,6 +62,7 @@ IMLIB_SRC_C += \
     mjpeg.c \
     orb.c \
     phasecorrelation.c \
+    pipeline.c \
     png.c \
     point.c \
     ppm.c \
@@ -69,12 +70,14 @@ IMLIB_SRC_C += \
     qsort.c \
     rainbow_tab.c \
     rectangle.c \
+    remap.c \
     rotation_corr.c \
     selective_search.c \
     sincos_tab.c \
     stats.c \
     stereo.c \
     template.c \
+    tracker.c \
     xyz_tab.c \
     yuv.c \
     zbar.c \
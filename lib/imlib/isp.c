@@ -1050,26 +1050,16 @@ void imlib_ccm(image_t *img, float *ccm, bool offset) {
     }
 }
 
-void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
+void imlib_gamma_lut(pixformat_t pixfmt, float gamma, float contrast, float brightness, uint8_t *lut) {
     gamma = IM_DIV(1.0f, gamma);
-    switch (img->pixfmt) {
+    switch (pixfmt) {
         case PIXFORMAT_BINARY: {
             float pScale = COLOR_BINARY_MAX - COLOR_BINARY_MIN;
             float pDiv = 1 / pScale;
-            int p_lut[COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1];
 
             for (int i = COLOR_BINARY_MIN; i <= COLOR_BINARY_MAX; i++) {
                 int p = ((fast_powf(i * pDiv, gamma) * contrast) + brightness) * pScale;
-                p_lut[i] = __USAT(p, 1);
-            }
-
-            for (int y = 0, yy = img->h; y < yy; y++) {
-                uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                for (int x = 0, xx = img->w; x < xx; x++) {
-                    int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, x);
-                    int p = p_lut[dataPixel];
-                    IMAGE_PUT_BINARY_PIXEL_FAST(data, x, p);
-                }
+                lut[i] = __USAT(p, 1);
             }
 
             break;
@@ -1079,27 +1069,12 @@ void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
         case PIXFORMAT_YUV_ANY: {
             float pScale = COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN;
             float pDiv = 1 / pScale;
-            int *p_lut = uma_malloc((COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1) * sizeof(int), UMA_DTCM);
 
             for (int i = COLOR_GRAYSCALE_MIN; i <= COLOR_GRAYSCALE_MAX; i++) {
                 int p = ((fast_powf(i * pDiv, gamma) * contrast) + brightness) * pScale;
-                p_lut[i] = __USAT(p, 8);
+                lut[i] = __USAT(p, 8);
             }
 
-            uint8_t *ptr = (uint8_t *) img->data;
-            int n = img->w * img->h;
-
-            if (img->bpp == 2) {
-                for (; n > 0; n--, ptr += 2) {
-                    *ptr = p_lut[*ptr];
-                }
-            } else {
-                for (; n > 0; n--, ptr += 1) {
-                    *ptr = p_lut[*ptr];
-                }
-            }
-
-            uma_free(p_lut);
             break;
         }
         case PIXFORMAT_RGB565: {
@@ -1109,9 +1084,9 @@ void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
             float rDiv = 1 / rScale;
             float gDiv = 1 / gScale;
             float bDiv = 1 / bScale;
-            int *r_lut = uma_malloc((COLOR_R5_MAX - COLOR_R5_MIN + 1) * sizeof(int), UMA_DTCM);
-            int *g_lut = uma_malloc((COLOR_G6_MAX - COLOR_G6_MIN + 1) * sizeof(int), UMA_DTCM);
-            int *b_lut = uma_malloc((COLOR_B5_MAX - COLOR_B5_MIN + 1) * sizeof(int), UMA_DTCM);
+            uint8_t *r_lut = lut + IMLIB_GAMMA_LUT_R5;
+            uint8_t *g_lut = lut + IMLIB_GAMMA_LUT_G6;
+            uint8_t *b_lut = lut + IMLIB_GAMMA_LUT_B5;
 
             for (int i = COLOR_R5_MIN; i <= COLOR_R5_MAX; i++) {
                 int r = ((fast_powf(i * rDiv, gamma) * contrast) + brightness) * rScale;
@@ -1128,6 +1103,50 @@ void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
                 b_lut[i] = __USAT(b, 5);
             }
 
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+void imlib_gamma_lut_apply(image_t *img, const uint8_t *lut) {
+    switch (img->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            for (int y = 0, yy = img->h; y < yy; y++) {
+                uint32_t *data = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
+                for (int x = 0, xx = img->w; x < xx; x++) {
+                    int dataPixel = IMAGE_GET_BINARY_PIXEL_FAST(data, x);
+                    int p = lut[dataPixel];
+                    IMAGE_PUT_BINARY_PIXEL_FAST(data, x, p);
+                }
+            }
+
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE:
+        case PIXFORMAT_BAYER_ANY:
+        case PIXFORMAT_YUV_ANY: {
+            uint8_t *ptr = (uint8_t *) img->data;
+            int n = img->w * img->h;
+
+            if (img->bpp == 2) {
+                for (; n > 0; n--, ptr += 2) {
+                    *ptr = lut[*ptr];
+                }
+            } else {
+                for (; n > 0; n--, ptr += 1) {
+                    *ptr = lut[*ptr];
+                }
+            }
+
+            break;
+        }
+        case PIXFORMAT_RGB565: {
+            const uint8_t *r_lut = lut + IMLIB_GAMMA_LUT_R5;
+            const uint8_t *g_lut = lut + IMLIB_GAMMA_LUT_G6;
+            const uint8_t *b_lut = lut + IMLIB_GAMMA_LUT_B5;
             uint16_t *ptr = (uint16_t *) img->data;
             int n = img->w * img->h;
 
@@ -1139,9 +1158,6 @@ void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
                 *ptr++ = COLOR_R5_G6_B5_TO_RGB565(r, g, b);
             }
 
-            uma_free(b_lut);
-            uma_free(g_lut);
-            uma_free(r_lut);
             break;
         }
         default: {
@@ -1150,4 +1166,10 @@ void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
     }
 }
 
+void imlib_gamma(image_t *img, float gamma, float contrast, float brightness) {
+    uint8_t lut[IMLIB_GAMMA_LUT_SIZE];
+    imlib_gamma_lut(img->pixfmt, gamma, contrast, brightness, lut);
+    imlib_gamma_lut_apply(img, lut);
+}
+
 #endif // IMLIB_ENABLE_ISP_OPS
@@ -33,6 +33,24 @@
 #include "py/nlr.h"
 #include "py/runtime.h"
 
+// Expands roi to the MCU grid and sets the size of the image jpeg_decompress_rect() outputs.
+void jpeg_decompress_geometry(image_t *dst, image_t *src, rectangle_t *roi, int scale) {
+    if ((scale != 1) && (scale != 2) && (scale != 4) && (scale != 8)) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("JPEG scale must be 1, 2, 4 or 8"));
+    }
+
+    // 16x16 is the largest MCU size and a multiple of the others.
+    int x_end = IM_MIN(roi->x + roi->w, src->w);
+    int y_end = IM_MIN(roi->y + roi->h, src->h);
+    roi->x &= ~15;
+    roi->y &= ~15;
+    roi->w = IM_MIN((x_end + 15) & ~15, src->w) - roi->x;
+    roi->h = IM_MIN((y_end + 15) & ~15, src->h) - roi->y;
+
+    dst->w = (roi->w + scale - 1) / scale;
+    dst->h = (roi->h + scale - 1) / scale;
+}
+
 #if (OMV_JPEG_CODEC_ENABLE == 0)
 /* Software JPEG decoder */
 #define FILE_HIGHWATER         1536
@@ -172,6 +190,9 @@ typedef struct jpeg_image_tag {
     int iVLCSize;                // current quantity of data in the VLC buffer
     int iResInterval, iResCount; // restart interval
     int iMaxMCUs;                // max MCUs of pixels per JPEGDraw call
+    int iPitch;                  // output buffer pitch in pixels
+    int iCropX, iCropY;          // area to draw, everything else is only entropy decoded
+    int iCropCX, iCropCY;
     JPEG_READ_CALLBACK *pfnRead;
     JPEG_SEEK_CALLBACK *pfnSeek;
     JPEG_DRAW_CALLBACK *pfnDraw;
@@ -207,6 +228,7 @@ int JPEG_getThumbHeight(JPEGIMAGE *pJPEG);
 int JPEG_getLastError(JPEGIMAGE *pJPEG);
 void JPEG_setPixelType(JPEGIMAGE *pJPEG, int iType); // defaults to little endian
 void JPEG_setMaxOutputSize(JPEGIMAGE *pJPEG, int iMaxMCUs);
+void JPEG_setCropArea(JPEGIMAGE *pJPEG, int x, int y, int w, int h);
 
 // Due to unaligned memory causing an exception, we have to do these macros the slow way
 #define INTELSHORT(p)     (*(uint16_t *) p)
@@ -433,6 +455,13 @@ void JPEG_setMaxOutputSize(JPEGIMAGE *pJPEG, int iMaxMCUs) {
     pJPEG->iMaxMCUs = iMaxMCUs;
 }
 
+void JPEG_setCropArea(JPEGIMAGE *pJPEG, int x, int y, int w, int h) {
+    pJPEG->iCropX = x;
+    pJPEG->iCropY = y;
+    pJPEG->iCropCX = w;
+    pJPEG->iCropCY = h;
+}
+
 int JPEG_decode(JPEGIMAGE *pJPEG, int x, int y, int iOptions) {
     pJPEG->iXOffset = x;
     pJPEG->iYOffset = y;
@@ -1326,15 +1355,16 @@ static void JPEGIDCT(JPEGIMAGE *pJPEG, int iMCUOffset, int iQuantTable, int iACF
     // http://netilium.org/~mad/dtj/DTJ/DTJK04/
     pQuant = &pJPEG->sQuantTable[iQuantTable * DCTSIZE];
     if (pJPEG->iOptions & JPEG_SCALE_QUARTER) {
-        // special case
+        // special case, each output pixel is the mean of a 4x4 quadrant. The first AC terms
+        // average to 0.906 of their peak over a quadrant, which is 0.653 of the AAN prescale.
         /* Column 0 */
         tmp4 = pMCUSrc[0] * pQuant[0];
-        tmp5 = pMCUSrc[8] * pQuant[8];
+        tmp5 = (pMCUSrc[8] * pQuant[8] * 167) >> 8;
         tmp0 = tmp4 + tmp5;
         tmp2 = tmp4 - tmp5;
         /* Column 1 */
-        tmp4 = pMCUSrc[1] * pQuant[1];
-        tmp5 = pMCUSrc[9] * pQuant[9];
+        tmp4 = (pMCUSrc[1] * pQuant[1] * 167) >> 8;
+        tmp5 = (pMCUSrc[9] * pQuant[9] * 109) >> 8;
         tmp1 = tmp4 + tmp5;
         tmp3 = tmp4 - tmp5;
         /* Pass 2: process 2 rows, store into output array. */
@@ -1565,7 +1595,7 @@ static void JPEGPutMCUGray(JPEGIMAGE *pJPEG, int x, int y) {
         }
     } else {
         // must be RGB565 output
-        const int iPitch = pJPEG->iWidth;
+        const int iPitch = pJPEG->iPitch;
         uint16_t *usDest = (uint16_t *) &pJPEG->pImage[(y * iPitch * 2) + x * 2];
 
         for (i = 0; i < ycount; i++) {
@@ -1581,8 +1611,8 @@ static void JPEGPutMCUGray(JPEGIMAGE *pJPEG, int x, int y) {
 }
 
 static void JPEGPutMCU8BitGray(JPEGIMAGE *pJPEG, int x, int y) {
-    int i, j, xcount, ycount;
-    const int iPitch = pJPEG->iWidth;
+    int i, j, xcount, ycount, iSrcPitch;
+    const int iPitch = pJPEG->iPitch;
     uint8_t *pDest, *pSrc = (uint8_t *) &pJPEG->sMCUs[0];
     pDest = (uint8_t *) &pJPEG->pImage[(y * iPitch) + x];
     if (pJPEG->ucSubSample <= 0x11) {
@@ -1601,16 +1631,17 @@ static void JPEGPutMCU8BitGray(JPEGIMAGE *pJPEG, int x, int y) {
             }
             return;
         }
-        xcount = ycount = 8; // debug
+        xcount = ycount = iSrcPitch = 8; // debug
         if (pJPEG->iOptions & JPEG_SCALE_QUARTER) {
-            xcount = ycount = 2;
+            // the scaled IDCT output is packed
+            xcount = ycount = iSrcPitch = 2;
         } else if (pJPEG->iOptions & JPEG_SCALE_EIGHTH) {
-            xcount = ycount = 1;
+            xcount = ycount = iSrcPitch = 1;
         }
-        if ((x + 8) > pJPEG->iWidth) {
+        if (xcount == 8 && (x + 8) > pJPEG->iWidth) {
             xcount = pJPEG->iWidth & 7;
         }
-        if ((y + 8) > pJPEG->iHeight) {
+        if (ycount == 8 && (y + 8) > pJPEG->iHeight) {
             ycount = pJPEG->iHeight & 7;
         }
         for (i = 0; i < ycount; i++) {
@@ -1618,7 +1649,7 @@ static void JPEGPutMCU8BitGray(JPEGIMAGE *pJPEG, int x, int y) {
             for (j = 0; j < xcount; j++) {
                 *pDest++ = *pSrc++;
             }
-            pSrc += (8 - xcount);
+            pSrc += (iSrcPitch - xcount);
             pDest -= xcount;
             pDest += iPitch; // next line
         }
@@ -2045,7 +2076,7 @@ static void JPEGPutMCU11(JPEGIMAGE *pJPEG, int x, int y) {
     int iCr, iCb;
     signed int Y;
     int iCol, iRow, cx, cy;
-    const int iPitch = pJPEG->iWidth;
+    const int iPitch = pJPEG->iPitch;
     uint8_t *pY, *pCr, *pCb;
     uint16_t *pOutput = (uint16_t *) &pJPEG->pImage[(y * iPitch * 2) + x * 2];
 
@@ -2128,7 +2159,7 @@ static void JPEGPutMCU22(JPEGIMAGE *pJPEG, int x, int y) {
     signed int Y1, Y2, Y3, Y4;
     int iRow, iRowLimit, iCol, iXCount1, iXCount2;
     unsigned char *pY, *pCr, *pCb;
-    const int iPitch = pJPEG->iWidth;
+    const int iPitch = pJPEG->iPitch;
     int bUseOdd1, bUseOdd2; // special case where 24bpp odd sized image can clobber first column
     uint16_t *pOutput = (uint16_t *) &pJPEG->pImage[(y * iPitch * 2) + x * 2];
 
@@ -2370,7 +2401,7 @@ static void JPEGPutMCU12(JPEGIMAGE *pJPEG, int x, int y) {
     signed int Y1, Y2;
     int iRow, iCol, iXCount, iYCount;
     uint8_t *pY, *pCr, *pCb;
-    const int iPitch = pJPEG->iWidth;
+    const int iPitch = pJPEG->iPitch;
     uint16_t *pOutput = (uint16_t *) &pJPEG->pImage[(y * iPitch * 2) + x * 2];
 
     pY = (uint8_t *) &pJPEG->sMCUs[0 * DCTSIZE];
@@ -2477,7 +2508,7 @@ static void JPEGPutMCU21(JPEGIMAGE *pJPEG, int x, int y) {
     int iCol;
     int iRow, iXCount, iYCount;
     uint8_t *pY, *pCr, *pCb;
-    const int iPitch = pJPEG->iWidth;
+    const int iPitch = pJPEG->iPitch;
     uint16_t *pOutput = (uint16_t *) &pJPEG->pImage[(y * iPitch * 2) + x * 2];
 
     pY = (uint8_t *) &pJPEG->sMCUs[0 * DCTSIZE];
@@ -2594,6 +2625,7 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
     uint32_t l, *pl;
     unsigned char cDCTable0, cACTable0, cDCTable1, cACTable1, cDCTable2, cACTable2;
     int iMaxFill = 16, iScaleShift = 0;
+    int iLumBlocks, iPutY, iCropX0, iCropX1, iCropY0, iCropY1;
 
     // Requested the Exif thumbnail
     if (pJPEG->iOptions & JPEG_EXIF_THUMBNAIL) {
@@ -2643,6 +2675,7 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
             iCr = MCU1;
             iCb = MCU2;
             mcuCX = mcuCY = 8;
+            iLumBlocks = 1;
             break;
         case 0x12:
             cx = (pJPEG->iWidth + 7) >> 3;    // number of MCU blocks
@@ -2651,6 +2684,7 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
             iCb = MCU3;
             mcuCX = 8;
             mcuCY = 16;
+            iLumBlocks = 2;
             break;
         case 0x21:
             cx = (pJPEG->iWidth + 15) >> 4;    // number of MCU blocks
@@ -2659,6 +2693,7 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
             iCb = MCU3;
             mcuCX = 16;
             mcuCY = 8;
+            iLumBlocks = 2;
             break;
         case 0x22:
             cx = (pJPEG->iWidth + 15) >> 4;    // number of MCU blocks
@@ -2666,12 +2701,24 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
             iCr = MCU4;
             iCb = MCU5;
             mcuCX = mcuCY = 16;
+            iLumBlocks = 4;
             break;
         default: // to suppress compiler warning
             cx = cy = 0;
             iCr = iCb = 0;
+            iLumBlocks = 0;
             break;
     }
+    // MCUs outside of the crop area are entropy decoded but not drawn
+    iCropX0 = iCropY0 = 0;
+    iCropX1 = cx;
+    iCropY1 = cy;
+    if (pJPEG->iCropCX > 0 && pJPEG->iCropCY > 0 && mcuCX > 0) {
+        iCropX0 = pJPEG->iCropX / mcuCX;
+        iCropY0 = pJPEG->iCropY / mcuCY;
+        iCropX1 = IM_MIN((pJPEG->iCropX + pJPEG->iCropCX + mcuCX - 1) / mcuCX, cx);
+        iCropY1 = IM_MIN((pJPEG->iCropY + pJPEG->iCropCY + mcuCY - 1) / mcuCY, cy);
+    }
     // Scale down the MCUs by the requested amount
     mcuCX >>= iScaleShift;
     mcuCY >>= iScaleShift;
@@ -2702,138 +2749,158 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
         // dithered, override the max MCU count
         iMCUCount = cx; // do the whole row
     }
-    for (y = 0; y < cy && bContinue; y++) {
+    for (y = 0; y < iCropY1 && bContinue; y++) {
+        // when drawing a row of MCUs at a time every row starts at the top of the output buffer
+        iPutY = (pJPEG->pfnDraw) ? 0 : (y * mcuCY);
         for (x = 0; x < cx && bContinue && iErr == 0; x++) {
-            pJPEG->ucACTable = cACTable0;
-            pJPEG->ucDCTable = cDCTable0;
-            // do the first luminance component
-            iErr = JPEGDecodeMCU(pJPEG, iLum0, &iDCPred0);
-            if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
-                // no AC components, save some time
-                pl = (uint32_t *) &pJPEG->sMCUs[iLum0];
-                c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
-                l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
-                // dct stores byte values
-                for (i = 0; i < iMaxFill; i++) {
-                    // 8x8 bytes = 16 longs
-                    pl[i] = l;
+            if ((y < iCropY0) || (x < iCropX0) || (x >= iCropX1)) {
+                // outside of the crop area, only the entropy decoder has to advance
+                pJPEG->ucACTable = cACTable0;
+                pJPEG->ucDCTable = cDCTable0;
+                iErr = 0;
+                for (i = 0; i < iLumBlocks; i++) {
+                    iErr |= JPEGDecodeMCU(pJPEG, iLum0, &iDCPred0);
+                }
+                if (pJPEG->ucSubSample && pJPEG->ucNumComponents == 3) {
+                    pJPEG->ucACTable = cACTable1;
+                    pJPEG->ucDCTable = cDCTable1;
+                    iErr |= JPEGDecodeMCU(pJPEG, iCr, &iDCPred1);
+                    pJPEG->ucACTable = cACTable2;
+                    pJPEG->ucDCTable = cDCTable2;
+                    iErr |= JPEGDecodeMCU(pJPEG, iCb, &iDCPred2);
                 }
             } else {
-                // first quantization table
-                JPEGIDCT(pJPEG, iLum0, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
-            }
-            // do the second luminance component
-            if (pJPEG->ucSubSample > 0x11) {
-                // subsampling
-                iErr |= JPEGDecodeMCU(pJPEG, iLum1, &iDCPred0);
+                pJPEG->ucACTable = cACTable0;
+                pJPEG->ucDCTable = cDCTable0;
+                // do the first luminance component
+                iErr = JPEGDecodeMCU(pJPEG, iLum0, &iDCPred0);
                 if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
                     // no AC components, save some time
+                    pl = (uint32_t *) &pJPEG->sMCUs[iLum0];
                     c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
                     l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
                     // dct stores byte values
-                    pl = (uint32_t *) &pJPEG->sMCUs[iLum1];
                     for (i = 0; i < iMaxFill; i++) {
                         // 8x8 bytes = 16 longs
                         pl[i] = l;
                     }
                 } else {
                     // first quantization table
-                    JPEGIDCT(pJPEG, iLum1, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
+                    JPEGIDCT(pJPEG, iLum0, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
                 }
-                if (pJPEG->ucSubSample == 0x22) {
-                    iErr |= JPEGDecodeMCU(pJPEG, iLum2, &iDCPred0);
+                // do the second luminance component
+                if (pJPEG->ucSubSample > 0x11) {
+                    // subsampling
+                    iErr |= JPEGDecodeMCU(pJPEG, iLum1, &iDCPred0);
                     if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
                         // no AC components, save some time
                         c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
                         l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
                         // dct stores byte values
-                        pl = (uint32_t *) &pJPEG->sMCUs[iLum2];
+                        pl = (uint32_t *) &pJPEG->sMCUs[iLum1];
                         for (i = 0; i < iMaxFill; i++) {
                             // 8x8 bytes = 16 longs
                             pl[i] = l;
                         }
                     } else {
                         // first quantization table
-                        JPEGIDCT(pJPEG, iLum2, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
+                        JPEGIDCT(pJPEG, iLum1, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
                     }
-                    iErr |= JPEGDecodeMCU(pJPEG, iLum3, &iDCPred0);
+                    if (pJPEG->ucSubSample == 0x22) {
+                        iErr |= JPEGDecodeMCU(pJPEG, iLum2, &iDCPred0);
+                        if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
+                            // no AC components, save some time
+                            c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
+                            l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
+                            // dct stores byte values
+                            pl = (uint32_t *) &pJPEG->sMCUs[iLum2];
+                            for (i = 0; i < iMaxFill; i++) {
+                                // 8x8 bytes = 16 longs
+                                pl[i] = l;
+                            }
+                        } else {
+                            // first quantization table
+                            JPEGIDCT(pJPEG, iLum2, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
+                        }
+                        iErr |= JPEGDecodeMCU(pJPEG, iLum3, &iDCPred0);
+                        if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
+                            // no AC components, save some time
+                            c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
+                            l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
+                            // dct stores byte values
+                            pl = (uint32_t *) &pJPEG->sMCUs[iLum3];
+                            for (i = 0; i < iMaxFill; i++) {
+                                // 8x8 bytes = 16 longs
+                                pl[i] = l;
+                            }
+                        } else {
+                            // first quantization table
+                            JPEGIDCT(pJPEG, iLum3, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
+                        }
+                    } // if 2:2 subsampling
+                } // if subsampling used
+                if (pJPEG->ucSubSample && pJPEG->ucNumComponents == 3) {
+                    // if color (not CMYK)
+                    // first chroma
+                    pJPEG->ucACTable = cACTable1;
+                    pJPEG->ucDCTable = cDCTable1;
+                    iErr |= JPEGDecodeMCU(pJPEG, iCr, &iDCPred1);
                     if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
                         // no AC components, save some time
-                        c = ucRangeTable[((iDCPred0 * iQuant1) >> 5) & 0x3ff];
+                        c = ucRangeTable[((iDCPred1 * iQuant2) >> 5) & 0x3ff];
                         l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
                         // dct stores byte values
-                        pl = (uint32_t *) &pJPEG->sMCUs[iLum3];
+                        pl = (uint32_t *) &pJPEG->sMCUs[iCr];
                         for (i = 0; i < iMaxFill; i++) {
                             // 8x8 bytes = 16 longs
                             pl[i] = l;
                         }
                     } else {
-                        // first quantization table
-                        JPEGIDCT(pJPEG, iLum3, pJPEG->JPCI[0].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
-                    }
-                } // if 2:2 subsampling
-            } // if subsampling used
-            if (pJPEG->ucSubSample && pJPEG->ucNumComponents == 3) {
-                // if color (not CMYK)
-                // first chroma
-                pJPEG->ucACTable = cACTable1;
-                pJPEG->ucDCTable = cDCTable1;
-                iErr |= JPEGDecodeMCU(pJPEG, iCr, &iDCPred1);
-                if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
-                    // no AC components, save some time
-                    c = ucRangeTable[((iDCPred1 * iQuant2) >> 5) & 0x3ff];
-                    l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
-                    // dct stores byte values
-                    pl = (uint32_t *) &pJPEG->sMCUs[iCr];
-                    for (i = 0; i < iMaxFill; i++) {
-                        // 8x8 bytes = 16 longs
-                        pl[i] = l;
+                        // second quantization table
+                        JPEGIDCT(pJPEG, iCr, pJPEG->JPCI[1].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
                     }
-                } else {
-                    // second quantization table
-                    JPEGIDCT(pJPEG, iCr, pJPEG->JPCI[1].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
-                }
-                // second chroma
-                pJPEG->ucACTable = cACTable2;
-                pJPEG->ucDCTable = cDCTable2;
-                iErr |= JPEGDecodeMCU(pJPEG, iCb, &iDCPred2);
-                if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
-                    // no AC components, save some time
-                    c = ucRangeTable[((iDCPred2 * iQuant3) >> 5) & 0x3ff];
-                    l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
-                    // dct stores byte values
-                    pl = (uint32_t *) &pJPEG->sMCUs[iCb];
-                    for (i = 0; i < iMaxFill; i++) {
-                        // 8x8 bytes = 16 longs
-                        pl[i] = l;
+                    // second chroma
+                    pJPEG->ucACTable = cACTable2;
+                    pJPEG->ucDCTable = cDCTable2;
+                    iErr |= JPEGDecodeMCU(pJPEG, iCb, &iDCPred2);
+                    if (pJPEG->ucMaxACCol == 0 || bThumbnail) {
+                        // no AC components, save some time
+                        c = ucRangeTable[((iDCPred2 * iQuant3) >> 5) & 0x3ff];
+                        l = c | ((uint32_t) c << 8) | ((uint32_t) c << 16) | ((uint32_t) c << 24);
+                        // dct stores byte values
+                        pl = (uint32_t *) &pJPEG->sMCUs[iCb];
+                        for (i = 0; i < iMaxFill; i++) {
+                            // 8x8 bytes = 16 longs
+                            pl[i] = l;
+                        }
+                    } else {
+                        JPEGIDCT(pJPEG, iCb, pJPEG->JPCI[2].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
                     }
+                } // if color components present
+                if (pJPEG->ucPixelType == EIGHT_BIT_GRAYSCALE) {
+                    JPEGPutMCU8BitGray(pJPEG, x * mcuCX, iPutY);
+                } else if (pJPEG->ucPixelType == ONE_BIT_GRAYSCALE) {
+                    JPEGPutMCU1BitGray(pJPEG, x * mcuCX, iPutY);
                 } else {
-                    JPEGIDCT(pJPEG, iCb, pJPEG->JPCI[2].quant_tbl_no, (pJPEG->ucMaxACCol | (pJPEG->ucMaxACRow << 8)));
+                    switch (pJPEG->ucSubSample) {
+                        case 0x00: // grayscale
+                            JPEGPutMCUGray(pJPEG, x * mcuCX, iPutY);
+                            break; // not used
+                        case 0x11:
+                            JPEGPutMCU11(pJPEG, x * mcuCX, iPutY);
+                            break;
+                        case 0x12:
+                            JPEGPutMCU12(pJPEG, x * mcuCX, iPutY);
+                            break;
+                        case 0x21:
+                            JPEGPutMCU21(pJPEG, x * mcuCX, iPutY);
+                            break;
+                        case 0x22:
+                            JPEGPutMCU22(pJPEG, x * mcuCX, iPutY);
+                            break;
+                    } // switch on color option
                 }
-            } // if color components present
-            if (pJPEG->ucPixelType == EIGHT_BIT_GRAYSCALE) {
-                JPEGPutMCU8BitGray(pJPEG, x * mcuCX, y * mcuCY);
-            } else if (pJPEG->ucPixelType == ONE_BIT_GRAYSCALE) {
-                JPEGPutMCU1BitGray(pJPEG, x * mcuCX, y * mcuCY);
-            } else {
-                switch (pJPEG->ucSubSample) {
-                    case 0x00: // grayscale
-                        JPEGPutMCUGray(pJPEG, x * mcuCX, y * mcuCY);
-                        break; // not used
-                    case 0x11:
-                        JPEGPutMCU11(pJPEG, x * mcuCX, y * mcuCY);
-                        break;
-                    case 0x12:
-                        JPEGPutMCU12(pJPEG, x * mcuCX, y * mcuCY);
-                        break;
-                    case 0x21:
-                        JPEGPutMCU21(pJPEG, x * mcuCX, y * mcuCY);
-                        break;
-                    case 0x22:
-                        JPEGPutMCU22(pJPEG, x * mcuCX, y * mcuCY);
-                        break;
-                } // switch on color option
-            }
+            } // if inside the crop area
             if (pJPEG->iResInterval) {
                 if (--pJPEG->iResCount == 0) {
                     pJPEG->iResCount = pJPEG->iResInterval;
@@ -2850,6 +2917,18 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
                 JPEGGetMoreData(pJPEG); // need more 'filtered' VLC data
             }
         } // for x
+        if (pJPEG->pfnDraw && y >= iCropY0 && iErr == 0) {
+            // pass the finished row of MCUs to the draw callback
+            JPEGDRAW jd;
+            jd.x = 0;
+            jd.y = y * mcuCY;
+            jd.iWidth = pJPEG->iPitch;
+            jd.iHeight = mcuCY;
+            jd.iBpp = (pJPEG->ucPixelType == EIGHT_BIT_GRAYSCALE) ? 8 : 16;
+            jd.pPixels = (uint16_t *) pJPEG->pImage;
+            jd.pUser = pJPEG->pUser;
+            bContinue = (*pJPEG->pfnDraw)(&jd);
+        }
     } // for y
     if (iErr != 0) {
         pJPEG->iError = JPEG_DECODE_ERROR;
@@ -2857,7 +2936,69 @@ static int DecodeJPEG(JPEGIMAGE *pJPEG) {
     return (iErr == 0);
 }
 
-void jpeg_decompress(image_t *dst, image_t *src) {
+typedef struct jpeg_decompress_rows {
+    image_t *dst;
+    image_t rows;
+    int x_offset, y_offset;
+    jpeg_decompress_callback_t callback;
+    void *callback_arg;
+} jpeg_decompress_rows_t;
+
+// Copies a row of MCUs that overlaps the crop area to the output image or passes it to the callback.
+static int jpeg_decompress_draw(JPEGDRAW *pDraw) {
+    jpeg_decompress_rows_t *r = (jpeg_decompress_rows_t *) pDraw->pUser;
+    image_t *dst = r->callback ? &r->rows : r->dst;
+    int y_start = IM_MAX(pDraw->y, r->y_offset);
+    int y_end = IM_MIN(pDraw->y + pDraw->iHeight, r->y_offset + r->dst->h);
+
+    if (y_start >= y_end) {
+        return 1;
+    }
+
+    for (int y = y_start; y < y_end; y++) {
+        int dst_y = r->callback ? (y - y_start) : (y - r->y_offset);
+        size_t src_offset = ((y - pDraw->y) * pDraw->iWidth) + r->x_offset;
+
+        switch (dst->pixfmt) {
+            case PIXFORMAT_BINARY: {
+                uint8_t *src_row = ((uint8_t *) pDraw->pPixels) + src_offset;
+                uint32_t *dst_row = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, dst_y);
+                for (int x = 0; x < dst->w; x++) {
+                    IMAGE_PUT_BINARY_PIXEL_FAST(dst_row, x, src_row[x] > 127);
+                }
+                break;
+            }
+            case PIXFORMAT_GRAYSCALE: {
+                uint8_t *src_row = ((uint8_t *) pDraw->pPixels) + src_offset;
+                memcpy(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, dst_y), src_row, dst->w);
+                break;
+            }
+            case PIXFORMAT_RGB565: {
+                uint16_t *dst_row = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, dst_y);
+                if (pDraw->iBpp == 16) {
+                    memcpy(dst_row, pDraw->pPixels + src_offset, dst->w * sizeof(uint16_t));
+                } else {
+                    // Grayscale JPEGs are decoded to 8-bit and expanded here.
+                    uint8_t *src_row = ((uint8_t *) pDraw->pPixels) + src_offset;
+                    for (int x = 0; x < dst->w; x++) {
+                        dst_row[x] = usGrayTo565[src_row[x]];
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    if (r->callback) {
+        r->rows.h = y_end - y_start;
+        r->callback(r->callback_arg, &r->rows, y_start - r->y_offset);
+    }
+
+    return 1;
+}
+
+void jpeg_decompress_rect(image_t *dst, image_t *src, rectangle_t *roi, int scale,
+                          jpeg_decompress_callback_t callback, void *callback_arg) {
     JPEGIMAGE *jpg = uma_malloc(sizeof(JPEGIMAGE), UMA_FAST);
 
     // Supports decoding baseline JPEGs only.
@@ -2866,7 +3007,7 @@ void jpeg_decompress(image_t *dst, image_t *src) {
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Non-Baseline JPEGs are not supported."));
     }
 
-    if (JPEG_openRAM(jpg, src->data, src->size, dst->data) == 0) {
+    if (JPEG_openRAM(jpg, src->data, src->size, NULL) == 0) {
         // failed to parse the header
         uma_free(jpg);
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("JPEG decoder failed."));
@@ -2874,34 +3015,84 @@ void jpeg_decompress(image_t *dst, image_t *src) {
 
     switch (dst->pixfmt) {
         case PIXFORMAT_BINARY:
-            // Force 1-bit (binary) output in the draw function.
-            jpg->ucPixelType = ONE_BIT_GRAYSCALE;
-            break;
         case PIXFORMAT_GRAYSCALE:
-            // Force 8-bit grayscale output.
             jpg->ucPixelType = EIGHT_BIT_GRAYSCALE;
             break;
         case PIXFORMAT_RGB565:
-            // Force output to be RGB565
-            jpg->ucPixelType = RGB565_LITTLE_ENDIAN;
+            // Grayscale JPEGs have no scaled RGB565 output, they are expanded when copied out.
+            jpg->ucPixelType = (jpg->ucSubSample == 0x00) ? EIGHT_BIT_GRAYSCALE : RGB565_LITTLE_ENDIAN;
             break;
         default:
             uma_free(jpg);
             mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Unsupported format."));
     }
 
-    // Set up dest image params
-    jpg->pUser = (void *) dst;
+    int shift = (scale == 8) ? 3 : (scale == 4) ? 2 : (scale == 2) ? 1 : 0;
+    int options = (scale == 8) ? JPEG_SCALE_EIGHTH : (scale == 4) ? JPEG_SCALE_QUARTER :
+                  (scale == 2) ? JPEG_SCALE_HALF : 0;
+
+    // One row of MCUs is decoded at a time, the rows are sized for the largest (16x16) MCUs.
+    jpg->iPitch = ((jpg->iWidth + 15) & ~15) >> shift;
+    size_t bpp = (jpg->ucPixelType == EIGHT_BIT_GRAYSCALE) ? sizeof(uint8_t) : sizeof(uint16_t);
+    jpg->pImage = uma_malloc(jpg->iPitch * (16 >> shift) * bpp, UMA_FAST);
+
+    jpeg_decompress_rows_t rows = {
+        .dst = dst,
+        .rows = { .w = dst->w, .h = 16 >> shift, .pixfmt = dst->pixfmt },
+        .x_offset = roi->x >> shift,
+        .y_offset = roi->y >> shift,
+        .callback = callback,
+        .callback_arg = callback_arg,
+    };
+
+    if (callback) {
+        rows.rows.data = uma_malloc(image_size(&rows.rows), UMA_FAST);
+    }
+
+    jpg->pUser = &rows;
+    jpg->pfnDraw = jpeg_decompress_draw;
+    JPEG_setCropArea(jpg, roi->x, roi->y, roi->w, roi->h);
+
+    bool ok = JPEG_decode(jpg, 0, 0, options);
 
-    // Fill buffer with 0's so we only need to write "set" bits
-    memset(dst->data, 0, image_size(dst));
+    if (callback) {
+        uma_free(rows.rows.data);
+    }
 
-    // Start decoding.
-    bool ok = JPEG_decode(jpg, 0, 0, 0);
+    uma_free(jpg->pImage);
     uma_free(jpg);
 
     if (!ok) {
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("JPEG decoder failed."));
     }
 }
+
+void jpeg_decompress(image_t *dst, image_t *src) {
+    rectangle_t roi = { 0, 0, dst->w, dst->h };
+    jpeg_decompress_rect(dst, src, &roi, 1, NULL, NULL);
+}
+#else
+// The hardware decoder only outputs whole frames, so decode the frame and crop/scale it.
+void jpeg_decompress_rect(image_t *dst, image_t *src, rectangle_t *roi, int scale,
+                          jpeg_decompress_callback_t callback, void *callback_arg) {
+    image_t frame = { .w = src->w, .h = src->h, .pixfmt = dst->pixfmt };
+    frame.data = uma_malloc(image_size(&frame), UMA_CACHE);
+    jpeg_decompress(&frame, src);
+
+    image_t out = *dst;
+
+    if (callback) {
+        out.data = uma_malloc(image_size(&out), UMA_CACHE);
+    }
+
+    float s = 1.0f / scale;
+    imlib_draw_image(&out, &frame, 0, 0, s, s, roi, -1, 255, NULL, NULL,
+                     (scale > 1) ? IMAGE_HINT_AREA : 0, NULL, NULL, NULL, NULL);
+    uma_free(frame.data);
+
+    if (callback) {
+        callback(callback_arg, &out, 0);
+        uma_free(out.data);
+    }
+}
 #endif
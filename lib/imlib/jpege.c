@@ -27,6 +27,8 @@
  */
 #include "imlib.h"
 #include "file_utils.h"
+#include "simd.h"
+#include "trace.h"
 
 // Expand 4 bits to 32 for binary to grayscale - process 4 pixels at a time
 #if (OMV_JPEG_CODEC_ENABLE == 1)
@@ -331,21 +333,17 @@ void jpeg_get_mcu(image_t *src, int x_offset, int y_offset, int dx, int dy,
 #define FIX_0_707106781    ((int32_t) 181)
 #define FIX_1_306562965    ((int32_t) 334)
 
-#define DESCALE(x, y)      (x >> y)
-#define MULTIPLY(x, y)     DESCALE((x) * (y), 8)
+#define MULTIPLY(x, y)     vasr_s32(vmul_n_s32(x, y), 8)
 
+// Quantization divisors with the AAN output scaling folded in. Each coefficient
+// is quantized as (|x| * recip + round) >> shift with a 16-bit reciprocal.
 typedef struct {
-    int idx;
-    int length;
-    uint8_t *buf;
-    uint32_t bitb;
-    uint32_t bitc;
-    bool realloc;
-    bool overflow;
-} jpeg_buf_t;
+    uint16_t recip[64];
+    uint8_t shift[64];
+} jpeg_qtbl_t;
 
 // Quantization tables
-static float fdtbl_Y[64], fdtbl_UV[64];
+static jpeg_qtbl_t qtbl_Y, qtbl_UV;
 static uint8_t YTable[64], UVTable[64];
 
 static const uint8_t s_jpeg_ZigZag[] = {
@@ -626,21 +624,64 @@ static void jpeg_put_bytes(jpeg_buf_t *jpeg_buf, const void *data, int size) {
     jpeg_buf->idx += size;
 }
 
-static inline void jpeg_write_bits(jpeg_buf_t *jpeg_buf, const uint16_t *bs) {
-    jpeg_buf->bitc += bs[1];
-    jpeg_buf->bitb |= bs[0] << (24 - jpeg_buf->bitc);
+static inline void jpeg_put_byte_stuffed(jpeg_buf_t *jpeg_buf, uint8_t c) {
+    jpeg_put_char(jpeg_buf, c);
+    if (c == 255) {
+        jpeg_put_char(jpeg_buf, 0);
+    }
+}
+
+// Writes out the top 32 bits of the bit buffer. Words without a 0xFF byte (that
+// would need a 0x00 stuffed after it) are stored with a single space check.
+static void jpeg_flush_word(jpeg_buf_t *jpeg_buf) {
+    uint32_t word = jpeg_buf->bitb >> 32;
+    jpeg_buf->bitb <<= 32;
+    jpeg_buf->bitc -= 32;
+
+    if ((((~word - 0x01010101) & word & 0x80808080) == 0) && ((jpeg_buf->idx + 4) < jpeg_buf->length)) {
+        uint8_t *p = jpeg_buf->buf + jpeg_buf->idx;
+        p[0] = word >> 24;
+        p[1] = word >> 16;
+        p[2] = word >> 8;
+        p[3] = word;
+        jpeg_buf->idx += 4;
+    } else {
+        jpeg_put_byte_stuffed(jpeg_buf, word >> 24);
+        jpeg_put_byte_stuffed(jpeg_buf, word >> 16);
+        jpeg_put_byte_stuffed(jpeg_buf, word >> 8);
+        jpeg_put_byte_stuffed(jpeg_buf, word);
+    }
+}
 
+// Writes out all whole bytes left in the bit buffer.
+static void jpeg_flush_bits(jpeg_buf_t *jpeg_buf) {
     while (jpeg_buf->bitc > 7) {
-        uint8_t c = (jpeg_buf->bitb >> 16) & 255;
-        jpeg_put_char(jpeg_buf, c);
-        if (c == 255) {
-            jpeg_put_char(jpeg_buf, 0);
-        }
+        jpeg_put_byte_stuffed(jpeg_buf, jpeg_buf->bitb >> 56);
         jpeg_buf->bitb <<= 8;
         jpeg_buf->bitc -= 8;
     }
 }
 
+// Appends the n (1 to 32) low bits of value. Less than 32 bits are ever left
+// buffered, so the 64-bit buffer can not overflow.
+static inline void jpeg_write_bits_n(jpeg_buf_t *jpeg_buf, uint32_t value, uint32_t n) {
+    jpeg_buf->bitc += n;
+    jpeg_buf->bitb |= ((uint64_t) value) << (64 - jpeg_buf->bitc);
+
+    if (jpeg_buf->bitc >= 32) {
+        jpeg_flush_word(jpeg_buf);
+    }
+}
+
+static inline void jpeg_write_bits(jpeg_buf_t *jpeg_buf, const uint16_t *bs) {
+    jpeg_write_bits_n(jpeg_buf, bs[0], bs[1]);
+}
+
+// Writes a Huffman code followed by its magnitude bits (at most 27 bits).
+static inline void jpeg_write_code(jpeg_buf_t *jpeg_buf, const uint16_t *code, const uint16_t *bits) {
+    jpeg_write_bits_n(jpeg_buf, (code[0] << bits[1]) | bits[0], code[1] + bits[1]);
+}
+
 //Huffman-encoded magnitude value
 static inline void jpeg_calc_bits(int val, uint16_t bits[2]) {
     int t1 = val;
@@ -652,111 +693,117 @@ static inline void jpeg_calc_bits(int val, uint16_t bits[2]) {
     bits[0] = val & ((1 << bits[1]) - 1);
 }
 
-static int jpeg_processDU(jpeg_buf_t *jpeg_buf, int8_t *CDU, float *fdtbl, int DC, const uint16_t (*HTDC)[2],
-                          const uint16_t (*HTAC)[2]) {
-    int DU[64];
-    int DUQ[64];
-    int z1, z2, z3, z4, z5, z11, z13;
-    int t0, t1, t2, t3, t4, t5, t6, t7, t10, t11, t12, t13;
-    const uint16_t EOB[2] = { HTAC[0x00][0], HTAC[0x00][1] };
-    const uint16_t M16zeroes[2] = { HTAC[0xF0][0], HTAC[0xF0][1] };
+// One AAN forward DCT pass. Each lane runs an independent 1-D DCT over the 8 vectors.
+static inline void jpeg_fdct_pass(v128_t *d) {
+    v128_t t0 = vadd_s32(d[0], d[7]);
+    v128_t t1 = vadd_s32(d[1], d[6]);
+    v128_t t2 = vadd_s32(d[2], d[5]);
+    v128_t t3 = vadd_s32(d[3], d[4]);
+
+    v128_t t7 = vsub_s32(d[0], d[7]);
+    v128_t t6 = vsub_s32(d[1], d[6]);
+    v128_t t5 = vsub_s32(d[2], d[5]);
+    v128_t t4 = vsub_s32(d[3], d[4]);
+
+    // Even part
+    v128_t t10 = vadd_s32(t0, t3);  // phase 2
+    v128_t t13 = vsub_s32(t0, t3);
+    v128_t t11 = vadd_s32(t1, t2);
+    v128_t t12 = vsub_s32(t1, t2);
+    v128_t z1 = MULTIPLY(vadd_s32(t12, t13), FIX_0_707106781); // c4
+
+    d[0] = vadd_s32(t10, t11);      // phase 3
+    d[4] = vsub_s32(t10, t11);
+    d[2] = vadd_s32(t13, z1);       // phase 5
+    d[6] = vsub_s32(t13, z1);
+
+    // Odd part
+    t10 = vadd_s32(t4, t5);         // phase 2
+    t11 = vadd_s32(t5, t6);
+    t12 = vadd_s32(t6, t7);
+
+    // The rotator is modified from fig 4-8 to avoid extra negations.
+    v128_t z5 = MULTIPLY(vsub_s32(t10, t12), FIX_0_382683433); // c6
+    v128_t z2 = vadd_s32(MULTIPLY(t10, FIX_0_541196100), z5); // 1.306562965f-c6
+    v128_t z4 = vadd_s32(MULTIPLY(t12, FIX_1_306562965), z5); // 1.306562965f+c6
+    v128_t z3 = MULTIPLY(t11, FIX_0_707106781); // c4
+    v128_t z11 = vadd_s32(t7, z3);  // phase 5
+    v128_t z13 = vsub_s32(t7, z3);
+
+    d[5] = vadd_s32(z13, z2);       // phase 6
+    d[3] = vsub_s32(z13, z2);
+    d[1] = vadd_s32(z11, z4);
+    d[7] = vsub_s32(z11, z4);
+}
+
+// 2-D DCT of an 8x8 block. The column pass runs on INT32_VECTOR_SIZE columns at a time and
+// stores its output transposed so that the row pass can load whole vectors again. The passes
+// use int32 lanes (4 columns per vector on MVE) rather than 8 int16 lanes: simd.h has no signed
+// high multiply for int16, the AAN multipliers (up to 1.3066) don't fit Q15, and the row pass
+// intermediates times the multipliers overflow int16.
+static void jpeg_fdct(const int8_t *CDU, int32_t *DU) {
+    int32_t tmp[64];
+    v128_t offsets = vidup_u32(0, 8);
+
+    for (int c = 0; c < 8; c += INT32_VECTOR_SIZE) {
+        v128_t d[8];
 
-    // DCT rows
-    for (int i = 8, *p = DU; i > 0; i--, p += 8, CDU += 8) {
-        t0 = CDU[0] + CDU[7];
-        t1 = CDU[1] + CDU[6];
-        t2 = CDU[2] + CDU[5];
-        t3 = CDU[3] + CDU[4];
-
-        t7 = CDU[0] - CDU[7];
-        t6 = CDU[1] - CDU[6];
-        t5 = CDU[2] - CDU[5];
-        t4 = CDU[3] - CDU[4];
-
-        // Even part
-        t10 = t0 + t3;
-        t13 = t0 - t3;
-        t11 = t1 + t2;
-        t12 = t1 - t2;
-        z1 = MULTIPLY(t12 + t13, FIX_0_707106781); // c4
-
-        p[0] = t10 + t11;
-        p[4] = t10 - t11;
-        p[2] = t13 + z1;
-        p[6] = t13 - z1;
-
-        // Odd part
-        t10 = t4 + t5;// phase 2
-        t11 = t5 + t6;
-        t12 = t6 + t7;
-
-        // The rotator is modified from fig 4-8 to avoid extra negations.
-        z5 = MULTIPLY(t10 - t12, FIX_0_382683433); // c6
-        z2 = MULTIPLY(t10, FIX_0_541196100) + z5; // 1.306562965f-c6
-        z4 = MULTIPLY(t12, FIX_1_306562965) + z5; // 1.306562965f+c6
-        z3 = MULTIPLY(t11, FIX_0_707106781); // c4
-        z11 = t7 + z3;    // phase 5
-        z13 = t7 - z3;
-
-        p[5] = z13 + z2;// phase 6
-        p[3] = z13 - z2;
-        p[1] = z11 + z4;
-        p[7] = z11 - z4;
+        for (int r = 0; r < 8; r++) {
+            d[r] = vldr_s8_widen_s32(CDU + (r * 8) + c);
+        }
+
+        jpeg_fdct_pass(d);
+
+        for (int r = 0; r < 8; r++) {
+            vstr_s32_scatter(tmp + (c * 8) + r, offsets, d[r]);
+        }
     }
 
-    // DCT columns
-    for (int i = 8, *p = DU; i > 0; i--, p++) {
-        t0 = p[0] + p[56];
-        t1 = p[8] + p[48];
-        t2 = p[16] + p[40];
-        t3 = p[24] + p[32];
-
-        t7 = p[0] - p[56];
-        t6 = p[8] - p[48];
-        t5 = p[16] - p[40];
-        t4 = p[24] - p[32];
-
-        // Even part
-        t10 = t0 + t3;  // phase 2
-        t13 = t0 - t3;
-        t11 = t1 + t2;
-        t12 = t1 - t2;
-        z1 = MULTIPLY(t12 + t13, FIX_0_707106781); // c4
-
-        p[0] = t10 + t11;               // phase 3
-        p[32] = t10 - t11;
-        p[16] = t13 + z1;               // phase 5
-        p[48] = t13 - z1;
-
-        // Odd part
-        t10 = t4 + t5;          // phase 2
-        t11 = t5 + t6;
-        t12 = t6 + t7;
-
-        // The rotator is modified from fig 4-8 to avoid extra negations.
-        z5 = MULTIPLY(t10 - t12, FIX_0_382683433); // c6
-        z2 = MULTIPLY(t10, FIX_0_541196100) + z5; // 1.306562965f-c6
-        z4 = MULTIPLY(t12, FIX_1_306562965) + z5; // 1.306562965f+c6
-        z3 = MULTIPLY(t11, FIX_0_707106781); // c4
-        z11 = t7 + z3;          // phase 5
-        z13 = t7 - z3;
-
-        p[40] = z13 + z2;// phase 6
-        p[24] = z13 - z2;
-        p[8] = z11 + z4;
-        p[56] = z11 - z4;
+    for (int r = 0; r < 8; r += INT32_VECTOR_SIZE) {
+        v128_t d[8];
+
+        for (int c = 0; c < 8; c++) {
+            d[c] = vldr_s32(tmp + (c * 8) + r);
+        }
+
+        jpeg_fdct_pass(d);
+
+        for (int c = 0; c < 8; c++) {
+            vstr_s32_scatter(DU + (r * 8) + c, offsets, d[c]);
+        }
     }
+}
+
+// Transforms and quantizes an 8x8 block into zigzag order. Returns the position of the last
+// non-zero coefficient.
+static inline int jpeg_fdct_quant(const int8_t *CDU, const jpeg_qtbl_t *qtbl, int *DUQ) {
+    int32_t DU[64];
+
+    jpeg_fdct(CDU, DU);
 
     // first non-zero element in reverse order
     int end0pos = 0;
     // Quantize/descale/zigzag the coefficients
     for (int i = 0; i < 64; ++i) {
-        DUQ[s_jpeg_ZigZag[i]] = fast_roundf(DU[i] * fdtbl[i]);
+        uint32_t shift = qtbl->shift[i];
+        int q = ((((uint32_t) abs(DU[i])) * qtbl->recip[i]) + (1 << (shift - 1))) >> shift;
+        DUQ[s_jpeg_ZigZag[i]] = (DU[i] < 0) ? -q : q;
         if (s_jpeg_ZigZag[i] > end0pos && DUQ[s_jpeg_ZigZag[i]]) {
             end0pos = s_jpeg_ZigZag[i];
         }
     }
 
+    return end0pos;
+}
+
+static int jpeg_processDU(jpeg_buf_t *jpeg_buf, int8_t *CDU, const jpeg_qtbl_t *qtbl, int DC,
+                          const uint16_t (*HTDC)[2], const uint16_t (*HTAC)[2]) {
+    int DUQ[64];
+    const uint16_t EOB[2] = { HTAC[0x00][0], HTAC[0x00][1] };
+    const uint16_t M16zeroes[2] = { HTAC[0xF0][0], HTAC[0xF0][1] };
+
+    int end0pos = jpeg_fdct_quant(CDU, qtbl, DUQ);
+
     if (jpeg_check_highwater(jpeg_buf)) {
         // check if we're getting close to the end of the buffer
         return 0; // stop encoding, we've run out of space
@@ -769,8 +816,7 @@ static int jpeg_processDU(jpeg_buf_t *jpeg_buf, int8_t *CDU, float *fdtbl, int D
     } else {
         uint16_t bits[2];
         jpeg_calc_bits(diff, bits);
-        jpeg_write_bits(jpeg_buf, HTDC[bits[1]]);
-        jpeg_write_bits(jpeg_buf, bits);
+        jpeg_write_code(jpeg_buf, HTDC[bits[1]], bits);
     }
 
     // Encode ACs
@@ -793,8 +839,7 @@ static int jpeg_processDU(jpeg_buf_t *jpeg_buf, int8_t *CDU, float *fdtbl, int D
         }
         uint16_t bits[2];
         jpeg_calc_bits(DUQ[i], bits);
-        jpeg_write_bits(jpeg_buf, HTAC[(nrzeroes << 4) + bits[1]]);
-        jpeg_write_bits(jpeg_buf, bits);
+        jpeg_write_code(jpeg_buf, HTAC[(nrzeroes << 4) + bits[1]], bits);
     }
     if (end0pos != 63) {
         jpeg_write_bits(jpeg_buf, EOB);
@@ -802,8 +847,26 @@ static int jpeg_processDU(jpeg_buf_t *jpeg_buf, int8_t *CDU, float *fdtbl, int D
     return DUQ[0];
 }
 
+// Stores 1 / div as a reciprocal in [32768, 65535] and the matching shift.
+static void jpeg_set_divisor(jpeg_qtbl_t *qtbl, int i, float div) {
+    float recip = 1.0f / div;
+    int shift = 16;
+
+    // Normalize the reciprocal to [32768, 65535], divisors below 1 need a smaller shift.
+    while ((recip * (1 << shift)) >= 65535.5f) {
+        shift--;
+    }
+
+    while ((recip * (1 << shift)) < 32767.5f) {
+        shift++;
+    }
+
+    qtbl->recip[i] = IM_MIN(fast_roundf(recip * (1 << shift)), 0xFFFF);
+    qtbl->shift[i] = shift;
+}
+
 static void jpeg_init(int quality) {
-    static int q = 0;
+    static int q = -1;
 
     quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
 
@@ -819,8 +882,8 @@ static void jpeg_init(int quality) {
 
         for (int r = 0, k = 0; r < 8; ++r) {
             for (int c = 0; c < 8; ++c, ++k) {
-                fdtbl_Y[k] = 1.0f / (aasf[r] * aasf[c] * YTable [s_jpeg_ZigZag[k]] * 8.0f);
-                fdtbl_UV[k] = 1.0f / (aasf[r] * aasf[c] * UVTable[s_jpeg_ZigZag[k]] * 8.0f);
+                jpeg_set_divisor(&qtbl_Y, k, aasf[r] * aasf[c] * YTable [s_jpeg_ZigZag[k]] * 8.0f);
+                jpeg_set_divisor(&qtbl_UV, k, aasf[r] * aasf[c] * UVTable[s_jpeg_ZigZag[k]] * 8.0f);
             }
         }
     }
@@ -930,32 +993,15 @@ static void jpeg_write_headers(jpeg_buf_t *jpeg_buf, int w, int h, int bpp, jpeg
     jpeg_put_bytes(jpeg_buf, (uint8_t [3]) {0x00, 0x3F, 0x0}, 3);
 }
 
-bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
+void jpeg_encoder_start(jpeg_encoder_t *enc, image_t *dst, int w, int h, bool is_color,
+                        int quality, bool realloc, jpeg_subsampling_t subsampling) {
     if (!dst->data) {
         uint32_t size = IM_MIN(uma_avail(0), JPEG_MAX_ALLOC_SIZE);
         dst->data = uma_malloc(size, UMA_CACHE);
         dst->size = IMLIB_IMAGE_MAX_SIZE(size);
     }
 
-    if (src->is_compressed) {
-        return true;
-    }
-
-    // JPEG buffer
-    jpeg_buf_t jpeg_buf = {
-        .idx = 0,
-        .buf = dst->data,
-        .length = dst->size,
-        .bitc = 0,
-        .bitb = 0,
-        .realloc = realloc,
-        .overflow = false,
-    };
-
-    // Initialize quantization tables
-    jpeg_init(quality);
-
-    if (src->is_color) {
+    if (is_color) {
         if (subsampling == JPEG_SUBSAMPLING_AUTO) {
             if (quality <= 35) {
                 subsampling = JPEG_SUBSAMPLING_420;
@@ -969,11 +1015,32 @@ bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_s
         subsampling = JPEG_SUBSAMPLING_444;
     }
 
-    jpeg_write_headers(&jpeg_buf, src->w, src->h, src->is_color ? 2 : 1, subsampling);
+    *enc = (jpeg_encoder_t) {
+        .buf = {
+            .idx = 0,
+            .buf = dst->data,
+            .length = dst->size,
+            .bitc = 0,
+            .bitb = 0,
+            .realloc = realloc,
+            .overflow = false,
+        },
+        .dst = dst,
+        // 4:2:0 MCUs cover two rows of blocks.
+        .band_h = (subsampling == JPEG_SUBSAMPLING_420) ? (JPEG_MCU_H * 2) : JPEG_MCU_H,
+        .is_color = is_color,
+        .subsampling = subsampling,
+    };
+
+    // Initialize quantization tables
+    jpeg_init(quality);
+    jpeg_write_headers(&enc->buf, w, h, is_color ? 2 : 1, subsampling);
+}
 
-    int DCY = 0, DCU = 0, DCV = 0;
+bool jpeg_encoder_band(jpeg_encoder_t *enc, image_t *src, int y) {
+    int DCY = enc->DCY, DCU = enc->DCU, DCV = enc->DCV;
 
-    switch (subsampling) {
+    switch (enc->subsampling) {
         // Quiet GCC compiler warning (this is never reached)
         case JPEG_SUBSAMPLING_AUTO: {
             break;
@@ -983,23 +1050,17 @@ bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_s
             int8_t UDU[JPEG_444_GS_MCU_SIZE];
             int8_t VDU[JPEG_444_GS_MCU_SIZE];
 
-            for (int y_offset = 0; y_offset < src->h; y_offset += JPEG_MCU_H) {
-                int dy = IM_MIN(JPEG_MCU_H, src->h - y_offset);
-
-                for (int x_offset = 0; x_offset < src->w; x_offset += JPEG_MCU_W) {
-                    int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
+            int dy = IM_MIN(JPEG_MCU_H, src->h - y);
 
-                    jpeg_get_mcu(src, x_offset, y_offset, dx, dy, YDU, UDU, VDU);
-                    DCY = jpeg_processDU(&jpeg_buf, YDU, fdtbl_Y, DCY, YDC_HT, YAC_HT);
+            for (int x_offset = 0; x_offset < src->w; x_offset += JPEG_MCU_W) {
+                int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
 
-                    if (src->is_color) {
-                        DCU = jpeg_processDU(&jpeg_buf, UDU, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-                        DCV = jpeg_processDU(&jpeg_buf, VDU, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
-                    }
-                }
+                jpeg_get_mcu(src, x_offset, y, dx, dy, YDU, UDU, VDU);
+                DCY = jpeg_processDU(&enc->buf, YDU, &qtbl_Y, DCY, YDC_HT, YAC_HT);
 
-                if (jpeg_buf.overflow) {
-                    return true;
+                if (enc->is_color) {
+                    DCU = jpeg_processDU(&enc->buf, UDU, &qtbl_UV, DCU, UVDC_HT, UVAC_HT);
+                    DCV = jpeg_processDU(&enc->buf, VDU, &qtbl_UV, DCV, UVDC_HT, UVAC_HT);
                 }
             }
             break;
@@ -1012,99 +1073,93 @@ bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_s
             int8_t UDU_avg[JPEG_444_GS_MCU_SIZE];
             int8_t VDU_avg[JPEG_444_GS_MCU_SIZE];
 
-            for (int y_offset = 0; y_offset < src->h; y_offset += JPEG_MCU_H) {
-                int dy = IM_MIN(JPEG_MCU_H, src->h - y_offset);
-
-                for (int x_offset = 0; x_offset < src->w; ) {
-                    for (int i = 0; i < (JPEG_444_GS_MCU_SIZE * 2);
-                         i += JPEG_444_GS_MCU_SIZE, x_offset += JPEG_MCU_W) {
-                        int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
+            int dy = IM_MIN(JPEG_MCU_H, src->h - y);
 
-                        if (dx > 0) {
-                            jpeg_get_mcu(src, x_offset, y_offset, dx, dy, YDU + i, UDU + i, VDU + i);
-                        } else {
-                            memset(YDU + i, 0, JPEG_444_GS_MCU_SIZE);
-                            memset(UDU + i, 0, JPEG_444_GS_MCU_SIZE);
-                            memset(VDU + i, 0, JPEG_444_GS_MCU_SIZE);
-                        }
+            for (int x_offset = 0; x_offset < src->w; ) {
+                for (int i = 0; i < (JPEG_444_GS_MCU_SIZE * 2);
+                     i += JPEG_444_GS_MCU_SIZE, x_offset += JPEG_MCU_W) {
+                    int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
 
-                        DCY = jpeg_processDU(&jpeg_buf, YDU + i, fdtbl_Y, DCY, YDC_HT, YAC_HT);
+                    if (dx > 0) {
+                        jpeg_get_mcu(src, x_offset, y, dx, dy, YDU + i, UDU + i, VDU + i);
+                    } else {
+                        memset(YDU + i, 0, JPEG_444_GS_MCU_SIZE);
+                        memset(UDU + i, 0, JPEG_444_GS_MCU_SIZE);
+                        memset(VDU + i, 0, JPEG_444_GS_MCU_SIZE);
                     }
 
-                    // horizontal subsampling of U & V
+                    DCY = jpeg_processDU(&enc->buf, YDU + i, &qtbl_Y, DCY, YDC_HT, YAC_HT);
+                }
+
+                // horizontal subsampling of U & V
+                #if defined(ARM_MATH_DSP)
+                uint32_t *UDUp0 = (uint32_t *) UDU;
+                uint32_t *VDUp0 = (uint32_t *) VDU;
+                uint32_t *UDUp1 = (uint32_t *) (UDU + JPEG_444_GS_MCU_SIZE);
+                uint32_t *VDUp1 = (uint32_t *) (VDU + JPEG_444_GS_MCU_SIZE);
+                #else
+                int8_t *UDUp0 = UDU;
+                int8_t *VDUp0 = VDU;
+                int8_t *UDUp1 = UDUp0 + JPEG_444_GS_MCU_SIZE;
+                int8_t *VDUp1 = VDUp0 + JPEG_444_GS_MCU_SIZE;
+                #endif
+                for (int j = 0; j < JPEG_444_GS_MCU_SIZE; j += JPEG_MCU_W) {
                     #if defined(ARM_MATH_DSP)
-                    uint32_t *UDUp0 = (uint32_t *) UDU;
-                    uint32_t *VDUp0 = (uint32_t *) VDU;
-                    uint32_t *UDUp1 = (uint32_t *) (UDU + JPEG_444_GS_MCU_SIZE);
-                    uint32_t *VDUp1 = (uint32_t *) (VDU + JPEG_444_GS_MCU_SIZE);
+                    uint32_t UDUp0_3210 = *UDUp0++;
+                    uint32_t UDUp0_avg_32_10 = __SHADD8(UDUp0_3210, __UXTB16_RORn(UDUp0_3210, 8));
+                    UDU_avg[j] = UDUp0_avg_32_10;
+                    UDU_avg[j + 1] = UDUp0_avg_32_10 >> 16;
+
+                    uint32_t UDUp0_7654 = *UDUp0++;
+                    uint32_t UDUp0_avg_76_54 = __SHADD8(UDUp0_7654, __UXTB16_RORn(UDUp0_7654, 8));
+                    UDU_avg[j + 2] = UDUp0_avg_76_54;
+                    UDU_avg[j + 3] = UDUp0_avg_76_54 >> 16;
+
+                    uint32_t UDUp1_3210 = *UDUp1++;
+                    uint32_t UDUp1_avg_32_10 = __SHADD8(UDUp1_3210, __UXTB16_RORn(UDUp1_3210, 8));
+                    UDU_avg[j + 4] = UDUp1_avg_32_10;
+                    UDU_avg[j + 5] = UDUp1_avg_32_10 >> 16;
+
+                    uint32_t UDUp1_7654 = *UDUp1++;
+                    uint32_t UDUp1_avg_76_54 = __SHADD8(UDUp1_7654, __UXTB16_RORn(UDUp1_7654, 8));
+                    UDU_avg[j + 6] = UDUp1_avg_76_54;
+                    UDU_avg[j + 7] = UDUp1_avg_76_54 >> 16;
+
+                    uint32_t VDUp0_3210 = *VDUp0++;
+                    uint32_t VDUp0_avg_32_10 = __SHADD8(VDUp0_3210, __UXTB16_RORn(VDUp0_3210, 8));
+                    VDU_avg[j] = VDUp0_avg_32_10;
+                    VDU_avg[j + 1] = VDUp0_avg_32_10 >> 16;
+
+                    uint32_t VDUp0_7654 = *VDUp0++;
+                    uint32_t VDUp0_avg_76_54 = __SHADD8(VDUp0_7654, __UXTB16_RORn(VDUp0_7654, 8));
+                    VDU_avg[j + 2] = VDUp0_avg_76_54;
+                    VDU_avg[j + 3] = VDUp0_avg_76_54 >> 16;
+
+                    uint32_t VDUp1_3210 = *VDUp1++;
+                    uint32_t VDUp1_avg_32_10 = __SHADD8(VDUp1_3210, __UXTB16_RORn(VDUp1_3210, 8));
+                    VDU_avg[j + 4] = VDUp1_avg_32_10;
+                    VDU_avg[j + 5] = VDUp1_avg_32_10 >> 16;
+
+                    uint32_t VDUp1_7654 = *VDUp1++;
+                    uint32_t VDUp1_avg_76_54 = __SHADD8(VDUp1_7654, __UXTB16_RORn(VDUp1_7654, 8));
+                    VDU_avg[j + 6] = VDUp1_avg_76_54;
+                    VDU_avg[j + 7] = VDUp1_avg_76_54 >> 16;
                     #else
-                    int8_t *UDUp0 = UDU;
-                    int8_t *VDUp0 = VDU;
-                    int8_t *UDUp1 = UDUp0 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *VDUp1 = VDUp0 + JPEG_444_GS_MCU_SIZE;
-                    #endif
-                    for (int j = 0; j < JPEG_444_GS_MCU_SIZE; j += JPEG_MCU_W) {
-                        #if defined(ARM_MATH_DSP)
-                        uint32_t UDUp0_3210 = *UDUp0++;
-                        uint32_t UDUp0_avg_32_10 = __SHADD8(UDUp0_3210, __UXTB16_RORn(UDUp0_3210, 8));
-                        UDU_avg[j] = UDUp0_avg_32_10;
-                        UDU_avg[j + 1] = UDUp0_avg_32_10 >> 16;
-
-                        uint32_t UDUp0_7654 = *UDUp0++;
-                        uint32_t UDUp0_avg_76_54 = __SHADD8(UDUp0_7654, __UXTB16_RORn(UDUp0_7654, 8));
-                        UDU_avg[j + 2] = UDUp0_avg_76_54;
-                        UDU_avg[j + 3] = UDUp0_avg_76_54 >> 16;
-
-                        uint32_t UDUp1_3210 = *UDUp1++;
-                        uint32_t UDUp1_avg_32_10 = __SHADD8(UDUp1_3210, __UXTB16_RORn(UDUp1_3210, 8));
-                        UDU_avg[j + 4] = UDUp1_avg_32_10;
-                        UDU_avg[j + 5] = UDUp1_avg_32_10 >> 16;
-
-                        uint32_t UDUp1_7654 = *UDUp1++;
-                        uint32_t UDUp1_avg_76_54 = __SHADD8(UDUp1_7654, __UXTB16_RORn(UDUp1_7654, 8));
-                        UDU_avg[j + 6] = UDUp1_avg_76_54;
-                        UDU_avg[j + 7] = UDUp1_avg_76_54 >> 16;
-
-                        uint32_t VDUp0_3210 = *VDUp0++;
-                        uint32_t VDUp0_avg_32_10 = __SHADD8(VDUp0_3210, __UXTB16_RORn(VDUp0_3210, 8));
-                        VDU_avg[j] = VDUp0_avg_32_10;
-                        VDU_avg[j + 1] = VDUp0_avg_32_10 >> 16;
-
-                        uint32_t VDUp0_7654 = *VDUp0++;
-                        uint32_t VDUp0_avg_76_54 = __SHADD8(VDUp0_7654, __UXTB16_RORn(VDUp0_7654, 8));
-                        VDU_avg[j + 2] = VDUp0_avg_76_54;
-                        VDU_avg[j + 3] = VDUp0_avg_76_54 >> 16;
-
-                        uint32_t VDUp1_3210 = *VDUp1++;
-                        uint32_t VDUp1_avg_32_10 = __SHADD8(VDUp1_3210, __UXTB16_RORn(VDUp1_3210, 8));
-                        VDU_avg[j + 4] = VDUp1_avg_32_10;
-                        VDU_avg[j + 5] = VDUp1_avg_32_10 >> 16;
-
-                        uint32_t VDUp1_7654 = *VDUp1++;
-                        uint32_t VDUp1_avg_76_54 = __SHADD8(VDUp1_7654, __UXTB16_RORn(VDUp1_7654, 8));
-                        VDU_avg[j + 6] = VDUp1_avg_76_54;
-                        VDU_avg[j + 7] = VDUp1_avg_76_54 >> 16;
-                        #else
-                        for (int i = 0; i < JPEG_MCU_W; i += 2) {
-                            UDU_avg[j + (i / 2)] = (UDUp0[i] + UDUp0[i + 1]) / 2;
-                            VDU_avg[j + (i / 2)] = (VDUp0[i] + VDUp0[i + 1]) / 2;
-                            UDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] = (UDUp1[i] + UDUp1[i + 1]) / 2;
-                            VDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] = (VDUp1[i] + VDUp1[i + 1]) / 2;
-                        }
-                        UDUp0 += JPEG_MCU_W;
-                        VDUp0 += JPEG_MCU_W;
-                        UDUp1 += JPEG_MCU_W;
-                        VDUp1 += JPEG_MCU_W;
-                        #endif
+                    for (int i = 0; i < JPEG_MCU_W; i += 2) {
+                        UDU_avg[j + (i / 2)] = (UDUp0[i] + UDUp0[i + 1]) / 2;
+                        VDU_avg[j + (i / 2)] = (VDUp0[i] + VDUp0[i + 1]) / 2;
+                        UDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] = (UDUp1[i] + UDUp1[i + 1]) / 2;
+                        VDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] = (VDUp1[i] + VDUp1[i + 1]) / 2;
                     }
-
-                    DCU = jpeg_processDU(&jpeg_buf, UDU_avg, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-                    DCV = jpeg_processDU(&jpeg_buf, VDU_avg, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
+                    UDUp0 += JPEG_MCU_W;
+                    VDUp0 += JPEG_MCU_W;
+                    UDUp1 += JPEG_MCU_W;
+                    VDUp1 += JPEG_MCU_W;
+                    #endif
                 }
 
-                if (jpeg_buf.overflow) {
-                    return true;
-                }
+                DCU = jpeg_processDU(&enc->buf, UDU_avg, &qtbl_UV, DCU, UVDC_HT, UVAC_HT);
+                DCV = jpeg_processDU(&enc->buf, VDU_avg, &qtbl_UV, DCV, UVDC_HT, UVAC_HT);
             }
             break;
         }
@@ -1116,152 +1171,190 @@ bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_s
             int8_t UDU_avg[JPEG_444_GS_MCU_SIZE];
             int8_t VDU_avg[JPEG_444_GS_MCU_SIZE];
 
-            for (int y_offset = 0; y_offset < src->h; ) {
-                for (int x_offset = 0; x_offset < src->w; ) {
-                    for (int j = 0; j < (JPEG_444_GS_MCU_SIZE * 4);
-                         j += (JPEG_444_GS_MCU_SIZE * 2), y_offset += JPEG_MCU_H) {
-                        int dy = IM_MIN(JPEG_MCU_H, src->h - y_offset);
-
-                        for (int i = 0; i < (JPEG_444_GS_MCU_SIZE * 2);
-                             i += JPEG_444_GS_MCU_SIZE, x_offset += JPEG_MCU_W) {
-                            int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
-
-                            if ((dx > 0) && (dy > 0)) {
-                                jpeg_get_mcu(src, x_offset, y_offset, dx, dy, YDU + i + j, UDU + i + j, VDU + i + j);
-                            } else {
-                                memset(YDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
-                                memset(UDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
-                                memset(VDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
-                            }
-
-                            DCY = jpeg_processDU(&jpeg_buf, YDU + i + j, fdtbl_Y, DCY, YDC_HT, YAC_HT);
+            int y_offset = y;
+
+            for (int x_offset = 0; x_offset < src->w; ) {
+                for (int j = 0; j < (JPEG_444_GS_MCU_SIZE * 4);
+                     j += (JPEG_444_GS_MCU_SIZE * 2), y_offset += JPEG_MCU_H) {
+                    int dy = IM_MIN(JPEG_MCU_H, src->h - y_offset);
+
+                    for (int i = 0; i < (JPEG_444_GS_MCU_SIZE * 2);
+                         i += JPEG_444_GS_MCU_SIZE, x_offset += JPEG_MCU_W) {
+                        int dx = IM_MIN(JPEG_MCU_W, src->w - x_offset);
+
+                        if ((dx > 0) && (dy > 0)) {
+                            jpeg_get_mcu(src, x_offset, y_offset, dx, dy, YDU + i + j, UDU + i + j, VDU + i + j);
+                        } else {
+                            memset(YDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
+                            memset(UDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
+                            memset(VDU + i + j, 0, JPEG_444_GS_MCU_SIZE);
                         }
 
-                        // Reset back two columns.
-                        x_offset -= (JPEG_MCU_W * 2);
+                        DCY = jpeg_processDU(&enc->buf, YDU + i + j, &qtbl_Y, DCY, YDC_HT, YAC_HT);
                     }
 
-                    // Advance to the next columns.
-                    x_offset += (JPEG_MCU_W * 2);
+                    // Reset back two columns.
+                    x_offset -= (JPEG_MCU_W * 2);
+                }
+
+                // Advance to the next columns.
+                x_offset += (JPEG_MCU_W * 2);
 
-                    // Reset back two rows.
-                    y_offset -= (JPEG_MCU_H * 2);
+                // Reset back two rows.
+                y_offset -= (JPEG_MCU_H * 2);
 
-                    // horizontal and vertical subsampling of U & V
+                // horizontal and vertical subsampling of U & V
+                #if defined(ARM_MATH_DSP)
+                uint32_t *UDUp = (uint32_t *) UDU;
+                uint32_t *VDUp = (uint32_t *) VDU;
+                #else
+                int8_t *UDUp0 = UDU;
+                int8_t *VDUp0 = VDU;
+                int8_t *UDUp1 = UDUp0 + JPEG_444_GS_MCU_SIZE;
+                int8_t *VDUp1 = VDUp0 + JPEG_444_GS_MCU_SIZE;
+                int8_t *UDUp2 = UDUp1 + JPEG_444_GS_MCU_SIZE;
+                int8_t *VDUp2 = VDUp1 + JPEG_444_GS_MCU_SIZE;
+                int8_t *UDUp3 = UDUp2 + JPEG_444_GS_MCU_SIZE;
+                int8_t *VDUp3 = VDUp2 + JPEG_444_GS_MCU_SIZE;
+                #endif
+                for (int j = 0, k = JPEG_444_GS_MCU_SIZE / 2; k < JPEG_444_GS_MCU_SIZE;
+                     j += JPEG_MCU_W, k += JPEG_MCU_W) {
                     #if defined(ARM_MATH_DSP)
-                    uint32_t *UDUp = (uint32_t *) UDU;
-                    uint32_t *VDUp = (uint32_t *) VDU;
+                    for (int i = 0; i < 4; i++) {
+                        int index = ((i & 2) ? k : j) + ((i & 1) * 4);
+
+                        uint32_t UDU_r0_3210 = UDUp[i * 16];
+                        uint32_t UDU_r0_avg_32_10 = __SHADD8(UDU_r0_3210, __UXTB16_RORn(UDU_r0_3210, 8));
+                        uint32_t UDU_r0_7654 = UDUp[(i * 16) + 1];
+                        uint32_t UDU_r0_avg_76_54 = __SHADD8(UDU_r0_7654, __UXTB16_RORn(UDU_r0_7654, 8));
+
+                        uint32_t UDU_r1_3210 = UDUp[(i * 16) + 2];
+                        uint32_t UDU_r1_avg_32_10 = __SHADD8(UDU_r1_3210, __UXTB16_RORn(UDU_r1_3210, 8));
+                        uint32_t UDU_r1_7654 = UDUp[(i * 16) + 3];
+                        uint32_t UDU_r1_avg_76_54 = __SHADD8(UDU_r1_7654, __UXTB16_RORn(UDU_r1_7654, 8));
+
+                        uint32_t UDU_r0_r1_avg_32_10 = __SHADD8(UDU_r0_avg_32_10, UDU_r1_avg_32_10);
+                        UDU_avg[index] = UDU_r0_r1_avg_32_10;
+                        UDU_avg[index + 1] = UDU_r0_r1_avg_32_10 >> 16;
+
+                        uint32_t UDU_r0_r1_avg_76_54 = __SHADD8(UDU_r0_avg_76_54, UDU_r1_avg_76_54);
+                        UDU_avg[index + 2] = UDU_r0_r1_avg_76_54;
+                        UDU_avg[index + 3] = UDU_r0_r1_avg_76_54 >> 16;
+
+                        uint32_t VDU_r0_3210 = VDUp[i * 16];
+                        uint32_t VDU_r0_avg_32_10 = __SHADD8(VDU_r0_3210, __UXTB16_RORn(VDU_r0_3210, 8));
+                        uint32_t VDU_r0_7654 = VDUp[(i * 16) + 1];
+                        uint32_t VDU_r0_avg_76_54 = __SHADD8(VDU_r0_7654, __UXTB16_RORn(VDU_r0_7654, 8));
+
+                        uint32_t VDU_r1_3210 = VDUp[(i * 16) + 2];
+                        uint32_t VDU_r1_avg_32_10 = __SHADD8(VDU_r1_3210, __UXTB16_RORn(VDU_r1_3210, 8));
+                        uint32_t VDU_r1_7654 = VDUp[(i * 16) + 3];
+                        uint32_t VDU_r1_avg_76_54 = __SHADD8(VDU_r1_7654, __UXTB16_RORn(VDU_r1_7654, 8));
+
+                        uint32_t VDU_r0_r1_avg_32_10 = __SHADD8(VDU_r0_avg_32_10, VDU_r1_avg_32_10);
+                        VDU_avg[index] = VDU_r0_r1_avg_32_10;
+                        VDU_avg[index + 1] = VDU_r0_r1_avg_32_10 >> 16;
+
+                        uint32_t VDU_r0_r1_avg_76_54 = __SHADD8(VDU_r0_avg_76_54, VDU_r1_avg_76_54);
+                        VDU_avg[index + 2] = VDU_r0_r1_avg_76_54;
+                        VDU_avg[index + 3] = VDU_r0_r1_avg_76_54 >> 16;
+                    }
+                    UDUp += 4;
+                    VDUp += 4;
                     #else
-                    int8_t *UDUp0 = UDU;
-                    int8_t *VDUp0 = VDU;
-                    int8_t *UDUp1 = UDUp0 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *VDUp1 = VDUp0 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *UDUp2 = UDUp1 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *VDUp2 = VDUp1 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *UDUp3 = UDUp2 + JPEG_444_GS_MCU_SIZE;
-                    int8_t *VDUp3 = VDUp2 + JPEG_444_GS_MCU_SIZE;
-                    #endif
-                    for (int j = 0, k = JPEG_444_GS_MCU_SIZE / 2; k < JPEG_444_GS_MCU_SIZE;
-                         j += JPEG_MCU_W, k += JPEG_MCU_W) {
-                        #if defined(ARM_MATH_DSP)
-                        for (int i = 0; i < 4; i++) {
-                            int index = ((i & 2) ? k : j) + ((i & 1) * 4);
-
-                            uint32_t UDU_r0_3210 = UDUp[i * 16];
-                            uint32_t UDU_r0_avg_32_10 = __SHADD8(UDU_r0_3210, __UXTB16_RORn(UDU_r0_3210, 8));
-                            uint32_t UDU_r0_7654 = UDUp[(i * 16) + 1];
-                            uint32_t UDU_r0_avg_76_54 = __SHADD8(UDU_r0_7654, __UXTB16_RORn(UDU_r0_7654, 8));
-
-                            uint32_t UDU_r1_3210 = UDUp[(i * 16) + 2];
-                            uint32_t UDU_r1_avg_32_10 = __SHADD8(UDU_r1_3210, __UXTB16_RORn(UDU_r1_3210, 8));
-                            uint32_t UDU_r1_7654 = UDUp[(i * 16) + 3];
-                            uint32_t UDU_r1_avg_76_54 = __SHADD8(UDU_r1_7654, __UXTB16_RORn(UDU_r1_7654, 8));
-
-                            uint32_t UDU_r0_r1_avg_32_10 = __SHADD8(UDU_r0_avg_32_10, UDU_r1_avg_32_10);
-                            UDU_avg[index] = UDU_r0_r1_avg_32_10;
-                            UDU_avg[index + 1] = UDU_r0_r1_avg_32_10 >> 16;
-
-                            uint32_t UDU_r0_r1_avg_76_54 = __SHADD8(UDU_r0_avg_76_54, UDU_r1_avg_76_54);
-                            UDU_avg[index + 2] = UDU_r0_r1_avg_76_54;
-                            UDU_avg[index + 3] = UDU_r0_r1_avg_76_54 >> 16;
-
-                            uint32_t VDU_r0_3210 = VDUp[i * 16];
-                            uint32_t VDU_r0_avg_32_10 = __SHADD8(VDU_r0_3210, __UXTB16_RORn(VDU_r0_3210, 8));
-                            uint32_t VDU_r0_7654 = VDUp[(i * 16) + 1];
-                            uint32_t VDU_r0_avg_76_54 = __SHADD8(VDU_r0_7654, __UXTB16_RORn(VDU_r0_7654, 8));
-
-                            uint32_t VDU_r1_3210 = VDUp[(i * 16) + 2];
-                            uint32_t VDU_r1_avg_32_10 = __SHADD8(VDU_r1_3210, __UXTB16_RORn(VDU_r1_3210, 8));
-                            uint32_t VDU_r1_7654 = VDUp[(i * 16) + 3];
-                            uint32_t VDU_r1_avg_76_54 = __SHADD8(VDU_r1_7654, __UXTB16_RORn(VDU_r1_7654, 8));
-
-                            uint32_t VDU_r0_r1_avg_32_10 = __SHADD8(VDU_r0_avg_32_10, VDU_r1_avg_32_10);
-                            VDU_avg[index] = VDU_r0_r1_avg_32_10;
-                            VDU_avg[index + 1] = VDU_r0_r1_avg_32_10 >> 16;
-
-                            uint32_t VDU_r0_r1_avg_76_54 = __SHADD8(VDU_r0_avg_76_54, VDU_r1_avg_76_54);
-                            VDU_avg[index + 2] = VDU_r0_r1_avg_76_54;
-                            VDU_avg[index + 3] = VDU_r0_r1_avg_76_54 >> 16;
-                        }
-                        UDUp += 4;
-                        VDUp += 4;
-                        #else
-                        for (int i = 0; i < JPEG_MCU_W; i += 2) {
-                            UDU_avg[j + (i / 2)] =
-                                (UDUp0[i] + UDUp0[i + 1] + UDUp0[i + JPEG_MCU_W] + UDUp0[i + 1 + JPEG_MCU_W]) / 4;
-                            VDU_avg[j + (i / 2)] =
-                                (VDUp0[i] + VDUp0[i + 1] + VDUp0[i + JPEG_MCU_W] + VDUp0[i + 1 + JPEG_MCU_W]) / 4;
-                            UDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] =
-                                (UDUp1[i] + UDUp1[i + 1] + UDUp1[i + JPEG_MCU_W] + UDUp1[i + 1 + JPEG_MCU_W]) / 4;
-                            VDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] =
-                                (VDUp1[i] + VDUp1[i + 1] + VDUp1[i + JPEG_MCU_W] + VDUp1[i + 1 + JPEG_MCU_W]) / 4;
-                            UDU_avg[k + (i / 2)] =
-                                (UDUp2[i] + UDUp2[i + 1] + UDUp2[i + JPEG_MCU_W] + UDUp2[i + 1 + JPEG_MCU_W]) / 4;
-                            VDU_avg[k + (i / 2)] =
-                                (VDUp2[i] + VDUp2[i + 1] + VDUp2[i + JPEG_MCU_W] + VDUp2[i + 1 + JPEG_MCU_W]) / 4;
-                            UDU_avg[k + (i / 2) + (JPEG_MCU_W / 2)] =
-                                (UDUp3[i] + UDUp3[i + 1] + UDUp3[i + JPEG_MCU_W] + UDUp3[i + 1 + JPEG_MCU_W]) / 4;
-                            VDU_avg[k + (i / 2) + (JPEG_MCU_W / 2)] =
-                                (VDUp3[i] + VDUp3[i + 1] + VDUp3[i + JPEG_MCU_W] + VDUp3[i + 1 + JPEG_MCU_W]) / 4;
-                        }
-                        UDUp0 += JPEG_MCU_W * 2;
-                        VDUp0 += JPEG_MCU_W * 2;
-                        UDUp1 += JPEG_MCU_W * 2;
-                        VDUp1 += JPEG_MCU_W * 2;
-                        UDUp2 += JPEG_MCU_W * 2;
-                        VDUp2 += JPEG_MCU_W * 2;
-                        UDUp3 += JPEG_MCU_W * 2;
-                        VDUp3 += JPEG_MCU_W * 2;
-                        #endif
+                    for (int i = 0; i < JPEG_MCU_W; i += 2) {
+                        UDU_avg[j + (i / 2)] =
+                            (UDUp0[i] + UDUp0[i + 1] + UDUp0[i + JPEG_MCU_W] + UDUp0[i + 1 + JPEG_MCU_W]) / 4;
+                        VDU_avg[j + (i / 2)] =
+                            (VDUp0[i] + VDUp0[i + 1] + VDUp0[i + JPEG_MCU_W] + VDUp0[i + 1 + JPEG_MCU_W]) / 4;
+                        UDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] =
+                            (UDUp1[i] + UDUp1[i + 1] + UDUp1[i + JPEG_MCU_W] + UDUp1[i + 1 + JPEG_MCU_W]) / 4;
+                        VDU_avg[j + (i / 2) + (JPEG_MCU_W / 2)] =
+                            (VDUp1[i] + VDUp1[i + 1] + VDUp1[i + JPEG_MCU_W] + VDUp1[i + 1 + JPEG_MCU_W]) / 4;
+                        UDU_avg[k + (i / 2)] =
+                            (UDUp2[i] + UDUp2[i + 1] + UDUp2[i + JPEG_MCU_W] + UDUp2[i + 1 + JPEG_MCU_W]) / 4;
+                        VDU_avg[k + (i / 2)] =
+                            (VDUp2[i] + VDUp2[i + 1] + VDUp2[i + JPEG_MCU_W] + VDUp2[i + 1 + JPEG_MCU_W]) / 4;
+                        UDU_avg[k + (i / 2) + (JPEG_MCU_W / 2)] =
+                            (UDUp3[i] + UDUp3[i + 1] + UDUp3[i + JPEG_MCU_W] + UDUp3[i + 1 + JPEG_MCU_W]) / 4;
+                        VDU_avg[k + (i / 2) + (JPEG_MCU_W / 2)] =
+                            (VDUp3[i] + VDUp3[i + 1] + VDUp3[i + JPEG_MCU_W] + VDUp3[i + 1 + JPEG_MCU_W]) / 4;
                     }
-
-                    DCU = jpeg_processDU(&jpeg_buf, UDU_avg, fdtbl_UV, DCU, UVDC_HT, UVAC_HT);
-                    DCV = jpeg_processDU(&jpeg_buf, VDU_avg, fdtbl_UV, DCV, UVDC_HT, UVAC_HT);
-                }
-
-                if (jpeg_buf.overflow) {
-                    return true;
+                    UDUp0 += JPEG_MCU_W * 2;
+                    VDUp0 += JPEG_MCU_W * 2;
+                    UDUp1 += JPEG_MCU_W * 2;
+                    VDUp1 += JPEG_MCU_W * 2;
+                    UDUp2 += JPEG_MCU_W * 2;
+                    VDUp2 += JPEG_MCU_W * 2;
+                    UDUp3 += JPEG_MCU_W * 2;
+                    VDUp3 += JPEG_MCU_W * 2;
+                    #endif
                 }
 
-                // Advance to the next rows.
-                y_offset += (JPEG_MCU_H * 2);
+                DCU = jpeg_processDU(&enc->buf, UDU_avg, &qtbl_UV, DCU, UVDC_HT, UVAC_HT);
+                DCV = jpeg_processDU(&enc->buf, VDU_avg, &qtbl_UV, DCV, UVDC_HT, UVAC_HT);
             }
             break;
         }
     }
 
+    enc->DCY = DCY;
+    enc->DCU = DCU;
+    enc->DCV = DCV;
+    return enc->buf.overflow;
+}
+
+bool jpeg_encoder_finish(jpeg_encoder_t *enc) {
+    if (enc->buf.overflow) {
+        return true;
+    }
+
     // Do the bit alignment of the EOI marker
-    jpeg_write_bits(&jpeg_buf, (const uint16_t []) {0x7F, 7});
+    jpeg_write_bits(&enc->buf, (const uint16_t []) {0x7F, 7});
+    jpeg_flush_bits(&enc->buf);
 
     // EOI
-    jpeg_put_char(&jpeg_buf, 0xFF);
-    jpeg_put_char(&jpeg_buf, 0xD9);
+    jpeg_put_char(&enc->buf, 0xFF);
+    jpeg_put_char(&enc->buf, 0xD9);
 
-    dst->size = jpeg_buf.idx;
-    dst->data = jpeg_buf.buf;
+    enc->dst->size = enc->buf.idx;
+    enc->dst->data = enc->buf.buf;
     return false;
 }
 
+static bool jpeg_compress_sw(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
+    if (src->is_compressed) {
+        return true;
+    }
+
+    jpeg_encoder_t enc;
+    jpeg_encoder_start(&enc, dst, src->w, src->h, src->is_color, quality, realloc, subsampling);
+
+    // Bands are read in place, so that Bayer and YUV sources can use their neighbouring rows.
+    for (int y = 0; y < src->h; y += enc.band_h) {
+        if (jpeg_encoder_band(&enc, src, y)) {
+            return true;
+        }
+    }
+
+    return jpeg_encoder_finish(&enc);
+}
+
+#if MICROPY_PY_UNITTEST
+// Runs the encoder's luma DCT and quantization on a contiguous 8x8 block of level shifted
+// samples, so that benchmarks can time this stage on its own.
+int jpeg_fdct_quant_luma(const int8_t *CDU, int quality, int *DUQ) {
+    jpeg_init(quality);
+    return jpeg_fdct_quant(CDU, &qtbl_Y, DUQ);
+}
+#endif
+
+bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
+    bool overflow;
+    // Allocating the output can raise, which would skip the end of a scope.
+    OMV_TRACE_CALL("jpeg", overflow = jpeg_compress_sw(src, dst, quality, realloc, subsampling));
+    return overflow;
+}
 #endif // (OMV_JPEG_CODEC_ENABLE == 0)
 
 bool jpeg_is_valid(image_t *img) {
@@ -276,26 +276,88 @@ void imlib_logpolar_int(image_t *dst, image_t *src, rectangle_t *roi, int cx, in
 }
 
 #if defined(IMLIB_ENABLE_LOGPOLAR) || defined(IMLIB_ENABLE_LINPOLAR)
-void imlib_logpolar(image_t *img, int cx, int cy, bool linear, bool reverse) {
-    image_t img_2;
-    img_2.w = img->w;
-    img_2.h = img->h;
-    img_2.pixfmt = img->pixfmt;
-
-    rectangle_t rect;
-    rect.x = 0;
-    rect.y = 0;
-    rect.w = img->w;
-    rect.h = img->h;
-
-    size_t size = image_size(img);
-    img_2.data = uma_malloc(size, 0);
-    memcpy(img_2.data, img->data, size);
-    memset(img->data, 0, size);
-
-    imlib_logpolar_int(img, &img_2, &rect, cx, cy, linear, reverse);
-
-    uma_free(img_2.data);
+typedef struct imlib_logpolar_key {
+    int cx, cy, linear, reverse;
+} imlib_logpolar_key_t;
+
+typedef struct imlib_logpolar_args {
+    int w, cx, cy;
+    bool linear, reverse;
+    float rho_scale, theta_scale_d, theta_scale_inv;
+} imlib_logpolar_args_t;
+
+// Same mapping as imlib_logpolar_int() for a full image ROI.
+static void imlib_logpolar_point(const void *args, int x, int y, float *sx, float *sy) {
+    const imlib_logpolar_args_t *a = args;
+    const float m_pi_1_5 = 1.5f * IMLIB_PI;
+    const float m_pi_1_5_d = IM_RAD2DEG(m_pi_1_5);
+    const int m_pi_2_0_d_i = IM_RAD2DEG(2.0f * IMLIB_PI);
+
+    if (!a->reverse) {
+        float rho = y * a->rho_scale;
+        if (!a->linear) {
+            rho = fast_expf(rho);
+        }
+        int theta = fast_roundf(m_pi_1_5_d - (x * a->theta_scale_d));
+        while (theta < 0) {
+            theta += m_pi_2_0_d_i;
+        }
+        while (theta >= m_pi_2_0_d_i) {
+            theta -= m_pi_2_0_d_i;
+        }
+        *sx = a->cx + fast_roundf(rho * cos_table[theta]); // rounding is necessary
+        *sy = a->cy + fast_roundf(rho * sin_table[theta]); // rounding is necessary
+    } else {
+        int x_2 = x - a->cx;
+        int y_2 = y - a->cy;
+        float rho = fast_sqrtf((x_2 * x_2) + (y_2 * y_2));
+        if (!a->linear) {
+            rho = fast_log(rho);
+        }
+        float theta = m_pi_1_5 - fast_atan2f(y_2, x_2 ? x_2 : -1);
+        int sourceX = fast_roundf(theta * a->theta_scale_inv); // rounding is necessary
+        while (sourceX < 0) {
+            sourceX += a->w;
+        }
+        while (sourceX >= a->w) {
+            sourceX -= a->w;
+        }
+        *sx = sourceX;
+        *sy = rho * a->rho_scale;
+    }
+}
+
+void imlib_logpolar(image_t *dst, image_t *src, int cx, int cy, bool linear, bool reverse) {
+    imlib_logpolar_key_t key = { cx, cy, linear, reverse };
+    imlib_remap_t *map = imlib_remap_cache_get(IMLIB_REMAP_CACHE_POLAR, src, &key, sizeof(key));
+
+    if (!map) {
+        int w = src->w;
+        int h = src->h;
+        int w_2 = w / 2;
+        int h_2 = h / 2;
+        float rho_scale = fast_sqrtf((w_2 * w_2) + (h_2 * h_2));
+        if (!linear) {
+            rho_scale = fast_log(rho_scale);
+        }
+
+        imlib_logpolar_args_t args = {
+            .w = w,
+            .cx = cx,
+            .cy = cy,
+            .linear = linear,
+            .reverse = reverse,
+            .rho_scale = reverse ? ((h - 1) / rho_scale) : (rho_scale / h),
+            .theta_scale_d = IM_RAD2DEG(2.0f * IMLIB_PI) / w,
+            .theta_scale_inv = w / (2.0f * IMLIB_PI),
+        };
+
+        // Polar maps wrap around, which tiles can't interpolate.
+        map = imlib_remap_cache_set(IMLIB_REMAP_CACHE_POLAR, src, &key, sizeof(key),
+                                    imlib_logpolar_point, &args, false);
+    }
+
+    imlib_remap_image(map, dst, src);
 }
 #endif //defined(IMLIB_ENABLE_LOGPOLAR) || defined(IMLIB_ENABLE_LINPOLAR)
 
@@ -334,8 +396,8 @@ void imlib_phasecorrelate(image_t *img0,
         fft2d_run_again(&fft0);
         fft2d_run_again(&fft1);
 
-        int w = (1 << fft0.w_pow2);
-        int h = (1 << fft0.h_pow2);
+        int w = fft0.w;
+        int h = fft0.h;
 
         for (int i = 0, j = h * w * 2; i < j; i += 2) {
             float ga_r = fft0.data[i + 0];
@@ -504,7 +566,7 @@ void imlib_phasecorrelate(image_t *img0,
             }
         }
 
-        imlib_rotation_corr(&img0_fixed, 0, 0, *rotation, 0, 0, *scale, 60, NULL);
+        imlib_rotation_corr(&img0_fixed, &img0_fixed, 0, 0, *rotation, 0, 0, *scale, 60, NULL, false);
     } else {
         memcpy(&img0_fixed, img0, sizeof(image_t));
         memcpy(&roi0_fixed, roi0, sizeof(rectangle_t));
@@ -549,8 +611,8 @@ void imlib_phasecorrelate(image_t *img0,
         fft2d_run(&fft0);
         fft2d_run(&fft1);
 
-        int w = (1 << fft0.w_pow2);
-        int h = (1 << fft0.h_pow2);
+        int w = fft0.w;
+        int h = fft0.h;
 
         for (int i = 0, j = h * w * 2; i < j; i += 2) {
             float ga_r = fft0.data[i + 0];
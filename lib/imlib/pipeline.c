@@ -0,0 +1,553 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2013-2024 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Row-streaming image pipeline.
+ *
+ * The source image is read once from top to bottom. Every stage writes into its own row
+ * buffer and pushes the row to the next stage, so the intermediate images are never stored
+ * in full. Stages with a vertical kernel keep a ring of input rows and output their rows one
+ * row late. The last stage hands each finished row to a consumer callback.
+ *
+ * The JPEG consumer only keeps one band of MCU rows, which is encoded as soon as it's full.
+ */
+#include "py/runtime.h"
+#include "imlib.h"
+
+typedef struct pipeline_state {
+    imlib_pipeline_t *pipeline;
+    int w, h;
+    // Row format going into each stage, then the output format.
+    pixformat_t pixfmt[IMLIB_PIPELINE_MAX_STAGES + 1];
+    // Output row of each stage.
+    uint8_t *rows[IMLIB_PIPELINE_MAX_STAGES];
+    // Input rows of sepconv3 stages (3 rows) and constant operands of line op stages (1 row).
+    uint8_t *ring[IMLIB_PIPELINE_MAX_STAGES];
+    uint8_t *luts[IMLIB_PIPELINE_MAX_STAGES];
+    uint8_t *src_row;
+    uint16_t *vrow;
+    imlib_pipeline_callback_t callback;
+    void *callback_arg;
+} pipeline_state_t;
+
+static size_t pipeline_line_size(pixformat_t pixfmt, int w) {
+    image_t img = {.w = w, .h = 1, .pixfmt = pixfmt};
+    return image_line_size(&img);
+}
+
+pixformat_t imlib_pipeline_pixfmt(imlib_pipeline_t *pipeline, image_t *src, pixformat_t *stage_pixfmt) {
+    pixformat_t pixfmt = PIXFORMAT_INVALID;
+
+    switch (src->pixfmt) {
+        case PIXFORMAT_BINARY:
+        case PIXFORMAT_GRAYSCALE:
+        case PIXFORMAT_RGB565: {
+            pixfmt = src->pixfmt;
+            break;
+        }
+        case PIXFORMAT_BAYER_ANY:
+        case PIXFORMAT_YUV_ANY: {
+            // Raw images are converted once on the way in, straight to grayscale when possible.
+            bool gray = pipeline->n_stages && (pipeline->stages[0].op == IMLIB_PIPELINE_OP_TO_GRAYSCALE);
+            pixfmt = gray ? PIXFORMAT_GRAYSCALE : PIXFORMAT_RGB565;
+            break;
+        }
+        default: {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Pipeline input must be an uncompressed image"));
+        }
+    }
+
+    if (stage_pixfmt) {
+        stage_pixfmt[0] = pixfmt;
+    }
+
+    for (size_t i = 0; i < pipeline->n_stages; i++) {
+        imlib_pipeline_stage_t *stage = &pipeline->stages[i];
+
+        switch (stage->op) {
+            case IMLIB_PIPELINE_OP_TO_GRAYSCALE: {
+                pixfmt = PIXFORMAT_GRAYSCALE;
+                break;
+            }
+            case IMLIB_PIPELINE_OP_TO_RGB565: {
+                pixfmt = PIXFORMAT_RGB565;
+                break;
+            }
+            case IMLIB_PIPELINE_OP_SEPCONV3: {
+                if (pixfmt != PIXFORMAT_GRAYSCALE) {
+                    mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Kernel stages require GRAYSCALE rows"));
+                }
+                break;
+            }
+            case IMLIB_PIPELINE_OP_GAMMA: {
+                break;
+            }
+            case IMLIB_PIPELINE_OP_CCM: {
+                if (pixfmt != PIXFORMAT_RGB565) {
+                    mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("CCM stages require RGB565 rows"));
+                }
+                break;
+            }
+            case IMLIB_PIPELINE_OP_BINARY: {
+                pixfmt = PIXFORMAT_BINARY;
+                break;
+            }
+            case IMLIB_PIPELINE_OP_LINE_OP: {
+                image_t *other = stage->line_op.other;
+                if (other && ((other->w != src->w) || (other->h != src->h) || (other->pixfmt != pixfmt))) {
+                    mp_raise_msg(&mp_type_ValueError,
+                                 MP_ERROR_TEXT("Image operands must match the size and format of the stage"));
+                }
+                break;
+            }
+        }
+
+        if (stage_pixfmt) {
+            stage_pixfmt[i + 1] = pixfmt;
+        }
+    }
+
+    return pixfmt;
+}
+
+// Converts a row between BINARY, GRAYSCALE and RGB565.
+static void pipeline_convert_row(const void *src, pixformat_t src_pixfmt, void *dst, pixformat_t dst_pixfmt, int w) {
+    if (src_pixfmt == dst_pixfmt) {
+        memcpy(dst, src, pipeline_line_size(dst_pixfmt, w));
+        return;
+    }
+
+    if (dst_pixfmt == PIXFORMAT_BINARY) {
+        memset(dst, 0, pipeline_line_size(dst_pixfmt, w));
+    }
+
+    for (int x = 0; x < w; x++) {
+        int pixel;
+
+        switch (src_pixfmt) {
+            case PIXFORMAT_BINARY: {
+                pixel = IMAGE_GET_BINARY_PIXEL_FAST((uint32_t *) src, x);
+                pixel = (dst_pixfmt == PIXFORMAT_GRAYSCALE) ?
+                        COLOR_BINARY_TO_GRAYSCALE(pixel) : COLOR_BINARY_TO_RGB565(pixel);
+                break;
+            }
+            case PIXFORMAT_GRAYSCALE: {
+                pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST((uint8_t *) src, x);
+                pixel = (dst_pixfmt == PIXFORMAT_BINARY) ?
+                        COLOR_GRAYSCALE_TO_BINARY(pixel) : COLOR_GRAYSCALE_TO_RGB565(pixel);
+                break;
+            }
+            default: {
+                pixel = IMAGE_GET_RGB565_PIXEL_FAST((uint16_t *) src, x);
+                pixel = (dst_pixfmt == PIXFORMAT_BINARY) ?
+                        COLOR_RGB565_TO_BINARY(pixel) : COLOR_RGB565_TO_GRAYSCALE(pixel);
+                break;
+            }
+        }
+
+        switch (dst_pixfmt) {
+            case PIXFORMAT_BINARY: {
+                IMAGE_PUT_BINARY_PIXEL_FAST((uint32_t *) dst, x, pixel);
+                break;
+            }
+            case PIXFORMAT_GRAYSCALE: {
+                IMAGE_PUT_GRAYSCALE_PIXEL_FAST((uint8_t *) dst, x, pixel);
+                break;
+            }
+            default: {
+                IMAGE_PUT_RGB565_PIXEL_FAST((uint16_t *) dst, x, pixel);
+                break;
+            }
+        }
+    }
+}
+
+#ifdef IMLIB_ENABLE_BINARY_OPS
+static void pipeline_binary_row(imlib_pipeline_stage_t *stage, const void *src, pixformat_t src_pixfmt,
+                                uint32_t *dst, int w) {
+    memset(dst, 0, pipeline_line_size(PIXFORMAT_BINARY, w));
+
+    list_for_each(it, (&stage->binary.thresholds)) {
+        color_thresholds_list_lnk_data_t *lnk_data = list_get_data(it);
+        bool invert = stage->binary.invert;
+
+        switch (src_pixfmt) {
+            case PIXFORMAT_BINARY: {
+                for (int x = 0; x < w; x++) {
+                    if (COLOR_THRESHOLD_BINARY(IMAGE_GET_BINARY_PIXEL_FAST((uint32_t *) src, x), lnk_data, invert)) {
+                        IMAGE_SET_BINARY_PIXEL_FAST(dst, x);
+                    }
+                }
+                break;
+            }
+            case PIXFORMAT_GRAYSCALE: {
+                for (int x = 0; x < w; x++) {
+                    if (COLOR_THRESHOLD_GRAYSCALE(IMAGE_GET_GRAYSCALE_PIXEL_FAST((uint8_t *) src, x), lnk_data, invert)) {
+                        IMAGE_SET_BINARY_PIXEL_FAST(dst, x);
+                    }
+                }
+                break;
+            }
+            default: {
+                for (int x = 0; x < w; x++) {
+                    if (COLOR_THRESHOLD_RGB565(IMAGE_GET_RGB565_PIXEL_FAST((uint16_t *) src, x), lnk_data, invert)) {
+                        IMAGE_SET_BINARY_PIXEL_FAST(dst, x);
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+#endif // IMLIB_ENABLE_BINARY_OPS
+
+// Fills a row with the constant operand of a line op.
+static void pipeline_scalar_row(imlib_pipeline_stage_t *stage, pixformat_t pixfmt, void *dst, int w) {
+    int pixel = stage->line_op.scalar;
+
+    if (stage->line_op.scalar_is_rgb888) {
+        int r = (pixel >> 16) & 0xFF, g = (pixel >> 8) & 0xFF, b = pixel & 0xFF;
+        switch (pixfmt) {
+            case PIXFORMAT_BINARY: {
+                pixel = COLOR_RGB888_TO_Y(r, g, b) > 127;
+                break;
+            }
+            case PIXFORMAT_GRAYSCALE: {
+                pixel = COLOR_RGB888_TO_Y(r, g, b);
+                break;
+            }
+            default: {
+                pixel = COLOR_R8_G8_B8_TO_RGB565(r, g, b);
+                break;
+            }
+        }
+    }
+
+    switch (pixfmt) {
+        case PIXFORMAT_BINARY: {
+            memset(dst, (pixel & 1) ? 0xFF : 0x00, pipeline_line_size(pixfmt, w));
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            memset(dst, pixel, w);
+            break;
+        }
+        default: {
+            for (int x = 0; x < w; x++) {
+                IMAGE_PUT_RGB565_PIXEL_FAST((uint16_t *) dst, x, pixel);
+            }
+            break;
+        }
+    }
+}
+
+static void pipeline_push(pipeline_state_t *state, size_t i, const void *row, int y);
+
+// Outputs row y of a sepconv3 stage from its ring of input rows, clamping at the borders.
+static void pipeline_sepconv3_emit(pipeline_state_t *state, size_t i, int y) {
+    imlib_pipeline_stage_t *stage = &state->pipeline->stages[i];
+    int w = state->w;
+    uint8_t *r0 = state->ring[i] + (((y > 0) ? (y - 1) : 0) % 3) * w;
+    uint8_t *r1 = state->ring[i] + (y % 3) * w;
+    uint8_t *r2 = state->ring[i] + (((y < (state->h - 1)) ? (y + 1) : y) % 3) * w;
+
+    imlib_sepconv3_row(r0, r1, r2, state->rows[i], w, stage->sepconv3.krn,
+                       stage->sepconv3.m, stage->sepconv3.b, state->vrow);
+    pipeline_push(state, i + 1, state->rows[i], y);
+}
+
+static void pipeline_push(pipeline_state_t *state, size_t i, const void *row, int y) {
+    if (i == state->pipeline->n_stages) {
+        state->callback(state->callback_arg, row, y);
+        return;
+    }
+
+    imlib_pipeline_stage_t *stage = &state->pipeline->stages[i];
+    pixformat_t src_pixfmt = state->pixfmt[i];
+    pixformat_t dst_pixfmt = state->pixfmt[i + 1];
+    uint8_t *dst = state->rows[i];
+    int w = state->w;
+    image_t dst_img = {.w = w, .h = 1, .pixfmt = dst_pixfmt, .data = dst};
+
+    switch (stage->op) {
+        case IMLIB_PIPELINE_OP_TO_GRAYSCALE:
+        case IMLIB_PIPELINE_OP_TO_RGB565: {
+            pipeline_convert_row(row, src_pixfmt, dst, dst_pixfmt, w);
+            break;
+        }
+        case IMLIB_PIPELINE_OP_SEPCONV3: {
+            // Buffer the input row and output the row above it once its lower neighbour is known.
+            memcpy(state->ring[i] + (y % 3) * w, row, w);
+            if (y > 0) {
+                pipeline_sepconv3_emit(state, i, y - 1);
+            }
+            return;
+        }
+        #ifdef IMLIB_ENABLE_ISP_OPS
+        case IMLIB_PIPELINE_OP_GAMMA: {
+            memcpy(dst, row, image_line_size(&dst_img));
+            imlib_gamma_lut_apply(&dst_img, state->luts[i]);
+            break;
+        }
+        case IMLIB_PIPELINE_OP_CCM: {
+            memcpy(dst, row, image_line_size(&dst_img));
+            imlib_ccm(&dst_img, stage->ccm.ccm, stage->ccm.offset);
+            break;
+        }
+        #endif // IMLIB_ENABLE_ISP_OPS
+        #ifdef IMLIB_ENABLE_BINARY_OPS
+        case IMLIB_PIPELINE_OP_BINARY: {
+            pipeline_binary_row(stage, row, src_pixfmt, (uint32_t *) dst, w);
+            break;
+        }
+        #endif // IMLIB_ENABLE_BINARY_OPS
+        case IMLIB_PIPELINE_OP_LINE_OP: {
+            image_t *other = stage->line_op.other;
+            imlib_draw_row_data_t data = {
+                .dst_img = &dst_img,
+                .dst_row_override = other ? (other->data + (y * image_line_size(other))) : state->ring[i],
+            };
+            memcpy(dst, row, image_line_size(&dst_img));
+            stage->line_op.callback(0, w, 0, &data);
+            break;
+        }
+        default: {
+            memcpy(dst, row, image_line_size(&dst_img));
+            break;
+        }
+    }
+
+    pipeline_push(state, i + 1, dst, y);
+}
+
+pixformat_t imlib_pipeline_run(imlib_pipeline_t *pipeline, image_t *src,
+                               imlib_pipeline_callback_t callback, void *callback_arg) {
+    pipeline_state_t state = {
+        .pipeline = pipeline,
+        .w = src->w,
+        .h = src->h,
+        .callback = callback,
+        .callback_arg = callback_arg,
+    };
+
+    pixformat_t pixfmt = imlib_pipeline_pixfmt(pipeline, src, state.pixfmt);
+    bool has_sepconv3 = false;
+
+    for (size_t i = 0; i < pipeline->n_stages; i++) {
+        imlib_pipeline_stage_t *stage = &pipeline->stages[i];
+        state.rows[i] = uma_malloc(pipeline_line_size(state.pixfmt[i + 1], state.w), UMA_CACHE | UMA_SCRATCH);
+
+        switch (stage->op) {
+            case IMLIB_PIPELINE_OP_SEPCONV3: {
+                state.ring[i] = uma_malloc(state.w * 3, UMA_CACHE | UMA_SCRATCH);
+                has_sepconv3 = true;
+                break;
+            }
+            #ifdef IMLIB_ENABLE_ISP_OPS
+            case IMLIB_PIPELINE_OP_GAMMA: {
+                state.luts[i] = uma_malloc(IMLIB_GAMMA_LUT_SIZE, UMA_DTCM | UMA_SCRATCH);
+                imlib_gamma_lut(state.pixfmt[i + 1], stage->gamma.gamma, stage->gamma.contrast,
+                                stage->gamma.brightness, state.luts[i]);
+                break;
+            }
+            #endif // IMLIB_ENABLE_ISP_OPS
+            case IMLIB_PIPELINE_OP_LINE_OP: {
+                if (!stage->line_op.other) {
+                    state.ring[i] = uma_malloc(pipeline_line_size(state.pixfmt[i + 1], state.w), UMA_CACHE | UMA_SCRATCH);
+                    pipeline_scalar_row(stage, state.pixfmt[i + 1], state.ring[i], state.w);
+                }
+                break;
+            }
+            default: {
+                break;
+            }
+        }
+    }
+
+    if (has_sepconv3) {
+        state.vrow = uma_malloc(state.w * sizeof(uint16_t), UMA_DTCM | UMA_SCRATCH);
+    }
+
+    if (src->pixfmt != state.pixfmt[0]) {
+        state.src_row = uma_malloc(pipeline_line_size(state.pixfmt[0], state.w), UMA_CACHE | UMA_SCRATCH);
+    }
+
+    for (int y = 0; y < state.h; y++) {
+        imlib_poll_events();
+
+        const void *row = src->data + (y * image_line_size(src));
+
+        if (state.src_row) {
+            if (src->is_bayer) {
+                imlib_debayer_line(0, state.w, y, state.src_row, state.pixfmt[0], src);
+            } else {
+                imlib_deyuv_line(0, state.w, y, state.src_row, state.pixfmt[0], src);
+            }
+
+            row = state.src_row;
+        }
+
+        pipeline_push(&state, 0, row, y);
+    }
+
+    // Flush the last row of each kernel stage, which may feed a later kernel stage.
+    for (size_t i = 0; i < pipeline->n_stages; i++) {
+        if ((pipeline->stages[i].op == IMLIB_PIPELINE_OP_SEPCONV3) && state.h) {
+            pipeline_sepconv3_emit(&state, i, state.h - 1);
+        }
+    }
+
+    uma_free(state.src_row);
+    uma_free(state.vrow);
+
+    for (size_t i = pipeline->n_stages; i > 0; i--) {
+        uma_free(state.luts[i - 1]);
+        uma_free(state.ring[i - 1]);
+        uma_free(state.rows[i - 1]);
+    }
+
+    return pixfmt;
+}
+
+void imlib_pipeline_image_cb(void *arg, const void *row, int y) {
+    image_t *dst = arg;
+    size_t size = image_line_size(dst);
+    memcpy(dst->data + (y * size), row, size);
+}
+
+void imlib_pipeline_histogram_start(imlib_pipeline_histogram_t *state) {
+    histogram_t *hist = state->hist;
+    memset(hist->LBins, 0, hist->LBinCount * sizeof(uint32_t));
+
+    if (state->pixfmt == PIXFORMAT_RGB565) {
+        memset(hist->ABins, 0, hist->ABinCount * sizeof(uint32_t));
+        memset(hist->BBins, 0, hist->BBinCount * sizeof(uint32_t));
+    }
+
+    state->pixels = 0;
+}
+
+void imlib_pipeline_histogram_cb(void *arg, const void *row, int y) {
+    imlib_pipeline_histogram_t *state = arg;
+    histogram_t *hist = state->hist;
+    uint32_t *l_bins = (uint32_t *) hist->LBins;
+
+    switch (state->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            float mult = (hist->LBinCount - 1) / ((float) (COLOR_BINARY_MAX - COLOR_BINARY_MIN));
+            for (int x = 0; x < state->w; x++) {
+                int pixel = IMAGE_GET_BINARY_PIXEL_FAST((uint32_t *) row, x);
+                l_bins[fast_roundf((pixel - COLOR_BINARY_MIN) * mult)]++;
+            }
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            float mult = (hist->LBinCount - 1) / ((float) (COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN));
+            for (int x = 0; x < state->w; x++) {
+                int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST((uint8_t *) row, x);
+                l_bins[fast_roundf((pixel - COLOR_GRAYSCALE_MIN) * mult)]++;
+            }
+            break;
+        }
+        case PIXFORMAT_RGB565: {
+            uint32_t *a_bins = (uint32_t *) hist->ABins;
+            uint32_t *b_bins = (uint32_t *) hist->BBins;
+            float l_mult = (hist->LBinCount - 1) / ((float) (COLOR_L_MAX - COLOR_L_MIN));
+            float a_mult = (hist->ABinCount - 1) / ((float) (COLOR_A_MAX - COLOR_A_MIN));
+            float b_mult = (hist->BBinCount - 1) / ((float) (COLOR_B_MAX - COLOR_B_MIN));
+            for (int x = 0; x < state->w; x++) {
+                int pixel = IMAGE_GET_RGB565_PIXEL_FAST((uint16_t *) row, x);
+                l_bins[fast_roundf((COLOR_RGB565_TO_L(pixel) - COLOR_L_MIN) * l_mult)]++;
+                a_bins[fast_roundf((COLOR_RGB565_TO_A(pixel) - COLOR_A_MIN) * a_mult)]++;
+                b_bins[fast_roundf((COLOR_RGB565_TO_B(pixel) - COLOR_B_MIN) * b_mult)]++;
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+
+    state->pixels += state->w;
+}
+
+void imlib_pipeline_histogram_finish(imlib_pipeline_histogram_t *state) {
+    histogram_t *hist = state->hist;
+    float pixels = IM_DIV(1, ((float) state->pixels));
+
+    for (int i = 0, j = hist->LBinCount; i < j; i++) {
+        hist->LBins[i] = ((uint32_t *) hist->LBins)[i] * pixels;
+    }
+
+    for (int i = 0, j = hist->ABinCount; i < j; i++) {
+        hist->ABins[i] = ((uint32_t *) hist->ABins)[i] * pixels;
+    }
+
+    for (int i = 0, j = hist->BBinCount; i < j; i++) {
+        hist->BBins[i] = ((uint32_t *) hist->BBins)[i] * pixels;
+    }
+}
+
+void imlib_pipeline_find_blobs_cb(void *arg, const void *row, int y) {
+    imlib_find_blobs_row((blob_labeler_t *) arg, row, y);
+}
+
+#if (OMV_JPEG_CODEC_ENABLE == 0)
+void imlib_pipeline_jpeg_start(imlib_pipeline_jpeg_t *state, image_t *dst, int w, int h, pixformat_t pixfmt,
+                               int quality, jpeg_subsampling_t subsampling) {
+    // The output grows as needed, since the pipeline's row buffers are allocated after it.
+    jpeg_encoder_start(&state->enc, dst, w, h, pixfmt == PIXFORMAT_RGB565, quality, true, subsampling);
+    state->h = h;
+    state->band = (image_t) {
+        .w = w,
+        .h = state->enc.band_h,
+        .pixfmt = pixfmt,
+    };
+    state->band.data = uma_malloc(image_size(&state->band), UMA_CACHE | UMA_SCRATCH);
+}
+
+void imlib_pipeline_jpeg_cb(void *arg, const void *row, int y) {
+    imlib_pipeline_jpeg_t *state = arg;
+    image_t *band = &state->band;
+    int band_y = y % state->enc.band_h;
+    size_t size = image_line_size(band);
+
+    // The rest of the image is dropped once the output overflows.
+    if (state->enc.buf.overflow) {
+        return;
+    }
+
+    memcpy(band->data + (band_y * size), row, size);
+
+    if ((band_y == (state->enc.band_h - 1)) || (y == (state->h - 1))) {
+        // The last band may be shorter, the encoder pads it.
+        band->h = band_y + 1;
+        jpeg_encoder_band(&state->enc, band, 0);
+    }
+}
+
+bool imlib_pipeline_jpeg_finish(imlib_pipeline_jpeg_t *state) {
+    uma_free(state->band.data);
+    state->band.data = NULL;
+    return jpeg_encoder_finish(&state->enc);
+}
+#endif // (OMV_JPEG_CODEC_ENABLE == 0)
@@ -0,0 +1,457 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Cached remap tables for geometric corrections.
+ *
+ * A remap table holds the source pixel of every destination pixel so that fixed geometric
+ * corrections (lens, rotation, polar) are computed once and then applied with a gather.
+ * Dense tables store per-row spans of valid pixels, each span holds the source offset of
+ * its first pixel and an int16 step to each following one, a new span starts when a step
+ * doesn't fit. Tiled tables only store the source coordinates at the corners of 8x8 tiles
+ * and interpolate between them, which trades exactness for a much smaller table. Cached
+ * tables share a total budget, other slots are evicted to make room and tables that don't
+ * fit aren't cached. Without memory for a table, the source of each pixel is computed
+ * while the map is applied.
+ */
+#include "imlib.h"
+#include "fmath.h"
+#include "simd.h"
+
+#ifdef IMLIB_ENABLE_REMAP
+#define IMLIB_REMAP_TILE        (1 << IMLIB_REMAP_TILE_SHIFT)
+// Keeps Q16 coordinates within int32 range.
+#define IMLIB_REMAP_COORD_MAX   (16383.0f)
+
+typedef struct imlib_remap_cache {
+    imlib_remap_t map;
+    size_t key_size;
+    uint8_t key[IMLIB_REMAP_KEY_SIZE];
+} imlib_remap_cache_t;
+
+static imlib_remap_cache_t imlib_remap_cache[IMLIB_REMAP_CACHE_MAX];
+
+static inline float imlib_remap_clamp(float v) {
+    // NaN (i.e. points at infinity) ends up out of bounds.
+    if (!(v > -IMLIB_REMAP_COORD_MAX)) {
+        return -IMLIB_REMAP_COORD_MAX;
+    }
+    return IM_MIN(v, IMLIB_REMAP_COORD_MAX);
+}
+
+// Returns the source offset of a pixel, or UINT32_MAX if it's outside of the image.
+static inline uint32_t imlib_remap_offset(imlib_remap_t *map, int x, int y) {
+    if ((x < 0) || (x >= map->w) || (y < 0) || (y >= map->h)) {
+        return UINT32_MAX;
+    }
+    return (y * map->stride) + x;
+}
+
+static void imlib_remap_free(imlib_remap_t *map) {
+    if (map->row_spans) {
+        uma_free(map->row_spans);
+    }
+    if (map->spans) {
+        uma_free(map->spans);
+    }
+    if (map->deltas) {
+        uma_free(map->deltas);
+    }
+    if (map->grid) {
+        uma_free(map->grid);
+    }
+    map->row_spans = NULL;
+    map->spans = NULL;
+    map->deltas = NULL;
+    map->grid = NULL;
+    map->size = 0;
+}
+
+static bool imlib_remap_init_dense(imlib_remap_t *map, imlib_remap_point_t point, const void *args, uint32_t flags) {
+    size_t n_spans = 0, n_deltas = 0;
+
+    // The first pass sizes the table and the second one fills it.
+    for (int pass = 0; pass < 2; pass++) {
+        n_spans = 0;
+        n_deltas = 0;
+
+        for (int y = 0; y < map->h; y++) {
+            uint32_t last = UINT32_MAX;
+            imlib_poll_events_noexc();
+
+            if (pass) {
+                map->row_spans[y] = n_spans;
+            }
+
+            for (int x = 0; x < map->w; x++) {
+                float sx, sy;
+                point(args, x, y, &sx, &sy);
+                uint32_t offset = imlib_remap_offset(map, fast_roundf(imlib_remap_clamp(sx)),
+                                                     fast_roundf(imlib_remap_clamp(sy)));
+
+                if (offset == UINT32_MAX) {
+                    last = UINT32_MAX;
+                    continue;
+                }
+                int32_t delta = offset - last;
+
+                // Pixels continue the span if their step fits, otherwise they start a new one.
+                if ((last != UINT32_MAX) && (delta >= INT16_MIN) && (delta <= INT16_MAX)) {
+                    if (pass) {
+                        map->spans[n_spans - 1].n += 1;
+                        map->deltas[n_deltas] = delta;
+                    }
+                    n_deltas += 1;
+                } else {
+                    if (pass) {
+                        map->spans[n_spans].x = x;
+                        map->spans[n_spans].n = 1;
+                        map->spans[n_spans].offset = offset;
+                    }
+                    n_spans += 1;
+                }
+
+                last = offset;
+            }
+        }
+
+        if (!pass) {
+            map->size = (sizeof(uint32_t) * (map->h + 1)) +
+                        (sizeof(imlib_remap_span_t) * IM_MAX(n_spans, 1u)) +
+                        (sizeof(int16_t) * IM_MAX(n_deltas, 1u));
+            map->row_spans = uma_malloc(sizeof(uint32_t) * (map->h + 1), flags);
+            map->spans = uma_malloc(sizeof(imlib_remap_span_t) * IM_MAX(n_spans, 1u), flags);
+            map->deltas = uma_malloc(sizeof(int16_t) * IM_MAX(n_deltas, 1u), flags);
+            if (!map->row_spans || !map->spans || !map->deltas) {
+                imlib_remap_free(map);
+                return false;
+            }
+        }
+    }
+
+    map->row_spans[map->h] = n_spans;
+    return true;
+}
+
+static bool imlib_remap_init_tiled(imlib_remap_t *map, imlib_remap_point_t point, const void *args, uint32_t flags) {
+    // Tile corners are placed every IMLIB_REMAP_TILE pixels, plus the last row and column.
+    map->grid_w = ((map->w + IMLIB_REMAP_TILE - 2) >> IMLIB_REMAP_TILE_SHIFT) + 1;
+    map->grid_h = ((map->h + IMLIB_REMAP_TILE - 2) >> IMLIB_REMAP_TILE_SHIFT) + 1;
+    map->grid = uma_malloc(sizeof(int32_t) * 2 * map->grid_w * map->grid_h, flags);
+    if (!map->grid) {
+        return false;
+    }
+    map->size = sizeof(int32_t) * 2 * map->grid_w * map->grid_h;
+
+    for (int j = 0; j < map->grid_h; j++) {
+        int y = IM_MIN(j << IMLIB_REMAP_TILE_SHIFT, map->h - 1);
+        imlib_poll_events_noexc();
+
+        for (int i = 0; i < map->grid_w; i++) {
+            int x = IM_MIN(i << IMLIB_REMAP_TILE_SHIFT, map->w - 1);
+            int32_t *corner = map->grid + (((j * map->grid_w) + i) * 2);
+            float sx, sy;
+            point(args, x, y, &sx, &sy);
+            corner[0] = fast_roundf(imlib_remap_clamp(sx) * 65536.0f);
+            corner[1] = fast_roundf(imlib_remap_clamp(sy) * 65536.0f);
+        }
+    }
+    return true;
+}
+
+bool imlib_remap_init(imlib_remap_t *map, image_t *img, imlib_remap_point_t point, const void *args,
+                      bool tiled, uint32_t flags) {
+    memset(map, 0, sizeof(imlib_remap_t));
+    map->w = img->w;
+    map->h = img->h;
+    map->pixfmt = img->pixfmt;
+    map->stride = (img->pixfmt == PIXFORMAT_BINARY) ? (IMAGE_BINARY_LINE_LEN(img) * 32) : img->w;
+
+    // Tiles need at least two corners per axis.
+    tiled = tiled && (map->w > 1) && (map->h > 1);
+
+    bool built;
+    if (!tiled) {
+        built = imlib_remap_init_dense(map, point, args, flags);
+    } else {
+        built = ((sizeof(int16_t) * map->w * map->h) <= IMLIB_REMAP_DENSE_MAX) &&
+                imlib_remap_init_dense(map, point, args, flags | UMA_MAYBE);
+        built = built || imlib_remap_init_tiled(map, point, args, flags);
+    }
+
+    // Without memory for a table (UMA_MAYBE) the map computes each source while it's applied,
+    // so the point function and its arguments must outlive the map.
+    if (!built) {
+        map->point = point;
+        map->args = args;
+    }
+    return built;
+}
+
+void imlib_remap_deinit(imlib_remap_t *map) {
+    imlib_remap_free(map);
+    memset(map, 0, sizeof(imlib_remap_t));
+}
+
+// Copies n pixels from the source offsets into the destination row starting at x.
+static void imlib_remap_gather(image_t *dst, image_t *src, int x, int y, int n, const uint32_t *offsets) {
+    switch (src->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            uint32_t *src_ptr = (uint32_t *) src->data;
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+            for (int i = 0; i < n; i++) {
+                IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x + i, IMAGE_GET_BINARY_PIXEL_FAST(src_ptr, offsets[i]));
+            }
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y) + x;
+            for (int i = 0; i < n; i += UINT32_VECTOR_SIZE) {
+                v128_predicate_t pred = vpredicate_32(n - i);
+                v128_t offs = vldr_u32_pred(offsets + i, pred);
+                vstr_u32_narrow_u8_pred(row_ptr + i, vldr_u8_widen_u32_gather_pred(src->data, offs, pred), pred);
+            }
+            break;
+        }
+        case PIXFORMAT_RGB565: {
+            uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y) + x;
+            for (int i = 0; i < n; i += UINT32_VECTOR_SIZE) {
+                v128_predicate_t pred = vpredicate_32(n - i);
+                v128_t offs = vldr_u32_pred(offsets + i, pred);
+                vstr_u32_narrow_u16_pred(row_ptr + i,
+                                         vldr_u16_widen_u32_gather_pred((uint16_t *) src->data, offs, pred), pred);
+            }
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// Clears n pixels of the destination row starting at x, for pixels that have no source.
+static void imlib_remap_fill(image_t *dst, int x, int y, int n) {
+    switch (dst->pixfmt) {
+        case PIXFORMAT_BINARY: {
+            uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(dst, y);
+            for (int i = x; i < (x + n); i++) {
+                IMAGE_CLEAR_BINARY_PIXEL_FAST(row_ptr, i);
+            }
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            memset(IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(dst, y) + x, 0, n);
+            break;
+        }
+        case PIXFORMAT_RGB565: {
+            memset(IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(dst, y) + x, 0, n * sizeof(uint16_t));
+            break;
+        }
+        default: {
+            break;
+        }
+    }
+}
+
+// Computes the source offsets of a destination row from the tile corners.
+static void imlib_remap_tiled_row(imlib_remap_t *map, int y, uint32_t *offsets) {
+    int j = IM_MIN(y >> IMLIB_REMAP_TILE_SHIFT, map->grid_h - 2);
+    int y0 = j << IMLIB_REMAP_TILE_SHIFT;
+    int y1 = IM_MIN(y0 + IMLIB_REMAP_TILE, map->h - 1);
+    int64_t wy = ((y - y0) << 16) / (y1 - y0);
+    int32_t *top = map->grid + (j * map->grid_w * 2);
+    int32_t *bottom = top + (map->grid_w * 2);
+
+    for (int i = 0; i < (map->grid_w - 1); i++) {
+        int x0 = i << IMLIB_REMAP_TILE_SHIFT;
+        int x1 = IM_MIN(x0 + IMLIB_REMAP_TILE, map->w - 1);
+        // The last tile also covers the last column.
+        int x_end = (i == (map->grid_w - 2)) ? (x1 + 1) : x1;
+
+        // Interpolate the left and right tile edges, then step across the tile.
+        int32_t lx = top[i * 2 + 0] + (((bottom[i * 2 + 0] - (int64_t) top[i * 2 + 0]) * wy) >> 16);
+        int32_t ly = top[i * 2 + 1] + (((bottom[i * 2 + 1] - (int64_t) top[i * 2 + 1]) * wy) >> 16);
+        int32_t rx = top[i * 2 + 2] + (((bottom[i * 2 + 2] - (int64_t) top[i * 2 + 2]) * wy) >> 16);
+        int32_t ry = top[i * 2 + 3] + (((bottom[i * 2 + 3] - (int64_t) top[i * 2 + 3]) * wy) >> 16);
+        int32_t dx = (rx - lx) / (x1 - x0);
+        int32_t dy = (ry - ly) / (x1 - x0);
+
+        for (int x = x0; x < x_end; x++, lx += dx, ly += dy) {
+            offsets[x] = imlib_remap_offset(map, (lx + 0x8000) >> 16, (ly + 0x8000) >> 16);
+        }
+    }
+}
+
+// Computes the source offsets of a destination row with the point function.
+static void imlib_remap_point_row(imlib_remap_t *map, int y, uint32_t *offsets) {
+    for (int x = 0; x < map->w; x++) {
+        float sx, sy;
+        map->point(map->args, x, y, &sx, &sy);
+        offsets[x] = imlib_remap_offset(map, fast_roundf(imlib_remap_clamp(sx)), fast_roundf(imlib_remap_clamp(sy)));
+    }
+}
+
+void imlib_remap_apply(imlib_remap_t *map, image_t *dst, image_t *src) {
+    uint32_t *offsets = uma_malloc(sizeof(uint32_t) * map->w, UMA_FAST);
+    int16_t *deltas = map->deltas;
+
+    // Every destination pixel is written once, either from its source or with the fill value.
+    for (int y = 0; y < map->h; y++) {
+        if (map->row_spans) {
+            int x = 0;
+            for (uint32_t s = map->row_spans[y]; s < map->row_spans[y + 1]; s++) {
+                imlib_remap_span_t *span = &map->spans[s];
+                if (span->x > x) {
+                    imlib_remap_fill(dst, x, y, span->x - x);
+                }
+
+                // Expand the span's steps into offsets for the gather.
+                uint32_t offset = span->offset;
+                offsets[0] = offset;
+                for (int i = 1; i < span->n; i++) {
+                    offset += *deltas++;
+                    offsets[i] = offset;
+                }
+
+                imlib_remap_gather(dst, src, span->x, y, span->n, offsets);
+                x = span->x + span->n;
+            }
+            if (x < map->w) {
+                imlib_remap_fill(dst, x, y, map->w - x);
+            }
+            continue;
+        }
+
+        if (map->grid) {
+            imlib_remap_tiled_row(map, y, offsets);
+        } else {
+            imlib_poll_events_noexc();
+            imlib_remap_point_row(map, y, offsets);
+        }
+
+        for (int x = 0; x < map->w;) {
+            bool valid = offsets[x] != UINT32_MAX;
+            int n = 1;
+            while (((x + n) < map->w) && ((offsets[x + n] != UINT32_MAX) == valid)) {
+                n++;
+            }
+
+            if (valid) {
+                imlib_remap_gather(dst, src, x, y, n, offsets + x);
+            } else {
+                imlib_remap_fill(dst, x, y, n);
+            }
+            x += n;
+        }
+    }
+
+    uma_free(offsets);
+}
+
+void imlib_remap_image(imlib_remap_t *map, image_t *dst, image_t *src) {
+    if (dst->data != src->data) {
+        imlib_remap_apply(map, dst, src);
+        return;
+    }
+
+    // A gather can't run in place, so the result is staged and copied back.
+    image_t tmp = *dst;
+    size_t size = image_size(dst);
+    tmp.data = uma_malloc(size, 0);
+    imlib_remap_apply(map, &tmp, src);
+    memcpy(dst->data, tmp.data, size);
+    uma_free(tmp.data);
+}
+
+void imlib_remap_once(image_t *dst, image_t *src, imlib_remap_point_t point, const void *args, bool tiled) {
+    imlib_remap_t map;
+    imlib_remap_init(&map, src, point, args, tiled, UMA_MAYBE);
+    imlib_remap_image(&map, dst, src);
+    imlib_remap_deinit(&map);
+}
+
+void imlib_remap_init0(void) {
+    // The heap was reset, so there's nothing to free.
+    memset(imlib_remap_cache, 0, sizeof(imlib_remap_cache));
+}
+
+void imlib_remap_deinit0(void) {
+    for (int i = 0; i < IMLIB_REMAP_CACHE_MAX; i++) {
+        imlib_remap_deinit(&imlib_remap_cache[i].map);
+        imlib_remap_cache[i].key_size = 0;
+    }
+}
+
+imlib_remap_t *imlib_remap_cache_get(imlib_remap_cache_slot_t slot, image_t *img, const void *key, size_t key_size) {
+    imlib_remap_cache_t *cache = &imlib_remap_cache[slot];
+
+    if ((cache->key_size != key_size) ||
+        (cache->map.w != img->w) ||
+        (cache->map.h != img->h) ||
+        (cache->map.pixfmt != img->pixfmt) ||
+        memcmp(cache->key, key, key_size)) {
+        // The table is stale, free it before the caller builds the new one.
+        imlib_remap_deinit(&cache->map);
+        cache->key_size = 0;
+        return NULL;
+    }
+
+    return &cache->map;
+}
+
+imlib_remap_t *imlib_remap_cache_set(imlib_remap_cache_slot_t slot, image_t *img, const void *key, size_t key_size,
+                                     imlib_remap_point_t point, const void *args, bool tiled) {
+    imlib_remap_cache_t *cache = &imlib_remap_cache[slot];
+    imlib_remap_deinit(&cache->map);
+    cache->key_size = 0;
+
+    // Cached tables outlive the exceptions that free transient allocations. A map that has
+    // no table uses the caller's arguments, so it's only valid for this call.
+    if (!imlib_remap_init(&cache->map, img, point, args, tiled, UMA_PERSIST | UMA_MAYBE)) {
+        return &cache->map;
+    }
+
+    // Tables larger than the cache are only used for this call, the next lookup frees them.
+    if (cache->map.size > IMLIB_REMAP_CACHE_SIZE) {
+        return &cache->map;
+    }
+
+    // Evict the other slots until the table fits.
+    for (int i = 0; i < IMLIB_REMAP_CACHE_MAX; i++) {
+        size_t used = 0;
+        for (int j = 0; j < IMLIB_REMAP_CACHE_MAX; j++) {
+            used += imlib_remap_cache[j].map.size;
+        }
+        if (used <= IMLIB_REMAP_CACHE_SIZE) {
+            break;
+        }
+        if (i != slot) {
+            imlib_remap_deinit(&imlib_remap_cache[i].map);
+            imlib_remap_cache[i].key_size = 0;
+        }
+    }
+
+    memcpy(cache->key, key, key_size);
+    cache->key_size = key_size;
+    return &cache->map;
+}
+#endif // IMLIB_ENABLE_REMAP
@@ -16,17 +16,43 @@
 #include "common/homography.h"
 
 #ifdef IMLIB_ENABLE_ROTATION_CORR
+typedef struct imlib_rotation_corr_key {
+    float x_rotation, y_rotation, z_rotation;
+    float x_translation, y_translation;
+    float zoom, fov;
+    float corners[8];
+    bool has_corners;
+} imlib_rotation_corr_key_t;
+
+typedef struct imlib_rotation_corr_args {
+    float T[3][3];  // Destination to source homography.
+    bool valid, affine;
+} imlib_rotation_corr_args_t;
+
+static void imlib_rotation_corr_point(const void *args, int x, int y, float *sx, float *sy) {
+    const imlib_rotation_corr_args_t *a = args;
+
+    if (!a->valid) {
+        *sx = -1.0f;
+        *sy = -1.0f;
+    } else if (a->affine) {
+        *sx = a->T[0][0] * x + a->T[0][1] * y + a->T[0][2];
+        *sy = a->T[1][0] * x + a->T[1][1] * y + a->T[1][2];
+    } else {
+        float xxx = a->T[0][0] * x + a->T[0][1] * y + a->T[0][2];
+        float yyy = a->T[1][0] * x + a->T[1][1] * y + a->T[1][2];
+        float zzz = a->T[2][0] * x + a->T[2][1] * y + a->T[2][2];
+        *sx = xxx / zzz;
+        *sy = yyy / zzz;
+    }
+}
+
 // http://jepsonsblog.blogspot.com/2012/11/rotation-in-3d-using-opencvs.html
-void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float z_rotation,
-                         float x_translation, float y_translation,
-                         float zoom, float fov, float *corners) {
-    size_t size = image_size(img);
-    void *data = uma_malloc(size, 0);
-    memcpy(data, img->data, size);
-    memset(img->data, 0, size);
-
-    int w = img->w;
-    int h = img->h;
+static void imlib_rotation_corr_args(imlib_rotation_corr_args_t *args, int w, int h,
+                                     float x_rotation, float y_rotation, float z_rotation,
+                                     float x_translation, float y_translation,
+                                     float zoom, float fov, float *corners) {
+    memset(args, 0, sizeof(imlib_rotation_corr_args_t));
     float z = (fast_sqrtf((w * w) + (h * h)) / 2) / tanf(fov / 2);
     float z_z = z * zoom;
 
@@ -129,145 +155,20 @@ void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float
     }
 
     if (T4) {
-        float T4_00 = MATD_EL(T4, 0, 0), T4_01 = MATD_EL(T4, 0, 1), T4_02 = MATD_EL(T4, 0, 2);
-        float T4_10 = MATD_EL(T4, 1, 0), T4_11 = MATD_EL(T4, 1, 1), T4_12 = MATD_EL(T4, 1, 2);
-        float T4_20 = MATD_EL(T4, 2, 0), T4_21 = MATD_EL(T4, 2, 1), T4_22 = MATD_EL(T4, 2, 2);
+        args->valid = true;
+        args->affine = (fast_fabsf(MATD_EL(T4, 2, 0)) < MATD_EPS) && (fast_fabsf(MATD_EL(T4, 2, 1)) < MATD_EPS);
 
-        if ((fast_fabsf(T4_20) < MATD_EPS) && (fast_fabsf(T4_21) < MATD_EPS)) {
-            // warp affine
-            T4_00 /= T4_22;
-            T4_01 /= T4_22;
-            T4_02 /= T4_22;
-            T4_10 /= T4_22;
-            T4_11 /= T4_22;
-            T4_12 /= T4_22;
-            switch (img->pixfmt) {
-                case PIXFORMAT_BINARY: {
-                    uint32_t *tmp = (uint32_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            int sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-                            int sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY);
-                                int pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                case PIXFORMAT_GRAYSCALE: {
-                    uint8_t *tmp = (uint8_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            int sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-                            int sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint8_t *ptr = tmp + (w * sourceY);
-                                int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                case PIXFORMAT_RGB565: {
-                    uint16_t *tmp = (uint16_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            int sourceX = fast_roundf(T4_00 * x + T4_01 * y + T4_02);
-                            int sourceY = fast_roundf(T4_10 * x + T4_11 * y + T4_12);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint16_t *ptr = tmp + (w * sourceY);
-                                int pixel = IMAGE_GET_RGB565_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                default: {
-                    break;
-                }
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                args->T[i][j] = MATD_EL(T4, i, j);
             }
-        } else {
-            // warp perspective
-            switch (img->pixfmt) {
-                case PIXFORMAT_BINARY: {
-                    uint32_t *tmp = (uint32_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint32_t *row_ptr = IMAGE_COMPUTE_BINARY_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            float xxx = T4_00 * x + T4_01 * y + T4_02;
-                            float yyy = T4_10 * x + T4_11 * y + T4_12;
-                            float zzz = T4_20 * x + T4_21 * y + T4_22;
-                            int sourceX = fast_roundf(xxx / zzz);
-                            int sourceY = fast_roundf(yyy / zzz);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint32_t *ptr = tmp + (((w + UINT32_T_MASK) >> UINT32_T_SHIFT) * sourceY);
-                                int pixel = IMAGE_GET_BINARY_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_BINARY_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                case PIXFORMAT_GRAYSCALE: {
-                    uint8_t *tmp = (uint8_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint8_t *row_ptr = IMAGE_COMPUTE_GRAYSCALE_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            float xxx = T4_00 * x + T4_01 * y + T4_02;
-                            float yyy = T4_10 * x + T4_11 * y + T4_12;
-                            float zzz = T4_20 * x + T4_21 * y + T4_22;
-                            int sourceX = fast_roundf(xxx / zzz);
-                            int sourceY = fast_roundf(yyy / zzz);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint8_t *ptr = tmp + (w * sourceY);
-                                int pixel = IMAGE_GET_GRAYSCALE_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_GRAYSCALE_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                case PIXFORMAT_RGB565: {
-                    uint16_t *tmp = (uint16_t *) data;
-
-                    for (int y = 0, yy = h; y < yy; y++) {
-                        uint16_t *row_ptr = IMAGE_COMPUTE_RGB565_PIXEL_ROW_PTR(img, y);
-                        for (int x = 0, xx = w; x < xx; x++) {
-                            float xxx = T4_00 * x + T4_01 * y + T4_02;
-                            float yyy = T4_10 * x + T4_11 * y + T4_12;
-                            float zzz = T4_20 * x + T4_21 * y + T4_22;
-                            int sourceX = fast_roundf(xxx / zzz);
-                            int sourceY = fast_roundf(yyy / zzz);
-
-                            if ((0 <= sourceX) && (sourceX < w) && (0 <= sourceY) && (sourceY < h)) {
-                                uint16_t *ptr = tmp + (w * sourceY);
-                                int pixel = IMAGE_GET_RGB565_PIXEL_FAST(ptr, sourceX);
-                                IMAGE_PUT_RGB565_PIXEL_FAST(row_ptr, x, pixel);
-                            }
-                        }
-                    }
-                    break;
-                }
-                default: {
-                    break;
+        }
+
+        if (args->affine) {
+            // warp affine
+            for (int i = 0; i < 2; i++) {
+                for (int j = 0; j < 3; j++) {
+                    args->T[i][j] /= args->T[2][2];
                 }
             }
         }
@@ -285,7 +186,41 @@ void imlib_rotation_corr(image_t *img, float x_rotation, float y_rotation, float
     matd_destroy(RY);
     matd_destroy(RX);
     matd_destroy(A1);
+}
+
+void imlib_rotation_corr(image_t *dst, image_t *src, float x_rotation, float y_rotation, float z_rotation,
+                         float x_translation, float y_translation,
+                         float zoom, float fov, float *corners, bool cache) {
+    imlib_rotation_corr_key_t key;
+    memset(&key, 0, sizeof(key));
+    key.x_rotation = x_rotation;
+    key.y_rotation = y_rotation;
+    key.z_rotation = z_rotation;
+    key.x_translation = x_translation;
+    key.y_translation = y_translation;
+    key.zoom = zoom;
+    key.fov = fov;
+    key.has_corners = corners != NULL;
+    if (corners) {
+        memcpy(key.corners, corners, sizeof(key.corners));
+    }
+
+    imlib_remap_t *map = cache ? imlib_remap_cache_get(IMLIB_REMAP_CACHE_ROTATION_CORR, src, &key, sizeof(key)) : NULL;
+
+    if (!map) {
+        imlib_rotation_corr_args_t args;
+        imlib_rotation_corr_args(&args, src->w, src->h, x_rotation, y_rotation, z_rotation,
+                                 x_translation, y_translation, zoom, fov, corners);
+
+        if (!cache) {
+            imlib_remap_once(dst, src, imlib_rotation_corr_point, &args, true);
+            return;
+        }
+
+        map = imlib_remap_cache_set(IMLIB_REMAP_CACHE_ROTATION_CORR, src, &key, sizeof(key),
+                                    imlib_rotation_corr_point, &args, true);
+    }
 
-    uma_free(data);
+    imlib_remap_image(map, dst, src);
 }
 #endif //IMLIB_ENABLE_ROTATION_CORR
@@ -841,6 +841,34 @@ static inline v128_t vshlc(v128_t v0, uint32_t *reg, uint32_t n) {
 }
 #endif
 
+static inline v128_t vadd_u8(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vaddq_u8(v0.u8, v1.u8);
+    #elif (__ARM_ARCH >= 7)
+    return (v128_t) {
+        .u32 = { __UADD8(v0.u32[0], v1.u32[0]) }
+    };
+    #else
+    return (v128_t) {
+        .u8 = v0.u8 + v1.u8
+    };
+    #endif
+}
+
+static inline v128_t vadd_u16(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vaddq_u16(v0.u16, v1.u16);
+    #elif (__ARM_ARCH >= 7)
+    return (v128_t) {
+        .u32 = { __UADD16(v0.u32[0], v1.u32[0]) }
+    };
+    #else
+    return (v128_t) {
+        .u16 = v0.u16 + v1.u16
+    };
+    #endif
+}
+
 static inline v128_t vadd_u32(v128_t v0, v128_t v1) {
     #if (__ARM_ARCH >= 8)
     return (v128_t) vaddq_u32(v0.u32, v1.u32);
@@ -937,6 +965,16 @@ static inline v128_t vsub_s16(v128_t v0, v128_t v1) {
     #endif
 }
 
+static inline v128_t vsub_s32(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vsubq_s32(v0.s32, v1.s32);
+    #else
+    return (v128_t) {
+        .s32 = v0.s32 - v1.s32
+    };
+    #endif
+}
+
 static inline v128_t vsub_n_u32(v128_t v0, uint32_t x) {
     #if (__ARM_ARCH >= 8)
     return (v128_t) vsubq_n_u32(v0.u32, x);
@@ -1043,6 +1081,16 @@ static inline v128_t vasr_s32(v128_t v0, uint32_t n) {
 }
 #endif
 
+#if (__ARM_ARCH >= 8)
+#define vlsl_u8(v0, n) ((v128_t) vshlq_n(v0.u8, n))
+#else
+static inline v128_t vlsl_u8(v128_t v0, uint32_t n) {
+    return (v128_t) {
+        .u8 = v0.u8 << n
+    };
+}
+#endif
+
 #if (__ARM_ARCH >= 8)
 #define vlsl_u16(v0, n) ((v128_t) vshlq_n(v0.u16, n))
 #else
@@ -1083,6 +1131,16 @@ static inline v128_t vlsl_s32(v128_t v0, uint32_t n) {
 }
 #endif
 
+#if (__ARM_ARCH >= 8)
+#define vlsr_u8(v0, n) ((v128_t) vshrq(v0.u8, n))
+#else
+static inline v128_t vlsr_u8(v128_t v0, uint32_t n) {
+    return (v128_t) {
+        .u8 = v0.u8 >> n
+    };
+}
+#endif
+
 #if (__ARM_ARCH >= 8)
 #define vlsr_u16(v0, n) ((v128_t) vshrq(v0.u16, n))
 #else
@@ -1183,6 +1241,97 @@ static inline v128_t veor_s32(v128_t v0, v128_t v1) {
     #endif
 }
 
+static inline v128_t vmin_u8(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vminq_u8(v0.u8, v1.u8);
+    #elif (__ARM_ARCH >= 7)
+    uint32_t t0 = __USUB8(v0.u32[0], v1.u32[0]); (void) t0;
+    return (v128_t) {
+        .u32 = { __SEL(v1.u32[0], v0.u32[0]) }
+    };
+    #else
+    v128_t r;
+    r.u8[0] = IM_MIN(v0.u8[0], v1.u8[0]);
+    r.u8[1] = IM_MIN(v0.u8[1], v1.u8[1]);
+    r.u8[2] = IM_MIN(v0.u8[2], v1.u8[2]);
+    r.u8[3] = IM_MIN(v0.u8[3], v1.u8[3]);
+    return r;
+    #endif
+}
+
+static inline v128_t vmax_u8(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vmaxq_u8(v0.u8, v1.u8);
+    #elif (__ARM_ARCH >= 7)
+    uint32_t t0 = __USUB8(v0.u32[0], v1.u32[0]); (void) t0;
+    return (v128_t) {
+        .u32 = { __SEL(v0.u32[0], v1.u32[0]) }
+    };
+    #else
+    v128_t r;
+    r.u8[0] = IM_MAX(v0.u8[0], v1.u8[0]);
+    r.u8[1] = IM_MAX(v0.u8[1], v1.u8[1]);
+    r.u8[2] = IM_MAX(v0.u8[2], v1.u8[2]);
+    r.u8[3] = IM_MAX(v0.u8[3], v1.u8[3]);
+    return r;
+    #endif
+}
+
+static inline v128_t vmin_u16(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vminq_u16(v0.u16, v1.u16);
+    #elif (__ARM_ARCH >= 7)
+    uint32_t t0 = __USUB16(v0.u32[0], v1.u32[0]); (void) t0;
+    return (v128_t) {
+        .u32 = { __SEL(v1.u32[0], v0.u32[0]) }
+    };
+    #else
+    v128_t r;
+    r.u16[0] = IM_MIN(v0.u16[0], v1.u16[0]);
+    r.u16[1] = IM_MIN(v0.u16[1], v1.u16[1]);
+    return r;
+    #endif
+}
+
+static inline v128_t vmax_u16(v128_t v0, v128_t v1) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vmaxq_u16(v0.u16, v1.u16);
+    #elif (__ARM_ARCH >= 7)
+    uint32_t t0 = __USUB16(v0.u32[0], v1.u32[0]); (void) t0;
+    return (v128_t) {
+        .u32 = { __SEL(v0.u32[0], v1.u32[0]) }
+    };
+    #else
+    v128_t r;
+    r.u16[0] = IM_MAX(v0.u16[0], v1.u16[0]);
+    r.u16[1] = IM_MAX(v0.u16[1], v1.u16[1]);
+    return r;
+    #endif
+}
+
+// Selects lanes from t where v0 >= v1 and from f otherwise.
+static inline v128_t vsel_ge_s32(v128_t v0, v128_t v1, v128_t t, v128_t f) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vpselq_s32(t.s32, f.s32, vcmpgeq_s32(v0.s32, v1.s32));
+    #else
+    return (v128_t) {
+        .s32 = { (v0.s32[0] >= v1.s32[0]) ? t.s32[0] : f.s32[0] }
+    };
+    #endif
+}
+
+// Returns the high half of the 32-bit product: (v0 * x) >> 16.
+static inline v128_t vmulh_n_u16(v128_t v0, uint16_t x) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vmulhq_u16(v0.u16, vdupq_n_u16(x));
+    #else
+    v128_t r;
+    r.u16[0] = (v0.u16[0] * x) >> 16;
+    r.u16[1] = (v0.u16[1] * x) >> 16;
+    return r;
+    #endif
+}
+
 static inline v128_t vmul_u32(v128_t v0, v128_t v1) {
     #if (__ARM_ARCH >= 8)
     return (v128_t) vmulq_u32(v0.u32, v1.u32);
@@ -1545,6 +1694,16 @@ static inline v128_t vldr_s8_widen_s32_gather_pred(const int8_t *p,
     #endif
 }
 
+static inline v128_t vldr_s8_widen_s32(const int8_t *p) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vldrbq_s32(p);
+    #else
+    return (v128_t) {
+        .s32 = { p[0] }
+    };
+    #endif
+}
+
 static inline void vstr_u8(uint8_t *p, v128_t v0) {
     #if (__ARM_ARCH >= 8)
     vstrbq(p, v0.u8);
@@ -1669,6 +1828,17 @@ static inline void vstr_u16_narrow_u8_pred(uint8_t *p, v128_t v0, v128_predicate
     #endif
 }
 
+static inline v128_t vldr_u8_widen_u16_gather(const uint8_t *p, v128_t offsets) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vldrbq_gather_offset_u16(p, offsets.u16);
+    #else
+    v128_t v0;
+    v0.u16[0] = *(p + offsets.u16[0]);
+    v0.u16[1] = *(p + offsets.u16[1]);
+    return v0;
+    #endif
+}
+
 static inline void vstr_u16_narrow_u8_scatter(uint8_t *p, v128_t offsets, v128_t v0) {
     #if (__ARM_ARCH >= 8)
     vstrbq_scatter_offset(p, offsets.u16, v0.u16);
@@ -1747,6 +1917,18 @@ static inline v128_t vldr_f32_gather_pred(const float32_t *p,
     #endif
 }
 
+static inline v128_t vldr_u32_gather_pred(const uint32_t *p,
+                                          v128_t offsets,
+                                          v128_predicate_t pred) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vldrwq_gather_shifted_offset_z_u32(p, offsets.u32, pred);
+    #else
+    return (v128_t) {
+        .u32 = { *(p + offsets.u32[0]) }
+    };
+    #endif
+}
+
 static inline void vstr_f32_scatter(float32_t *p, v128_t offsets, v128_t v0) {
     #if (__ARM_ARCH >= 8)
     vstrwq_scatter_shifted_offset(p, offsets.u32, v0.f32);
@@ -1755,6 +1937,58 @@ static inline void vstr_f32_scatter(float32_t *p, v128_t offsets, v128_t v0) {
     #endif
 }
 
+static inline v128_t vldr_u32_pred(const uint32_t *p, v128_predicate_t pred) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vldrwq_z_u32(p, pred);
+    #else
+    return (v128_t) {
+        .u32 = { p[0] }
+    };
+    #endif
+}
+
+static inline void vstr_u32_narrow_u8_pred(uint8_t *p, v128_t v0, v128_predicate_t pred) {
+    #if (__ARM_ARCH >= 8)
+    vstrbq_p_u32(p, v0.u32, pred);
+    #else
+    *p = v0.u32[0];
+    #endif
+}
+
+static inline void vstr_u32_narrow_u16_pred(uint16_t *p, v128_t v0, v128_predicate_t pred) {
+    #if (__ARM_ARCH >= 8)
+    vstrhq_p_u32(p, v0.u32, pred);
+    #else
+    *p = v0.u32[0];
+    #endif
+}
+
+static inline v128_t vldr_s32(const int32_t *p) {
+    #if (__ARM_ARCH >= 8)
+    return (v128_t) vldrwq_s32(p);
+    #else
+    return (v128_t) {
+        .s32 = { p[0] }
+    };
+    #endif
+}
+
+static inline void vstr_s32(int32_t *p, v128_t v0) {
+    #if (__ARM_ARCH >= 8)
+    vstrwq_s32(p, v0.s32);
+    #else
+    p[0] = v0.s32[0];
+    #endif
+}
+
+static inline void vstr_s32_scatter(int32_t *p, v128_t offsets, v128_t v0) {
+    #if (__ARM_ARCH >= 8)
+    vstrwq_scatter_shifted_offset(p, offsets.u32, v0.s32);
+    #else
+    *(p + offsets.u32[0]) = v0.s32[0];
+    #endif
+}
+
 static inline v2x_rows_t vld2_u8(const uint8_t *p) {
     #if (__ARM_ARCH >= 8)
     uint8x16x2_t r = vld2q(p);
@@ -167,7 +167,7 @@ void imlib_get_similarity(image_t *img,
 
     imlib_similarity_line_op_state_t state;
     state.dssim = dssim;
-    int *base = uma_calloc(h_blocks * sizeof(int) * 5, 0);
+    int *base = uma_calloc(h_blocks * sizeof(int) * 5, UMA_SCRATCH);
     state.sumBucketsOfX = &base[h_blocks * 0];
     state.sumBucketsOfY = &base[h_blocks * 1];
     state.sum2BucketsOfX = &base[h_blocks * 2];
@@ -180,7 +180,7 @@ void imlib_get_similarity(image_t *img,
     state.lines_processed = 0;
     state.lines = p1.y - p0.y;
 
-    void *dst_row_override = uma_calloc(image_line_size(img), UMA_CACHE);
+    void *dst_row_override = uma_calloc(image_line_size(img), UMA_CACHE | UMA_SCRATCH);
     imlib_draw_image(img, other, x_start, y_start, x_scale, y_scale, roi,
                      rgb_channel, alpha, color_palette, alpha_palette, hint,
                      NULL, imlib_similarity_line_op, &state, dst_row_override);
@@ -874,7 +874,7 @@ static int get_median_l(long long *array, long long array_sum, int array_len) {
 static bool grow_points(point_t **points, size_t *points_max) {
     size_t new_max = *points_max ? (*points_max * 2) : 256;
     point_t *new_points = (point_t *) uma_realloc(*points, new_max * sizeof(point_t),
-                                                  UMA_DTCM | UMA_MAYBE);
+                                                  UMA_DTCM | UMA_MAYBE | UMA_SCRATCH);
     if (!new_points) {
         return false;
     }
@@ -896,10 +896,10 @@ bool imlib_get_regression(find_lines_list_lnk_data_t *out,
     memset(out, 0, sizeof(find_lines_list_lnk_data_t));
 
     // Theil-Sen Estimator
-    int *x_histogram = uma_calloc(ptr->w * sizeof(int), UMA_DTCM);
-    int *y_histogram = uma_calloc(ptr->h * sizeof(int), UMA_DTCM);
-    long long *x_delta_histogram = uma_calloc((2 * ptr->w) * sizeof(long long), UMA_DTCM);
-    long long *y_delta_histogram = uma_calloc((2 * ptr->h) * sizeof(long long), UMA_DTCM);
+    int *x_histogram = uma_calloc(ptr->w * sizeof(int), UMA_DTCM | UMA_SCRATCH);
+    int *y_histogram = uma_calloc(ptr->h * sizeof(int), UMA_DTCM | UMA_SCRATCH);
+    long long *x_delta_histogram = uma_calloc((2 * ptr->w) * sizeof(long long), UMA_DTCM | UMA_SCRATCH);
+    long long *y_delta_histogram = uma_calloc((2 * ptr->h) * sizeof(long long), UMA_DTCM | UMA_SCRATCH);
 
     point_t *points = NULL;
     size_t points_max = 0;
@@ -0,0 +1,195 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Temporal ROI tracker for marker detectors.
+ *
+ * Markers found in a frame are kept as tracks with a constant velocity model. Following
+ * frames only search a window around each track's predicted position, and the whole ROI
+ * is scanned every N frames, when a track is lost, or when there's nothing to track.
+ */
+#include "imlib.h"
+#include "fmath.h"
+
+void imlib_tracker_init(imlib_tracker_t *tracker, int interval, float margin, int max_lost) {
+    memset(tracker, 0, sizeof(imlib_tracker_t));
+    tracker->interval = IM_MAX(interval, 1);
+    tracker->margin = IM_MAX(margin, 0.0f);
+    tracker->max_lost = IM_MAX(max_lost, 0);
+    tracker->next_id = 1;
+}
+
+void imlib_tracker_reset(imlib_tracker_t *tracker) {
+    imlib_tracker_init(tracker, tracker->interval, tracker->margin, tracker->max_lost);
+}
+
+// Returns the (unclamped) search window of a track for the current frame.
+static void imlib_tracker_window(imlib_tracker_t *tracker, imlib_track_t *track,
+                                 int *x0, int *y0, int *x1, int *y1) {
+    // The window grows with every frame the track isn't found.
+    int frames = track->lost + 1;
+    int margin = fast_ceilf(IM_MAX(track->rect.w, track->rect.h) * tracker->margin * frames);
+    *x0 = track->rect.x + fast_roundf(track->vx * frames) - margin;
+    *y0 = track->rect.y + fast_roundf(track->vy * frames) - margin;
+    *x1 = *x0 + track->rect.w + (margin * 2);
+    *y1 = *y0 + track->rect.h + (margin * 2);
+}
+
+size_t imlib_tracker_windows(imlib_tracker_t *tracker, rectangle_t *roi, rectangle_t *windows) {
+    tracker->full_scan = (tracker->n_tracks == 0) || tracker->rescan || (tracker->frames >= tracker->interval);
+
+    if (tracker->full_scan) {
+        tracker->frames = 0;
+        tracker->rescan = false;
+        windows[0] = *roi;
+        return 1;
+    }
+
+    size_t n = 0;
+    for (size_t i = 0; i < tracker->n_tracks; i++) {
+        int x0, y0, x1, y1;
+        imlib_tracker_window(tracker, &tracker->tracks[i], &x0, &y0, &x1, &y1);
+        x0 = IM_MAX(x0, roi->x);
+        y0 = IM_MAX(y0, roi->y);
+        x1 = IM_MIN(x1, roi->x + roi->w);
+        y1 = IM_MIN(y1, roi->y + roi->h);
+        if ((x0 < x1) && (y0 < y1)) {
+            rectangle_init(&windows[n++], x0, y0, x1 - x0, y1 - y0);
+        }
+    }
+
+    // Merge overlapping windows so that no area is searched twice. A grown window may
+    // overlap windows that were already checked, so repeat until nothing is merged.
+    for (bool merged = true; merged;) {
+        merged = false;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                if (rectangle_overlap(&windows[i], &windows[j])) {
+                    rectangle_united(&windows[i], &windows[j]);
+                    // Check the window moved into this slot next.
+                    windows[j--] = windows[--n];
+                    merged = true;
+                }
+            }
+        }
+    }
+
+    return n;
+}
+
+void imlib_tracker_update(imlib_tracker_t *tracker, size_t n, imlib_tracker_det_t *dets, uint32_t *ids) {
+    bool matched[IMLIB_TRACKER_MAX_TRACKS] = { false };
+
+    // Match each detection with the nearest track of the same key whose window contains it.
+    for (size_t i = 0; i < n; i++) {
+        int cx = dets[i].rect.x + (dets[i].rect.w / 2);
+        int cy = dets[i].rect.y + (dets[i].rect.h / 2);
+        imlib_track_t *best = NULL;
+        int best_dist = INT32_MAX;
+
+        for (size_t j = 0; j < tracker->n_tracks; j++) {
+            imlib_track_t *track = &tracker->tracks[j];
+            if (matched[j] || (track->key != dets[i].key)) {
+                continue;
+            }
+
+            int x0, y0, x1, y1;
+            imlib_tracker_window(tracker, track, &x0, &y0, &x1, &y1);
+            if ((cx < x0) || (cx >= x1) || (cy < y0) || (cy >= y1)) {
+                continue;
+            }
+
+            int dx = cx - ((x0 + x1) / 2);
+            int dy = cy - ((y0 + y1) / 2);
+            int dist = (dx * dx) + (dy * dy);
+            if (dist < best_dist) {
+                best = track;
+                best_dist = dist;
+            }
+        }
+
+        if (best) {
+            int frames = best->lost + 1;
+            float vx = (cx - (best->rect.x + (best->rect.w / 2))) / (float) frames;
+            float vy = (cy - (best->rect.y + (best->rect.h / 2))) / (float) frames;
+            // Smooth the velocity to reject detection jitter.
+            best->vx = (best->vx + vx) * 0.5f;
+            best->vy = (best->vy + vy) * 0.5f;
+            best->rect = dets[i].rect;
+            best->lost = 0;
+            matched[best - tracker->tracks] = true;
+            ids[i] = best->id;
+            continue;
+        }
+
+        // Start a new track, replacing the track that's been lost the longest if full.
+        size_t slot = tracker->n_tracks;
+        if (slot == IMLIB_TRACKER_MAX_TRACKS) {
+            for (size_t j = 0; j < tracker->n_tracks; j++) {
+                if (!matched[j] && ((slot == IMLIB_TRACKER_MAX_TRACKS) ||
+                                    (tracker->tracks[j].lost > tracker->tracks[slot].lost))) {
+                    slot = j;
+                }
+            }
+
+            if ((slot == IMLIB_TRACKER_MAX_TRACKS) || (tracker->tracks[slot].lost == 0)) {
+                ids[i] = 0;
+                continue;
+            }
+        } else {
+            tracker->n_tracks += 1;
+        }
+
+        imlib_track_t *track = &tracker->tracks[slot];
+        track->id = tracker->next_id++;
+        track->key = dets[i].key;
+        track->rect = dets[i].rect;
+        track->vx = 0.0f;
+        track->vy = 0.0f;
+        track->lost = 0;
+        matched[slot] = true;
+        ids[i] = track->id;
+    }
+
+    // Age unmatched tracks and drop the ones lost for too long.
+    for (size_t j = 0; j < tracker->n_tracks;) {
+        if (matched[j]) {
+            j++;
+            continue;
+        }
+
+        // Search the full ROI next if a track left its window.
+        if (!tracker->full_scan) {
+            tracker->rescan = true;
+        }
+
+        if (++tracker->tracks[j].lost > tracker->max_lost) {
+            tracker->n_tracks -= 1;
+            tracker->tracks[j] = tracker->tracks[tracker->n_tracks];
+            matched[j] = matched[tracker->n_tracks];
+        } else {
+            j++;
+        }
+    }
+
+    tracker->frames += 1;
+}
@@ -44,6 +44,7 @@
 #include "py/gc.h"
 #include "py_ml.h"
 #include "umalloc.h"
+#include "trace.h"
 
 #include "ll_aton_runtime.h"
 #include "ll_aton_platform.h"
@@ -250,6 +251,7 @@ int ml_backend_run_inference(py_ml_model_obj_t *model) {
     ml_backend_state_t *state = (ml_backend_state_t *) model->state;
 
     uma_transient_acquire();
+    OMV_TRACE_BEGIN("inference");
 
     // Flush input buffers.
     for (size_t i = 0; i < model->inputs_size; i++) {
@@ -284,6 +286,7 @@ int ml_backend_run_inference(py_ml_model_obj_t *model) {
 
     LL_ATON_RT_DeInit_Network(&state->nn_inst);
     LL_ATON_RT_RuntimeDeInit();
+    OMV_TRACE_END("inference");
     uma_transient_release();
 
     if (exc != MP_OBJ_NULL) {
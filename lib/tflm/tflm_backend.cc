@@ -62,6 +62,7 @@ extern "C" {
 #include "py/gc.h"
 #include "py_ml.h"
 #include "common/omv_profiler.h"
+#include "common/trace.h"
 
 using namespace tflite;
 #define TF_ARENA_EXTRA      (512)
@@ -335,7 +336,11 @@ int ml_backend_run_inference(py_ml_model_obj_t *model) {
     RegisterDebugLogCallback(ml_backend_log_handler);
     ml_backend_state_t *state = (ml_backend_state_t *) model->state;
 
-    if (state->interpreter->Invoke() != kTfLiteOk) {
+    OMV_TRACE_BEGIN("inference");
+    TfLiteStatus status = state->interpreter->Invoke();
+    OMV_TRACE_END("inference");
+
+    if (status != kTfLiteOk) {
         mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invoke failed"));
     }
 
@@ -51,6 +51,7 @@
 #include "omv_i2c.h"
 #include "py_helper.h"
 #include "framebuffer.h"
+#include "umalloc.h"
 #if MICROPY_PY_ULAB
 #include "ndarray.h"
 #endif
@@ -214,6 +215,9 @@ static mp_obj_t py_csi_snapshot(size_t n_args, const mp_obj_t *pos_args, mp_map_
         flags |= OMV_CSI_FLAG_NON_BLOCK;
     }
 
+    // Each snapshot starts a new frame for the scratch allocator.
+    uma_frame_begin();
+
     if (time == -1 && frames == -1) {
         int error = omv_csi_snapshot(self->csi, &image, flags);
         if (error != 0) {
@@ -223,22 +227,6 @@ static mp_obj_t py_csi_snapshot(size_t n_args, const mp_obj_t *pos_args, mp_map_
             }
             omv_csi_raise_error(error);
         }
-
-        // If an image is provided update it and return.
-        if (args[ARG_image].u_obj != mp_const_none) {
-            image_t *other = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_MUTABLE);
-            imlib_draw_image(other, &image, 0, 0, 1.f, 1.f, NULL, -1, 255, NULL, NULL,
-                             IMAGE_HINT_SCALE_ASPECT_IGNORE, NULL, NULL, NULL, NULL);
-            return mp_const_none;
-        }
-
-        #if MICROPY_PY_IMU
-        // +-10 degree dead-zone around pitch 90/270.
-        // +-35 degree active-zone around roll 0/90/180/270/360.
-        omv_csi_set_rotation(self->csi, 10, 35);
-        #endif // MICROPY_PY_IMU
-
-        return py_image_from_struct(&image);
     } else {
         uint32_t millis = mp_hal_ticks_ms();
 
@@ -257,8 +245,34 @@ static mp_obj_t py_csi_snapshot(size_t n_args, const mp_obj_t *pos_args, mp_map_
             }
         }
 
+        // No frame was captured.
+        if (!image.data) {
+            return mp_const_none;
+        }
+    }
+
+    // If an image is provided update it and return.
+    if (args[ARG_image].u_obj != mp_const_none) {
+        image_t *other = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_MUTABLE);
+        imlib_draw_image(other, &image, 0, 0, 1.f, 1.f, NULL, -1, 255, NULL, NULL,
+                         IMAGE_HINT_SCALE_ASPECT_IGNORE, NULL, NULL, NULL, NULL);
         return mp_const_none;
     }
+
+    #if MICROPY_PY_IMU
+    // +-10 degree dead-zone around pitch 90/270.
+    // +-35 degree active-zone around roll 0/90/180/270/360.
+    omv_csi_set_rotation(self->csi, 10, 35);
+    #endif // MICROPY_PY_IMU
+
+    // Attach the capture metadata of the returned frame, this is the last frame when
+    // capturing for a time or a number of frames.
+    vbuffer_t *buffer = framebuffer_acquire(self->csi->fb, FB_FLAG_USED | FB_FLAG_PEEK);
+    if (buffer) {
+        return py_image_from_frame(&image, &buffer->meta);
+    }
+
+    return py_image_from_struct(&image);
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_csi_snapshot_obj, 1, py_csi_snapshot);
 
@@ -790,6 +804,57 @@ static mp_obj_t py_csi_framebuffers(size_t n_args, const mp_obj_t *args) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_csi_framebuffers_obj, 1, 2, py_csi_framebuffers);
 
+static mp_obj_t py_csi_frame_stats(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_reset };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_reset, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+    };
+
+    py_csi_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    framebuffer_stats_t *stats = &self->csi->fb->stats;
+    mp_obj_t depth[FRAMEBUFFER_DEPTH_BINS];
+
+    for (size_t i = 0; i < FRAMEBUFFER_DEPTH_BINS; i++) {
+        depth[i] = mp_obj_new_int_from_uint(stats->depth[i]);
+    }
+
+    mp_obj_t tuple[5] = {
+        mp_obj_new_int_from_uint(stats->captured),
+        mp_obj_new_int_from_uint(stats->dropped),
+        mp_obj_new_int_from_uint(stats->flushed),
+        mp_obj_new_int_from_uint(stats->overflowed),
+        mp_obj_new_tuple(FRAMEBUFFER_DEPTH_BINS, depth),
+    };
+
+    if (args[ARG_reset].u_bool) {
+        framebuffer_reset_stats(self->csi->fb);
+    }
+
+    return mp_obj_new_tuple(5, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_csi_frame_stats_obj, 1, py_csi_frame_stats);
+
+static mp_obj_t py_csi_preview_budget(size_t n_args, const mp_obj_t *args) {
+    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
+
+    if (n_args == 1) {
+        return mp_obj_new_int_from_uint(fb->budget);
+    }
+
+    mp_int_t budget = mp_obj_get_int(args[1]);
+
+    if (budget < 0) {
+        omv_csi_raise_error(OMV_CSI_ERROR_INVALID_ARGUMENT);
+    }
+
+    framebuffer_set_preview_budget(fb, budget);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_csi_preview_budget_obj, 1, 2, py_csi_preview_budget);
+
 static mp_obj_t py_csi_special_effect(mp_obj_t self_in, mp_obj_t sde) {
     py_csi_obj_t *self = MP_OBJ_TO_PTR(self_in);
 
@@ -1264,7 +1329,65 @@ static mp_obj_t py_csi_ioctl(size_t n_args, const mp_obj_t *args) {
             }
             break;
         }
+        case OMV_CSI_IOCTL_GENX320_ACCUMULATE: {
+            int mode = (n_args >= 2) ? mp_obj_get_int(args[0]) : -1;
+
+            if ((mode == OMV_CSI_GENX320_ACC_HISTOGRAM && (n_args == 3 || n_args == 4)) ||
+                (mode == OMV_CSI_GENX320_ACC_TIME_SURFACE && n_args == 3)) {
+                image_t *img = py_helper_arg_to_image(args[1], ARG_IMAGE_MUTABLE | ARG_IMAGE_GRAYSCALE);
+
+                // The histogram accumulates unless a brightness to clear to is passed.
+                if (n_args == 4) {
+                    memset(img->data, mp_obj_get_int(args[3]), image_size(img));
+                }
+
+                error = omv_csi_ioctl(self->csi, request, mode, img->data, img->w, img->h, mp_obj_get_int(args[2]));
+            #if MICROPY_PY_ULAB
+            } else if (mode == OMV_CSI_GENX320_ACC_VOXEL_GRID && n_args == 2) {
+                if (!MP_OBJ_IS_TYPE(args[1], &ulab_ndarray_type)) {
+                    mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Expected a ndarray"));
+                }
+
+                ndarray_obj_t *array = MP_OBJ_TO_PTR(args[1]);
+
+                if (array->dtype != NDARRAY_INT16) {
+                    mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected a ndarray with dtype int16"));
+                }
+
+                if (!(ndarray_is_dense(array) && (array->ndim == 2 || array->ndim == 3))) {
+                    mp_raise_msg(&mp_type_ValueError,
+                                 MP_ERROR_TEXT("Expected a dense ndarray with shape (h, w) or (bins, h, w)"));
+                }
+
+                // A 2D grid is a single bin polarity histogram.
+                int bins = (array->ndim == 3) ? array->shape[ULAB_MAX_DIMS - 3] : 1;
+                error = omv_csi_ioctl(self->csi, request, mode, array->array,
+                                      array->shape[ULAB_MAX_DIMS - 1],
+                                      array->shape[ULAB_MAX_DIMS - 2], bins);
+            #endif // MICROPY_PY_ULAB
+            }
+
+            if (error >= 0) {
+                ret_obj = mp_obj_new_int(error);
+            }
+            break;
+        }
         #endif // (OMV_GENX320_ENABLE == 1)
+
+        #if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+        case OMV_CSI_IOCTL_SOFTCSI_REPLAY: {
+            // ioctl(IOCTL_SOFTCSI_REPLAY, path[, fps]) replays frames from a file or directory at
+            // fps frames per second (0 = on demand), or switches back to the test pattern if the
+            // path is None. The fps is positional, ioctl() doesn't take keyword arguments.
+            if (n_args < 1 || n_args > 2) {
+                mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Expected a path and an optional fps"));
+            }
+            const char *path = (args[0] == mp_const_none) ? NULL : mp_obj_str_get_str(args[0]);
+            int fps = (n_args == 2) ? mp_obj_get_int(args[1]) : 0;
+            error = omv_csi_ioctl(self->csi, request, path, fps);
+            break;
+        }
+        #endif // (OMV_SOFTCSI_REPLAY_ENABLE == 1)
         default: {
             omv_csi_raise_error(OMV_CSI_ERROR_CTL_UNSUPPORTED);
             break;
@@ -1277,7 +1400,7 @@ static mp_obj_t py_csi_ioctl(size_t n_args, const mp_obj_t *args) {
 
     return ret_obj;
 }
-static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_csi_ioctl_obj, 2, 5, py_csi_ioctl);
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_csi_ioctl_obj, 2, 6, py_csi_ioctl);
 
 static mp_obj_t py_csi_color_palette(size_t n_args, const mp_obj_t *args) {
     py_csi_obj_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -1461,6 +1584,8 @@ static const mp_rom_map_elem_t py_csi_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_transpose),           MP_ROM_PTR(&py_csi_transpose_obj) },
     { MP_ROM_QSTR(MP_QSTR_auto_rotation),       MP_ROM_PTR(&py_csi_auto_rotation_obj) },
     { MP_ROM_QSTR(MP_QSTR_framebuffers),        MP_ROM_PTR(&py_csi_framebuffers_obj) },
+    { MP_ROM_QSTR(MP_QSTR_frame_stats),         MP_ROM_PTR(&py_csi_frame_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_preview_budget),      MP_ROM_PTR(&py_csi_preview_budget_obj) },
     { MP_ROM_QSTR(MP_QSTR_lens_correction),     MP_ROM_PTR(&py_csi_lens_correction_obj) },
     { MP_ROM_QSTR(MP_QSTR_special_effect),      MP_ROM_PTR(&py_csi_special_effect_obj) },
     { MP_ROM_QSTR(MP_QSTR_vsync_callback),      MP_ROM_PTR(&py_csi_vsync_callback_obj) },
@@ -1615,6 +1740,10 @@ static const mp_rom_map_elem_t globals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_IOCTL_GENX320_READ_EVENTS),    MP_ROM_INT(OMV_CSI_IOCTL_GENX320_READ_EVENTS)},
     { MP_ROM_QSTR(MP_QSTR_IOCTL_GENX320_CALIBRATE),      MP_ROM_INT(OMV_CSI_IOCTL_GENX320_CALIBRATE)},
     { MP_ROM_QSTR(MP_QSTR_IOCTL_GENX320_READ_EVENTS_RAW), MP_ROM_INT(OMV_CSI_IOCTL_GENX320_READ_EVENTS_RAW)},
+    { MP_ROM_QSTR(MP_QSTR_IOCTL_GENX320_ACCUMULATE),     MP_ROM_INT(OMV_CSI_IOCTL_GENX320_ACCUMULATE)},
+    { MP_ROM_QSTR(MP_QSTR_GENX320_ACC_HISTOGRAM),        MP_ROM_INT(OMV_CSI_GENX320_ACC_HISTOGRAM)},
+    { MP_ROM_QSTR(MP_QSTR_GENX320_ACC_TIME_SURFACE),     MP_ROM_INT(OMV_CSI_GENX320_ACC_TIME_SURFACE)},
+    { MP_ROM_QSTR(MP_QSTR_GENX320_ACC_VOXEL_GRID),       MP_ROM_INT(OMV_CSI_GENX320_ACC_VOXEL_GRID)},
     { MP_ROM_QSTR(MP_QSTR_PIX_OFF_EVENT),                MP_ROM_INT(EC_PIX_OFF_EVENT)},
     { MP_ROM_QSTR(MP_QSTR_PIX_ON_EVENT),                 MP_ROM_INT(EC_PIX_ON_EVENT)},
     { MP_ROM_QSTR(MP_QSTR_RST_TRIGGER_RISING),           MP_ROM_INT(EC_RST_TRIGGER_RISING)},
@@ -1622,6 +1751,9 @@ static const mp_rom_map_elem_t globals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_EXT_TRIGGER_RISING),           MP_ROM_INT(EC_EXT_TRIGGER_RISING)},
     { MP_ROM_QSTR(MP_QSTR_EXT_TRIGGER_FALLING),          MP_ROM_INT(EC_EXT_TRIGGER_FALLING)},
     #endif
+    #if (OMV_SOFTCSI_REPLAY_ENABLE == 1)
+    { MP_ROM_QSTR(MP_QSTR_IOCTL_SOFTCSI_REPLAY),         MP_ROM_INT(OMV_CSI_IOCTL_SOFTCSI_REPLAY)},
+    #endif
 };
 static MP_DEFINE_CONST_DICT(globals_dict, globals_dict_table);
 
@@ -45,6 +45,8 @@ typedef struct py_gif_obj {
     uint32_t height;
     bool color;
     bool loop;
+    uint8_t *prev;
+    gif_stats_t stats;
     file_t fp;
 } py_gif_obj_t;
 
@@ -83,6 +85,24 @@ static mp_obj_t py_gif_loop(mp_obj_t self_in) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(py_gif_loop_obj, py_gif_loop);
 
+static mp_obj_t py_gif_count(mp_obj_t self_in) {
+    py_gif_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_int(self->stats.frames);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_gif_count_obj, py_gif_count);
+
+static mp_obj_t py_gif_stats(mp_obj_t self_in) {
+    py_gif_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t tuple[4] = {
+        mp_obj_new_int(self->stats.frames),
+        mp_obj_new_int(self->stats.pixels),
+        mp_obj_new_int(self->stats.encoded_pixels),
+        mp_obj_new_int(self->stats.bytes),
+    };
+    return mp_obj_new_tuple(4, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_gif_stats_obj, py_gif_stats);
+
 static mp_obj_t py_gif_add_frame(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     enum { ARG_delay };
     static const mp_arg_t allowed_args[] = {
@@ -103,25 +123,31 @@ static mp_obj_t py_gif_add_frame(size_t n_args, const mp_obj_t *pos_args, mp_map
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Image format is not supported"));
     }
 
-    gif_add_frame(&self->fp, image, args[ARG_delay].u_int);
+    gif_add_frame(&self->fp, image, args[ARG_delay].u_int, self->prev, &self->stats);
     return mp_const_none;
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_gif_add_frame_obj, 2, py_gif_add_frame);
 
 static mp_obj_t py_gif_close(mp_obj_t self_in) {
     py_gif_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    // Freed first, writing the trailer can raise.
+    if (self->prev) {
+        uma_free(self->prev);
+        self->prev = NULL;
+    }
     gif_close(&self->fp);
     return mp_const_none;
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(py_gif_close_obj, py_gif_close);
 
 static mp_obj_t py_gif_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_width, ARG_height, ARG_color, ARG_loop };
+    enum { ARG_width, ARG_height, ARG_color, ARG_loop, ARG_delta };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_width, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = -1 } },
         { MP_QSTR_height, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = -1 } },
         { MP_QSTR_color, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = -1 } },
         { MP_QSTR_loop, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_bool = true } },
+        { MP_QSTR_delta, MP_ARG_BOOL | MP_ARG_KW_ONLY,  {.u_bool = false } },
     };
 
     // Parse args.
@@ -136,9 +162,17 @@ static mp_obj_t py_gif_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *k
     gif->height = (args[ARG_height].u_int == -1) ? fb->h : args[ARG_height].u_int;
     gif->color = (args[ARG_color].u_int == -1) ? (fb->bpp >= 2) : args[ARG_color].u_bool;
     gif->loop = args[ARG_loop].u_bool;
+    gif->prev = NULL;
+    memset(&gif->stats, 0, sizeof(gif->stats));
 
     file_open(&gif->fp, path, FA_WRITE | FA_CREATE_ALWAYS);
     gif_open(&gif->fp, gif->width, gif->height, gif->color, gif->loop);
+
+    // Allocated last, so it's not leaked if the file can't be opened or written.
+    if (args[ARG_delta].u_bool) {
+        // Holds the last frame to find the pixels that changed.
+        gif->prev = uma_malloc(gif->width * gif->height, UMA_PERSIST | UMA_CACHE);
+    }
     return gif;
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_gif_open_obj, 1, py_gif_open);
@@ -152,6 +186,8 @@ static const mp_rom_map_elem_t py_gif_locals_dict_table[] = {
     { MP_OBJ_NEW_QSTR(MP_QSTR_format),      MP_ROM_PTR(&py_gif_format_obj)    },
     { MP_OBJ_NEW_QSTR(MP_QSTR_size),        MP_ROM_PTR(&py_gif_size_obj)      },
     { MP_OBJ_NEW_QSTR(MP_QSTR_loop),        MP_ROM_PTR(&py_gif_loop_obj)      },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_count),       MP_ROM_PTR(&py_gif_count_obj)     },
+    { MP_OBJ_NEW_QSTR(MP_QSTR_stats),       MP_ROM_PTR(&py_gif_stats_obj)     },
     { MP_OBJ_NEW_QSTR(MP_QSTR_add_frame),   MP_ROM_PTR(&py_gif_add_frame_obj) },
     { MP_OBJ_NEW_QSTR(MP_QSTR_close),       MP_ROM_PTR(&py_gif_close_obj)     },
     { NULL, NULL },
@@ -49,6 +49,7 @@ void py_helper_arg_to_float_array(const mp_obj_t arg, float *array, size_t size)
 int py_helper_arg_to_color(image_t *img, mp_obj_t obj, int default_val);
 void py_helper_arg_to_thresholds(const mp_obj_t arg, list_t *thresholds);
 int py_helper_arg_to_ksize(const mp_obj_t arg);
+bool py_helper_arg_to_ccm(const mp_obj_t arg, float *ccm);
 bool py_helper_is_equal_to_framebuffer(image_t *img);
 void py_helper_update_framebuffer(image_t *img);
 void py_helper_set_to_framebuffer(image_t *img);
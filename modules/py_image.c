@@ -47,9 +47,14 @@
 #include "py_image_descriptor.h"
 #include "py_image_stats.h"
 #include "board_config.h"
+#include "py_image_pipeline.h"
+#include "py_image_tracker.h"
 #if defined(IMLIB_ENABLE_IMAGE_IO)
 #include "py_imageio.h"
 #endif
+#ifdef IMLIB_ENABLE_APRILTAGS
+#include "py_image_apriltag.h"
+#endif
 #include "ulab/code/ndarray.h"
 #include "simd.h"
 
@@ -60,6 +65,7 @@ const mp_obj_type_t py_image_type;
 typedef struct _py_image_obj_t {
     mp_obj_base_t base;
     image_t _cobj;
+    vbuffer_meta_t meta;    // Capture metadata, the sequence is 0 if not captured.
 } py_image_obj_t;
 
 typedef struct _mp_obj_py_image_it_t {
@@ -453,6 +459,42 @@ static mp_obj_t py_image_height(mp_obj_t img_obj) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_1(py_image_height_obj, py_image_height);
 
+static mp_obj_t py_image_seq(mp_obj_t img_obj) {
+    PY_ASSERT_TYPE(img_obj, &py_image_type);
+    py_image_obj_t *self = MP_OBJ_TO_PTR(img_obj);
+    return self->meta.seq ? mp_obj_new_int_from_uint(self->meta.seq) : mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_image_seq_obj, py_image_seq);
+
+// Returns the capture start time, compatible with time.ticks_us() and time.ticks_diff().
+static mp_obj_t py_image_timestamp(mp_obj_t img_obj) {
+    PY_ASSERT_TYPE(img_obj, &py_image_type);
+    py_image_obj_t *self = MP_OBJ_TO_PTR(img_obj);
+    if (!self->meta.seq) {
+        return mp_const_none;
+    }
+    return mp_obj_new_int_from_uint(self->meta.start_us & (MICROPY_PY_TIME_TICKS_PERIOD - 1));
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_image_timestamp_obj, py_image_timestamp);
+
+static mp_obj_t py_image_metadata(mp_obj_t img_obj) {
+    PY_ASSERT_TYPE(img_obj, &py_image_type);
+    py_image_obj_t *self = MP_OBJ_TO_PTR(img_obj);
+    vbuffer_meta_t *meta = &self->meta;
+    if (!meta->seq) {
+        return mp_const_none;
+    }
+    return mp_obj_new_tuple(6, (mp_obj_t []) {
+        mp_obj_new_int_from_uint(meta->seq),
+        mp_obj_new_int_from_uint(meta->start_us & (MICROPY_PY_TIME_TICKS_PERIOD - 1)),
+        mp_obj_new_int_from_uint(meta->end_us & (MICROPY_PY_TIME_TICKS_PERIOD - 1)),
+        (meta->exposure_us < 0) ? mp_const_none : mp_obj_new_int(meta->exposure_us),
+        isnan(meta->gain_db) ? mp_const_none : mp_obj_new_float(meta->gain_db),
+        mp_obj_new_int_from_uint(meta->dropped)
+    });
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_image_metadata_obj, py_image_metadata);
+
 static mp_obj_t py_image_format(mp_obj_t img_obj) {
     image_t *image = py_image_cobj(img_obj);
     switch (image->pixfmt) {
@@ -838,7 +880,7 @@ static mp_obj_t py_image_to(pixformat_t pixfmt, mp_rom_obj_t default_color_palet
     }
 
     if (args[ARG_quality].u_int < 1 || args[ARG_quality].u_int > 100) {
-        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Quality ranges between 0 and 100"));
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Quality ranges between 1 and 100"));
     }
 
     float x_scale = 1.0f;
@@ -1827,48 +1869,8 @@ static MP_DEFINE_CONST_FUN_OBJ_KW(py_awb_obj, 1, py_awb);
 static mp_obj_t py_ccm(mp_obj_t img_obj, mp_obj_t ccm_obj) {
     image_t *image = py_helper_arg_to_image(img_obj, ARG_IMAGE_MUTABLE);
 
-    float ccm[12] = {};
-    bool offset = false;
-
-    size_t len;
-    mp_obj_t *items;
-    mp_obj_get_array(ccm_obj, &len, &items);
-
-    // Form [[rr, rg, rb], [gr, gg, gb], [br, bg, bb]]
-    // Form [[rr, rg, rb], [gr, gg, gb], [br, bg, bb], [xx, xx, xx]]
-    // Form [[rr, rg, rb, ro], [gr, gg, gb, go], [br, bg, bb, bo]]
-    // Form [[rr, rg, rb, ro], [gr, gg, gb, go], [br, bg, bb, bo], [xx, xx, xx, xx]]
-    if ((len == 3) || (len == 4)) {
-        for (size_t i = 0; i < 3; i++) {
-            size_t row_len;
-            mp_obj_t *row_items;
-            mp_obj_get_array(items[i], &row_len, &row_items);
-            offset = offset || (row_len == 4);
-            if ((row_len == 3) || (row_len == 4)) {
-                for (size_t j = 0; j < row_len; j++) {
-                    ccm[(i * 4) + j] = mp_obj_get_float_to_f(row_items[j]);
-                }
-            } else {
-                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected matrix dimensions!"));
-            }
-        }
-        // Form [rr, rg, rb, gr, gg, gb, br, bg, bb]
-    } else if (len == 9) {
-        for (size_t i = 0; i < 3; i++) {
-            for (size_t j = 0; j < 3; j++) {
-                ccm[(i * 4) + j] = mp_obj_get_float_to_f(items[(i * 3) + j]);
-            }
-        }
-        // Form [rr, rg, rb, ro, gr, gg, gb, go, br, bg, bb, bo]
-        // Form [rr, rg, rb, ro, gr, gg, gb, go, br, bg, bb, bo, xx, xx, xx, xx]
-    } else if (len == 12 || len == 16) {
-        offset = true;
-        for (size_t i = 0; i < 12; i++) {
-            ccm[i] = mp_obj_get_float_to_f(items[i]);
-        }
-    } else {
-        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected matrix dimensions!"));
-    }
+    float ccm[12];
+    bool offset = py_helper_arg_to_ccm(ccm_obj, ccm);
 
     imlib_ccm(image, ccm, offset);
     return img_obj;
@@ -2127,7 +2129,7 @@ static mp_obj_t py_image_histeq(size_t n_args, const mp_obj_t *pos_args, mp_map_
     if (args[ARG_adaptive].u_bool) {
         imlib_clahe_histeq(image, clip_limit, mask);
     } else {
-        imlib_histeq(image, mask);
+        UMA_SCRATCH_CALL(imlib_histeq(image, mask));
     }
     return pos_args[0];
 }
@@ -2153,7 +2155,7 @@ static mp_obj_t py_image_mean(size_t n_args, const mp_obj_t *pos_args, mp_map_t
         mask = py_helper_arg_to_image(args[ARG_mask].u_obj, ARG_IMAGE_MUTABLE | ARG_IMAGE_ALLOC);
     }
 
-    imlib_mean_filter(image, ksize, args[ARG_threshold].u_bool, args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_mean_filter(image, ksize, args[ARG_threshold].u_bool, args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_mean_obj, 2, py_image_mean);
@@ -2182,8 +2184,8 @@ static mp_obj_t py_image_median(size_t n_args, const mp_obj_t *pos_args, mp_map_
         mask = py_helper_arg_to_image(args[ARG_mask].u_obj, ARG_IMAGE_MUTABLE | ARG_IMAGE_ALLOC);
     }
 
-    imlib_median_filter(image, ksize, percentile, args[ARG_threshold].u_bool, args[ARG_offset].u_int,
-                        args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_median_filter(image, ksize, percentile, args[ARG_threshold].u_bool, args[ARG_offset].u_int,
+                                         args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_median_obj, 2, py_image_median);
@@ -2209,7 +2211,7 @@ static mp_obj_t py_image_mode(size_t n_args, const mp_obj_t *pos_args, mp_map_t
         mask = py_helper_arg_to_image(args[ARG_mask].u_obj, ARG_IMAGE_MUTABLE | ARG_IMAGE_ALLOC);
     }
 
-    imlib_mode_filter(image, ksize, args[ARG_threshold].u_bool, args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_mode_filter(image, ksize, args[ARG_threshold].u_bool, args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_mode_obj, 2, py_image_mode);
@@ -2238,8 +2240,8 @@ static mp_obj_t py_image_midpoint(size_t n_args, const mp_obj_t *pos_args, mp_ma
         mask = py_helper_arg_to_image(args[ARG_mask].u_obj, ARG_IMAGE_MUTABLE | ARG_IMAGE_ALLOC);
     }
 
-    imlib_midpoint_filter(image, ksize, bias, args[ARG_threshold].u_bool, args[ARG_offset].u_int,
-                          args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_midpoint_filter(image, ksize, bias, args[ARG_threshold].u_bool, args[ARG_offset].u_int,
+                                           args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_midpoint_obj, 2, py_image_midpoint);
@@ -2313,8 +2315,8 @@ static mp_obj_t py_image_morph(size_t n_args, const mp_obj_t *pos_args, mp_map_t
     float mul = py_helper_arg_to_float(args[ARG_mul].u_obj, 1.0f);
     float add = py_helper_arg_to_float(args[ARG_add].u_obj, 0.0f);
 
-    imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
-                args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
+                                 args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_morph_obj, 3, py_image_morph);
@@ -2378,8 +2380,8 @@ static mp_obj_t py_image_gaussian(size_t n_args, const mp_obj_t *pos_args, mp_ma
     float mul = py_helper_arg_to_float(args[ARG_mul].u_obj, 1.0f);
     float add = py_helper_arg_to_float(args[ARG_add].u_obj, 0.0f);
 
-    imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
-                args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
+                                 args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_gaussian_obj, 2, py_image_gaussian);
@@ -2444,8 +2446,8 @@ static mp_obj_t py_image_laplacian(size_t n_args, const mp_obj_t *pos_args, mp_m
     float mul = py_helper_arg_to_float(args[ARG_mul].u_obj, 1.0f);
     float add = py_helper_arg_to_float(args[ARG_add].u_obj, 0.0f);
 
-    imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
-                args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_morph(image, ksize, krn, mul / sum, add, args[ARG_threshold].u_bool,
+                                 args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_laplacian_obj, 2, py_image_laplacian);
@@ -2475,8 +2477,8 @@ static mp_obj_t py_image_bilateral(size_t n_args, const mp_obj_t *pos_args, mp_m
         mask = py_helper_arg_to_image(args[ARG_mask].u_obj, ARG_IMAGE_MUTABLE | ARG_IMAGE_ALLOC);
     }
 
-    imlib_bilateral_filter(image, ksize, color_sigma, space_sigma, args[ARG_threshold].u_bool,
-                           args[ARG_offset].u_int, args[ARG_invert].u_bool, mask);
+    UMA_SCRATCH_CALL(imlib_bilateral_filter(image, ksize, color_sigma, space_sigma, args[ARG_threshold].u_bool,
+                                            args[ARG_offset].u_int, args[ARG_invert].u_bool, mask));
     return pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_bilateral_obj, 2, py_image_bilateral);
@@ -2488,11 +2490,12 @@ static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_bilateral_obj, 2, py_image_bilateral)
 
 #ifdef IMLIB_ENABLE_LINPOLAR
 static mp_obj_t py_image_linpolar(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_x, ARG_y, ARG_reverse };
+    enum { ARG_x, ARG_y, ARG_reverse, ARG_copy };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_x,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_y,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_reverse, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+        { MP_QSTR_copy,    MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
     };
 
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_MUTABLE);
@@ -2504,19 +2507,25 @@ static mp_obj_t py_image_linpolar(size_t n_args, const mp_obj_t *pos_args, mp_ma
     int cx = (args[ARG_x].u_obj == mp_const_none) ? (image->w / 2) : mp_obj_get_int(args[ARG_x].u_obj);
     int cy = (args[ARG_y].u_obj == mp_const_none) ? (image->h / 2) : mp_obj_get_int(args[ARG_y].u_obj);
 
-    imlib_logpolar(image, cx, cy, true, args[ARG_reverse].u_bool);
-    return pos_args[0];
+    image_t out = *image;
+    if (args[ARG_copy].u_bool) {
+        image_alloc(&out, image_size(&out));
+    }
+
+    imlib_logpolar(&out, image, cx, cy, true, args[ARG_reverse].u_bool);
+    return args[ARG_copy].u_bool ? py_image_from_struct(&out) : pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_linpolar_obj, 1, py_image_linpolar);
 #endif // IMLIB_ENABLE_LINPOLAR
 
 #ifdef IMLIB_ENABLE_LOGPOLAR
 static mp_obj_t py_image_logpolar(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_x, ARG_y, ARG_reverse };
+    enum { ARG_x, ARG_y, ARG_reverse, ARG_copy };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_x,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_y,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_reverse, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+        { MP_QSTR_copy,    MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
     };
 
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_MUTABLE);
@@ -2528,20 +2537,26 @@ static mp_obj_t py_image_logpolar(size_t n_args, const mp_obj_t *pos_args, mp_ma
     int cx = (args[ARG_x].u_obj == mp_const_none) ? (image->w / 2) : mp_obj_get_int(args[ARG_x].u_obj);
     int cy = (args[ARG_y].u_obj == mp_const_none) ? (image->h / 2) : mp_obj_get_int(args[ARG_y].u_obj);
 
-    imlib_logpolar(image, cx, cy, false, args[ARG_reverse].u_bool);
-    return pos_args[0];
+    image_t out = *image;
+    if (args[ARG_copy].u_bool) {
+        image_alloc(&out, image_size(&out));
+    }
+
+    imlib_logpolar(&out, image, cx, cy, false, args[ARG_reverse].u_bool);
+    return args[ARG_copy].u_bool ? py_image_from_struct(&out) : pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_logpolar_obj, 1, py_image_logpolar);
 #endif // IMLIB_ENABLE_LOGPOLAR
 
 #ifdef IMLIB_ENABLE_LENS_CORR
 static mp_obj_t py_image_lens_corr(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_strength, ARG_zoom, ARG_x_corr, ARG_y_corr };
+    enum { ARG_strength, ARG_zoom, ARG_x_corr, ARG_y_corr, ARG_copy };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_strength, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_zoom,     MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_x_corr,   MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_y_corr,   MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_copy,     MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
     };
 
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_MUTABLE);
@@ -2557,8 +2572,13 @@ static mp_obj_t py_image_lens_corr(size_t n_args, const mp_obj_t *pos_args, mp_m
     float x_corr = py_helper_arg_to_float(args[ARG_x_corr].u_obj, 0.0f);
     float y_corr = py_helper_arg_to_float(args[ARG_y_corr].u_obj, 0.0f);
 
-    imlib_lens_corr(image, strength, zoom, x_corr, y_corr);
-    return pos_args[0];
+    image_t out = *image;
+    if (args[ARG_copy].u_bool) {
+        image_alloc(&out, image_size(&out));
+    }
+
+    imlib_lens_corr(&out, image, strength, zoom, x_corr, y_corr);
+    return args[ARG_copy].u_bool ? py_image_from_struct(&out) : pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_lens_corr_obj, 1, py_image_lens_corr);
 #endif // IMLIB_ENABLE_LENS_CORR
@@ -2567,7 +2587,7 @@ static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_lens_corr_obj, 1, py_image_lens_corr)
 static mp_obj_t py_image_rotation_corr(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     enum {
         ARG_x_rotation, ARG_y_rotation, ARG_z_rotation, ARG_x_translation, ARG_y_translation,
-        ARG_zoom, ARG_fov, ARG_corners
+        ARG_zoom, ARG_fov, ARG_corners, ARG_copy
     };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_x_rotation,    MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
@@ -2578,6 +2598,7 @@ static mp_obj_t py_image_rotation_corr(size_t n_args, const mp_obj_t *pos_args,
         { MP_QSTR_zoom,          MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_fov,           MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_corners,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_copy,          MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
     };
 
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_MUTABLE);
@@ -2607,9 +2628,14 @@ static mp_obj_t py_image_rotation_corr(size_t n_args, const mp_obj_t *pos_args,
         }
     }
 
-    imlib_rotation_corr(image, x_rotation, y_rotation, z_rotation,
-                        x_translation, y_translation, zoom, fov, corners);
-    return pos_args[0];
+    image_t out = *image;
+    if (args[ARG_copy].u_bool) {
+        image_alloc(&out, image_size(&out));
+    }
+
+    imlib_rotation_corr(&out, image, x_rotation, y_rotation, z_rotation,
+                        x_translation, y_translation, zoom, fov, corners, true);
+    return args[ARG_copy].u_bool ? py_image_from_struct(&out) : pos_args[0];
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_rotation_corr_obj, 1, py_image_rotation_corr);
 #endif // IMLIB_ENABLE_ROTATION_CORR
@@ -2663,10 +2689,10 @@ static mp_obj_t py_image_get_similarity(size_t n_args, const mp_obj_t *pos_args,
     const uint8_t *alpha_palette = py_helper_arg_to_palette(args[ARG_alpha_palette].u_obj, PIXFORMAT_GRAYSCALE);
 
     float avg = 0.0f, std = 0.0f, min = 0.0f, max = 0.0f;
-    imlib_get_similarity(image, other, args[ARG_x].u_int, args[ARG_y].u_int, x_scale, y_scale, &roi,
-                         args[ARG_channel].u_int, args[ARG_alpha].u_int, color_palette, alpha_palette,
-                         args[ARG_hint].u_int | IMAGE_HINT_BLACK_BACKGROUND, args[ARG_dssim].u_bool,
-                         &avg, &std, &min, &max);
+    UMA_SCRATCH_CALL(imlib_get_similarity(image, other, args[ARG_x].u_int, args[ARG_y].u_int, x_scale, y_scale, &roi,
+                                          args[ARG_channel].u_int, args[ARG_alpha].u_int, color_palette, alpha_palette,
+                                          args[ARG_hint].u_int | IMAGE_HINT_BLACK_BACKGROUND, args[ARG_dssim].u_bool,
+                                          &avg, &std, &min, &max));
 
     mp_obj_t items[] = {
         mp_obj_new_float(avg),
@@ -2709,50 +2735,11 @@ static mp_obj_t py_image_get_histogram(size_t n_args, const mp_obj_t *pos_args,
 
     histogram_t hist;
     switch (image->pixfmt) {
-        case PIXFORMAT_BINARY: {
-            int bins = (args[ARG_bins].u_int >= 0) ? args[ARG_bins].u_int : (COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1);
-            PY_ASSERT_TRUE_MSG(bins >= 2, "bins must be >= 2");
-            hist.LBinCount = (args[ARG_l_bins].u_int >= 0) ? args[ARG_l_bins].u_int : bins;
-            PY_ASSERT_TRUE_MSG(hist.LBinCount >= 2, "l_bins must be >= 2");
-            hist.ABinCount = 0;
-            hist.BBinCount = 0;
-            hist.LBins = uma_malloc(hist.LBinCount * sizeof(float), UMA_DTCM);
-            hist.ABins = NULL;
-            hist.BBins = NULL;
-            imlib_get_histogram(&hist, image, &roi, &thresholds, args[ARG_invert].u_bool, other);
-            list_free(&thresholds);
-            break;
-        }
-        case PIXFORMAT_GRAYSCALE: {
-            int bins = (args[ARG_bins].u_int >= 0) ? args[ARG_bins].u_int : (COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1);
-            PY_ASSERT_TRUE_MSG(bins >= 2, "bins must be >= 2");
-            hist.LBinCount = (args[ARG_l_bins].u_int >= 0) ? args[ARG_l_bins].u_int : bins;
-            PY_ASSERT_TRUE_MSG(hist.LBinCount >= 2, "l_bins must be >= 2");
-            hist.ABinCount = 0;
-            hist.BBinCount = 0;
-            hist.LBins = uma_malloc(hist.LBinCount * sizeof(float), UMA_DTCM);
-            hist.ABins = NULL;
-            hist.BBins = NULL;
-            imlib_get_histogram(&hist, image, &roi, &thresholds, args[ARG_invert].u_bool, other);
-            list_free(&thresholds);
-            break;
-        }
+        case PIXFORMAT_BINARY:
+        case PIXFORMAT_GRAYSCALE:
         case PIXFORMAT_RGB565: {
-            int l_bins = (args[ARG_bins].u_int >= 0) ? args[ARG_bins].u_int : (COLOR_L_MAX - COLOR_L_MIN + 1);
-            PY_ASSERT_TRUE_MSG(l_bins >= 2, "bins must be >= 2");
-            hist.LBinCount = (args[ARG_l_bins].u_int >= 0) ? args[ARG_l_bins].u_int : l_bins;
-            PY_ASSERT_TRUE_MSG(hist.LBinCount >= 2, "l_bins must be >= 2");
-            int a_bins = (args[ARG_bins].u_int >= 0) ? args[ARG_bins].u_int : (COLOR_A_MAX - COLOR_A_MIN + 1);
-            PY_ASSERT_TRUE_MSG(a_bins >= 2, "bins must be >= 2");
-            hist.ABinCount = (args[ARG_a_bins].u_int >= 0) ? args[ARG_a_bins].u_int : a_bins;
-            PY_ASSERT_TRUE_MSG(hist.ABinCount >= 2, "a_bins must be >= 2");
-            int b_bins = (args[ARG_bins].u_int >= 0) ? args[ARG_bins].u_int : (COLOR_B_MAX - COLOR_B_MIN + 1);
-            PY_ASSERT_TRUE_MSG(b_bins >= 2, "bins must be >= 2");
-            hist.BBinCount = (args[ARG_b_bins].u_int >= 0) ? args[ARG_b_bins].u_int : b_bins;
-            PY_ASSERT_TRUE_MSG(hist.BBinCount >= 2, "b_bins must be >= 2");
-            hist.LBins = uma_malloc(hist.LBinCount * sizeof(float), UMA_DTCM);
-            hist.ABins = uma_malloc(hist.ABinCount * sizeof(float), UMA_DTCM);
-            hist.BBins = uma_malloc(hist.BBinCount * sizeof(float), UMA_DTCM);
+            py_histogram_alloc_hist(&hist, image->pixfmt, args[ARG_bins].u_int,
+                                    args[ARG_l_bins].u_int, args[ARG_a_bins].u_int, args[ARG_b_bins].u_int);
             imlib_get_histogram(&hist, image, &roi, &thresholds, args[ARG_invert].u_bool, other);
             list_free(&thresholds);
             break;
@@ -2762,33 +2749,7 @@ static mp_obj_t py_image_get_histogram(size_t n_args, const mp_obj_t *pos_args,
         }
     }
 
-    py_histogram_obj_t *o = m_new_obj(py_histogram_obj_t);
-    o->base.type = &py_histogram_type;
-    o->pixfmt = image->pixfmt;
-
-    o->LBins = mp_obj_new_list(hist.LBinCount, NULL);
-    o->ABins = mp_obj_new_list(hist.ABinCount, NULL);
-    o->BBins = mp_obj_new_list(hist.BBinCount, NULL);
-
-    mp_obj_list_t *l_bins = MP_OBJ_TO_PTR(o->LBins);
-    mp_obj_list_t *a_bins = MP_OBJ_TO_PTR(o->ABins);
-    mp_obj_list_t *b_bins = MP_OBJ_TO_PTR(o->BBins);
-
-    for (int i = 0; i < hist.LBinCount; i++) {
-        l_bins->items[i] = mp_obj_new_float(hist.LBins[i]);
-    }
-
-    for (int i = 0; i < hist.ABinCount; i++) {
-        a_bins->items[i] = mp_obj_new_float(hist.ABins[i]);
-    }
-
-    for (int i = 0; i < hist.BBinCount; i++) {
-        b_bins->items[i] = mp_obj_new_float(hist.BBins[i]);
-    }
-
-    py_histogram_free_hist(&hist);
-
-    return o;
+    return py_histogram_from_hist(&hist, image->pixfmt);
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_get_histogram_obj, 1, py_image_get_histogram);
 
@@ -2985,8 +2946,9 @@ static mp_obj_t py_image_get_regression(size_t n_args, const mp_obj_t *pos_args,
     }
 
     find_lines_list_lnk_data_t out;
-    bool result = imlib_get_regression(&out, work_img, &work_roi, x_stride,
-                                       y_stride, &thresholds, invert, area_threshold, pixels_threshold);
+    bool result;
+    UMA_SCRATCH_CALL(result = imlib_get_regression(&out, work_img, &work_roi, x_stride,
+                                                   y_stride, &thresholds, invert, area_threshold, pixels_threshold));
 
     if (do_scale) {
         uma_free(temp_img.data);
@@ -3118,6 +3080,25 @@ static mp_obj_t py_blob_new(find_blobs_list_lnk_data_t *blob) {
     };
     return mp_obj_new_attrtuple(blob_fields, MP_ARRAY_SIZE(blob_fields), items);
 }
+
+// Converts a find_blobs() result into a list of blob objects and empties it.
+mp_obj_t py_blob_list_from_list(list_t *blobs) {
+    mp_obj_list_t *objects_list = mp_obj_new_list(list_size(blobs), NULL);
+    for (size_t i = 0; list_size(blobs); i++) {
+        find_blobs_list_lnk_data_t lnk_data;
+        list_pop_front(blobs, &lnk_data);
+        objects_list->items[i] = py_blob_new(&lnk_data);
+        if (lnk_data.x_hist_bins) {
+            m_free(lnk_data.x_hist_bins);
+        }
+        if (lnk_data.y_hist_bins) {
+            m_free(lnk_data.y_hist_bins);
+        }
+    }
+
+    return objects_list;
+}
+
 static bool py_image_find_blobs_threshold_cb(void *fun_obj, find_blobs_list_lnk_data_t *blob) {
     return mp_obj_is_true(mp_call_function_1(fun_obj, py_blob_new(blob)));
 }
@@ -3179,27 +3160,14 @@ static mp_obj_t py_image_find_blobs(size_t n_args, const mp_obj_t *pos_args, mp_
     unsigned int y_hist_bins_max = args[ARG_y_hist_bins_max].u_int;
 
     list_t out;
-    imlib_find_blobs(&out, image, &roi, x_stride, y_stride, &thresholds,
-                     invert, area_threshold, pixels_threshold, merge, margin,
-                     py_image_find_blobs_threshold_cb, threshold_cb,
-                     py_image_find_blobs_merge_cb, merge_cb,
-                     x_hist_bins_max, y_hist_bins_max);
+    UMA_SCRATCH_CALL(imlib_find_blobs(&out, image, &roi, x_stride, y_stride, &thresholds,
+                                      invert, area_threshold, pixels_threshold, merge, margin,
+                                      py_image_find_blobs_threshold_cb, threshold_cb,
+                                      py_image_find_blobs_merge_cb, merge_cb,
+                                      x_hist_bins_max, y_hist_bins_max));
     list_free(&thresholds);
 
-    mp_obj_list_t *objects_list = mp_obj_new_list(list_size(&out), NULL);
-    for (size_t i = 0; list_size(&out); i++) {
-        find_blobs_list_lnk_data_t lnk_data;
-        list_pop_front(&out, &lnk_data);
-        objects_list->items[i] = py_blob_new(&lnk_data);
-        if (lnk_data.x_hist_bins) {
-            m_free(lnk_data.x_hist_bins);
-        }
-        if (lnk_data.y_hist_bins) {
-            m_free(lnk_data.y_hist_bins);
-        }
-    }
-
-    return objects_list;
+    return py_blob_list_from_list(&out);
 }
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_find_blobs_obj, 2, py_image_find_blobs);
 
@@ -3404,12 +3372,24 @@ static const qstr qrcode_fields[] = {
     MP_QSTR_corners,
     MP_QSTR_is_numeric, MP_QSTR_is_alphanumeric,
     MP_QSTR_is_binary, MP_QSTR_is_kanji, MP_QSTR_rect,
+    MP_QSTR_track_id,
 };
 
+static void py_image_find_qrcodes_window(list_t *out, image_t *image, rectangle_t *roi, void *arg) {
+    imlib_find_qrcodes(out, image, roi);
+}
+
+static uint32_t py_image_qrcode_key(void *lnk_data, rectangle_t *rect) {
+    find_qrcodes_list_lnk_data_t *qrcode = lnk_data;
+    *rect = qrcode->rect;
+    return py_tracker_hash(qrcode->payload, qrcode->payload_len);
+}
+
 static mp_obj_t py_image_find_qrcodes(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_roi };
+    enum { ARG_roi, ARG_tracker };
     static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_roi, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_roi,     MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_tracker, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
     };
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_ANY);
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -3417,7 +3397,13 @@ static mp_obj_t py_image_find_qrcodes(size_t n_args, const mp_obj_t *pos_args, m
     rectangle_t roi = py_helper_arg_to_roi(args[ARG_roi].u_obj, image);
 
     list_t out;
-    imlib_find_qrcodes(&out, image, &roi);
+    uint32_t *track_ids = NULL;
+    if (args[ARG_tracker].u_obj != mp_const_none) {
+        track_ids = py_tracker_find(args[ARG_tracker].u_obj, &out, sizeof(find_qrcodes_list_lnk_data_t), image,
+                                    &roi, py_image_find_qrcodes_window, py_image_qrcode_key, NULL);
+    } else {
+        imlib_find_qrcodes(&out, image, &roi);
+    }
 
     mp_obj_list_t *objects_list = mp_obj_new_list(list_size(&out), NULL);
     for (size_t i = 0; list_size(&out); i++) {
@@ -3453,6 +3439,7 @@ static mp_obj_t py_image_find_qrcodes(size_t n_args, const mp_obj_t *pos_args, m
             mp_obj_new_bool(data_type == 4),
             mp_obj_new_bool(data_type == 8),
             mp_obj_new_tuple(4, (mp_obj_t []) {x, y, w, h}),
+            (track_ids && track_ids[i]) ? mp_obj_new_int(track_ids[i]) : mp_const_none,
         };
         objects_list->items[i] = mp_obj_new_attrtuple(qrcode_fields, MP_ARRAY_SIZE(qrcode_fields), items);
         m_free(lnk_data.payload);
@@ -3475,47 +3462,22 @@ static const qstr apriltag_fields[] = {
     MP_QSTR_x_translation, MP_QSTR_y_translation, MP_QSTR_z_translation,
     MP_QSTR_x_rotation, MP_QSTR_y_rotation, MP_QSTR_z_rotation,
     MP_QSTR_corners, MP_QSTR_area,
-    MP_QSTR_rect,
+    MP_QSTR_rect, MP_QSTR_track_id,
 };
 
-static mp_obj_t py_image_find_apriltags(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_roi, ARG_families, ARG_fx, ARG_fy, ARG_cx, ARG_cy };
-    static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_roi,      MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-        { MP_QSTR_families, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = TAG36H11} },
-        { MP_QSTR_fx,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-        { MP_QSTR_fy,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-        { MP_QSTR_cx,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-        { MP_QSTR_cy,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-    };
-    image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_ANY);
-    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
-    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
-    rectangle_t roi = py_helper_arg_to_roi(args[ARG_roi].u_obj, image);
-#ifndef IMLIB_ENABLE_HIGH_RES_APRILTAGS
-    PY_ASSERT_TRUE_MSG((roi.w * roi.h) < 65536, "The maximum supported resolution for find_apriltags() is < 64K pixels.");
-#endif
-    if ((roi.w < 4) || (roi.h < 4)) {
-        return mp_obj_new_list(0, NULL);
-    }
-
-    apriltag_families_t families = args[ARG_families].u_int;
-    // 2.8mm Focal Length w/ OV7725 sensor for reference.
-    float fx = py_helper_arg_to_float(args[ARG_fx].u_obj, (2.8 / 3.984) * image->w);
-    // 2.8mm Focal Length w/ OV7725 sensor for reference.
-    float fy = py_helper_arg_to_float(args[ARG_fy].u_obj, (2.8 / 2.952) * image->h);
-    // Use the image versus the roi here since the image should be projected from the camera center.
-    float cx = py_helper_arg_to_float(args[ARG_cx].u_obj, image->w * 0.5f);
-    // Use the image versus the roi here since the image should be projected from the camera center.
-    float cy = py_helper_arg_to_float(args[ARG_cy].u_obj, image->h * 0.5f);
-
-    list_t out;
-    imlib_find_apriltags(&out, image, &roi, families, fx, fy, cx, cy);
+uint32_t py_apriltag_track_key(void *lnk_data, rectangle_t *rect) {
+    find_apriltags_list_lnk_data_t *tag = lnk_data;
+    *rect = tag->rect;
+    return (((uint32_t) tag->family) << 16) | tag->id;
+}
 
-    mp_obj_list_t *objects_list = mp_obj_new_list(list_size(&out), NULL);
-    for (size_t i = 0; list_size(&out); i++) {
+// Converts a find_apriltags() result into a list of apriltag objects and empties it.
+// track_ids is either NULL or holds the tracker id of each tag in list order.
+mp_obj_t py_apriltag_list_from_list(list_t *tags, const uint32_t *track_ids) {
+    mp_obj_list_t *objects_list = mp_obj_new_list(list_size(tags), NULL);
+    for (size_t i = 0; list_size(tags); i++) {
         find_apriltags_list_lnk_data_t lnk_data;
-        list_pop_front(&out, &lnk_data);
+        list_pop_front(tags, &lnk_data);
 
         mp_obj_t x = mp_obj_new_int(lnk_data.rect.x);
         mp_obj_t y = mp_obj_new_int(lnk_data.rect.y);
@@ -3603,12 +3565,75 @@ static mp_obj_t py_image_find_apriltags(size_t n_args, const mp_obj_t *pos_args,
             corners,
             mp_obj_new_int(lnk_data.rect.w * lnk_data.rect.h),
             mp_obj_new_tuple(4, (mp_obj_t []) {x, y, w, h}),
+            (track_ids && track_ids[i]) ? mp_obj_new_int(track_ids[i]) : mp_const_none,
         };
         objects_list->items[i] = mp_obj_new_attrtuple(apriltag_fields, MP_ARRAY_SIZE(apriltag_fields), items);
     }
 
     return objects_list;
 }
+
+typedef struct py_image_find_apriltags_args {
+    imlib_apriltag_detector_t detector;
+    rectangle_t roi;
+    float fx, fy, cx, cy;
+} py_image_find_apriltags_args_t;
+
+static void py_image_find_apriltags_window(list_t *out, image_t *image, rectangle_t *roi, void *arg) {
+    py_image_find_apriltags_args_t *a = arg;
+    // Poses are computed relative to the search area, so shift the optical center by the window
+    // offset to return the same pose a full scan of the ROI would.
+    imlib_apriltag_detector_detect(&a->detector, out, image, roi, a->fx, a->fy,
+                                   a->cx - (roi->x - a->roi.x), a->cy - (roi->y - a->roi.y));
+}
+
+static mp_obj_t py_image_find_apriltags(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_roi, ARG_families, ARG_fx, ARG_fy, ARG_cx, ARG_cy, ARG_tracker };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_roi,      MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_families, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = TAG36H11} },
+        { MP_QSTR_fx,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_fy,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_cx,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_cy,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_tracker,  MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+    };
+    image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_ANY);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+    rectangle_t roi = py_helper_arg_to_roi(args[ARG_roi].u_obj, image);
+#ifndef IMLIB_ENABLE_HIGH_RES_APRILTAGS
+    PY_ASSERT_TRUE_MSG((roi.w * roi.h) < 65536, "The maximum supported resolution for find_apriltags() is < 64K pixels.");
+#endif
+    if ((roi.w < 4) || (roi.h < 4)) {
+        return mp_obj_new_list(0, NULL);
+    }
+
+    apriltag_families_t families = args[ARG_families].u_int;
+    // 2.8mm Focal Length w/ OV7725 sensor for reference.
+    float fx = py_helper_arg_to_float(args[ARG_fx].u_obj, (2.8 / 3.984) * image->w);
+    // 2.8mm Focal Length w/ OV7725 sensor for reference.
+    float fy = py_helper_arg_to_float(args[ARG_fy].u_obj, (2.8 / 2.952) * image->h);
+    // Use the image versus the roi here since the image should be projected from the camera center.
+    float cx = py_helper_arg_to_float(args[ARG_cx].u_obj, image->w * 0.5f);
+    // Use the image versus the roi here since the image should be projected from the camera center.
+    float cy = py_helper_arg_to_float(args[ARG_cy].u_obj, image->h * 0.5f);
+
+    list_t out;
+    if (args[ARG_tracker].u_obj != mp_const_none) {
+        // The detector (and its tag family tables) is built once and shared by all windows.
+        py_image_find_apriltags_args_t find_args = { .roi = roi, .fx = fx, .fy = fy, .cx = cx, .cy = cy };
+        imlib_apriltag_detector_init(&find_args.detector, families, 0);
+        uint32_t *track_ids = py_tracker_find(args[ARG_tracker].u_obj, &out, sizeof(find_apriltags_list_lnk_data_t),
+                                              image, &roi, py_image_find_apriltags_window, py_apriltag_track_key,
+                                              &find_args);
+        imlib_apriltag_detector_deinit(&find_args.detector);
+        return py_apriltag_list_from_list(&out, track_ids);
+    }
+
+    imlib_find_apriltags(&out, image, &roi, families, fx, fy, cx, cy);
+    return py_apriltag_list_from_list(&out, NULL);
+}
 static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_find_apriltags_obj, 1, py_image_find_apriltags);
 #endif // IMLIB_ENABLE_APRILTAGS
 
@@ -3618,14 +3643,25 @@ static const qstr datamatrix_fields[] = {
     MP_QSTR_x, MP_QSTR_y, MP_QSTR_w, MP_QSTR_h,
     MP_QSTR_payload, MP_QSTR_rotation,
     MP_QSTR_rows, MP_QSTR_columns, MP_QSTR_capacity, MP_QSTR_padding,
-    MP_QSTR_corners, MP_QSTR_rect,
+    MP_QSTR_corners, MP_QSTR_rect, MP_QSTR_track_id,
 };
 
+static void py_image_find_datamatrices_window(list_t *out, image_t *image, rectangle_t *roi, void *arg) {
+    imlib_find_datamatrices(out, image, roi, *((int *) arg));
+}
+
+static uint32_t py_image_datamatrix_key(void *lnk_data, rectangle_t *rect) {
+    find_datamatrices_list_lnk_data_t *datamatrix = lnk_data;
+    *rect = datamatrix->rect;
+    return py_tracker_hash(datamatrix->payload, datamatrix->payload_len);
+}
+
 static mp_obj_t py_image_find_datamatrices(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
-    enum { ARG_roi, ARG_effort };
+    enum { ARG_roi, ARG_effort, ARG_tracker };
     static const mp_arg_t allowed_args[] = {
-        { MP_QSTR_roi,    MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
-        { MP_QSTR_effort, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 200} },
+        { MP_QSTR_roi,     MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_effort,  MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 200} },
+        { MP_QSTR_tracker, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
     };
     image_t *image = py_helper_arg_to_image(pos_args[0], ARG_IMAGE_ANY);
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -3634,7 +3670,13 @@ static mp_obj_t py_image_find_datamatrices(size_t n_args, const mp_obj_t *pos_ar
     int effort = args[ARG_effort].u_int;
 
     list_t out;
-    imlib_find_datamatrices(&out, image, &roi, effort);
+    uint32_t *track_ids = NULL;
+    if (args[ARG_tracker].u_obj != mp_const_none) {
+        track_ids = py_tracker_find(args[ARG_tracker].u_obj, &out, sizeof(find_datamatrices_list_lnk_data_t), image,
+                                    &roi, py_image_find_datamatrices_window, py_image_datamatrix_key, &effort);
+    } else {
+        imlib_find_datamatrices(&out, image, &roi, effort);
+    }
 
     mp_obj_list_t *objects_list = mp_obj_new_list(list_size(&out), NULL);
     for (size_t i = 0; list_size(&out); i++) {
@@ -3665,6 +3707,7 @@ static mp_obj_t py_image_find_datamatrices(size_t n_args, const mp_obj_t *pos_ar
             mp_obj_new_int(lnk_data.padding),
             corners,
             mp_obj_new_tuple(4, (mp_obj_t []) {x, y, w, h}),
+            (track_ids && track_ids[i]) ? mp_obj_new_int(track_ids[i]) : mp_const_none,
         };
         objects_list->items[i] = mp_obj_new_attrtuple(datamatrix_fields, MP_ARRAY_SIZE(datamatrix_fields), items);
         m_free(lnk_data.payload);
@@ -4082,13 +4125,15 @@ static MP_DEFINE_CONST_FUN_OBJ_KW(py_image_stereo_disparity_obj, 1, py_image_ste
 #endif // IMLIB_ENABLE_STEREO_DISPARITY
 
 mp_obj_t py_image_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
-    enum { ARG_arg, ARG_height, ARG_pixformat, ARG_buffer, ARG_copy_to_fb, ARG_shape, ARG_strides, ARG_scale};
+    enum { ARG_arg, ARG_height, ARG_pixformat, ARG_buffer, ARG_copy_to_fb, ARG_roi, ARG_scale };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_arg,          MP_ARG_REQUIRED | MP_ARG_OBJ },
         { MP_QSTR_height,       MP_ARG_INT, {.u_int = -1} },
         { MP_QSTR_pixformat,    MP_ARG_INT, {.u_int = -1} },
         { MP_QSTR_buffer,       MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
         { MP_QSTR_copy_to_fb,   MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+        { MP_QSTR_roi,          MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_scale,        MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 1} },
     };
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
@@ -4105,13 +4150,47 @@ mp_obj_t py_image_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw
         imlib_read_geometry(&fp, &image, path, &rs);
         file_close(&fp);
 
-        if (args[ARG_copy_to_fb].u_bool) {
-            py_helper_set_to_framebuffer(&image);
+        bool decode = (args[ARG_pixformat].u_int != -1) ||
+                      (args[ARG_roi].u_obj != mp_const_none) ||
+                      (args[ARG_scale].u_int != 1);
+
+        if (decode && (image.pixfmt == PIXFORMAT_JPEG)) {
+            // Decode straight to the requested pixformat, roi and scale.
+            image_t jpeg = image;
+            jpeg.data = uma_malloc(jpeg.size, UMA_CACHE);
+            imlib_load_image(&jpeg, path);
+
+            rectangle_t roi = py_helper_arg_to_roi(args[ARG_roi].u_obj, &jpeg);
+            image.pixfmt = (args[ARG_pixformat].u_int == -1) ? PIXFORMAT_RGB565 : args[ARG_pixformat].u_int;
+            image.size = 0;
+
+            if ((image.pixfmt != PIXFORMAT_BINARY) &&
+                (image.pixfmt != PIXFORMAT_GRAYSCALE) &&
+                (image.pixfmt != PIXFORMAT_RGB565)) {
+                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("JPEGs decode to BINARY, GRAYSCALE or RGB565"));
+            }
+
+            jpeg_decompress_geometry(&image, &jpeg, &roi, args[ARG_scale].u_int);
+
+            if (args[ARG_copy_to_fb].u_bool) {
+                py_helper_set_to_framebuffer(&image);
+            } else {
+                image_alloc(&image, image_size(&image));
+            }
+
+            jpeg_decompress_rect(&image, &jpeg, &roi, args[ARG_scale].u_int, NULL, NULL);
+            uma_free(jpeg.data);
+        } else if (decode) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("pixformat, roi and scale need a JPEG file"));
         } else {
-            image_alloc(&image, image_size(&image));
-        }
+            if (args[ARG_copy_to_fb].u_bool) {
+                py_helper_set_to_framebuffer(&image);
+            } else {
+                image_alloc(&image, image_size(&image));
+            }
 
-        imlib_load_image(&image, path);
+            imlib_load_image(&image, path);
+        }
         #else
         mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Image I/O is not supported"));
         #endif // IMLIB_ENABLE_IMAGE_FILE_IO
@@ -4224,6 +4303,9 @@ static const mp_rom_map_elem_t locals_dict_table[] = {
     {MP_ROM_QSTR(MP_QSTR_height),              MP_ROM_PTR(&py_image_height_obj)},
     {MP_ROM_QSTR(MP_QSTR_format),              MP_ROM_PTR(&py_image_format_obj)},
     {MP_ROM_QSTR(MP_QSTR_size),                MP_ROM_PTR(&py_image_size_obj)},
+    {MP_ROM_QSTR(MP_QSTR_seq),                 MP_ROM_PTR(&py_image_seq_obj)},
+    {MP_ROM_QSTR(MP_QSTR_timestamp),           MP_ROM_PTR(&py_image_timestamp_obj)},
+    {MP_ROM_QSTR(MP_QSTR_metadata),            MP_ROM_PTR(&py_image_metadata_obj)},
     {MP_ROM_QSTR(MP_QSTR_bytearray),           MP_ROM_PTR(&py_image_bytearray_obj)},
     #if defined(MODULE_ULAB_ENABLED) && (ULAB_MAX_DIMS == 4)
     {MP_ROM_QSTR(MP_QSTR_to_ndarray),          MP_ROM_PTR(&py_image_to_ndarray_obj)},
@@ -4784,6 +4866,13 @@ mp_obj_t py_image_from_struct(image_t *img) {
     py_image_obj_t *o = m_new_obj(py_image_obj_t);
     o->base.type = &py_image_type;
     o->_cobj = *img;
+    o->meta = (vbuffer_meta_t) { 0 };
+    return o;
+}
+
+mp_obj_t py_image_from_frame(image_t *img, const vbuffer_meta_t *meta) {
+    py_image_obj_t *o = MP_OBJ_TO_PTR(py_image_from_struct(img));
+    o->meta = *meta;
     return o;
 }
 
@@ -5040,6 +5129,13 @@ static const mp_rom_map_elem_t globals_dict_table[] = {
     #else
     {MP_ROM_QSTR(MP_QSTR_ImageIO),             MP_ROM_PTR(&py_func_unavailable_obj)},
     #endif
+    {MP_ROM_QSTR(MP_QSTR_Pipeline),            MP_ROM_PTR(&py_image_pipeline_type)},
+    {MP_ROM_QSTR(MP_QSTR_Tracker),             MP_ROM_PTR(&py_image_tracker_type)},
+    #ifdef IMLIB_ENABLE_APRILTAGS
+    {MP_ROM_QSTR(MP_QSTR_AprilTagDetector),    MP_ROM_PTR(&py_image_apriltag_detector_type)},
+    #else
+    {MP_ROM_QSTR(MP_QSTR_AprilTagDetector),    MP_ROM_PTR(&py_func_unavailable_obj)},
+    #endif
     {MP_ROM_QSTR(MP_QSTR_binary_to_grayscale), MP_ROM_PTR(&py_image_binary_to_grayscale_obj)},
     {MP_ROM_QSTR(MP_QSTR_binary_to_rgb),       MP_ROM_PTR(&py_image_binary_to_rgb_obj)},
     {MP_ROM_QSTR(MP_QSTR_binary_to_lab),       MP_ROM_PTR(&py_image_binary_to_lab_obj)},
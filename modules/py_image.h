@@ -26,9 +26,14 @@
 #ifndef __PY_IMAGE_H__
 #define __PY_IMAGE_H__
 #include "imlib.h"
+#include "framebuffer.h"
 extern const mp_obj_type_t py_image_type;
 mp_obj_t py_image(int width, int height, pixformat_t pixfmt, uint32_t size, void *pixels);
 mp_obj_t py_image_from_struct(image_t *img);
+mp_obj_t py_image_from_frame(image_t *img, const vbuffer_meta_t *meta);
 void *py_image_cobj(mp_obj_t img_obj);
 int py_image_descriptor_from_roi(image_t *img, const char *path, rectangle_t *roi);
+mp_obj_t py_blob_list_from_list(list_t *blobs);
+mp_obj_t py_apriltag_list_from_list(list_t *tags, const uint32_t *track_ids);
+uint32_t py_apriltag_track_key(void *lnk_data, rectangle_t *rect);
 #endif // __PY_IMAGE_H__
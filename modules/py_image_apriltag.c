@@ -0,0 +1,211 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * AprilTag detector Python module.
+ */
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "imlib.h"
+#include "umalloc.h"
+#include "py_assert.h"
+#include "py_helper.h"
+#include "py_image.h"
+#include "py_image_apriltag.h"
+#include "py_image_tracker.h"
+
+#ifdef IMLIB_ENABLE_APRILTAGS
+typedef struct py_apriltag_detector_obj {
+    mp_obj_base_t base;
+    apriltag_families_t families;
+    imlib_apriltag_detector_t detector;
+} py_apriltag_detector_obj_t;
+
+static mp_obj_t py_apriltag_detector_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw,
+                                              const mp_obj_t *all_args) {
+    enum { ARG_families, ARG_quad_decimate, ARG_quad_sigma, ARG_refine_edges };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_families, MP_ARG_INT, {.u_int = TAG36H11} },
+        { MP_QSTR_quad_decimate, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_quad_sigma, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_refine_edges, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_apriltag_detector_obj_t *self = mp_obj_malloc_with_finaliser(py_apriltag_detector_obj_t, type);
+    self->families = args[ARG_families].u_int;
+
+    // The detector state is kept until the object is deleted.
+    imlib_apriltag_detector_init(&self->detector, self->families, UMA_PERSIST);
+
+    imlib_apriltag_detector_t *detector = &self->detector;
+    detector->quad_decimate = py_helper_arg_to_float(args[ARG_quad_decimate].u_obj, detector->quad_decimate);
+    detector->quad_sigma = py_helper_arg_to_float(args[ARG_quad_sigma].u_obj, detector->quad_sigma);
+
+    if (args[ARG_refine_edges].u_obj != mp_const_none) {
+        detector->refine_edges = mp_obj_is_true(args[ARG_refine_edges].u_obj);
+    }
+
+    PY_ASSERT_TRUE_MSG(detector->quad_decimate >= 1.0f, "quad_decimate must be >= 1");
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static mp_obj_t py_apriltag_detector_deinit(mp_obj_t self_in) {
+    py_apriltag_detector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    imlib_apriltag_detector_deinit(&self->detector);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_apriltag_detector_deinit_obj, py_apriltag_detector_deinit);
+
+typedef struct py_apriltag_detector_window {
+    imlib_apriltag_detector_t *detector;
+    rectangle_t roi;
+    float fx, fy, cx, cy;
+} py_apriltag_detector_window_t;
+
+static void py_apriltag_detector_detect_window(list_t *out, image_t *image, rectangle_t *roi, void *arg) {
+    py_apriltag_detector_window_t *w = arg;
+    // Keep poses relative to the requested ROI, see find_apriltags().
+    imlib_apriltag_detector_detect(w->detector, out, image, roi, w->fx, w->fy,
+                                   w->cx - (roi->x - w->roi.x), w->cy - (roi->y - w->roi.y));
+}
+
+static mp_obj_t py_apriltag_detector_detect(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_image, ARG_roi, ARG_fx, ARG_fy, ARG_cx, ARG_cy, ARG_tracker };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_image, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_roi, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_fx, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_fy, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_cx, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_cy, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_tracker, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_apriltag_detector_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    PY_ASSERT_TRUE_MSG(self->detector.td != NULL, "Detector was deinitialized");
+
+    image_t *image = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_ANY);
+    rectangle_t roi = py_helper_arg_to_roi(args[ARG_roi].u_obj, image);
+#ifndef IMLIB_ENABLE_HIGH_RES_APRILTAGS
+    PY_ASSERT_TRUE_MSG((roi.w * roi.h) < 65536, "The maximum supported resolution for find_apriltags() is < 64K pixels.");
+#endif
+    if ((roi.w < 4) || (roi.h < 4)) {
+        return mp_obj_new_list(0, NULL);
+    }
+
+    // Same camera defaults as find_apriltags().
+    float fx = py_helper_arg_to_float(args[ARG_fx].u_obj, (2.8 / 3.984) * image->w);
+    float fy = py_helper_arg_to_float(args[ARG_fy].u_obj, (2.8 / 2.952) * image->h);
+    float cx = py_helper_arg_to_float(args[ARG_cx].u_obj, image->w * 0.5f);
+    float cy = py_helper_arg_to_float(args[ARG_cy].u_obj, image->h * 0.5f);
+
+    list_t out;
+    if (args[ARG_tracker].u_obj != mp_const_none) {
+        py_apriltag_detector_window_t window = { &self->detector, roi, fx, fy, cx, cy };
+        uint32_t *track_ids = py_tracker_find(args[ARG_tracker].u_obj, &out, sizeof(find_apriltags_list_lnk_data_t),
+                                              image, &roi, py_apriltag_detector_detect_window, py_apriltag_track_key,
+                                              &window);
+        return py_apriltag_list_from_list(&out, track_ids);
+    }
+
+    imlib_apriltag_detector_detect(&self->detector, &out, image, &roi, fx, fy, cx, cy);
+    return py_apriltag_list_from_list(&out, NULL);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_apriltag_detector_detect_obj, 2, py_apriltag_detector_detect);
+
+static void py_apriltag_detector_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    py_apriltag_detector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    imlib_apriltag_detector_t *detector = &self->detector;
+
+    if (dest[0] == MP_OBJ_NULL) {
+        // Load attribute.
+        switch (attr) {
+            case MP_QSTR_families:
+                dest[0] = mp_obj_new_int(self->families);
+                break;
+            case MP_QSTR_quad_decimate:
+                dest[0] = mp_obj_new_float(detector->quad_decimate);
+                break;
+            case MP_QSTR_quad_sigma:
+                dest[0] = mp_obj_new_float(detector->quad_sigma);
+                break;
+            case MP_QSTR_refine_edges:
+                dest[0] = mp_obj_new_bool(detector->refine_edges);
+                break;
+            default:
+                // Continue lookup in locals_dict.
+                dest[1] = MP_OBJ_SENTINEL;
+                break;
+        }
+    } else if (dest[1] != MP_OBJ_NULL) {
+        // Store attribute.
+        switch (attr) {
+            case MP_QSTR_quad_decimate: {
+                float quad_decimate = mp_obj_get_float(dest[1]);
+                PY_ASSERT_TRUE_MSG(quad_decimate >= 1.0f, "quad_decimate must be >= 1");
+                detector->quad_decimate = quad_decimate;
+                break;
+            }
+            case MP_QSTR_quad_sigma:
+                detector->quad_sigma = mp_obj_get_float(dest[1]);
+                break;
+            case MP_QSTR_refine_edges:
+                detector->refine_edges = mp_obj_is_true(dest[1]);
+                break;
+            default:
+                return;
+        }
+        dest[0] = MP_OBJ_NULL;
+    }
+}
+
+static void py_apriltag_detector_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    py_apriltag_detector_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "{\"families\":%d, \"quad_decimate\":%f, \"quad_sigma\":%f, \"refine_edges\":%d}",
+              self->families, (double) self->detector.quad_decimate, (double) self->detector.quad_sigma,
+              self->detector.refine_edges);
+}
+
+static const mp_rom_map_elem_t py_apriltag_detector_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__),         MP_ROM_PTR(&py_apriltag_detector_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_deinit),          MP_ROM_PTR(&py_apriltag_detector_deinit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_detect),          MP_ROM_PTR(&py_apriltag_detector_detect_obj) },
+};
+static MP_DEFINE_CONST_DICT(py_apriltag_detector_locals_dict, py_apriltag_detector_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    py_image_apriltag_detector_type,
+    MP_QSTR_AprilTagDetector,
+    MP_TYPE_FLAG_NONE,
+    print, py_apriltag_detector_print,
+    make_new, py_apriltag_detector_make_new,
+    attr, py_apriltag_detector_attr,
+    locals_dict, &py_apriltag_detector_locals_dict
+    );
+#endif // IMLIB_ENABLE_APRILTAGS
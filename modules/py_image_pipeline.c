@@ -0,0 +1,507 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2013-2024 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Image pipeline Python module.
+ */
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "imlib.h"
+#include "umalloc.h"
+#include "py_assert.h"
+#include "py_helper.h"
+#include "py_image.h"
+#include "py_image_stats.h"
+#include "py_image_pipeline.h"
+
+typedef struct py_pipeline_obj {
+    mp_obj_base_t base;
+    imlib_pipeline_t pipeline;
+    // Keeps the image operands of line op stages alive.
+    mp_obj_t operands[IMLIB_PIPELINE_MAX_STAGES];
+} py_pipeline_obj_t;
+
+static imlib_pipeline_stage_t *py_pipeline_add_stage(mp_obj_t self_in, imlib_pipeline_op_t op) {
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->pipeline.n_stages >= IMLIB_PIPELINE_MAX_STAGES) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Too many pipeline stages"));
+    }
+
+    imlib_pipeline_stage_t *stage = &self->pipeline.stages[self->pipeline.n_stages++];
+    memset(stage, 0, sizeof(imlib_pipeline_stage_t));
+    stage->op = op;
+    return stage;
+}
+
+static mp_obj_t py_pipeline_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_arg_check_num(n_args, n_kw, 0, 0, false);
+    py_pipeline_obj_t *self = mp_obj_malloc(py_pipeline_obj_t, type);
+    self->pipeline.n_stages = 0;
+    memset(self->operands, 0, sizeof(self->operands));
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static void py_pipeline_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "{\"stages\":%d}", self->pipeline.n_stages);
+}
+
+static mp_obj_t py_pipeline_clear(mp_obj_t self_in) {
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    self->pipeline.n_stages = 0;
+    memset(self->operands, 0, sizeof(self->operands));
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_pipeline_clear_obj, py_pipeline_clear);
+
+static mp_obj_t py_pipeline_to_grayscale(mp_obj_t self_in) {
+    py_pipeline_add_stage(self_in, IMLIB_PIPELINE_OP_TO_GRAYSCALE);
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_pipeline_to_grayscale_obj, py_pipeline_to_grayscale);
+
+static mp_obj_t py_pipeline_to_rgb565(mp_obj_t self_in) {
+    py_pipeline_add_stage(self_in, IMLIB_PIPELINE_OP_TO_RGB565);
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_pipeline_to_rgb565_obj, py_pipeline_to_rgb565);
+
+static mp_obj_t py_pipeline_sepconv3(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_kernel, ARG_mul, ARG_add };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_kernel, MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_mul, MP_ARG_OBJ | MP_ARG_KW_ONLY,  {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_add, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = 0 } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t *krn;
+    mp_obj_get_array_fixed_n(args[ARG_kernel].u_obj, 3, &krn);
+
+    int8_t k[3];
+    int sum = 0;
+    for (int i = 0; i < 3; i++) {
+        int v = mp_obj_get_int(krn[i]);
+        PY_ASSERT_TRUE_MSG((v >= INT8_MIN) && (v <= INT8_MAX), "Kernel values must be between -128 and 127");
+        k[i] = v;
+        sum += v;
+    }
+
+    // The 2D kernel is the outer product of the 1D kernel with itself.
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(pos_args[0], IMLIB_PIPELINE_OP_SEPCONV3);
+    memcpy(stage->sepconv3.krn, k, sizeof(k));
+    stage->sepconv3.m = py_helper_arg_to_float(args[ARG_mul].u_obj, IM_DIV(1.0f, (float) (sum * sum)));
+    stage->sepconv3.b = args[ARG_add].u_int;
+    return pos_args[0];
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_sepconv3_obj, 2, py_pipeline_sepconv3);
+
+static mp_obj_t py_pipeline_gaussian(mp_obj_t self_in) {
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(self_in, IMLIB_PIPELINE_OP_SEPCONV3);
+    // The first row of the 3x3 gaussian kernel is its 1D kernel.
+    memcpy(stage->sepconv3.krn, kernel_gauss_3, sizeof(stage->sepconv3.krn));
+    stage->sepconv3.m = 1.0f / 16.0f;
+    stage->sepconv3.b = 0;
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_pipeline_gaussian_obj, py_pipeline_gaussian);
+
+#ifdef IMLIB_ENABLE_ISP_OPS
+static mp_obj_t py_pipeline_gamma(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_gamma, ARG_contrast, ARG_brightness };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_gamma, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_contrast, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE } },
+        { MP_QSTR_brightness, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE } },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(pos_args[0], IMLIB_PIPELINE_OP_GAMMA);
+    stage->gamma.gamma = py_helper_arg_to_float(args[ARG_gamma].u_obj, 1.0f);
+    stage->gamma.contrast = py_helper_arg_to_float(args[ARG_contrast].u_obj, 1.0f);
+    stage->gamma.brightness = py_helper_arg_to_float(args[ARG_brightness].u_obj, 0.0f);
+    return pos_args[0];
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_gamma_obj, 1, py_pipeline_gamma);
+
+static mp_obj_t py_pipeline_ccm(mp_obj_t self_in, mp_obj_t ccm_obj) {
+    float ccm[12];
+    bool offset = py_helper_arg_to_ccm(ccm_obj, ccm);
+
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(self_in, IMLIB_PIPELINE_OP_CCM);
+    memcpy(stage->ccm.ccm, ccm, sizeof(ccm));
+    stage->ccm.offset = offset;
+    return self_in;
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_ccm_obj, py_pipeline_ccm);
+#endif // IMLIB_ENABLE_ISP_OPS
+
+#ifdef IMLIB_ENABLE_BINARY_OPS
+static mp_obj_t py_pipeline_binary(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_thresholds, ARG_invert };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_thresholds, MP_ARG_OBJ | MP_ARG_REQUIRED, },
+        { MP_QSTR_invert, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(pos_args[0], IMLIB_PIPELINE_OP_BINARY);
+    list_init(&stage->binary.thresholds, sizeof(color_thresholds_list_lnk_data_t));
+    py_helper_arg_to_thresholds(args[ARG_thresholds].u_obj, &stage->binary.thresholds);
+    stage->binary.invert = args[ARG_invert].u_bool;
+    return pos_args[0];
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_binary_obj, 2, py_pipeline_binary);
+#endif // IMLIB_ENABLE_BINARY_OPS
+
+static mp_obj_t py_pipeline_line_op(mp_obj_t self_in, mp_obj_t other_obj, imlib_draw_row_callback_t callback) {
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    imlib_pipeline_stage_t *stage = py_pipeline_add_stage(self_in, IMLIB_PIPELINE_OP_LINE_OP);
+    stage->line_op.callback = callback;
+
+    // Scalars are converted to the row format when the pipeline runs.
+    if (mp_obj_is_integer(other_obj)) {
+        stage->line_op.scalar = mp_obj_get_int(other_obj);
+    } else if (MP_OBJ_IS_TYPE(other_obj, &mp_type_tuple) || MP_OBJ_IS_TYPE(other_obj, &mp_type_list)) {
+        mp_obj_t *rgb888;
+        mp_obj_get_array_fixed_n(other_obj, 3, &rgb888);
+        int r = IM_CLAMP(mp_obj_get_int(rgb888[0]), COLOR_R8_MIN, COLOR_R8_MAX);
+        int g = IM_CLAMP(mp_obj_get_int(rgb888[1]), COLOR_G8_MIN, COLOR_G8_MAX);
+        int b = IM_CLAMP(mp_obj_get_int(rgb888[2]), COLOR_B8_MIN, COLOR_B8_MAX);
+        stage->line_op.scalar = (r << 16) | (g << 8) | b;
+        stage->line_op.scalar_is_rgb888 = true;
+    } else {
+        stage->line_op.other = py_helper_arg_to_image(other_obj, ARG_IMAGE_UNCOMPRESSED | ARG_IMAGE_ALLOC);
+        self->operands[self->pipeline.n_stages - 1] = other_obj;
+    }
+
+    return self_in;
+}
+
+#ifdef IMLIB_ENABLE_MATH_OPS
+static mp_obj_t py_pipeline_add(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_add_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_add_obj, py_pipeline_add);
+
+static mp_obj_t py_pipeline_sub(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_sub_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_sub_obj, py_pipeline_sub);
+
+static mp_obj_t py_pipeline_min(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_min_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_min_obj, py_pipeline_min);
+
+static mp_obj_t py_pipeline_max(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_max_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_max_obj, py_pipeline_max);
+
+static mp_obj_t py_pipeline_difference(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_difference_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_difference_obj, py_pipeline_difference);
+#endif // IMLIB_ENABLE_MATH_OPS
+
+#ifdef IMLIB_ENABLE_BINARY_OPS
+static mp_obj_t py_pipeline_b_and(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_b_and_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_b_and_obj, py_pipeline_b_and);
+
+static mp_obj_t py_pipeline_b_or(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_b_or_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_b_or_obj, py_pipeline_b_or);
+
+static mp_obj_t py_pipeline_b_xor(mp_obj_t self_in, mp_obj_t other_obj) {
+    return py_pipeline_line_op(self_in, other_obj, imlib_b_xor_line_op);
+}
+static MP_DEFINE_CONST_FUN_OBJ_2(py_pipeline_b_xor_obj, py_pipeline_b_xor);
+#endif // IMLIB_ENABLE_BINARY_OPS
+
+static mp_obj_t py_pipeline_run(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_image, ARG_copy };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_image, MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_copy, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+    };
+
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    bool copy = args[ARG_copy].u_bool;
+    image_t *src = py_helper_arg_to_image(args[ARG_image].u_obj, copy ? ARG_IMAGE_UNCOMPRESSED : ARG_IMAGE_MUTABLE);
+
+    image_t dst = {
+        .w = src->w,
+        .h = src->h,
+        .pixfmt = imlib_pipeline_pixfmt(&self->pipeline, src, NULL),
+    };
+
+    if (copy) {
+        image_alloc(&dst, image_size(&dst));
+    } else {
+        // Rows are written back behind the rows being read, which only works if they don't grow.
+        // Bayer rows are debayered from their neighbours, so they can't be overwritten early.
+        if ((image_line_size(&dst) > image_line_size(src)) || src->is_bayer) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Can't run the pipeline in place, use copy=True"));
+        }
+        dst.data = src->data;
+    }
+
+    UMA_SCRATCH_CALL(imlib_pipeline_run(&self->pipeline, src, imlib_pipeline_image_cb, &dst));
+
+    if (copy) {
+        return py_image_from_struct(&dst);
+    }
+
+    src->pixfmt = dst.pixfmt;
+    py_helper_update_framebuffer(src);
+    return args[ARG_image].u_obj;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_run_obj, 2, py_pipeline_run);
+
+static mp_obj_t py_pipeline_get_histogram(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_image, ARG_bins, ARG_l_bins, ARG_a_bins, ARG_b_bins };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_image, MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_bins,        MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = -1} },
+        { MP_QSTR_l_bins,      MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = -1} },
+        { MP_QSTR_a_bins,      MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = -1} },
+        { MP_QSTR_b_bins,      MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = -1} },
+    };
+
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_t *src = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_UNCOMPRESSED);
+
+    histogram_t hist;
+    imlib_pipeline_histogram_t state = {
+        .hist = &hist,
+        .pixfmt = imlib_pipeline_pixfmt(&self->pipeline, src, NULL),
+        .w = src->w,
+    };
+
+    py_histogram_alloc_hist(&hist, state.pixfmt, args[ARG_bins].u_int,
+                            args[ARG_l_bins].u_int, args[ARG_a_bins].u_int, args[ARG_b_bins].u_int);
+
+    imlib_pipeline_histogram_start(&state);
+    UMA_SCRATCH_CALL(imlib_pipeline_run(&self->pipeline, src, imlib_pipeline_histogram_cb, &state));
+    imlib_pipeline_histogram_finish(&state);
+
+    return py_histogram_from_hist(&hist, state.pixfmt);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_get_histogram_obj, 2, py_pipeline_get_histogram);
+
+static mp_obj_t py_pipeline_find_blobs(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum {
+        ARG_image, ARG_thresholds, ARG_invert, ARG_x_stride, ARG_y_stride, ARG_area_threshold,
+        ARG_pixels_threshold, ARG_merge, ARG_margin, ARG_x_hist_bins_max, ARG_y_hist_bins_max
+    };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_image,            MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_thresholds,       MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_invert,           MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+        { MP_QSTR_x_stride,        MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 2} },
+        { MP_QSTR_y_stride,        MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 1} },
+        { MP_QSTR_area_threshold,  MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 10} },
+        { MP_QSTR_pixels_threshold, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 10} },
+        { MP_QSTR_merge,            MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+        { MP_QSTR_margin,           MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 0} },
+        { MP_QSTR_x_hist_bins_max, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 0} },
+        { MP_QSTR_y_hist_bins_max, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 0} },
+    };
+
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_t *src = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_UNCOMPRESSED);
+
+    list_t thresholds;
+    list_init(&thresholds, sizeof(color_thresholds_list_lnk_data_t));
+    py_helper_arg_to_thresholds(args[ARG_thresholds].u_obj, &thresholds);
+    if (!list_size(&thresholds)) {
+        return mp_obj_new_list(0, NULL);
+    }
+
+    unsigned int x_stride = args[ARG_x_stride].u_int;
+    PY_ASSERT_TRUE_MSG(x_stride > 0, "x_stride must not be zero.");
+    unsigned int y_stride = args[ARG_y_stride].u_int;
+    PY_ASSERT_TRUE_MSG(y_stride > 0, "y_stride must not be zero.");
+
+    // The labeler only needs the geometry and format of the rows it receives.
+    image_t img = {
+        .w = src->w,
+        .h = src->h,
+        .pixfmt = imlib_pipeline_pixfmt(&self->pipeline, src, NULL),
+    };
+    rectangle_t roi = {0, 0, img.w, img.h};
+
+    list_t out;
+    blob_labeler_t *ctx;
+    UMA_SCRATCH_CALL({
+        ctx = imlib_find_blobs_start(&out, &img, &roi, x_stride, y_stride, &thresholds,
+                                     args[ARG_invert].u_bool, args[ARG_area_threshold].u_int,
+                                     args[ARG_pixels_threshold].u_int, NULL, NULL,
+                                     args[ARG_x_hist_bins_max].u_int, args[ARG_y_hist_bins_max].u_int);
+        imlib_pipeline_run(&self->pipeline, src, imlib_pipeline_find_blobs_cb, ctx);
+        imlib_find_blobs_finish(ctx, args[ARG_merge].u_bool, args[ARG_margin].u_int, NULL, NULL);
+    });
+    list_free(&thresholds);
+
+    return py_blob_list_from_list(&out);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_find_blobs_obj, 3, py_pipeline_find_blobs);
+
+static mp_obj_t py_pipeline_compress(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_image, ARG_quality, ARG_subsampling };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_image, MP_ARG_OBJ | MP_ARG_REQUIRED },
+        { MP_QSTR_quality, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 90} },
+        { MP_QSTR_subsampling, MP_ARG_INT | MP_ARG_KW_ONLY,  {.u_int = JPEG_SUBSAMPLING_AUTO} },
+    };
+
+    py_pipeline_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    image_t *src = py_helper_arg_to_image(args[ARG_image].u_obj, ARG_IMAGE_UNCOMPRESSED);
+    int quality = args[ARG_quality].u_int;
+
+    if (quality < 1 || quality > 100) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Quality ranges between 1 and 100"));
+    }
+
+    image_t img = {
+        .w = src->w,
+        .h = src->h,
+        .pixfmt = imlib_pipeline_pixfmt(&self->pipeline, src, NULL),
+    };
+
+    // Starts with room for the uncompressed output, the encoder grows it if needed.
+    image_t out = {
+        .w = img.w,
+        .h = img.h,
+        .pixfmt = PIXFORMAT_JPEG,
+        .size = image_size(&img),
+    };
+    out.data = uma_malloc(out.size, UMA_CACHE);
+
+    #if (OMV_JPEG_CODEC_ENABLE == 0)
+    imlib_pipeline_jpeg_t state;
+    bool overflow;
+    UMA_SCRATCH_CALL({
+        imlib_pipeline_jpeg_start(&state, &out, img.w, img.h, img.pixfmt, quality, args[ARG_subsampling].u_int);
+        imlib_pipeline_run(&self->pipeline, src, imlib_pipeline_jpeg_cb, &state);
+        overflow = imlib_pipeline_jpeg_finish(&state);
+    });
+    #else
+    // The codec encodes whole frames, so the rows are staged into one.
+    bool overflow;
+    UMA_SCRATCH_CALL({
+        img.data = uma_malloc(image_size(&img), UMA_CACHE | UMA_SCRATCH);
+        imlib_pipeline_run(&self->pipeline, src, imlib_pipeline_image_cb, &img);
+        overflow = jpeg_compress(&img, &out, quality, true, args[ARG_subsampling].u_int);
+        uma_free(img.data);
+    });
+    #endif
+
+    if (overflow) {
+        uma_free(out.data);
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Compression Failed!"));
+    }
+
+    image_t dst = out;
+    image_alloc(&dst, out.size);
+    memcpy(dst.data, out.data, out.size);
+    uma_free(out.data);
+    return py_image_from_struct(&dst);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_pipeline_compress_obj, 2, py_pipeline_compress);
+
+static const mp_rom_map_elem_t py_pipeline_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_clear),           MP_ROM_PTR(&py_pipeline_clear_obj) },
+    { MP_ROM_QSTR(MP_QSTR_to_grayscale),    MP_ROM_PTR(&py_pipeline_to_grayscale_obj) },
+    { MP_ROM_QSTR(MP_QSTR_to_rgb565),       MP_ROM_PTR(&py_pipeline_to_rgb565_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sepconv3),        MP_ROM_PTR(&py_pipeline_sepconv3_obj) },
+    { MP_ROM_QSTR(MP_QSTR_gaussian),        MP_ROM_PTR(&py_pipeline_gaussian_obj) },
+    #ifdef IMLIB_ENABLE_ISP_OPS
+    { MP_ROM_QSTR(MP_QSTR_gamma),           MP_ROM_PTR(&py_pipeline_gamma_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ccm),             MP_ROM_PTR(&py_pipeline_ccm_obj) },
+    #else
+    { MP_ROM_QSTR(MP_QSTR_gamma),           MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_ccm),             MP_ROM_PTR(&py_func_unavailable_obj) },
+    #endif
+    #ifdef IMLIB_ENABLE_BINARY_OPS
+    { MP_ROM_QSTR(MP_QSTR_binary),          MP_ROM_PTR(&py_pipeline_binary_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_and),           MP_ROM_PTR(&py_pipeline_b_and_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_or),            MP_ROM_PTR(&py_pipeline_b_or_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_xor),           MP_ROM_PTR(&py_pipeline_b_xor_obj) },
+    #else
+    { MP_ROM_QSTR(MP_QSTR_binary),          MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_and),           MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_or),            MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_b_xor),           MP_ROM_PTR(&py_func_unavailable_obj) },
+    #endif
+    #ifdef IMLIB_ENABLE_MATH_OPS
+    { MP_ROM_QSTR(MP_QSTR_add),             MP_ROM_PTR(&py_pipeline_add_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sub),             MP_ROM_PTR(&py_pipeline_sub_obj) },
+    { MP_ROM_QSTR(MP_QSTR_min),             MP_ROM_PTR(&py_pipeline_min_obj) },
+    { MP_ROM_QSTR(MP_QSTR_max),             MP_ROM_PTR(&py_pipeline_max_obj) },
+    { MP_ROM_QSTR(MP_QSTR_difference),      MP_ROM_PTR(&py_pipeline_difference_obj) },
+    #else
+    { MP_ROM_QSTR(MP_QSTR_add),             MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sub),             MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_min),             MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_max),             MP_ROM_PTR(&py_func_unavailable_obj) },
+    { MP_ROM_QSTR(MP_QSTR_difference),      MP_ROM_PTR(&py_func_unavailable_obj) },
+    #endif
+    { MP_ROM_QSTR(MP_QSTR_run),             MP_ROM_PTR(&py_pipeline_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get_histogram),   MP_ROM_PTR(&py_pipeline_get_histogram_obj) },
+    { MP_ROM_QSTR(MP_QSTR_find_blobs),      MP_ROM_PTR(&py_pipeline_find_blobs_obj) },
+    { MP_ROM_QSTR(MP_QSTR_compress),        MP_ROM_PTR(&py_pipeline_compress_obj) },
+};
+static MP_DEFINE_CONST_DICT(py_pipeline_locals_dict, py_pipeline_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    py_image_pipeline_type,
+    MP_QSTR_Pipeline,
+    MP_TYPE_FLAG_NONE,
+    print, py_pipeline_print,
+    make_new, py_pipeline_make_new,
+    locals_dict, &py_pipeline_locals_dict
+    );
@@ -170,9 +170,9 @@ static void py_histogram_to_hist(py_histogram_obj_t *self, histogram_t *hist) {
     hist->LBinCount = l_bins->len;
     hist->ABinCount = a_bins->len;
     hist->BBinCount = b_bins->len;
-    hist->LBins = uma_malloc(hist->LBinCount * sizeof(float), UMA_DTCM);
-    hist->ABins = uma_malloc(hist->ABinCount * sizeof(float), UMA_DTCM);
-    hist->BBins = uma_malloc(hist->BBinCount * sizeof(float), UMA_DTCM);
+    hist->LBins = uma_malloc(hist->LBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+    hist->ABins = uma_malloc(hist->ABinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+    hist->BBins = uma_malloc(hist->BBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
 
     for (int i = 0; i < hist->LBinCount; i++) {
         hist->LBins[i] = mp_obj_get_float_to_f(l_bins->items[i]);
@@ -191,6 +191,84 @@ void py_histogram_free_hist(histogram_t *hist) {
     uma_free(hist->LBins);
 }
 
+// Allocates the bins for a BINARY, GRAYSCALE or RGB565 histogram. Negative counts select the default.
+void py_histogram_alloc_hist(histogram_t *hist, pixformat_t pixfmt, int bins, int l_bins, int a_bins, int b_bins) {
+    switch (pixfmt) {
+        case PIXFORMAT_BINARY: {
+            bins = (bins >= 0) ? bins : (COLOR_BINARY_MAX - COLOR_BINARY_MIN + 1);
+            PY_ASSERT_TRUE_MSG(bins >= 2, "bins must be >= 2");
+            hist->LBinCount = (l_bins >= 0) ? l_bins : bins;
+            PY_ASSERT_TRUE_MSG(hist->LBinCount >= 2, "l_bins must be >= 2");
+            hist->ABinCount = 0;
+            hist->BBinCount = 0;
+            hist->LBins = uma_malloc(hist->LBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+            hist->ABins = NULL;
+            hist->BBins = NULL;
+            break;
+        }
+        case PIXFORMAT_GRAYSCALE: {
+            bins = (bins >= 0) ? bins : (COLOR_GRAYSCALE_MAX - COLOR_GRAYSCALE_MIN + 1);
+            PY_ASSERT_TRUE_MSG(bins >= 2, "bins must be >= 2");
+            hist->LBinCount = (l_bins >= 0) ? l_bins : bins;
+            PY_ASSERT_TRUE_MSG(hist->LBinCount >= 2, "l_bins must be >= 2");
+            hist->ABinCount = 0;
+            hist->BBinCount = 0;
+            hist->LBins = uma_malloc(hist->LBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+            hist->ABins = NULL;
+            hist->BBins = NULL;
+            break;
+        }
+        default: {
+            int l_default = (bins >= 0) ? bins : (COLOR_L_MAX - COLOR_L_MIN + 1);
+            PY_ASSERT_TRUE_MSG(l_default >= 2, "bins must be >= 2");
+            hist->LBinCount = (l_bins >= 0) ? l_bins : l_default;
+            PY_ASSERT_TRUE_MSG(hist->LBinCount >= 2, "l_bins must be >= 2");
+            int a_default = (bins >= 0) ? bins : (COLOR_A_MAX - COLOR_A_MIN + 1);
+            PY_ASSERT_TRUE_MSG(a_default >= 2, "bins must be >= 2");
+            hist->ABinCount = (a_bins >= 0) ? a_bins : a_default;
+            PY_ASSERT_TRUE_MSG(hist->ABinCount >= 2, "a_bins must be >= 2");
+            int b_default = (bins >= 0) ? bins : (COLOR_B_MAX - COLOR_B_MIN + 1);
+            PY_ASSERT_TRUE_MSG(b_default >= 2, "bins must be >= 2");
+            hist->BBinCount = (b_bins >= 0) ? b_bins : b_default;
+            PY_ASSERT_TRUE_MSG(hist->BBinCount >= 2, "b_bins must be >= 2");
+            hist->LBins = uma_malloc(hist->LBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+            hist->ABins = uma_malloc(hist->ABinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+            hist->BBins = uma_malloc(hist->BBinCount * sizeof(float), UMA_DTCM | UMA_SCRATCH);
+            break;
+        }
+    }
+}
+
+// Creates a histogram object from the bins and frees them.
+mp_obj_t py_histogram_from_hist(histogram_t *hist, pixformat_t pixfmt) {
+    py_histogram_obj_t *o = m_new_obj(py_histogram_obj_t);
+    o->base.type = &py_histogram_type;
+    o->pixfmt = pixfmt;
+
+    o->LBins = mp_obj_new_list(hist->LBinCount, NULL);
+    o->ABins = mp_obj_new_list(hist->ABinCount, NULL);
+    o->BBins = mp_obj_new_list(hist->BBinCount, NULL);
+
+    mp_obj_list_t *l_bins = MP_OBJ_TO_PTR(o->LBins);
+    mp_obj_list_t *a_bins = MP_OBJ_TO_PTR(o->ABins);
+    mp_obj_list_t *b_bins = MP_OBJ_TO_PTR(o->BBins);
+
+    for (int i = 0; i < hist->LBinCount; i++) {
+        l_bins->items[i] = mp_obj_new_float(hist->LBins[i]);
+    }
+
+    for (int i = 0; i < hist->ABinCount; i++) {
+        a_bins->items[i] = mp_obj_new_float(hist->ABins[i]);
+    }
+
+    for (int i = 0; i < hist->BBinCount; i++) {
+        b_bins->items[i] = mp_obj_new_float(hist->BBins[i]);
+    }
+
+    py_histogram_free_hist(hist);
+    return o;
+}
+
 mp_obj_t py_histogram_get_percentile(mp_obj_t self_in, mp_obj_t percentile) {
     py_histogram_obj_t *self = MP_OBJ_TO_PTR(self_in);
     histogram_t hist;
@@ -37,4 +37,6 @@ extern const qstr similarity_fields[4];
 #endif
 mp_obj_t py_statistics_attrtuple(statistics_t *stats);
 void py_histogram_free_hist(histogram_t *hist);
+void py_histogram_alloc_hist(histogram_t *hist, pixformat_t pixfmt, int bins, int l_bins, int a_bins, int b_bins);
+mp_obj_t py_histogram_from_hist(histogram_t *hist, pixformat_t pixfmt);
 #endif // __PY_IMAGE_STATS_H__
@@ -0,0 +1,163 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * Temporal ROI tracker Python module.
+ */
+#include "py/obj.h"
+#include "py/runtime.h"
+
+#include "imlib.h"
+#include "py_assert.h"
+#include "py_helper.h"
+#include "py_image.h"
+#include "py_image_tracker.h"
+
+typedef struct py_tracker_obj {
+    mp_obj_base_t base;
+    imlib_tracker_t tracker;
+} py_tracker_obj_t;
+
+// FNV-1a hash of a detection payload.
+uint32_t py_tracker_hash(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ ((uint8_t) data[i])) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t *py_tracker_find(mp_obj_t tracker_obj, list_t *out, size_t lnk_size, image_t *image, rectangle_t *roi,
+                          py_tracker_find_t find, py_tracker_key_t key, void *arg) {
+    if (!MP_OBJ_IS_TYPE(tracker_obj, &py_image_tracker_type)) {
+        mp_raise_TypeError(MP_ERROR_TEXT("Expected a Tracker"));
+    }
+
+    imlib_tracker_t *tracker = &((py_tracker_obj_t *) MP_OBJ_TO_PTR(tracker_obj))->tracker;
+    rectangle_t windows[IMLIB_TRACKER_MAX_TRACKS];
+    size_t n_windows = imlib_tracker_windows(tracker, roi, windows);
+
+    list_init(out, lnk_size);
+
+    for (size_t i = 0; i < n_windows; i++) {
+        // Windows clipped by the ROI edge may be too small to hold a marker.
+        if ((windows[i].w < 4) || (windows[i].h < 4)) {
+            continue;
+        }
+
+        list_t window_out;
+        find(&window_out, image, &windows[i], arg);
+
+        while (list_size(&window_out)) {
+            list_move_back(out, &window_out, window_out.head);
+        }
+    }
+
+    size_t n = list_size(out);
+    imlib_tracker_det_t *dets = m_new(imlib_tracker_det_t, n);
+    uint32_t *ids = m_new(uint32_t, n);
+
+    size_t i = 0;
+    list_for_each(it, out) {
+        dets[i].key = key(list_get_data(it), &dets[i].rect);
+        i++;
+    }
+
+    imlib_tracker_update(tracker, n, dets, ids);
+    m_del(imlib_tracker_det_t, dets, n);
+    return ids;
+}
+
+static mp_obj_t py_tracker_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_interval, ARG_margin, ARG_max_lost };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_interval, MP_ARG_INT, {.u_int = 30} },
+        { MP_QSTR_margin, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_max_lost, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 3} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    PY_ASSERT_TRUE_MSG(args[ARG_interval].u_int > 0, "interval must be > 0");
+    PY_ASSERT_TRUE_MSG(args[ARG_max_lost].u_int >= 0, "max_lost must be >= 0");
+
+    py_tracker_obj_t *self = mp_obj_malloc(py_tracker_obj_t, type);
+    imlib_tracker_init(&self->tracker, args[ARG_interval].u_int,
+                       py_helper_arg_to_float(args[ARG_margin].u_obj, 0.5f), args[ARG_max_lost].u_int);
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static void py_tracker_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    py_tracker_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "{\"interval\":%d, \"max_lost\":%d, \"tracks\":%d, \"full_scan\":%d}",
+              self->tracker.interval, self->tracker.max_lost, self->tracker.n_tracks, self->tracker.full_scan);
+}
+
+static mp_obj_t py_tracker_reset(mp_obj_t self_in) {
+    py_tracker_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    imlib_tracker_reset(&self->tracker);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_1(py_tracker_reset_obj, py_tracker_reset);
+
+static void py_tracker_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    py_tracker_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (dest[0] == MP_OBJ_NULL) {
+        // Load attribute.
+        switch (attr) {
+            case MP_QSTR_interval:
+                dest[0] = mp_obj_new_int(self->tracker.interval);
+                break;
+            case MP_QSTR_margin:
+                dest[0] = mp_obj_new_float(self->tracker.margin);
+                break;
+            case MP_QSTR_max_lost:
+                dest[0] = mp_obj_new_int(self->tracker.max_lost);
+                break;
+            case MP_QSTR_tracks:
+                dest[0] = mp_obj_new_int(self->tracker.n_tracks);
+                break;
+            case MP_QSTR_full_scan:
+                dest[0] = mp_obj_new_bool(self->tracker.full_scan);
+                break;
+            default:
+                // Continue lookup in locals_dict.
+                dest[1] = MP_OBJ_SENTINEL;
+                break;
+        }
+    }
+}
+
+static const mp_rom_map_elem_t py_tracker_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_reset),           MP_ROM_PTR(&py_tracker_reset_obj) },
+};
+static MP_DEFINE_CONST_DICT(py_tracker_locals_dict, py_tracker_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    py_image_tracker_type,
+    MP_QSTR_Tracker,
+    MP_TYPE_FLAG_NONE,
+    print, py_tracker_print,
+    make_new, py_tracker_make_new,
+    attr, py_tracker_attr,
+    locals_dict, &py_tracker_locals_dict
+    );
@@ -0,0 +1,35 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ * Temporal ROI tracker Python module.
+ */
+#ifndef __PY_IMAGE_TRACKER_H__
+#define __PY_IMAGE_TRACKER_H__
+extern const mp_obj_type_t py_image_tracker_type;
+// Detector run on each search window.
+typedef void (*py_tracker_find_t) (list_t *out, image_t *image, rectangle_t *roi, void *arg);
+// Returns the identity key and the bounding box of a detection.
+typedef uint32_t (*py_tracker_key_t) (void *lnk_data, rectangle_t *rect);
+uint32_t *py_tracker_find(mp_obj_t tracker_obj, list_t *out, size_t lnk_size, image_t *image, rectangle_t *roi,
+                          py_tracker_find_t find, py_tracker_key_t key, void *arg);
+uint32_t py_tracker_hash(const char *data, size_t len);
+#endif // __PY_IMAGE_TRACKER_H__
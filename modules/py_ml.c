@@ -77,6 +77,348 @@ static size_t py_ml_dtype_size(char dtype) {
     }
 }
 
+// Normalization Object.
+typedef struct py_ml_norm_obj {
+    mp_obj_base_t base;
+    mp_obj_t image;
+    mp_obj_t roi;
+    float scale[2];
+    float mean[3];
+    float stdev[3];
+} py_ml_norm_obj_t;
+
+// Per-channel lookup tables mapping 8-bit pixel values to tensor values.
+typedef union py_ml_norm_lut {
+    uint8_t u8[3][256];
+    uint16_t u16[3][256];
+    float f32[3][256];
+} py_ml_norm_lut_t;
+
+typedef struct py_ml_norm_state {
+    void *output;
+    int dtype;
+    int channels;
+    int w;
+    const py_ml_norm_lut_t *lut;
+} py_ml_norm_state_t;
+
+static const mp_obj_type_t py_ml_norm_type;
+
+static bool py_ml_norm_is_default(py_ml_norm_obj_t *self) {
+    return (self->scale[0] == 0.0f) && (self->scale[1] == 1.0f) &&
+           (self->mean[0] == 0.0f) && (self->mean[1] == 0.0f) && (self->mean[2] == 0.0f) &&
+           (self->stdev[0] == 1.0f) && (self->stdev[1] == 1.0f) && (self->stdev[2] == 1.0f);
+}
+
+static float py_ml_norm_grayscale(const float *x) {
+    return (x[0] * 0.299f) + (x[1] * 0.587f) + (x[2] * 0.114f);
+}
+
+// Builds the pixel to tensor lookup tables. Float tensors get the normalized value. Integer tensors
+// get the normalized value quantized with the tensor scale and zero point. With the default
+// normalization 8-bit tensors get the raw pixel values (shifted by 128 for int8), which is what
+// quantized vision models expect.
+static void py_ml_norm_build_lut(py_ml_norm_obj_t *self, int channels, int dtype,
+                                 float input_scale, int input_zero_point, py_ml_norm_lut_t *lut) {
+    bool raw = (dtype == 'b' || dtype == 'B') && (input_scale == 0.0f || py_ml_norm_is_default(self));
+
+    for (int c = 0; c < channels; c++) {
+        float mean = (channels == 1) ? py_ml_norm_grayscale(self->mean) : self->mean[c];
+        float stdev = (channels == 1) ? py_ml_norm_grayscale(self->stdev) : self->stdev[c];
+        float fscale = ((self->scale[1] - self->scale[0]) / 255.0f) / stdev;
+        float fadd = (self->scale[0] - mean) / stdev;
+
+        for (int i = 0; i < 256; i++) {
+            float v = (i * fscale) + fadd;
+            switch (dtype) {
+                case 'f':
+                    lut->f32[c][i] = v;
+                    break;
+                case 'b':
+                    lut->u8[c][i] = raw ? (i ^ 0x80) :
+                                    (uint8_t) IM_CLAMP(fast_roundf((v / input_scale) + input_zero_point), INT8_MIN, INT8_MAX);
+                    break;
+                case 'B':
+                    lut->u8[c][i] = raw ? i :
+                                    IM_CLAMP(fast_roundf((v / input_scale) + input_zero_point), 0, UINT8_MAX);
+                    break;
+                case 'h':
+                    lut->u16[c][i] = (uint16_t) IM_CLAMP(fast_roundf((v / input_scale) + input_zero_point), INT16_MIN, INT16_MAX);
+                    break;
+                case 'H':
+                    lut->u16[c][i] = IM_CLAMP(fast_roundf((v / input_scale) + input_zero_point), 0, UINT16_MAX);
+                    break;
+            }
+        }
+    }
+}
+
+// Converts one row rendered by imlib_draw_image() into the tensor.
+static void py_ml_norm_row_callback(int x_start, int x_end, int y_row, imlib_draw_row_data_t *data) {
+    py_ml_norm_state_t *state = data->callback_arg;
+    const py_ml_norm_lut_t *lut = state->lut;
+    size_t offset = ((y_row * state->w) + x_start) * state->channels;
+
+    if (state->channels == 1) {
+        const uint8_t *src = ((uint8_t *) data->dst_row_override) + x_start;
+        switch (state->dtype) {
+            case 'f': {
+                float *dst = ((float *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++) {
+                    *dst++ = lut->f32[0][*src++];
+                }
+                break;
+            }
+            case 'h':
+            case 'H': {
+                uint16_t *dst = ((uint16_t *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++) {
+                    *dst++ = lut->u16[0][*src++];
+                }
+                break;
+            }
+            default: {
+                uint8_t *dst = ((uint8_t *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++) {
+                    *dst++ = lut->u8[0][*src++];
+                }
+                break;
+            }
+        }
+    } else {
+        const uint16_t *src = ((uint16_t *) data->dst_row_override) + x_start;
+        switch (state->dtype) {
+            case 'f': {
+                float *dst = ((float *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++, dst += 3) {
+                    int pixel = *src++;
+                    dst[0] = lut->f32[0][COLOR_RGB565_TO_R8(pixel)];
+                    dst[1] = lut->f32[1][COLOR_RGB565_TO_G8(pixel)];
+                    dst[2] = lut->f32[2][COLOR_RGB565_TO_B8(pixel)];
+                }
+                break;
+            }
+            case 'h':
+            case 'H': {
+                uint16_t *dst = ((uint16_t *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++, dst += 3) {
+                    int pixel = *src++;
+                    dst[0] = lut->u16[0][COLOR_RGB565_TO_R8(pixel)];
+                    dst[1] = lut->u16[1][COLOR_RGB565_TO_G8(pixel)];
+                    dst[2] = lut->u16[2][COLOR_RGB565_TO_B8(pixel)];
+                }
+                break;
+            }
+            default: {
+                uint8_t *dst = ((uint8_t *) state->output) + offset;
+                for (int x = x_start; x < x_end; x++, dst += 3) {
+                    int pixel = *src++;
+                    dst[0] = lut->u8[0][COLOR_RGB565_TO_R8(pixel)];
+                    dst[1] = lut->u8[1][COLOR_RGB565_TO_G8(pixel)];
+                    dst[2] = lut->u8[2][COLOR_RGB565_TO_B8(pixel)];
+                }
+                break;
+            }
+        }
+    }
+}
+
+// Crops, scales, color converts and normalizes/quantizes the bound image into the tensor
+// buffer in a single pass. An input_scale of 0 means the tensor quantization is unknown.
+static void py_ml_norm_process(py_ml_norm_obj_t *self, void *buffer, size_t buffer_size,
+                               mp_obj_tuple_t *shape, int dtype, float input_scale, int input_zero_point) {
+    if (shape->len != 4) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected input tensor with shape: (1, H, W, C)"));
+    }
+
+    int b = mp_obj_get_int(shape->items[0]);
+    int h = mp_obj_get_int(shape->items[1]);
+    int w = mp_obj_get_int(shape->items[2]);
+    int c = mp_obj_get_int(shape->items[3]);
+
+    if (b != 1) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected batches to be 1"));
+    }
+
+    if (c != 1 && c != 3) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected channels to be 1 or 3"));
+    }
+
+    if ((dtype == 'h' || dtype == 'H') && input_scale == 0.0f) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unsupported dtype"));
+    }
+
+    if ((size_t) (w * h * c) * py_ml_dtype_size(dtype) > buffer_size) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Buffer is too small"));
+    }
+
+    image_t *src_img = py_helper_arg_to_image(self->image, ARG_IMAGE_ANY);
+    rectangle_t roi = py_helper_arg_to_roi(self->roi, src_img);
+
+    image_t dst_img = {
+        .w = w,
+        .h = h,
+        .pixfmt = (c == 1) ? PIXFORMAT_GRAYSCALE : PIXFORMAT_RGB565,
+    };
+
+    py_ml_norm_lut_t *lut = m_new(py_ml_norm_lut_t, 1);
+    py_ml_norm_build_lut(self, c, dtype, input_scale, input_zero_point, lut);
+
+    // Fill the area not covered by the image (if any) with black.
+    image_hint_t hint = IMAGE_HINT_BILINEAR | IMAGE_HINT_CENTER |
+                        IMAGE_HINT_SCALE_ASPECT_IGNORE | IMAGE_HINT_BLACK_BACKGROUND;
+    point_t p0, p1;
+    imlib_draw_image_get_bounds(&dst_img, src_img, 0, 0, 1.0f, 1.0f, &roi, 255, NULL, hint, &p0, &p1);
+
+    if ((p0.x != 0) || (p0.y != 0) || (p1.x != w) || (p1.y != h)) {
+        size_t size = py_ml_dtype_size(dtype);
+        for (size_t i = 0, n = w * h * c; i < n; i++) {
+            memcpy(((uint8_t *) buffer) + (i * size), ((uint8_t *) lut) + ((i % c) * 256 * size), size);
+        }
+    }
+
+    py_ml_norm_state_t state = {
+        .output = buffer,
+        .dtype = dtype,
+        .channels = c,
+        .w = w,
+        .lut = lut,
+    };
+
+    dst_img.data = uma_calloc(image_line_size(&dst_img), UMA_CACHE);
+    imlib_draw_image(&dst_img, src_img, 0, 0, 1.0f, 1.0f, &roi, -1, 255, NULL, NULL,
+                     hint, NULL, py_ml_norm_row_callback, &state, dst_img.data);
+    uma_free(dst_img.data);
+    m_del(py_ml_norm_lut_t, lut, 1);
+}
+
+static void py_ml_norm_parse_floats(mp_obj_t arg, size_t n, float *values) {
+    mp_obj_t *items;
+    mp_obj_get_array_fixed_n(arg, n, &items);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = mp_obj_get_float_to_f(items[i]);
+    }
+}
+
+static mp_obj_t py_ml_norm_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_scale, ARG_mean, ARG_stdev, ARG_roi };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_scale, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_mean, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_stdev, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_roi, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_norm_obj_t *self = mp_obj_malloc(py_ml_norm_obj_t, &py_ml_norm_type);
+    self->image = mp_const_none;
+    self->roi = args[ARG_roi].u_obj;
+    self->scale[0] = 0.0f;
+    self->scale[1] = 1.0f;
+
+    for (size_t i = 0; i < 3; i++) {
+        self->mean[i] = 0.0f;
+        self->stdev[i] = 1.0f;
+    }
+
+    if (args[ARG_scale].u_obj != mp_const_none) {
+        py_ml_norm_parse_floats(args[ARG_scale].u_obj, 2, self->scale);
+    }
+
+    if (args[ARG_mean].u_obj != mp_const_none) {
+        py_ml_norm_parse_floats(args[ARG_mean].u_obj, 3, self->mean);
+    }
+
+    if (args[ARG_stdev].u_obj != mp_const_none) {
+        py_ml_norm_parse_floats(args[ARG_stdev].u_obj, 3, self->stdev);
+    }
+
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Called with an image to bind it, or with (buffer, shape, dtype[, scale, zero_point]) to fill
+// a tensor. The scale and zero point are the tensor quantization, unknown if not passed.
+static mp_obj_t py_ml_norm_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    py_ml_norm_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_arg_check_num(n_args, n_kw, 1, 5, false);
+
+    if (n_args == 1) {
+        if (!MP_OBJ_IS_TYPE(args[0], &py_image_type)) {
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected an image input"));
+        }
+
+        image_t *image = py_image_cobj(args[0]);
+        py_ml_norm_obj_t *norm = mp_obj_malloc(py_ml_norm_obj_t, &py_ml_norm_type);
+        memcpy(norm, self, sizeof(py_ml_norm_obj_t));
+        norm->image = args[0];
+
+        if (norm->roi == mp_const_none) {
+            mp_obj_t roi[4] = {
+                mp_obj_new_int(0), mp_obj_new_int(0), mp_obj_new_int(image->w), mp_obj_new_int(image->h)
+            };
+            norm->roi = mp_obj_new_tuple(4, roi);
+        }
+
+        return MP_OBJ_FROM_PTR(norm);
+    }
+
+    if ((n_args != 3 && n_args != 5) || self->image == mp_const_none) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected an image input"));
+    }
+
+    float input_scale = (n_args == 5) ? mp_obj_get_float_to_f(args[3]) : 0.0f;
+    int input_zero_point = (n_args == 5) ? mp_obj_get_int(args[4]) : 0;
+
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_WRITE);
+    py_ml_norm_process(self, bufinfo.buf, bufinfo.len, MP_OBJ_TO_PTR(args[1]), mp_obj_get_int(args[2]),
+                       input_scale, input_zero_point);
+    return mp_const_none;
+}
+
+static void py_ml_norm_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
+    py_ml_norm_obj_t *self = MP_OBJ_TO_PTR(self_in);
+    if (dest[0] == MP_OBJ_NULL) {
+        // Load attribute.
+        switch (attr) {
+            case MP_QSTR_scale:
+                dest[0] = mp_obj_new_tuple(2, (mp_obj_t []) {
+                    mp_obj_new_float(self->scale[0]), mp_obj_new_float(self->scale[1])
+                });
+                break;
+            case MP_QSTR_mean:
+                dest[0] = mp_obj_new_tuple(3, (mp_obj_t []) {
+                    mp_obj_new_float(self->mean[0]), mp_obj_new_float(self->mean[1]), mp_obj_new_float(self->mean[2])
+                });
+                break;
+            case MP_QSTR_stdev:
+                dest[0] = mp_obj_new_tuple(3, (mp_obj_t []) {
+                    mp_obj_new_float(self->stdev[0]), mp_obj_new_float(self->stdev[1]), mp_obj_new_float(self->stdev[2])
+                });
+                break;
+            case MP_QSTR_roi:
+                dest[0] = self->roi;
+                break;
+            default:
+                // Continue lookup in locals_dict.
+                dest[1] = MP_OBJ_SENTINEL;
+                break;
+        }
+    }
+}
+
+static MP_DEFINE_CONST_OBJ_TYPE(
+    py_ml_norm_type,
+    MP_QSTR_Normalization,
+    MP_TYPE_FLAG_NONE,
+    make_new, py_ml_norm_make_new,
+    call, py_ml_norm_call,
+    attr, py_ml_norm_attr
+    );
+
 static void py_ml_process_input(py_ml_model_obj_t *model, mp_obj_t arg) {
     mp_obj_list_t *input_list = MP_OBJ_TO_PTR(arg);
 
@@ -89,7 +431,15 @@ static void py_ml_process_input(py_ml_model_obj_t *model, mp_obj_t arg) {
         int input_dtype = mp_obj_get_int(model->input_dtype->items[i]);
         mp_obj_t input_arg = input_list->items[i];
 
-        if (mp_obj_is_callable(input_arg)) {
+        if (MP_OBJ_IS_TYPE(input_arg, &py_ml_norm_type)) {
+            // Input is a normalized image. The image is converted directly into the tensor buffer.
+            py_ml_norm_obj_t *norm = MP_OBJ_TO_PTR(input_arg);
+            if (norm->image == mp_const_none) {
+                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected an image input"));
+            }
+            py_ml_norm_process(norm, input_buffer, input_size * py_ml_dtype_size(input_dtype), input_shape,
+                               input_dtype, mp_obj_get_float_to_f(model->input_scale->items[i]), input_zero_point);
+        } else if (mp_obj_is_callable(input_arg)) {
             // Input is a callable. Call the object and pass the tensor buffer and dtype.
             mp_obj_t fargs[3] = {
                 mp_obj_new_bytearray_by_ref(input_size * py_ml_dtype_size(input_dtype), input_buffer),
@@ -210,9 +560,6 @@ static mp_obj_t py_ml_process_output(py_ml_model_obj_t *model, bool deep_copy) {
     return MP_OBJ_FROM_PTR(output_list);
 }
 
-// TF Model Object.
-static const mp_obj_type_t py_ml_model_type;
-
 static mp_obj_t py_ml_dtype_char_tuple(const mp_obj_tuple_t *dtype) {
     mp_obj_tuple_t *r = (mp_obj_tuple_t *) MP_OBJ_TO_PTR(mp_obj_new_tuple(dtype->len, NULL));
     for (size_t i = 0; i < dtype->len; i++) {
@@ -411,7 +758,7 @@ static const mp_rom_map_elem_t py_ml_model_locals_dict_table[] = {
 
 static MP_DEFINE_CONST_DICT(py_ml_model_locals_dict, py_ml_model_locals_dict_table);
 
-static MP_DEFINE_CONST_OBJ_TYPE(
+MP_DEFINE_CONST_OBJ_TYPE(
     py_ml_model_type,
     MP_QSTR_ml_model,
     MP_TYPE_FLAG_NONE,
@@ -426,6 +773,8 @@ extern const mp_obj_type_t py_ml_nms_type;
 static const mp_rom_map_elem_t py_ml_globals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__),            MP_OBJ_NEW_QSTR(MP_QSTR_ml) },
     { MP_ROM_QSTR(MP_QSTR_Model),               MP_ROM_PTR(&py_ml_model_type) },
+    { MP_ROM_QSTR(MP_QSTR_NMS),                 MP_ROM_PTR(&py_ml_nms_type) },
+    { MP_ROM_QSTR(MP_QSTR_Normalization),       MP_ROM_PTR(&py_ml_norm_type) },
 };
 
 static MP_DEFINE_CONST_DICT(py_ml_globals_dict, py_ml_globals_dict_table);
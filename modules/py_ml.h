@@ -55,6 +55,8 @@ typedef struct py_ml_model_obj {
     void *state; // Private context for the backend.
 } py_ml_model_obj_t;
 
+extern const mp_obj_type_t py_ml_model_type;
+
 // Initialize a model.
 int ml_backend_init_model(py_ml_model_obj_t *model);
 
@@ -0,0 +1,811 @@
+/*
+ * Copyright (C) 2024 OpenMV, LLC.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Any redistribution, use, or modification in source or binary form
+ *    is done solely for personal benefit and not for any commercial
+ *    purpose or for monetary gain. For commercial licensing options,
+ *    please contact openmv@openmv.io
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE LICENSOR AND COPYRIGHT OWNER "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE LICENSOR OR COPYRIGHT
+ * OWNER BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+ * OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Detection post-processing: box decoding and non-maximum suppression.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/objlist.h"
+#include "py/objtuple.h"
+
+#include "imlib_config.h"
+
+#if MICROPY_PY_ML
+#include "py_ml.h"
+#include "ulab/code/ndarray.h"
+
+#define PY_ML_NMS_BOX_CX        (0)
+#define PY_ML_NMS_BOX_CY        (1)
+#define PY_ML_NMS_BOX_CW        (2)
+#define PY_ML_NMS_BOX_CH        (3)
+#define PY_ML_NMS_YOLO_V5_SCORE (4)
+#define PY_ML_NMS_YOLO_V5_CLASS (5)
+#define PY_ML_NMS_YOLO_V8_CLASS (4)
+#define PY_ML_NMS_ANCHORS_KP    (4)
+
+typedef struct py_ml_nms_box {
+    int x, y, w, h;
+    float score;
+    int label;
+    mp_obj_t keypoints;     // Caller keypoints (ndarray), or MP_OBJ_NULL.
+    size_t kp_index;        // Offset of decoded keypoints in the keypoint pool.
+    size_t kp_count;        // Number of decoded (x, y) keypoints.
+} py_ml_nms_box_t;
+
+typedef struct py_ml_nms_obj {
+    mp_obj_base_t base;
+    int window_w;
+    int window_h;
+    int roi[4];
+    size_t boxes_len;
+    size_t boxes_max;
+    py_ml_nms_box_t *boxes;
+    size_t kp_len;
+    size_t kp_max;
+    float *kp;
+} py_ml_nms_obj_t;
+
+// A raw (quantized) output tensor viewed as a 2D (rows, cols) array.
+typedef struct py_ml_nms_tensor {
+    const void *data;
+    int dtype;
+    float scale;
+    float zero_point;
+    size_t rows;
+    size_t cols;
+} py_ml_nms_tensor_t;
+
+typedef struct py_ml_nms_sort {
+    float score;
+    size_t index;
+} py_ml_nms_sort_t;
+
+// Returns the model, or NULL if the source is a list of output ndarrays.
+static py_ml_model_obj_t *py_ml_nms_get_model(mp_obj_t arg) {
+    mp_obj_t native = mp_obj_cast_to_native_base(arg, MP_OBJ_FROM_PTR(&py_ml_model_type));
+    if (native != MP_OBJ_NULL) {
+        return MP_OBJ_TO_PTR(native);
+    }
+    if (!MP_OBJ_IS_TYPE(arg, &mp_type_list) && !MP_OBJ_IS_TYPE(arg, &mp_type_tuple)) {
+        mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Expected a Model or a list of ndarrays"));
+    }
+    return NULL;
+}
+
+// Output ndarrays are already dequantized and are read as float tensors.
+static void py_ml_nms_get_ndarray(mp_obj_t arg, mp_int_t index, py_ml_nms_tensor_t *t) {
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_get_array(arg, &len, &items);
+
+    if (index < 0 || (size_t) index >= len) {
+        mp_raise_msg(&mp_type_IndexError, MP_ERROR_TEXT("Invalid output index"));
+    }
+
+    if (!MP_OBJ_IS_TYPE(items[index], &ulab_ndarray_type)) {
+        mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Expected a ndarray"));
+    }
+
+    ndarray_obj_t *array = MP_OBJ_TO_PTR(items[index]);
+
+    if (array->dtype != NDARRAY_FLOAT || !ndarray_is_dense(array) || !array->len) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected a dense ndarray with dtype float"));
+    }
+
+    t->data = array->array;
+    t->dtype = 'f';
+    t->scale = 1.0f;
+    t->zero_point = 0.0f;
+    t->cols = array->shape[ULAB_MAX_DIMS - 1];
+    t->rows = array->len / t->cols;
+}
+
+static void py_ml_nms_get_tensor(mp_obj_t arg, mp_int_t index, py_ml_nms_tensor_t *t) {
+    py_ml_model_obj_t *model = py_ml_nms_get_model(arg);
+
+    if (!model) {
+        py_ml_nms_get_ndarray(arg, index, t);
+        return;
+    }
+
+    if (index < 0 || (size_t) index >= model->outputs_size) {
+        mp_raise_msg(&mp_type_IndexError, MP_ERROR_TEXT("Invalid output index"));
+    }
+
+    mp_obj_tuple_t *shape = MP_OBJ_TO_PTR(model->output_shape->items[index]);
+    if (shape->len < 1) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected tensor shape"));
+    }
+
+    t->data = ml_backend_get_output(model, index);
+    t->dtype = mp_obj_get_int(model->output_dtype->items[index]);
+    t->cols = mp_obj_get_int(shape->items[shape->len - 1]);
+    t->rows = 1;
+    for (size_t i = 0; i < shape->len - 1; i++) {
+        t->rows *= mp_obj_get_int(shape->items[i]);
+    }
+
+    if (t->dtype == 'f') {
+        t->scale = 1.0f;
+        t->zero_point = 0.0f;
+    } else {
+        t->scale = mp_obj_get_float_to_f(model->output_scale->items[index]);
+        t->zero_point = mp_obj_get_int(model->output_zero_point->items[index]);
+    }
+}
+
+static inline float py_ml_nms_raw(const py_ml_nms_tensor_t *t, size_t i) {
+    switch (t->dtype) {
+        case 'b':
+            return ((const int8_t *) t->data)[i];
+        case 'B':
+            return ((const uint8_t *) t->data)[i];
+        case 'h':
+            return ((const int16_t *) t->data)[i];
+        case 'H':
+            return ((const uint16_t *) t->data)[i];
+        default:
+            return ((const float *) t->data)[i];
+    }
+}
+
+static inline float py_ml_nms_dequantize(const py_ml_nms_tensor_t *t, float raw) {
+    return (raw - t->zero_point) * t->scale;
+}
+
+static inline float py_ml_nms_quantize(const py_ml_nms_tensor_t *t, float value) {
+    return (value / t->scale) + t->zero_point;
+}
+
+// Compares raw scores against a quantized threshold. A negative scale flips the order.
+static inline bool py_ml_nms_above(const py_ml_nms_tensor_t *t, float raw, float q_threshold) {
+    return (t->scale > 0.0f) ? (raw > q_threshold) : (raw < q_threshold);
+}
+
+// Returns the model input (width, height) used to scale normalized boxes. Without
+// a model the window size is used, which is the model input size in the post-processors.
+static void py_ml_nms_get_input_size(py_ml_nms_obj_t *self, mp_obj_t arg, float *iw, float *ih) {
+    py_ml_model_obj_t *model = py_ml_nms_get_model(arg);
+
+    if (!model) {
+        *iw = self->window_w;
+        *ih = self->window_h;
+        return;
+    }
+
+    mp_obj_tuple_t *shape = MP_OBJ_TO_PTR(model->input_shape->items[0]);
+    if (shape->len != 4) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected tensor shape"));
+    }
+    *ih = mp_obj_get_int(shape->items[1]);
+    *iw = mp_obj_get_int(shape->items[2]);
+}
+
+static void py_ml_nms_add(py_ml_nms_obj_t *self, float xmin, float ymin, float xmax, float ymax,
+                          float score, int label, mp_obj_t keypoints, const float *kp, size_t kp_count) {
+    if (!(score >= 0.0f && score <= 1.0f)) {
+        return;
+    }
+
+    xmin = fmaxf(0.0f, fminf(xmin, self->window_w));
+    ymin = fmaxf(0.0f, fminf(ymin, self->window_h));
+    xmax = fmaxf(0.0f, fminf(xmax, self->window_w));
+    ymax = fmaxf(0.0f, fminf(ymax, self->window_h));
+
+    int w = (int) (xmax - xmin);
+    int h = (int) (ymax - ymin);
+
+    if (w <= 0 || h <= 0) {
+        return;
+    }
+
+    if (self->boxes_len == self->boxes_max) {
+        size_t boxes_max = self->boxes_max ? (self->boxes_max * 2) : 16;
+        self->boxes = m_renew(py_ml_nms_box_t, self->boxes, self->boxes_max, boxes_max);
+        self->boxes_max = boxes_max;
+    }
+
+    if (kp_count && ((self->kp_len + (kp_count * 2)) > self->kp_max)) {
+        size_t kp_max = MAX(self->kp_max * 2, self->kp_len + (kp_count * 2));
+        self->kp = m_renew(float, self->kp, self->kp_max, kp_max);
+        self->kp_max = kp_max;
+    }
+
+    py_ml_nms_box_t *box = &self->boxes[self->boxes_len++];
+    box->x = (int) xmin;
+    box->y = (int) ymin;
+    box->w = w;
+    box->h = h;
+    box->score = score;
+    box->label = label;
+    box->keypoints = keypoints;
+    box->kp_index = self->kp_len;
+    box->kp_count = kp_count;
+
+    if (kp_count) {
+        memcpy(self->kp + self->kp_len, kp, kp_count * 2 * sizeof(float));
+        self->kp_len += kp_count * 2;
+    }
+}
+
+// Adds a box given its normalized center and size, scaled to the model input.
+static void py_ml_nms_add_normalized(py_ml_nms_obj_t *self, float iw, float ih, float cx, float cy,
+                                     float cw, float ch, float score, int label) {
+    float w_rel = cw * 0.5f;
+    float h_rel = ch * 0.5f;
+    py_ml_nms_add(self, (cx - w_rel) * iw, (cy - h_rel) * ih, (cx + w_rel) * iw, (cy + h_rel) * ih,
+                  score, label, MP_OBJ_NULL, NULL, 0);
+}
+
+mp_obj_t py_ml_nms_make_new(const mp_obj_type_t *type, size_t n_args, size_t n_kw, const mp_obj_t *all_args) {
+    enum { ARG_window_w, ARG_window_h, ARG_roi };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_window_w, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_window_h, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_roi, MP_ARG_REQUIRED | MP_ARG_OBJ },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all_kw_array(n_args, n_kw, all_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    mp_obj_t *roi;
+    mp_obj_get_array_fixed_n(args[ARG_roi].u_obj, 4, &roi);
+
+    py_ml_nms_obj_t *self = mp_obj_malloc(py_ml_nms_obj_t, type);
+    self->window_w = args[ARG_window_w].u_int;
+    self->window_h = args[ARG_window_h].u_int;
+
+    for (size_t i = 0; i < 4; i++) {
+        self->roi[i] = mp_obj_get_int(roi[i]);
+    }
+
+    if (self->roi[2] < 1 || self->roi[3] < 1) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid ROI dimensions!"));
+    }
+
+    if (self->window_w < 1 || self->window_h < 1) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid window dimensions!"));
+    }
+
+    self->boxes_len = 0;
+    self->boxes_max = 0;
+    self->boxes = NULL;
+    self->kp_len = 0;
+    self->kp_max = 0;
+    self->kp = NULL;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+static mp_obj_t py_ml_nms_add_bounding_box(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_xmin, ARG_ymin, ARG_xmax, ARG_ymax, ARG_score, ARG_label_index, ARG_keypoints };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_xmin, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_ymin, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_xmax, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_ymax, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_score, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_label_index, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_keypoints, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_nms_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_obj_t keypoints = args[ARG_keypoints].u_obj;
+    int label = mp_obj_get_int(args[ARG_label_index].u_obj);
+
+    if (label < 0) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid label index"));
+    }
+
+    if (keypoints == mp_const_none) {
+        keypoints = MP_OBJ_NULL;
+    } else {
+        // Keypoints are mapped to the input image in place, so they must be a (N, >= 2) float array.
+        ndarray_obj_t *array = MP_OBJ_IS_TYPE(keypoints, &ulab_ndarray_type) ? MP_OBJ_TO_PTR(keypoints) : NULL;
+        if (!array || array->dtype != NDARRAY_FLOAT || array->ndim != 2 || array->shape[ULAB_MAX_DIMS - 1] < 2) {
+            mp_raise_msg(&mp_type_TypeError, MP_ERROR_TEXT("Expected keypoints to be a float ndarray of shape (N, 2)"));
+        }
+    }
+
+    py_ml_nms_add(self,
+                  mp_obj_get_float_to_f(args[ARG_xmin].u_obj),
+                  mp_obj_get_float_to_f(args[ARG_ymin].u_obj),
+                  mp_obj_get_float_to_f(args[ARG_xmax].u_obj),
+                  mp_obj_get_float_to_f(args[ARG_ymax].u_obj),
+                  mp_obj_get_float_to_f(args[ARG_score].u_obj),
+                  label, keypoints, NULL, 0);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_ml_nms_add_bounding_box_obj, 6, py_ml_nms_add_bounding_box);
+
+// YOLOv5: (rows, 5 + classes) with an objectness score per row.
+static mp_obj_t py_ml_nms_add_yolov5(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_model, ARG_threshold, ARG_index };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_model, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_threshold, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_index, MP_ARG_INT, {.u_int = 0 } },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_nms_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_obj_t model = args[ARG_model].u_obj;
+
+    float iw, ih;
+    py_ml_nms_tensor_t t;
+    py_ml_nms_get_input_size(self, model, &iw, &ih);
+    py_ml_nms_get_tensor(model, args[ARG_index].u_int, &t);
+
+    if (t.cols <= PY_ML_NMS_YOLO_V5_CLASS) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected tensor shape"));
+    }
+
+    float q_threshold = py_ml_nms_quantize(&t, mp_obj_get_float_to_f(args[ARG_threshold].u_obj));
+
+    for (size_t i = 0, row = 0; i < t.rows; i++, row += t.cols) {
+        float raw = py_ml_nms_raw(&t, row + PY_ML_NMS_YOLO_V5_SCORE);
+        if (!py_ml_nms_above(&t, raw, q_threshold)) {
+            continue;
+        }
+
+        int label = 0;
+        float label_score = py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + PY_ML_NMS_YOLO_V5_CLASS));
+        for (size_t j = PY_ML_NMS_YOLO_V5_CLASS + 1; j < t.cols; j++) {
+            float v = py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + j));
+            if (v > label_score) {
+                label_score = v;
+                label = j - PY_ML_NMS_YOLO_V5_CLASS;
+            }
+        }
+
+        py_ml_nms_add_normalized(self, iw, ih,
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + PY_ML_NMS_BOX_CX)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + PY_ML_NMS_BOX_CY)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + PY_ML_NMS_BOX_CW)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, row + PY_ML_NMS_BOX_CH)),
+                                 py_ml_nms_dequantize(&t, raw), label);
+    }
+
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_ml_nms_add_yolov5_obj, 3, py_ml_nms_add_yolov5);
+
+// Running per-anchor best class score over one row of the transposed YOLOv8 output.
+#define PY_ML_NMS_YOLO_V8_SCAN(type, op)                         \
+    do {                                                         \
+        const type *row = ((const type *) t.data) + (k * t.cols); \
+        for (size_t n = 0; n < t.cols; n++) {                    \
+            if (row[n] op best[n]) {                             \
+                best[n] = row[n];                                \
+                best_k[n] = k;                                   \
+            }                                                    \
+        }                                                        \
+    } while (0)
+
+// YOLOv8: (4 + classes, anchors), i.e. anchors are stored in columns.
+static mp_obj_t py_ml_nms_add_yolov8(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_model, ARG_threshold, ARG_index };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_model, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_threshold, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_index, MP_ARG_INT, {.u_int = 0 } },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_nms_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_obj_t model = args[ARG_model].u_obj;
+
+    float iw, ih;
+    py_ml_nms_tensor_t t;
+    py_ml_nms_get_input_size(self, model, &iw, &ih);
+    py_ml_nms_get_tensor(model, args[ARG_index].u_int, &t);
+
+    if (t.rows <= PY_ML_NMS_YOLO_V8_CLASS) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected tensor shape"));
+    }
+
+    float q_threshold = py_ml_nms_quantize(&t, mp_obj_get_float_to_f(args[ARG_threshold].u_obj));
+
+    // Scan the class rows once, in memory order, keeping the best raw score per anchor.
+    // With a negative scale the largest dequantized score is the smallest raw value.
+    float *best = m_new(float, t.cols);
+    uint16_t *best_k = m_new(uint16_t, t.cols);
+
+    for (size_t n = 0; n < t.cols; n++) {
+        best[n] = py_ml_nms_raw(&t, (PY_ML_NMS_YOLO_V8_CLASS * t.cols) + n);
+        best_k[n] = PY_ML_NMS_YOLO_V8_CLASS;
+    }
+
+    bool max = t.scale > 0.0f;
+    for (size_t k = PY_ML_NMS_YOLO_V8_CLASS + 1; k < t.rows; k++) {
+        switch (t.dtype) {
+            case 'b':
+                if (max) {
+                    PY_ML_NMS_YOLO_V8_SCAN(int8_t, >);
+                } else {
+                    PY_ML_NMS_YOLO_V8_SCAN(int8_t, <);
+                }
+                break;
+            case 'B':
+                if (max) {
+                    PY_ML_NMS_YOLO_V8_SCAN(uint8_t, >);
+                } else {
+                    PY_ML_NMS_YOLO_V8_SCAN(uint8_t, <);
+                }
+                break;
+            case 'h':
+                if (max) {
+                    PY_ML_NMS_YOLO_V8_SCAN(int16_t, >);
+                } else {
+                    PY_ML_NMS_YOLO_V8_SCAN(int16_t, <);
+                }
+                break;
+            case 'H':
+                if (max) {
+                    PY_ML_NMS_YOLO_V8_SCAN(uint16_t, >);
+                } else {
+                    PY_ML_NMS_YOLO_V8_SCAN(uint16_t, <);
+                }
+                break;
+            default:
+                PY_ML_NMS_YOLO_V8_SCAN(float, >);
+                break;
+        }
+    }
+
+    for (size_t n = 0; n < t.cols; n++) {
+        if (!py_ml_nms_above(&t, best[n], q_threshold)) {
+            continue;
+        }
+
+        py_ml_nms_add_normalized(self, iw, ih,
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, (PY_ML_NMS_BOX_CX * t.cols) + n)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, (PY_ML_NMS_BOX_CY * t.cols) + n)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, (PY_ML_NMS_BOX_CW * t.cols) + n)),
+                                 py_ml_nms_dequantize(&t, py_ml_nms_raw(&t, (PY_ML_NMS_BOX_CH * t.cols) + n)),
+                                 py_ml_nms_dequantize(&t, best[n]), best_k[n] - PY_ML_NMS_YOLO_V8_CLASS);
+    }
+
+    m_del(float, best, t.cols);
+    m_del(uint16_t, best_k, t.cols);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_ml_nms_add_yolov8_obj, 3, py_ml_nms_add_yolov8);
+
+// SSD/MediaPipe: logit scores in one tensor, anchor relative boxes (+ keypoints) in another.
+static mp_obj_t py_ml_nms_add_anchors(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_model, ARG_scores, ARG_cords, ARG_anchors, ARG_threshold, ARG_offset, ARG_label_index };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_model, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_scores, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_cords, MP_ARG_REQUIRED | MP_ARG_INT },
+        { MP_QSTR_anchors, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_threshold, MP_ARG_REQUIRED | MP_ARG_OBJ },
+        { MP_QSTR_offset, MP_ARG_INT, {.u_int = 0 } },
+        { MP_QSTR_label_index, MP_ARG_INT, {.u_int = 0 } },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_nms_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    mp_obj_t model = args[ARG_model].u_obj;
+
+    if (args[ARG_label_index].u_int < 0) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid label index"));
+    }
+
+    float iw, ih;
+    py_ml_nms_tensor_t s, c;
+    py_ml_nms_get_input_size(self, model, &iw, &ih);
+    py_ml_nms_get_tensor(model, args[ARG_scores].u_int, &s);
+    py_ml_nms_get_tensor(model, args[ARG_cords].u_int, &c);
+
+    size_t count = s.rows * s.cols;
+    size_t kp_count = (c.cols - PY_ML_NMS_ANCHORS_KP) / 2;
+
+    if (c.cols < PY_ML_NMS_ANCHORS_KP || c.rows != count) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unexpected tensor shape"));
+    }
+
+    // Anchors are (N, 2) centers, or (N, 4) centers and sizes. Like MediaPipe's SSD decoder,
+    // the sizes scale the box and keypoint offsets, (N, 2) anchors have a size of 1.
+    ndarray_obj_t *anchors = MP_OBJ_IS_TYPE(args[ARG_anchors].u_obj, &ulab_ndarray_type) ?
+                             MP_OBJ_TO_PTR(args[ARG_anchors].u_obj) : NULL;
+    size_t anchors_w = anchors ? anchors->shape[ULAB_MAX_DIMS - 1] : 0;
+    mp_int_t offset = args[ARG_offset].u_int;
+
+    if (!anchors || anchors->ndim != 2 || (anchors_w != 2 && anchors_w != 4)) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Expected anchors to be an ndarray of shape (N, 2) or (N, 4)"));
+    }
+
+    if (offset < 0 || ((size_t) offset + count) > anchors->shape[ULAB_MAX_DIMS - 2]) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Not enough anchors"));
+    }
+
+    // Scores are logits, so compare against the threshold in logit space and only apply the
+    // sigmoid to the boxes that pass.
+    float threshold = mp_obj_get_float_to_f(args[ARG_threshold].u_obj);
+    float q_threshold = py_ml_nms_quantize(&s, logf(threshold / (1.0f - threshold)));
+    int32_t a_row_stride = anchors->strides[ULAB_MAX_DIMS - 2];
+    int32_t a_col_stride = anchors->strides[ULAB_MAX_DIMS - 1];
+    float *kp = m_new(float, kp_count * 2);
+
+    for (size_t i = 0; i < count; i++) {
+        float raw = py_ml_nms_raw(&s, i);
+        if (!py_ml_nms_above(&s, raw, q_threshold)) {
+            continue;
+        }
+
+        uint8_t *a = ((uint8_t *) anchors->array) + ((offset + i) * a_row_stride);
+        float ax = ndarray_get_float_value(a, anchors->dtype);
+        float ay = ndarray_get_float_value(a + a_col_stride, anchors->dtype);
+        float aw = 1.0f, ah = 1.0f;
+        if (anchors_w == 4) {
+            aw = ndarray_get_float_value(a + (a_col_stride * 2), anchors->dtype);
+            ah = ndarray_get_float_value(a + (a_col_stride * 3), anchors->dtype);
+            if (!(aw > 0.0f) || !(ah > 0.0f)) {
+                mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid anchor size"));
+            }
+        }
+
+        size_t row = i * c.cols;
+        float x_center = (py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_BOX_CX)) / iw) * aw + ax;
+        float y_center = (py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_BOX_CY)) / ih) * ah + ay;
+        float w_rel = (py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_BOX_CW)) / iw) * aw * 0.5f;
+        float h_rel = (py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_BOX_CH)) / ih) * ah * 0.5f;
+
+        for (size_t j = 0; j < kp_count; j++) {
+            float kx = py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_ANCHORS_KP + (j * 2)));
+            float ky = py_ml_nms_dequantize(&c, py_ml_nms_raw(&c, row + PY_ML_NMS_ANCHORS_KP + (j * 2) + 1));
+            kp[(j * 2) + 0] = ((kx / iw) * aw + ax) * iw;
+            kp[(j * 2) + 1] = ((ky / ih) * ah + ay) * ih;
+        }
+
+        float score = 1.0f / (1.0f + expf(-py_ml_nms_dequantize(&s, raw)));
+
+        py_ml_nms_add(self, (x_center - w_rel) * iw, (y_center - h_rel) * ih,
+                      (x_center + w_rel) * iw, (y_center + h_rel) * ih,
+                      score, args[ARG_label_index].u_int, MP_OBJ_NULL, kp, kp_count);
+    }
+
+    m_del(float, kp, kp_count * 2);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_ml_nms_add_anchors_obj, 6, py_ml_nms_add_anchors);
+
+static int py_ml_nms_sort_compare(const void *a, const void *b) {
+    const py_ml_nms_sort_t *sa = a;
+    const py_ml_nms_sort_t *sb = b;
+    if (sa->score != sb->score) {
+        return (sa->score > sb->score) ? -1 : 1;
+    }
+    // Keep insertion order for equal scores (stable sort).
+    return (sa->index < sb->index) ? -1 : (sa->index > sb->index);
+}
+
+static float py_ml_nms_iou(const py_ml_nms_box_t *a, const py_ml_nms_box_t *b) {
+    int x1 = MAX(a->x, b->x);
+    int y1 = MAX(a->y, b->y);
+    int x2 = MIN(a->x + a->w, b->x + b->w);
+    int y2 = MIN(a->y + a->h, b->y + b->h);
+    int intersection = MAX(0, x2 - x1) * MAX(0, y2 - y1);
+    int union_ = (a->w * a->h) + (b->w * b->h) - intersection;
+    return (float) intersection / (float) union_;
+}
+
+static mp_obj_t py_ml_nms_get_bounding_boxes(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_threshold, ARG_sigma, ARG_iou_threshold, ARG_per_class };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_threshold, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_sigma, MP_ARG_OBJ, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_iou_threshold, MP_ARG_OBJ | MP_ARG_KW_ONLY, {.u_rom_obj = MP_ROM_NONE} },
+        { MP_QSTR_per_class, MP_ARG_BOOL | MP_ARG_KW_ONLY, {.u_bool = false} },
+    };
+
+    // Parse args.
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args - 1, pos_args + 1, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    py_ml_nms_obj_t *self = MP_OBJ_TO_PTR(pos_args[0]);
+    float threshold = (args[ARG_threshold].u_obj == mp_const_none) ?
+                      0.1f : mp_obj_get_float_to_f(args[ARG_threshold].u_obj);
+    float sigma = (args[ARG_sigma].u_obj == mp_const_none) ?
+                  0.1f : mp_obj_get_float_to_f(args[ARG_sigma].u_obj);
+    float sigma_scale = (sigma > 0.0f) ? (-1.0f / sigma) : 0.0f;
+    bool greedy = args[ARG_iou_threshold].u_obj != mp_const_none;
+    float iou_threshold = greedy ? mp_obj_get_float_to_f(args[ARG_iou_threshold].u_obj) : 0.0f;
+    bool per_class = args[ARG_per_class].u_bool;
+
+    // Sort boxes by score (descending) and keep the box indices in that order.
+    size_t n = self->boxes_len;
+    py_ml_nms_sort_t *sorted = m_new(py_ml_nms_sort_t, n);
+    size_t *order = m_new(size_t, n);
+    size_t *output = m_new(size_t, n);
+    size_t output_len = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        sorted[i].score = self->boxes[i].score;
+        sorted[i].index = i;
+    }
+
+    qsort(sorted, n, sizeof(py_ml_nms_sort_t), py_ml_nms_sort_compare);
+
+    for (size_t i = 0; i < n; i++) {
+        order[i] = sorted[i].index;
+    }
+
+    m_del(py_ml_nms_sort_t, sorted, n);
+
+    // Perform (soft) non-maximum suppression. The order of the remaining boxes is preserved
+    // so that ties resolve the same way as a sorted list scan.
+    size_t max_index = 0;
+    int max_label = 0;
+
+    while (n) {
+        py_ml_nms_box_t *box = &self->boxes[order[max_index]];
+        output[output_len++] = order[max_index];
+        max_label = MAX(max_label, box->label);
+
+        size_t pop_index = max_index;
+        size_t len = 0;
+        float max_score = 0.0f;
+        for (size_t i = 0; i < n; i++) {
+            if (i == pop_index) {
+                continue;
+            }
+
+            py_ml_nms_box_t *other = &self->boxes[order[i]];
+
+            if (!per_class || other->label == box->label) {
+                float v = py_ml_nms_iou(box, other);
+                if (greedy) {
+                    if (v > iou_threshold) {
+                        other->score = 0.0f;
+                    }
+                } else {
+                    other->score *= expf(sigma_scale * v * v);
+                }
+            }
+
+            if (other->score < threshold) {
+                other->score = 0.0f;
+            }
+
+            // Filter out suppressed boxes and find the next largest.
+            if (other->score > 0.0f) {
+                if (!len || other->score > max_score) {
+                    max_score = other->score;
+                    max_index = len;
+                }
+                order[len++] = order[i];
+            }
+        }
+
+        n = len;
+    }
+
+    // Map the output boxes back to the input image.
+    float x_scale = self->roi[2] / (float) self->window_w;
+    float y_scale = self->roi[3] / (float) self->window_h;
+    float x_offset = ((self->roi[2] - (self->window_w * x_scale)) / 2) + self->roi[0];
+    float y_offset = ((self->roi[3] - (self->window_h * y_scale)) / 2) + self->roi[1];
+
+    // Create a list per class with (rect, score[, keypoints]) tuples.
+    mp_obj_list_t *output_list = MP_OBJ_TO_PTR(mp_obj_new_list(max_label + 1, NULL));
+    for (size_t i = 0; i < output_list->len; i++) {
+        output_list->items[i] = mp_obj_new_list(0, NULL);
+    }
+
+    for (size_t i = 0; i < output_len; i++) {
+        py_ml_nms_box_t *box = &self->boxes[output[i]];
+        mp_obj_t rect[4] = {
+            mp_obj_new_int((int) ((box->x * x_scale) + x_offset)),
+            mp_obj_new_int((int) ((box->y * y_scale) + y_offset)),
+            mp_obj_new_int((int) (box->w * x_scale)),
+            mp_obj_new_int((int) (box->h * y_scale)),
+        };
+
+        mp_obj_t keypoints = box->keypoints;
+
+        if (keypoints != MP_OBJ_NULL) {
+            ndarray_obj_t *array = MP_OBJ_TO_PTR(keypoints);
+            uint8_t *row = array->array;
+            for (size_t j = 0; j < array->shape[ULAB_MAX_DIMS - 2]; j++, row += array->strides[ULAB_MAX_DIMS - 2]) {
+                mp_float_t *kx = (mp_float_t *) row;
+                mp_float_t *ky = (mp_float_t *) (row + array->strides[ULAB_MAX_DIMS - 1]);
+                *kx = (*kx * x_scale) + x_offset;
+                *ky = (*ky * y_scale) + y_offset;
+            }
+        } else if (box->kp_count) {
+            size_t shape[ULAB_MAX_DIMS] = {};
+            shape[ULAB_MAX_DIMS - 2] = box->kp_count;
+            shape[ULAB_MAX_DIMS - 1] = 2;
+            ndarray_obj_t *array = ndarray_new_dense_ndarray(2, shape, NDARRAY_FLOAT);
+            mp_float_t *kp = (mp_float_t *) array->array;
+            for (size_t j = 0; j < box->kp_count; j++) {
+                kp[(j * 2) + 0] = (self->kp[box->kp_index + (j * 2) + 0] * x_scale) + x_offset;
+                kp[(j * 2) + 1] = (self->kp[box->kp_index + (j * 2) + 1] * y_scale) + y_offset;
+            }
+            keypoints = MP_OBJ_FROM_PTR(array);
+        }
+
+        mp_obj_t rect_score[3] = {
+            mp_obj_new_list(4, rect),
+            mp_obj_new_float(box->score),
+            keypoints,
+        };
+
+        mp_obj_list_append(output_list->items[box->label],
+                           mp_obj_new_tuple((keypoints != MP_OBJ_NULL) ? 3 : 2, rect_score));
+    }
+
+    m_del(size_t, order, self->boxes_len);
+    m_del(size_t, output, self->boxes_len);
+
+    // Boxes are consumed by NMS.
+    self->boxes_len = 0;
+    self->kp_len = 0;
+    return MP_OBJ_FROM_PTR(output_list);
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_ml_nms_get_bounding_boxes_obj, 1, py_ml_nms_get_bounding_boxes);
+
+static const mp_rom_map_elem_t py_ml_nms_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_add_bounding_box),    MP_ROM_PTR(&py_ml_nms_add_bounding_box_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_yolov5),          MP_ROM_PTR(&py_ml_nms_add_yolov5_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_yolov8),          MP_ROM_PTR(&py_ml_nms_add_yolov8_obj) },
+    { MP_ROM_QSTR(MP_QSTR_add_anchors),         MP_ROM_PTR(&py_ml_nms_add_anchors_obj) },
+    { MP_ROM_QSTR(MP_QSTR_get_bounding_boxes),  MP_ROM_PTR(&py_ml_nms_get_bounding_boxes_obj) },
+};
+
+static MP_DEFINE_CONST_DICT(py_ml_nms_locals_dict, py_ml_nms_locals_dict_table);
+
+MP_DEFINE_CONST_OBJ_TYPE(
+    py_ml_nms_type,
+    MP_QSTR_NMS,
+    MP_TYPE_FLAG_NONE,
+    make_new, py_ml_nms_make_new,
+    locals_dict, &py_ml_nms_locals_dict
+    );
+#endif // MICROPY_PY_ML
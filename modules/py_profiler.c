@@ -0,0 +1,149 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Profiler Python module.
+ */
+#if OMV_TRACE_ENABLE || OMV_SAMPLER_ENABLE
+#include "py/obj.h"
+#include "py/runtime.h"
+#include "omv_sampler.h"
+#include "trace.h"
+
+#if OMV_TRACE_ENABLE
+static mp_obj_t py_profiler_trace(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_name, ARG_type, ARG_value };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_name, MP_ARG_REQUIRED | MP_ARG_OBJ, {.u_obj = MP_OBJ_NULL} },
+        { MP_QSTR_type, MP_ARG_INT, {.u_int = OMV_TRACE_TYPE_INSTANT} },
+        { MP_QSTR_value, MP_ARG_INT, {.u_int = 0} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_type].u_int <= OMV_TRACE_TYPE_NONE || args[ARG_type].u_int > OMV_TRACE_TYPE_COUNTER) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Invalid event type"));
+    }
+
+    // Only the firmware's static qstrs have fixed pointers, the memory of any other
+    // string can be reused (even interned ones after a soft reset).
+    mp_obj_t name_obj = args[ARG_name].u_obj;
+    const char *name = mp_obj_str_get_str(name_obj);
+    bool is_static = mp_obj_is_qstr(name_obj) && (MP_OBJ_QSTR_VALUE(name_obj) < MP_QSTRnumber_of);
+    uint8_t id = is_static ? omv_trace_name(name) : omv_trace_name_str(name);
+    omv_trace_record(args[ARG_type].u_int, id, args[ARG_value].u_int);
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_profiler_trace_obj, 1, py_profiler_trace);
+
+static mp_obj_t py_profiler_count(void) {
+    return mp_obj_new_int(omv_trace_get_count());
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(py_profiler_count_obj, py_profiler_count);
+#endif // OMV_TRACE_ENABLE
+
+#if OMV_SAMPLER_ENABLE
+static mp_obj_t py_profiler_sample_start(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum { ARG_rate, ARG_lr };
+    static const mp_arg_t allowed_args[] = {
+        { MP_QSTR_rate, MP_ARG_INT, {.u_int = OMV_SAMPLER_RATE_HZ} },
+        { MP_QSTR_lr, MP_ARG_KW_ONLY | MP_ARG_BOOL, {.u_bool = false} },
+    };
+
+    mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
+    mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
+
+    if (args[ARG_rate].u_int <= 0) {
+        mp_raise_ValueError(MP_ERROR_TEXT("Invalid sampling rate"));
+    }
+
+    if (omv_sampler_start(args[ARG_rate].u_int, args[ARG_lr].u_bool) != 0) {
+        mp_raise_msg(&mp_type_RuntimeError, MP_ERROR_TEXT("Sampling is not supported"));
+    }
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_KW(py_profiler_sample_start_obj, 0, py_profiler_sample_start);
+
+static mp_obj_t py_profiler_sample_stop(void) {
+    omv_sampler_stop();
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(py_profiler_sample_stop_obj, py_profiler_sample_stop);
+
+static mp_obj_t py_profiler_samples(void) {
+    // Records are only appended while sampling, so the first count records are stable.
+    size_t count = omv_sampler_get_size() / sizeof(omv_sampler_record_t);
+    const omv_sampler_record_t *records = omv_sampler_get_data();
+    mp_obj_t list = mp_obj_new_list(count, NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        mp_obj_t tuple[3] = {
+            mp_obj_new_int_from_uint(records[i].pc),
+            mp_obj_new_int_from_uint(records[i].lr),
+            mp_obj_new_int_from_uint(records[i].count),
+        };
+        ((mp_obj_list_t *) MP_OBJ_TO_PTR(list))->items[i] = mp_obj_new_tuple(3, tuple);
+    }
+    return list;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(py_profiler_samples_obj, py_profiler_samples);
+#endif // OMV_SAMPLER_ENABLE
+
+static mp_obj_t py_profiler_reset(void) {
+    #if OMV_TRACE_ENABLE
+    omv_trace_reset();
+    #endif
+    #if OMV_SAMPLER_ENABLE
+    omv_sampler_reset();
+    #endif
+    return mp_const_none;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(py_profiler_reset_obj, py_profiler_reset);
+
+static const mp_rom_map_elem_t globals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__),   MP_OBJ_NEW_QSTR(MP_QSTR_profiler) },
+    { MP_ROM_QSTR(MP_QSTR_reset),      MP_ROM_PTR(&py_profiler_reset_obj) },
+    #if OMV_TRACE_ENABLE
+    { MP_ROM_QSTR(MP_QSTR_trace),      MP_ROM_PTR(&py_profiler_trace_obj) },
+    { MP_ROM_QSTR(MP_QSTR_count),      MP_ROM_PTR(&py_profiler_count_obj) },
+    { MP_ROM_QSTR(MP_QSTR_BEGIN),      MP_ROM_INT(OMV_TRACE_TYPE_BEGIN) },
+    { MP_ROM_QSTR(MP_QSTR_END),        MP_ROM_INT(OMV_TRACE_TYPE_END) },
+    { MP_ROM_QSTR(MP_QSTR_INSTANT),    MP_ROM_INT(OMV_TRACE_TYPE_INSTANT) },
+    { MP_ROM_QSTR(MP_QSTR_COUNTER),    MP_ROM_INT(OMV_TRACE_TYPE_COUNTER) },
+    #endif
+    #if OMV_SAMPLER_ENABLE
+    { MP_ROM_QSTR(MP_QSTR_sample_start), MP_ROM_PTR(&py_profiler_sample_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sample_stop), MP_ROM_PTR(&py_profiler_sample_stop_obj) },
+    { MP_ROM_QSTR(MP_QSTR_samples),    MP_ROM_PTR(&py_profiler_samples_obj) },
+    #endif
+};
+
+static MP_DEFINE_CONST_DICT(globals_dict, globals_dict_table);
+
+const mp_obj_module_t profiler_module = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_t) &globals_dict,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_profiler, profiler_module);
+#endif // OMV_TRACE_ENABLE || OMV_SAMPLER_ENABLE
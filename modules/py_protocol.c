@@ -191,6 +191,29 @@ static int py_channel_write(const omv_protocol_channel_t *channel, uint32_t offs
     return 0; // Default success
 }
 
+// Writev delegate - passes all segments to Python in a single call, as a tuple of bytearrays
+static int py_channel_writev(const omv_protocol_channel_t *channel, const omv_protocol_iovec_t *iov, size_t iovcnt) {
+    mp_obj_t obj = MP_OBJ_FROM_PTR(channel->priv);
+    mp_obj_t items[iovcnt];
+
+    for (size_t i = 0; i < iovcnt; i++) {
+        items[i] = mp_obj_new_bytearray_by_ref(iov[i].size, (void *) iov[i].data);
+    }
+
+    mp_obj_t args[1] = { mp_obj_new_tuple(iovcnt, items) };
+
+    // Call the Python writev method
+    mp_obj_t result = py_channel_call(obj, MP_QSTR_writev, 1, args);
+
+    if (result == MP_OBJ_NULL) {
+        return -1; // Method not found or exception
+    } else if (mp_obj_is_int(result)) {
+        return mp_obj_get_int(result);
+    }
+
+    return 0; // Default success
+}
+
 // Readp delegate - calls Python readp method and returns pointer (dangerous but needed)
 static const void *py_channel_readp(const omv_protocol_channel_t *channel, uint32_t offset, size_t size) {
     mp_obj_t obj = MP_OBJ_FROM_PTR(channel->priv);
@@ -319,6 +342,10 @@ static MP_DEFINE_CONST_FUN_OBJ_0(py_protocol_is_active_obj, py_protocol_is_activ
 
 // Protocol init function
 static mp_obj_t py_protocol_init(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
+    enum {
+        ARG_crc, ARG_seq, ARG_ack, ARG_events, ARG_max_payload, ARG_rtx_retries,
+        ARG_rtx_timeout_ms, ARG_lock_interval_ms, ARG_poll_ms, ARG_window
+    };
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_crc, MP_ARG_BOOL, {.u_bool = true} },
         { MP_QSTR_seq, MP_ARG_BOOL, {.u_bool = true} },
@@ -329,22 +356,29 @@ static mp_obj_t py_protocol_init(size_t n_args, const mp_obj_t *pos_args, mp_map
         { MP_QSTR_rtx_timeout_ms, MP_ARG_INT, {.u_int = OMV_PROTOCOL_DEF_RTX_TIMEOUT_MS} },
         { MP_QSTR_lock_interval_ms, MP_ARG_INT, {.u_int = OMV_PROTOCOL_MIN_LOCK_INTERVAL_MS} },
         { MP_QSTR_poll_ms, MP_ARG_INT, {.u_int = 0} },
+        { MP_QSTR_window, MP_ARG_INT | MP_ARG_KW_ONLY, {.u_int = 1} },
     };
 
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
+    // Checked before it's narrowed to the config's uint8_t.
+    if (args[ARG_window].u_int < 1 || args[ARG_window].u_int > OMV_PROTOCOL_MAX_WINDOW) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid window size"));
+    }
+
     // Build configuration structure from arguments
     omv_protocol_config_t config = {
-        .crc_enabled = args[0].u_bool,
-        .seq_enabled = args[1].u_bool,
-        .ack_enabled = args[2].u_bool,
-        .event_enabled = args[3].u_bool,
-        .max_payload = args[4].u_int,
-        .rtx_retries = args[5].u_int,
-        .rtx_timeout_ms = args[6].u_int,
-        .lock_intval_ms = args[7].u_int,
-        .poll_ms = args[8].u_int,
+        .crc_enabled = args[ARG_crc].u_bool,
+        .seq_enabled = args[ARG_seq].u_bool,
+        .ack_enabled = args[ARG_ack].u_bool,
+        .event_enabled = args[ARG_events].u_bool,
+        .max_payload = args[ARG_max_payload].u_int,
+        .window = args[ARG_window].u_int,
+        .rtx_retries = args[ARG_rtx_retries].u_int,
+        .rtx_timeout_ms = args[ARG_rtx_timeout_ms].u_int,
+        .lock_intval_ms = args[ARG_lock_interval_ms].u_int,
+        .poll_ms = args[ARG_poll_ms].u_int,
     };
 
     if (omv_protocol_init(&config)) {
@@ -357,9 +391,14 @@ static mp_obj_t py_protocol_init(size_t n_args, const mp_obj_t *pos_args, mp_map
     omv_protocol_register_channel(&omv_stream_channel);
 
     // Register the profiler channel (if enabled)
-    #if OMV_PROFILER_ENABLE
+    #if OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
     omv_protocol_register_channel(&omv_profile_channel);
-    #endif // OMV_PROFILER_ENABLE
+    #endif // OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
+
+    // Register the loopback test channel (if enabled)
+    #if OMV_PROTOCOL_LOOPBACK_ENABLE
+    omv_protocol_register_channel(&omv_loopback_channel);
+    #endif // OMV_PROTOCOL_LOOPBACK_ENABLE
 
     return mp_const_none;
 }
@@ -401,6 +440,7 @@ static mp_obj_t py_protocol_register(size_t n_args, const mp_obj_t *pos_args, mp
     channel->flush = py_channel_has_method(backend, MP_QSTR_flush) ? py_channel_flush : NULL;
     channel->ioctl = py_channel_has_method(backend, MP_QSTR_ioctl) ? py_channel_ioctl : NULL;
     channel->is_active = py_channel_has_method(backend, MP_QSTR_is_active) ? py_channel_is_active : NULL;
+    channel->writev = py_channel_has_method(backend, MP_QSTR_writev) ? py_channel_writev : NULL;
 
     // Automatically set flags based on available methods
     if (channel->read || channel->readp) {
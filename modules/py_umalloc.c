@@ -58,6 +58,21 @@ static mp_obj_t py_umalloc_stats(size_t n_args, const mp_obj_t *args) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_umalloc_stats_obj, 0, 1, py_umalloc_stats);
 
+// Returns the pool peak and the scratch arena stats of the last frame.
+static mp_obj_t py_umalloc_frame_stats(size_t n_args, const mp_obj_t *args) {
+    int index = (n_args > 0) ? mp_obj_get_int(args[0]) : -1;
+    uma_stats_t s;
+    uma_get_stats(index, false, &s);
+    mp_obj_t tuple[4] = {
+        mp_obj_new_int(s.frame_peak_bytes),
+        mp_obj_new_int(s.scratch_bytes),
+        mp_obj_new_int(s.scratch_peak_bytes),
+        mp_obj_new_int(s.scratch_misses),
+    };
+    return mp_obj_new_tuple(4, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(py_umalloc_frame_stats_obj, 0, 1, py_umalloc_frame_stats);
+
 static mp_obj_t py_umalloc_print_stats(size_t n_args, const mp_obj_t *args) {
     int index = (n_args > 0) ? mp_obj_get_int(args[0]) : -1;
     uma_print_stats(index);
@@ -70,6 +85,7 @@ static const mp_rom_map_elem_t globals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_init),       MP_ROM_PTR(&py_umalloc_init_obj) },
     { MP_ROM_QSTR(MP_QSTR_collect),    MP_ROM_PTR(&py_umalloc_collect_obj) },
     { MP_ROM_QSTR(MP_QSTR_stats),      MP_ROM_PTR(&py_umalloc_stats_obj) },
+    { MP_ROM_QSTR(MP_QSTR_frame_stats), MP_ROM_PTR(&py_umalloc_frame_stats_obj) },
     { MP_ROM_QSTR(MP_QSTR_print_stats), MP_ROM_PTR(&py_umalloc_print_stats_obj) },
 };
 
@@ -0,0 +1,613 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2025-2026 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Imlib benchmarks.
+ */
+#include "imlib_config.h"
+
+#if MICROPY_PY_UNITTEST
+
+#include <math.h>
+#include <string.h>
+#include "py/runtime.h"
+#include "py/obj.h"
+#include "py/mphal.h"
+
+#include "imlib.h"
+#include "umalloc.h"
+#include "omv_cycles.h"
+#include "py_helper.h"
+
+typedef void (*bench_fn_t) (image_t *img);
+
+// Formats a kernel is benchmarked with.
+#define BENCH_GRAYSCALE     (1 << 0)
+#define BENCH_RGB565        (1 << 1)
+#define BENCH_BINARY        (1 << 2)
+#define BENCH_COLOR         (BENCH_GRAYSCALE | BENCH_RGB565)
+
+typedef struct {
+    const char *name;
+    uint32_t formats;
+    bench_fn_t fn;
+} bench_kernel_t;
+
+static const int bench_gauss_3[9] = {
+    1, 2, 1,
+    2, 4, 2,
+    1, 2, 1,
+};
+
+// Draws a deterministic frame: a noisy gradient with filled shapes on top.
+static void bench_frame_init(image_t *img) {
+    uint32_t seed = 0x12345678;
+    for (int y = 0; y < img->h; y++) {
+        for (int x = 0; x < img->w; x++) {
+            seed = (seed * 1103515245) + 12345;
+            int v = ((x + y) * 255 / (img->w + img->h)) + ((seed >> 16) & 0xF);
+            v = IM_MIN(v, COLOR_GRAYSCALE_MAX);
+            if (img->pixfmt == PIXFORMAT_BINARY) {
+                IMAGE_PUT_BINARY_PIXEL(img, x, y, v > 127);
+            } else if (img->pixfmt == PIXFORMAT_GRAYSCALE) {
+                IMAGE_PUT_GRAYSCALE_PIXEL(img, x, y, v);
+            } else {
+                IMAGE_PUT_RGB565_PIXEL(img, x, y, COLOR_R8_G8_B8_TO_RGB565(v, 255 - v, (v * 3) & 0xFF));
+            }
+        }
+    }
+
+    for (int i = 0; i < 16; i++) {
+        seed = (seed * 1103515245) + 12345;
+        int x = (seed >> 8) % img->w;
+        int y = (seed >> 20) % img->h;
+        int r = 4 + ((seed >> 4) % (img->w / 16));
+        int c = (i & 1) ? COLOR_R8_G8_B8_TO_RGB565(255, 0, 0) : COLOR_R8_G8_B8_TO_RGB565(0, 0, 255);
+        if (img->pixfmt == PIXFORMAT_BINARY) {
+            c = i & 1;
+        } else if (img->pixfmt == PIXFORMAT_GRAYSCALE) {
+            c = (i & 1) ? 255 : 0;
+        }
+        if (i & 2) {
+            imlib_draw_circle(img, x, y, r, c, 1, true);
+        } else {
+            imlib_draw_rectangle(img, x - r, y - r, r * 2, r, c, 1, true);
+        }
+    }
+}
+
+#ifdef IMLIB_ENABLE_MEAN
+static void bench_mean(image_t *img) {
+    imlib_mean_filter(img, 1, false, 0, false, NULL);
+}
+#endif
+
+#ifdef IMLIB_ENABLE_MEDIAN
+static void bench_median(image_t *img) {
+    imlib_median_filter(img, 1, 0.5f, false, 0, false, NULL);
+}
+#endif
+
+static void bench_gaussian(image_t *img) {
+    imlib_morph(img, 1, bench_gauss_3, 1.0f / 16.0f, 0.0f, false, 0, false, NULL);
+}
+
+#ifdef IMLIB_ENABLE_BINARY_OPS
+static void bench_erode(image_t *img) {
+    imlib_erode(img, 1, 0, NULL);
+}
+
+static void bench_dilate(image_t *img) {
+    imlib_dilate(img, 1, 0, NULL);
+}
+#endif
+
+// Converts to the other format, like to_grayscale()/to_rgb565() with copy=True.
+static void bench_convert(image_t *img) {
+    image_t dst = {
+        .w = img->w,
+        .h = img->h,
+        .pixfmt = (img->pixfmt == PIXFORMAT_GRAYSCALE) ? PIXFORMAT_RGB565 : PIXFORMAT_GRAYSCALE,
+    };
+    dst.data = uma_malloc(image_size(&dst), UMA_CACHE);
+    imlib_draw_image(&dst, img, 0, 0, 1.0f, 1.0f, NULL, -1, 255, NULL, NULL, 0, NULL, NULL, NULL, NULL);
+    uma_free(dst.data);
+}
+
+static void bench_scale(image_t *img) {
+    image_t dst = {
+        .w = img->w / 2,
+        .h = img->h / 2,
+        .pixfmt = img->pixfmt,
+    };
+    dst.data = uma_malloc(image_size(&dst), UMA_CACHE);
+    imlib_draw_image(&dst, img, 0, 0, 0.5f, 0.5f, NULL, -1, 255, NULL, NULL,
+                     IMAGE_HINT_BILINEAR, NULL, NULL, NULL, NULL);
+    uma_free(dst.data);
+}
+
+static void bench_jpeg(image_t *img) {
+    image_t dst = {
+        .w = img->w,
+        .h = img->h,
+        .pixfmt = PIXFORMAT_JPEG,
+        .size = image_size(img),
+    };
+    dst.data = uma_malloc(dst.size, UMA_CACHE);
+    bool overflow = jpeg_compress(img, &dst, 90, false, JPEG_SUBSAMPLING_AUTO);
+    uma_free(dst.data);
+
+    // A truncated encode would be timed as a faster one.
+    if (overflow) {
+        mp_raise_msg(&mp_type_OSError, MP_ERROR_TEXT("Compression Failed!"));
+    }
+}
+
+static void bench_find_blobs(image_t *img) {
+    list_t thresholds, out;
+    list_init(&thresholds, sizeof(color_thresholds_list_lnk_data_t));
+    color_thresholds_list_lnk_data_t t = {
+        .LMin = 30, .LMax = 100, .AMin = 20, .AMax = 127, .BMin = -128, .BMax = 127,
+    };
+    if (img->pixfmt == PIXFORMAT_GRAYSCALE) {
+        t.LMin = 192;
+        t.LMax = 255;
+    }
+    list_push_back(&thresholds, &t);
+
+    rectangle_t roi = {0, 0, img->w, img->h};
+    imlib_find_blobs(&out, img, &roi, 2, 1, &thresholds, false, 10, 10, false, 0,
+                     NULL, NULL, NULL, NULL, 0, 0);
+    list_free(&out);
+    list_free(&thresholds);
+}
+
+#ifdef IMLIB_ENABLE_APRILTAGS
+static void bench_find_apriltags(image_t *img) {
+    list_t out;
+    rectangle_t roi = {0, 0, img->w, img->h};
+    imlib_find_apriltags(&out, img, &roi, TAG36H11, (2.8f / 3.984f) * img->w, (2.8f / 2.952f) * img->h,
+                         img->w * 0.5f, img->h * 0.5f);
+    list_free(&out);
+}
+#endif
+
+#ifdef IMLIB_ENABLE_QRCODES
+static void bench_find_qrcodes(image_t *img) {
+    list_t out;
+    rectangle_t roi = {0, 0, img->w, img->h};
+    imlib_find_qrcodes(&out, img, &roi);
+    while (list_size(&out)) {
+        find_qrcodes_list_lnk_data_t lnk_data;
+        list_pop_front(&out, &lnk_data);
+        m_free(lnk_data.payload);
+    }
+}
+#endif
+
+static void bench_integral(image_t *img) {
+    i_image_t sum;
+    imlib_integral_image_alloc(&sum, img->w, img->h);
+    imlib_integral_image(img, &sum);
+    imlib_integral_image_free(&sum);
+}
+
+static const bench_kernel_t bench_kernels[] = {
+    #ifdef IMLIB_ENABLE_MEAN
+    { "mean", BENCH_COLOR, bench_mean },
+    #endif
+    #ifdef IMLIB_ENABLE_MEDIAN
+    { "median", BENCH_COLOR, bench_median },
+    #endif
+    { "gaussian", BENCH_COLOR, bench_gaussian },
+    #ifdef IMLIB_ENABLE_BINARY_OPS
+    { "erode", BENCH_COLOR | BENCH_BINARY, bench_erode },
+    { "dilate", BENCH_COLOR | BENCH_BINARY, bench_dilate },
+    #endif
+    { "convert", BENCH_COLOR, bench_convert },
+    { "scale", BENCH_COLOR, bench_scale },
+    { "jpeg", BENCH_COLOR, bench_jpeg },
+    { "find_blobs", BENCH_COLOR, bench_find_blobs },
+    #ifdef IMLIB_ENABLE_APRILTAGS
+    { "find_apriltags", BENCH_COLOR, bench_find_apriltags },
+    #endif
+    #ifdef IMLIB_ENABLE_QRCODES
+    { "find_qrcodes", BENCH_COLOR, bench_find_qrcodes },
+    #endif
+    { "integral", BENCH_GRAYSCALE, bench_integral },
+};
+
+// QEMU doesn't model the DWT cycle counter, so fall back to the tick timer scaled to core
+// clocks. The ticks are deterministic when QEMU runs with -icount.
+static bool bench_has_cyccnt(void) {
+    uint32_t start = omv_cycles_now();
+    for (volatile int i = 0; i < 100; i++) {
+    }
+    return omv_cycles_now() != start;
+}
+
+static mp_obj_t bench_kernels_list(void) {
+    mp_obj_t list = mp_obj_new_list(0, NULL);
+    for (size_t i = 0; i < MP_ARRAY_SIZE(bench_kernels); i++) {
+        mp_obj_list_append(list, mp_obj_new_str(bench_kernels[i].name, strlen(bench_kernels[i].name)));
+    }
+    return list;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(bench_kernels_obj, bench_kernels_list);
+
+// Runs a kernel on a fresh synthetic frame per iteration and returns its average and best
+// cycles, plus the peak bytes it allocated from the pools and from the scratch arena. Returns
+// None if the kernel doesn't support the format.
+static mp_obj_t bench_run(size_t n_args, const mp_obj_t *args) {
+    const char *name = mp_obj_str_get_str(args[0]);
+    int w = mp_obj_get_int(args[1]);
+    int h = mp_obj_get_int(args[2]);
+    pixformat_t pixfmt = mp_obj_get_int(args[3]);
+    int iterations = IM_MAX((n_args > 4) ? mp_obj_get_int(args[4]) : 1, 1);
+
+    const bench_kernel_t *kernel = NULL;
+    for (size_t i = 0; i < MP_ARRAY_SIZE(bench_kernels); i++) {
+        if (!strcmp(bench_kernels[i].name, name)) {
+            kernel = &bench_kernels[i];
+        }
+    }
+
+    if (!kernel) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Unknown kernel"));
+    }
+
+    uint32_t format = (pixfmt == PIXFORMAT_GRAYSCALE) ? BENCH_GRAYSCALE :
+                      (pixfmt == PIXFORMAT_RGB565) ? BENCH_RGB565 :
+                      (pixfmt == PIXFORMAT_BINARY) ? BENCH_BINARY : 0;
+
+    if (!(kernel->formats & format)) {
+        return mp_const_none;
+    }
+
+    // Both frames share one block, so there is a single buffer to free if a kernel raises.
+    image_t src = { .w = w, .h = h, .pixfmt = pixfmt };
+    image_t img = src;
+    size_t size = OMV_ALIGN_TO(image_size(&src), OMV_CACHE_LINE_SIZE);
+    src.data = uma_malloc(size * 2, UMA_CACHE);
+    img.data = src.data + size;
+    bench_frame_init(&src);
+
+    bool cyccnt = bench_has_cyccnt();
+    uint64_t cycles_total = 0;
+    uint32_t cycles_min = UINT32_MAX;
+    size_t peak_bytes = 0;
+    size_t scratch_bytes = 0;
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        // The first run warms up the caches and sizes the scratch arena.
+        for (int i = -1; i < iterations; i++) {
+            memcpy(img.data, src.data, image_size(&src));
+
+            uma_stats_t stats;
+            uma_frame_begin();
+            uma_get_stats(-1, false, &stats);
+            size_t used_bytes = stats.used_bytes;
+
+            uint32_t start_cycles = omv_cycles_now();
+            uint32_t start_us = mp_hal_ticks_us();
+            kernel->fn(&img);
+            uint32_t cycles = omv_cycles_now() - start_cycles;
+            uint32_t us = mp_hal_ticks_us() - start_us;
+
+            if (!cyccnt) {
+                cycles = us * OMV_CYCLES_PER_US;
+            }
+
+            uma_frame_begin();
+            uma_get_stats(-1, false, &stats);
+
+            if (i >= 0) {
+                cycles_total += cycles;
+                cycles_min = IM_MIN(cycles_min, cycles);
+                peak_bytes = IM_MAX(peak_bytes, stats.frame_peak_bytes - used_bytes);
+                scratch_bytes = IM_MAX(scratch_bytes, stats.scratch_peak_bytes);
+            }
+        }
+        nlr_pop();
+    } else {
+        uma_free(src.data);
+        nlr_jump(nlr.ret_val);
+    }
+
+    uma_free(src.data);
+
+    mp_obj_t dict = mp_obj_new_dict(8);
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_iterations), mp_obj_new_int(iterations));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_cycles), mp_obj_new_int_from_uint(cycles_total / iterations));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_cycles_min), mp_obj_new_int_from_uint(cycles_min));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_cpu_hz), mp_obj_new_int_from_uint(OMV_CPU_FREQ_HZ));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_clock), MP_OBJ_NEW_QSTR(cyccnt ? MP_QSTR_dwt : MP_QSTR_ticks));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_peak_bytes), mp_obj_new_int_from_uint(peak_bytes));
+    mp_obj_dict_store(dict, MP_OBJ_NEW_QSTR(MP_QSTR_scratch_bytes), mp_obj_new_int_from_uint(scratch_bytes));
+    return dict;
+}
+static MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(bench_run_obj, 4, 5, bench_run);
+
+// Luma quantization of the software JPEG encoder before the integer DCT: a scalar AAN DCT
+// followed by a float multiply per coefficient. It's kept here as the baseline for the
+// jpeg_encode benchmark, which compares it against the current encoder.
+static const uint8_t bench_jpeg_yqt[64] = {
+    16, 11, 10, 16, 24,  40,  51,  61,
+    12, 12, 14, 19, 26,  58,  60,  55,
+    14, 13, 16, 24, 40,  57,  69,  56,
+    14, 17, 22, 29, 51,  87,  80,  62,
+    18, 22, 37, 56, 68,  109, 103, 77,
+    24, 35, 55, 64, 81,  104, 113, 92,
+    49, 64, 78, 87, 103, 121, 120, 101,
+    72, 92, 95, 98, 112, 100, 103, 99
+};
+
+static const float bench_jpeg_aasf[8] = {
+    1.0f, 1.387039845f, 1.306562965f, 1.175875602f,
+    1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+#define BENCH_MULTIPLY(x, y)    (((x) * (y)) >> 8)
+
+// One scalar AAN forward DCT pass over 8 values spaced by stride.
+static void bench_jpeg_fdct_1d(int *p, int stride) {
+    int t0 = p[0 * stride] + p[7 * stride];
+    int t1 = p[1 * stride] + p[6 * stride];
+    int t2 = p[2 * stride] + p[5 * stride];
+    int t3 = p[3 * stride] + p[4 * stride];
+    int t7 = p[0 * stride] - p[7 * stride];
+    int t6 = p[1 * stride] - p[6 * stride];
+    int t5 = p[2 * stride] - p[5 * stride];
+    int t4 = p[3 * stride] - p[4 * stride];
+
+    // Even part
+    int t10 = t0 + t3;
+    int t13 = t0 - t3;
+    int t11 = t1 + t2;
+    int t12 = t1 - t2;
+    int z1 = BENCH_MULTIPLY(t12 + t13, 181);
+
+    p[0 * stride] = t10 + t11;
+    p[4 * stride] = t10 - t11;
+    p[2 * stride] = t13 + z1;
+    p[6 * stride] = t13 - z1;
+
+    // Odd part
+    t10 = t4 + t5;
+    t11 = t5 + t6;
+    t12 = t6 + t7;
+
+    int z5 = BENCH_MULTIPLY(t10 - t12, 98);
+    int z2 = BENCH_MULTIPLY(t10, 139) + z5;
+    int z4 = BENCH_MULTIPLY(t12, 334) + z5;
+    int z3 = BENCH_MULTIPLY(t11, 181);
+    int z11 = t7 + z3;
+    int z13 = t7 - z3;
+
+    p[5 * stride] = z13 + z2;
+    p[3 * stride] = z13 - z2;
+    p[1 * stride] = z11 + z4;
+    p[7 * stride] = z11 - z4;
+}
+
+static int bench_jpeg_get_y(image_t *img, int x, int y) {
+    switch (img->pixfmt) {
+        case PIXFORMAT_GRAYSCALE:
+            return IMAGE_GET_GRAYSCALE_PIXEL(img, x, y);
+        case PIXFORMAT_RGB565:
+            return COLOR_RGB565_TO_Y(IMAGE_GET_RGB565_PIXEL(img, x, y));
+        default:
+            return IMAGE_GET_YUV_PIXEL(img, x, y) & 0xFF;
+    }
+}
+
+// Quantizes an 8x8 block of centered luma like the baseline encoder.
+static void bench_jpeg_quantize(const int8_t *CDU, int stride, const float *fdtbl, int *DUQ) {
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            DUQ[(r * 8) + c] = CDU[(r * stride) + c];
+        }
+    }
+
+    for (int i = 0; i < 8; i++) {
+        bench_jpeg_fdct_1d(DUQ + (i * 8), 1);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        bench_jpeg_fdct_1d(DUQ + i, 8);
+    }
+
+    for (int i = 0; i < 64; i++) {
+        DUQ[i] = fast_roundf(DUQ[i] * fdtbl[i]);
+    }
+}
+
+// Reconstructs a block of dequantized coefficients with an exact float IDCT, and returns
+// the squared error against the centered luma at CDU.
+static uint32_t bench_jpeg_idct_error(const float *F, const int8_t *CDU, int stride, float (*cosines)[8]) {
+    float tmp[64];
+    uint32_t error = 0;
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            float sum = 0;
+            for (int u = 0; u < 8; u++) {
+                sum += cosines[c][u] * F[(r * 8) + u];
+            }
+            tmp[(r * 8) + c] = sum;
+        }
+    }
+
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            float sum = 0;
+            for (int v = 0; v < 8; v++) {
+                sum += cosines[r][v] * tmp[(v * 8) + c];
+            }
+            int p = IM_MAX(IM_MIN(fast_roundf(sum), 127), -128);
+            int d = p - CDU[(r * stride) + c];
+            error += d * d;
+        }
+    }
+    return error;
+}
+
+// Times the luma DCT and quantization of the baseline and of the encoder over the image, and
+// returns both times in microseconds (the encoder's is None with a hardware codec) with the
+// luma PSNR of the baseline and of the JPEG encoded from the same image. The baseline is
+// reconstructed with an exact float IDCT and the JPEG with the image decoder, whose IDCT
+// rounding costs far less than the margin the test allows.
+static mp_obj_t bench_jpeg_reference(mp_obj_t img_obj, mp_obj_t jpg_obj, mp_obj_t quality_obj) {
+    image_t *img = py_helper_arg_to_image(img_obj, ARG_IMAGE_UNCOMPRESSED);
+    image_t *jpg = py_helper_arg_to_image(jpg_obj, ARG_IMAGE_ANY);
+    int quality = mp_obj_get_int(quality_obj);
+
+    if ((img->pixfmt != PIXFORMAT_GRAYSCALE && img->pixfmt != PIXFORMAT_RGB565 && img->pixfmt != PIXFORMAT_YUV422) ||
+        (jpg->pixfmt != PIXFORMAT_JPEG) || (img->w % 8) || (img->h % 8) || (jpg->w != img->w) ||
+        (jpg->h != img->h) || (quality < 1) || (quality > 100)) {
+        mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("Invalid arguments"));
+    }
+
+    // Same scaling as the encoder, the quantizer folds in the AAN output scale factors.
+    float qtbl[64], fdtbl[64];
+    int scale = (quality < 50) ? (5000 / quality) : (200 - (quality * 2));
+    for (int r = 0, i = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++, i++) {
+            qtbl[i] = IM_MAX(IM_MIN(((bench_jpeg_yqt[i] * scale) + 50) / 100, 255), 1);
+            fdtbl[i] = 1.0f / (bench_jpeg_aasf[r] * bench_jpeg_aasf[c] * qtbl[i] * 8.0f);
+        }
+    }
+
+    // The luma is extracted first so that only the DCT and quantization are timed.
+    int8_t *luma = uma_malloc(img->w * img->h, UMA_CACHE);
+    for (int y = 0; y < img->h; y++) {
+        for (int x = 0; x < img->w; x++) {
+            luma[(y * img->w) + x] = bench_jpeg_get_y(img, x, y) - 128;
+        }
+    }
+
+    // Both stages are timed on the same contiguous 8x8 blocks, as the encoder's MCU buffer.
+    int8_t *blocks = uma_malloc(img->w * img->h, UMA_CACHE);
+    for (int y = 0, i = 0; y < img->h; y += 8) {
+        for (int x = 0; x < img->w; x += 8) {
+            for (int r = 0; r < 8; r++) {
+                for (int c = 0; c < 8; c++, i++) {
+                    blocks[i] = luma[((y + r) * img->w) + x + c];
+                }
+            }
+        }
+    }
+
+    int DUQ[64];
+    int n_blocks = (img->w * img->h) / 64;
+    volatile int sink = 0;
+    uint32_t start = mp_hal_ticks_us();
+    for (int i = 0; i < n_blocks; i++) {
+        bench_jpeg_quantize(blocks + (i * 64), 8, fdtbl, DUQ);
+        sink += DUQ[0];
+    }
+    uint32_t us = mp_hal_ticks_us() - start;
+
+    mp_obj_t enc_us = mp_const_none;
+    #if (OMV_JPEG_CODEC_ENABLE == 0)
+    start = mp_hal_ticks_us();
+    for (int i = 0; i < n_blocks; i++) {
+        sink += jpeg_fdct_quant_luma(blocks + (i * 64), quality, DUQ);
+    }
+    enc_us = mp_obj_new_int_from_uint(mp_hal_ticks_us() - start);
+    #endif
+    uma_free(blocks);
+
+    float cosines[8][8];
+    for (int x = 0; x < 8; x++) {
+        for (int u = 0; u < 8; u++) {
+            cosines[x][u] = ((u == 0) ? M_SQRT1_2 : 1.0f) * cosf(((2 * x) + 1) * u * M_PI / 16) / 2;
+        }
+    }
+
+    uint64_t ref_error = 0;
+    for (int y = 0; y < img->h; y += 8) {
+        for (int x = 0; x < img->w; x += 8) {
+            float F[64];
+            bench_jpeg_quantize(luma + (y * img->w) + x, img->w, fdtbl, DUQ);
+            for (int i = 0; i < 64; i++) {
+                F[i] = DUQ[i] * qtbl[i];
+            }
+            ref_error += bench_jpeg_idct_error(F, luma + (y * img->w) + x, img->w, cosines);
+        }
+    }
+
+    image_t dec = {
+        .w = img->w,
+        .h = img->h,
+        .pixfmt = PIXFORMAT_GRAYSCALE,
+    };
+    dec.data = uma_malloc(image_size(&dec), UMA_CACHE);
+
+    // The decoder raises on a corrupt JPEG, the buffers must not leak then.
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        jpeg_decompress(&dec, jpg);
+        nlr_pop();
+    } else {
+        uma_free(dec.data);
+        uma_free(luma);
+        nlr_jump(nlr.ret_val);
+    }
+
+    uint64_t error = 0;
+    for (int i = 0, n = img->w * img->h; i < n; i++) {
+        int d = (dec.data[i] - 128) - luma[i];
+        error += d * d;
+    }
+    uma_free(dec.data);
+    uma_free(luma);
+
+    float n = img->w * img->h * 255.0f * 255.0f;
+    mp_obj_t tuple[4] = {
+        mp_obj_new_int_from_uint(us),
+        enc_us,
+        mp_obj_new_float(10.0f * log10f(n / IM_MAX(ref_error, (uint64_t) 1))),
+        mp_obj_new_float(10.0f * log10f(n / IM_MAX(error, (uint64_t) 1))),
+    };
+    return mp_obj_new_tuple(4, tuple);
+}
+static MP_DEFINE_CONST_FUN_OBJ_3(bench_jpeg_reference_obj, bench_jpeg_reference);
+
+static const mp_rom_map_elem_t unittest_bench_module_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_unittest_bench) },
+    { MP_ROM_QSTR(MP_QSTR_kernels), MP_ROM_PTR(&bench_kernels_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run), MP_ROM_PTR(&bench_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_jpeg_reference), MP_ROM_PTR(&bench_jpeg_reference_obj) },
+};
+
+static MP_DEFINE_CONST_DICT(unittest_bench_module_globals, unittest_bench_module_globals_table);
+
+const mp_obj_module_t unittest_bench_module = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t *) &unittest_bench_module_globals,
+};
+
+MP_REGISTER_MODULE(MP_QSTR_unittest_bench, unittest_bench_module);
+
+#endif // MICROPY_PY_UNITTEST
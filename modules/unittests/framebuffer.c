@@ -280,6 +280,117 @@ static mp_obj_t test_framebuffer_acquire_release(void) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(test_framebuffer_acquire_release_obj, test_framebuffer_acquire_release);
 
+// Test frame metadata and counters with triple buffering
+static mp_obj_t test_framebuffer_metadata(void) {
+    framebuffer_t *fb = framebuffer_get(FB_MAINFB_ID);
+    if (fb == NULL) {
+        return mp_const_false;
+    }
+
+    size_t orig_buf_count = fb->buf_count;
+    size_t orig_buf_size = fb->buf_size;
+
+    if (framebuffer_resize(fb, 3, 1024) != 0) {
+        return mp_const_false;
+    }
+
+    framebuffer_reset_stats(fb);
+    fb->meta.seq = 0;
+    fb->meta.dropped = 0;
+
+    // The third frame finds one free buffer left and replaces the second one.
+    bool ok = true;
+    for (int i = 0; i < 3; i++) {
+        framebuffer_begin_frame(fb);
+        framebuffer_release(fb, FB_FLAG_FREE | FB_FLAG_CHECK_LAST);
+    }
+
+    vbuffer_t *first = framebuffer_acquire(fb, FB_FLAG_USED);
+    vbuffer_t *latest = framebuffer_acquire(fb, FB_FLAG_USED);
+
+    ok = ok && first && latest && !framebuffer_readable(fb);
+    ok = ok && (first->meta.seq == 1) && (first->meta.dropped == 0);
+    ok = ok && (latest->meta.seq == 3) && (latest->meta.dropped == 1);
+    ok = ok && ((int32_t) (latest->meta.end_us - latest->meta.start_us) >= 0);
+    ok = ok && ((int32_t) (latest->meta.start_us - first->meta.end_us) >= 0);
+
+    ok = ok && (fb->stats.captured == 3) && (fb->stats.dropped == 1);
+    ok = ok && (fb->stats.depth[0] == 1) && (fb->stats.depth[1] == 1) && (fb->stats.depth[2] == 1);
+
+    // Flushing counts the frames still in the used queue.
+    framebuffer_flush(fb);
+    framebuffer_release(fb, FB_FLAG_FREE);
+    framebuffer_flush(fb);
+    ok = ok && (fb->stats.flushed == 1) && (fb->stats.captured == 4);
+
+    // The sequence keeps counting after resetting the counters.
+    framebuffer_reset_stats(fb);
+    ok = ok && (fb->stats.captured == 0) && (fb->meta.seq == 4);
+
+    framebuffer_resize(fb, orig_buf_count, orig_buf_size);
+    return mp_obj_new_bool(ok);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_framebuffer_metadata_obj, test_framebuffer_metadata);
+
+// Test that staged preview frames fall back to inline encoding if the driver doesn't poll,
+// and aren't staged until the host reads the last published frame.
+static mp_obj_t test_framebuffer_stage_preview(void) {
+    framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
+    if (fb == NULL || !fb->raw_base) {
+        return mp_const_false;
+    }
+
+    uint8_t orig_enabled = fb->enabled;
+    uint8_t orig_polled = fb->polled;
+    uint8_t orig_unread = fb->unread;
+    uint32_t orig_budget = fb->budget;
+    framebuffer_set_enabled(fb, true);
+    framebuffer_set_preview_budget(fb, 0x7FFFFFFF);
+
+    static uint8_t pixels[40 * 30];
+    memset(pixels, 0x80, sizeof(pixels));
+
+    image_t img[3];
+    for (int i = 0; i < 3; i++) {
+        img[i] = (image_t) {
+            .w = 32 + (i * 4),
+            .h = 24 + (i * 3),
+            .pixfmt = PIXFORMAT_GRAYSCALE,
+            .data = pixels
+        };
+    }
+
+    // Drivers that never poll are encoded inline.
+    fb->polled = false;
+    framebuffer_stage_preview(&img[0]);
+    bool ok = !fb->pending && (fb->pixfmt == PIXFORMAT_JPEG) && (fb->w == img[0].w);
+
+    // Frames aren't staged until the host reads the published one.
+    framebuffer_poll_preview();
+    framebuffer_stage_preview(&img[1]);
+    ok = ok && fb->unread && !fb->pending;
+
+    // Once read, frames are staged and encoded on the next poll.
+    fb->unread = false;
+    framebuffer_stage_preview(&img[1]);
+    ok = ok && fb->pending && (fb->w == img[0].w);
+    framebuffer_poll_preview();
+    ok = ok && !fb->pending && fb->unread && (fb->w == img[1].w) && (fb->h == img[1].h);
+
+    // A staged frame that wasn't polled is dropped for the next one, encoded inline.
+    fb->unread = false;
+    framebuffer_stage_preview(&img[0]);
+    framebuffer_stage_preview(&img[2]);
+    ok = ok && !fb->pending && (fb->w == img[2].w) && (fb->h == img[2].h);
+
+    fb->polled = orig_polled;
+    fb->unread = orig_unread;
+    framebuffer_set_preview_budget(fb, orig_budget);
+    framebuffer_set_enabled(fb, orig_enabled);
+    return mp_obj_new_bool(ok);
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_framebuffer_stage_preview_obj, test_framebuffer_stage_preview);
+
 // Module definition
 static const mp_rom_map_elem_t unittest_fb_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_unittest_fb) },
@@ -289,6 +400,8 @@ static const mp_rom_map_elem_t unittest_fb_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_test_framebuffer_resize), MP_ROM_PTR(&test_framebuffer_resize_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_framebuffer_flush), MP_ROM_PTR(&test_framebuffer_flush_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_framebuffer_acquire_release), MP_ROM_PTR(&test_framebuffer_acquire_release_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_framebuffer_metadata), MP_ROM_PTR(&test_framebuffer_metadata_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_framebuffer_stage_preview), MP_ROM_PTR(&test_framebuffer_stage_preview_obj) },
 };
 
 static MP_DEFINE_CONST_DICT(unittest_fb_module_globals, unittest_fb_module_globals_table);
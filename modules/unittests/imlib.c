@@ -401,6 +401,379 @@ static mp_obj_t test_imlib_sepconv3_tall_narrow(void) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_sepconv3_tall_narrow_obj, test_imlib_sepconv3_tall_narrow);
 
+// The filter SIMD paths run when there is no mask. An all-set mask forces the scalar reference path
+// over the same pixels, so both outputs must match bit-for-bit.
+#if defined(IMLIB_ENABLE_MEAN) || defined(IMLIB_ENABLE_MEDIAN) || defined(IMLIB_ENABLE_MIDPOINT)
+#define FILTER_TEST_SIZES   (4)
+#define FILTER_TEST_KSIZES  (4)
+
+static const int filter_test_sizes[FILTER_TEST_SIZES][2] = {
+    {37, 23}, {1, 1}, {2, 9}, {40, 3}
+};
+
+static void filter_test_fill(image_t *img, uint32_t seed) {
+    for (size_t i = 0; i < image_size(img); i++) {
+        seed = (seed * 1664525) + 1013904223;
+        img->data[i] = seed >> 24;
+    }
+}
+
+// Runs op on a random image with and without an all-set mask and compares the results.
+static bool filter_test_compare(int w, int h, pixformat_t pixfmt, uint32_t seed,
+                                void (*op)(image_t *img, image_t *mask, int arg), int arg) {
+    image_t img = { .w = w, .h = h, .pixfmt = pixfmt };
+    image_t ref = { .w = w, .h = h, .pixfmt = pixfmt };
+    image_t mask = { .w = w, .h = h, .pixfmt = PIXFORMAT_GRAYSCALE };
+    image_alloc(&img, image_size(&img));
+    image_alloc(&ref, image_size(&ref));
+    image_alloc(&mask, image_size(&mask));
+    filter_test_fill(&img, seed);
+    memcpy(ref.data, img.data, image_size(&img));
+    memset(mask.data, 0xFF, image_size(&mask));
+
+    op(&img, NULL, arg);
+    op(&ref, &mask, arg);
+
+    return memcmp(img.data, ref.data, image_size(&img)) == 0;
+}
+
+static bool filter_test_run(void (*op)(image_t *img, image_t *mask, int arg)) {
+    static const pixformat_t pixfmts[2] = { PIXFORMAT_GRAYSCALE, PIXFORMAT_RGB565 };
+    for (int f = 0; f < 2; f++) {
+        for (int s = 0; s < FILTER_TEST_SIZES; s++) {
+            for (int arg = 0; arg < (FILTER_TEST_KSIZES * 2); arg++) {
+                if (!filter_test_compare(filter_test_sizes[s][0], filter_test_sizes[s][1],
+                                         pixfmts[f], (s * 31) + arg, op, arg)) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+#ifdef IMLIB_ENABLE_BINARY_OPS
+// The BINARY morphology path works on whole words, the GRAYSCALE path one pixel at a time.
+// Running both on the same 0/255 pixels must give the same results.
+static bool morph_test_compare(int w, int h, int ksize, int threshold, bool dilate,
+                               uint32_t seed, pixformat_t mask_pixfmt) {
+    image_t bin = { .w = w, .h = h, .pixfmt = PIXFORMAT_BINARY };
+    image_t ref = { .w = w, .h = h, .pixfmt = PIXFORMAT_GRAYSCALE };
+    image_t mask = { .w = w, .h = h, .pixfmt = mask_pixfmt };
+    image_alloc(&bin, image_size(&bin));
+    image_alloc(&ref, image_size(&ref));
+    image_alloc(&mask, image_size(&mask));
+    memset(bin.data, 0, image_size(&bin));
+    memset(mask.data, 0, image_size(&mask));
+
+    // Vary the density so that both erode and dilate have something to do.
+    uint32_t density = seed & 0xFF;
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            seed = (seed * 1664525) + 1013904223;
+            bool pixel = (seed >> 24) < density;
+            IMAGE_PUT_BINARY_PIXEL(&bin, x, y, pixel);
+            IMAGE_PUT_GRAYSCALE_PIXEL(&ref, x, y, pixel ? COLOR_GRAYSCALE_BINARY_MAX : COLOR_GRAYSCALE_BINARY_MIN);
+            if ((seed >> 8) & 3) {
+                if (mask_pixfmt == PIXFORMAT_BINARY) {
+                    IMAGE_SET_BINARY_PIXEL(&mask, x, y);
+                } else if (mask_pixfmt == PIXFORMAT_GRAYSCALE) {
+                    IMAGE_PUT_GRAYSCALE_PIXEL(&mask, x, y, COLOR_GRAYSCALE_BINARY_MAX);
+                }
+            }
+        }
+    }
+
+    image_t *m = (mask_pixfmt == PIXFORMAT_INVALID) ? NULL : &mask;
+    binary_morph_op_t op = dilate ? imlib_dilate : imlib_erode;
+    op(&bin, ksize, threshold, m);
+    op(&ref, ksize, threshold, m);
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (IMAGE_GET_BINARY_PIXEL(&bin, x, y) != (IMAGE_GET_GRAYSCALE_PIXEL(&ref, x, y) > 0)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static mp_obj_t test_imlib_binary_morph(void) {
+    static const int sizes[][2] = {
+        {37, 23}, {1, 1}, {2, 9}, {40, 3}, {64, 5}, {70, 40}
+    };
+    static const pixformat_t masks[3] = { PIXFORMAT_INVALID, PIXFORMAT_BINARY, PIXFORMAT_GRAYSCALE };
+
+    for (int s = 0; s < OMV_ARRAY_SIZE(sizes); s++) {
+        for (int ksize = 0; ksize <= 4; ksize++) {
+            int n = imlib_ksize_to_n(ksize);
+            int thresholds[6] = { -1, 0, 1, 3, n - 2, n };
+            for (int t = 0; t < 6; t++) {
+                for (int m = 0; m < 3; m++) {
+                    uint32_t seed = (s * 977) + (ksize * 131) + (t * 17) + m;
+                    if (!morph_test_compare(sizes[s][0], sizes[s][1], ksize, thresholds[t], false, seed, masks[m]) ||
+                        !morph_test_compare(sizes[s][0], sizes[s][1], ksize, thresholds[t], true, seed, masks[m])) {
+                        return mp_const_false;
+                    }
+                }
+            }
+        }
+    }
+    return mp_const_true;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_binary_morph_obj, test_imlib_binary_morph);
+#endif
+
+#ifdef IMLIB_ENABLE_MEAN
+// arg: bit 0 = threshold, rest = ksize.
+static void filter_test_mean(image_t *img, image_t *mask, int arg) {
+    imlib_mean_filter(img, arg >> 1, arg & 1, 4, false, mask);
+}
+
+// Test mean: the vectorized box filter matches the scalar reference.
+static mp_obj_t test_imlib_mean_filter_simd(void) {
+    return filter_test_run(filter_test_mean) ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_mean_filter_simd_obj, test_imlib_mean_filter_simd);
+#endif
+
+#ifdef IMLIB_ENABLE_MEDIAN
+static void filter_test_median(image_t *img, image_t *mask, int arg) {
+    imlib_median_filter(img, arg >> 1, 0.25f * (1 + (arg & 3)), arg & 1, 2, true, mask);
+}
+
+// Test median: the vectorized rank selection matches the scalar histogram for all percentiles.
+static mp_obj_t test_imlib_median_filter_simd(void) {
+    return filter_test_run(filter_test_median) ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_median_filter_simd_obj, test_imlib_median_filter_simd);
+#endif
+
+#ifdef IMLIB_ENABLE_MIDPOINT
+static void filter_test_midpoint(image_t *img, image_t *mask, int arg) {
+    imlib_midpoint_filter(img, arg >> 1, 0.3f, arg & 1, -3, false, mask);
+}
+
+// Test midpoint: the separable vectorized min/max matches the scalar reference.
+static mp_obj_t test_imlib_midpoint_filter_simd(void) {
+    return filter_test_run(filter_test_midpoint) ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_midpoint_filter_simd_obj, test_imlib_midpoint_filter_simd);
+#endif
+
+// Test tracker: markers keep their ids while moving and only their windows are searched.
+static mp_obj_t test_imlib_tracker(void) {
+    imlib_tracker_t tracker;
+    rectangle_t roi = { 0, 0, 320, 240 };
+    rectangle_t windows[IMLIB_TRACKER_MAX_TRACKS];
+    imlib_tracker_det_t dets[2] = {
+        { { 10, 10, 20, 20 }, 1 },
+        { { 200, 100, 20, 20 }, 2 },
+    };
+    uint32_t ids[2];
+
+    imlib_tracker_init(&tracker, 4, 0.5f, 1);
+    if ((imlib_tracker_windows(&tracker, &roi, windows) != 1) || !tracker.full_scan ||
+        !rectangle_equal(&windows[0], &roi)) {
+        return mp_const_false;
+    }
+
+    imlib_tracker_update(&tracker, 2, dets, ids);
+    if ((ids[0] != 1) || (ids[1] != 2)) {
+        return mp_const_false;
+    }
+
+    // Move both markers and report them in the opposite order.
+    for (int frame = 0; frame < 3; frame++) {
+        size_t n = imlib_tracker_windows(&tracker, &roi, windows);
+        if ((n != 2) || tracker.full_scan) {
+            return mp_const_false;
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            if ((windows[i].w != 40) || (windows[i].h != 40)) {
+                return mp_const_false;
+            }
+        }
+
+        imlib_tracker_det_t moved[2] = { dets[1], dets[0] };
+        moved[0].rect.x += 4 * (frame + 1);
+        moved[1].rect.y += 4 * (frame + 1);
+        imlib_tracker_update(&tracker, 2, moved, ids);
+        if ((ids[0] != 2) || (ids[1] != 1)) {
+            return mp_const_false;
+        }
+    }
+
+    // The interval forces a full scan.
+    imlib_tracker_windows(&tracker, &roi, windows);
+    return tracker.full_scan ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_tracker_obj, test_imlib_tracker);
+
+// Test tracker: a missed marker triggers a full scan and is dropped after max_lost frames.
+static mp_obj_t test_imlib_tracker_lost(void) {
+    imlib_tracker_t tracker;
+    rectangle_t roi = { 0, 0, 320, 240 };
+    rectangle_t windows[IMLIB_TRACKER_MAX_TRACKS];
+    imlib_tracker_det_t dets[2] = {
+        { { 10, 10, 20, 20 }, 1 },
+        { { 26, 10, 20, 20 }, 2 },
+    };
+    uint32_t ids[2];
+
+    imlib_tracker_init(&tracker, 30, 0.5f, 1);
+    imlib_tracker_windows(&tracker, &roi, windows);
+    imlib_tracker_update(&tracker, 2, dets, ids);
+
+    // Overlapping windows are merged and clipped to the ROI.
+    if ((imlib_tracker_windows(&tracker, &roi, windows) != 1) ||
+        (windows[0].x != 0) || (windows[0].y != 0) || (windows[0].w != 56) || (windows[0].h != 40)) {
+        return mp_const_false;
+    }
+
+    imlib_tracker_update(&tracker, 1, dets, ids);
+    if ((ids[0] != 1) || !tracker.rescan || (tracker.n_tracks != 2)) {
+        return mp_const_false;
+    }
+
+    // A missed track forces a full scan of the ROI.
+    imlib_tracker_windows(&tracker, &roi, windows);
+    if (!tracker.full_scan) {
+        return mp_const_false;
+    }
+
+    imlib_tracker_update(&tracker, 1, dets, ids);
+    if ((ids[0] != 1) || (tracker.n_tracks != 1)) {
+        return mp_const_false;
+    }
+
+    // A marker that comes back after being dropped gets a new id.
+    imlib_tracker_windows(&tracker, &roi, windows);
+    imlib_tracker_update(&tracker, 2, dets, ids);
+    if ((ids[0] != 1) || (ids[1] != 3)) {
+        return mp_const_false;
+    }
+
+    imlib_tracker_reset(&tracker);
+    return ((tracker.n_tracks == 0) && (tracker.next_id == 1)) ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_tracker_lost_obj, test_imlib_tracker_lost);
+
+// Test tracker: a merged window that grows into a window checked before is merged with it too.
+static mp_obj_t test_imlib_tracker_merge(void) {
+    imlib_tracker_t tracker;
+    rectangle_t roi = { 0, 0, 320, 240 };
+    rectangle_t windows[IMLIB_TRACKER_MAX_TRACKS];
+    imlib_tracker_det_t dets[3] = {
+        { { 0, 20, 10, 10 }, 1 },
+        { { 20, 0, 10, 30 }, 2 },
+        { { 0, 0, 25, 5 }, 3 },
+    };
+    uint32_t ids[3];
+
+    imlib_tracker_init(&tracker, 30, 0.0f, 1);
+    imlib_tracker_windows(&tracker, &roi, windows);
+    imlib_tracker_update(&tracker, 3, dets, ids);
+
+    // Only the last two windows overlap, but their union overlaps the first one.
+    return ((imlib_tracker_windows(&tracker, &roi, windows) == 1) &&
+            (windows[0].x == 0) && (windows[0].y == 0) &&
+            (windows[0].w == 30) && (windows[0].h == 30)) ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_tracker_merge_obj, test_imlib_tracker_merge);
+
+#ifdef IMLIB_ENABLE_REMAP
+static void remap_test_shift(const void *args, int x, int y, float *sx, float *sy) {
+    *sx = x + 3;
+    *sy = y - 2;
+}
+
+// Test remap: a shift map moves pixels and zeroes those without a source, both into a separate
+// destination and in place.
+static mp_obj_t test_imlib_remap_shift(void) {
+    bool pass = true;
+    imlib_remap_t map;
+    image_t img = { .w = 37, .h = 11, .pixfmt = PIXFORMAT_GRAYSCALE };
+    image_alloc(&img, image_size(&img));
+
+    for (int i = 0; i < (img.w * img.h); i++) {
+        img.data[i] = (i * 7) + 1;
+    }
+
+    image_t src = img;
+    image_alloc(&src, image_size(&src));
+    memcpy(src.data, img.data, image_size(&img));
+
+    // Pixels without a source must be written with the fill value.
+    image_t dst = img;
+    image_alloc(&dst, image_size(&dst));
+    memset(dst.data, 0xFF, image_size(&dst));
+
+    imlib_remap_init(&map, &img, remap_test_shift, NULL, false, 0);
+    imlib_remap_image(&map, &dst, &src);
+    imlib_remap_image(&map, &img, &img);
+    imlib_remap_deinit(&map);
+
+    for (int y = 0; (y < img.h) && pass; y++) {
+        for (int x = 0; x < img.w; x++) {
+            int sx = x + 3, sy = y - 2;
+            int expected = ((sx < src.w) && (sy >= 0)) ? IMAGE_GET_GRAYSCALE_PIXEL(&src, sx, sy) : 0;
+            if ((IMAGE_GET_GRAYSCALE_PIXEL(&img, x, y) != expected) ||
+                (IMAGE_GET_GRAYSCALE_PIXEL(&dst, x, y) != expected)) {
+                pass = false;
+                break;
+            }
+        }
+    }
+
+    return pass ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_remap_shift_obj, test_imlib_remap_shift);
+
+static void remap_test_flip(const void *args, int x, int y, float *sx, float *sy) {
+    *sx = x;
+    *sy = (x & 1) ? (*((int *) args) - 1 - y) : y;
+}
+
+// Test remap: source steps that don't fit the table's int16 deltas start new spans.
+static mp_obj_t test_imlib_remap_flip(void) {
+    bool pass = true;
+    imlib_remap_t map;
+    image_t src = { .w = 512, .h = 80, .pixfmt = PIXFORMAT_GRAYSCALE };
+    image_alloc(&src, image_size(&src));
+
+    for (int i = 0; i < (src.w * src.h); i++) {
+        src.data[i] = (i * 7) + (i / src.w) + 1;
+    }
+
+    image_t dst = src;
+    image_alloc(&dst, image_size(&dst));
+
+    // Odd columns read the mirrored row, so most steps are larger than INT16_MAX.
+    int h = src.h;
+    imlib_remap_init(&map, &src, remap_test_flip, &h, false, 0);
+    pass = map.row_spans[map.h] > map.h;
+    imlib_remap_image(&map, &dst, &src);
+    imlib_remap_deinit(&map);
+
+    for (int y = 0; (y < dst.h) && pass; y++) {
+        for (int x = 0; x < dst.w; x++) {
+            int sy = (x & 1) ? (h - 1 - y) : y;
+            if (IMAGE_GET_GRAYSCALE_PIXEL(&dst, x, y) != IMAGE_GET_GRAYSCALE_PIXEL(&src, x, sy)) {
+                pass = false;
+                break;
+            }
+        }
+    }
+
+    return pass ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_imlib_remap_flip_obj, test_imlib_remap_flip);
+#endif
+
 // Module definition
 static const mp_rom_map_elem_t unittest_imlib_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_unittest_imlib) },
@@ -420,6 +793,25 @@ static const mp_rom_map_elem_t unittest_imlib_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_test_imlib_sepconv3_odd_sizes), MP_ROM_PTR(&test_imlib_sepconv3_odd_sizes_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_imlib_sepconv3_2x2), MP_ROM_PTR(&test_imlib_sepconv3_2x2_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_imlib_sepconv3_tall_narrow), MP_ROM_PTR(&test_imlib_sepconv3_tall_narrow_obj) },
+#ifdef IMLIB_ENABLE_BINARY_OPS
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_binary_morph), MP_ROM_PTR(&test_imlib_binary_morph_obj) },
+#endif
+    #ifdef IMLIB_ENABLE_MEAN
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_mean_filter_simd), MP_ROM_PTR(&test_imlib_mean_filter_simd_obj) },
+    #endif
+    #ifdef IMLIB_ENABLE_MEDIAN
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_median_filter_simd), MP_ROM_PTR(&test_imlib_median_filter_simd_obj) },
+    #endif
+    #ifdef IMLIB_ENABLE_MIDPOINT
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_midpoint_filter_simd), MP_ROM_PTR(&test_imlib_midpoint_filter_simd_obj) },
+    #endif
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_tracker), MP_ROM_PTR(&test_imlib_tracker_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_tracker_lost), MP_ROM_PTR(&test_imlib_tracker_lost_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_tracker_merge), MP_ROM_PTR(&test_imlib_tracker_merge_obj) },
+    #ifdef IMLIB_ENABLE_REMAP
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_remap_shift), MP_ROM_PTR(&test_imlib_remap_shift_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_imlib_remap_flip), MP_ROM_PTR(&test_imlib_remap_flip_obj) },
+    #endif
 };
 
 static MP_DEFINE_CONST_DICT(unittest_imlib_module_globals, unittest_imlib_module_globals_table);
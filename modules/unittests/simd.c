@@ -296,6 +296,21 @@ static mp_obj_t test_simd_vsub(void) {
     }
     #endif
 
+    // Test vsub_s32 with negative: all lanes should compute -100000 - 200000 = -300000
+    a = vdup_s32(-100000);
+    b = vdup_s32(200000);
+    c = vsub_s32(a, b);
+    expected = vdup_s32(-300000);
+    diff = veor_u32(c, expected);
+    if (vget_u32(diff, 0) != 0) {
+        return mp_const_false;
+    }
+    #if (UINT32_VECTOR_SIZE > 1)
+    if (vget_u32(diff, 1) != 0 || vget_u32(diff, 2) != 0 || vget_u32(diff, 3) != 0) {
+        return mp_const_false;
+    }
+    #endif
+
     // Test vsub_n_u32: all lanes should compute 1000 - 100 = 900
     a = vdup_u32(1000);
     c = vsub_n_u32(a, 100);
@@ -1174,6 +1189,69 @@ static mp_obj_t test_simd_vminmax(void) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(test_simd_vminmax_obj, test_simd_vminmax);
 
+// Test integer add, shift, min/max and high-half multiply.
+static mp_obj_t test_simd_vminmax_int(void) {
+    v128_t a = vdup_u8(200);
+    v128_t b = vdup_u8(100);
+
+    // vadd_u8 wraps around.
+    if (vget_u8(vadd_u8(a, b), 0) != 44) {
+        return mp_const_false;
+    }
+
+    if (vget_u8(vmin_u8(a, b), 0) != 100 || vget_u8(vmax_u8(a, b), 0) != 200) {
+        return mp_const_false;
+    }
+
+    // Mixed lanes: min/max are per lane.
+    a = vset_u8(a, 1, 10);
+    if (vget_u8(vmin_u8(a, b), 1) != 10 || vget_u8(vmax_u8(a, b), 1) != 100) {
+        return mp_const_false;
+    }
+
+    if (vget_u8(vlsl_u8(vdup_u8(0x81), 1), 0) != 0x02 || vget_u8(vlsr_u8(vdup_u8(0x81), 7), 0) != 1) {
+        return mp_const_false;
+    }
+
+    a = vdup_u16(60000);
+    b = vdup_u16(1000);
+    if (vget_u16(vadd_u16(a, b), 0) != (uint16_t) 61000) {
+        return mp_const_false;
+    }
+
+    a = vset_u16(a, 1, 5);
+    if (vget_u16(vmin_u16(a, b), 0) != 1000 || vget_u16(vmin_u16(a, b), 1) != 5 ||
+        vget_u16(vmax_u16(a, b), 0) != 60000 || vget_u16(vmax_u16(a, b), 1) != 1000) {
+        return mp_const_false;
+    }
+
+    // (60000 * 7281) >> 16 = 6665
+    if (vget_u16(vmulh_n_u16(vdup_u16(60000), 7281), 0) != 6665) {
+        return mp_const_false;
+    }
+
+    // vldr_u8_widen_u16_gather: table lookup into u16 lanes.
+    uint8_t table[8] = { 0, 10, 20, 30, 40, 50, 60, 70 };
+    v128_t v = vldr_u8_widen_u16_gather(table, vidup_u16(1, 3));
+    if (vget_u16(v, 0) != 10 || vget_u16(v, 1) != 40) {
+        return mp_const_false;
+    }
+
+    // vsel_ge_s32: signed compare, selects t where v0 >= v1.
+    v = vsel_ge_s32(vdup_s32(-5), vdup_s32(-5), vdup_s32(7), vdup_s32(-7));
+    if (vget_s32(v, 0) != 7) {
+        return mp_const_false;
+    }
+
+    v = vsel_ge_s32(vdup_s32(-6), vdup_s32(3), vdup_s32(7), vdup_s32(-7));
+    if (vget_s32(v, 0) != -7) {
+        return mp_const_false;
+    }
+
+    return mp_const_true;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_simd_vminmax_int_obj, test_simd_vminmax_int);
+
 // Test predicate operations
 static mp_obj_t test_simd_predicate(void) {
     // vpredicate_8: create predicate for n u8 elements
@@ -1675,6 +1753,22 @@ static mp_obj_t test_simd_gather_scatter(void) {
         return mp_const_false;
     }
 
+    // Test vldr_s8_widen_s32 and vldr_s32
+    v = vldr_s8_widen_s32(sbuf8);
+    for (int i = 0; i < INT32_VECTOR_SIZE; i++) {
+        if (vget_s32(v, i) != sbuf8[i]) {
+            return mp_const_false;
+        }
+    }
+
+    int32_t sbuf32[4] = {-100000, 200000, -300000, 400000};
+    v = vldr_s32(sbuf32);
+    for (int i = 0; i < INT32_VECTOR_SIZE; i++) {
+        if (vget_s32(v, i) != sbuf32[i]) {
+            return mp_const_false;
+        }
+    }
+
     // Test vldr_u16_widen_u32_gather_pred
     uint16_t buf16[8] = {0x1000, 0x2000, 0x3000, 0x4000, 0x5000, 0x6000, 0x7000, 0x8000};
     offsets32 = vdup_u32(3);  // Load buf16[3]
@@ -1727,6 +1821,15 @@ static mp_obj_t test_simd_gather_scatter(void) {
     }
     #endif
 
+    // Test vstr_s32_scatter: lane i -> sout[i * 2]
+    int32_t sout[8] = {0};
+    vstr_s32_scatter(sout, vidup_u32(0, 2), vldr_s32(sbuf32));
+    for (int i = 0; i < INT32_VECTOR_SIZE; i++) {
+        if (sout[i * 2] != sbuf32[i] || sout[i * 2 + 1] != 0) {
+            return mp_const_false;
+        }
+    }
+
     // Test vstr_u16_narrow_u8_scatter
     uint8_t out8[8] = {0};
     v128_t offsets16 = vdup_u32(0);
@@ -1808,6 +1911,16 @@ static mp_obj_t test_simd_gather_scatter(void) {
     }
     #endif
 
+    // Test vldr_u32_gather_pred and vstr_s32
+    uint32_t buf32[8] = { 0, 100, 200, 300, 400, 500, 600, 700 };
+    int32_t out32[4] = { 0 };
+    pred = vpredicate_32(1);
+    v = vldr_u32_gather_pred(buf32 + 1, vdup_u32(5), pred);
+    vstr_s32(out32, v);
+    if (vget_u32(v, 0) != 600 || out32[0] != 600) {
+        return mp_const_false;
+    }
+
     return mp_const_true;
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(test_simd_gather_scatter_obj, test_simd_gather_scatter);
@@ -2051,6 +2164,7 @@ static const mp_rom_map_elem_t unittest_simd_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_test_simd_vmladav), MP_ROM_PTR(&test_simd_vmladav_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_simd_vcvt), MP_ROM_PTR(&test_simd_vcvt_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_simd_vminmax), MP_ROM_PTR(&test_simd_vminmax_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_simd_vminmax_int), MP_ROM_PTR(&test_simd_vminmax_int_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_simd_predicate), MP_ROM_PTR(&test_simd_predicate_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_simd_vldr_vstr), MP_ROM_PTR(&test_simd_vldr_vstr_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_simd_vld2_vst2), MP_ROM_PTR(&test_simd_vld2_vst2_obj) },
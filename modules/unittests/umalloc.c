@@ -685,6 +685,163 @@ static mp_obj_t test_uma_realloc_aligned(void) {
 }
 static MP_DEFINE_CONST_FUN_OBJ_0(test_uma_realloc_aligned_obj, test_uma_realloc_aligned);
 
+// Test that scratch allocations are served from the frame arena.
+static mp_obj_t test_uma_scratch_arena(void) {
+    // The first frame only records the scratch demand, the arena is sized from it.
+    uma_frame_begin();
+    uma_free(uma_malloc(1024, UMA_SCRATCH));
+    uma_frame_begin();
+
+    uma_stats_t s;
+    uma_get_stats(-1, false, &s);
+    if (s.scratch_bytes < 1024 || s.scratch_peak_bytes < 1024) {
+        return mp_const_false;
+    }
+
+    // Arena blocks aren't TLSF blocks.
+    uint8_t *a = uma_malloc(512, UMA_SCRATCH);
+    uint8_t *b = uma_malloc(256, UMA_SCRATCH | UMA_CACHE);
+    uma_get_stats(-1, true, &s);
+    bool pass = (s.used_count == 0) && ((uintptr_t) b % OMV_CACHE_LINE_SIZE == 0);
+
+    // Freeing the top block rewinds the arena.
+    uma_free(b);
+    uint8_t *c = uma_malloc(256, UMA_SCRATCH | UMA_CACHE);
+    pass = pass && (c == b);
+
+    // Blocks below the top can be freed first, the arena rewinds once the top is freed.
+    uint8_t *d = uma_malloc(128, UMA_SCRATCH);
+    uint8_t *e = uma_malloc(128, UMA_SCRATCH);
+    uma_free(d);
+    uint8_t *g = uma_malloc(64, UMA_SCRATCH);
+    pass = pass && (g > e);
+    uma_free(g);
+    uma_free(e);
+    uint8_t *h = uma_malloc(128, UMA_SCRATCH);
+    pass = pass && (h == d);
+
+    // Stale and double frees of blocks that aren't live are ignored.
+    uma_free(g);
+    uint8_t *i = uma_malloc(256, UMA_SCRATCH);
+    uma_free(h);
+    uma_free(h);
+    uma_free(i);
+    uint8_t *j = uma_malloc(128, UMA_SCRATCH);
+    pass = pass && (j == d);
+
+    // Freeing every block in any order resets the arena.
+    uma_free(c);
+    uma_free(a);
+    uma_free(j);
+    uint8_t *k = uma_malloc(64, UMA_SCRATCH);
+    uma_free(k);
+    pass = pass && (k == a);
+
+    // Blocks that don't fit fall back to the pools and are counted as misses.
+    void *f = uma_malloc(UMA_SCRATCH_MAX_SIZE * 2, UMA_SCRATCH | UMA_MAYBE);
+    uma_frame_begin();
+    uma_get_stats(-1, false, &s);
+    pass = pass && (!f || (s.scratch_misses == 1));
+    uma_free(f);
+
+    return pass ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_uma_scratch_arena_obj, test_uma_scratch_arena);
+
+// Test that nested scratch scopes restore the arena offset when released.
+static mp_obj_t test_uma_scratch_scopes(void) {
+    uma_frame_begin();
+    uma_free(uma_malloc(2048, UMA_SCRATCH));
+    uma_frame_begin();
+
+    uma_stats_t s;
+    uma_get_stats(-1, false, &s);
+    if (s.scratch_bytes < 2048) {
+        return mp_const_false;
+    }
+
+    uint8_t *a = uma_malloc(128, UMA_SCRATCH);
+    size_t outer = uma_scratch_mark();
+    uint8_t *b = uma_malloc(128, UMA_SCRATCH);
+    size_t inner = uma_scratch_mark();
+    uint8_t *c = uma_malloc(256, UMA_SCRATCH);
+    bool pass = (inner > outer) && (c > b) && (b > a);
+
+    // A block allocated before the inner scope and freed inside it stays freed.
+    uma_free(b);
+    uma_scratch_release(inner);
+    size_t mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    pass = pass && (mark == outer);
+
+    // Releasing the outer scope reclaims its blocks, stale frees of them are ignored.
+    uint8_t *d = uma_malloc(64, UMA_SCRATCH);
+    pass = pass && (d == b);
+    uma_scratch_release(outer);
+    mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    pass = pass && (mark == outer);
+    uma_free(c);
+    uma_free(d);
+
+    // Freeing the last block empties the arena.
+    uma_free(a);
+    mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    pass = pass && (mark == 0);
+
+    // The arena is released once a frame uses no scratch memory.
+    uma_frame_begin();
+    uma_frame_begin();
+    uma_get_stats(-1, false, &s);
+    pass = pass && (s.scratch_bytes == 0);
+
+    return pass ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_uma_scratch_scopes_obj, test_uma_scratch_scopes);
+
+// Test that scratch blocks left behind by a kernel that raised are reclaimed.
+static mp_obj_t test_uma_scratch_leak(void) {
+    uma_frame_begin();
+    uma_free(uma_malloc(1024, UMA_SCRATCH));
+    uma_frame_begin();
+
+    // A scope releases the blocks of a call that raised.
+    nlr_buf_t nlr;
+    uint8_t *volatile a = NULL;
+    if (nlr_push(&nlr) == 0) {
+        UMA_SCRATCH_CALL({
+            a = uma_malloc(256, UMA_SCRATCH);
+            mp_raise_msg(&mp_type_ValueError, MP_ERROR_TEXT("leak"));
+        });
+        nlr_pop();
+    }
+    size_t mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    bool pass = (a != NULL) && (mark == 0);
+
+    // Blocks leaked outside of a scope are reclaimed when the next frame begins.
+    uma_malloc(256, UMA_SCRATCH);
+    uma_frame_begin();
+    mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    pass = pass && (mark == 0);
+
+    // A frame started inside a scope keeps the blocks of that scope.
+    size_t outer = uma_scratch_mark();
+    uint8_t *b = uma_malloc(128, UMA_SCRATCH);
+    uma_frame_begin();
+    uint8_t *c = uma_malloc(128, UMA_SCRATCH);
+    pass = pass && (c > b);
+    uma_scratch_release(outer);
+    mark = uma_scratch_mark();
+    uma_scratch_release(mark);
+    pass = pass && (mark == 0);
+
+    return pass ? mp_const_true : mp_const_false;
+}
+static MP_DEFINE_CONST_FUN_OBJ_0(test_uma_scratch_leak_obj, test_uma_scratch_leak);
+
 // Module definition
 static const mp_rom_map_elem_t unittest_umalloc_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_unittest_umalloc) },
@@ -713,6 +870,9 @@ static const mp_rom_map_elem_t unittest_umalloc_module_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_test_uma_pool_dtcm_strict), MP_ROM_PTR(&test_uma_pool_dtcm_strict_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_uma_pool_dtcm_strict_fail), MP_ROM_PTR(&test_uma_pool_dtcm_strict_fail_obj) },
     { MP_ROM_QSTR(MP_QSTR_test_uma_realloc_aligned), MP_ROM_PTR(&test_uma_realloc_aligned_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_uma_scratch_arena), MP_ROM_PTR(&test_uma_scratch_arena_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_uma_scratch_scopes), MP_ROM_PTR(&test_uma_scratch_scopes_obj) },
+    { MP_ROM_QSTR(MP_QSTR_test_uma_scratch_leak), MP_ROM_PTR(&test_uma_scratch_leak_obj) },
 };
 
 static MP_DEFINE_CONST_DICT(unittest_umalloc_module_globals, unittest_umalloc_module_globals_table);
@@ -85,6 +85,7 @@
 #include "py_imu.h"
 #include "omv_gpio.h"
 #include "omv_protocol.h"
+#include "trace.h"
 
 NORETURN void __fatal_error(const char *msg);
 extern void machine_pwm_deinit_all(void);
@@ -108,6 +109,11 @@ int main(void) {
     ospi_flash_init();
     #endif
 
+    #if OMV_TRACE_ENABLE
+    // Start recording before anything is traced, the buffer is kept across soft resets.
+    omv_trace_init();
+    #endif
+
 soft_reset:
     #if CORE_M55_HP
     omv_gpio_write(&omv_pin_LED_R, 1);
@@ -311,6 +311,9 @@ int alif_csi_snapshot(omv_csi_t *csi, image_t *dst_image, uint32_t flags) {
             return OMV_CSI_ERROR_WOULD_BLOCK;
         }
 
+        // Compress the staged preview frame while waiting.
+        framebuffer_poll_preview();
+
         if ((mp_hal_ticks_ms() - start) > OMV_CSI_TIMEOUT_MS) {
             omv_csi_abort(csi, true, false);
             return OMV_CSI_ERROR_CAPTURE_TIMEOUT;
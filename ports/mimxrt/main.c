@@ -71,6 +71,7 @@
 #include "mp_utils.h"
 #include "mimxrt_hal.h"
 #include "omv_protocol.h"
+#include "trace.h"
 
 #if MICROPY_PY_MACHINE_CAN
 extern void machine_can_deinit_all(void);
@@ -87,6 +88,11 @@ int main(void) {
     led_init();
     pendsv_init();
 
+    #if OMV_TRACE_ENABLE
+    // Start recording before anything is traced, the buffer is kept across soft resets.
+    omv_trace_init();
+    #endif
+
 soft_reset:
     led_init();
 
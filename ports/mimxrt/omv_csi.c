@@ -129,6 +129,7 @@ void omv_csi_sof_callback(omv_csi_t *csi) {
     vbuffer_t *buffer = framebuffer_acquire(csi->fb, FB_FLAG_FREE | FB_FLAG_PEEK);
 
     if (buffer == NULL) {
+        framebuffer_drop_frame(csi->fb);
         omv_csi_abort(csi, false, true);
         return;
     } else if (csi->one_shot) {
@@ -417,6 +418,9 @@ int imx_csi_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
             return OMV_CSI_ERROR_WOULD_BLOCK;
         }
 
+        // Compress the staged preview frame while waiting.
+        framebuffer_poll_preview();
+
         if ((mp_hal_ticks_ms() - start) > OMV_CSI_TIMEOUT_MS) {
             omv_csi_abort(csi, true, false);
             return OMV_CSI_ERROR_CAPTURE_TIMEOUT;
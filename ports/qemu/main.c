@@ -46,6 +46,7 @@
 #include "umalloc.h"
 #include "framebuffer.h"
 #include "omv_csi.h"
+#include "trace.h"
 
 #if MICROPY_PY_LWIP
 #include "lwip/init.h"
@@ -70,6 +71,11 @@ int main(int argc, char **argv) {
     mod_network_lwip_init();
     #endif
 
+    #if OMV_TRACE_ENABLE
+    // Start recording before anything is traced, the buffer is kept across soft resets.
+    omv_trace_init();
+    #endif
+
 soft_reset:
     // Initialise stack extents and GC heap.
     extern uint8_t _estack, _sstack, _heap_start, _heap_end;
@@ -44,6 +44,7 @@ CFLAGS += -D$(TARGET) \
           -DARM_NN_TRUNCATE=1 \
           -DCMSIS_MCU_H=$(CMSIS_MCU_H) \
           -DOMV_CPU_FREQ_HZ=$(CPU_FREQ_HZ) \
+          -DOMV_SAMPLER_ENABLE=1 \
           $(OMV_BOARD_CFLAGS)
 
 # Linker Flags
@@ -149,6 +150,12 @@ ifneq ($(QEMU_MACHINE),)
 QEMU_SYSTEM = qemu-system-arm
 QEMU_ARGS += -machine $(QEMU_MACHINE) -nographic -monitor null -semihosting
 
+# Ties the virtual clock to the instruction count, which makes the timers (and the
+# benchmark results) deterministic, e.g. make run QEMU_ICOUNT=0
+ifdef QEMU_ICOUNT
+QEMU_ARGS += -icount shift=$(QEMU_ICOUNT)
+endif
+
 ifdef OMV_ROMFS_PART0_ORIGIN
 QEMU_ARGS += -device loader,file=$(FW_DIR)/romfs0.img,addr=$(OMV_ROMFS_PART0_ORIGIN),force-raw=on
 endif
@@ -0,0 +1,82 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2025 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Sampling profiler timer for QEMU/FVP port.
+ */
+// The MPS3 (SSE-300) timers at 0x48000000 are Armv8-M system timers, not CMSDK
+// APB timers, so sampling isn't supported there and it uses the weak default.
+#if OMV_SAMPLER_ENABLE && !defined(QEMU_SOC_MPS3)
+#include <stdint.h>
+#include CMSIS_MCU_H
+#include "omv_sampler.h"
+
+// MPS2 CMSDK APB timer 0 base address and IRQ.
+#define SAMPLER_TIMER_BASE      (0x40000000)
+#define SAMPLER_TIMER_IRQ       (8)
+#define SAMPLER_TIMER_IRQ_PRI   (0)
+
+typedef struct {
+    volatile uint32_t CTRL;
+    volatile uint32_t VALUE;
+    volatile uint32_t RELOAD;
+    volatile uint32_t INTCLEAR;
+} cmsdk_timer_t;
+
+#define SAMPLER_TIMER           ((cmsdk_timer_t *) SAMPLER_TIMER_BASE)
+#define CMSDK_TIMER_CTRL_EN     (1 << 0)
+#define CMSDK_TIMER_CTRL_IRQEN  (1 << 3)
+
+static void sampler_timer_ack(void) {
+    SAMPLER_TIMER->INTCLEAR = 1;
+}
+
+OMV_SAMPLER_IRQ_HANDLER(sampler_timer_irq_handler, sampler_timer_ack)
+
+int omv_sampler_timer_start(uint32_t rate_hz) {
+    // The timer is clocked from the system clock.
+    uint32_t reload = OMV_CPU_FREQ_HZ / rate_hz;
+    if (!reload) {
+        return -1;
+    }
+
+    SAMPLER_TIMER->CTRL = 0;
+    SAMPLER_TIMER->INTCLEAR = 1;
+    SAMPLER_TIMER->RELOAD = reload - 1;
+    SAMPLER_TIMER->VALUE = reload - 1;
+
+    NVIC_SetVector((IRQn_Type) SAMPLER_TIMER_IRQ, (uint32_t) sampler_timer_irq_handler);
+    NVIC_SetPriority((IRQn_Type) SAMPLER_TIMER_IRQ, SAMPLER_TIMER_IRQ_PRI);
+    NVIC_ClearPendingIRQ((IRQn_Type) SAMPLER_TIMER_IRQ);
+    NVIC_EnableIRQ((IRQn_Type) SAMPLER_TIMER_IRQ);
+
+    SAMPLER_TIMER->CTRL = CMSDK_TIMER_CTRL_EN | CMSDK_TIMER_CTRL_IRQEN;
+    return 0;
+}
+
+void omv_sampler_timer_stop(void) {
+    SAMPLER_TIMER->CTRL = 0;
+    NVIC_DisableIRQ((IRQn_Type) SAMPLER_TIMER_IRQ);
+    NVIC_ClearPendingIRQ((IRQn_Type) SAMPLER_TIMER_IRQ);
+    SAMPLER_TIMER->INTCLEAR = 1;
+}
+#endif // OMV_SAMPLER_ENABLE && !defined(QEMU_SOC_MPS3)
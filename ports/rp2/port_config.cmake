@@ -176,17 +176,20 @@ target_sources(${MICROPY_TARGET} PRIVATE
     ${TOP_DIR}/lib/imlib/mjpeg.c
     ${TOP_DIR}/lib/imlib/orb.c
     ${TOP_DIR}/lib/imlib/phasecorrelation.c
+    ${TOP_DIR}/lib/imlib/pipeline.c
     ${TOP_DIR}/lib/imlib/point.c
     ${TOP_DIR}/lib/imlib/ppm.c
     ${TOP_DIR}/lib/imlib/qrcode.c
     ${TOP_DIR}/lib/imlib/qsort.c
     ${TOP_DIR}/lib/imlib/rainbow_tab.c
     ${TOP_DIR}/lib/imlib/rectangle.c
+    ${TOP_DIR}/lib/imlib/remap.c
     ${TOP_DIR}/lib/imlib/selective_search.c
     ${TOP_DIR}/lib/imlib/sincos_tab.c
     ${TOP_DIR}/lib/imlib/stats.c
     ${TOP_DIR}/lib/imlib/stereo.c
     ${TOP_DIR}/lib/imlib/template.c
+    ${TOP_DIR}/lib/imlib/tracker.c
     ${TOP_DIR}/lib/imlib/xyz_tab.c
     ${TOP_DIR}/lib/imlib/yuv.c
     ${TOP_DIR}/lib/imlib/zbar.c
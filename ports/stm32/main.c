@@ -90,6 +90,7 @@
 #include "omv_protocol.h"
 #include "mp_utils.h"
 #include "framebuffer.h"
+#include "trace.h"
 
 #include "sdram.h"
 #include "stm_xspi.h"
@@ -196,6 +197,11 @@ int main(void) {
     // Re-enable IRQs (disabled by bootloader)
     __enable_irq();
 
+    #if OMV_TRACE_ENABLE
+    // Start recording before anything is traced, the buffer is kept across soft resets.
+    omv_trace_init();
+    #endif
+
 soft_reset:
     for (size_t i = 0; i < 4; i++) {
         led_state(i + 1, 0);
@@ -47,19 +47,11 @@ static void omv_crc_init(void) {
 }
 
 uint16_t omv_crc16_start(const void *buf, size_t len) {
-    if (!crc_initialized) {
-        omv_crc_init();
-    }
-
-    // Set CRC16 polynomial and length directly
-    WRITE_REG(hcrc.Instance->POL, OMV_CRC16_POLY);
-    MODIFY_REG(hcrc.Instance->CR, CRC_CR_POLYSIZE, CRC_POLYLENGTH_16B);
-
     if (len == 0) {
         return OMV_CRC16_INIT;
     }
 
-    return (uint16_t) HAL_CRC_Calculate(&hcrc, (uint32_t *) buf, len);
+    return omv_crc16_update(OMV_CRC16_INIT, buf, len);
 }
 
 uint16_t omv_crc16_update(uint16_t crc, const void *buf, size_t len) {
@@ -67,30 +59,43 @@ uint16_t omv_crc16_update(uint16_t crc, const void *buf, size_t len) {
         return crc;
     }
 
-    return (uint16_t) HAL_CRC_Accumulate(&hcrc, (uint32_t *) buf, len);
-}
-
-uint32_t omv_crc32_start(const void *buf, size_t len) {
     if (!crc_initialized) {
         omv_crc_init();
     }
 
-    // Set CRC32 polynomial and length directly
-    WRITE_REG(hcrc.Instance->POL, OMV_CRC32_POLY);
-    MODIFY_REG(hcrc.Instance->CR, CRC_CR_POLYSIZE, CRC_POLYLENGTH_32B);
+    // Set CRC16 polynomial and length directly, and seed the CRC with the previous
+    // value so updates can be interleaved with other CRC calculations.
+    WRITE_REG(hcrc.Instance->POL, OMV_CRC16_POLY);
+    MODIFY_REG(hcrc.Instance->CR, CRC_CR_POLYSIZE, CRC_POLYLENGTH_16B);
+    WRITE_REG(hcrc.Instance->INIT, crc);
 
+    return (uint16_t) HAL_CRC_Calculate(&hcrc, (uint32_t *) buf, len);
+}
+
+uint32_t omv_crc32_start(const void *buf, size_t len) {
     if (len == 0) {
         return OMV_CRC32_INIT;
     }
 
-    return HAL_CRC_Calculate(&hcrc, (uint32_t *) buf, len);
+    return omv_crc32_update(OMV_CRC32_INIT, buf, len);
 }
 
 uint32_t omv_crc32_update(uint32_t crc, const void *buf, size_t len) {
     if (len == 0) {
         return crc;
     }
-    return HAL_CRC_Accumulate(&hcrc, (uint32_t *) buf, len);
+
+    if (!crc_initialized) {
+        omv_crc_init();
+    }
+
+    // Set CRC32 polynomial and length directly, and seed the CRC with the previous
+    // value so updates can be interleaved with other CRC calculations.
+    WRITE_REG(hcrc.Instance->POL, OMV_CRC32_POLY);
+    MODIFY_REG(hcrc.Instance->CR, CRC_CR_POLYSIZE, CRC_POLYLENGTH_32B);
+    WRITE_REG(hcrc.Instance->INIT, crc);
+
+    return HAL_CRC_Calculate(&hcrc, (uint32_t *) buf, len);
 }
 
 #endif // STM32F7 || STM32H7 || STM32N6
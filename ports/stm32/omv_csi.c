@@ -44,6 +44,7 @@
 #include "stm_dma.h"
 #include "stm_isp.h"
 #include "stm_pwm.h"
+#include "trace.h"
 
 #if defined(DCMIPP)
 #define USE_DCMIPP          (1)
@@ -455,6 +456,7 @@ static void stm_csi_frame_event(omv_csi_t *csi, uint32_t pipe) {
 
     // Release the buffer from free queue -> used queue.
     framebuffer_release(fb, FB_FLAG_FREE | FB_FLAG_CHECK_LAST);
+    OMV_TRACE_INSTANT("frame");
 
     if (csi->frame_cb.fun) {
         csi->frame_cb.fun(csi->frame_cb.arg);
@@ -508,6 +510,7 @@ void DCMI_DMAConvCpltUser(DCMI_HandleTypeDef *hdcmi, uint32_t addr) {
     // Acquire a buffer from the free queue.
     vbuffer_t *buffer = framebuffer_acquire(fb, FB_FLAG_FREE | FB_FLAG_PEEK);
     if (buffer == NULL) {
+        framebuffer_drop_frame(fb);
         omv_csi_abort(csi, false, true);
         return;
     }
@@ -728,6 +731,9 @@ static int stm_csi_snapshot(omv_csi_t *csi, image_t *image, uint32_t flags) {
             return OMV_CSI_ERROR_WOULD_BLOCK;
         }
 
+        // Compress the staged preview frame while waiting.
+        framebuffer_poll_preview();
+
         if ((mp_hal_ticks_ms() - start) > OMV_CSI_TIMEOUT_MS) {
             omv_csi_abort(csi, true, false);
             return OMV_CSI_ERROR_CAPTURE_TIMEOUT;
@@ -70,6 +70,18 @@ CFLAGS += -D$(MCU) \
           -DSTM32_HAL_H='<stm32$(MCU_SERIES)xx_hal.h>' \
           $(OMV_BOARD_CFLAGS)
 
+# Enable the sampling profiler (uses a spare timer, see stm_sampler.c). Unlike
+# PROFILE_ENABLE it doesn't instrument the firmware, so it works in release builds.
+ifeq ($(SAMPLER_ENABLE), 1)
+# Number of histogram records (must be a power of 2, up to 65536).
+SAMPLER_POOL ?= 1024
+# Samples are counted per 2^SAMPLER_GRANULE bytes of code.
+SAMPLER_GRANULE ?= 4
+CFLAGS += -DOMV_SAMPLER_ENABLE=1
+CFLAGS += -DOMV_SAMPLER_POOL_SIZE=$(SAMPLER_POOL)
+CFLAGS += -DOMV_SAMPLER_PC_SHIFT=$(SAMPLER_GRANULE)
+endif
+
 # Linker Flags
 LDFLAGS = -mthumb \
           -mcpu=$(CPU) \
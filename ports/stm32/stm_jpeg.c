@@ -34,6 +34,7 @@
 #include STM32_HAL_H
 #include "irq.h"
 #include "stm_dma.h"
+#include "trace.h"
 
 #if (OMV_VENC_CODEC_ENABLE == 1)
 #include "jpegencapi.h"
@@ -284,7 +285,7 @@ static void jpeg_compress_data_ready(JPEG_HandleTypeDef *hjpeg, uint8_t *pDataOu
     }
 }
 
-bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
+static bool jpeg_compress_hw(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
     #if (OMV_VENC_CODEC_ENABLE == 1)
     // Try VC8000 first. Returns -1 if not handled (fall through), 0=success, 1=error.
     int vc = jpeg_compress_vc8000(src, dst, quality, subsampling);
@@ -562,6 +563,13 @@ exit_cleanup:
     return jpeg_overflow;
 }
 
+bool jpeg_compress(image_t *src, image_t *dst, int quality, bool realloc, jpeg_subsampling_t subsampling) {
+    bool overflow;
+    // Allocating the output can raise, which would skip the end of a scope.
+    OMV_TRACE_CALL("jpeg", overflow = jpeg_compress_hw(src, dst, quality, realloc, subsampling));
+    return overflow;
+}
+
 static void jpeg_decompress_data_ready_abort(JPEG_HandleTypeDef *hjpeg, uint8_t *pDataOut, uint32_t OutDataLength) {
     HAL_JPEG_Abort(hjpeg);
 }
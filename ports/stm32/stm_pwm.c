@@ -10,7 +10,7 @@ typedef struct _tim_info {
     uint32_t pulse;
 } tim_info_t;
 
-static uint32_t stm_tim_get_source_clock(TIM_TypeDef *inst) {
+uint32_t stm_tim_get_source_clock(TIM_TypeDef *inst) {
     uint32_t source = 0;
     #if defined(STM32F4) || defined(STM32F7) || defined(STM32H7)
     uintptr_t base = ((uintptr_t) inst) & 0xFFFF0000u;
@@ -29,6 +29,7 @@
 #include <stdbool.h>
 #include STM32_HAL_H
 
+uint32_t stm_tim_get_source_clock(TIM_TypeDef *inst);
 int stm_pwm_start(TIM_HandleTypeDef *tim, TIM_TypeDef *inst, uint32_t channel, uint32_t frequency);
 int stm_pwm_stop(TIM_HandleTypeDef *tim, uint32_t channel);
 uint32_t stm_pwm_get_frequency(TIM_HandleTypeDef *tim, uint32_t channel);
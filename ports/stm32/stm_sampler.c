@@ -0,0 +1,168 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2025 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * Sampling profiler timer for STM32 port.
+ */
+#if OMV_SAMPLER_ENABLE
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include STM32_HAL_H
+
+#include "board_config.h"
+#include "omv_sampler.h"
+#include "stm_pwm.h"
+
+// Basic timer used for sampling, it's not used by the firmware. Boards can
+// override it, the timer must be clocked from APB1 (or the TIM kernel clock).
+// The timer may still be used from Python while not sampling, so its state
+// is saved on start and restored on stop.
+#ifndef OMV_SAMPLER_TIM
+#define OMV_SAMPLER_TIM                 (TIM7)
+#define OMV_SAMPLER_TIM_IRQn            (TIM7_IRQn)
+#define OMV_SAMPLER_TIM_CLK_ENABLE()    __HAL_RCC_TIM7_CLK_ENABLE()
+#define OMV_SAMPLER_TIM_CLK_DISABLE()   __HAL_RCC_TIM7_CLK_DISABLE()
+#define OMV_SAMPLER_TIM_CLK_ENABLED()   __HAL_RCC_TIM7_IS_CLK_ENABLED()
+#endif
+#define SAMPLER_TIM_IRQ_PRI             (0)
+
+// The vector table is in flash, and the timer's IRQ handler is owned by
+// MicroPython, so the table is copied to RAM to install the sampling handler.
+#define SAMPLER_VECTORS                 (256)
+static uint32_t sampler_vectors[SAMPLER_VECTORS] __attribute__((aligned(SAMPLER_VECTORS * 4)));
+
+static struct {
+    uint32_t vtor;
+    uint32_t vector;
+    uint32_t priority;
+    bool irq_enabled;
+    bool clk_enabled;
+    uint32_t psc, arr, dier;
+} sampler_saved;
+
+static void sampler_timer_ack(void) {
+    OMV_SAMPLER_TIM->SR = ~TIM_SR_UIF;
+}
+
+OMV_SAMPLER_IRQ_HANDLER(sampler_timer_irq_handler, sampler_timer_ack)
+
+static int sampler_vectors_init(void) {
+    if (OMV_SAMPLER_TIM_IRQn + NVIC_USER_IRQ_OFFSET >= SAMPLER_VECTORS) {
+        return -1;
+    }
+
+    sampler_saved.vtor = SCB->VTOR;
+    if (sampler_saved.vtor != (uint32_t) sampler_vectors) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        memcpy(sampler_vectors, (void *) sampler_saved.vtor, sizeof(sampler_vectors));
+        __DSB();
+        SCB->VTOR = (uint32_t) sampler_vectors;
+        __DSB();
+        __ISB();
+        __set_PRIMASK(primask);
+    }
+    return 0;
+}
+
+static void sampler_vectors_deinit(void) {
+    if (SCB->VTOR != sampler_saved.vtor) {
+        uint32_t primask = __get_PRIMASK();
+        __disable_irq();
+        __DSB();
+        SCB->VTOR = sampler_saved.vtor;
+        __DSB();
+        __ISB();
+        __set_PRIMASK(primask);
+    }
+}
+
+int omv_sampler_timer_start(uint32_t rate_hz) {
+    // Fail if the timer is already in use.
+    sampler_saved.clk_enabled = OMV_SAMPLER_TIM_CLK_ENABLED();
+    if (sampler_saved.clk_enabled && (OMV_SAMPLER_TIM->CR1 & TIM_CR1_CEN)) {
+        return -1;
+    }
+
+    uint32_t ticks = stm_tim_get_source_clock(OMV_SAMPLER_TIM) / rate_hz;
+    if (!ticks || sampler_vectors_init() != 0) {
+        return -1;
+    }
+
+    // Basic timers have a 16-bit counter.
+    uint32_t prescaler = (ticks - 1) / 65536;
+    uint32_t period = ticks / (prescaler + 1);
+
+    OMV_SAMPLER_TIM_CLK_ENABLE();
+    sampler_saved.psc = OMV_SAMPLER_TIM->PSC;
+    sampler_saved.arr = OMV_SAMPLER_TIM->ARR;
+    sampler_saved.dier = OMV_SAMPLER_TIM->DIER;
+    OMV_SAMPLER_TIM->DIER = 0;
+    OMV_SAMPLER_TIM->CR1 = 0;
+    OMV_SAMPLER_TIM->PSC = prescaler;
+    OMV_SAMPLER_TIM->ARR = period - 1;
+    OMV_SAMPLER_TIM->CNT = 0;
+    // Load the prescaler, and clear the update flag the event sets.
+    OMV_SAMPLER_TIM->EGR = TIM_EGR_UG;
+    OMV_SAMPLER_TIM->SR = 0;
+
+    sampler_saved.vector = NVIC_GetVector(OMV_SAMPLER_TIM_IRQn);
+    sampler_saved.priority = NVIC_GetPriority(OMV_SAMPLER_TIM_IRQn);
+    sampler_saved.irq_enabled = NVIC_GetEnableIRQ(OMV_SAMPLER_TIM_IRQn);
+    NVIC_DisableIRQ(OMV_SAMPLER_TIM_IRQn);
+    NVIC_SetVector(OMV_SAMPLER_TIM_IRQn, (uint32_t) sampler_timer_irq_handler);
+    NVIC_SetPriority(OMV_SAMPLER_TIM_IRQn, SAMPLER_TIM_IRQ_PRI);
+    NVIC_ClearPendingIRQ(OMV_SAMPLER_TIM_IRQn);
+    NVIC_EnableIRQ(OMV_SAMPLER_TIM_IRQn);
+
+    OMV_SAMPLER_TIM->DIER = TIM_DIER_UIE;
+    OMV_SAMPLER_TIM->CR1 = TIM_CR1_CEN;
+    return 0;
+}
+
+void omv_sampler_timer_stop(void) {
+    OMV_SAMPLER_TIM->CR1 = 0;
+    OMV_SAMPLER_TIM->DIER = 0;
+    OMV_SAMPLER_TIM->SR = 0;
+    NVIC_DisableIRQ(OMV_SAMPLER_TIM_IRQn);
+    NVIC_ClearPendingIRQ(OMV_SAMPLER_TIM_IRQn);
+
+    // Give the timer back in the state it was found in.
+    OMV_SAMPLER_TIM->PSC = sampler_saved.psc;
+    OMV_SAMPLER_TIM->ARR = sampler_saved.arr;
+    OMV_SAMPLER_TIM->EGR = TIM_EGR_UG;
+    OMV_SAMPLER_TIM->SR = 0;
+    OMV_SAMPLER_TIM->DIER = sampler_saved.dier;
+    NVIC_SetVector(OMV_SAMPLER_TIM_IRQn, sampler_saved.vector);
+    NVIC_SetPriority(OMV_SAMPLER_TIM_IRQn, sampler_saved.priority);
+    sampler_vectors_deinit();
+
+    if (sampler_saved.irq_enabled) {
+        NVIC_EnableIRQ(OMV_SAMPLER_TIM_IRQn);
+    }
+
+    if (!sampler_saved.clk_enabled) {
+        OMV_SAMPLER_TIM_CLK_DISABLE();
+    }
+}
+#endif // OMV_SAMPLER_ENABLE
@@ -51,6 +51,16 @@ static soft_timer_entry_t protocol_timer;
 static mp_sched_node_t protocol_sched_node;
 static void omv_protocol_poll_callback(soft_timer_entry_t *self);
 
+// In-flight fragment descriptor (windowed transfers)
+typedef struct {
+    omv_protocol_packet_t packet;   // Packet header
+    const uint8_t *data;            // Payload, owned by the caller until the transfer completes
+    uint32_t crc;                   // Payload CRC
+    uint32_t sent_ms;               // Time of the last (re)transmission
+    uint32_t rtx_timeout;           // Current RTX timeout
+    int rtx_retries;                // Remaining retries
+} omv_protocol_fragment_t;
+
 int omv_protocol_init(const omv_protocol_config_t *config) {
     if (!config) {
         return -1;
@@ -59,6 +69,7 @@ int omv_protocol_init(const omv_protocol_config_t *config) {
     // Validate config
     if (config->max_payload < OMV_PROTOCOL_MIN_PAYLOAD_SIZE ||
         config->max_payload > OMV_PROTOCOL_MAX_PAYLOAD_SIZE ||
+        config->window < 1 || config->window > OMV_PROTOCOL_MAX_WINDOW ||
         config->lock_intval_ms < OMV_PROTOCOL_MIN_LOCK_INTERVAL_MS) {
         return -1;
     }
@@ -100,6 +111,7 @@ int omv_protocol_init_default() {
         .ack_enabled = true,
         .event_enabled = true,
         .max_payload = OMV_PROTOCOL_MAX_PAYLOAD_SIZE,
+        .window = 1,
         .rtx_retries = OMV_PROTOCOL_DEF_RTX_RETRIES,
         .rtx_timeout_ms = OMV_PROTOCOL_DEF_RTX_TIMEOUT_MS,
         .lock_intval_ms = OMV_PROTOCOL_MIN_LOCK_INTERVAL_MS,
@@ -120,9 +132,14 @@ int omv_protocol_init_default() {
     omv_protocol_register_channel(&omv_stream_channel);
 
     // Register the profiler channel (if enabled)
-    #if OMV_PROFILER_ENABLE
+    #if OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
     omv_protocol_register_channel(&omv_profile_channel);
-    #endif // OMV_PROFILER_ENABLE
+    #endif // OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
+
+    // Register the loopback test channel (if enabled)
+    #if OMV_PROTOCOL_LOOPBACK_ENABLE
+    omv_protocol_register_channel(&omv_loopback_channel);
+    #endif // OMV_PROTOCOL_LOOPBACK_ENABLE
 
     #endif // OMV_PROTOCOL_DEFAULT_CHANNELS
 
@@ -298,11 +315,13 @@ static inline bool omv_protocol_is_sync(const omv_protocol_packet_t *packet) {
            omv_protocol_crc_check(OMV_CRC16, (void *) packet, OMV_PROTOCOL_HEADER_SIZE);
 }
 
-// Check if packet is a valid ACK for expected opcode/sequence
-static inline bool omv_protocol_is_ack(const omv_protocol_packet_t *packet, uint8_t opcode, uint8_t sequence) {
+// Check if packet is a valid ACK for expected opcode, and any of the
+// outstanding sequence numbers [sequence, sequence + window).
+static inline bool omv_protocol_is_ack(const omv_protocol_packet_t *packet, uint8_t opcode,
+                                       uint8_t sequence, uint8_t window) {
     return packet->sync == OMV_PROTOCOL_SYNC_WORD &&
            (packet->flags & (OMV_PROTOCOL_FLAG_ACK | OMV_PROTOCOL_FLAG_NAK)) &&
-           packet->opcode == opcode && packet->sequence == sequence &&
+           packet->opcode == opcode && (uint8_t) (packet->sequence - sequence) < window &&
            omv_protocol_crc_check(OMV_CRC16, (void *) packet, OMV_PROTOCOL_HEADER_SIZE);
 }
 
@@ -343,6 +362,178 @@ int omv_protocol_send_event(uint8_t channel_id, uint16_t event, bool wait_ack) {
     return ret;
 }
 
+// Write segments using a single vectored write if the transport supports it.
+static int omv_protocol_write_iov(const omv_protocol_channel_t *transport,
+                                  const omv_protocol_iovec_t *iov, size_t iovcnt) {
+    if (transport->writev) {
+        return transport->writev(transport, iov, iovcnt);
+    }
+
+    int sent = 0;
+    for (size_t i = 0; i < iovcnt; i++) {
+        sent += transport->write(transport, 0, iov[i].size, iov[i].data);
+    }
+    return sent;
+}
+
+// Send packet header, payload and payload CRC. The payload is sent directly from the caller's
+// memory, in one vectored write with the header if supported, or in chunks otherwise. If
+// update_crc is true, the payload CRC is calculated as the data is sent, so it overlaps the
+// transfer (e.g. DMA or USB FIFO draining) instead of delaying it.
+static int omv_protocol_write_packet(const omv_protocol_channel_t *transport, const omv_protocol_packet_t *packet,
+                                     const uint8_t *data, uint32_t *crc, bool update_crc) {
+    size_t length = data ? packet->length : 0;
+    size_t chunk = transport->writev ? length : OMV_PROTOCOL_CRC_CHUNK_SIZE;
+    omv_protocol_iovec_t iov[2] = {
+        { packet, OMV_PROTOCOL_HEADER_SIZE },
+        { data, OMV_MIN(length, chunk) },
+    };
+
+    int sent = omv_protocol_write_iov(transport, iov, length ? 2 : 1);
+
+    for (size_t offset = 0; offset < length; offset += iov[1].size) {
+        if (offset) {
+            iov[1].data = data + offset;
+            iov[1].size = OMV_MIN(length - offset, chunk);
+            sent += omv_protocol_write_iov(transport, &iov[1], 1);
+        }
+
+        // Update the CRC after the chunk is queued.
+        if (update_crc) {
+            *crc = offset ? omv_crc_update(OMV_CRC32, *crc, iov[1].data, iov[1].size) :
+                   omv_crc_start(OMV_CRC32, iov[1].data, iov[1].size);
+        }
+    }
+
+    if (length) {
+        iov[0].data = crc;
+        iov[0].size = 4;
+        sent += omv_protocol_write_iov(transport, iov, 1);
+    }
+
+    if (transport->flush && transport->flush(transport) < 0) {
+        ctx.stats.transport_errors++;
+        return -1;
+    }
+
+    if (sent != OMV_PROTOCOL_HEADER_SIZE + packet->length + (packet->length > 0 ? 4 : 0)) {
+        ctx.stats.transport_errors++;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Set RTX and recalculate the CRC.
+static void omv_protocol_set_rtx(omv_protocol_packet_t *packet) {
+    if (ctx.config.crc_enabled && !(packet->flags & OMV_PROTOCOL_FLAG_RTX)) {
+        packet->flags |= OMV_PROTOCOL_FLAG_RTX;
+        packet->crc = omv_crc_start(OMV_CRC16, packet, OMV_PROTOCOL_HEADER_SIZE - 2);
+    }
+}
+
+// Sliding window transfer, keeps up to config.window fragments in flight. An ACK acknowledges
+// all outstanding fragments up to and including its sequence number, a NAK requests the
+// retransmission of that fragment only, and a timeout retransmits the oldest fragment.
+static int omv_protocol_send_window(const omv_protocol_channel_t *transport, uint8_t opcode,
+                                    uint8_t channel_id, size_t size, const uint8_t *data, uint8_t flags) {
+    size_t head = 0;
+    size_t count = 0;
+    omv_protocol_fragment_t ring[OMV_PROTOCOL_MAX_WINDOW];
+
+    ctx.scan_offset = 0;
+    ctx.ack_opcode = opcode;
+
+    while (size > 0 || count > 0) {
+        // Fill the window with new fragments.
+        for (; size > 0 && count < ctx.config.window; count++) {
+            omv_protocol_fragment_t *frag = &ring[(head + count) % OMV_PROTOCOL_MAX_WINDOW];
+            size_t frag_len = OMV_MIN(size, ctx.config.max_payload);
+
+            frag->packet = (omv_protocol_packet_t) {
+                .sync = OMV_PROTOCOL_SYNC_WORD,
+                .sequence = ctx.sequence++,
+                .channel = channel_id,
+                .flags = (size > frag_len) ? (flags | OMV_PROTOCOL_FLAG_FRAGMENT) : flags,
+                .opcode = opcode,
+                .length = frag_len,
+            };
+
+            frag->crc = 0;
+            if (ctx.config.crc_enabled) {
+                frag->packet.crc = omv_crc_start(OMV_CRC16, &frag->packet, OMV_PROTOCOL_HEADER_SIZE - 2);
+            }
+
+            frag->data = data;
+            frag->rtx_retries = ctx.config.rtx_retries;
+            frag->rtx_timeout = ctx.config.rtx_timeout_ms;
+            frag->sent_ms = OMV_PROTOCOL_TICKS_MS();
+
+            // The payload CRC is calculated on the first transmission and reused for RTX.
+            if (omv_protocol_write_packet(transport, &frag->packet, frag->data,
+                                          &frag->crc, ctx.config.crc_enabled) != 0) {
+                return -1;
+            }
+
+            size -= frag_len;
+            data += frag_len;
+            ctx.stats.sent_packets++;
+        }
+
+        // Wait for an ACK/NAK on any outstanding fragment.
+        omv_protocol_fragment_t *oldest = &ring[head];
+        ctx.ack_status = -1;
+        ctx.ack_sequence = oldest->packet.sequence;
+        ctx.ack_window = count;
+        ctx.wait_for_ack = true;
+
+        for (;; OMV_PROTOCOL_EVENT_POLL()) {
+            omv_protocol_fragment_t *frag = NULL;
+            size_t index = 0;
+
+            if (omv_protocol_poll() == -1) {
+                return -1;
+            }
+
+            if (ctx.ack_status == OMV_PROTOCOL_STATUS_SUCCESS) {
+                // Slide the window past the acknowledged fragment.
+                index = (uint8_t) (ctx.ack_received - ctx.ack_sequence) + 1;
+                head = (head + index) % OMV_PROTOCOL_MAX_WINDOW;
+                count -= index;
+                break;
+            }
+
+            if (ctx.ack_status == OMV_PROTOCOL_STATUS_FAILED) {
+                index = (uint8_t) (ctx.ack_received - ctx.ack_sequence);
+                frag = &ring[(head + index) % OMV_PROTOCOL_MAX_WINDOW];
+            } else if (omv_protocol_check_timeout(oldest->sent_ms, oldest->rtx_timeout)) {
+                frag = oldest;
+            }
+
+            if (frag) {
+                if (frag->rtx_retries-- <= 0) {
+                    omv_protocol_reset();
+                    return -1;
+                }
+
+                // Double RTX timeout
+                frag->rtx_timeout *= 2;
+                ctx.stats.retransmit++;
+                omv_protocol_set_rtx(&frag->packet);
+
+                if (omv_protocol_write_packet(transport, &frag->packet, frag->data, &frag->crc, false) != 0) {
+                    return -1;
+                }
+
+                frag->sent_ms = OMV_PROTOCOL_TICKS_MS();
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
 int omv_protocol_send_packet(uint8_t opcode, uint8_t channel_id, size_t size, const void *data, uint8_t flags) {
     const omv_protocol_channel_t *transport = omv_protocol_find_transport();
     if (!transport || !transport->is_active(transport)) {
@@ -356,11 +547,18 @@ int omv_protocol_send_packet(uint8_t opcode, uint8_t channel_id, size_t size, co
         flags |= OMV_PROTOCOL_FLAG_ACK_REQ;
     }
 
+    // Pipeline fragmented transfers if a window was negotiated.
+    if (ctx.config.window > 1 && data && size > ctx.config.max_payload &&
+        (flags & OMV_PROTOCOL_FLAG_ACK_REQ) && !(flags & OMV_PROTOCOL_FLAG_EVENT)) {
+        return omv_protocol_send_window(transport, opcode, channel_id, size, data, flags);
+    }
+
     do {
         int rtx_retries = ctx.config.rtx_retries;
         uint32_t rtx_timeout = ctx.config.rtx_timeout_ms;
 
-        uint8_t crc32_bytes[4];
+        uint32_t crc32 = 0;
+        bool update_crc = ctx.config.crc_enabled;
         size_t frag_len = (size <= ctx.config.max_payload) ? size : ctx.config.max_payload;
         uint8_t frag_flags = (size <= ctx.config.max_payload) ? flags : (flags | OMV_PROTOCOL_FLAG_FRAGMENT);
 
@@ -379,37 +577,22 @@ int omv_protocol_send_packet(uint8_t opcode, uint8_t channel_id, size_t size, co
             packet.crc = omv_crc_start(OMV_CRC16, &packet, OMV_PROTOCOL_HEADER_SIZE - 2);
         }
 
-        // Calculate payload CRC (excluding the CRC field itself)
-        if (ctx.config.crc_enabled && size && data) {
-            *((uint32_t *) crc32_bytes) = omv_crc_start(OMV_CRC32, data, frag_len);
-        }
-
         // Set up ACK waiting context
         if (flags & OMV_PROTOCOL_FLAG_ACK_REQ) {
             ctx.scan_offset = 0;
             ctx.ack_status = -1;
             ctx.ack_opcode = packet.opcode;
             ctx.ack_sequence = packet.sequence;
+            ctx.ack_window = 1;
             ctx.wait_for_ack = true;
         }
 
         do {
-            // Send packet header, payload and CRC
-            int sent = transport->write(transport, 0, OMV_PROTOCOL_HEADER_SIZE, &packet);
-            if (size && data) {
-                sent += transport->write(transport, 0, frag_len, data);
-                sent += transport->write(transport, 0, 4, crc32_bytes);
-            }
-
-            if (transport->flush && transport->flush(transport) < 0) {
-                ctx.stats.transport_errors++;
-                return -1;
-            }
-
-            if (sent != OMV_PROTOCOL_HEADER_SIZE + frag_len + (frag_len > 0 ? 4 : 0)) {
-                ctx.stats.transport_errors++;
+            // The payload CRC is calculated on the first transmission and reused for RTX.
+            if (omv_protocol_write_packet(transport, &packet, data, &crc32, update_crc) != 0) {
                 return -1;
             }
+            update_crc = false;
 
             for (uint32_t start = OMV_PROTOCOL_TICKS_MS(); ctx.wait_for_ack; OMV_PROTOCOL_EVENT_POLL()) {
                 if (omv_protocol_poll() == -1) {
@@ -431,12 +614,8 @@ int omv_protocol_send_packet(uint8_t opcode, uint8_t channel_id, size_t size, co
                     // Double RTX timeout
                     rtx_timeout *= 2;
                     ctx.stats.retransmit++;
-
-                    // Set RTX and recalculate the CRC.
-                    if (ctx.config.crc_enabled && !(packet.flags & OMV_PROTOCOL_FLAG_RTX)) {
-                        packet.flags |= OMV_PROTOCOL_FLAG_RTX;
-                        packet.crc = omv_crc_start(OMV_CRC16, &packet, OMV_PROTOCOL_HEADER_SIZE - 2);
-                    }
+                    ctx.ack_status = -1;
+                    omv_protocol_set_rtx(&packet);
                     break;
                 }
             }
@@ -589,6 +768,18 @@ int omv_protocol_poll(void) {
 
             // Scan through buffer looking for expected ACK packet
             case OMV_PROTOCOL_STATE_WAIT_ACK:
+                // Drop ACK/NAKs for sequences outside the window (duplicates of cumulative ACKs or
+                // already acknowledged ones) from the head, otherwise they pin the buffer.
+                if (buffer_size >= OMV_PROTOCOL_HEADER_SIZE &&
+                    omv_protocol_is_ack(packet, packet->opcode, packet->sequence, 1) &&
+                    !omv_protocol_is_ack(packet, ctx.ack_opcode, ctx.ack_sequence, ctx.ack_window)) {
+                    size_t ack_size = OMV_PROTOCOL_PACKET_GET_SIZE(packet);
+                    ctx.scan_offset = 0;
+                    omv_buffer_consume(&ctx.buffer, (buffer_size >= ack_size) ?
+                                       ack_size : OMV_PROTOCOL_HEADER_SIZE);
+                    break;
+                }
+
                 for (; ctx.scan_offset <= buffer_size - OMV_PROTOCOL_HEADER_SIZE; ctx.scan_offset++) {
                     omv_protocol_packet_t *packet = (omv_protocol_packet_t *) (buffer + ctx.scan_offset);
 
@@ -599,15 +790,20 @@ int omv_protocol_poll(void) {
                     }
 
                     // Found the matching ACK/NAK - consume it and return to SYNC
-                    if (omv_protocol_is_ack(packet, ctx.ack_opcode, ctx.ack_sequence)) {
-                        ctx.scan_offset = 0;
-
-                        // Consume packet if found at the beginning of the buffer.
-                        if ((void *) packet == buffer) {
-                            omv_buffer_consume(&ctx.buffer, OMV_PROTOCOL_HEADER_SIZE);
+                    if (omv_protocol_is_ack(packet, ctx.ack_opcode, ctx.ack_sequence, ctx.ack_window)) {
+                        uint8_t flags = packet->flags;
+                        size_t ack_size = OMV_PROTOCOL_PACKET_GET_SIZE(packet);
+                        ctx.ack_received = packet->sequence;
+
+                        // Remove the packet (and NAK status if received) from the buffer. Any data
+                        // before it is kept, and rescanned since the window moves after an ACK.
+                        if ((buffer_size - ctx.scan_offset) < ack_size) {
+                            ack_size = OMV_PROTOCOL_HEADER_SIZE;
                         }
+                        omv_buffer_remove(&ctx.buffer, ctx.scan_offset, ack_size);
+                        ctx.scan_offset = 0;
 
-                        if (packet->flags & OMV_PROTOCOL_FLAG_ACK) {
+                        if (flags & OMV_PROTOCOL_FLAG_ACK) {
                             ctx.wait_for_ack = false;
                             ctx.ack_status = OMV_PROTOCOL_STATUS_SUCCESS;
                         } else {
@@ -644,6 +840,7 @@ void omv_protocol_process(const omv_protocol_packet_t *packet) {
             caps.ack_enabled = ctx.config.ack_enabled;
             caps.event_enabled = ctx.config.event_enabled;
             caps.max_payload = ctx.config.max_payload;
+            caps.window = ctx.config.window;
             // Transport fields are not sent over wire
             omv_protocol_send_packet(packet->opcode, packet->channel, sizeof(caps), &caps, 0);
             break;
@@ -655,7 +852,8 @@ void omv_protocol_process(const omv_protocol_packet_t *packet) {
             // Validate only the protocol capability fields
             if (packet->length != sizeof(omv_protocol_caps_t) ||
                 caps->max_payload < OMV_PROTOCOL_MIN_PAYLOAD_SIZE ||
-                caps->max_payload > OMV_PROTOCOL_MAX_PAYLOAD_SIZE) {
+                caps->max_payload > OMV_PROTOCOL_MAX_PAYLOAD_SIZE ||
+                caps->window > OMV_PROTOCOL_MAX_WINDOW) {
                 omv_protocol_send_status(packet->opcode, packet->channel, OMV_PROTOCOL_STATUS_INVALID);
             } else {
                 // ACK the updated caps first before changing them.
@@ -667,6 +865,8 @@ void omv_protocol_process(const omv_protocol_packet_t *packet) {
                 ctx.config.ack_enabled = caps->ack_enabled;
                 ctx.config.event_enabled = caps->event_enabled;
                 ctx.config.max_payload = caps->max_payload;
+                // Hosts that predate windowing send 0 (reserved), fall back to stop-and-wait.
+                ctx.config.window = OMV_MAX(caps->window, 1);
             }
             break;
         }
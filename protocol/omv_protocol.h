@@ -46,7 +46,7 @@
 
 #define OMV_PROTOCOL_VERSION_MAJOR          (1)
 #define OMV_PROTOCOL_VERSION_MINOR          (0)
-#define OMV_PROTOCOL_VERSION_PATCH          (2)
+#define OMV_PROTOCOL_VERSION_PATCH          (5)
 
 #define OMV_PROTOCOL_SYNC_SIZE              (2)
 #define OMV_PROTOCOL_SYNC_WORD              (0xD5AA)
@@ -57,6 +57,11 @@
 #define OMV_PROTOCOL_DEF_RTX_RETRIES        (3)
 #define OMV_PROTOCOL_DEF_RTX_TIMEOUT_MS     (500)   // Doubled after each timeout
 #define OMV_PROTOCOL_MIN_LOCK_INTERVAL_MS   (10)
+#define OMV_PROTOCOL_MAX_WINDOW             (8)     // Max outstanding fragments (1 = stop-and-wait)
+
+#ifndef OMV_PROTOCOL_CRC_CHUNK_SIZE
+#define OMV_PROTOCOL_CRC_CHUNK_SIZE         (512)   // Payload CRC is updated after each chunk is sent
+#endif
 
 #define OMV_PROTOCOL_MAGIC_BAUDRATE         (921600)
 
@@ -254,7 +259,8 @@ typedef struct __attribute__((packed)) {
     uint32_t event_enabled : 1;
     uint32_t reserved1 : 28;
     uint16_t max_payload;
-    uint8_t reserved2[10];
+    uint8_t window;
+    uint8_t reserved2[9];
 } omv_protocol_caps_t;
 OMV_PROTOCOL_ASSERT_SIZE(omv_protocol_caps_t, 16);
 
@@ -330,6 +336,7 @@ typedef struct {
     bool ack_enabled;
     bool event_enabled;
     uint16_t max_payload;
+    uint8_t window;
     // Transport configuration (local only)
     uint16_t rtx_retries;
     uint16_t rtx_timeout_ms;
@@ -348,7 +355,9 @@ typedef struct {
 
     // ACK waiting context
     uint8_t ack_opcode;     // Opcode of waiting ACK
-    uint8_t ack_sequence;   // Sequence of waiting ACK
+    uint8_t ack_sequence;   // Sequence of the oldest unacknowledged packet
+    uint8_t ack_window;     // Number of unacknowledged packets
+    uint8_t ack_received;   // Sequence of the last ACK/NAK received
     uint8_t ack_status;     // Status of waiting ACK
 
     // Protocol configuration (capabilities + transport config)
@@ -64,6 +64,7 @@ typedef enum {
     OMV_CHANNEL_IOCTL_PROFILE_SET_EVENT = 0x01, // Set event type to profile
     OMV_CHANNEL_IOCTL_PROFILE_RESET     = 0x02, // Reset profiler data
     OMV_CHANNEL_IOCTL_PROFILE_STATS     = 0x03, // Get profiler statistics
+    OMV_CHANNEL_IOCTL_PROFILE_TRACE     = 0x04, // Select the trace buffer (1) or statistics (0)
 } omv_channel_ioctl_profile_t;
 
 // IOCTL sizes lookup table entries
@@ -80,7 +81,8 @@ typedef enum {
     {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_MODE, 4},      \
     {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_SET_EVENT, 8}, \
     {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_RESET, 0},     \
-    {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_STATS, 0}
+    {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_STATS, 0},     \
+    {OMV_PROTOCOL_CHANNEL_ID_PROFILE, OMV_CHANNEL_IOCTL_PROFILE_TRACE, 4}
 
 /***************************************************************************
 * Channel Interface
@@ -118,6 +120,12 @@ typedef enum {
 // Forward declaration
 typedef struct omv_protocol_channel omv_protocol_channel_t;
 
+// Vectored I/O segment
+typedef struct {
+    const void *data;
+    size_t size;
+} omv_protocol_iovec_t;
+
 // Channel interface (used for both transport and logical channels)
 struct omv_protocol_channel {
     void *priv;
@@ -142,6 +150,9 @@ struct omv_protocol_channel {
     void (*tick) (const omv_protocol_channel_t *channel);
     // Transport-specific functions (for channel ID 0 only)
     bool (*is_active) (const omv_protocol_channel_t *channel);
+    // Optional vectored write, segments are sent in order and the data pointers may point to
+    // any memory (e.g. framebuffers). Returns the total number of bytes written.
+    int (*writev) (const omv_protocol_channel_t *channel, const omv_protocol_iovec_t *iov, size_t iovcnt);
 };
 
 // Default channels.
@@ -150,5 +161,6 @@ extern const omv_protocol_channel_t omv_stdin_channel;
 extern const omv_protocol_channel_t omv_stdout_channel;
 extern const omv_protocol_channel_t omv_stream_channel;
 extern const omv_protocol_channel_t omv_profile_channel;
+extern omv_protocol_channel_t omv_loopback_channel;
 
 #endif // __OMV_PROTOCOL_CHANNEL_H__
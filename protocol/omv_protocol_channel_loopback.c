@@ -0,0 +1,78 @@
+/*
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (C) 2022-2024 OpenMV, LLC.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * OpenMV Protocol Loopback Channel.
+ * Data written to this channel is stored and can be read back, which
+ * allows hosts to test link integrity and measure transfer throughput.
+ */
+
+#include "omv_common.h"
+#include "omv_protocol.h"
+#include "board_config.h"
+
+#if OMV_PROTOCOL_LOOPBACK_ENABLE
+#ifndef OMV_PROTOCOL_LOOPBACK_SIZE
+#define OMV_PROTOCOL_LOOPBACK_SIZE  (32 * 1024)
+#endif
+
+static size_t loopback_size;
+static uint8_t loopback_buffer[OMV_PROTOCOL_LOOPBACK_SIZE];
+
+static int loopback_channel_init(const omv_protocol_channel_t *channel) {
+    loopback_size = 0;
+    return 0;
+}
+
+static size_t loopback_channel_size(const omv_protocol_channel_t *channel) {
+    return loopback_size;
+}
+
+static int loopback_channel_write(const omv_protocol_channel_t *channel, uint32_t offset, size_t size, const void *data) {
+    if (offset + size > OMV_PROTOCOL_LOOPBACK_SIZE) {
+        return 0;
+    }
+    memcpy(loopback_buffer + offset, data, size);
+    loopback_size = OMV_MAX(loopback_size, offset + size);
+    return size;
+}
+
+static const void *loopback_channel_readp(const omv_protocol_channel_t *channel, uint32_t offset, size_t size) {
+    if (offset + size > loopback_size) {
+        return NULL;
+    }
+    return loopback_buffer + offset;
+}
+
+// Registered as a dynamic channel, so it's assigned the first free channel ID.
+omv_protocol_channel_t omv_loopback_channel = {
+    .priv = NULL,
+    .name = "loopback",
+    .flags = OMV_PROTOCOL_CHANNEL_FLAG_READ |
+             OMV_PROTOCOL_CHANNEL_FLAG_WRITE |
+             OMV_PROTOCOL_CHANNEL_FLAG_DYNAMIC,
+    .init = loopback_channel_init,
+    .size = loopback_channel_size,
+    .write = loopback_channel_write,
+    .readp = loopback_channel_readp,
+};
+#endif // OMV_PROTOCOL_LOOPBACK_ENABLE
@@ -26,43 +26,194 @@
 
 #include "omv_common.h"
 #include "omv_profiler.h"
+#include "omv_sampler.h"
+#include "trace.h"
 #include "omv_protocol.h"
 #include "board_config.h"
 
-#if OMV_PROFILER_ENABLE
+#if OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
+// Profiling modes set with the PROFILE_MODE ioctl.
+typedef enum {
+    PROFILE_MODE_INCLUSIVE  = 0,    // Instrumented, inclusive times
+    PROFILE_MODE_EXCLUSIVE  = 1,    // Instrumented, exclusive times
+    PROFILE_MODE_SAMPLE     = 2,    // Sampled PC histogram
+    PROFILE_MODE_SAMPLE_LR  = 3,    // Sampled PC and LR histogram
+} profile_mode_t;
+
+// Data source read by the channel.
+typedef enum {
+    PROFILE_SOURCE_STATS,
+    PROFILE_SOURCE_SAMPLES,
+    PROFILE_SOURCE_TRACE,
+} profile_source_t;
+
+static profile_source_t profile_source;
+#if OMV_TRACE_ENABLE
+// Source to go back to when the trace buffer is deselected.
+static profile_source_t profile_source_prev;
+#endif
+
 static int profile_channel_init(const omv_protocol_channel_t *channel) {
+    #if OMV_PROFILER_ENABLE
     omv_profiler_init();
+    profile_source = PROFILE_SOURCE_STATS;
+    #elif OMV_SAMPLER_ENABLE
+    profile_source = PROFILE_SOURCE_SAMPLES;
+    #else
+    profile_source = PROFILE_SOURCE_TRACE;
+    #endif
+    #if OMV_SAMPLER_ENABLE
+    omv_sampler_init();
+    #endif
+    #if OMV_TRACE_ENABLE
+    omv_trace_init();
+    #endif
     return 0;
 }
 
 static size_t profile_channel_size(const omv_protocol_channel_t *channel) {
-    return omv_profiler_get_size();
+    switch (profile_source) {
+        #if OMV_TRACE_ENABLE
+        case PROFILE_SOURCE_TRACE:
+            return omv_trace_get_size();
+        #endif
+        #if OMV_SAMPLER_ENABLE
+        case PROFILE_SOURCE_SAMPLES:
+            return omv_sampler_get_size();
+        #endif
+        #if OMV_PROFILER_ENABLE
+        case PROFILE_SOURCE_STATS:
+            return omv_profiler_get_size();
+        #endif
+        default:
+            return 0;
+    }
 }
 
 static size_t profile_channel_shape(const omv_protocol_channel_t *channel, size_t shape[4]) {
-    shape[0] = omv_profiler_get_size() / sizeof(omv_profiler_data_t);
-    shape[1] = sizeof(omv_profiler_data_t);
+    switch (profile_source) {
+        #if OMV_TRACE_ENABLE
+        case PROFILE_SOURCE_TRACE:
+            shape[0] = omv_trace_get_count();
+            shape[1] = sizeof(omv_trace_event_t);
+            break;
+        #endif
+        #if OMV_SAMPLER_ENABLE
+        case PROFILE_SOURCE_SAMPLES:
+            shape[0] = omv_sampler_get_size() / sizeof(omv_sampler_record_t);
+            shape[1] = sizeof(omv_sampler_record_t);
+            break;
+        #endif
+        #if OMV_PROFILER_ENABLE
+        case PROFILE_SOURCE_STATS:
+            shape[0] = omv_profiler_get_size() / sizeof(omv_profiler_data_t);
+            shape[1] = sizeof(omv_profiler_data_t);
+            break;
+        #endif
+        default:
+            shape[0] = shape[1] = 0;
+            break;
+    }
     return 2;
 }
 
 static int profile_channel_lock(const omv_protocol_channel_t *channel) {
-    size_t size = channel->size(channel);
-    return size && mutex_try_lock(omv_profiler_lock(), MUTEX_TID_IDE) ? 0 : -1;
+    switch (profile_source) {
+        #if OMV_TRACE_ENABLE
+        case PROFILE_SOURCE_TRACE:
+            // Recording is paused until the host unlocks the channel.
+            omv_trace_pause(true);
+            return 0;
+        #endif
+        #if OMV_SAMPLER_ENABLE
+        case PROFILE_SOURCE_SAMPLES:
+            omv_sampler_pause(true);
+            return 0;
+        #endif
+        #if OMV_PROFILER_ENABLE
+        case PROFILE_SOURCE_STATS: {
+            size_t size = channel->size(channel);
+            return size && mutex_try_lock(omv_profiler_lock(), MUTEX_TID_IDE) ? 0 : -1;
+        }
+        #endif
+        default:
+            return -1;
+    }
 }
 
 static int profile_channel_unlock(const omv_protocol_channel_t *channel) {
-    mutex_unlock(omv_profiler_lock(), MUTEX_TID_IDE);
-    return 0;
+    switch (profile_source) {
+        #if OMV_TRACE_ENABLE
+        case PROFILE_SOURCE_TRACE:
+            omv_trace_pause(false);
+            return 0;
+        #endif
+        #if OMV_SAMPLER_ENABLE
+        case PROFILE_SOURCE_SAMPLES:
+            omv_sampler_pause(false);
+            return 0;
+        #endif
+        #if OMV_PROFILER_ENABLE
+        case PROFILE_SOURCE_STATS:
+            mutex_unlock(omv_profiler_lock(), MUTEX_TID_IDE);
+            return 0;
+        #endif
+        default:
+            return -1;
+    }
 }
 
 static const void *profile_channel_readp(const omv_protocol_channel_t *channel, uint32_t offset, size_t size) {
-    const uint8_t *data = omv_profiler_get_data();
-    if (offset + size > channel->size(channel)) {
+    const uint8_t *data = NULL;
+
+    switch (profile_source) {
+        #if OMV_TRACE_ENABLE
+        case PROFILE_SOURCE_TRACE:
+            data = omv_trace_get_data();
+            break;
+        #endif
+        #if OMV_SAMPLER_ENABLE
+        case PROFILE_SOURCE_SAMPLES:
+            data = omv_sampler_get_data();
+            break;
+        #endif
+        #if OMV_PROFILER_ENABLE
+        case PROFILE_SOURCE_STATS:
+            data = omv_profiler_get_data();
+            break;
+        #endif
+        default:
+            break;
+    }
+
+    if (!data || offset + size > channel->size(channel)) {
         return NULL;
     }
     return data + offset;
 }
 
+static int profile_channel_set_mode(uint32_t mode) {
+    #if OMV_SAMPLER_ENABLE
+    if (mode == PROFILE_MODE_SAMPLE || mode == PROFILE_MODE_SAMPLE_LR) {
+        omv_sampler_reset();
+        profile_source = PROFILE_SOURCE_SAMPLES;
+        return omv_sampler_start(OMV_SAMPLER_RATE_HZ, mode == PROFILE_MODE_SAMPLE_LR);
+    }
+
+    // Any other mode stops sampling, the samples can still be read.
+    omv_sampler_stop();
+    #endif
+
+    #if OMV_PROFILER_ENABLE
+    if (mode == PROFILE_MODE_INCLUSIVE || mode == PROFILE_MODE_EXCLUSIVE) {
+        omv_profiler_set_mode(mode);
+        profile_source = PROFILE_SOURCE_STATS;
+        return 0;
+    }
+    #endif
+    return -1;
+}
+
 static int profile_channel_ioctl(const omv_protocol_channel_t *channel, uint32_t cmd, size_t len, void *arg) {
     union {
         uint8_t bytes[16];
@@ -73,14 +224,35 @@ static int profile_channel_ioctl(const omv_protocol_channel_t *channel, uint32_t
 
     switch (cmd) {
         case OMV_CHANNEL_IOCTL_PROFILE_MODE:
-            omv_profiler_set_mode(u.args[0]);
-            return 0;
+            return profile_channel_set_mode(u.args[0]);
+        #if OMV_PROFILER_ENABLE
         case OMV_CHANNEL_IOCTL_PROFILE_SET_EVENT:
             omv_profiler_set_event(u.args[0], u.args[1]);
             return 0;
+        #endif
         case OMV_CHANNEL_IOCTL_PROFILE_RESET:
+            #if OMV_PROFILER_ENABLE
             omv_profiler_reset();
+            #endif
+            #if OMV_SAMPLER_ENABLE
+            omv_sampler_reset();
+            #endif
+            #if OMV_TRACE_ENABLE
+            omv_trace_reset();
+            #endif
+            return 0;
+        #if OMV_TRACE_ENABLE
+        case OMV_CHANNEL_IOCTL_PROFILE_TRACE:
+            // Resume recording if the host switches views while locked.
+            omv_trace_pause(false);
+            if (u.args[0] && profile_source != PROFILE_SOURCE_TRACE) {
+                profile_source_prev = profile_source;
+                profile_source = PROFILE_SOURCE_TRACE;
+            } else if (!u.args[0] && profile_source == PROFILE_SOURCE_TRACE) {
+                profile_source = profile_source_prev;
+            }
             return 0;
+        #endif
         default:
             return -1;
     }
@@ -100,4 +272,4 @@ const omv_protocol_channel_t omv_profile_channel = {
     .readp = profile_channel_readp,
     .ioctl = profile_channel_ioctl,
 };
-#endif // OMV_PROFILER_ENABLE
+#endif // OMV_PROFILER_ENABLE || OMV_SAMPLER_ENABLE || OMV_TRACE_ENABLE
@@ -49,6 +49,7 @@ static int stream_channel_unlock(const omv_protocol_channel_t *channel) {
     framebuffer_t *fb = framebuffer_get(FB_STREAM_ID);
     if (mutex_get_tid(&fb->lock) == MUTEX_TID_IDE) {
         memset(fb->raw_base, 0, sizeof(framebuffer_header_t));
+        fb->unread = false;
         mutex_unlock(&fb->lock, MUTEX_TID_IDE);
     }
     return 0;
@@ -99,6 +100,7 @@ static int stream_channel_ioctl(const omv_protocol_channel_t *channel, uint32_t
             // Reset stream buffer state
             mutex_init0(&fb->lock);
             memset(fb->raw_base, 0, sizeof(framebuffer_header_t));
+            fb->unread = false;
             return 0;
         case OMV_CHANNEL_IOCTL_STREAM_RAW_CFG:
             fb->raw_w = u.args[0];
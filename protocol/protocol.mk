@@ -27,6 +27,12 @@ PROTOCOL_SRC_C += \
     omv_protocol_channel_stdio.c \
     omv_protocol_channel_stream.c \
     omv_protocol_channel_profile.c \
+    omv_protocol_channel_loopback.c \
+
+# Loopback channel for link and throughput tests.
+ifeq ($(PROTOCOL_LOOPBACK), 1)
+CFLAGS += -DOMV_PROTOCOL_LOOPBACK_ENABLE=1
+endif
 
 ifeq ($(OMV_USB_STACK_TINYUSB), 1)
 CFLAGS += -DOMV_USB_STACK_TINYUSB=1
@@ -0,0 +1,45 @@
+# This work is licensed under the MIT license.
+# Copyright (c) 2013-2025 OpenMV LLC. All rights reserved.
+# https://github.com/openmv/openmv/blob/master/LICENSE
+#
+# This example shows off using the genx320 event camera from Prophesee
+# using event streaming mode, accumulating the raw events directly into
+# an image without reading them into an ndarray first.
+
+import csi
+import image
+import time
+
+# Surface to accumulate the events on.
+img = image.Image(320, 320, image.GRAYSCALE)
+
+# Initialize the sensor.
+csi0 = csi.CSI(cid=csi.GENX320)
+csi0.reset()
+csi0.ioctl(csi.IOCTL_GENX320_SET_MODE, csi.GENX320_MODE_EVENT, 4096)
+
+# Time constant of the time surface in microseconds.
+TAU_US = 20000
+
+clock = time.clock()
+
+while True:
+    clock.tick()
+
+    # Reads a buffer of events from the camera and accumulates them into the image.
+    # Returns the number of accumulated pixel events or raises an error.
+    #
+    # GENX320_ACC_TIME_SURFACE: Each pixel is set to 255 * exp(-age / TAU_US), where
+    #   age is the time since the pixel's last event, so the image shows the recent motion.
+    # GENX320_ACC_HISTOGRAM: Adds (ON events) or subtracts (OFF events) the contrast
+    #   argument. If a brightness argument follows the image is cleared to it first:
+    #   csi0.ioctl(csi.IOCTL_GENX320_ACCUMULATE, csi.GENX320_ACC_HISTOGRAM, img, 64, 128)
+    # GENX320_ACC_VOXEL_GRID: Adds +1/-1 per event to an int16 ndarray with shape
+    #   (bins, 320, 320), splitting the time span of the events evenly between the bins:
+    #   csi0.ioctl(csi.IOCTL_GENX320_ACCUMULATE, csi.GENX320_ACC_VOXEL_GRID, grid)
+    event_count = csi0.ioctl(csi.IOCTL_GENX320_ACCUMULATE, csi.GENX320_ACC_TIME_SURFACE, img, TAU_US)
+
+    # Push the image to the jpeg buffer for the IDE to pull and display.
+    img.flush()
+
+    print(event_count, clock.fps())
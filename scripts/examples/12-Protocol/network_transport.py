@@ -11,6 +11,7 @@ communicates using the OpenMV protocol over UDP.
 The transport implements the physical layer interface required by the protocol:
 - read(): Read from UDP socket
 - write(): Buffer data for the next datagram
+- writev(): Buffer a packet's header, payload and CRC in one call (optional)
 - is_active(): Check if a client address is known
 - size(): Peek at available bytes without consuming
 - flush(): Send buffered writes as a single UDP datagram
@@ -90,6 +91,14 @@ class NetworkTransport:
         self.txlen += n
         return n
 
+    def writev(self, segments):
+        n = 0
+        for data in segments:
+            if self.write(0, data) < 0:
+                return -1
+            n += len(data)
+        return n
+
     def flush(self):
         if self.client is None or self.txlen == 0:
             return 0
@@ -35,12 +35,6 @@ _NO_DETECTION = const(())
 
 
 class mediapipe_detection_postprocess:
-    _MEDIAPIPE_CX = const(0)
-    _MEDIAPIPE_CY = const(1)
-    _MEDIAPIPE_CW = const(2)
-    _MEDIAPIPE_CH = const(3)
-    _MEDIAPIPE_KP = const(4)
-
     def __init__(self, threshold=0.6, anchors=None, anchor_grid=None, scores=[], cords=[],
                  nms_threshold=0.1, nms_sigma=0.1):
         self.threshold = threshold
@@ -69,63 +63,16 @@ class mediapipe_detection_postprocess:
     def __call__(self, model, inputs, outputs):
         ib, ih, iw, ic = model.input_shape[0]
         nms = NMS(iw, ih, inputs[0].roi)
-        output_len = outputs[0].shape[1]
+        output_len = model.output_shape[0][1]
 
-        self.detection_post_process(ih, iw, nms, model, inputs, outputs, self.scores[0], self.cords[0],
-                                    self.threshold, self.anchors[:output_len])
+        # Decodes the anchor boxes and keypoints that score above the threshold.
+        nms.add_anchors(model, self.scores[0], self.cords[0], self.anchors, self.threshold)
 
         if output_len < len(self.anchors):
-            self.detection_post_process(ih, iw, nms, model, inputs, outputs, self.scores[1], self.cords[1],
-                                        self.threshold, self.anchors[output_len:])
+            nms.add_anchors(model, self.scores[1], self.cords[1], self.anchors, self.threshold, output_len)
 
         return nms.get_bounding_boxes(threshold=self.nms_threshold, sigma=self.nms_sigma)[0]
 
-    def detection_post_process(self, ih, iw, nms, model, inputs, outputs, score_idx, cords_idx, t, anchors):
-        s_oh, s_ow, s_oc = model.output_shape[score_idx]
-        scale = model.output_scale[score_idx]
-        t = quantize(model, logit(t), index=score_idx)
-
-        # Threshold all the scores
-        score_row_outputs = outputs[score_idx].reshape((s_oh * s_ow * s_oc))
-        score_indices = threshold(score_row_outputs, t, scale)
-        if not len(score_indices):
-            return _NO_DETECTION
-
-        # Get the score information
-        bb_scores = np.take(score_row_outputs, score_indices, axis=0)
-        bb_scores = sigmoid(dequantize(model, bb_scores, index=score_idx))
-
-        # Get the bounding boxes that have a valid score
-        c_oh, c_ow, c_oc = model.output_shape[cords_idx]
-        cords_row_outputs = outputs[cords_idx].reshape((c_oh * c_ow, c_oc))
-        bb = dequantize(model, np.take(cords_row_outputs, score_indices, axis=0), index=cords_idx)
-
-        # Get the anchor box information
-        bb_a_array = np.take(anchors, score_indices, axis=0)
-
-        # Compute the bounding box information
-        ax = bb_a_array[:, _MEDIAPIPE_CX]
-        ay = bb_a_array[:, _MEDIAPIPE_CY]
-        x_center = bb[:, _MEDIAPIPE_CX] / iw + ax
-        y_center = bb[:, _MEDIAPIPE_CY] / ih + ay
-        w_rel = bb[:, _MEDIAPIPE_CW] / iw * 0.5
-        h_rel = bb[:, _MEDIAPIPE_CH] / ih * 0.5
-
-        # Get the keypoint information
-        row_count = bb.shape[0]
-        keypoints = np.empty((row_count, (c_oc - _MEDIAPIPE_KP) // 2, 2))
-        keypoints[:, :, 0] = (bb[:, _MEDIAPIPE_KP::2] / iw + ax.reshape((row_count, 1))) * iw
-        keypoints[:, :, 1] = (bb[:, _MEDIAPIPE_KP + 1::2] / ih + ay.reshape((row_count, 1))) * ih
-
-        # Scale the bounding boxes to have enough integer precision for NMS
-        xmin = (x_center - w_rel) * iw
-        ymin = (y_center - h_rel) * ih
-        xmax = (x_center + w_rel) * iw
-        ymax = (y_center + h_rel) * ih
-
-        for i in range(bb.shape[0]):
-            nms.add_bounding_box(xmin[i], ymin[i], xmax[i], ymax[i], bb_scores[i], 0, keypoints=keypoints[i])
-
 
 class BlazeFace(mediapipe_detection_postprocess):
     def __init__(self, threshold=0.6, anchors=None, nms_threshold=0.1, nms_sigma=0.1):
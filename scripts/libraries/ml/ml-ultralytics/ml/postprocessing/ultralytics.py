@@ -26,120 +26,30 @@
 # OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
 # (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
-from ml.utils import *
-from micropython import const
-from ulab import numpy as np
-
-
-_NO_DETECTION = const(())
+from ml.utils import NMS
 
 
 class YoloV5:
-    _YOLO_V5_CX = const(0)
-    _YOLO_V5_CY = const(1)
-    _YOLO_V5_CW = const(2)
-    _YOLO_V5_CH = const(3)
-    _YOLO_V5_SCORE = const(4)
-    _YOLO_V5_CLASSES = const(5)
-
     def __init__(self, threshold=0.6, nms_threshold=0.1, nms_sigma=0.1):
         self.threshold = threshold
         self.nms_threshold = nms_threshold
         self.nms_sigma = nms_sigma
 
     def __call__(self, model, inputs, outputs):
-        oh, ow, oc = model.output_shape[0]
-        scale = model.output_scale[0]
-        t = quantize(model, self.threshold)
-        class_count = oc - _YOLO_V5_CLASSES
-
-        # Reshape the output to a 2D array
-        row_outputs = outputs[0].reshape((oh * ow, _YOLO_V5_CLASSES + class_count))
-
-        # Threshold all the scores
-        score_indices = row_outputs[:, _YOLO_V5_SCORE]
-        score_indices = threshold(score_indices, t, scale)
-        if not len(score_indices):
-            return _NO_DETECTION
-
-        # Get the bounding boxes that have a valid score
-        bb = dequantize(model, np.take(row_outputs, score_indices, axis=0))
-
-        # Get the score information
-        bb_scores = bb[:, _YOLO_V5_SCORE]
-
-        # Get the class information
-        bb_classes = np.argmax(bb[:, _YOLO_V5_CLASSES:], axis=1)
-
-        # Compute the bounding box information
-        x_center = bb[:, _YOLO_V5_CX]
-        y_center = bb[:, _YOLO_V5_CY]
-        w_rel = bb[:, _YOLO_V5_CW] * 0.5
-        h_rel = bb[:, _YOLO_V5_CH] * 0.5
-
-        # Scale the bounding boxes to have enough integer precision for NMS
         ib, ih, iw, ic = model.input_shape[0]
-        xmin = (x_center - w_rel) * iw
-        ymin = (y_center - h_rel) * ih
-        xmax = (x_center + w_rel) * iw
-        ymax = (y_center + h_rel) * ih
-
         nms = NMS(iw, ih, inputs[0].roi)
-        for i in range(bb.shape[0]):
-            nms.add_bounding_box(xmin[i], ymin[i], xmax[i], ymax[i], bb_scores[i], bb_classes[i])
+        nms.add_yolov5(model, self.threshold)
         return nms.get_bounding_boxes(threshold=self.nms_threshold, sigma=self.nms_sigma)
 
 
 class YoloV8:
-    _YOLO_V8_CX = const(0)
-    _YOLO_V8_CY = const(1)
-    _YOLO_V8_CW = const(2)
-    _YOLO_V8_CH = const(3)
-    _YOLO_V8_CLASSES = const(4)
-
     def __init__(self, threshold=0.6, nms_threshold=0.1, nms_sigma=0.1):
         self.threshold = threshold
         self.nms_threshold = nms_threshold
         self.nms_sigma = nms_sigma
 
     def __call__(self, model, inputs, outputs):
-        oh, ow, oc = model.output_shape[0]
-        scale = model.output_scale[0]
-        t = quantize(model, self.threshold)
-        class_count = ow - _YOLO_V8_CLASSES
-
-        # Reshape the output to a 2D array
-        row_outputs = outputs[0].reshape((oh * (_YOLO_V8_CLASSES + class_count), oc)).T
-
-        # Threshold all the scores
-        score_indices = row_outputs[:, _YOLO_V8_CLASSES:]
-        score_indices = threshold(score_indices, t, scale, find_max=True, find_max_axis=1)
-        if not len(score_indices):
-            return _NO_DETECTION
-
-        # Get the bounding boxes that have a valid score
-        bb = dequantize(model, np.take(row_outputs, score_indices, axis=0))
-
-        # Get the score information
-        bb_scores = np.max(bb[:, _YOLO_V8_CLASSES:], axis=1)
-
-        # Get the class information
-        bb_classes = np.argmax(bb[:, _YOLO_V8_CLASSES:], axis=1)
-
-        # Compute the bounding box information
-        x_center = bb[:, _YOLO_V8_CX]
-        y_center = bb[:, _YOLO_V8_CY]
-        w_rel = bb[:, _YOLO_V8_CW] * 0.5
-        h_rel = bb[:, _YOLO_V8_CH] * 0.5
-
-        # Scale the bounding boxes to have enough integer precision for NMS
         ib, ih, iw, ic = model.input_shape[0]
-        xmin = (x_center - w_rel) * iw
-        ymin = (y_center - h_rel) * ih
-        xmax = (x_center + w_rel) * iw
-        ymax = (y_center + h_rel) * ih
-
         nms = NMS(iw, ih, inputs[0].roi)
-        for i in range(bb.shape[0]):
-            nms.add_bounding_box(xmin[i], ymin[i], xmax[i], ymax[i], bb_scores[i], bb_classes[i])
+        nms.add_yolov8(model, self.threshold)
         return nms.get_bounding_boxes(threshold=self.nms_threshold, sigma=self.nms_sigma)
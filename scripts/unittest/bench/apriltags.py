@@ -12,6 +12,14 @@ def unittest(data_path, temp_path):
         total += time.ticks_diff(time.ticks_us(), start)
     print("find_apriltags: %d us avg (%d runs)" % (total // iterations, iterations))
 
+    detector = image.AprilTagDetector(image.TAG36H11)
+    total = 0
+    for _ in range(iterations):
+        start = time.ticks_us()
+        detector.detect(img)
+        total += time.ticks_diff(time.ticks_us(), start)
+    print("AprilTagDetector.detect: %d us avg (%d runs)" % (total // iterations, iterations))
+
     #for t in tags:
     #    print(t.id, t.family, t.x, t.y, t.w, t.h, t.cx, t.cy)
 
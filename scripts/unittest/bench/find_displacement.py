@@ -0,0 +1,33 @@
+def unittest(data_path, temp_path):
+    import image
+    import time
+
+    src = image.Image(data_path + "/graffiti.pgm", copy_to_fb=True)
+
+    # 96x96 isn't a power of two and runs as a mixed-radix FFT without padding.
+    for size in (64, 96, 128):
+        roi = (40, 40, size, size)
+        template_roi = (44, 37, size, size)
+
+        total = 0
+        iterations = 20
+        for _ in range(iterations):
+            start = time.ticks_us()
+            d = src.find_displacement(src, roi=roi, template_roi=template_roi)
+            total += time.ticks_diff(time.ticks_us(), start)
+        print(
+            "find_displacement %dx%d: %d us avg (%d runs)"
+            % (size, size, total // iterations, iterations)
+        )
+
+        if abs(abs(d.x_translation) - 4) > 0.5 or abs(abs(d.y_translation) - 3) > 0.5:
+            return False
+
+    return True
+
+
+temp_path = "/remote/temp"
+data_path = "/remote/data"
+
+if __name__ == "__main__":
+    unittest(data_path, temp_path)
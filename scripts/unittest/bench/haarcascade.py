@@ -0,0 +1,25 @@
+def unittest(data_path, temp_path):
+    import image
+    import time
+
+    cascade = image.HaarCascade(data_path + "/frontalface.cascade")
+    img = image.Image(data_path + "/dennis.pgm", copy_to_fb=True)
+
+    total = 0
+    iterations = 10
+    for _ in range(iterations):
+        start = time.ticks_us()
+        objects = img.find_features(cascade, threshold=0.75, scale=1.25)
+        total += time.ticks_diff(time.ticks_us(), start)
+    print("find_features: %d us avg (%d runs)" % (total // iterations, iterations))
+
+    return (
+        objects and objects[0] == (189, 53, 88, 88) and objects[1] == (12, 11, 107, 107)
+    )
+
+
+temp_path = "/remote/temp"
+data_path = "/remote/data"
+
+if __name__ == "__main__":
+    unittest(data_path, temp_path)
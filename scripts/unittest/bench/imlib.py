@@ -0,0 +1,34 @@
+def unittest(data_path, temp_path):
+    import image
+    import json
+
+    try:
+        import unittest_bench
+    except ImportError:
+        return "skip"
+
+    iterations = 5
+    formats = (("BINARY", image.BINARY), ("GRAYSCALE", image.GRAYSCALE), ("RGB565", image.RGB565))
+    resolutions = (("QQVGA", 160, 120), ("QVGA", 320, 240), ("VGA", 640, 480))
+
+    # One JSON object per line, so the output can be diffed against a baseline.
+    for kernel in unittest_bench.kernels():
+        for res, w, h in resolutions:
+            for fmt, pixfmt in formats:
+                r = unittest_bench.run(kernel, w, h, pixfmt, iterations)
+                if r is None:
+                    continue
+                r["kernel"] = kernel
+                r["resolution"] = res
+                r["pixformat"] = fmt
+                r["mpix_s"] = round((w * h) * (r["cpu_hz"] / 1e6) / max(r["cycles"], 1), 3)
+                print(json.dumps(r))
+
+    return True
+
+
+temp_path = "/remote/temp"
+data_path = "/remote/data"
+
+if __name__ == "__main__":
+    unittest(data_path, temp_path)
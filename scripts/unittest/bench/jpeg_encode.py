@@ -0,0 +1,79 @@
+def encode(img, ref, name, iterations):
+    import math
+    import time
+
+    total = 0
+    for _ in range(iterations):
+        start = time.ticks_us()
+        jpg = img.to_jpeg(quality=90, copy=True)
+        total += time.ticks_diff(time.ticks_us(), start)
+
+    mbps = (img.size() * iterations) / max(total, 1)
+    dec = jpg.to_grayscale(copy=True)
+    if name == "RGB565":
+        dec.difference(img.to_grayscale(copy=True))
+    else:
+        dec.difference(ref)
+    stats = dec.get_statistics()
+    mse = max(stats.l_mean() ** 2 + stats.l_stdev() ** 2, 1e-3)
+    psnr = 10 * math.log10((255 * 255) / mse)
+    return mbps, psnr, jpg.size(), jpg
+
+
+def unittest(data_path, temp_path):
+    import image
+
+    try:
+        # Baseline float DCT and quantization, compared on the luma of each encoded image.
+        from unittest_bench import jpeg_reference
+    except ImportError:
+        # Without it only the encoder is measured.
+        jpeg_reference = None
+
+    src = image.Image(data_path + "/graffiti.bmp", copy_to_fb=True)
+
+    passed = True
+    iterations = 10
+    for w, h in ((320, 240), (640, 480)):
+        ref = image.Image(w, h, image.GRAYSCALE)
+        ref.draw_image(src, 0, 0, x_scale=w / src.width(), y_scale=h / src.height())
+
+        for name in ("GRAYSCALE", "RGB565", "YUV422"):
+            if name == "GRAYSCALE":
+                img = ref
+            elif name == "RGB565":
+                img = image.Image(w, h, image.RGB565)
+                img.draw_image(src, 0, 0, x_scale=w / src.width(), y_scale=h / src.height())
+            else:
+                # Y from the grayscale reference with neutral chroma.
+                img = image.Image(w, h, image.YUV422)
+                yuv = img.bytearray()
+                gray = ref.bytearray()
+                for i in range(w * h):
+                    yuv[i * 2] = gray[i]
+                    yuv[i * 2 + 1] = 128
+
+            mbps, psnr, size, jpg = encode(img, ref, name, iterations)
+            print(
+                "to_jpeg %dx%d %s: %.2f MB/s, PSNR %.2f dB, %d bytes"
+                % (w, h, name, mbps, psnr, size)
+            )
+            if jpeg_reference:
+                # The baseline uses an exact float IDCT and the JPEG the image decoder's.
+                # The stage times cover the luma DCT and quantization only, not the whole encode.
+                ref_us, enc_us, ref_luma, luma = jpeg_reference(img, jpg, 90)
+                stage = "    luma DCT+quant: baseline %.2f MB/s" % ((w * h) / max(ref_us, 1))
+                if enc_us is not None:
+                    stage += ", encoder %.2f MB/s" % ((w * h) / max(enc_us, 1))
+                print(stage + ", PSNR %.2f -> %.2f dB" % (ref_luma, luma))
+                passed = passed and luma > (ref_luma - 0.1)
+            passed = passed and psnr > 30
+
+    return passed
+
+
+temp_path = "/remote/temp"
+data_path = "/remote/data"
+
+if __name__ == "__main__":
+    unittest(data_path, temp_path)
@@ -0,0 +1,67 @@
+class RAMBlockDev:
+    def __init__(self, block_size, num_blocks):
+        self.block_size = block_size
+        self.data = bytearray(block_size * num_blocks)
+
+    def readblocks(self, block_num, buf, offset=0):
+        addr = block_num * self.block_size + offset
+        buf[:] = self.data[addr : addr + len(buf)]
+
+    def writeblocks(self, block_num, buf, offset=0):
+        addr = block_num * self.block_size + offset
+        self.data[addr : addr + len(buf)] = buf
+
+    def ioctl(self, op, arg):
+        if op == 4:  # Block count
+            return len(self.data) // self.block_size
+        if op == 5:  # Block size
+            return self.block_size
+        if op == 6:  # Block erase
+            return 0
+
+
+def unittest(data_path, temp_path):
+    import image
+    import mjpeg
+    import time
+    import vfs
+
+    try:
+        bdev = RAMBlockDev(512, 2048)
+    except MemoryError:
+        return "skip"
+
+    vfs.VfsFat.mkfs(bdev)
+    vfs.mount(vfs.VfsFat(bdev), "/ram")
+
+    src = image.Image(data_path + "/graffiti.bmp", copy_to_fb=True)
+
+    try:
+        for w, h, frames in ((160, 120, 150), (320, 240, 40)):
+            img = image.Image(w, h, image.RGB565)
+            img.draw_image(src, 0, 0, x_scale=w / src.width(), y_scale=h / src.height())
+            jpg = img.to_jpeg(quality=50)
+
+            start = time.ticks_us()
+            m = mjpeg.Mjpeg("/ram/bench.mjpeg", width=w, height=h)
+            for _ in range(frames):
+                m.write(jpg)
+            size = m.size()
+            m.close()
+            elapsed = max(time.ticks_diff(time.ticks_us(), start), 1)
+
+            print(
+                "mjpeg %dx%d: %d frames, %d bytes, %.2f MB/s"
+                % (w, h, frames, size, size / elapsed)
+            )
+    finally:
+        vfs.umount("/ram")
+
+    return True
+
+
+temp_path = "/remote/temp"
+data_path = "/remote/data"
+
+if __name__ == "__main__":
+    unittest(data_path, temp_path)
@@ -0,0 +1,31 @@
+def unittest(data_path, temp_path):
+    import image
+
+    img = image.Image(data_path + "/apriltags.pgm", copy_to_fb=True)
+    detector = image.AprilTagDetector(image.TAG36H11)
+
+    expected = [
+        (0, 8, 494, 308, 34, 39, 511, 328),
+        (0, 8, 567, 333, 37, 40, 585, 353),
+        (0, 8, 302, 324, 36, 38, 320, 343),
+        (0, 8, 229, 319, 36, 38, 247, 338),
+        (0, 8, 469, 306, 18, 42, 478, 327),
+        (0, 8, 324, 194, 37, 31, 342, 209),
+    ]
+
+    # The detector must give the same results as find_apriltags() across calls.
+    for _ in range(3):
+        tags = detector.detect(img)
+        if len(tags) != len(expected):
+            return False
+        for t, e in zip(tags, expected):
+            if (t.id, t.family, t.x, t.y, t.w, t.h, t.cx, t.cy) != e:
+                return False
+
+    detector.refine_edges = False
+    detector.quad_decimate = 2.0
+    if detector.refine_edges or detector.quad_decimate != 2.0:
+        return False
+
+    detector.deinit()
+    return True
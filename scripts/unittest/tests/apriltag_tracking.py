@@ -0,0 +1,36 @@
+def unittest(data_path, temp_path):
+    import image
+
+    img = image.Image(data_path + "/apriltags.pgm", copy_to_fb=True)
+    tracker = image.Tracker(interval=4)
+
+    def key(t):
+        return (t.cx, t.cy)
+
+    # The first call scans the whole image and starts a track per tag.
+    first = sorted(img.find_apriltags(tracker=tracker), key=key)
+    if not tracker.full_scan or tracker.tracks != len(first) or len(first) != 6:
+        return False
+
+    if sorted(t.track_id for t in first) != list(range(1, 7)):
+        return False
+
+    # Later calls only search around the tracks and must return the same tags and ids.
+    for i in range(6):
+        tags = sorted(img.find_apriltags(tracker=tracker), key=key)
+        if tracker.full_scan != (i == 3):
+            return False
+        if len(tags) != len(first):
+            return False
+        for t, f in zip(tags, first):
+            if (t.id, t.family, t.track_id) != (f.id, f.family, f.track_id):
+                return False
+            if abs(t.cxf - f.cxf) > 2 or abs(t.cyf - f.cyf) > 2:
+                return False
+
+    # Without a tracker no ids are assigned.
+    if any(t.track_id is not None for t in img.find_apriltags()):
+        return False
+
+    tracker.reset()
+    return tracker.tracks == 0
@@ -12,6 +12,24 @@ def unittest(data_path, temp_path):
 
     blobs = img.find_blobs(thresholds, pixels_threshold=200, area_threshold=200)
 
+    # Blob codes are a 32-bit mask, so more thresholds are rejected.
+    try:
+        img.find_blobs(thresholds * 11)
+        return False
+    except ValueError:
+        pass
+
+    # A pixel matching overlapping thresholds is only part of the blobs of the first one.
+    img = image.Image(16, 8, image.GRAYSCALE)
+    img.draw_rectangle(2, 2, 6, 4, color=100, fill=True)
+    img.draw_rectangle(8, 2, 6, 4, color=180, fill=True)
+    wide = img.find_blobs([(50, 255), (50, 150)], pixels_threshold=1, area_threshold=1)
+    narrow = img.find_blobs([(50, 150), (50, 255)], pixels_threshold=1, area_threshold=1)
+    if [(b.code(), b.x(), b.pixels()) for b in wide] != [(1, 2, 48)]:
+        return False
+    if [(b.code(), b.x(), b.pixels()) for b in narrow] != [(1, 2, 24), (2, 8, 24)]:
+        return False
+
     return (
         blobs[0][0:7] == (61, 21, 49, 41, 84, 41, 1556)
         and blobs[1][0:7] == (22, 20, 39, 45, 40, 42, 1294)
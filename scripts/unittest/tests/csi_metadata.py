@@ -0,0 +1,50 @@
+def unittest(data_path, temp_path):
+    import csi
+    import image
+    import time
+
+    csi0 = csi.CSI()
+    csi0.reset()
+    csi0.pixformat(csi.GRAYSCALE)
+    csi0.framesize(csi.QQVGA)
+
+    last = None
+    for i in range(3):
+        img = csi0.snapshot()
+        seq, start_us, end_us, exposure_us, gain_db, dropped = img.metadata()
+
+        if img.seq() != seq or img.timestamp() != start_us:
+            return False
+
+        if time.ticks_diff(end_us, start_us) < 0 or time.ticks_diff(time.ticks_us(), end_us) < 0:
+            return False
+
+        if last is not None and seq != last + 1 + dropped:
+            return False
+        last = seq
+
+    # Reading the exposure or gain in auto mode doesn't make later frames report it.
+    try:
+        csi0.exposure_us()
+        csi0.gain_db()
+    except Exception:
+        pass
+
+    # Capturing a number of frames returns the last one with its metadata.
+    img = csi0.snapshot(frames=2)
+    if img is None or img.seq() is None or img.seq() <= last:
+        return False
+
+    exposure_us, gain_db = img.metadata()[3:5]
+    if exposure_us is not None or gain_db is not None:
+        return False
+
+    captured, dropped, flushed, overflowed, depth = csi0.frame_stats(reset=True)
+    if captured < 3 or captured != sum(depth) or overflowed != 0:
+        return False
+
+    if csi0.frame_stats()[0] != 0:
+        return False
+
+    # Images that weren't captured have no metadata.
+    return image.Image(8, 8, image.GRAYSCALE).seq() is None and img.copy().metadata() is None
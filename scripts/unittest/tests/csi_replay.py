@@ -0,0 +1,86 @@
+def check_frames(csi0, expected, tolerance):
+    for value in expected:
+        img = csi0.snapshot()
+        if img.width() != 160 or img.height() != 120:
+            return False
+        if abs(img.get_statistics().mean() - value) > tolerance:
+            return False
+    return True
+
+
+def unittest(data_path, temp_path):
+    import csi
+    import image
+    import mjpeg
+    import os
+    import time
+
+    if not hasattr(csi, "IOCTL_SOFTCSI_REPLAY"):
+        return "skip"
+
+    values = (40, 120, 200)
+    img = image.Image(80, 60, image.GRAYSCALE)
+
+    try:
+        os.mkdir(temp_path + "/replay")
+    except OSError:
+        pass
+
+    stream = image.ImageIO(temp_path + "/replay.bin", "w")
+    m = mjpeg.Mjpeg(temp_path + "/replay.mjpeg", width=80, height=60)
+    for i, value in enumerate(values):
+        img.draw_rectangle(0, 0, 80, 60, color=value, fill=True)
+        stream.write(img)
+        m.write(img, quality=95)
+        # Saved in reverse name order, the files are replayed sorted by name.
+        img.save(temp_path + "/replay/%c.pgm" % "cba"[i])
+    stream.close()
+    m.close()
+
+    csi0 = csi.CSI()
+    csi0.reset()
+    csi0.pixformat(csi.GRAYSCALE)
+    csi0.framesize(csi.QQVGA)
+
+    try:
+        # The frames are scaled up to the frame size and wrap around at the end.
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, temp_path + "/replay.bin")
+        if not check_frames(csi0, values + values[:1], 0):
+            return False
+
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, temp_path + "/replay.mjpeg")
+        if not check_frames(csi0, values, 2):
+            return False
+
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, temp_path + "/replay")
+        if not check_frames(csi0, values[::-1], 0):
+            return False
+
+        # Frames replayed on demand are always ready.
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, temp_path + "/replay.bin")
+        img = csi0.snapshot(blocking=False)
+        if img is None or img.get_statistics().mean() != values[0]:
+            return False
+
+        # At 10 fps the first frame is due right away and the next one 100 ms later.
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, temp_path + "/replay.bin", 10)
+        if not check_frames(csi0, values[:1], 0):
+            return False
+        if csi0.snapshot(blocking=False) is not None:
+            return False
+
+        start = time.ticks_ms()
+        if not check_frames(csi0, values[1:], 0):
+            return False
+        elapsed = time.ticks_diff(time.ticks_ms(), start)
+        if elapsed < 150 or elapsed > 400:
+            return False
+
+        # Reset switches back to the test pattern.
+        csi0.reset()
+        csi0.pixformat(csi.GRAYSCALE)
+        csi0.framesize(csi.QQVGA)
+        stats = csi0.snapshot().difference(data_path + "/csi.pgm").get_statistics()
+        return (stats.max + stats.min) == 0
+    finally:
+        csi0.ioctl(csi.IOCTL_SOFTCSI_REPLAY, None)
@@ -43,4 +43,22 @@ def unittest(data_path, temp_path):
     if result.response < 0.5:
         return False
 
+    # 96 (3*2^5) and 80 (5*2^4) use a radix-3/5 stage on top of the power of two
+    # FFTs. Check both in the rows and in the columns.
+    for w, h in ((96, 80), (80, 96)):
+        img1 = image.Image(w, h, image.GRAYSCALE)
+        img2 = image.Image(w, h, image.GRAYSCALE)
+        img1.clear()
+        img2.clear()
+        img1.draw_rectangle(20, 20, 11, 11, color=255, fill=True)
+        img2.draw_rectangle(27, 16, 11, 11, color=255, fill=True)
+
+        # A (+7, -4) pixel shift gives (-7, -4).
+        result = img1.find_displacement(img2)
+        if abs(result.x_translation + 7) > 0.5 or abs(result.y_translation + 4) > 0.5:
+            return False
+
+        if result.response < 0.5:
+            return False
+
     return True
@@ -0,0 +1,131 @@
+def gif_decode(path):
+    import struct
+
+    with open(path, "rb") as f:
+        d = f.read()
+
+    if d[:6] != b"GIF89a":
+        return None
+
+    w, h, flags = struct.unpack("<HHB", d[6:11])
+    p = 13 + 3 * (2 << (flags & 7))
+    canvas = bytearray(w * h)
+    frames = []
+    transparent = -1
+
+    while d[p] != 0x3B:
+        if d[p] == 0x21:
+            if d[p + 1] == 0xF9 and d[p + 3] & 1:
+                transparent = d[p + 6]
+            p += 2
+            while d[p]:
+                p += d[p] + 1
+            p += 1
+            continue
+
+        x, y, fw, fh = struct.unpack("<HHHH", d[p + 1 : p + 9])
+        min_size = d[p + 10]
+        p += 11
+        data = bytearray()
+        while d[p]:
+            data += d[p + 1 : p + 1 + d[p]]
+            p += d[p] + 1
+        p += 1
+
+        # LZW decode with variable code sizes.
+        clear = 1 << min_size
+        table = None
+        prev = None
+        pixels = bytearray()
+        bits = 0
+        nbits = 0
+        i = 0
+        size = min_size + 1
+        while True:
+            while nbits < size:
+                bits |= data[i] << nbits
+                nbits += 8
+                i += 1
+            code = bits & ((1 << size) - 1)
+            bits >>= size
+            nbits -= size
+            if code == clear:
+                table = [bytes([c]) for c in range(clear)] + [b"", b""]
+                size = min_size + 1
+                prev = None
+                continue
+            if code == clear + 1:
+                break
+            if prev is None:
+                entry = table[code]
+            else:
+                entry = table[code] if code < len(table) else prev + prev[:1]
+                if len(table) < 4096:
+                    table.append(prev + entry[:1])
+                    if len(table) == (1 << size) and size < 12:
+                        size += 1
+            pixels += entry
+            prev = entry
+
+        if len(pixels) != fw * fh:
+            return None
+
+        for j in range(fh):
+            for k in range(fw):
+                v = pixels[j * fw + k]
+                if v != transparent:
+                    canvas[(y + j) * w + x + k] = v
+        frames.append(bytes(canvas))
+        transparent = -1
+
+    return frames
+
+
+def unittest(data_path, temp_path):
+    import gif
+    import image
+
+    w, h = 32, 24
+    img = image.Image(w, h, image.GRAYSCALE)
+    path = temp_path + "/gif_encoder.gif"
+
+    for delta in (False, True):
+        g = gif.Gif(path, width=w, height=h, color=False, delta=delta)
+        expected = []
+        for f in range(6):
+            for y in range(h):
+                for x in range(w):
+                    v = (x * 8) & 0xFF
+                    if 4 * f <= x < 4 * f + 5 and 3 <= y < 9:
+                        v = 255
+                    img.set_pixel(x, y, v)
+            expected.append(bytes(p >> 1 for p in img.bytearray()))
+            g.add_frame(img, delay=5)
+
+        frames, pixels, encoded, size = g.stats()
+        g.close()
+
+        if g.count() != 6 or frames != 6 or pixels != 6 * w * h:
+            return False
+
+        # Delta frames only cover the moving box.
+        if delta and encoded >= 2 * w * h:
+            return False
+
+        if gif_decode(path) != expected:
+            return False
+
+    # Noise fills the 4096 code dictionary many times over, which forces CLEAR codes.
+    w, h = 128, 96
+    img = image.Image(w, h, image.GRAYSCALE)
+    buf = img.bytearray()
+    seed = 12345
+    for i in range(w * h):
+        seed = (seed * 1103515245 + 12345) & 0x7FFFFFFF
+        buf[i] = seed >> 23
+
+    g = gif.Gif(path, width=w, height=h, color=False)
+    g.add_frame(img)
+    g.close()
+
+    return gif_decode(path) == [bytes(p >> 1 for p in buf)]
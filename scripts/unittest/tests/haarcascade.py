@@ -1,14 +1,17 @@
 def unittest(data_path, temp_path):
     import image
 
-    # Load Haar Cascade
-    cascade = image.HaarCascade(data_path + "/frontalface.cascade")
-
-    # Load image and find keypoints
+    # Load image
     img = image.Image(data_path + "/dennis.pgm", copy_to_fb=True)
 
-    # Find objects
-    objects = img.find_features(cascade, threshold=0.75, scale=1.25)
-    return (
-        objects and objects[0] == (189, 53, 88, 88) and objects[1] == (12, 11, 107, 107)
-    )
+    # The legacy cascade and the same cascade packed with haar2c.py must find the same objects.
+    for name in ("frontalface.cascade", "frontalface_packed.cascade"):
+        # Load Haar Cascade
+        cascade = image.HaarCascade(data_path + "/" + name)
+        # Find objects
+        objects = img.find_features(cascade, threshold=0.75, scale=1.25)
+        if not (
+            objects and objects[0] == (189, 53, 88, 88) and objects[1] == (12, 11, 107, 107)
+        ):
+            return False
+    return True
@@ -0,0 +1,36 @@
+def unittest(data_path, temp_path):
+    import image
+
+    path = data_path + "/compressed.jpeg"
+
+    # Decode at 1/4 scale, the size is rounded up.
+    img = image.Image(path, pixformat=image.GRAYSCALE, scale=4)
+    if img.width() != 80 or img.height() != 68:
+        return False
+
+    if img.format() != image.GRAYSCALE:
+        return False
+
+    # Decode an MCU aligned ROI at 1/2 scale.
+    img = image.Image(path, pixformat=image.RGB565, roi=(16, 16, 128, 96), scale=2)
+    if img.width() != 64 or img.height() != 48:
+        return False
+
+    # A full scale ROI decode must match a crop of the full decode.
+    full = image.Image(path, pixformat=image.GRAYSCALE)
+    roi = image.Image(path, pixformat=image.GRAYSCALE, roi=(32, 48, 64, 64))
+    full.crop(roi=(32, 48, 64, 64))
+    if roi.width() != 64 or roi.height() != 64:
+        return False
+
+    if full.difference(roi).get_statistics().max != 0:
+        return False
+
+    # Unsupported scales must raise.
+    try:
+        image.Image(path, pixformat=image.GRAYSCALE, scale=3)
+        return False
+    except ValueError:
+        pass
+
+    return True
@@ -0,0 +1,95 @@
+def unittest(data_path, temp_path):
+    import omv
+
+    if "MPS3" not in omv.arch():
+        return "skip"
+
+    from ml.utils import NMS
+
+    def run(**kwargs):
+        nms = NMS(100, 100, (0, 0, 200, 200))
+        nms.add_bounding_box(0, 0, 10, 10, 0.9, 0)
+        nms.add_bounding_box(1, 1, 11, 11, 0.8, 0)
+        nms.add_bounding_box(50, 50, 60, 60, 0.7, 1)
+        nms.add_bounding_box(20, 20, 20, 30, 0.7, 1)  # Empty box, dropped.
+        nms.add_bounding_box(20, 20, 30, 30, 1.5, 1)  # Invalid score, dropped.
+        return [[(rect, round(score, 2)) for rect, score in c] for c in nms.get_bounding_boxes(**kwargs)]
+
+    # Soft-NMS suppresses the overlapping box below the threshold.
+    if run() != [[([0, 0, 20, 20], 0.9)], [([100, 100, 20, 20], 0.7)]]:
+        return False
+
+    # Without decay both overlapping boxes are kept.
+    if run(sigma=0.0) != [[([0, 0, 20, 20], 0.9), ([2, 2, 20, 20], 0.8)], [([100, 100, 20, 20], 0.7)]]:
+        return False
+
+    # Greedy NMS.
+    if run(iou_threshold=0.5) != [[([0, 0, 20, 20], 0.9)], [([100, 100, 20, 20], 0.7)]]:
+        return False
+
+    if NMS(10, 10, (0, 0, 10, 10)).get_bounding_boxes() != [[]]:
+        return False
+
+    from ulab import numpy as np
+
+    def boxes(nms):
+        return [[(rect, round(score, 2)) for rect, score in c] for c in nms.get_bounding_boxes()]
+
+    # The decoders also accept the output ndarrays, boxes are scaled by the window size.
+    expected = [[([16, 16, 32, 32], 0.5)], [([48, 32, 32, 64], 0.75)]]
+
+    # YOLOv5: (cx, cy, w, h, objectness, classes...) per row, the second row is below the threshold.
+    nms = NMS(128, 128, (0, 0, 128, 128))
+    nms.add_yolov5([np.array([
+        [0.5, 0.5, 0.25, 0.5, 0.75, 0.25, 0.5],
+        [0.5, 0.5, 0.25, 0.5, 0.25, 0.75, 0.5],
+        [0.25, 0.25, 0.25, 0.25, 0.5, 0.75, 0.25],
+    ])], 0.4)
+    if boxes(nms) != expected:
+        return False
+
+    # YOLOv8: the same boxes with anchors in columns, and no objectness score.
+    nms = NMS(128, 128, (0, 0, 128, 128))
+    nms.add_yolov8([np.array([
+        [0.5, 0.5, 0.25],
+        [0.5, 0.5, 0.25],
+        [0.25, 0.25, 0.25],
+        [0.5, 0.5, 0.25],
+        [0.25, 0.25, 0.5],
+        [0.75, 0.25, 0.25],
+    ])], 0.4)
+    if boxes(nms) != expected:
+        return False
+
+    # Anchors: logit scores and anchor relative boxes in pixels, with one keypoint.
+    nms = NMS(128, 128, (0, 0, 128, 128))
+    anchors = np.array([[0.5, 0.5], [0.25, 0.25]])
+    outputs = [
+        np.array([[1.0986123], [-5.0]]),
+        np.array([[0, 0, 32, 64, 16, -16], [0, 0, 32, 32, 0, 0]]),
+    ]
+    nms.add_anchors(outputs, 0, 1, anchors, 0.4)
+    output = nms.get_bounding_boxes()
+    if len(output) != 1 or len(output[0]) != 1:
+        return False
+    rect, score, kp = output[0][0]
+    if rect != [48, 32, 32, 64] or round(score, 2) != 0.75:
+        return False
+    if kp.shape != (1, 2) or kp[0, 0] != 80 or kp[0, 1] != 48:
+        return False
+
+    # (N, 4) anchors scale the box and keypoint offsets by the anchor size.
+    nms = NMS(128, 128, (0, 0, 128, 128))
+    nms.add_anchors(outputs, 0, 1, np.array([[0.5, 0.5, 0.5, 1.5], [0.25, 0.25, 1.0, 1.0]]), 0.4)
+    rect, score, kp = nms.get_bounding_boxes()[0][0]
+    if rect != [56, 16, 16, 96] or kp[0, 0] != 72 or kp[0, 1] != 40:
+        return False
+
+    # Anchor sizes must be positive.
+    try:
+        nms.add_anchors(outputs, 0, 1, np.array([[0.5, 0.5, 0.0, 1.0], [0.25, 0.25, 1.0, 1.0]]), 0.4)
+        return False
+    except ValueError:
+        pass
+
+    return True
@@ -0,0 +1,77 @@
+def unittest(data_path, temp_path):
+    import image
+    import struct
+
+    try:
+        from ml.preprocessing import Normalization
+    except ImportError:
+        return "skip"
+
+    w, h = 16, 8
+
+    gray = image.Image(w, h, image.GRAYSCALE)
+    rgb = image.Image(w, h, image.RGB565)
+    for y in range(h):
+        for x in range(w):
+            gray.set_pixel(x, y, (x * 16) + (y * 2))
+            rgb.set_pixel(x, y, ((x * 17) & 0xFF, (y * 37 + x * 5) & 0xFF, 255 - (x * 17)))
+
+    custom = {"scale": (-1.0, 1.0), "mean": (0.1, 0.2, 0.3), "stdev": (0.5, 0.6, 0.7)}
+
+    def grayscale(x):
+        return (x[0] * 0.299) + (x[1] * 0.587) + (x[2] * 0.114)
+
+    # Fills a (1, H, W, C) tensor through the fused draw/normalize path.
+    def fused(img, c, fmt, norm, *quant):
+        n = w * h * c
+        buf = bytearray(n * struct.calcsize(fmt))
+        Normalization(**norm)(img)(buf, (1, h, w, c), ord(fmt), *quant)
+        return struct.unpack("<%d%s" % (n, fmt), buf)
+
+    # Converts with to_ndarray() and applies the normalization and quantization by hand.
+    def reference(img, c, fmt, norm, *quant):
+        scale = norm.get("scale", (0.0, 1.0))
+        mean = norm.get("mean", (0.0, 0.0, 0.0))
+        stdev = norm.get("stdev", (1.0, 1.0, 1.0))
+        if c == 1:
+            mean = [grayscale(mean)]
+            stdev = [grayscale(stdev)]
+
+        out = []
+        for i, p in enumerate(img.to_ndarray("f").flatten()):
+            v = ((p * (scale[1] - scale[0]) / 255.0) + scale[0] - mean[i % c]) / stdev[i % c]
+            if fmt == "f":
+                out.append(v)
+            elif not quant or not norm:
+                # 8-bit tensors get the raw pixels with the default normalization.
+                out.append(int(p) - 128 if fmt == "b" else int(p))
+            else:
+                lo, hi = (-128, 127) if fmt == "b" else (0, 255)
+                out.append(min(max(round((v / quant[0]) + quant[1]), lo), hi))
+        return out
+
+    def check(img, c, fmt, norm, *quant):
+        out = fused(img, c, fmt, norm, *quant)
+        ref = reference(img, c, fmt, norm, *quant)
+        tol = 0.001 if fmt == "f" else 1
+        return len(out) == len(ref) and all(abs(a - b) <= tol for a, b in zip(out, ref))
+
+    for img, c in ((gray, 1), (rgb, 3)):
+        for norm in ({}, custom):
+            if not check(img, c, "f", norm):
+                return False
+            if not check(img, c, "b", norm) or not check(img, c, "B", norm):
+                return False
+            if not check(img, c, "b", norm, 0.02, -5):
+                return False
+            if not check(img, c, "B", norm, 0.015, 120):
+                return False
+
+    # The unquantized 8-bit tensors must match to_ndarray() exactly.
+    for img, c in ((gray, 1), (rgb, 3)):
+        for fmt in ("b", "B"):
+            if list(fused(img, c, fmt, {})) != list(img.to_ndarray(fmt).flatten()):
+                return False
+
+    return True
+
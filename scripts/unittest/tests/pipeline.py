@@ -0,0 +1,43 @@
+def unittest(data_path, temp_path):
+    import image
+
+    thresholds = [
+        (0, 100, 56, 95, 41, 74),   # generic_red_thresholds
+        (0, 100, -128, -22, -128, 99),  # generic_green_thresholds
+        (0, 100, -128, 98, -128, -16),  # generic_blue_thresholds
+    ]
+
+    img = image.Image(data_path + "/blobs.ppm", copy_to_fb=True)
+
+    # Streaming blobs must match find_blobs() on the same image.
+    blobs = img.find_blobs(thresholds, pixels_threshold=200, area_threshold=200)
+    pipe_blobs = image.Pipeline().find_blobs(img, thresholds, pixels_threshold=200, area_threshold=200)
+    if len(blobs) != len(pipe_blobs):
+        return False
+    for a, b in zip(blobs, pipe_blobs):
+        if a[0:7] != b[0:7]:
+            return False
+
+    # Streaming conversion and thresholding must match the image methods.
+    # Binary stages always output a bitmap, like binary(to_bitmap=True).
+    pipe = image.Pipeline().to_grayscale().binary([(128, 255)])
+    out = pipe.run(img, copy=True)
+    ref = img.to_grayscale(copy=True).binary([(128, 255)], to_bitmap=True)
+    if out.format() != image.BINARY or out.get_histogram().bins() != ref.get_histogram().bins():
+        return False
+
+    # Histograms of the pipeline output must match the materialized output.
+    pipe = image.Pipeline().to_grayscale().gaussian()
+    out = pipe.run(img, copy=True)
+    if pipe.get_histogram(img).bins() != out.get_histogram().bins():
+        return False
+
+    # Encoding the rows as they're produced must match compressing the materialized output.
+    jpg = pipe.compress(img, quality=90)
+    ref = out.compress(quality=90, copy=True)
+    if jpg.format() != image.JPEG or jpg.bytearray() != ref.bytearray():
+        return False
+
+    # Running in place converts the image.
+    pipe.run(img)
+    return img.format() == image.GRAYSCALE and img.get_histogram().bins() == out.get_histogram().bins()
@@ -0,0 +1,38 @@
+def unittest(data_path, temp_path):
+    import time
+
+    try:
+        import profiler
+
+        profiler.sample_start
+    except (ImportError, AttributeError):
+        return "skip"
+
+    try:
+        profiler.sample_start(rate=1000, lr=True)
+    except RuntimeError:
+        return "skip"
+
+    start = time.ticks_ms()
+    x = 0
+    while time.ticks_diff(time.ticks_ms(), start) < 200:
+        x += 1
+    profiler.sample_stop()
+
+    samples = profiler.samples()
+
+    # Record 0 counts the dropped samples.
+    if not samples or samples[0][0] != 0:
+        return False
+
+    # ~200 samples at 1kHz, allow for timer and emulation jitter.
+    total = sum(s[2] for s in samples)
+    if total < 50 or total > 400:
+        return False
+
+    # Sampling is stopped, and reset clears the samples.
+    if sum(s[2] for s in profiler.samples()) != total:
+        return False
+
+    profiler.reset()
+    return sum(s[2] for s in profiler.samples()) == 0
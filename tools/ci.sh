@@ -137,6 +137,50 @@ ci_run_qemu_tests() {
     return 0
 }
 
+########################################################################################
+# Run QEMU benchmarks
+ci_run_qemu_bench() {
+    TARGET="${1}"
+
+    # Start QEMU in background with a deterministic virtual clock
+    echo "Starting QEMU for ${TARGET}..."
+    make TARGET=${TARGET} QEMU_ICOUNT=0 run > qemu_output.txt 2>&1 &
+    QEMU_PID=$!
+
+    echo "Waiting for QEMU to start..."
+    for i in {1..30}; do
+        if grep -q "char device redirected to" qemu_output.txt; then
+            break
+        fi
+        sleep 1
+    done
+
+    PTS_DEVICE=$(grep "redirected to" qemu_output.txt | sed 's/.*redirected to \(\/dev\/pts\/[0-9]*\).*/\1/')
+
+    if [ -z "$PTS_DEVICE" ]; then
+        echo "Error: Could not find QEMU serial port"
+        cat qemu_output.txt
+        return 1
+    fi
+
+    patch -N -p1 -d lib/micropython < tools/mpremote-qemu-serial.patch || echo "Patch already applied or failed"
+
+    # Run the benchmarks and keep the JSON lines
+    echo "Running benchmarks..."
+    python3 lib/micropython/tools/mpremote/mpremote.py connect $PTS_DEVICE \
+        mount scripts/unittest/ run scripts/unittest/bench/imlib.py 2>&1 | tee bench_output.txt
+    BENCH_EXIT_CODE=${PIPESTATUS[0]}
+
+    kill ${QEMU_PID} 2>/dev/null
+    grep '^{' bench_output.txt > bench_${TARGET}.json
+
+    if [ $BENCH_EXIT_CODE -ne 0 ]; then
+        echo "mpremote command failed with exit code $BENCH_EXIT_CODE"
+        return 1
+    fi
+    return 0
+}
+
 ########################################################################################
 # Install FVP
 FVP_VERSION="11.31.28"
@@ -6,39 +6,563 @@
 #
 # This work is licensed under the MIT license, see the file LICENSE for details.
 #
-# An example TCP client for testing WiFi modules.
+# A throughput test client.
+#
+# tcp:      Raw TCP upload/download test for WiFi modules.
+# protocol: Reads the OpenMV protocol loopback channel (firmware built with
+#           PROTOCOL_LOOPBACK=1) over a serial port or UDP, using a sliding
+#           window negotiated with PROTO_SET_CAPS.
+# trace:    Reads the timeline trace buffer from the profile channel (firmware
+#           built with PROFILE_ENABLE=1) and converts it to Chrome trace JSON,
+#           which can be opened with ui.perfetto.dev or chrome://tracing.
+# sample:   Runs the sampling profiler through the profile channel, or reads
+#           samples printed by profiler.samples(), and resolves them to functions
+#           using the firmware ELF symbol table.
+#
+# Examples:
+#   client.py tcp --addr 192.168.1.103:8080
+#   client.py protocol --port /dev/ttyACM0 --window 8
+#   client.py protocol --udp openmv.local:5555 --window 4 --max-payload 1400
+#   client.py trace --port /dev/ttyACM0 --output trace.json
+#   client.py sample --port /dev/ttyACM0 --elf firmware.elf --duration 5
 
+import sys
 import time
-import select
 import socket
+import struct
+import json
+import argparse
+import bisect
 from datetime import timedelta
 
-UPLOAD_LEN   = 1*1024
-DOWNLOAD_LEN = 1*1024
-ADDR=('192.168.1.103', 8080)
-
-def recvall(sock, n):
-    # Helper function to recv n bytes or return None if EOF is hit
-    data = bytearray()
-    while len(data) < n:
-        packet = sock.recv(n - len(data))
-        if not packet:
-            return None
-        data.extend(packet)
-    return data
-
-s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-s.connect(ADDR)
-
-upload = 0
-download = 0
-start_time = time.monotonic()
-while (True):
-    s.sendall(b'0' * UPLOAD_LEN)
-    buf = recvall(s, DOWNLOAD_LEN)
-    upload += UPLOAD_LEN
-    download += DOWNLOAD_LEN
-    secs = time.monotonic() - start_time
-    print("%s Upload: %.3f MBytes Download: %.3f MBytes %.3f MBytes/s"
-            %(str(timedelta(seconds=secs)), upload/(1024*1024), download/(1024*1024), (upload+download)/(1024*1024)/secs))
-s.close()
+SYNC_WORD = 0xD5AA
+HEADER_SIZE = 10
+
+FLAG_ACK = 0x01
+FLAG_NAK = 0x02
+FLAG_RTX = 0x04
+FLAG_ACK_REQ = 0x08
+FLAG_FRAGMENT = 0x10
+FLAG_EVENT = 0x20
+
+OPCODE_PROTO_SYNC = 0x00
+OPCODE_PROTO_GET_CAPS = 0x01
+OPCODE_PROTO_SET_CAPS = 0x02
+OPCODE_PROTO_STATS = 0x03
+OPCODE_CHANNEL_LIST = 0x20
+OPCODE_CHANNEL_LOCK = 0x22
+OPCODE_CHANNEL_UNLOCK = 0x23
+OPCODE_CHANNEL_SIZE = 0x25
+OPCODE_CHANNEL_READ = 0x26
+OPCODE_CHANNEL_WRITE = 0x27
+OPCODE_CHANNEL_IOCTL = 0x28
+
+STATUS_SEQUENCE = 0x06
+
+CHANNEL_ID_PROFILE = 4
+IOCTL_PROFILE_MODE = 0x00
+IOCTL_PROFILE_RESET = 0x02
+IOCTL_PROFILE_TRACE = 0x04
+
+PROFILE_MODE_SAMPLE = 2
+PROFILE_MODE_SAMPLE_LR = 3
+
+TRACE_MAGIC = 0x54564D4F
+TRACE_HEADER = "<IHHIIIIHHHH"
+TRACE_PHASES = {1: "B", 2: "E", 3: "i", 4: "C"}
+
+
+def crc_table(poly, bits):
+    mask = (1 << bits) - 1
+    table = []
+    for i in range(256):
+        crc = i << (bits - 8)
+        for _ in range(8):
+            crc = ((crc << 1) ^ poly) if crc & (1 << (bits - 1)) else (crc << 1)
+        table.append(crc & mask)
+    return table
+
+
+CRC16_TABLE = crc_table(0xF94F, 16)
+CRC32_TABLE = crc_table(0xFA567D89, 32)
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc = ((crc << 8) & 0xFFFF) ^ CRC16_TABLE[(crc >> 8) ^ b]
+    return crc
+
+
+def crc32(data):
+    crc = 0xFFFFFFFF
+    for b in data:
+        crc = ((crc << 8) & 0xFFFFFFFF) ^ CRC32_TABLE[(crc >> 24) ^ b]
+    return crc
+
+
+class SerialTransport:
+    def __init__(self, port, baudrate):
+        import serial
+
+        self.ser = serial.Serial(port, baudrate, timeout=0.1)
+
+    def write(self, data):
+        self.ser.write(data)
+
+    def read(self):
+        return self.ser.read(max(1, self.ser.in_waiting))
+
+
+class UDPTransport:
+    def __init__(self, addr):
+        host, port = addr.rsplit(":", 1)
+        self.addr = (host, int(port))
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(0.1)
+
+    def write(self, data):
+        self.sock.sendto(data, self.addr)
+
+    def read(self):
+        try:
+            return self.sock.recv(65536)
+        except socket.timeout:
+            return b""
+
+
+class Protocol:
+    def __init__(self, transport, timeout=2.0):
+        self.transport = transport
+        self.timeout = timeout
+        self.sequence = 0
+        self.crc = True
+        self.rxbuf = bytearray()
+        # Drop the Nth ACK (-1: the last one) of fragmented responses, to test retransmissions.
+        self.drop_ack = 0
+
+    def send(self, opcode, channel=0, payload=b"", flags=0, sequence=None):
+        seq = self.sequence if sequence is None else sequence
+        header = struct.pack("<HBBBBH", SYNC_WORD, seq, channel, flags, opcode, len(payload))
+        packet = header + struct.pack("<H", crc16(header) if self.crc else 0)
+        if payload:
+            packet += payload + struct.pack("<I", crc32(payload) if self.crc else 0)
+        self.transport.write(packet)
+
+    def recv(self):
+        deadline = time.monotonic() + self.timeout
+        while time.monotonic() < deadline:
+            # Resync on the sync word.
+            while len(self.rxbuf) >= 2 and struct.unpack_from("<H", self.rxbuf)[0] != SYNC_WORD:
+                del self.rxbuf[0]
+
+            if len(self.rxbuf) >= HEADER_SIZE:
+                seq, chan, flags, opcode, length, crc = struct.unpack_from("<BBBBHH", self.rxbuf, 2)
+                if self.crc and crc != crc16(self.rxbuf[:HEADER_SIZE - 2]):
+                    del self.rxbuf[0]
+                    continue
+                size = HEADER_SIZE + (length + 4 if length else 0)
+                if len(self.rxbuf) >= size:
+                    payload = bytes(self.rxbuf[HEADER_SIZE:HEADER_SIZE + length])
+                    valid = not length or not self.crc or \
+                        struct.unpack_from("<I", self.rxbuf, HEADER_SIZE + length)[0] == crc32(payload)
+                    del self.rxbuf[:size]
+                    if valid:
+                        return seq, chan, flags, opcode, payload
+                    continue
+            self.rxbuf += self.transport.read()
+        raise TimeoutError("timeout waiting for packet")
+
+    def command(self, opcode, channel=0, payload=b""):
+        # Responses start with the same sequence number as the command.
+        expect = self.sequence
+        self.send(opcode, channel, payload)
+        data = bytearray()
+        pending = {}
+        nak = None
+        acks = 0
+        fragmented = False
+        while True:
+            seq, chan, flags, op, frag = self.recv()
+            if flags & FLAG_EVENT:
+                continue
+
+            if op != opcode:
+                # Fragment of an earlier response retransmitted because its ACK was lost.
+                if flags & FLAG_ACK_REQ and not flags & (FLAG_ACK | FLAG_NAK):
+                    self.send(op, chan, flags=FLAG_ACK, sequence=seq)
+                continue
+
+            self.sequence = (seq + 1) & 0xFF
+            if flags & FLAG_NAK:
+                raise RuntimeError("command 0x%02x failed (status %d)" % (opcode, frag[0]))
+            if flags & FLAG_ACK:
+                return bytes(data)
+            if not flags & FLAG_ACK_REQ:
+                data += frag
+                if not flags & FLAG_FRAGMENT:
+                    return bytes(data)
+                continue
+
+            # Keep out of order fragments, and NAK the missing one once.
+            diff = (seq - expect) & 0xFF
+            if diff >= 0x80:
+                self.send(opcode, chan, flags=FLAG_ACK, sequence=(expect - 1) & 0xFF)
+                continue
+            pending[seq] = (flags, frag)
+            fragmented |= bool(flags & FLAG_FRAGMENT)
+            if diff and nak != expect:
+                nak = expect
+                self.send(opcode, chan, struct.pack("<H", STATUS_SEQUENCE), FLAG_NAK, expect)
+                continue
+
+            last = False
+            while expect in pending:
+                flags, frag = pending.pop(expect)
+                data += frag
+                last = not flags & FLAG_FRAGMENT
+                expect = (expect + 1) & 0xFF
+
+            # Cumulative ACK of all the fragments received in order.
+            acks += 1
+            if not fragmented or (acks != self.drop_ack and not (self.drop_ack < 0 and last)):
+                self.send(opcode, chan, flags=FLAG_ACK, sequence=(expect - 1) & 0xFF)
+            self.sequence = expect
+            if last:
+                return bytes(data)
+
+    def sync(self):
+        self.sequence = 0
+        self.send(OPCODE_PROTO_SYNC)
+        self.recv()
+        self.rxbuf.clear()
+        self.sequence = 0
+
+
+def tcp_test(args):
+    def recvall(sock, n):
+        # Helper function to recv n bytes or return None if EOF is hit
+        data = bytearray()
+        while len(data) < n:
+            packet = sock.recv(n - len(data))
+            if not packet:
+                return None
+            data.extend(packet)
+        return data
+
+    host, port = args.addr.rsplit(":", 1)
+    s = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    s.connect((host, int(port)))
+
+    upload = 0
+    download = 0
+    start_time = time.monotonic()
+    while True:
+        s.sendall(b"0" * args.upload)
+        recvall(s, args.download)
+        upload += args.upload
+        download += args.download
+        secs = time.monotonic() - start_time
+        print("%s Upload: %.3f MBytes Download: %.3f MBytes %.3f MBytes/s"
+              % (str(timedelta(seconds=secs)), upload / (1024 * 1024),
+                 download / (1024 * 1024), (upload + download) / (1024 * 1024) / secs))
+
+
+def protocol_connect(args):
+    # Returns the protocol, the loopback channel ID and the negotiated max payload.
+    if args.udp:
+        transport = UDPTransport(args.udp)
+    else:
+        transport = SerialTransport(args.port, args.baudrate)
+
+    proto = Protocol(transport)
+    proto.sync()
+
+    # Negotiate the window, and optionally disable CRCs.
+    caps = bytearray(proto.command(OPCODE_PROTO_GET_CAPS))
+    flags, max_payload = struct.unpack_from("<IH", caps)
+    if args.max_payload:
+        max_payload = args.max_payload
+    flags = (flags & ~1) | (0 if args.no_crc else 1)
+    struct.pack_into("<IHB", caps, 0, flags, max_payload, args.window)
+    proto.command(OPCODE_PROTO_SET_CAPS, payload=bytes(caps))
+    proto.crc = not args.no_crc
+
+    channels = proto.command(OPCODE_CHANNEL_LIST)
+    loopback = None
+    for i in range(0, len(channels), 16):
+        cid, cflags, name = struct.unpack_from("<BB14s", channels, i)
+        if name.rstrip(b"\0") == b"loopback":
+            loopback = cid
+    if loopback is None:
+        sys.exit("loopback channel not found, rebuild the firmware with PROTOCOL_LOOPBACK=1")
+    return proto, loopback, max_payload
+
+
+def loopback_fill(proto, loopback, max_payload, size):
+    # Writes a test pattern to the loopback channel and returns it.
+    pattern = bytes((i * 7 + (i >> 8)) & 0xFF for i in range(size))
+    chunk = max_payload - 8
+    for offset in range(0, size, chunk):
+        data = pattern[offset:offset + chunk]
+        proto.command(OPCODE_CHANNEL_WRITE, loopback, struct.pack("<II", offset, len(data)) + data)
+    return pattern
+
+
+def protocol_test(args):
+    proto, loopback, max_payload = protocol_connect(args)
+    pattern = loopback_fill(proto, loopback, max_payload, args.size)
+
+    print("window: %d max_payload: %d crc: %s" % (args.window, max_payload, not args.no_crc))
+    total = 0
+    start_time = time.monotonic()
+    for i in range(args.count):
+        data = proto.command(OPCODE_CHANNEL_READ, loopback, struct.pack("<II", 0, args.size))
+        if data != pattern:
+            sys.exit("data mismatch on transfer %d" % i)
+        total += len(data)
+        secs = time.monotonic() - start_time
+        print("%s Download: %.3f MBytes %.3f MBytes/s"
+              % (str(timedelta(seconds=secs)), total / (1024 * 1024), total / (1024 * 1024) / secs))
+
+    stats = struct.unpack("<8I", proto.command(OPCODE_PROTO_STATS))
+    print("sent: %d retransmit: %d checksum errors: %d" % (stats[0], stats[4], stats[2]))
+
+
+def trace_to_json(data):
+    magic, version, event_size, freq, capacity, head, dropped, name_count, name_size, name_capacity, _ = \
+        struct.unpack_from(TRACE_HEADER, data)
+    if magic != TRACE_MAGIC or version != 1:
+        raise ValueError("invalid trace buffer")
+
+    offset = struct.calcsize(TRACE_HEADER)
+    names = [data[offset + i * name_size:offset + (i + 1) * name_size].split(b"\0")[0].decode()
+             for i in range(name_count)]
+    offset += name_capacity * name_size
+
+    # The buffer is a ring, the oldest event is at head once it has wrapped.
+    count = min(head, capacity)
+    order = range(count) if head <= capacity else \
+        [(head + i) % capacity for i in range(capacity)]
+
+    events = []
+    contexts = set()
+    cycles = None
+    ts = 0
+    for i in order:
+        cyc, value, etype, name, context = struct.unpack_from("<IiBBH", data, offset + i * event_size)
+        if etype not in TRACE_PHASES:
+            continue
+        # Unwrap the 32-bit cycle counter, events from IRQs may be slightly out of order.
+        if cycles is not None:
+            delta = (cyc - cycles) & 0xFFFFFFFF
+            ts += delta - (1 << 32) if delta & 0x80000000 else delta
+        cycles = cyc
+        contexts.add(context)
+        event = {
+            "name": names[name] if name < len(names) else "unknown",
+            "ph": TRACE_PHASES[etype],
+            "ts": ts * 1e6 / freq,
+            "pid": 0,
+            "tid": context,
+        }
+        if etype == 3:
+            event["s"] = "t"
+        elif etype == 4:
+            event["args"] = {"value": value}
+        events.append(event)
+
+    for context in sorted(contexts):
+        label = "main" if context == 0 else \
+            "irq %d" % (context - 16) if context >= 16 else "exception %d" % context
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": context, "args": {"name": label}})
+
+    return {"traceEvents": events, "displayTimeUnit": "ms",
+            "otherData": {"dropped": dropped, "cpu_freq": freq}}
+
+
+def trace_dump(args):
+    if args.input:
+        with open(args.input, "rb") as f:
+            data = f.read()
+    else:
+        if args.udp:
+            transport = UDPTransport(args.udp)
+        else:
+            transport = SerialTransport(args.port, args.baudrate)
+
+        proto = Protocol(transport)
+        proto.sync()
+
+        # Select the trace buffer, recording is paused while the channel is locked.
+        proto.command(OPCODE_CHANNEL_IOCTL, CHANNEL_ID_PROFILE, struct.pack("<II", IOCTL_PROFILE_TRACE, 1))
+        proto.command(OPCODE_CHANNEL_LOCK, CHANNEL_ID_PROFILE)
+        try:
+            size = struct.unpack("<I", proto.command(OPCODE_CHANNEL_SIZE, CHANNEL_ID_PROFILE))[0]
+            data = proto.command(OPCODE_CHANNEL_READ, CHANNEL_ID_PROFILE, struct.pack("<II", 0, size))
+        finally:
+            proto.command(OPCODE_CHANNEL_UNLOCK, CHANNEL_ID_PROFILE)
+            if args.reset:
+                proto.command(OPCODE_CHANNEL_IOCTL, CHANNEL_ID_PROFILE, struct.pack("<I", IOCTL_PROFILE_RESET))
+            proto.command(OPCODE_CHANNEL_IOCTL, CHANNEL_ID_PROFILE, struct.pack("<II", IOCTL_PROFILE_TRACE, 0))
+
+        if args.raw:
+            with open(args.raw, "wb") as f:
+                f.write(data)
+
+    trace = trace_to_json(data)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+    print("%d events, %d dropped -> %s" % (len(trace["traceEvents"]), trace["otherData"]["dropped"], args.output))
+
+
+def elf_functions(path):
+    # Returns the sorted (address, size, name) of the function symbols in an ELF32 file.
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF" or elf[4] != 1:
+        raise ValueError("not an ELF32 file")
+
+    shoff, = struct.unpack_from("<I", elf, 0x20)
+    shentsize, shnum = struct.unpack_from("<HH", elf, 0x2E)
+    sections = [struct.unpack_from("<IIIIIIIIII", elf, shoff + i * shentsize) for i in range(shnum)]
+
+    functions = []
+    for sh in sections:
+        if sh[1] != 2:  # SHT_SYMTAB
+            continue
+        strtab = sections[sh[6]]
+        for offset in range(sh[4], sh[4] + sh[5], 16):
+            name, value, size, info = struct.unpack_from("<IIIB", elf, offset)
+            if info & 0xF == 2 and value:  # STT_FUNC
+                end = elf.index(b"\0", strtab[4] + name)
+                functions.append((value & ~1, size, elf[strtab[4] + name:end].decode()))
+    return sorted(functions)
+
+
+def resolve(functions, addresses, pc):
+    i = bisect.bisect_right(addresses, pc) - 1
+    if i >= 0:
+        addr, size, name = functions[i]
+        if not size or pc < addr + size:
+            return name
+    return "0x%08x" % pc
+
+
+def sample_profile(args):
+    records = []
+    if args.input:
+        # Lines of "pc lr count", as printed by profiler.samples().
+        with open(args.input) as f:
+            for line in f:
+                fields = line.replace(",", " ").strip("()[] \n").split()
+                if len(fields) == 3:
+                    records.append(tuple(int(x, 0) for x in fields))
+    else:
+        if args.udp:
+            transport = UDPTransport(args.udp)
+        else:
+            transport = SerialTransport(args.port, args.baudrate)
+
+        proto = Protocol(transport)
+        proto.sync()
+
+        mode = PROFILE_MODE_SAMPLE_LR if args.lr else PROFILE_MODE_SAMPLE
+        proto.command(OPCODE_CHANNEL_IOCTL, CHANNEL_ID_PROFILE, struct.pack("<II", IOCTL_PROFILE_MODE, mode))
+        time.sleep(args.duration)
+
+        # Sampling is paused while the channel is locked.
+        proto.command(OPCODE_CHANNEL_LOCK, CHANNEL_ID_PROFILE)
+        try:
+            size = struct.unpack("<I", proto.command(OPCODE_CHANNEL_SIZE, CHANNEL_ID_PROFILE))[0]
+            data = proto.command(OPCODE_CHANNEL_READ, CHANNEL_ID_PROFILE, struct.pack("<II", 0, size)) if size else b""
+        finally:
+            proto.command(OPCODE_CHANNEL_UNLOCK, CHANNEL_ID_PROFILE)
+        records = [struct.unpack_from("<III", data, i) for i in range(0, len(data), 12)]
+
+        # Stop sampling, this fails if the firmware has no instrumenting profiler to switch to.
+        try:
+            proto.command(OPCODE_CHANNEL_IOCTL, CHANNEL_ID_PROFILE, struct.pack("<II", IOCTL_PROFILE_MODE, 0))
+        except RuntimeError:
+            pass
+
+    functions = elf_functions(args.elf)
+    addresses = [f[0] for f in functions]
+
+    # Record 0 counts the samples that didn't fit in the device's pool.
+    dropped = sum(count for pc, lr, count in records if pc == 0)
+    total = sum(count for pc, lr, count in records)
+    if not total:
+        sys.exit("no samples")
+
+    hist = {}
+    callers = {}
+    for pc, lr, count in records:
+        if pc == 0:
+            continue
+        name = resolve(functions, addresses, pc)
+        hist[name] = hist.get(name, 0) + count
+        if lr:
+            caller = resolve(functions, addresses, lr)
+            callers.setdefault(name, {})
+            callers[name][caller] = callers[name].get(caller, 0) + count
+
+    print("%d samples, %d dropped" % (total, dropped))
+    print("%8s %7s  %s" % ("samples", "percent", "function"))
+    for name, count in sorted(hist.items(), key=lambda x: -x[1])[:args.top]:
+        print("%8d %6.2f%%  %s" % (count, count * 100.0 / total, name))
+        for caller, n in sorted(callers.get(name, {}).items(), key=lambda x: -x[1])[:3]:
+            print("%8d %7s    <- %s" % (n, "", caller))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="OpenMV throughput test client")
+    sub = parser.add_subparsers(dest="mode", required=True)
+
+    tcp = sub.add_parser("tcp", help="raw TCP socket test")
+    tcp.add_argument("--addr", default="192.168.1.103:8080", help="server host:port")
+    tcp.add_argument("--upload", type=int, default=1024, help="upload length per iteration")
+    tcp.add_argument("--download", type=int, default=1024, help="download length per iteration")
+
+    proto = sub.add_parser("protocol", help="protocol loopback channel test")
+    proto.add_argument("--port", default="/dev/ttyACM0", help="serial port")
+    proto.add_argument("--baudrate", type=int, default=921600, help="serial baudrate")
+    proto.add_argument("--udp", default=None, help="UDP transport host:port (instead of serial)")
+    proto.add_argument("--window", type=int, default=8, help="fragments in flight (1-8)")
+    proto.add_argument("--max-payload", type=int, default=0, help="max payload (default: device)")
+    proto.add_argument("--no-crc", action="store_true", help="disable CRCs")
+    proto.add_argument("--size", type=int, default=32 * 1024, help="loopback transfer size")
+    proto.add_argument("--count", type=int, default=100, help="number of transfers")
+
+    trace = sub.add_parser("trace", help="export the timeline trace as Chrome trace JSON")
+    trace.add_argument("--port", default="/dev/ttyACM0", help="serial port")
+    trace.add_argument("--baudrate", type=int, default=921600, help="serial baudrate")
+    trace.add_argument("--udp", default=None, help="UDP transport host:port (instead of serial)")
+    trace.add_argument("--output", default="trace.json", help="output JSON file")
+    trace.add_argument("--raw", default=None, help="also save the raw trace buffer")
+    trace.add_argument("--input", default=None, help="convert a saved raw trace buffer instead")
+    trace.add_argument("--reset", action="store_true", help="clear the trace buffer after reading")
+
+    sample = sub.add_parser("sample", help="sampling profiler, resolved with the firmware ELF")
+    sample.add_argument("--port", default="/dev/ttyACM0", help="serial port")
+    sample.add_argument("--baudrate", type=int, default=921600, help="serial baudrate")
+    sample.add_argument("--udp", default=None, help="UDP transport host:port (instead of serial)")
+    sample.add_argument("--elf", required=True, help="firmware ELF file")
+    sample.add_argument("--duration", type=float, default=5.0, help="sampling duration in seconds")
+    sample.add_argument("--lr", action="store_true", help="also sample LR to show the callers")
+    sample.add_argument("--input", default=None, help="read samples printed by profiler.samples() instead")
+    sample.add_argument("--top", type=int, default=30, help="number of functions to show")
+
+    args = parser.parse_args()
+    if args.mode == "tcp":
+        tcp_test(args)
+    elif args.mode == "trace":
+        trace_dump(args)
+    elif args.mode == "sample":
+        sample_profile(args)
+    else:
+        protocol_test(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -14,6 +14,9 @@ import struct
 import argparse
 from xml.dom import minidom
 
+HAAR_CASCADE_MAGIC = 0x52414148 # "HAAR"
+HAAR_FEATURE_MAX_RECTS = 3
+
 def print_cascade_info(path, size, stages, n_features, n_rectangles, c_format):
     C_GREEN = '\033[92m'
     C_RED = '\033[91m'
@@ -101,15 +104,128 @@ def cascade_info_old(path):
 
     print_cascade_info(path, size, stages, n_features, n_rectangles, False)
 
-def cascade_binary_universal(path, n_stages, name):
+def cascade_binary_universal(path, n_stages, name, legacy=False):
     xmldoc = minidom.parse(path)
     old_format = xmldoc.getElementsByTagName('stageNum').length == 0
     if old_format:
-        cascade_binary_old(path, n_stages, name)
+        cascade_binary_old(path, n_stages, name, legacy)
     else:
-        cascade_binary(path, n_stages, name)
+        cascade_binary(path, n_stages, name, legacy)
+
+def cascade_rects(rects):
+    # Returns a list of (x, y, w, h, weight) tuples.
+    return [tuple(map(int, r.childNodes[0].nodeValue[:-1].split()))[0:5] for r in rects]
+
+def cascade_write(path, name, size, stages, stage_threshold, features, legacy):
+    # Writes a binary cascade from quantized stage thresholds (Q8) and features
+    # (thresh Q12, alpha1 Q8, alpha2 Q8, rects). The default packed format is a
+    # header followed by one record per stage and one fixed size record per feature,
+    # which the firmware runs in place from the ROMFS.
+    if not name:
+        name = os.path.basename(path).split('.')[0]
+    fout = open(name+".cascade", "wb")
+
+    if legacy:
+        # write detection window size
+        fout.write(struct.pack('i', size[0]))
+        fout.write(struct.pack('i', size[1]))
+
+        # write num stages
+        fout.write(struct.pack('i', len(stages)))
+
+        # write num feat in stages
+        for s in stages:
+            fout.write(struct.pack('B', s)) # uint8_t
+
+        padding = (4 - ((12 + len(stages)) % 4)) % 4
+        if padding:
+            fout.write(b"\x00"*padding)
 
-def cascade_binary(path, n_stages, name):
+        # write stages thresholds
+        for t in stage_threshold:
+            fout.write(struct.pack('h', t)) #int16_t
+
+        # write features threshold, alpha1 and alpha2 1 per feature
+        for i in range(3):
+            for f in features:
+                fout.write(struct.pack('h', f[i])) #int16_t
+
+        # write num_rects per feature
+        for f in features:
+            fout.write(struct.pack('B', len(f[3]))) # uint8_t
+
+        # write rects weights 1 per rectangle
+        for f in features:
+            for r in f[3]:
+                fout.write(struct.pack('b', r[4])) #int8_t NOTE: multiply by 4096
+
+        # write rects
+        for f in features:
+            for r in f[3]:
+                fout.write(struct.pack('BBBB', r[0], r[1], r[2], r[3])) #uint8_t
+    else:
+        # write header (magic, window size, num stages and num features)
+        fout.write(struct.pack('<IHHHH', HAAR_CASCADE_MAGIC, size[0], size[1], len(stages), len(features)))
+
+        # write num feat and threshold per stage
+        for s, t in zip(stages, stage_threshold):
+            fout.write(struct.pack('<Hh', s, t)) # uint16_t, int16_t
+
+        # write features, rects are zero padded to HAAR_FEATURE_MAX_RECTS
+        for t, a1, a2, rects in features:
+            if len(rects) > HAAR_FEATURE_MAX_RECTS:
+                raise Exception("The max number of rectangles per feature is: %d"%(HAAR_FEATURE_MAX_RECTS))
+            padded = rects + [(0, 0, 0, 0, 0)] * (HAAR_FEATURE_MAX_RECTS - len(rects))
+            fout.write(struct.pack('<hhhB', t, a1, a2, len(rects)))
+            fout.write(struct.pack('<3b', *[r[4] for r in padded]))
+            fout.write(struct.pack('<12B2x', *[v for r in padded for v in r[0:4]]))
+
+    fout.close()
+
+def cascade_convert(path, name):
+    # Converts a legacy binary cascade to the packed format.
+    data = open(path, "rb").read()
+    if struct.unpack_from('<I', data)[0] == HAAR_CASCADE_MAGIC:
+        raise Exception("The cascade is already in the packed format")
+
+    size = list(struct.unpack_from('<ii', data))
+    n_stages = struct.unpack_from('<i', data, 8)[0]
+    stages = list(struct.unpack_from('<%dB'%(n_stages), data, 12))
+    n_features = sum(stages)
+
+    offset = 12 + n_stages + (4 - ((12 + n_stages) % 4)) % 4
+    stage_threshold = struct.unpack_from('<%dh'%(n_stages), data, offset)
+    offset += n_stages * 2
+    thresh = struct.unpack_from('<%dh'%(n_features), data, offset)
+    offset += n_features * 2
+    alpha1 = struct.unpack_from('<%dh'%(n_features), data, offset)
+    offset += n_features * 2
+    alpha2 = struct.unpack_from('<%dh'%(n_features), data, offset)
+    offset += n_features * 2
+    # num_rects is signed, like the firmware reads it. Negative counts are summed
+    # as is, but the feature has no rectangles.
+    num_rects = struct.unpack_from('<%db'%(n_features), data, offset)
+    offset += n_features
+
+    # The arrays are sized by the signed sum, but indexed by the clamped counts,
+    # so read them the same way to convert the rectangles the firmware uses.
+    n_rectangles = sum(num_rects)
+    n_indexed = sum(max(n, 0) for n in num_rects)
+    weights = struct.unpack_from('<%db'%(n_indexed), data, offset)
+    offset += n_rectangles
+    rects = struct.unpack_from('<%dB'%(n_indexed * 4), data, offset)
+
+    features = []
+    r_idx = 0
+    for i in range(n_features):
+        n = max(num_rects[i], 0)
+        r = [rects[j*4:j*4+4] + (weights[j],) for j in range(r_idx, r_idx + n)]
+        features.append((thresh[i], alpha1[i], alpha2[i], r))
+        r_idx += n
+
+    cascade_write(path, name, size, stages, stage_threshold, features, False)
+
+def cascade_binary(path, n_stages, name, legacy=False):
     #parse xml file
     xmldoc = minidom.parse(path)
 
@@ -126,6 +242,7 @@ def cascade_binary(path, n_stages, name):
     for node in stages_elements[0].childNodes:
         if node.nodeType == 1:
             stages.append(int(node.getElementsByTagName('maxWeakCount')[0].childNodes[0].nodeValue))
+    stages = stages[0:n_stages]
     stage_threshold = xmldoc.getElementsByTagName('stageThreshold')[0:n_stages]
 
     # total number of features
@@ -149,74 +266,25 @@ def cascade_binary(path, n_stages, name):
     # read cascade size
     size = [int(xmldoc.getElementsByTagName('width')[0].childNodes[0].nodeValue), int(xmldoc.getElementsByTagName('height')[0].childNodes[0].nodeValue)]
 
-    # open output file with the specified name or xml file name
-    if not name:
-        name = os.path.basename(path).split('.')[0]
-    fout = open(name+".cascade", "wb")
-
     n_rectangles = 0
     for f in feature:
         rects = f.getElementsByTagName('_')
         n_rectangles = n_rectangles + len(rects)
 
-    # write detection window size
-    fout.write(struct.pack('i', size[0]))
-    fout.write(struct.pack('i', size[1]))
-
-    # write num stages
-    fout.write(struct.pack('i', len(stages)))
-
-    # write num feat in stages
-    for s in stages:
-        fout.write(struct.pack('B', s)) # uint8_t
-
-    padding = (4 - ((12 + len(stages)) % 4)) % 4
-    if padding:
-        fout.write(b"\x00"*padding)
-
-    # write stages thresholds
-    for t in stage_threshold:
-        fout.write(struct.pack('h', int(float(t.childNodes[0].nodeValue)*256))) #int16_t
-
-    # write features threshold 1 per feature
-    for t in internal_nodes:
-        fout.write(struct.pack('h', int(float(t.childNodes[0].nodeValue.split()[3])*4096))) #int16_t
-
-    # write alpha1 1 per feature
-    for a in alpha1:
-        fout.write(struct.pack('h', int(float(a)*256))) #int16_t
-
-    # write alpha2 1 per feature
-    for a in alpha2:
-        fout.write(struct.pack('h', int(float(a)*256))) #int16_t
-
-    # write num_rects per feature
-    for f in internal_nodes:
-        idx = int(f.childNodes[0].nodeValue.split()[2])
-        rects = feature[idx].getElementsByTagName('_')
-        fout.write(struct.pack('B', len(rects))) # uint8_t
-
-    # write rects weights 1 per rectangle
-    for f in internal_nodes:
-        idx = int(f.childNodes[0].nodeValue.split()[2])
-        rects = feature[idx].getElementsByTagName('_')
-        for r in rects:
-            l = list(map(int, r.childNodes[0].nodeValue[:-1].split()))
-            fout.write(struct.pack('b', l[4])) #int8_t NOTE: multiply by 4096
-
-    # write rects
-    for f in internal_nodes:
-        idx = int(f.childNodes[0].nodeValue.split()[2])
-        rects = feature[idx].getElementsByTagName('_')
-        for r in rects:
-            l = list(map(int, r.childNodes[0].nodeValue[:-1].split()))
-            fout.write(struct.pack('BBBB', l[0], l[1], l[2], l[3])) #uint8_t
+    # Features reference their rectangles by index in the new format.
+    features = []
+    for f, a1, a2 in zip(internal_nodes, alpha1, alpha2):
+        node = f.childNodes[0].nodeValue.split()
+        rects = feature[int(node[2])].getElementsByTagName('_')
+        features.append((int(float(node[3])*4096), int(float(a1)*256), int(float(a2)*256), cascade_rects(rects)))
 
+    stage_threshold = [int(float(t.childNodes[0].nodeValue)*256) for t in stage_threshold]
+    cascade_write(path, name, size, stages, stage_threshold, features, legacy)
 
     print_cascade_info(path, size, stages, n_features, n_rectangles, True)
 
 
-def cascade_binary_old(path, n_stages, name):
+def cascade_binary_old(path, n_stages, name, legacy=False):
     #parse xml file
     xmldoc = minidom.parse(path)
 
@@ -249,65 +317,18 @@ def cascade_binary_old(path, n_stages, name):
     size = list(map(int, xmldoc.getElementsByTagName('size')[0].childNodes[0].nodeValue.split()))
 
 
-    # open output file with the specified name or xml file name
-    if not name:
-        name = os.path.basename(path).split('.')[0]
-    fout = open(name+".cascade", "wb")
-
     n_rectangles = 0
     for f in feature:
         rects = f.getElementsByTagName('_')
         n_rectangles = n_rectangles + len(rects)
 
-    # write detection window size
-    fout.write(struct.pack('i', size[0]))
-    fout.write(struct.pack('i', size[1]))
-
-    # write num stages
-    fout.write(struct.pack('i', len(stages)))
-
-    # write num feat in stages
-    for s in stages:
-        fout.write(struct.pack('B', s)) # uint8_t
+    features = []
+    for t, a1, a2, f in zip(threshold, alpha1, alpha2, feature):
+        features.append((int(float(t.childNodes[0].nodeValue)*4096), int(float(a1.childNodes[0].nodeValue)*256),
+                         int(float(a2.childNodes[0].nodeValue)*256), cascade_rects(f.getElementsByTagName('_'))))
 
-    padding = (4 - ((12 + len(stages)) % 4)) % 4
-    if padding:
-        fout.write(b"\x00"*padding)
-
-    # write stages thresholds
-    for t in stage_threshold:
-        fout.write(struct.pack('h', int(float(t.childNodes[0].nodeValue)*256))) #int16_t
-
-    # write features threshold 1 per feature
-    for t in threshold:
-        fout.write(struct.pack('h', int(float(t.childNodes[0].nodeValue)*4096))) #int16_t
-
-    # write alpha1 1 per feature
-    for a in alpha1:
-        fout.write(struct.pack('h', int(float(a.childNodes[0].nodeValue)*256))) #int16_t
-
-    # write alpha2 1 per feature
-    for a in alpha2:
-        fout.write(struct.pack('h', int(float(a.childNodes[0].nodeValue)*256))) #int16_t
-
-    # write num_rects per feature
-    for f in feature:
-        rects = f.getElementsByTagName('_')
-        fout.write(struct.pack('B', len(rects))) # uint8_t
-
-    # write rects weights 1 per rectangle
-    for f in feature:
-        rects = f.getElementsByTagName('_')
-        for r in rects:
-            l = list(map(int, r.childNodes[0].nodeValue[:-1].split()))
-            fout.write(struct.pack('b', l[4])) #int8_t NOTE: multiply by 4096
-
-    # write rects
-    for f in feature:
-        rects = f.getElementsByTagName('_')
-        for r in rects:
-            l = list(map(int, r.childNodes[0].nodeValue[:-1].split()))
-            fout.write(struct.pack('BBBB',l[0], l[1], l[2], l[3])) #uint8_t
+    stage_threshold = [int(float(t.childNodes[0].nodeValue)*256) for t in stage_threshold]
+    cascade_write(path, name, size, stages, stage_threshold, features, legacy)
 
     print_cascade_info(path, size, stages, n_features, n_rectangles, False)
 
@@ -406,7 +427,8 @@ def main():
     parser.add_argument("-n", "--name",     action = "store",       help = "set cascade name", default = "")
     parser.add_argument("-s", "--stages",   action = "store",       help = "set the maximum number of stages", type = int, default=0)
     parser.add_argument("-c", "--header",   action = "store_true",  help = "generate a C header")
-    parser.add_argument("file", action = "store", help = "OpenCV xml cascade file path")
+    parser.add_argument("-l", "--legacy",   action = "store_true",  help = "generate a legacy binary cascade")
+    parser.add_argument("file", action = "store", help = "OpenCV xml cascade or legacy binary cascade file path")
 
     # Parse CMD args
     args = parser.parse_args()
@@ -421,8 +443,13 @@ def main():
         cascade_header(args.file, args.stages, args.name)
         return
 
+    if args.file.endswith(".cascade"):
+        # convert a legacy binary cascade to the packed format
+        cascade_convert(args.file, args.name)
+        return
+
     # generate a binary cascade from the xml cascade
-    cascade_binary_universal(args.file, args.stages, args.name)
+    cascade_binary_universal(args.file, args.stages, args.name, args.legacy)
 
 if __name__ == '__main__':
     main()
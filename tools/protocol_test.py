@@ -0,0 +1,65 @@
+#!/usr/bin/env python
+# This file is part of the OpenMV project.
+#
+# Copyright (C) 2026 OpenMV, LLC.
+#
+# This work is licensed under the MIT license, see the file LICENSE for details.
+#
+# Windowed transfer test, using the client.py protocol implementation. Reads the
+# loopback channel (firmware built with PROTOCOL_LOOPBACK=1) with more than one
+# fragment in flight, then drops an ACK in the middle of the window (recovered by
+# the next cumulative ACK) and the last ACK of a transfer (recovered by the device
+# retransmitting the fragment). Exits with an error if any transfer fails.
+#
+# Examples:
+#   protocol_test.py --port /dev/ttyACM0
+#   protocol_test.py --udp openmv.local:5555 --window 4 --max-payload 1400
+
+import sys
+import struct
+import argparse
+
+from client import OPCODE_CHANNEL_READ, OPCODE_PROTO_STATS, protocol_connect, loopback_fill
+
+
+def main():
+    parser = argparse.ArgumentParser(description="OpenMV protocol windowed transfer test")
+    parser.add_argument("--port", default="/dev/ttyACM0", help="serial port")
+    parser.add_argument("--baudrate", type=int, default=921600, help="serial baudrate")
+    parser.add_argument("--udp", default=None, help="UDP transport host:port (instead of serial)")
+    parser.add_argument("--window", type=int, default=4, help="fragments in flight (2-8)")
+    parser.add_argument("--max-payload", type=int, default=0, help="max payload (default: device)")
+    parser.add_argument("--no-crc", action="store_true", help="disable CRCs")
+    args = parser.parse_args()
+
+    if args.window < 2:
+        sys.exit("the window must be larger than one packet")
+
+    proto, loopback, max_payload = protocol_connect(args)
+
+    # Enough fragments to fill the window twice, with a partial last one.
+    size = (max_payload * args.window * 2) + (max_payload // 2)
+    pattern = loopback_fill(proto, loopback, max_payload, size)
+
+    def retransmits():
+        return struct.unpack("<8I", proto.command(OPCODE_PROTO_STATS))[4]
+
+    failed = False
+    for name, drop_ack in (("no drop", 0), ("drop middle ACK", 2), ("drop last ACK", -1)):
+        before = retransmits()
+        proto.drop_ack = drop_ack
+        data = proto.command(OPCODE_CHANNEL_READ, loopback, struct.pack("<II", 0, size))
+        proto.drop_ack = 0
+        # Reading the stats also ACKs the retransmitted fragment if the last ACK was dropped.
+        count = retransmits() - before
+
+        ok = (data == pattern) and (drop_ack >= 0 or count > 0)
+        failed |= not ok
+        print("%-16s window: %d size: %d retransmit: %d %s"
+              % (name, args.window, size, count, "PASS" if ok else "FAIL"))
+
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()